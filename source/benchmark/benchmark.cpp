@@ -0,0 +1,1437 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+// Headless benchmark for the StreamFX filters.
+//
+// Loads the StreamFX module into a libobs instance without a front-end, attaches each filter to a generated test
+// pattern and renders a fixed number of frames at several resolutions. Rendering happens in a main render callback,
+// so that libobs keeps ticking sources like it normally would. CPU and GPU times of every frame are written as JSON.
+// Filters that build up their output over several frames also report how many frames it took to settle, measured on
+// a fresh instance of the filter.
+//
+// Synthetic frames don't behave like real content, so frames of any source can be captured into a raw frame file
+// (see raw-frames.hpp) and replayed instead of the test pattern. Replayed frames can also be fed to encoders, which
+// then report their throughput, frame-to-packet latency and the CPU usage of the process through an output that only
+// counts packets. "--encoder all" runs every video encoder that StreamFX registered. With --preset-key, every encoder
+// runs once for each entry of that list in its properties, which is "Preset" for the NVENC and AMF handlers and
+// "Software.Preset" for software encoders.
+//
+// Software encoders also remember how many frames per second each preset could sustain, and show that next to the
+// preset in their properties. They only measure after 5 seconds of encoding and store it in the StreamFX
+// configuration, which --config places in OBS' plugin_config directory. So the estimates OBS shows come from e.g.:
+//   streamfx-benchmark --replay FILE --encoder all --preset-key Software.Preset --frames 900 --config DIRECTORY
+//
+// OpenGL and Direct3D 11 build mipmaps differently, see gs-mipmapper.cpp. --mipmaps records a frame of Transform
+// sampling the mipmaps of the test pattern, and --compare checks two such recordings against each other. Both box
+// filter every level, but may round differently, which is what the tolerance allows for. On Windows, where both
+// graphics modules exist:
+//   streamfx-benchmark --graphics libobs-d3d11 --mipmaps d3d11.raw
+//   streamfx-benchmark --graphics libobs-opengl --mipmaps opengl.raw
+//   streamfx-benchmark --compare d3d11.raw --compare opengl.raw
+//
+// usage: streamfx-benchmark [--frames N] [--warmup N] [--resolution WxH]... [--filter NAME]... [--output FILE]
+//                           [--module FILE] [--data DIRECTORY] [--config DIRECTORY] [--graphics MODULE]
+//                           [--plugin FILE]...
+//                           [--replay FILE] [--encoder ID]... [--encoder-settings JSON] [--preset-key KEY] [--fps N]
+//        streamfx-benchmark --capture FILE --source ID [--source-settings JSON] [--frames N] [--warmup N]
+//                           [--resolution WxH] [--plugin FILE]...
+//        streamfx-benchmark --mipmaps FILE [--resolution WxH] [--warmup N] [--graphics MODULE]
+//        streamfx-benchmark --compare FILE --compare FILE [--tolerance N]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <obs-module.h>
+#include <obs.h>
+#include <util/platform.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+}
+
+#include "raw-frames.hpp"
+
+#if defined(_WIN32)
+#define D_GRAPHICS_MODULE "libobs-d3d11"
+#else
+#define D_GRAPHICS_MODULE "libobs-opengl"
+#endif
+
+#define D_PATTERN_ID "streamfx-benchmark-pattern"
+#define D_PATTERN_WIDTH "Width"
+#define D_PATTERN_HEIGHT "Height"
+
+#define D_REPLAY_ID "streamfx-benchmark-replay"
+#define D_REPLAY_FILE "File"
+
+#define D_OUTPUT_ID "streamfx-benchmark-output"
+
+struct filter_case {
+	const char*                                                   name;
+	const char*                                                   id;
+	std::function<void(obs_data_t*, const std::filesystem::path&)> settings;
+	bool converge = false; // Also count the frames until the output stops changing, see convergence.
+};
+
+// Canonical settings, which enable the expensive parts of each filter. Anything not set here keeps its default.
+static const filter_case filter_cases[] = {
+	{"blur", "streamfx-filter-blur",
+	 [](obs_data_t* data, const std::filesystem::path&) {
+		 obs_data_set_string(data, "Filter.Blur.Type", "gaussian");
+		 obs_data_set_double(data, "Filter.Blur.Size", 15.);
+	 }},
+	{"color-grade", "streamfx-filter-color-grade", [](obs_data_t*, const std::filesystem::path&) {}},
+	{"displacement", "streamfx-filter-displacement",
+	 [](obs_data_t* data, const std::filesystem::path& path) {
+		 auto file = (path / "examples" / "normal-maps" / "stretch-middle.png").u8string();
+		 obs_data_set_string(data, "Filter.Displacement.File", file.c_str());
+	 }},
+	{"dynamic-mask", "streamfx-filter-dynamic-mask", [](obs_data_t*, const std::filesystem::path&) {}},
+	{"sdf-effects", "streamfx-filter-sdf-effects",
+	 [](obs_data_t* data, const std::filesystem::path&) {
+		 obs_data_set_bool(data, "Filter.SDFEffects.Shadow.Outer", true);
+		 obs_data_set_bool(data, "Filter.SDFEffects.Glow.Outer", true);
+		 obs_data_set_double(data, "Filter.SDFEffects.Glow.Outer.Width", 16.);
+	 }},
+	// Both distance field producers, rebuilding the field every frame so that the producer itself is measured.
+	{"sdf-iterative", "streamfx-filter-sdf-effects",
+	 [](obs_data_t* data, const std::filesystem::path&) {
+		 obs_data_set_bool(data, "Filter.SDFEffects.Glow.Outer", true);
+		 obs_data_set_double(data, "Filter.SDFEffects.Glow.Outer.Width", 16.);
+		 obs_data_set_int(data, "Filter.SDFEffects.SDF.Producer", 0);
+		 obs_data_set_bool(data, "Filter.SDFEffects.SDF.Cache", false);
+	 },
+	 true},
+	{"sdf-jump-flooding", "streamfx-filter-sdf-effects",
+	 [](obs_data_t* data, const std::filesystem::path&) {
+		 obs_data_set_bool(data, "Filter.SDFEffects.Glow.Outer", true);
+		 obs_data_set_double(data, "Filter.SDFEffects.Glow.Outer.Width", 16.);
+		 obs_data_set_int(data, "Filter.SDFEffects.SDF.Producer", 1);
+		 obs_data_set_bool(data, "Filter.SDFEffects.SDF.Cache", false);
+	 },
+	 true},
+	{"shader", "streamfx-filter-shader",
+	 [](obs_data_t* data, const std::filesystem::path& path) {
+		 auto file = (path / "examples" / "shaders" / "filter" / "hexagonize.effect").u8string();
+		 obs_data_set_string(data, "Shader.Shader.File", file.c_str());
+	 }},
+	{"transform", "streamfx-filter-transform",
+	 [](obs_data_t* data, const std::filesystem::path&) {
+		 obs_data_set_double(data, "Filter.Transform.Rotation.X", 30.);
+		 obs_data_set_double(data, "Filter.Transform.Rotation.Y", 15.);
+	 }},
+	{"video-superresolution", "streamfx-filter-video-superresolution",
+	 [](obs_data_t*, const std::filesystem::path&) {}},
+};
+
+//------------------------------------------------------------------------------
+// Test Pattern
+//------------------------------------------------------------------------------
+// A checkerboard with a soft circle in its alpha channel, so that alpha-driven filters like SDF Effects have
+// something to work with.
+struct pattern {
+	uint32_t      width   = 0;
+	uint32_t      height  = 0;
+	gs_texture_t* texture = nullptr;
+
+	void update(obs_data_t* data)
+	{
+		uint32_t new_width  = static_cast<uint32_t>(obs_data_get_int(data, D_PATTERN_WIDTH));
+		uint32_t new_height = static_cast<uint32_t>(obs_data_get_int(data, D_PATTERN_HEIGHT));
+		if ((new_width == width) && (new_height == height) && texture)
+			return;
+		width  = new_width;
+		height = new_height;
+
+		std::vector<uint32_t> pixels(static_cast<std::size_t>(width) * height);
+		double                radius = std::min(width, height) * 0.4;
+		for (uint32_t y = 0; y < height; y++) {
+			for (uint32_t x = 0; x < width; x++) {
+				double   dx    = x - width / 2.;
+				double   dy    = y - height / 2.;
+				double   edge  = std::clamp(radius - std::sqrt(dx * dx + dy * dy), 0., 1.);
+				uint32_t alpha = static_cast<uint32_t>(edge * 255.);
+				uint32_t color = (((x / 32) + (y / 32)) % 2) ? 0x00C0C0C0 : 0x00404040;
+				pixels[static_cast<std::size_t>(y) * width + x] = (alpha << 24) | color;
+			}
+		}
+
+		const uint8_t* data_ptr = reinterpret_cast<const uint8_t*>(pixels.data());
+		obs_enter_graphics();
+		if (texture)
+			gs_texture_destroy(texture);
+		texture = gs_texture_create(width, height, GS_RGBA, 1, &data_ptr, 0);
+		obs_leave_graphics();
+	}
+
+	static const char* get_name(void*)
+	{
+		return "StreamFX Benchmark Pattern";
+	}
+
+	static void* create(obs_data_t* data, obs_source_t*)
+	{
+		auto self = new pattern();
+		self->update(data);
+		return self;
+	}
+
+	static void destroy(void* ptr)
+	{
+		auto self = reinterpret_cast<pattern*>(ptr);
+		obs_enter_graphics();
+		if (self->texture)
+			gs_texture_destroy(self->texture);
+		obs_leave_graphics();
+		delete self;
+	}
+
+	static void update_cb(void* ptr, obs_data_t* data)
+	{
+		reinterpret_cast<pattern*>(ptr)->update(data);
+	}
+
+	static uint32_t get_width(void* ptr)
+	{
+		return reinterpret_cast<pattern*>(ptr)->width;
+	}
+
+	static uint32_t get_height(void* ptr)
+	{
+		return reinterpret_cast<pattern*>(ptr)->height;
+	}
+
+	static void video_render(void* ptr, gs_effect_t*)
+	{
+		auto         self   = reinterpret_cast<pattern*>(ptr);
+		gs_effect_t* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+		gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), self->texture);
+		while (gs_effect_loop(effect, "Draw")) {
+			gs_draw_sprite(self->texture, 0, self->width, self->height);
+		}
+	}
+
+	static void register_source()
+	{
+		obs_source_info info = {};
+		info.id              = D_PATTERN_ID;
+		info.type            = OBS_SOURCE_TYPE_INPUT;
+		info.output_flags    = OBS_SOURCE_VIDEO | OBS_SOURCE_CUSTOM_DRAW;
+		info.get_name        = get_name;
+		info.create          = create;
+		info.destroy         = destroy;
+		info.update          = update_cb;
+		info.get_width       = get_width;
+		info.get_height      = get_height;
+		info.video_render    = video_render;
+		obs_register_source(&info);
+	}
+};
+
+//------------------------------------------------------------------------------
+// Replay
+//------------------------------------------------------------------------------
+// Plays back a raw frame file, advancing by one frame every time it is rendered so that every run sees the same
+// sequence of frames regardless of timing.
+struct replay {
+	std::shared_ptr<raw_frames> file;
+	gs_texture_t*               texture = nullptr;
+	uint32_t                    index   = 0;
+
+	static const char* get_name(void*)
+	{
+		return "StreamFX Benchmark Replay";
+	}
+
+	static void* create(obs_data_t* data, obs_source_t*)
+	{
+		auto self = new replay();
+		try {
+			self->file = raw_frames::open(std::filesystem::u8path(obs_data_get_string(data, D_REPLAY_FILE)));
+		} catch (const std::exception& ex) {
+			std::cerr << "Failed to open replay: " << ex.what() << std::endl;
+			delete self;
+			return nullptr;
+		}
+
+		auto& header = self->file->header();
+		obs_enter_graphics();
+		self->texture = gs_texture_create(header.width, header.height, static_cast<gs_color_format>(header.format), 1,
+										  nullptr, GS_DYNAMIC);
+		obs_leave_graphics();
+		return self;
+	}
+
+	static void destroy(void* ptr)
+	{
+		auto self = reinterpret_cast<replay*>(ptr);
+		obs_enter_graphics();
+		if (self->texture)
+			gs_texture_destroy(self->texture);
+		obs_leave_graphics();
+		delete self;
+	}
+
+	static uint32_t get_width(void* ptr)
+	{
+		return reinterpret_cast<replay*>(ptr)->file->header().width;
+	}
+
+	static uint32_t get_height(void* ptr)
+	{
+		return reinterpret_cast<replay*>(ptr)->file->header().height;
+	}
+
+	static void video_render(void* ptr, gs_effect_t*)
+	{
+		auto  self   = reinterpret_cast<replay*>(ptr);
+		auto& header = self->file->header();
+		if (!self->texture)
+			return;
+
+		gs_texture_set_image(self->texture, self->file->frame(self->index), header.stride, false);
+		self->index = (self->index + 1) % header.frames;
+
+		gs_effect_t* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+		gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), self->texture);
+		while (gs_effect_loop(effect, "Draw")) {
+			gs_draw_sprite(self->texture, 0, header.width, header.height);
+		}
+	}
+
+	static void register_source()
+	{
+		obs_source_info info = {};
+		info.id              = D_REPLAY_ID;
+		info.type            = OBS_SOURCE_TYPE_INPUT;
+		info.output_flags    = OBS_SOURCE_VIDEO | OBS_SOURCE_CUSTOM_DRAW;
+		info.get_name        = get_name;
+		info.create          = create;
+		info.destroy         = destroy;
+		info.get_width       = get_width;
+		info.get_height      = get_height;
+		info.video_render    = video_render;
+		obs_register_source(&info);
+	}
+};
+
+//------------------------------------------------------------------------------
+// Capture
+//------------------------------------------------------------------------------
+// Renders a source into a raw frame file, one frame per main render callback.
+struct capture {
+	obs_source_t*               source = nullptr;
+	std::shared_ptr<raw_frames> file;
+	uint32_t                    warmup = 0;
+	uint32_t                    index  = 0;
+
+	gs_texrender_t*                       target = nullptr;
+	gs_stagesurf_t*                       stage  = nullptr;
+	std::chrono::steady_clock::time_point start;
+
+	std::mutex              lock;
+	std::condition_variable done_cv;
+	bool                    done = false;
+
+	void frame()
+	{
+		auto& header = file->header();
+		if (!target)
+			target = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+		if (!stage)
+			stage = gs_stagesurface_create(header.width, header.height, GS_RGBA);
+
+		gs_texrender_reset(target);
+		if (!gs_texrender_begin(target, header.width, header.height))
+			return;
+		vec4 clear = {};
+		gs_clear(GS_CLEAR_COLOR, &clear, 0, 0);
+		gs_ortho(0, static_cast<float>(obs_source_get_width(source)), 0,
+				 static_cast<float>(obs_source_get_height(source)), -1., 1.);
+		obs_source_video_render(source);
+		gs_texrender_end(target);
+
+		// Media sources take a moment to start, so leave them some frames before recording.
+		if (warmup > 0) {
+			warmup--;
+			return;
+		}
+
+		// Waiting for the copy stalls the GPU, which is fine as nothing is measured while capturing.
+		uint8_t* data     = nullptr;
+		uint32_t linesize = 0;
+		gs_stage_texture(stage, gs_texrender_get_texture(target));
+		if (!gs_stagesurface_map(stage, &data, &linesize))
+			return;
+		uint8_t* output = file->frame(index);
+		for (uint32_t y = 0; y < header.height; y++) {
+			std::memcpy(output + static_cast<std::size_t>(y) * header.stride,
+						data + static_cast<std::size_t>(y) * linesize, header.stride);
+		}
+		gs_stagesurface_unmap(stage);
+
+		auto now = std::chrono::steady_clock::now();
+		if (index == 0)
+			start = now;
+		file->set_timestamp(index, static_cast<uint64_t>(
+									   std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count()));
+
+		if (++index >= header.frames) {
+			std::unique_lock<std::mutex> ul(lock);
+			done = true;
+			done_cv.notify_all();
+		}
+	}
+
+	void release()
+	{
+		obs_enter_graphics();
+		if (stage)
+			gs_stagesurface_destroy(stage);
+		if (target)
+			gs_texrender_destroy(target);
+		stage  = nullptr;
+		target = nullptr;
+		obs_leave_graphics();
+	}
+
+	static void render_callback(void* ptr, uint32_t, uint32_t)
+	{
+		auto self = reinterpret_cast<capture*>(ptr);
+		{
+			std::unique_lock<std::mutex> ul(self->lock);
+			if (self->done)
+				return;
+		}
+		self->frame();
+	}
+};
+
+//------------------------------------------------------------------------------
+// Encoding
+//------------------------------------------------------------------------------
+// Output that takes the packets of a single video encoder and only counts them.
+struct counting_output {
+	obs_output_t* self = nullptr;
+
+	uint64_t                              target  = 0;
+	uint64_t                              packets = 0;
+	uint64_t                              bytes   = 0;
+	std::chrono::steady_clock::time_point first;
+	std::chrono::steady_clock::time_point last;
+	std::vector<uint64_t>                 latency; // Nanoseconds from the frame to its packet.
+
+	std::mutex              lock;
+	std::condition_variable done_cv;
+
+	static counting_output* current; // The output being created, as libobs offers no way to pass it in.
+
+	static const char* get_name(void*)
+	{
+		return "StreamFX Benchmark Output";
+	}
+
+	static void* create(obs_data_t*, obs_output_t* output)
+	{
+		current->self = output;
+		return current;
+	}
+
+	static void destroy(void*) {}
+
+	static bool start(void* ptr)
+	{
+		auto self = reinterpret_cast<counting_output*>(ptr);
+		if (!obs_output_can_begin_data_capture(self->self, 0) || !obs_output_initialize_encoders(self->self, 0))
+			return false;
+		return obs_output_begin_data_capture(self->self, 0);
+	}
+
+	static void stop(void* ptr, uint64_t)
+	{
+		obs_output_end_data_capture(reinterpret_cast<counting_output*>(ptr)->self);
+	}
+
+	static void encoded_packet(void* ptr, encoder_packet* packet)
+	{
+		auto self = reinterpret_cast<counting_output*>(ptr);
+		if (!packet)
+			return;
+
+		std::unique_lock<std::mutex> ul(self->lock);
+		auto                         now = std::chrono::steady_clock::now();
+		if (self->packets == 0)
+			self->first = now;
+		self->last = now;
+		self->packets++;
+		self->bytes += packet->size;
+
+		// libobs places every packet on the system clock of the frame its decode timestamp belongs to, which is the
+		// frame itself for encoders that don't reorder frames.
+		int64_t now_usec = static_cast<int64_t>(os_gettime_ns() / 1000);
+		if ((packet->sys_dts_usec > 0) && (now_usec >= packet->sys_dts_usec)) {
+			self->latency.push_back(static_cast<uint64_t>(now_usec - packet->sys_dts_usec) * 1000);
+		}
+		if (self->packets >= self->target)
+			self->done_cv.notify_all();
+	}
+
+	static void register_output()
+	{
+		obs_output_info info = {};
+		info.id              = D_OUTPUT_ID;
+		info.flags           = OBS_OUTPUT_VIDEO | OBS_OUTPUT_ENCODED;
+		info.get_name        = get_name;
+		info.create          = create;
+		info.destroy         = destroy;
+		info.start           = start;
+		info.stop            = stop;
+		info.encoded_packet  = encoded_packet;
+		obs_register_output(&info);
+	}
+};
+counting_output* counting_output::current = nullptr;
+
+//------------------------------------------------------------------------------
+// Measurement
+//------------------------------------------------------------------------------
+// Renders a source with its filters into a target of its own, the way a scene would draw it.
+static void render_source(gs_texrender_t*& target, obs_source_t* source, uint32_t width, uint32_t height)
+{
+	if (!target)
+		target = gs_texrender_create(GS_RGBA, GS_ZS_NONE);
+
+	gs_texrender_reset(target);
+	if (gs_texrender_begin(target, width, height)) {
+		vec4 clear = {};
+		gs_clear(GS_CLEAR_COLOR, &clear, 0, 0);
+		gs_ortho(0, static_cast<float>(width), 0, static_cast<float>(height), -1., 1.);
+		gs_blend_state_push();
+		gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+		obs_source_video_render(source);
+		gs_blend_state_pop();
+		gs_texrender_end(target);
+	}
+}
+
+struct sample {
+	uint64_t cpu_ns;
+	uint64_t gpu_ns;
+	bool     gpu_valid;
+};
+
+// One benchmark run, rendered frame by frame from within the main render callback.
+struct job {
+	obs_source_t* source = nullptr;
+	uint32_t      width  = 0;
+	uint32_t      height = 0;
+	uint32_t      warmup = 0;
+	uint32_t      frames = 0;
+
+	gs_texrender_t*                                        target = nullptr;
+	std::vector<std::pair<gs_timer_t*, gs_timer_range_t*>> queries;
+	std::vector<uint64_t>                                  cpu;
+
+	std::mutex              lock;
+	std::condition_variable done_cv;
+	bool                    active = false;
+	bool                    done   = false;
+
+	void frame()
+	{
+		if (warmup > 0) {
+			render();
+			warmup--;
+			return;
+		}
+
+		// Disjoint queries can not be nested, and StreamFX opens its own around every filter. So only the timestamps
+		// surround the filter, while the range after it tells us the frequency and whether it is trustworthy.
+		gs_timer_t*       timer = gs_timer_create();
+		gs_timer_range_t* range = gs_timer_range_create();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		if (timer)
+			gs_timer_begin(timer);
+		render();
+		if (timer)
+			gs_timer_end(timer);
+		gs_flush();
+		cpu.push_back(static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start)
+				.count()));
+
+		if (range) {
+			gs_timer_range_begin(range);
+			gs_timer_range_end(range);
+		}
+		queries.emplace_back(timer, range);
+
+		if (cpu.size() >= frames) {
+			std::unique_lock<std::mutex> ul(lock);
+			active = false;
+			done   = true;
+			done_cv.notify_all();
+		}
+	}
+
+	void render()
+	{
+		render_source(target, source, width, height);
+	}
+
+	// Read back all GPU timings. This may wait for the GPU, which is fine once rendering is over.
+	std::vector<sample> resolve()
+	{
+		std::vector<sample> samples;
+
+		obs_enter_graphics();
+		for (std::size_t idx = 0; idx < queries.size(); idx++) {
+			sample s    = {cpu[idx], 0, false};
+			auto&  q    = queries[idx];
+			bool   disj = true;
+			uint64_t freq = 0, ticks = 0;
+			if (q.first && q.second) {
+				while (!gs_timer_range_get_data(q.second, &disj, &freq)) {
+				}
+				while (!gs_timer_get_data(q.first, &ticks)) {
+				}
+				if (!disj && (freq > 0)) {
+					s.gpu_ns    = static_cast<uint64_t>((static_cast<double>(ticks) * 1'000'000'000.) / freq);
+					s.gpu_valid = true;
+				}
+			}
+			if (q.first)
+				gs_timer_destroy(q.first);
+			if (q.second)
+				gs_timer_range_destroy(q.second);
+			samples.push_back(s);
+		}
+		queries.clear();
+		if (target)
+			gs_texrender_destroy(target);
+		target = nullptr;
+		obs_leave_graphics();
+
+		return samples;
+	}
+
+	static void render_callback(void* ptr, uint32_t, uint32_t)
+	{
+		auto self = reinterpret_cast<job*>(ptr);
+		{
+			std::unique_lock<std::mutex> ul(self->lock);
+			if (!self->active)
+				return;
+		}
+		self->frame();
+	}
+};
+
+// Renders a freshly created filter frame by frame and reads every frame back, to find how many frames it takes until
+// the output stops changing. Filters that build up their result over several frames, like the iterative distance field
+// of SDF Effects, only show their real cost this way. Reading back stalls the GPU, so nothing is timed meanwhile.
+struct convergence {
+	obs_source_t* source = nullptr;
+	uint32_t      width  = 0;
+	uint32_t      height = 0;
+	uint32_t      limit  = 0;
+	uint32_t      index  = 0;
+	uint32_t      last   = 0; // Frame that last changed the output.
+
+	gs_texrender_t*      target = nullptr;
+	gs_stagesurf_t*      stage  = nullptr;
+	std::vector<uint8_t> previous;
+
+	std::mutex              lock;
+	std::condition_variable done_cv;
+	bool                    active = false;
+	bool                    done   = false;
+
+	void frame()
+	{
+		if (!stage)
+			stage = gs_stagesurface_create(width, height, GS_RGBA);
+		render_source(target, source, width, height);
+
+		uint8_t* data     = nullptr;
+		uint32_t linesize = 0;
+		gs_stage_texture(stage, gs_texrender_get_texture(target));
+		if (gs_stagesurface_map(stage, &data, &linesize)) {
+			std::size_t row     = static_cast<std::size_t>(width) * 4;
+			bool        changed = previous.empty();
+			previous.resize(row * height);
+			for (uint32_t y = 0; y < height; y++) {
+				uint8_t* copy = previous.data() + y * row;
+				if (std::memcmp(copy, data + static_cast<std::size_t>(y) * linesize, row) != 0) {
+					std::memcpy(copy, data + static_cast<std::size_t>(y) * linesize, row);
+					changed = true;
+				}
+			}
+			gs_stagesurface_unmap(stage);
+			if (changed)
+				last = index;
+		}
+
+		if (++index >= limit) {
+			std::unique_lock<std::mutex> ul(lock);
+			active = false;
+			done   = true;
+			done_cv.notify_all();
+		}
+	}
+
+	void release()
+	{
+		obs_enter_graphics();
+		if (stage)
+			gs_stagesurface_destroy(stage);
+		if (target)
+			gs_texrender_destroy(target);
+		stage  = nullptr;
+		target = nullptr;
+		obs_leave_graphics();
+		previous.clear();
+	}
+
+	static void render_callback(void* ptr, uint32_t, uint32_t)
+	{
+		auto self = reinterpret_cast<convergence*>(ptr);
+		{
+			std::unique_lock<std::mutex> ul(self->lock);
+			if (!self->active)
+				return;
+		}
+		self->frame();
+	}
+};
+
+// Names come from translations and encoder properties, so they may contain anything.
+static std::string json_escape(std::string_view text)
+{
+	std::string escaped;
+	escaped.reserve(text.size());
+	for (char c : text) {
+		switch (c) {
+		case '"':
+			escaped += "\\\"";
+			break;
+		case '\\':
+			escaped += "\\\\";
+			break;
+		case '\n':
+			escaped += "\\n";
+			break;
+		case '\r':
+			escaped += "\\r";
+			break;
+		case '\t':
+			escaped += "\\t";
+			break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20) {
+				char buf[7];
+				std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned int>(c));
+				escaped += buf;
+			} else {
+				escaped += c;
+			}
+		}
+	}
+	return escaped;
+}
+
+static void write_statistics(std::ostream& stream, std::vector<uint64_t> values)
+{
+	if (values.empty()) {
+		stream << "null";
+		return;
+	}
+
+	std::sort(values.begin(), values.end());
+	auto percentile = [&values](double p) {
+		return values[std::min(values.size() - 1, static_cast<std::size_t>(p * static_cast<double>(values.size())))];
+	};
+	uint64_t total = 0;
+	for (auto v : values)
+		total += v;
+
+	stream << "{";
+	stream << "\"samples\":" << values.size() << ",";
+	stream << "\"average_ns\":" << (total / values.size()) << ",";
+	stream << "\"min_ns\":" << values.front() << ",";
+	stream << "\"p50_ns\":" << percentile(0.50) << ",";
+	stream << "\"p95_ns\":" << percentile(0.95) << ",";
+	stream << "\"p99_ns\":" << percentile(0.99) << ",";
+	stream << "\"max_ns\":" << values.back();
+	stream << "}";
+}
+
+typedef std::vector<std::pair<std::string, std::function<void(obs_data_t*)>>> preset_list;
+
+// Every entry of the list property key of an encoder, as a name and a function that selects it. Without a key, or if
+// the encoder has no such list, this is a single run with the given settings.
+static preset_list list_presets(const std::string& encoder_id, const std::string& key)
+{
+	preset_list       presets;
+	obs_properties_t* props = key.empty() ? nullptr : obs_get_encoder_properties(encoder_id.c_str());
+	obs_property_t*   list  = props ? obs_properties_get(props, key.c_str()) : nullptr;
+	if (list && (obs_property_get_type(list) == OBS_PROPERTY_LIST)) {
+		for (std::size_t idx = 0; idx < obs_property_list_item_count(list); idx++) {
+			std::string name = obs_property_list_item_name(list, idx);
+			switch (obs_property_list_format(list)) {
+			case OBS_COMBO_FORMAT_INT: {
+				long long value = obs_property_list_item_int(list, idx);
+				presets.emplace_back(name,
+									 [key, value](obs_data_t* data) { obs_data_set_int(data, key.c_str(), value); });
+				break;
+			}
+			case OBS_COMBO_FORMAT_FLOAT: {
+				double value = obs_property_list_item_float(list, idx);
+				presets.emplace_back(name,
+									 [key, value](obs_data_t* data) { obs_data_set_double(data, key.c_str(), value); });
+				break;
+			}
+			case OBS_COMBO_FORMAT_STRING: {
+				std::string value = obs_property_list_item_string(list, idx);
+				presets.emplace_back(
+					name, [key, value](obs_data_t* data) { obs_data_set_string(data, key.c_str(), value.c_str()); });
+				break;
+			}
+			default:
+				break;
+			}
+		}
+	}
+	if (props) {
+		obs_properties_destroy(props);
+	}
+	if (presets.empty()) {
+		presets.emplace_back("", [](obs_data_t*) {});
+	}
+	return presets;
+}
+
+//------------------------------------------------------------------------------
+// Main
+//------------------------------------------------------------------------------
+// Creates the source that jobs run on, either the test pattern or the replay.
+static obs_source_t* create_input(const std::string& replay_path, std::pair<uint32_t, uint32_t> resolution)
+{
+	obs_data_t*   settings = obs_data_create();
+	obs_source_t* source   = nullptr;
+	if (replay_path.empty()) {
+		obs_data_set_int(settings, D_PATTERN_WIDTH, resolution.first);
+		obs_data_set_int(settings, D_PATTERN_HEIGHT, resolution.second);
+		source = obs_source_create_private(D_PATTERN_ID, "Pattern", settings);
+	} else {
+		obs_data_set_string(settings, D_REPLAY_FILE, replay_path.c_str());
+		source = obs_source_create_private(D_REPLAY_ID, "Replay", settings);
+	}
+	obs_data_release(settings);
+	return source;
+}
+
+// Create an input with the filter of a case on it, and count the frames until the filter's output settles. This is
+// zero if the very first frame is final already, and -1 if the output was still changing on the last frame.
+static int64_t measure_convergence(const filter_case& fc, const std::filesystem::path& data_path,
+								   const std::string& replay_path, std::pair<uint32_t, uint32_t> resolution,
+								   uint32_t frames)
+{
+	obs_source_t* source          = create_input(replay_path, resolution);
+	obs_data_t*   filter_settings = obs_data_create();
+	fc.settings(filter_settings, data_path);
+	obs_source_t* filter = obs_source_create_private(fc.id, fc.name, filter_settings);
+	obs_data_release(filter_settings);
+
+	int64_t result = -1;
+	if (source && filter) {
+		obs_source_filter_add(source, filter);
+
+		convergence current;
+		current.source = source;
+		current.width  = resolution.first;
+		current.height = resolution.second;
+		current.limit  = frames;
+		current.active = true;
+		obs_add_main_render_callback(convergence::render_callback, &current);
+		{
+			std::unique_lock<std::mutex> ul(current.lock);
+			current.done_cv.wait(ul, [&current]() { return current.done; });
+		}
+		obs_remove_main_render_callback(convergence::render_callback, &current);
+		current.release();
+
+		if (current.last + 1 < frames)
+			result = current.last;
+		obs_source_filter_remove(source, filter);
+	}
+	obs_source_release(filter);
+	obs_source_release(source);
+	return result;
+}
+
+// Render a source into a new raw frame file at the given size.
+static int record_frames(obs_source_t* source, const std::string& path, std::pair<uint32_t, uint32_t> resolution,
+						 uint32_t frames, uint32_t warmup)
+{
+	capture current;
+	try {
+		current.file = raw_frames::create(std::filesystem::u8path(path), GS_RGBA, resolution.first, resolution.second,
+										  4, frames);
+	} catch (const std::exception& ex) {
+		std::cerr << "Failed to create '" << path << "': " << ex.what() << std::endl;
+		return 1;
+	}
+	current.source = source;
+	current.warmup = warmup;
+
+	obs_source_inc_showing(source);
+	obs_add_main_render_callback(capture::render_callback, &current);
+	{
+		std::unique_lock<std::mutex> ul(current.lock);
+		current.done_cv.wait(ul, [&current]() { return current.done; });
+	}
+	obs_remove_main_render_callback(capture::render_callback, &current);
+	obs_source_dec_showing(source);
+
+	current.release();
+	return 0;
+}
+
+static int run_capture(const std::string& path, const std::string& source_id, const std::string& source_settings,
+					   std::pair<uint32_t, uint32_t> resolution, uint32_t frames, uint32_t warmup)
+{
+	obs_data_t*   settings = source_settings.empty() ? obs_data_create()
+													  : obs_data_create_from_json(source_settings.c_str());
+	obs_source_t* source   = obs_source_create_private(source_id.c_str(), "Capture", settings);
+	obs_data_release(settings);
+	if (!source) {
+		std::cerr << "Failed to create source '" << source_id << "'." << std::endl;
+		return 1;
+	}
+
+	// Sources without a size of their own only know it after their first tick.
+	if (resolution.first == 0) {
+		for (uint32_t attempt = 0; (attempt < 100) && (obs_source_get_width(source) == 0); attempt++) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		resolution = {obs_source_get_width(source), obs_source_get_height(source)};
+	}
+	if (resolution.first == 0 || resolution.second == 0) {
+		std::cerr << "Source '" << source_id << "' has no size, use --resolution." << std::endl;
+		obs_source_release(source);
+		return 1;
+	}
+
+	int code = record_frames(source, path, resolution, frames, warmup);
+	obs_source_release(source);
+	if (code != 0)
+		return code;
+
+	std::cerr << "Captured " << frames << " frames of '" << source_id << "' at " << resolution.first << "x"
+			  << resolution.second << " into '" << path << "'." << std::endl;
+	return 0;
+}
+
+// Record the test pattern shrunk by Transform with mipmapping, so that the output is sampled from the levels that
+// gs::mipmapper built. The scale is not a power of two, which blends two levels into every pixel.
+static int run_mipmaps(const std::string& path, std::pair<uint32_t, uint32_t> resolution, uint32_t warmup)
+{
+	obs_source_t* source   = create_input({}, resolution);
+	obs_data_t*   settings = obs_data_create();
+	obs_data_set_bool(settings, "Filter.Transform.Mipmapping", true);
+	obs_data_set_double(settings, "Filter.Transform.Scale.X", 10.);
+	obs_data_set_double(settings, "Filter.Transform.Scale.Y", 10.);
+	obs_source_t* filter = obs_source_create_private("streamfx-filter-transform", "transform", settings);
+	obs_data_release(settings);
+
+	int code = 1;
+	if (source && filter) {
+		obs_source_filter_add(source, filter);
+		code = record_frames(source, path, resolution, 1, warmup);
+		obs_source_filter_remove(source, filter);
+	}
+	obs_source_release(filter);
+	obs_source_release(source);
+
+	if (code == 0) {
+		std::cerr << "Recorded mipmapped output at " << resolution.first << "x" << resolution.second << " into '"
+				  << path << "'." << std::endl;
+	}
+	return code;
+}
+
+// Compare two raw frame files byte by byte, and fail if any channel of any pixel differs by more than the
+// tolerance. Needs no graphics, so files written by different graphics modules or machines can be compared.
+static int run_compare(const std::string& first, const std::string& second, uint32_t tolerance)
+{
+	std::shared_ptr<raw_frames> files[2];
+	for (std::size_t idx = 0; idx < 2; idx++) {
+		const std::string& path = idx ? second : first;
+		try {
+			files[idx] = raw_frames::open(std::filesystem::u8path(path));
+		} catch (const std::exception& ex) {
+			std::cerr << "Failed to open '" << path << "': " << ex.what() << std::endl;
+			return 1;
+		}
+	}
+
+	auto& a = files[0]->header();
+	auto& b = files[1]->header();
+	if ((a.format != b.format) || (a.width != b.width) || (a.height != b.height) || (a.stride != b.stride)
+		|| (a.frames != b.frames)) {
+		std::cerr << "'" << first << "' and '" << second << "' differ in format, size or frame count." << std::endl;
+		return 1;
+	}
+
+	uint32_t largest = 0;
+	uint64_t total   = 0;
+	uint64_t above   = 0;
+	for (uint32_t frame = 0; frame < a.frames; frame++) {
+		const uint8_t* pa = files[0]->frame(frame);
+		const uint8_t* pb = files[1]->frame(frame);
+		for (std::size_t idx = 0, edx = static_cast<std::size_t>(a.stride) * a.height; idx < edx; idx++) {
+			uint32_t difference = static_cast<uint32_t>(std::abs(int32_t(pa[idx]) - int32_t(pb[idx])));
+			largest             = std::max(largest, difference);
+			total += difference;
+			if (difference > tolerance)
+				above++;
+		}
+	}
+
+	double_t values = static_cast<double_t>(a.stride) * a.height * a.frames;
+	std::cerr << "Compared " << a.frames << " frame(s) at " << a.width << "x" << a.height << ": largest difference "
+			  << largest << ", mean " << (static_cast<double_t>(total) / values) << ", " << above
+			  << " value(s) above the tolerance of " << tolerance << "." << std::endl;
+	return (largest > tolerance) ? 1 : 0;
+}
+
+int main(int argc, const char* argv[])
+{
+	uint32_t                                   frames = 300;
+	uint32_t                                   warmup = 30;
+	uint32_t                                   fps    = 60;
+	std::vector<std::pair<uint32_t, uint32_t>> resolutions;
+	std::vector<std::string>                   filters;
+	std::vector<std::string>                   encoders;
+	std::vector<std::string>                   plugins;
+	std::string                                encoder_settings;
+	std::string                                preset_key;
+	std::string                                output;
+	std::string                                capture_path;
+	std::string                                capture_source;
+	std::string                                capture_settings;
+	std::string                                replay_path;
+	std::string                                config_path;
+	std::string                                mipmaps_path;
+	std::vector<std::string>                   compare_paths;
+	uint32_t                                   tolerance = 3;
+	std::filesystem::path                      module_path = BENCHMARK_MODULE;
+	std::filesystem::path                      data_path   = BENCHMARK_DATA;
+	std::string                                graphics    = D_GRAPHICS_MODULE;
+
+	for (int idx = 1; idx < argc; idx++) {
+		std::string arg  = argv[idx];
+		const char* next = (idx + 1 < argc) ? argv[idx + 1] : nullptr;
+		if (!next) {
+			std::cerr << "Missing value for '" << arg << "'." << std::endl;
+			return 1;
+		}
+		idx++;
+
+		if (arg == "--frames") {
+			frames = static_cast<uint32_t>(std::max(std::stoul(next), 1ul));
+		} else if (arg == "--warmup") {
+			warmup = static_cast<uint32_t>(std::stoul(next));
+		} else if (arg == "--fps") {
+			fps = static_cast<uint32_t>(std::max(std::stoul(next), 1ul));
+		} else if (arg == "--resolution") {
+			uint32_t width = 0, height = 0;
+			if (sscanf(next, "%ux%u", &width, &height) != 2 || !width || !height) {
+				std::cerr << "Resolution '" << next << "' is not in the form WIDTHxHEIGHT." << std::endl;
+				return 1;
+			}
+			resolutions.emplace_back(width, height);
+		} else if (arg == "--filter") {
+			filters.push_back(next);
+		} else if (arg == "--encoder") {
+			encoders.push_back(next);
+		} else if (arg == "--encoder-settings") {
+			encoder_settings = next;
+		} else if (arg == "--preset-key") {
+			preset_key = next;
+		} else if (arg == "--output") {
+			output = next;
+		} else if (arg == "--module") {
+			module_path = std::filesystem::u8path(next);
+		} else if (arg == "--data") {
+			data_path = std::filesystem::u8path(next);
+		} else if (arg == "--config") {
+			config_path = next;
+		} else if (arg == "--graphics") {
+			graphics = next;
+		} else if (arg == "--plugin") {
+			plugins.push_back(next);
+		} else if (arg == "--capture") {
+			capture_path = next;
+		} else if (arg == "--source") {
+			capture_source = next;
+		} else if (arg == "--source-settings") {
+			capture_settings = next;
+		} else if (arg == "--replay") {
+			replay_path = next;
+		} else if (arg == "--mipmaps") {
+			mipmaps_path = next;
+		} else if (arg == "--compare") {
+			compare_paths.push_back(next);
+		} else if (arg == "--tolerance") {
+			tolerance = static_cast<uint32_t>(std::stoul(next));
+		} else {
+			std::cerr << "Unknown argument '" << arg << "'." << std::endl;
+			return 1;
+		}
+	}
+	if (!compare_paths.empty()) {
+		if (compare_paths.size() != 2) {
+			std::cerr << "Comparing requires --compare exactly twice." << std::endl;
+			return 1;
+		}
+		return run_compare(compare_paths[0], compare_paths[1], tolerance);
+	}
+	if (!capture_path.empty() && capture_source.empty()) {
+		std::cerr << "Capturing requires --source." << std::endl;
+		return 1;
+	}
+	if (!replay_path.empty()) {
+		// Replayed frames always have the size they were captured at.
+		try {
+			auto file   = raw_frames::open(std::filesystem::u8path(replay_path));
+			resolutions = {{file->header().width, file->header().height}};
+		} catch (const std::exception& ex) {
+			std::cerr << "Failed to open '" << replay_path << "': " << ex.what() << std::endl;
+			return 1;
+		}
+	}
+	if (resolutions.empty() && capture_path.empty()) {
+		resolutions = {{1280, 720}, {1920, 1080}, {3840, 2160}};
+	}
+
+	// Without a configuration directory, libobs places the configuration of modules in the working directory.
+	if (!obs_startup("en-US", config_path.empty() ? nullptr : config_path.c_str(), nullptr)) {
+		std::cerr << "Failed to start libobs." << std::endl;
+		return 1;
+	}
+
+	// There is no UI that could race with them, so tasks meant for the UI thread run wherever they are queued.
+	obs_set_ui_task_handler([](obs_task_t task, void* param, bool) { task(param); });
+
+	{ // Graphics only, at a frame rate high enough to never be the limit.
+		obs_video_info ovi    = {};
+		ovi.graphics_module   = graphics.c_str();
+		ovi.fps_num           = 1000;
+		ovi.fps_den           = 1;
+		ovi.base_width        = 640;
+		ovi.base_height       = 360;
+		ovi.output_width      = 640;
+		ovi.output_height     = 360;
+		ovi.output_format     = VIDEO_FORMAT_NV12;
+		ovi.adapter           = 0;
+		ovi.gpu_conversion    = true;
+		ovi.colorspace        = VIDEO_CS_709;
+		ovi.range             = VIDEO_RANGE_PARTIAL;
+		ovi.scale_type        = OBS_SCALE_BICUBIC;
+		if (int code = obs_reset_video(&ovi); code != OBS_VIDEO_SUCCESS) {
+			std::cerr << "Failed to initialize graphics with '" << graphics << "' (error " << code << ")." << std::endl;
+			obs_shutdown();
+			return 1;
+		}
+	}
+
+	pattern::register_source();
+	replay::register_source();
+	counting_output::register_output();
+
+	obs_module_t* module = nullptr;
+	if (obs_open_module(&module, module_path.u8string().c_str(), data_path.u8string().c_str()) != MODULE_SUCCESS
+		|| !obs_init_module(module)) {
+		std::cerr << "Failed to load StreamFX from '" << module_path.u8string() << "'." << std::endl;
+		obs_shutdown();
+		return 1;
+	}
+
+	// Other plugins provide the sources to capture and the encoders to compare against.
+	for (auto& plugin : plugins) {
+		obs_module_t* extra = nullptr;
+		if (obs_open_module(&extra, plugin.c_str(), nullptr) != MODULE_SUCCESS || !obs_init_module(extra)) {
+			std::cerr << "Failed to load plugin '" << plugin << "'." << std::endl;
+		}
+	}
+
+	// "all" stands for every video encoder StreamFX registered, which is one per FFmpeg handler that is available.
+	// Deprecated ones are aliases of another one for old settings, and internal ones are not meant to be picked.
+	if (auto all = std::find(encoders.begin(), encoders.end(), "all"); all != encoders.end()) {
+		encoders.erase(all);
+		const char* id = nullptr;
+		for (std::size_t idx = 0; obs_enum_encoder_types(idx, &id); idx++) {
+			if ((std::strncmp(id, "streamfx-", 9) != 0) || (obs_get_encoder_type(id) != OBS_ENCODER_VIDEO)) {
+				continue;
+			}
+			if ((obs_get_encoder_caps(id) & (OBS_ENCODER_CAP_DEPRECATED | OBS_ENCODER_CAP_INTERNAL)) == 0) {
+				encoders.push_back(id);
+			}
+		}
+	}
+
+	if (!capture_path.empty()) {
+		int code = run_capture(capture_path, capture_source, capture_settings,
+							   resolutions.empty() ? std::pair<uint32_t, uint32_t>{0, 0} : resolutions.front(), frames,
+							   warmup);
+		obs_shutdown();
+		return code;
+	}
+
+	if (!mipmaps_path.empty()) {
+		int code = run_mipmaps(mipmaps_path, resolutions.front(), warmup);
+		obs_shutdown();
+		return code;
+	}
+
+	job current;
+	obs_add_main_render_callback(job::render_callback, &current);
+
+	std::ostringstream json;
+	json << "{";
+	json << "\"libobs\":\"" << obs_get_version_string() << "\",";
+	json << "\"graphics\":\"" << graphics << "\",";
+	json << "\"frames\":" << frames << ",";
+	json << "\"input\":\"" << (replay_path.empty() ? "pattern" : "replay") << "\",";
+	json << "\"results\":[";
+
+	bool first = true;
+	for (auto& fc : filter_cases) {
+		// Asking for encoders only skips the filters, unless some were asked for too.
+		if (filters.empty() && !encoders.empty())
+			break;
+		if (!filters.empty() && (std::find(filters.begin(), filters.end(), fc.name) == filters.end()))
+			continue;
+
+		for (auto& resolution : resolutions) {
+			obs_source_t* source = create_input(replay_path, resolution);
+
+			obs_data_t* filter_settings = obs_data_create();
+			fc.settings(filter_settings, data_path);
+			obs_source_t* filter = obs_source_create_private(fc.id, fc.name, filter_settings);
+			obs_data_release(filter_settings);
+
+			std::vector<sample> samples;
+			if (source && filter) {
+				obs_source_filter_add(source, filter);
+
+				std::unique_lock<std::mutex> ul(current.lock);
+				current.source = source;
+				current.width  = resolution.first;
+				current.height = resolution.second;
+				current.warmup = warmup;
+				current.frames = frames;
+				current.cpu.clear();
+				current.done   = false;
+				current.active = true;
+				current.done_cv.wait(ul, [&current]() { return current.done; });
+				ul.unlock();
+
+				samples = current.resolve();
+				obs_source_filter_remove(source, filter);
+			}
+			obs_source_release(filter);
+			obs_source_release(source);
+
+			std::vector<uint64_t> cpu, gpu;
+			for (auto& s : samples) {
+				cpu.push_back(s.cpu_ns);
+				if (s.gpu_valid)
+					gpu.push_back(s.gpu_ns);
+			}
+
+			// Replayed frames change all the time, so only the still test pattern can show when a filter settles.
+			bool    converge = fc.converge && filter && replay_path.empty();
+			int64_t settled  = -1;
+			if (converge)
+				settled = measure_convergence(fc, data_path, replay_path, resolution, frames);
+
+			json << (first ? "" : ",") << "{";
+			json << "\"filter\":\"" << json_escape(fc.name) << "\",";
+			json << "\"id\":\"" << fc.id << "\",";
+			json << "\"width\":" << resolution.first << ",";
+			json << "\"height\":" << resolution.second << ",";
+			json << "\"available\":" << (filter ? "true" : "false") << ",";
+			json << "\"cpu\":";
+			write_statistics(json, cpu);
+			json << ",\"gpu\":";
+			write_statistics(json, gpu);
+			if (converge) {
+				json << ",\"converge_frames\":";
+				if (settled < 0) {
+					json << "null";
+				} else {
+					json << settled;
+				}
+			}
+			json << "}";
+			first = false;
+
+			std::cerr << fc.name << " @ " << resolution.first << "x" << resolution.second << ": "
+					  << (filter ? "done" : "unavailable") << std::endl;
+		}
+	}
+	json << "],\"encoders\":[";
+	obs_remove_main_render_callback(job::render_callback, &current);
+
+	first = true;
+	for (auto& encoder_id : encoders) {
+		auto presets = list_presets(encoder_id, preset_key);
+		for (auto& resolution : resolutions) {
+			// Encoders receive whatever libobs outputs, so the output has to match the input this time.
+			obs_video_info ovi  = {};
+			ovi.graphics_module = graphics.c_str();
+			ovi.fps_num         = fps;
+			ovi.fps_den         = 1;
+			ovi.base_width      = resolution.first;
+			ovi.base_height     = resolution.second;
+			ovi.output_width    = resolution.first;
+			ovi.output_height   = resolution.second;
+			ovi.output_format   = VIDEO_FORMAT_NV12;
+			ovi.adapter         = 0;
+			ovi.gpu_conversion  = true;
+			ovi.colorspace      = VIDEO_CS_709;
+			ovi.range           = VIDEO_RANGE_PARTIAL;
+			ovi.scale_type      = OBS_SCALE_BICUBIC;
+			if (int code = obs_reset_video(&ovi); code != OBS_VIDEO_SUCCESS) {
+				std::cerr << "Failed to reset video to " << resolution.first << "x" << resolution.second << " (error "
+						  << code << ")." << std::endl;
+				continue;
+			}
+
+			for (auto& preset : presets) {
+				obs_source_t* source = create_input(replay_path, resolution);
+				obs_set_output_source(0, source);
+
+				obs_data_t* settings = encoder_settings.empty() ? obs_data_create()
+																 : obs_data_create_from_json(encoder_settings.c_str());
+				preset.second(settings);
+				obs_encoder_t* encoder = obs_video_encoder_create(encoder_id.c_str(), "Encoder", settings, nullptr);
+				obs_data_release(settings);
+
+				counting_output counter;
+				counter.target           = frames;
+				counting_output::current = &counter;
+				obs_output_t* out        = obs_output_create(D_OUTPUT_ID, "Output", nullptr, nullptr);
+				counting_output::current = nullptr;
+
+				bool                 available = false;
+				uint32_t             skipped   = video_output_get_skipped_frames(obs_get_video());
+				uint32_t             lagged    = obs_get_lagged_frames();
+				os_cpu_usage_info_t* cpu_info  = os_cpu_usage_info_start();
+				double_t             cpu_usage = 0.; // Percent of one core, over the whole run.
+				if (source && encoder && out) {
+					obs_encoder_set_video(encoder, obs_get_video());
+					obs_output_set_video_encoder(out, encoder);
+					if (obs_output_start(out)) {
+						// Give up eventually, as an encoder that stopped producing packets would hang here forever.
+						auto timeout = std::chrono::seconds(10 + (frames * 4) / fps);
+
+						std::unique_lock<std::mutex> ul(counter.lock);
+						available = counter.done_cv.wait_for(ul, timeout, [&counter]() {
+							return counter.packets >= counter.target;
+						});
+						ul.unlock();
+						cpu_usage = os_cpu_usage_info_query(cpu_info);
+						obs_output_stop(out);
+					}
+				}
+				os_cpu_usage_info_destroy(cpu_info);
+				skipped = video_output_get_skipped_frames(obs_get_video()) - skipped;
+				lagged  = obs_get_lagged_frames() - lagged;
+
+				obs_output_release(out);
+				obs_encoder_release(encoder);
+				obs_set_output_source(0, nullptr);
+				obs_source_release(source);
+
+				std::unique_lock<std::mutex> ul(counter.lock);
+				double_t elapsed = std::chrono::duration<double_t>(counter.last - counter.first).count();
+				json << (first ? "" : ",") << "{";
+				json << "\"encoder\":\"" << encoder_id << "\",";
+				json << "\"preset\":\"" << json_escape(preset.first) << "\",";
+				json << "\"width\":" << resolution.first << ",";
+				json << "\"height\":" << resolution.second << ",";
+				json << "\"fps\":" << fps << ",";
+				json << "\"available\":" << (available ? "true" : "false") << ",";
+				json << "\"packets\":" << counter.packets << ",";
+				json << "\"bytes\":" << counter.bytes << ",";
+				json << "\"throughput\":"
+					 << ((counter.packets > 1 && elapsed > 0) ? (counter.packets - 1) / elapsed : 0.) << ",";
+				json << "\"latency\":";
+				write_statistics(json, counter.latency);
+				json << ",\"cpu_usage\":" << cpu_usage << ",";
+				json << "\"skipped\":" << skipped << ",";
+				json << "\"lagged\":" << lagged;
+				json << "}";
+				first = false;
+
+				std::cerr << encoder_id << (preset.first.empty() ? "" : " (" + preset.first + ")") << " @ "
+						  << resolution.first << "x" << resolution.second << ": "
+						  << (available ? "done" : "unavailable") << std::endl;
+			}
+		}
+	}
+	json << "]}";
+
+	obs_shutdown();
+
+	if (output.empty()) {
+		std::cout << json.str() << std::endl;
+	} else {
+		std::ofstream file(std::filesystem::u8path(output), std::ios::out | std::ios::trunc);
+		file << json.str() << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+// Reports glass-to-glass latency from H.264 and HEVC streams that were encoded with "Embed Capture Timecode".
+//
+// Every frame then carries the wall clock times at which it was handed to the encoder and left it. Read from a file
+// only these are known, so the encoder's share of the latency is reported. Read live from standard input, the time
+// at which a frame arrives is known as well, which adds the delivery and the total latency up to this point. Pipe a
+// received stream in without re-encoding it, for example:
+//
+//   ffmpeg -i rtmp://server/app/key -c:v copy -an -f h264 - | streamfx-latency -
+//
+// The clocks of both machines must be synchronized, for example with NTP, for the delivery times to be meaningful.
+//
+// usage: streamfx-latency [--hevc] [--live] [--csv FILE] <FILE|->
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "encoders/codecs/nal.hpp"
+#include "encoders/codecs/timecode.hpp"
+
+namespace codec = streamfx::encoder::codec;
+
+#define D_CHUNK_SIZE (64 * 1024)
+
+struct sample {
+	codec::timecode::frame_times times;
+	uint64_t                     received; // 0 unless read live.
+};
+
+static void print_distribution(const char* name, std::vector<int64_t> values)
+{
+	if (values.empty()) {
+		return;
+	}
+	std::sort(values.begin(), values.end());
+
+	double sum = 0.;
+	for (int64_t value : values) {
+		sum += static_cast<double>(value);
+	}
+	auto at = [&values](double fraction) {
+		std::size_t idx = static_cast<std::size_t>(fraction * static_cast<double>(values.size() - 1) + .5);
+		return static_cast<double>(values[idx]) / 1000.;
+	};
+
+	printf("%-10s min %8.2f  mean %8.2f  p50 %8.2f  p90 %8.2f  p99 %8.2f  max %8.2f ms\n", name,
+		   static_cast<double>(values.front()) / 1000., sum / static_cast<double>(values.size()) / 1000., at(.5),
+		   at(.9), at(.99), static_cast<double>(values.back()) / 1000.);
+}
+
+int main(int argc, const char* argv[])
+{
+	std::string input;
+	std::string csv;
+	bool        hevc = false;
+	bool        live = false;
+	for (int idx = 1; idx < argc; idx++) {
+		std::string arg = argv[idx];
+		if (arg == "--hevc") {
+			hevc = true;
+		} else if (arg == "--live") {
+			live = true;
+		} else if ((arg == "--csv") && ((idx + 1) < argc)) {
+			csv = argv[++idx];
+		} else if ((arg == "--help") || (arg == "-h")) {
+			printf("usage: streamfx-latency [--hevc] [--live] [--csv FILE] <FILE|->\n");
+			return 0;
+		} else {
+			input = arg;
+		}
+	}
+	if (input.empty()) {
+		fprintf(stderr, "No input given, see --help.\n");
+		return 1;
+	}
+
+	// Standard input is assumed to be live, and a file extension is a good enough hint for the codec.
+	std::istream* stream = &std::cin;
+	std::ifstream file;
+	if (input == "-") {
+		live = true;
+		std::ios::sync_with_stdio(false);
+	} else {
+		file.open(input, std::ios::binary);
+		if (!file) {
+			fprintf(stderr, "Failed to open '%s'.\n", input.c_str());
+			return 1;
+		}
+		stream = &file;
+
+		for (const char* ext : {".hevc", ".h265", ".265"}) {
+			std::size_t len = strlen(ext);
+			hevc |= (input.size() > len) && (input.compare(input.size() - len, len, ext) == 0);
+		}
+	}
+
+	std::vector<sample>  samples;
+	std::vector<uint8_t> buffer;
+	auto                 process = [&](std::size_t size, uint64_t received) {
+		codec::for_each_nal(buffer.data(), size, [&](const codec::nal_view& nal) {
+			sample entry;
+			if (codec::timecode::read_sei(hevc, nal, entry.times)) {
+				entry.received = received;
+				samples.push_back(entry);
+			}
+		});
+	};
+
+	// Only the NAL units before the last start code are known to be complete, the rest waits for the next chunk.
+	std::vector<char> chunk(D_CHUNK_SIZE);
+	while (*stream) {
+		stream->read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+		std::size_t read = static_cast<std::size_t>(stream->gcount());
+		if (read == 0) {
+			break;
+		}
+		uint64_t received = live ? codec::timecode::now() : 0;
+		buffer.insert(buffer.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(read));
+
+		const uint8_t* end  = buffer.data() + buffer.size();
+		const uint8_t* last = nullptr;
+		for (const uint8_t* ptr = codec::find_start_code(buffer.data(), end); ptr != end;
+			 ptr                = codec::find_start_code(ptr + 3, end)) {
+			last = ptr;
+		}
+		if (last && (last != buffer.data())) {
+			std::size_t complete = static_cast<std::size_t>(last - buffer.data());
+			process(complete, received);
+			buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(complete));
+		}
+	}
+	process(buffer.size(), live ? codec::timecode::now() : 0);
+
+	if (samples.empty()) {
+		fprintf(stderr, "No timecodes found, was the stream encoded with 'Embed Capture Timecode' as %s?\n",
+				hevc ? "HEVC" : "H.264");
+		return 1;
+	}
+
+	if (!csv.empty()) {
+		std::ofstream out(csv, std::ios::trunc);
+		out << "pts,captured,encoded,received\n";
+		for (const sample& entry : samples) {
+			out << entry.times.pts << ',' << entry.times.captured << ',' << entry.times.encoded << ','
+				<< entry.received << '\n';
+		}
+	}
+
+	std::vector<int64_t>  encode, delivery, total, interval;
+	std::vector<uint64_t> captured;
+	for (const sample& entry : samples) {
+		encode.push_back(static_cast<int64_t>(entry.times.encoded - entry.times.captured));
+		if (entry.received != 0) {
+			delivery.push_back(static_cast<int64_t>(entry.received - entry.times.encoded));
+			total.push_back(static_cast<int64_t>(entry.received - entry.times.captured));
+		}
+		captured.push_back(entry.times.captured);
+	}
+
+	// Packets arrive in decoding order, which differs from the capture order with B-frames.
+	std::sort(captured.begin(), captured.end());
+	for (std::size_t idx = 1; idx < captured.size(); idx++) {
+		interval.push_back(static_cast<int64_t>(captured[idx] - captured[idx - 1]));
+	}
+
+	printf("%zu frames\n", samples.size());
+	print_distribution("Encode", encode);
+	print_distribution("Delivery", delivery);
+	print_distribution("Total", total);
+	print_distribution("Interval", interval);
+	return 0;
+}
@@ -0,0 +1,355 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+// Micro-benchmarks for the CPU-side utilities that sit on hot paths.
+//
+// Built on Google Benchmark, and linked against the utility sources directly instead of the plugin, so that no OBS
+// Studio front-end, graphics or audio is needed. The source tracker needs the libobs core for its signals, which is
+// started without video or audio before the benchmarks run. Every Google Benchmark flag works as usual, for example:
+//
+// usage: streamfx-microbenchmark [--benchmark_filter=REGEX] [--benchmark_format=json] [--benchmark_out=FILE]
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "common.hpp"
+#include "obs/obs-source-tracker.hpp"
+#include "plugin.hpp"
+#include "util/util-event.hpp"
+#include "util/util-memory.hpp"
+#include "util/util-plane-copy.hpp"
+#include "util/util-profiler.hpp"
+#include "util/util-ringbuffer.hpp"
+#include "util/util-threadpool.hpp"
+#include "util/utility.hpp"
+
+#ifdef MICROBENCHMARK_FFMPEG
+#include "ffmpeg/avframe-queue.hpp"
+#include "ffmpeg/swscale.hpp"
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+#endif
+
+// Number of scenes the source tracker has to look through.
+#define D_TRACKED_SOURCES 256
+
+// The utilities reach for the plugin-wide thread pool, so the benchmark provides its own.
+static std::shared_ptr<streamfx::util::threadpool> _threadpool;
+
+std::shared_ptr<streamfx::util::threadpool> streamfx::threadpool()
+{
+	return _threadpool;
+}
+
+// -------------------------------------------------------------------------------- //
+// util::threadpool
+// -------------------------------------------------------------------------------- //
+
+static void threadpool_push(benchmark::State& state)
+{
+	std::atomic<int64_t> done{0};
+	int64_t              batch = state.range(0);
+	for (auto _ : state) {
+		done.store(0);
+		for (int64_t n = 0; n < batch; n++) {
+			_threadpool->push([&done](streamfx::util::threadpool_data_t) { done.fetch_add(1); }, nullptr);
+		}
+		while (done.load() < batch) {
+			std::this_thread::yield();
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(threadpool_push)->Arg(1)->Arg(64)->Arg(1024)->UseRealTime();
+
+static void threadpool_push_pop(benchmark::State& state)
+{
+	for (auto _ : state) {
+		auto task = _threadpool->push([](streamfx::util::threadpool_data_t) {}, nullptr);
+		_threadpool->pop(task);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(threadpool_push_pop);
+
+// -------------------------------------------------------------------------------- //
+// util::event
+// -------------------------------------------------------------------------------- //
+
+static void event_dispatch(benchmark::State& state)
+{
+	streamfx::util::event<int32_t> event;
+	int64_t                        sum = 0;
+	for (int64_t n = 0; n < state.range(0); n++) {
+		event.add([&sum](int32_t value) { sum += value; });
+	}
+
+	for (auto _ : state) {
+		event(1);
+	}
+	benchmark::DoNotOptimize(sum);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(event_dispatch)->Arg(0)->Arg(1)->Arg(8);
+
+// -------------------------------------------------------------------------------- //
+// util::profiler
+// -------------------------------------------------------------------------------- //
+
+static void profiler_track(benchmark::State& state)
+{
+	static std::shared_ptr<streamfx::util::profiler> profiler = streamfx::util::profiler::create();
+
+	uint64_t value = static_cast<uint64_t>(state.thread_index()) * 7919;
+	for (auto _ : state) {
+		// Spread over many buckets, like real durations would be.
+		profiler->track(std::chrono::nanoseconds(value & 0xFFFFFF));
+		value = value * 6364136223846793005ull + 1442695040888963407ull;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(profiler_track)->Threads(1)->Threads(4);
+
+// -------------------------------------------------------------------------------- //
+// util::math::kalman1D
+// -------------------------------------------------------------------------------- //
+
+static void kalman1D_filter(benchmark::State& state)
+{
+	streamfx::util::math::kalman1D<double_t> filter{1.0, 1.0, 1.0, 0.0};
+	double_t                                 measurement = 0.;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(filter.filter(measurement));
+		measurement += 0.5;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(kalman1D_filter);
+
+// -------------------------------------------------------------------------------- //
+// util::copy_plane, which is what the FFmpeg encoder's copy_data spends its time in.
+// -------------------------------------------------------------------------------- //
+
+static void copy_plane(benchmark::State& state)
+{
+	std::size_t          width      = static_cast<std::size_t>(state.range(0));
+	std::size_t          height     = static_cast<std::size_t>(state.range(1));
+	std::size_t          in_stride  = width;
+	std::size_t          out_stride = (width + 63) & ~static_cast<std::size_t>(63); // Like an AVFrame would have.
+	std::vector<uint8_t> from(in_stride * height, 0x7F);
+	std::vector<uint8_t> to(out_stride * height);
+	for (auto _ : state) {
+		streamfx::util::copy_plane(to.data(), out_stride, from.data(), in_stride, width, height);
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(width * height));
+}
+BENCHMARK(copy_plane)->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160})->UseRealTime();
+
+// The same sizes around the streaming threshold, once through copy_plane and once as a regular row by row copy, to
+// see where streaming stores start to win on this machine. The destination is read afterwards, like an encoder would.
+static void copy_plane_streaming(benchmark::State& state, bool regular)
+{
+	std::size_t          width  = 4096;
+	std::size_t          height = static_cast<std::size_t>(state.range(0)) * 1024 * 1024 / width;
+	std::size_t          stride = width + 64; // Not tightly packed, so that the rows are copied one by one.
+	std::vector<uint8_t> from(stride * height, 0x7F);
+	std::vector<uint8_t> to(stride * height);
+	for (auto _ : state) {
+		if (regular) {
+			for (std::size_t y = 0; y < height; y++) {
+				std::memcpy(to.data() + y * stride, from.data() + y * stride, width);
+			}
+		} else {
+			streamfx::util::copy_plane(to.data(), stride, from.data(), stride, width, height);
+		}
+		benchmark::DoNotOptimize(to[(height / 2) * stride]);
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(width * height));
+	state.counters["streaming"] = (!regular && (width * height >= streamfx::util::get_streaming_threshold())) ? 1 : 0;
+}
+BENCHMARK_CAPTURE(copy_plane_streaming, copy_plane, false)->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK_CAPTURE(copy_plane_streaming, memcpy, true)->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+
+// -------------------------------------------------------------------------------- //
+// util::ringbuffer and util::frame_arena
+// -------------------------------------------------------------------------------- //
+
+static void ringbuffer_push_pop(benchmark::State& state)
+{
+	streamfx::util::ringbuffer<uint64_t> ring(1024);
+	uint64_t                             value = 0;
+	for (auto _ : state) {
+		ring.push(value);
+		ring.pop(value);
+		value++;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(ringbuffer_push_pop);
+
+static void frame_vector_fill(benchmark::State& state)
+{
+	for (auto _ : state) {
+		streamfx::util::frame_vector<uint32_t> values;
+		for (int64_t n = 0; n < state.range(0); n++) {
+			values.push_back(static_cast<uint32_t>(n));
+		}
+		benchmark::DoNotOptimize(values.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(frame_vector_fill)->Arg(16)->Arg(1024);
+
+static void std_vector_fill(benchmark::State& state)
+{
+	for (auto _ : state) {
+		std::vector<uint32_t> values;
+		for (int64_t n = 0; n < state.range(0); n++) {
+			values.push_back(static_cast<uint32_t>(n));
+		}
+		benchmark::DoNotOptimize(values.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(std_vector_fill)->Arg(16)->Arg(1024);
+
+#ifdef MICROBENCHMARK_FFMPEG
+// -------------------------------------------------------------------------------- //
+// ffmpeg::swscale and ffmpeg::avframe_queue
+// -------------------------------------------------------------------------------- //
+
+static void swscale_convert(benchmark::State& state)
+{
+	int32_t width  = static_cast<int32_t>(state.range(0));
+	int32_t height = static_cast<int32_t>(state.range(1));
+
+	// NV12 to I420 is what the software encoders get from OBS Studio most of the time.
+	streamfx::ffmpeg::swscale scale;
+	scale.set_source_size(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+	scale.set_source_format(AV_PIX_FMT_NV12);
+	scale.set_source_color(false, AVCOL_SPC_BT709);
+	scale.set_target_size(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+	scale.set_target_format(AV_PIX_FMT_YUV420P);
+	scale.set_target_color(false, AVCOL_SPC_BT709);
+	scale.set_threads(static_cast<uint32_t>(state.range(2)));
+	if (!scale.initialize(SWS_POINT)) {
+		state.SkipWithError("Failed to initialize swscale.");
+		return;
+	}
+
+	uint8_t* source_data[4]   = {};
+	int      source_stride[4] = {};
+	uint8_t* target_data[4]   = {};
+	int      target_stride[4] = {};
+	av_image_alloc(source_data, source_stride, width, height, AV_PIX_FMT_NV12, 32);
+	av_image_alloc(target_data, target_stride, width, height, AV_PIX_FMT_YUV420P, 32);
+
+	for (auto _ : state) {
+		scale.convert(source_data, source_stride, 0, height, target_data, target_stride);
+	}
+	state.SetItemsProcessed(state.iterations());
+
+	av_freep(&source_data[0]);
+	av_freep(&target_data[0]);
+}
+BENCHMARK(swscale_convert)->Args({1920, 1080, 1})->Args({1920, 1080, 0})->Args({3840, 2160, 0})->UseRealTime();
+
+static void avframe_queue_cycle(benchmark::State& state)
+{
+	streamfx::ffmpeg::avframe_queue queue;
+	queue.set_resolution(1920, 1080);
+	queue.set_pixel_format(AV_PIX_FMT_NV12);
+	queue.precache(4);
+
+	for (auto _ : state) {
+		auto frame = queue.pop();
+		queue.push(frame);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(avframe_queue_cycle);
+#endif
+
+// -------------------------------------------------------------------------------- //
+// obs::source_tracker
+// -------------------------------------------------------------------------------- //
+
+static void source_tracker_enumerate(benchmark::State& state)
+{
+	auto tracker = streamfx::obs::source_tracker::get();
+	if (!tracker) {
+		state.SkipWithError("The libobs core is not running.");
+		return;
+	}
+
+	for (auto _ : state) {
+		std::size_t count = 0;
+		tracker->enumerate([&count](std::string, obs_source_t*) {
+			count++;
+			return false;
+		});
+		benchmark::DoNotOptimize(count);
+	}
+	state.SetItemsProcessed(state.iterations() * D_TRACKED_SOURCES);
+}
+BENCHMARK(source_tracker_enumerate);
+
+int main(int argc, char** argv)
+{
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+
+	_threadpool = std::make_shared<streamfx::util::threadpool>();
+
+	// Only the core is needed, scenes exist without any video or audio output.
+	std::vector<obs_source_t*> scenes;
+	if (obs_startup("en-US", nullptr, nullptr)) {
+		streamfx::obs::source_tracker::initialize();
+		for (std::size_t idx = 0; idx < D_TRACKED_SOURCES; idx++) {
+			std::string name = "Scene " + std::to_string(idx);
+			scenes.push_back(obs_scene_get_source(obs_scene_create(name.c_str())));
+		}
+	}
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	if (obs_initialized()) {
+		for (auto scene : scenes) {
+			obs_source_release(scene);
+		}
+		streamfx::obs::source_tracker::finalize();
+		obs_shutdown();
+	}
+	_threadpool.reset();
+	return 0;
+}
@@ -0,0 +1,200 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "raw-frames.hpp"
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static uint64_t align(uint64_t value)
+{
+	return (value + (D_RAWFRAMES_ALIGNMENT - 1)) & ~static_cast<uint64_t>(D_RAWFRAMES_ALIGNMENT - 1);
+}
+
+raw_frames::raw_frames()
+	: _header(nullptr), _timestamps(nullptr), _data(nullptr), _size(0), _writable(false),
+#ifdef _WIN32
+	  _file(INVALID_HANDLE_VALUE), _mapping(nullptr)
+#else
+	  _file(-1)
+#endif
+{}
+
+raw_frames::~raw_frames()
+{
+#ifdef _WIN32
+	if (_data) {
+		if (_writable) {
+			FlushViewOfFile(_header, 0);
+		}
+		UnmapViewOfFile(_header);
+	}
+	if (_mapping) {
+		CloseHandle(_mapping);
+	}
+	if (_file != INVALID_HANDLE_VALUE) {
+		CloseHandle(_file);
+	}
+#else
+	if (_data) {
+		if (_writable) {
+			msync(_header, _size, MS_SYNC);
+		}
+		munmap(_header, _size);
+	}
+	if (_file >= 0) {
+		close(_file);
+	}
+#endif
+}
+
+void raw_frames::map(const std::filesystem::path& path, std::size_t size, bool writable)
+{
+	_writable = writable;
+
+#ifdef _WIN32
+	_file = CreateFileW(path.wstring().c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+						FILE_SHARE_READ, nullptr, writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+						nullptr);
+	if (_file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Failed to open file.");
+	}
+	if (!writable) {
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(_file, &file_size)) {
+			throw std::runtime_error("Failed to query file size.");
+		}
+		size = static_cast<std::size_t>(file_size.QuadPart);
+	}
+	if (size < sizeof(raw_frames_header)) {
+		throw std::runtime_error("File is too small to be a raw frame file.");
+	}
+
+	_mapping = CreateFileMappingW(_file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+								  static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+								  static_cast<DWORD>(size & 0xFFFFFFFF), nullptr);
+	if (!_mapping) {
+		throw std::runtime_error("Failed to create file mapping.");
+	}
+	void* ptr = MapViewOfFile(_mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+	if (!ptr) {
+		throw std::runtime_error("Failed to map file.");
+	}
+#else
+	_file = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY, 0644);
+	if (_file < 0) {
+		throw std::runtime_error("Failed to open file.");
+	}
+	if (writable) {
+		if (ftruncate(_file, static_cast<off_t>(size)) != 0) {
+			throw std::runtime_error("Failed to resize file.");
+		}
+	} else {
+		struct stat info;
+		if (fstat(_file, &info) != 0) {
+			throw std::runtime_error("Failed to query file size.");
+		}
+		size = static_cast<std::size_t>(info.st_size);
+	}
+	if (size < sizeof(raw_frames_header)) {
+		throw std::runtime_error("File is too small to be a raw frame file.");
+	}
+
+	void* ptr = mmap(nullptr, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, _file, 0);
+	if (ptr == MAP_FAILED) {
+		throw std::runtime_error("Failed to map file.");
+	}
+#endif
+
+	_size       = size;
+	_header     = reinterpret_cast<raw_frames_header*>(ptr);
+	_timestamps = reinterpret_cast<uint64_t*>(reinterpret_cast<uint8_t*>(ptr) + sizeof(raw_frames_header));
+	_data       = reinterpret_cast<uint8_t*>(ptr);
+}
+
+std::shared_ptr<raw_frames> raw_frames::create(const std::filesystem::path& path, uint32_t format, uint32_t width,
+											   uint32_t height, uint32_t bytes_per_pixel, uint32_t frames)
+{
+	raw_frames_header header = {};
+	std::memcpy(header.magic, D_RAWFRAMES_MAGIC, sizeof(header.magic));
+	header.version     = D_RAWFRAMES_VERSION;
+	header.format      = format;
+	header.width       = width;
+	header.height      = height;
+	header.stride      = width * bytes_per_pixel;
+	header.frames      = frames;
+	header.frame_size  = align(static_cast<uint64_t>(header.stride) * height);
+	header.data_offset = align(sizeof(raw_frames_header) + sizeof(uint64_t) * frames);
+
+	auto self = std::shared_ptr<raw_frames>(new raw_frames());
+	self->map(path, static_cast<std::size_t>(header.data_offset + header.frame_size * frames), true);
+	std::memcpy(self->_header, &header, sizeof(header));
+	return self;
+}
+
+std::shared_ptr<raw_frames> raw_frames::open(const std::filesystem::path& path)
+{
+	auto self = std::shared_ptr<raw_frames>(new raw_frames());
+	self->map(path, 0, false);
+
+	const raw_frames_header& header = *self->_header;
+	if ((std::memcmp(header.magic, D_RAWFRAMES_MAGIC, sizeof(header.magic)) != 0)
+		|| (header.version != D_RAWFRAMES_VERSION)) {
+		throw std::runtime_error("Not a raw frame file, or one of an unsupported version.");
+	}
+	if ((header.frames == 0) || (header.frame_size < (static_cast<uint64_t>(header.stride) * header.height))
+		|| ((header.data_offset + header.frame_size * header.frames) > self->_size)) {
+		throw std::runtime_error("Raw frame file is truncated or corrupt.");
+	}
+	return self;
+}
+
+const raw_frames_header& raw_frames::header() const
+{
+	return *_header;
+}
+
+uint64_t raw_frames::timestamp(uint32_t index) const
+{
+	return _timestamps[index];
+}
+
+void raw_frames::set_timestamp(uint32_t index, uint64_t timestamp)
+{
+	_timestamps[index] = timestamp;
+}
+
+const uint8_t* raw_frames::frame(uint32_t index) const
+{
+	return _data + _header->data_offset + _header->frame_size * index;
+}
+
+uint8_t* raw_frames::frame(uint32_t index)
+{
+	return _data + _header->data_offset + _header->frame_size * index;
+}
@@ -0,0 +1,90 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+// Raw frame files, written by the benchmark's capture mode and read back by its replay mode.
+//
+// Layout:
+//   - raw_frames_header
+//   - One uint64_t timestamp in nanoseconds per frame, relative to the first frame.
+//   - The frames, each starting at a multiple of D_RAWFRAMES_ALIGNMENT, rows are 'stride' bytes apart.
+//
+// Files are memory mapped, so replaying them costs no more than the page faults for the frames actually touched.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+#define D_RAWFRAMES_MAGIC "SFXRAW\0"
+#define D_RAWFRAMES_VERSION 1
+#define D_RAWFRAMES_ALIGNMENT 4096
+
+struct raw_frames_header {
+	char     magic[8];
+	uint32_t version;
+	uint32_t format; // gs_color_format
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride; // Bytes per row
+	uint32_t frames;
+	uint64_t frame_size; // Bytes per frame, including padding.
+	uint64_t data_offset;
+};
+
+class raw_frames {
+	raw_frames_header* _header;
+	uint64_t*          _timestamps;
+	uint8_t*           _data;
+	std::size_t        _size;
+	bool               _writable;
+#ifdef _WIN32
+	void* _file;
+	void* _mapping;
+#else
+	int _file;
+#endif
+
+	raw_frames();
+
+	void map(const std::filesystem::path& path, std::size_t size, bool writable);
+
+	public:
+	~raw_frames();
+
+	raw_frames(const raw_frames&) = delete;
+	raw_frames& operator=(const raw_frames&) = delete;
+
+	/** Create a new file for this many frames, replacing any existing one. */
+	static std::shared_ptr<raw_frames> create(const std::filesystem::path& path, uint32_t format, uint32_t width,
+											  uint32_t height, uint32_t bytes_per_pixel, uint32_t frames);
+
+	/** Open an existing file for reading, throws if it is not a raw frame file. */
+	static std::shared_ptr<raw_frames> open(const std::filesystem::path& path);
+
+	const raw_frames_header& header() const;
+
+	uint64_t timestamp(uint32_t index) const;
+
+	void set_timestamp(uint32_t index, uint64_t timestamp);
+
+	const uint8_t* frame(uint32_t index) const;
+
+	uint8_t* frame(uint32_t index);
+};
@@ -0,0 +1,100 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2019 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "av1.hpp"
+
+using namespace streamfx::encoder::codec;
+
+enum class obu_type : uint8_t { // 4 bits
+	RESERVED_0             = 0,
+	SEQUENCE_HEADER        = 1,
+	TEMPORAL_DELIMITER     = 2,
+	FRAME_HEADER           = 3,
+	TILE_GROUP             = 4,
+	METADATA               = 5,
+	FRAME                  = 6,
+	REDUNDANT_FRAME_HEADER = 7,
+	TILE_LIST              = 8,
+	PADDING                = 15,
+};
+
+/** Read an unsigned LEB128 value of at most eight bytes.
+ *
+ * @return Number of bytes read, or 0 if the value doesn't fit into the buffer.
+ */
+static std::size_t read_leb128(const uint8_t* data, const uint8_t* end, uint64_t& value)
+{
+	value = 0;
+	for (std::size_t idx = 0; (idx < 8) && ((data + idx) < end); idx++) {
+		value |= static_cast<uint64_t>(data[idx] & 0x7F) << (idx * 7);
+		if ((data[idx] & 0x80) == 0) {
+			return idx + 1;
+		}
+	}
+	return 0;
+}
+
+void av1::extract_header_sei(uint8_t* data, std::size_t sz_data, std::vector<uint8_t>& header,
+							 std::vector<uint8_t>& sei)
+{
+	// Reserve enough memory to store the entire packet data if necessary.
+	header.reserve(sz_data);
+	sei.reserve(sz_data);
+
+	const uint8_t* ptr = data;
+	const uint8_t* end = data + sz_data;
+	while (ptr < end) {
+		// forbidden_bit(1), obu_type(4), obu_extension_flag(1), obu_has_size_field(1), obu_reserved_1bit(1)
+		const uint8_t* obu           = ptr;
+		auto           type          = static_cast<obu_type>((ptr[0] >> 3) & 0xF);
+		bool           has_extension = (ptr[0] & 0x4) != 0;
+		bool           has_size      = (ptr[0] & 0x2) != 0;
+		ptr += has_extension ? 2 : 1;
+		if (ptr > end) {
+			return; // Truncated header.
+		}
+
+		// Without a size field, the OBU extends to the end of the packet.
+		uint64_t size = static_cast<uint64_t>(end - ptr);
+		if (has_size) {
+			std::size_t length = read_leb128(ptr, end, size);
+			if (length == 0) {
+				return;
+			}
+			ptr += length;
+		}
+		if (size > static_cast<uint64_t>(end - ptr)) {
+			return; // Truncated payload.
+		}
+		ptr += size;
+
+		switch (type) {
+		case obu_type::SEQUENCE_HEADER:
+			header.insert(header.end(), obu, ptr);
+			break;
+		case obu_type::METADATA:
+			sei.insert(sei.end(), obu, ptr);
+			break;
+		default:
+			break;
+		}
+	}
+}
@@ -0,0 +1,69 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2019 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include "common.hpp"
+
+// Codec: AV1
+#define S_CODEC_AV1 "Codec.AV1"
+#define S_CODEC_AV1_PROFILE "Codec.AV1.Profile"
+#define S_CODEC_AV1_TIER "Codec.AV1.Tier"
+#define S_CODEC_AV1_LEVEL "Codec.AV1.Level"
+
+namespace streamfx::encoder::codec::av1 {
+	enum class profile {
+		MAIN,
+		HIGH,
+		PROFESSIONAL,
+		UNKNOWN = -1,
+	};
+
+	enum class tier {
+		MAIN,
+		HIGH,
+		UNKNOWN = -1,
+	};
+
+	enum class level { // seq_level_idx
+		L2_0    = 0,
+		L2_1    = 1,
+		L3_0    = 4,
+		L3_1    = 5,
+		L4_0    = 8,
+		L4_1    = 9,
+		L5_0    = 12,
+		L5_1    = 13,
+		L5_2    = 14,
+		L5_3    = 15,
+		L6_0    = 16,
+		L6_1    = 17,
+		L6_2    = 18,
+		L6_3    = 19,
+		UNKNOWN = -1,
+	};
+
+	/** Split a low overhead bitstream into its sequence headers and its metadata.
+	 *
+	 * AV1 has no SEI, metadata OBUs (such as HDR information) take its place instead.
+	 */
+	void extract_header_sei(uint8_t* data, std::size_t sz_data, std::vector<uint8_t>& header,
+							std::vector<uint8_t>& sei);
+} // namespace streamfx::encoder::codec::av1
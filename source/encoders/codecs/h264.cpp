@@ -20,3 +20,34 @@
 // SOFTWARE.
 
 #include "h264.hpp"
+#include "nal.hpp"
+
+using namespace streamfx::encoder::codec;
+
+enum class nal_unit_type : uint8_t { // 5 bits
+	SEI = 6,
+	SPS = 7,
+	PPS = 8,
+};
+
+void h264::extract_header_sei(uint8_t* data, std::size_t sz_data, std::vector<uint8_t>& header,
+							  std::vector<uint8_t>& sei)
+{
+	// Reserve enough memory to store the entire packet data if necessary.
+	header.reserve(sz_data);
+	sei.reserve(sz_data);
+
+	for_each_nal(data, sz_data, [&header, &sei](const nal_view& nal) {
+		switch (static_cast<nal_unit_type>(nal.data[0] & 0x1F)) {
+		case nal_unit_type::SPS:
+		case nal_unit_type::PPS:
+			header.insert(header.end(), nal.begin, nal.end);
+			break;
+		case nal_unit_type::SEI:
+			sei.insert(sei.end(), nal.begin, nal.end);
+			break;
+		default:
+			break;
+		}
+	});
+}
@@ -60,4 +60,7 @@ namespace streamfx::encoder::codec::h264 {
 		L6_2,
 		UNKNOWN = -1,
 	};
+
+	void extract_header_sei(uint8_t* data, std::size_t sz_data, std::vector<uint8_t>& header,
+							std::vector<uint8_t>& sei);
 } // namespace streamfx::encoder::codec::h264
@@ -20,6 +20,7 @@
 // SOFTWARE.
 
 #include "hevc.hpp"
+#include "nal.hpp"
 
 using namespace streamfx::encoder::codec;
 
@@ -90,150 +91,31 @@ enum class nal_unit_type : uint8_t { // 6 bits
 	UNSPEC63       = 63,
 };
 
-struct hevc_nal_unit_header {
-	bool          zero_bit : 1;
-	nal_unit_type nut : 6;
-	uint8_t       layer_id : 6;
-	uint8_t       temporal_id_plus1 : 3;
-};
-
-struct hevc_nal {
-	hevc_nal_unit_header* header;
-	std::size_t           size = 0;
-	uint8_t*              data = nullptr;
-};
-
-bool is_nal(uint8_t* data, uint8_t* end)
-{
-	std::size_t s = static_cast<size_t>(end - data);
-	if (s < 4)
-		return false;
-
-	if (*data != 0x0)
-		return false;
-	if (*(data + 1) != 0x0)
-		return false;
-	if (*(data + 2) != 0x0)
-		return false;
-	if (*(data + 3) != 0x1)
-		return false;
-
-	return true;
-}
-
-bool seek_to_nal(uint8_t*& data, uint8_t* end)
-{
-	if (data > end)
-		return false;
-
-	for (; data <= end; data++) {
-		if (is_nal(data, end)) {
-			return true;
-		}
-	}
-
-	return false;
-}
-
-std::size_t get_nal_size(uint8_t* data, uint8_t* end)
-{
-	uint8_t* ptr = data + 4;
-	if (!seek_to_nal(ptr, end)) {
-		return static_cast<size_t>(end - data);
-	}
-	return static_cast<size_t>(ptr - data);
-}
-
-bool is_discard_marker(uint8_t* data, uint8_t* end)
-{
-	std::size_t s = static_cast<size_t>(end - data);
-	if (s < 4)
-		return false;
-
-	if (*data != 0x0)
-		return false;
-	if (*(data + 1) != 0x0)
-		return false;
-
-	if (*(data + 2) == 0x3) {
-		// Discard marker only if the next byte is not 0x0, 0x1, 0x2 or 0x3.
-		if (*(data + 3) != 0x0)
-			return false;
-		if (*(data + 3) != 0x1)
-			return false;
-		if (*(data + 3) != 0x2)
-			return false;
-		if (*(data + 3) != 0x3)
-			return false;
-
-		return true;
-	} else {
-		if (*(data + 2) == 0x0)
-			return true;
-		if (*(data + 2) == 0x1)
-			return true;
-		if (*(data + 2) == 0x2)
-			return true;
-
-		return false;
-	}
-}
-
-bool should_discard_nal(uint8_t* data, uint8_t* end)
-{
-	if (data > end)
-		return true;
-
-	for (; data <= end; data++) {
-		if (is_discard_marker(data, end))
-			return true;
-	}
-
-	return false;
-}
-
-void progress_parse(uint8_t*& ptr, uint8_t* end, size_t& sz)
-{
-	ptr += sz;
-	sz = get_nal_size(ptr, end);
-}
-
 void hevc::extract_header_sei(uint8_t* data, std::size_t sz_data, std::vector<uint8_t>& header,
 							  std::vector<uint8_t>& sei)
 {
-	uint8_t* ptr = data;
-	uint8_t* end = data + sz_data;
-
 	// Reserve enough memory to store the entire packet data if necessary.
 	header.reserve(sz_data);
 	sei.reserve(sz_data);
 
-	if (!seek_to_nal(ptr, end)) {
-		return;
-	}
-
-	for (std::size_t nal_sz = get_nal_size(ptr, end); nal_sz > 0; progress_parse(ptr, end, nal_sz)) {
-		if (should_discard_nal(ptr + 4, ptr + nal_sz)) {
-			continue;
+	for_each_nal(data, sz_data, [&header, &sei](const nal_view& nal) {
+		if (nal.size() < 2) {
+			return; // Too short for the two byte header.
 		}
 
-		hevc_nal nal;
-		nal.header = reinterpret_cast<hevc_nal_unit_header*>(ptr + 4);
-		nal.size   = nal_sz - 4 - 2;
-		nal.data   = ptr + 4 + 2;
-
-		switch (nal.header->nut) {
+		// forbidden_zero_bit(1), nal_unit_type(6), nuh_layer_id(6), nuh_temporal_id_plus1(3)
+		switch (static_cast<nal_unit_type>((nal.data[0] >> 1) & 0x3F)) {
 		case nal_unit_type::VPS:
 		case nal_unit_type::SPS:
 		case nal_unit_type::PPS:
-			header.insert(header.end(), ptr, ptr + nal_sz);
+			header.insert(header.end(), nal.begin, nal.end);
 			break;
 		case nal_unit_type::PREFIX_SEI:
 		case nal_unit_type::SUFFIX_SEI:
-			sei.insert(sei.end(), ptr, ptr + nal_sz);
+			sei.insert(sei.end(), nal.begin, nal.end);
 			break;
 		default:
 			break;
 		}
-	}
+	});
 }
@@ -0,0 +1,215 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2019 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "nal.hpp"
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__x86_64__) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ST_HAVE_SSE2
+#elif defined(_M_ARM64) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ST_HAVE_NEON
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace streamfx::encoder::codec;
+
+#ifdef ST_HAVE_SSE2
+static inline uint32_t count_trailing_zeros(uint32_t v)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, v);
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(__builtin_ctz(v));
+#endif
+}
+#endif
+
+const uint8_t* streamfx::encoder::codec::find_start_code(const uint8_t* begin, const uint8_t* end)
+{
+	const uint8_t* ptr = begin;
+
+	// Test 16 candidate positions at once by comparing the stream against itself shifted by one and two bytes.
+#if defined(ST_HAVE_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one  = _mm_set1_epi8(1);
+	for (; (end - ptr) >= 18; ptr += 16) {
+		__m128i b0   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+		__m128i b1   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + 1));
+		__m128i b2   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + 2));
+		__m128i hits = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)),
+									 _mm_cmpeq_epi8(b2, one));
+		if (uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits)); mask != 0) {
+			return ptr + count_trailing_zeros(mask);
+		}
+	}
+#elif defined(ST_HAVE_NEON)
+	const uint8x16_t zero = vdupq_n_u8(0);
+	const uint8x16_t one  = vdupq_n_u8(1);
+	for (; (end - ptr) >= 18; ptr += 16) {
+		uint8x16_t b0   = vld1q_u8(ptr);
+		uint8x16_t b1   = vld1q_u8(ptr + 1);
+		uint8x16_t b2   = vld1q_u8(ptr + 2);
+		uint8x16_t hits = vandq_u8(vandq_u8(vceqq_u8(b0, zero), vceqq_u8(b1, zero)), vceqq_u8(b2, one));
+		uint64x2_t wide = vreinterpretq_u64_u8(hits);
+		if ((vgetq_lane_u64(wide, 0) | vgetq_lane_u64(wide, 1)) != 0) {
+			break; // The scalar loop below finds the exact position.
+		}
+	}
+#endif
+
+	for (; (end - ptr) >= 3; ptr++) {
+		if ((ptr[0] == 0x00) && (ptr[1] == 0x00) && (ptr[2] == 0x01)) {
+			return ptr;
+		}
+	}
+	return end;
+}
+
+void streamfx::encoder::codec::for_each_nal(const uint8_t* data, std::size_t size,
+											std::function<void(const nal_view& nal)> cb)
+{
+	const uint8_t* end = data + size;
+	const uint8_t* ptr = find_start_code(data, end);
+	while (ptr != end) {
+		nal_view nal;
+		nal.begin = ((ptr > data) && (ptr[-1] == 0x00)) ? ptr - 1 : ptr;
+		nal.data  = ptr + 3;
+
+		ptr     = find_start_code(nal.data, end);
+		nal.end = ptr;
+
+		// Trailing zero bytes, including the first byte of a four byte start code, belong to neither unit.
+		while ((nal.end > nal.data) && (nal.end[-1] == 0x00)) {
+			nal.end--;
+		}
+
+		if (nal.end > nal.data) {
+			cb(nal);
+		}
+	}
+}
+
+void streamfx::encoder::codec::escape_rbsp(const uint8_t* data, std::size_t size, std::vector<uint8_t>& out)
+{
+	out.reserve(out.size() + size + size / 64);
+
+	std::size_t zeros = 0;
+	for (std::size_t idx = 0; idx < size; idx++) {
+		// Two zero bytes may never be followed by anything up to 03 without a 03 in between.
+		if ((zeros >= 2) && (data[idx] <= 0x03)) {
+			out.push_back(0x03);
+			zeros = 0;
+		}
+		out.push_back(data[idx]);
+		zeros = (data[idx] == 0x00) ? zeros + 1 : 0;
+	}
+}
+
+void streamfx::encoder::codec::unescape_rbsp(const uint8_t* data, std::size_t size, std::vector<uint8_t>& out)
+{
+	out.reserve(out.size() + size);
+
+	std::size_t zeros = 0;
+	for (std::size_t idx = 0; idx < size; idx++) {
+		if ((zeros >= 2) && (data[idx] == 0x03)) {
+			zeros = 0;
+			continue;
+		}
+		out.push_back(data[idx]);
+		zeros = (data[idx] == 0x00) ? zeros + 1 : 0;
+	}
+}
+
+// SEI payload type of user_data_unregistered, identical in H.264 and HEVC.
+#define ST_SEI_USER_DATA_UNREGISTERED 5
+#define ST_SEI_UUID_SIZE 16
+
+static void write_sei_value(std::vector<uint8_t>& out, std::size_t value)
+{
+	for (; value >= 0xFF; value -= 0xFF) {
+		out.push_back(0xFF);
+	}
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+static bool read_sei_value(const uint8_t*& ptr, const uint8_t* end, std::size_t& value)
+{
+	value = 0;
+	while (ptr != end) {
+		uint8_t byte = *(ptr++);
+		value += byte;
+		if (byte != 0xFF) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::vector<uint8_t> streamfx::encoder::codec::make_user_data_sei(const uint8_t* header, std::size_t header_size,
+																  const uint8_t* uuid, const uint8_t* payload,
+																  std::size_t payload_size)
+{
+	std::vector<uint8_t> rbsp;
+	rbsp.reserve(ST_SEI_UUID_SIZE + payload_size + 8);
+	write_sei_value(rbsp, ST_SEI_USER_DATA_UNREGISTERED);
+	write_sei_value(rbsp, ST_SEI_UUID_SIZE + payload_size);
+	rbsp.insert(rbsp.end(), uuid, uuid + ST_SEI_UUID_SIZE);
+	rbsp.insert(rbsp.end(), payload, payload + payload_size);
+	rbsp.push_back(0x80); // rbsp_trailing_bits
+
+	std::vector<uint8_t> nal = {0x00, 0x00, 0x00, 0x01};
+	nal.insert(nal.end(), header, header + header_size);
+	escape_rbsp(rbsp.data(), rbsp.size(), nal);
+	return nal;
+}
+
+bool streamfx::encoder::codec::find_user_data_sei(const uint8_t* rbsp, std::size_t size, const uint8_t* uuid,
+												  const uint8_t** payload, std::size_t* payload_size)
+{
+	const uint8_t* ptr = rbsp;
+	const uint8_t* end = rbsp + size;
+
+	// Messages follow each other until only the trailing bits are left.
+	while ((end - ptr) > 1) {
+		std::size_t type = 0;
+		std::size_t len  = 0;
+		if (!read_sei_value(ptr, end, type) || !read_sei_value(ptr, end, len)
+			|| (static_cast<std::size_t>(end - ptr) < len)) {
+			return false;
+		}
+
+		if ((type == ST_SEI_USER_DATA_UNREGISTERED) && (len >= ST_SEI_UUID_SIZE)
+			&& (memcmp(ptr, uuid, ST_SEI_UUID_SIZE) == 0)) {
+			*payload      = ptr + ST_SEI_UUID_SIZE;
+			*payload_size = len - ST_SEI_UUID_SIZE;
+			return true;
+		}
+		ptr += len;
+	}
+	return false;
+}
@@ -0,0 +1,71 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2019 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace streamfx::encoder::codec {
+	/** A single NAL unit inside an Annex-B byte stream, pointing into the original buffer. */
+	struct nal_view {
+		const uint8_t* begin; // First byte of the start code, which may be three or four bytes long.
+		const uint8_t* data;  // First byte of the NAL unit header.
+		const uint8_t* end;   // One past the last byte of the NAL unit, without trailing zero bytes.
+
+		std::size_t size() const
+		{
+			return static_cast<std::size_t>(end - data);
+		}
+	};
+
+	/** Find the next Annex-B start code (00 00 01).
+	 *
+	 * @return The first zero byte of the start code, or end if there is none.
+	 */
+	const uint8_t* find_start_code(const uint8_t* begin, const uint8_t* end);
+
+	/** Call cb for every NAL unit in an Annex-B byte stream, in order. */
+	void for_each_nal(const uint8_t* data, std::size_t size, std::function<void(const nal_view& nal)> cb);
+
+	/** Append a raw byte sequence payload to out, with emulation prevention bytes so it never forms a start code. */
+	void escape_rbsp(const uint8_t* data, std::size_t size, std::vector<uint8_t>& out);
+
+	/** Append an escaped NAL unit payload to out as a raw byte sequence payload, without emulation prevention. */
+	void unescape_rbsp(const uint8_t* data, std::size_t size, std::vector<uint8_t>& out);
+
+	/** Build a complete Annex-B SEI NAL unit with a single user_data_unregistered message.
+	 *
+	 * @param header The NAL unit header of an SEI, one byte for H.264 and two for HEVC.
+	 * @param uuid The 16 byte identifier of the message.
+	 */
+	std::vector<uint8_t> make_user_data_sei(const uint8_t* header, std::size_t header_size, const uint8_t* uuid,
+											const uint8_t* payload, std::size_t payload_size);
+
+	/** Find a user_data_unregistered message with the given identifier in the unescaped payload of an SEI NAL unit.
+	 *
+	 * @param rbsp The SEI payload after the NAL unit header, without emulation prevention bytes.
+	 * @return true and the message payload after the identifier if found, otherwise false.
+	 */
+	bool find_user_data_sei(const uint8_t* rbsp, std::size_t size, const uint8_t* uuid, const uint8_t** payload,
+							std::size_t* payload_size);
+} // namespace streamfx::encoder::codec
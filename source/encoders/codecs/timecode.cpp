@@ -0,0 +1,111 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2022 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "timecode.hpp"
+#include <chrono>
+
+// Identifies the message among other user data, generated once and never to be changed.
+static const uint8_t ST_TIMECODE_UUID[16] = {0x5c, 0x1d, 0x72, 0x3e, 0x9b, 0x4f, 0x4a, 0x0c,
+											 0x8e, 0x61, 0x27, 0xd3, 0xb0, 0x95, 0x4e, 0x13};
+#define ST_TIMECODE_VERSION 1
+#define ST_TIMECODE_SIZE (1 + 8 + 8 + 8)
+
+// NAL unit headers of an SEI, with nuh_temporal_id_plus1 = 1 for HEVC.
+static const uint8_t ST_H264_SEI[1] = {0x06};
+static const uint8_t ST_HEVC_SEI[2] = {39 << 1, 0x01};
+
+static void write_u64(uint8_t*& ptr, uint64_t value)
+{
+	for (int32_t shift = 56; shift >= 0; shift -= 8) {
+		*(ptr++) = static_cast<uint8_t>(value >> shift);
+	}
+}
+
+static uint64_t read_u64(const uint8_t*& ptr)
+{
+	uint64_t value = 0;
+	for (std::size_t idx = 0; idx < 8; idx++) {
+		value = (value << 8) | *(ptr++);
+	}
+	return value;
+}
+
+uint64_t streamfx::encoder::codec::timecode::now()
+{
+	auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(since_epoch).count());
+}
+
+std::vector<uint8_t> streamfx::encoder::codec::timecode::make_sei(bool hevc, const frame_times& times)
+{
+	uint8_t  payload[ST_TIMECODE_SIZE];
+	uint8_t* ptr = payload;
+	*(ptr++)     = ST_TIMECODE_VERSION;
+	write_u64(ptr, static_cast<uint64_t>(times.pts));
+	write_u64(ptr, times.captured);
+	write_u64(ptr, times.encoded);
+
+	if (hevc) {
+		return make_user_data_sei(ST_HEVC_SEI, sizeof(ST_HEVC_SEI), ST_TIMECODE_UUID, payload, sizeof(payload));
+	} else {
+		return make_user_data_sei(ST_H264_SEI, sizeof(ST_H264_SEI), ST_TIMECODE_UUID, payload, sizeof(payload));
+	}
+}
+
+bool streamfx::encoder::codec::timecode::read_sei(bool hevc, const nal_view& nal, frame_times& times)
+{
+	std::size_t header = hevc ? 2 : 1;
+	if (nal.size() <= header) {
+		return false;
+	}
+	if (hevc ? (((nal.data[0] >> 1) & 0x3F) != 39) : ((nal.data[0] & 0x1F) != 6)) {
+		return false;
+	}
+
+	std::vector<uint8_t> rbsp;
+	unescape_rbsp(nal.data + header, nal.size() - header, rbsp);
+
+	const uint8_t* payload = nullptr;
+	std::size_t    size    = 0;
+	if (!find_user_data_sei(rbsp.data(), rbsp.size(), ST_TIMECODE_UUID, &payload, &size)
+		|| (size < ST_TIMECODE_SIZE) || (payload[0] != ST_TIMECODE_VERSION)) {
+		return false;
+	}
+
+	const uint8_t* ptr = payload + 1;
+	times.pts          = static_cast<int64_t>(read_u64(ptr));
+	times.captured     = read_u64(ptr);
+	times.encoded      = read_u64(ptr);
+	return true;
+}
+
+bool streamfx::encoder::codec::timecode::is_picture(bool hevc, const nal_view& nal)
+{
+	if (nal.size() == 0) {
+		return false;
+	}
+	if (hevc) {
+		return ((nal.data[0] >> 1) & 0x3F) < 32; // VCL NAL unit types are 0 to 31.
+	} else {
+		uint8_t type = nal.data[0] & 0x1F;
+		return (type >= 1) && (type <= 5);
+	}
+}
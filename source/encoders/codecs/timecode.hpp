@@ -0,0 +1,51 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2022 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "nal.hpp"
+
+namespace streamfx::encoder::codec::timecode {
+	/** Wall clock times of a single frame, carried in a user_data_unregistered SEI in front of its picture.
+	 *
+	 * All times are microseconds since the Unix epoch, so that a receiver on another machine can compare them with its
+	 * own clock, as long as both clocks are synchronized.
+	 */
+	struct frame_times {
+		int64_t  pts;      // In the encoder's time base.
+		uint64_t captured; // When OBS captured the frame.
+		uint64_t encoded;  // When the packet left the encoder.
+	};
+
+	/** The current wall clock time in microseconds since the Unix epoch. */
+	uint64_t now();
+
+	/** Build the SEI NAL unit for a frame, including its start code. */
+	std::vector<uint8_t> make_sei(bool hevc, const frame_times& times);
+
+	/** Read the frame times from a NAL unit, if it is an SEI that carries them. */
+	bool read_sei(bool hevc, const nal_view& nal, frame_times& times);
+
+	/** True for NAL units that hold coded picture data, in front of which the SEI belongs. */
+	bool is_picture(bool hevc, const nal_view& nal);
+} // namespace streamfx::encoder::codec::timecode
@@ -21,19 +21,29 @@
 
 #include "encoder-ffmpeg.hpp"
 #include "strings.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
+#include "codecs/av1.hpp"
+#include "codecs/h264.hpp"
 #include "codecs/hevc.hpp"
+#include "codecs/timecode.hpp"
 #include "ffmpeg/tools.hpp"
 #include "handlers/debug_handler.hpp"
 #include "obs/gs/gs-helper.hpp"
 #include "plugin.hpp"
+#include "util/util-plane-copy.hpp"
+#include "util/util-platform.hpp"
 
 #ifdef ENABLE_ENCODER_FFMPEG_AMF
+#include "handlers/amf_av1_handler.hpp"
 #include "handlers/amf_h264_handler.hpp"
 #include "handlers/amf_hevc_handler.hpp"
 #endif
 
 #ifdef ENABLE_ENCODER_FFMPEG_NVENC
+#include "handlers/nvenc_av1_handler.hpp"
 #include "handlers/nvenc_h264_handler.hpp"
 #include "handlers/nvenc_hevc_handler.hpp"
 #endif
@@ -42,13 +52,26 @@
 #include "handlers/prores_aw_handler.hpp"
 #endif
 
+#ifdef ENABLE_ENCODER_FFMPEG_SOFTWARE
+#include "handlers/software_handler.hpp"
+#endif
+
+#ifdef ENABLE_ENCODER_FFMPEG_VAAPI
+#include "handlers/vaapi_handler.hpp"
+#endif
+
+#ifdef ENABLE_BENCHMARK
+#include "handlers/null_handler.hpp"
+#endif
+
 extern "C" {
 #pragma warning(push)
 #pragma warning(disable : 4244)
-#include <obs-avc.h>
 #include <libavcodec/avcodec.h>
 #include <libavutil/dict.h>
 #include <libavutil/frame.h>
+#include <libavutil/hwcontext.h>
+#include <libavutil/imgutils.h>
 #include <libavutil/opt.h>
 #include <libavutil/pixdesc.h>
 #pragma warning(pop)
@@ -57,6 +80,12 @@ extern "C" {
 #ifdef WIN32
 #include "ffmpeg/hwapi/d3d11.hpp"
 #endif
+#ifdef ENABLE_NVIDIA_CUDA
+#include "ffmpeg/hwapi/cuda.hpp"
+#endif
+#ifdef ENABLE_ENCODER_FFMPEG_VAAPI
+#include "ffmpeg/hwapi/vaapi.hpp"
+#endif
 
 // FFmpeg
 #define ST_I18N_FFMPEG "FFmpegEncoder"
@@ -64,13 +93,52 @@ extern "C" {
 #define ST_I18N_FFMPEG_CUSTOMSETTINGS ST_I18N_FFMPEG ".CustomSettings"
 #define ST_KEY_FFMPEG_CUSTOMSETTINGS "FFmpeg.CustomSettings"
 #define ST_I18N_FFMPEG_THREADS ST_I18N_FFMPEG ".Threads"
-#define ST_KEY_FFMPEG_THREADS "FFmpeg.Threads"
+#define ST_I18N_FFMPEG_THREADPOLICY ST_I18N_FFMPEG ".ThreadPolicy"
+#define ST_I18N_FFMPEG_THREADPOLICY_PERFORMANCE ST_I18N_FFMPEG_THREADPOLICY ".Performance"
+#define ST_I18N_FFMPEG_THREADPOLICY_BACKGROUND ST_I18N_FFMPEG_THREADPOLICY ".Background"
+#define ST_KEY_FFMPEG_THREADPOLICY "FFmpeg.ThreadPolicy"
+#define ST_I18N_FFMPEG_CONVERSIONTHREADS ST_I18N_FFMPEG ".ConversionThreads"
+#define ST_KEY_FFMPEG_CONVERSIONTHREADS "FFmpeg.ConversionThreads"
+#define ST_I18N_FFMPEG_GPUCONVERSION ST_I18N_FFMPEG ".GPUConversion"
+#define ST_KEY_FFMPEG_GPUCONVERSION "FFmpeg.GPUConversion"
+#define ST_I18N_FFMPEG_GROUP ST_I18N_FFMPEG ".Group"
+#define ST_KEY_FFMPEG_GROUP "FFmpeg.Group"
+#define ST_I18N_FFMPEG_GROUP_WIDTH ST_I18N_FFMPEG ".Group.Width"
+#define ST_KEY_FFMPEG_GROUP_WIDTH "FFmpeg.Group.Width"
+#define ST_I18N_FFMPEG_GROUP_HEIGHT ST_I18N_FFMPEG ".Group.Height"
+#define ST_KEY_FFMPEG_GROUP_HEIGHT "FFmpeg.Group.Height"
 #define ST_I18N_FFMPEG_COLORFORMAT ST_I18N_FFMPEG ".ColorFormat"
 #define ST_KEY_FFMPEG_COLORFORMAT "FFmpeg.ColorFormat"
 #define ST_I18N_FFMPEG_STANDARDCOMPLIANCE ST_I18N_FFMPEG ".StandardCompliance"
 #define ST_KEY_FFMPEG_STANDARDCOMPLIANCE "FFmpeg.StandardCompliance"
 #define ST_I18N_FFMPEG_GPU ST_I18N_FFMPEG ".GPU"
 #define ST_KEY_FFMPEG_GPU "FFmpeg.GPU"
+#define ST_I18N_FFMPEG_ADAPTER ST_I18N_FFMPEG ".Adapter"
+#define ST_I18N_FFMPEG_ADAPTER_OBS ST_I18N_FFMPEG_ADAPTER ".OBS"
+#define ST_KEY_FFMPEG_ADAPTER "FFmpeg.Adapter"
+#define ST_I18N_FFMPEG_TEXTURERING ST_I18N_FFMPEG ".TextureRing"
+#define ST_KEY_FFMPEG_TEXTURERING "FFmpeg.TextureRing"
+#define ST_I18N_FFMPEG_SESSIONCACHE ST_I18N_FFMPEG ".SessionCache"
+#define ST_KEY_FFMPEG_SESSIONCACHE "FFmpeg.SessionCache"
+#define ST_I18N_FFMPEG_SESSIONLIMIT ST_I18N_FFMPEG ".SessionLimit"
+#define ST_KEY_FFMPEG_SESSIONLIMIT "FFmpeg.SessionLimit"
+#define ST_I18N_FFMPEG_ZEROCOPY ST_I18N_FFMPEG ".ZeroCopy"
+#define ST_KEY_FFMPEG_ZEROCOPY "FFmpeg.ZeroCopy"
+#define ST_I18N_FFMPEG_SHAREDFRAMES ST_I18N_FFMPEG ".SharedFrames"
+#define ST_KEY_FFMPEG_SHAREDFRAMES "FFmpeg.SharedFrames"
+#define ST_I18N_FFMPEG_SCALER ST_I18N_FFMPEG ".Scaler"
+#define ST_I18N_FFMPEG_SCALER_FASTEST ST_I18N_FFMPEG_SCALER ".Fastest"
+#define ST_I18N_FFMPEG_SCALER_NORMAL ST_I18N_FFMPEG_SCALER ".Normal"
+#define ST_I18N_FFMPEG_SCALER_BEST ST_I18N_FFMPEG_SCALER ".Best"
+#define ST_KEY_FFMPEG_SCALER "FFmpeg.Scaler"
+#define ST_I18N_FFMPEG_ASYNC ST_I18N_FFMPEG ".Async"
+#define ST_KEY_FFMPEG_ASYNC "FFmpeg.Async"
+#define ST_I18N_FFMPEG_ROI ST_I18N_FFMPEG ".RegionOfInterest"
+#define ST_KEY_FFMPEG_ROI "FFmpeg.RegionOfInterest"
+#define ST_I18N_FFMPEG_ROI_STRENGTH ST_I18N_FFMPEG_ROI ".Strength"
+#define ST_KEY_FFMPEG_ROI_STRENGTH "FFmpeg.RegionOfInterest.Strength"
+#define ST_I18N_FFMPEG_TIMECODE ST_I18N_FFMPEG ".Timecode"
+#define ST_KEY_FFMPEG_TIMECODE "FFmpeg.Timecode"
 
 #define ST_I18N_KEYFRAMES ST_I18N_FFMPEG ".KeyFrames"
 #define ST_I18N_KEYFRAMES_INTERVALTYPE ST_I18N_KEYFRAMES ".IntervalType"
@@ -80,11 +148,226 @@ extern "C" {
 #define ST_KEY_KEYFRAMES_INTERVAL_SECONDS "KeyFrames.Interval.Seconds"
 #define ST_KEY_KEYFRAMES_INTERVAL_FRAMES "KeyFrames.Interval.Frames"
 
+#define ST_I18N_STATISTICS "FFmpegEncoder.Statistics"
+#define ST_KEY_STATISTICS "Statistics"
+#define ST_I18N_STATISTICS_FILE ST_I18N_STATISTICS ".File"
+#define ST_KEY_STATISTICS_FILE "Statistics.File"
+#define ST_I18N_STATISTICS_SAVE ST_I18N_STATISTICS ".Save"
+#define ST_KEY_STATISTICS_SAVE "Statistics.Save"
+
+// Submitted frames remembered for latency tracking, in case an encoder drops some without a packet.
+#define ST_STATISTICS_MAX_PENDING 256
+// Packets remembered for the per-packet statistics file, older ones are overwritten.
+#define ST_STATISTICS_PACKETS 16384
+// Packets to allocate up front, more are created on demand.
+#define ST_PACKET_POOL_PRECACHE 8
+// Seconds of encoding after which handlers get to look at the statistics.
+#define ST_STATISTICS_WARMUP 5
+
+// Special values for the adapter selection, anything else is an index into the adapter list.
+#define ST_ADAPTER_AUTOMATIC -2
+#define ST_ADAPTER_OBS -1
+
+// Frames kept in the pool beyond the encoder's own lag.
+#define ST_FRAME_POOL_MARGIN 2
+
+// Frames a GPU conversion stays in flight before it is read back.
+#define ST_GPU_CONVERSION_LATENCY 2
+
 using namespace streamfx::encoder::ffmpeg;
 using namespace streamfx::encoder::codec;
 
+static void track_duration(std::shared_ptr<streamfx::util::profiler>&         profiler,
+						   std::chrono::high_resolution_clock::time_point begin)
+{
+	profiler->track(std::chrono::high_resolution_clock::now() - begin);
+}
+
+static std::size_t get_async_capacity(AVCodecContext* context)
+{
+	// Enough room for everything the encoder may hold on to, plus a bit of slack for hiccups.
+	return std::max<std::size_t>(4, static_cast<size_t>(std::max<int>(context->delay, 0)) + 2);
+}
+
 enum class keyframe_type { SECONDS, FRAMES };
 
+/** Identify an input frame by its buffer and its contents, as OBS hands the same buffers out again for later frames.
+ *
+ * Hashing a whole word at a time takes a fraction of the time that the conversion itself takes.
+ */
+static uint64_t get_frame_identity(const struct encoder_frame* frame, AVPixelFormat format, uint32_t height)
+{
+	const AVPixFmtDescriptor* desc   = av_pix_fmt_desc_get(format);
+	int32_t                   planes = std::min<int32_t>(av_pix_fmt_count_planes(format), MAX_AV_PLANES);
+
+	uint64_t hash = 14695981039346656037ull ^ static_cast<uint64_t>(reinterpret_cast<uintptr_t>(frame->data[0]));
+	for (int32_t plane = 0; (plane < planes) && frame->data[plane]; plane++) {
+		uint32_t rows = height;
+		if (desc && ((plane == 1) || (plane == 2))) {
+			rows = static_cast<uint32_t>(AV_CEIL_RSHIFT(static_cast<int>(height), desc->log2_chroma_h));
+		}
+
+		const uint8_t* ptr   = frame->data[plane];
+		std::size_t    size  = static_cast<std::size_t>(frame->linesize[plane]) * rows;
+		std::size_t    words = size / sizeof(uint64_t);
+		for (std::size_t idx = 0; idx < words; idx++) {
+			uint64_t word;
+			memcpy(&word, ptr + idx * sizeof(uint64_t), sizeof(uint64_t));
+			hash = (hash ^ word) * 1099511628211ull;
+		}
+		for (std::size_t idx = words * sizeof(uint64_t); idx < size; idx++) {
+			hash = (hash ^ ptr[idx]) * 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+ffmpeg_group::ffmpeg_group(std::string name, uint32_t width, uint32_t height, AVPixelFormat format,
+						   AVColorSpace colorspace, bool full_range)
+	: _name(name), _width(width), _height(height), _format(format), _colorspace(colorspace), _full_range(full_range),
+	  _lock(), _rungs(), _rungs_dirty(false), _source(0)
+{}
+
+ffmpeg_group::~ffmpeg_group()
+{
+	_rungs.clear();
+}
+
+bool ffmpeg_group::is_compatible(uint32_t width, uint32_t height, AVPixelFormat format, AVColorSpace colorspace,
+								 bool full_range)
+{
+	return (_width == width) && (_height == height) && (_format == format) && (_colorspace == colorspace)
+		   && (_full_range == full_range);
+}
+
+std::shared_ptr<ffmpeg_group::rung> ffmpeg_group::join(uint32_t width, uint32_t height, AVPixelFormat format)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+
+	for (auto& rung : _rungs) {
+		if ((rung->width == width) && (rung->height == height) && (rung->format == format)) {
+			rung->members++;
+			return rung;
+		}
+	}
+
+	auto rung     = std::make_shared<ffmpeg_group::rung>();
+	rung->width   = width;
+	rung->height  = height;
+	rung->format  = format;
+	rung->members = 1;
+	_rungs.push_back(rung);
+	_rungs_dirty = true;
+
+	DLOG_INFO("<%s> Group '%s' now converts to %" PRIu32 "x%" PRIu32 " %s.", __FUNCTION_NAME__, _name.c_str(),
+			  width, height, ::streamfx::ffmpeg::tools::get_pixel_format_name(format));
+	return rung;
+}
+
+void ffmpeg_group::leave(std::shared_ptr<rung> rung)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+
+	if (--rung->members > 0) {
+		return;
+	}
+
+	for (auto itr = _rungs.begin(); itr != _rungs.end(); itr++) {
+		if (*itr == rung) {
+			_rungs.erase(itr);
+			_rungs_dirty = true;
+			break;
+		}
+	}
+}
+
+void ffmpeg_group::rebuild()
+{
+	// Largest rung first, so that every other rung can be scaled from the one just above it.
+	std::stable_sort(_rungs.begin(), _rungs.end(), [](const std::shared_ptr<rung>& a, const std::shared_ptr<rung>& b) {
+		return (static_cast<uint64_t>(a->width) * a->height) > (static_cast<uint64_t>(b->width) * b->height);
+	});
+
+	uint32_t      width  = _width;
+	uint32_t      height = _height;
+	AVPixelFormat format = _format;
+	for (auto& rung : _rungs) {
+		rung->scaler.finalize();
+		rung->scaler.set_source_size(width, height);
+		rung->scaler.set_source_color(_full_range, _colorspace);
+		rung->scaler.set_source_format(format);
+		rung->scaler.set_target_size(rung->width, rung->height);
+		rung->scaler.set_target_color(_full_range, _colorspace);
+		rung->scaler.set_target_format(rung->format);
+		if (!rung->scaler.initialize(((width == rung->width) && (height == rung->height)) ? SWS_POINT : SWS_BICUBIC)) {
+			throw std::runtime_error("Failed to initialize scaler for group.");
+		}
+
+		width  = rung->width;
+		height = rung->height;
+		format = rung->format;
+	}
+
+	_rungs_dirty = false;
+}
+
+bool ffmpeg_group::convert(std::shared_ptr<rung> rung, struct encoder_frame* frame, AVFrame* output)
+{
+	// Neither the buffer nor the timestamps tell frames apart, OBS reuses buffers and every member counts on its own.
+	uint64_t identity = get_frame_identity(frame, _format, _height);
+
+	std::unique_lock<std::mutex> lock(_lock);
+	if ((identity != _source) || _rungs_dirty || !rung->current) {
+		if (_rungs_dirty) {
+			rebuild();
+		}
+
+		const uint8_t* const* data   = frame->data;
+		const int*            stride = reinterpret_cast<const int*>(frame->linesize);
+		int32_t               height = static_cast<int32_t>(_height);
+		for (auto& step : _rungs) {
+			// Reuse a frame that no encoder holds on to anymore, or allocate a new one.
+			std::shared_ptr<AVFrame> target;
+			for (auto& candidate : step->frames) {
+				if (av_frame_is_writable(candidate.get())) {
+					target = candidate;
+					break;
+				}
+			}
+			if (!target) {
+				target = std::shared_ptr<AVFrame>(av_frame_alloc(), [](AVFrame* frame) { av_frame_free(&frame); });
+				target->width  = static_cast<int>(step->width);
+				target->height = static_cast<int>(step->height);
+				target->format = step->format;
+				if (int res = av_frame_get_buffer(target.get(), 32); res < 0) {
+					DLOG_ERROR("<%s> Failed to allocate frame: %s (%" PRId32 ").", __FUNCTION_NAME__,
+							   ::streamfx::ffmpeg::tools::get_error_description(res), res);
+					return false;
+				}
+				step->frames.push_back(target);
+			}
+
+			if (int res = step->scaler.convert(data, stride, 0, height, target->data, target->linesize); res <= 0) {
+				DLOG_ERROR("<%s> Failed to convert frame: %s (%" PRId32 ").", __FUNCTION_NAME__,
+						   ::streamfx::ffmpeg::tools::get_error_description(res), res);
+				return false;
+			}
+			step->current = target;
+
+			data   = target->data;
+			stride = target->linesize;
+			height = target->height;
+		}
+
+		_source = identity;
+	}
+
+	if (!rung->current) {
+		return false;
+	}
+	return av_frame_ref(output, rung->current.get()) >= 0;
+}
+
 ffmpeg_instance::ffmpeg_instance(obs_data_t* settings, obs_encoder_t* self, bool is_hw)
 	: encoder_instance(settings, self, is_hw),
 
@@ -92,35 +375,95 @@ ffmpeg_instance::ffmpeg_instance(obs_data_t* settings, obs_encoder_t* self, bool
 
 	  _codec(_factory->get_avcodec()), _context(nullptr), _handler(ffmpeg_manager::get()->get_handler(_codec->name)),
 
-	  _scaler(), _packet(),
+	  _scaler(), _gpu_conversion(), _packets(), _packet(),
+
+	  _hwapi(), _hwinst(), _hwadapter(), _upload_frame(),
 
-	  _hwapi(), _hwinst(),
+	  _session_key(), _session(), _session_keep(0), _session_limit(0), _zerocopy(false), _shared_frames(),
 
 	  _lag_in_frames(0), _sent_frames(0), _have_first_frame(false), _extra_data(), _sei_data(),
 
-	  _free_frames(), _used_frames(), _free_frames_last_used()
+	  _free_frames(), _free_frames_capacity(0), _used_frames(),
+
+	  _async(false), _async_worker(), _async_stop(false), _async_frames(), _async_frames_lock(), _async_frames_cv(),
+	  _async_packets(), _async_packets_lock(), _async_backpressure(0),
+
+	  _group(), _group_rung(),
+
+	  _reconfigure(), _reconfigure_lock(), _reconfigure_pending(false),
+
+	  _roi_source(), _roi_offset(), _roi_tracking(),
+
+	  _timecode(false), _timecode_captured(), _timecode_lock(), _timecode_base(0), _timecode_offset(0),
+
+	  _profile_convert(streamfx::util::profiler::create()), _profile_send(streamfx::util::profiler::create()),
+	  _profile_receive(streamfx::util::profiler::create()), _stat_eagain(0), _stat_queue_total(0),
+	  _stat_queue_samples(0), _stat_queue_max(0), _profile_latency(streamfx::util::profiler::create()),
+	  _stat_submitted(), _stat_first_frame(), _stat_last_frame(), _stat_cpu(os_cpu_usage_info_start()),
+	  _stat_ring_exhausted(0), _stat_warmup_begin(), _stat_warmup_cpu(), _stat_warmup_frames(0),
+	  _stat_processed(false), _stat_frame_source(0), _stat_frame_target(0), _stat_bytes_moved(0),
+	  _stat_bytes_frames(0), _stat_packets_file(), _stat_packets(), _stat_packets_total(0), _stat_packets_lock()
 {
+	// Allocate the whole ring now, so that recording a packet never has to.
+	_stat_packets_file = obs_data_get_string(settings, ST_KEY_STATISTICS_FILE);
+	if (!_stat_packets_file.empty()) {
+		_stat_packets.resize(ST_STATISTICS_PACKETS);
+	}
+
 	// Initialize GPU Stuff
 	if (is_hw) {
 		// Abort if user specified manual override.
+		// Textures are only ever handed out as NV12, or as P010 for high bit depth output.
+		video_format format         = video_output_get_info(obs_encoder_video(_self))->format;
+		bool         texture_format = (format == VIDEO_FORMAT_NV12);
+#if LIBOBS_API_MAJOR_VER >= 28
+		texture_format = texture_format || (format == VIDEO_FORMAT_P010);
+#endif
 		if ((static_cast<AVPixelFormat>(obs_data_get_int(settings, ST_KEY_FFMPEG_COLORFORMAT)) != AV_PIX_FMT_NONE)
-			|| (obs_data_get_int(settings, ST_KEY_FFMPEG_GPU) != -1) || (obs_encoder_scaling_enabled(_self))
-			|| (video_output_get_info(obs_encoder_video(_self))->format != VIDEO_FORMAT_NV12)) {
+			|| (obs_data_get_int(settings, ST_KEY_FFMPEG_GPU) != -1)
+			|| (strlen(obs_data_get_string(settings, ST_KEY_FFMPEG_GROUP)) != 0) || !texture_format) {
 			throw std::runtime_error(
 				"Selected settings prevent the use of hardware encoding, falling back to software.");
 		}
 
+		auto    gctx    = streamfx::obs::gs::context();
+		int64_t adapter = obs_data_get_int(settings, ST_KEY_FFMPEG_ADAPTER);
+		if (!reuse_session(settings)) {
+#ifdef ENABLE_NVIDIA_CUDA
+			// Prefer CUDA where the encoder accepts it, as it maps OBS textures directly into the encoder's frames.
+			// It can only share textures with the adapter OBS renders on, and can't scale them, so those go through
+			// D3D11.
+			if ((adapter == ST_ADAPTER_OBS) && !obs_encoder_scaling_enabled(_self)
+				&& ::streamfx::ffmpeg::tools::can_hardware_encode(_codec, AV_PIX_FMT_CUDA)) {
+				try {
+					_hwapi = std::make_shared<::streamfx::ffmpeg::hwapi::cuda>();
+				} catch (const std::exception& ex) {
+					DLOG_WARNING("Failed to initialize CUDA acceleration, trying alternatives: %s", ex.what());
+				}
+			}
+#endif
 #ifdef WIN32
-		auto gctx = streamfx::obs::gs::context();
-		if (gs_get_device_type() == GS_DEVICE_DIRECT3D_11) {
-			_hwapi = std::make_shared<::streamfx::ffmpeg::hwapi::d3d11>();
-		}
+			if (!_hwapi && (gs_get_device_type() == GS_DEVICE_DIRECT3D_11)
+				&& ::streamfx::ffmpeg::tools::can_hardware_encode(_codec, AV_PIX_FMT_D3D11)) {
+				_hwapi = std::make_shared<::streamfx::ffmpeg::hwapi::d3d11>();
+			}
 #endif
-		if (!_hwapi) {
-			throw std::runtime_error("Failed to create acceleration context.");
+			if (!_hwapi) {
+				throw std::runtime_error("Failed to create acceleration context.");
+			}
+
+			// Frames can't be shared with other adapters, so those read them back from OBS's adapter instead.
+			create_hwinst(adapter);
 		}
+		_hwinst->set_ring_size(static_cast<size_t>(obs_data_get_int(settings, ST_KEY_FFMPEG_TEXTURERING)));
 
-		_hwinst = _hwapi->create_from_obs();
+		// OBS hands texture encoders the unscaled output, so any rescaling has to happen on our side.
+		if (obs_encoder_scaling_enabled(_self) && !_hwinst->can_scale()) {
+			throw std::runtime_error("Device is unable to scale textures, falling back to software.");
+		}
+
+		// Scaled textures have to be copied anyway.
+		_zerocopy = obs_data_get_bool(settings, ST_KEY_FFMPEG_ZEROCOPY) && !obs_encoder_scaling_enabled(_self);
 	}
 
 	// Initialize context.
@@ -130,9 +473,8 @@ ffmpeg_instance::ffmpeg_instance(obs_data_t* settings, obs_encoder_t* self, bool
 		throw std::runtime_error("Failed to create encoder context.");
 	}
 
-	// Create 8MB of precached Packet data for use later on.
-	av_init_packet(&_packet);
-	av_new_packet(&_packet, 8 * 1024 * 1024); // 8 MB precached Packet size.
+	// Packets are only empty shells, the encoder attaches its own refcounted buffers to them.
+	_packets.precache(ST_PACKET_POOL_PRECACHE);
 
 	// Initialize
 	if (is_hw) {
@@ -141,42 +483,149 @@ ffmpeg_instance::ffmpeg_instance(obs_data_t* settings, obs_encoder_t* self, bool
 		initialize_sw(settings);
 	}
 
+	// Submission mode can't be changed while encoding.
+	_async = obs_data_get_bool(settings, ST_KEY_FFMPEG_ASYNC);
+
+	// Only H.264 and HEVC have a place for the timecode in the bitstream.
+	_timecode = obs_data_get_bool(settings, ST_KEY_FFMPEG_TIMECODE)
+				&& ((_codec->id == AV_CODEC_ID_H264) || (_codec->id == AV_CODEC_ID_HEVC));
+
 	// Update settings
 	update(settings);
 
+	// Allocate all frames up front, now that we know how many the encoder will hold on to.
+	if (_codec->type == AVMEDIA_TYPE_VIDEO) {
+		initialize_frame_pool();
+	}
+
+	// Ask for headers while opening, so that outputs don't have to wait for the first packet to start.
+	if (_codec->type == AVMEDIA_TYPE_VIDEO) {
+		_context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+	}
+
 	// Initialize Encoder
-	auto gctx = streamfx::obs::gs::context();
-	int  res  = avcodec_open2(_context, _codec, NULL);
-	if (res < 0) {
-		throw std::runtime_error(::streamfx::ffmpeg::tools::get_error_description(res));
+	{
+		auto gctx   = streamfx::obs::gs::context();
+		auto policy = static_cast<streamfx::util::platform::thread_policy>(
+			obs_data_get_int(settings, ST_KEY_FFMPEG_THREADPOLICY));
+		if (_hwinst || !_handler || !_handler->has_threading_support(_factory)) {
+			policy = streamfx::util::platform::thread_policy::DEFAULT;
+		}
+
+		// FFmpeg starts its worker threads while opening, so this is where they pick up the policy.
+		int res = 0;
+		streamfx::util::platform::with_thread_policy(policy,
+													 [this, &res]() { res = avcodec_open2(_context, _codec, NULL); });
+		if (res < 0) {
+			throw std::runtime_error(::streamfx::ffmpeg::tools::get_error_description(res));
+		}
+	}
+
+	// Encoders that ignore the flag still have their headers extracted from the first packet.
+	if ((_context->extradata != nullptr) && (_context->extradata_size > 0)) {
+		extract_extra_data(_context->extradata, static_cast<size_t>(_context->extradata_size));
+		_have_first_frame = !_extra_data.empty();
+	}
+
+	// OBS wants its texture back before we return from encoding, so only encoders that return every packet right
+	// away, and do so on the calling thread, can work on it directly.
+	if (_zerocopy) {
+		if (_async || (_context->delay > 0) || (_context->max_b_frames > 0)) {
+			DLOG_WARNING("[%s] Encoder holds on to frames, so OBS textures are copied instead of used directly.",
+						 _codec->name);
+			_zerocopy = false;
+		} else {
+			DLOG_INFO("[%s] Encoding directly from OBS textures.", _codec->name);
+		}
+	}
+
+	// Start the submission worker last, as it immediately begins to use the context.
+	if (_async) {
+		async_start();
 	}
 }
 
 ffmpeg_instance::~ffmpeg_instance()
 {
+	async_stop();
+
+	log_statistics();
+	save_packet_statistics();
+	os_cpu_usage_info_destroy(_stat_cpu);
+	if (_stat_warmup_cpu) {
+		os_cpu_usage_info_destroy(_stat_warmup_cpu);
+	}
+
 	auto gctx = streamfx::obs::gs::context();
 	if (_context) {
 		// Flush encoders that require it.
 		if ((_codec->capabilities & AV_CODEC_CAP_DELAY) != 0) {
+			auto pkt = _packets.pop();
 			avcodec_send_frame(_context, nullptr);
-			while (avcodec_receive_packet(_context, &_packet) >= 0) {
+			while (avcodec_receive_packet(_context, pkt.get()) >= 0) {
 				avcodec_send_frame(_context, nullptr);
 				std::this_thread::sleep_for(std::chrono::milliseconds(1));
 			}
 		}
 
+		// Hand the hardware over to the next encoder with the same configuration, instead of tearing it down.
+		if (_hwinst && !_shared_frames && (_session_keep > 0) && _context->hw_device_ctx && _context->hw_frames_ctx) {
+			auto unref = [](AVBufferRef* v) { av_buffer_unref(&v); };
+
+			auto session      = std::make_shared<ffmpeg_session>();
+			session->key      = _session_key;
+			session->api      = _hwapi;
+			session->instance = _hwinst;
+			session->adapter  = _hwadapter;
+			session->device   = std::shared_ptr<AVBufferRef>(av_buffer_ref(_context->hw_device_ctx), unref);
+			session->frames   = std::shared_ptr<AVBufferRef>(av_buffer_ref(_context->hw_frames_ctx), unref);
+			session->expires  = std::chrono::steady_clock::now() + std::chrono::seconds(_session_keep);
+			ffmpeg_manager::get()->store_session(session);
+		}
+
 		// Close and free context.
 		avcodec_close(_context);
 		avcodec_free_context(&_context);
 	}
 
-	av_packet_unref(&_packet);
+	_packet.reset();
+
+	if (_group) {
+		_group->leave(_group_rung);
+	}
+
+	if (_shared_frames) {
+		_shared_frames->leave(this);
+		_shared_frames.reset();
+	}
+
+	if (_hwinst) {
+		_hwinst.reset();
+		ffmpeg_manager::get()->release_adapter(_hwadapter);
+	}
 
 	_scaler.finalize();
 }
 
 void ffmpeg_instance::get_properties(obs_properties_t* props)
 {
+	obs_properties_add_button2(
+		props, ST_KEY_STATISTICS, D_TRANSLATE(ST_I18N_STATISTICS),
+		[](obs_properties_t*, obs_property_t*, void* data) {
+			reinterpret_cast<ffmpeg_instance*>(data)->log_statistics();
+			return false;
+		},
+		this);
+	if (!_stat_packets.empty()) {
+		obs_properties_add_button2(
+			props, ST_KEY_STATISTICS_SAVE, D_TRANSLATE(ST_I18N_STATISTICS_SAVE),
+			[](obs_properties_t*, obs_property_t*, void* data) {
+				reinterpret_cast<ffmpeg_instance*>(data)->save_packet_statistics();
+				return false;
+			},
+			this);
+	}
+
 	if (_handler)
 		_handler->get_properties(props, _codec, _context, _handler->is_hardware_encoder(_factory));
 
@@ -186,8 +635,26 @@ void ffmpeg_instance::get_properties(obs_properties_t* props)
 
 	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_COLORFORMAT), false);
 	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_THREADS), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_THREADPOLICY), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_CONVERSIONTHREADS), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_GPUCONVERSION), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_TEXTURERING), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_SESSIONCACHE), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_SESSIONLIMIT), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_ZEROCOPY), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_SHAREDFRAMES), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_SCALER), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_ADAPTER), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_GROUP), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_GROUP_WIDTH), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_GROUP_HEIGHT), false);
 	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_STANDARDCOMPLIANCE), false);
 	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_GPU), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_ASYNC), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_ROI), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_ROI_STRENGTH), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_FFMPEG_TIMECODE), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_STATISTICS_FILE), false);
 }
 
 void ffmpeg_instance::migrate(obs_data_t* settings, uint64_t version)
@@ -198,6 +665,27 @@ void ffmpeg_instance::migrate(obs_data_t* settings, uint64_t version)
 
 bool ffmpeg_instance::update(obs_data_t* settings)
 {
+	// Once open, the context belongs to the thread submitting frames, which applies what it can live.
+	if (avcodec_is_open(_context)) {
+		obs_data_addref(settings);
+		std::lock_guard<std::mutex> lock(_reconfigure_lock);
+		_reconfigure = std::shared_ptr<obs_data_t>(settings, [](obs_data_t* v) { obs_data_release(v); });
+		_reconfigure_pending.store(true);
+		return true;
+	}
+
+	// Regions of Interest
+	_roi_source.reset();
+	if (const char* name = obs_data_get_string(settings, ST_KEY_FFMPEG_ROI);
+		(_codec->type == AVMEDIA_TYPE_VIDEO) && (strlen(name) > 0)) {
+		if (obs_source_t* source = obs_get_source_by_name(name); source) {
+			_roi_source = std::shared_ptr<obs_weak_source_t>(obs_source_get_weak_source(source),
+															 [](obs_weak_source_t* v) { obs_weak_source_release(v); });
+			obs_source_release(source);
+		}
+	}
+	_roi_offset = {-static_cast<int>(obs_data_get_int(settings, ST_KEY_FFMPEG_ROI_STRENGTH)), 100};
+
 	// FFmpeg Options
 	_context->debug                 = 0;
 	_context->strict_std_compliance = static_cast<int>(obs_data_get_int(settings, ST_KEY_FFMPEG_STANDARDCOMPLIANCE));
@@ -212,7 +700,7 @@ bool ffmpeg_instance::update(obs_data_t* settings)
 			_context->thread_type |= FF_THREAD_SLICE;
 		}
 		if (_context->thread_type != 0) {
-			int64_t threads = obs_data_get_int(settings, ST_I18N_FFMPEG_THREADS);
+			int64_t threads = obs_data_get_int(settings, ST_KEY_FFMPEG_THREADS);
 			if (threads > 0) {
 				_context->thread_count = static_cast<int>(threads);
 			} else {
@@ -277,13 +765,20 @@ bool ffmpeg_instance::update(obs_data_t* settings)
 				  ::streamfx::ffmpeg::tools::get_std_compliance_name(_context->strict_std_compliance));
 		DLOG_INFO("[%s]     Threading: %s (with %i threads)", _codec->name,
 				  ::streamfx::ffmpeg::tools::get_thread_type_name(_context->thread_type), _context->thread_count);
+		DLOG_INFO("[%s]     Submission: %s", _codec->name, _async ? "Asynchronous" : "Synchronous");
+		DLOG_INFO("[%s]     Timecode: %s", _codec->name, _timecode ? "Enabled" : "Disabled");
 
 		DLOG_INFO("[%s]   Video:", _codec->name);
-		if (_hwinst) {
+		if (is_hardware_encode()) {
 			DLOG_INFO("[%s]     Texture: %" PRId32 "x%" PRId32 " %s %s %s", _codec->name, _context->width,
 					  _context->height, ::streamfx::ffmpeg::tools::get_pixel_format_name(_context->sw_pix_fmt),
 					  ::streamfx::ffmpeg::tools::get_color_space_name(_context->colorspace),
 					  av_color_range_name(_context->color_range));
+			if (obs_encoder_scaling_enabled(_self)) {
+				auto voi = video_output_get_info(obs_encoder_video(_self));
+				DLOG_INFO("[%s]     Scaled: From %" PRIu32 "x%" PRIu32 " on GPU", _codec->name, voi->width,
+						  voi->height);
+			}
 		} else {
 			DLOG_INFO("[%s]     Input: %" PRId32 "x%" PRId32 " %s %s %s", _codec->name, _scaler.get_source_width(),
 					  _scaler.get_source_height(),
@@ -295,6 +790,17 @@ bool ffmpeg_instance::update(obs_data_t* settings)
 					  ::streamfx::ffmpeg::tools::get_pixel_format_name(_scaler.get_target_format()),
 					  ::streamfx::ffmpeg::tools::get_color_space_name(_scaler.get_target_colorspace()),
 					  _scaler.is_target_full_range() ? "Full" : "Partial");
+			if (_group) {
+				DLOG_INFO("[%s]     Conversion: Shared", _codec->name);
+			} else if (_gpu_conversion) {
+				DLOG_INFO("[%s]     Conversion: GPU (%zu frames latency)", _codec->name,
+						  _gpu_conversion->get_latency());
+			} else {
+				DLOG_INFO("[%s]     Conversion: %" PRIu32 " thread(s)", _codec->name, _scaler.get_active_threads());
+			}
+			if (_upload_frame)
+				DLOG_INFO("[%s]     Upload: %s", _codec->name,
+						  ::streamfx::ffmpeg::tools::get_pixel_format_name(_context->pix_fmt));
 			if (!_hwinst)
 				DLOG_INFO("[%s]     On GPU Index: %lli", _codec->name, obs_data_get_int(settings, ST_KEY_FFMPEG_GPU));
 		}
@@ -325,23 +831,11 @@ static inline void copy_data(encoder_frame* frame, AVFrame* vframe)
 			continue;
 
 		std::size_t plane_height = static_cast<size_t>(vframe->height) >> (idx ? v_chroma_shift : 0);
+		std::size_t ls_in        = static_cast<size_t>(frame->linesize[idx]);
+		std::size_t ls_out       = static_cast<size_t>(vframe->linesize[idx]);
 
-		if (static_cast<uint32_t>(vframe->linesize[idx]) == frame->linesize[idx]) {
-			std::memcpy(vframe->data[idx], frame->data[idx], frame->linesize[idx] * plane_height);
-		} else {
-			std::size_t ls_in  = static_cast<size_t>(frame->linesize[idx]);
-			std::size_t ls_out = static_cast<size_t>(vframe->linesize[idx]);
-			std::size_t bytes  = ls_in < ls_out ? ls_in : ls_out;
-
-			uint8_t* to   = vframe->data[idx];
-			uint8_t* from = frame->data[idx];
-
-			for (std::size_t y = 0; y < plane_height; y++) {
-				std::memcpy(to, from, bytes);
-				to += ls_out;
-				from += ls_in;
-			}
-		}
+		::streamfx::util::copy_plane(vframe->data[idx], ls_out, frame->data[idx], ls_in, std::min(ls_in, ls_out),
+									 plane_height);
 	}
 }
 
@@ -352,9 +846,15 @@ bool ffmpeg_instance::encode_audio(struct encoder_frame* frame, struct encoder_p
 
 bool ffmpeg_instance::encode_video(struct encoder_frame* frame, struct encoder_packet* packet, bool* received_packet)
 {
+	if (_timecode) {
+		capture_timecode(frame->pts);
+	}
+
 	std::shared_ptr<AVFrame> vframe = pop_free_frame(); // Retrieve an empty frame.
 
-	// Convert frame.
+	// Convert frame, either directly into the encoder's frame or into the staging frame for the upload.
+	auto     convert_begin = std::chrono::high_resolution_clock::now();
+	AVFrame* target        = _upload_frame ? _upload_frame.get() : vframe.get();
 	{
 		vframe->height          = _context->height;
 		vframe->format          = _context->pix_fmt;
@@ -364,20 +864,54 @@ bool ffmpeg_instance::encode_video(struct encoder_frame* frame, struct encoder_p
 		vframe->color_trc       = _context->color_trc;
 		vframe->pts             = frame->pts;
 
-		if ((_scaler.is_source_full_range() == _scaler.is_target_full_range())
+		if (_group) {
+			// Drop our own buffers, the group hands out a reference to its shared conversion instead.
+			av_frame_unref(vframe.get());
+			if (!_group->convert(_group_rung, frame, vframe.get())) {
+				DLOG_ERROR("[%s] Failed to convert frame in group.", _codec->name);
+				return false;
+			}
+			vframe->color_range     = _context->color_range;
+			vframe->colorspace      = _context->colorspace;
+			vframe->color_primaries = _context->color_primaries;
+			vframe->color_trc       = _context->color_trc;
+			vframe->pts             = frame->pts;
+		} else if (_gpu_conversion) {
+			// The converted frame leaves the GPU a few frames later, together with its original timestamp.
+			_gpu_conversion->push(frame->data, frame->linesize, frame->pts);
+			if (!_gpu_conversion->pop(vframe)) {
+				push_free_frame(vframe);
+				*received_packet = false;
+				return true;
+			}
+		} else if ((_scaler.is_source_full_range() == _scaler.is_target_full_range())
 			&& (_scaler.get_source_colorspace() == _scaler.get_target_colorspace())
 			&& (_scaler.get_source_format() == _scaler.get_target_format())) {
-			copy_data(frame, vframe.get());
+			// Matching formats, including P010 and I010 from OBS, only need a plane copy.
+			copy_data(frame, target);
+			_stat_bytes_moved += _stat_frame_source + _stat_frame_target;
+			_stat_bytes_frames++;
 		} else {
 			int res = _scaler.convert(reinterpret_cast<uint8_t**>(frame->data), reinterpret_cast<int*>(frame->linesize),
-									  0, _context->height, vframe->data, vframe->linesize);
+									  0, _context->height, target->data, target->linesize);
 			if (res <= 0) {
 				DLOG_ERROR("Failed to convert frame: %s (%" PRId32 ").",
 						   ::streamfx::ffmpeg::tools::get_error_description(res), res);
 				return false;
 			}
+			_stat_bytes_moved += _stat_frame_source + _stat_frame_target;
+			_stat_bytes_frames++;
+		}
+	}
+	if (_upload_frame) {
+		if (int res = _hwinst->upload_frame(vframe, _upload_frame); res < 0) {
+			DLOG_ERROR("Failed to upload frame: %s (%" PRId32 ").",
+					   ::streamfx::ffmpeg::tools::get_error_description(res), res);
+			return false;
 		}
+		_stat_bytes_moved += _stat_frame_target;
 	}
+	track_duration(_profile_convert, convert_begin);
 
 	if (!encode_avframe(vframe, packet, received_packet))
 		return false;
@@ -388,15 +922,59 @@ bool ffmpeg_instance::encode_video(struct encoder_frame* frame, struct encoder_p
 bool ffmpeg_instance::encode_video(uint32_t handle, int64_t pts, uint64_t lock_key, uint64_t* next_key,
 								   struct encoder_packet* packet, bool* received_packet)
 {
-#ifdef D_PLATFORM_WINDOWS
 	if (handle == GS_INVALID_HANDLE) {
 		DLOG_ERROR("Received invalid handle.");
 		*next_key = lock_key;
 		return false;
 	}
 
-	std::shared_ptr<AVFrame> vframe = pop_free_frame();
-	_hwinst->copy_from_obs(_context->hw_frames_ctx, handle, lock_key, next_key, vframe);
+	if (_timecode) {
+		capture_timecode(pts);
+	}
+
+	std::shared_ptr<AVFrame> vframe;
+	bool                     wrapped       = false;
+	bool                     shared        = false;
+	bool                     ringed        = false;
+	auto                     convert_begin = std::chrono::high_resolution_clock::now();
+	if (_zerocopy) {
+		vframe  = _hwinst->avframe_from_obs(_context->hw_frames_ctx, handle, lock_key, next_key);
+		wrapped = (vframe != nullptr);
+		if (!wrapped) {
+			DLOG_WARNING("[%s] OBS textures don't match the encoder's frames, copying them instead.", _codec->name);
+			_zerocopy = false;
+		}
+	}
+	if (!vframe && _shared_frames) {
+		vframe = _shared_frames->acquire(this, handle, lock_key, next_key);
+		shared = (vframe != nullptr);
+	} else if (!vframe) {
+		// An empty frame is made to reference the texture ring, which then needs no further copy.
+		ringed = (_hwinst->get_ring_size() > 0);
+		if (ringed) {
+			vframe = std::shared_ptr<AVFrame>(av_frame_alloc(), [](AVFrame* frame) {
+				av_frame_unref(frame);
+				av_frame_free(&frame);
+			});
+		} else {
+			vframe = pop_free_frame();
+		}
+		if (!_hwinst->copy_from_obs(_context->hw_frames_ctx, handle, lock_key, next_key, vframe)) {
+			push_free_frame(vframe);
+			vframe.reset();
+		}
+	}
+	if (!vframe) {
+		// Skip the frame rather than stall OBS until an intermediate texture frees up.
+		if (_stat_ring_exhausted++ == 0) {
+			DLOG_WARNING("[%s] Texture ring is exhausted, skipping frames. Consider increasing its size.",
+						 _codec->name);
+		}
+		*next_key        = lock_key;
+		*received_packet = false;
+		return true;
+	}
+	track_duration(_profile_convert, convert_begin);
 
 	vframe->color_range     = _context->color_range;
 	vframe->colorspace      = _context->colorspace;
@@ -404,15 +982,29 @@ bool ffmpeg_instance::encode_video(uint32_t handle, int64_t pts, uint64_t lock_k
 	vframe->color_trc       = _context->color_trc;
 	vframe->pts             = pts;
 
-	if (!encode_avframe(vframe, packet, received_packet))
+	bool encoded = encode_avframe(vframe, packet, received_packet);
+
+	// The frame is submitted, so OBS gets its texture back right away, like it does after a copy. An encoder that
+	// still holds on to the frame could read it while OBS renders the next one, so those copy from now on.
+	if (wrapped) {
+		_hwinst->unlock_from_obs(vframe);
+		if (av_buffer_get_ref_count(vframe->buf[0]) > 1) {
+			DLOG_WARNING("[%s] Encoder held on to an OBS texture, copying them from now on.", _codec->name);
+			_zerocopy = false;
+		}
+		av_frame_unref(vframe.get());
+	}
+
+	// Shared and ring frames return to where they came from, not to our free frames.
+	if (shared || ringed) {
+		av_frame_unref(vframe.get());
+	}
+	if (!encoded)
 		return false;
 
 	*next_key = lock_key;
 
 	return true;
-#else
-	return false;
-#endif
 }
 
 void ffmpeg_instance::initialize_sw(obs_data_t* settings)
@@ -425,7 +1017,69 @@ void ffmpeg_instance::initialize_sw(obs_data_t* settings)
 		AVPixelFormat _pixfmt_source = ::streamfx::ffmpeg::tools::obs_videoformat_to_avpixelformat(voi->format);
 		AVPixelFormat _pixfmt_target =
 			static_cast<AVPixelFormat>(obs_data_get_int(settings, ST_KEY_FFMPEG_COLORFORMAT));
-		if (_pixfmt_target == AV_PIX_FMT_NONE) {
+
+		// Every format handed to the encoder has to be one it lists, encoders without a list take anything.
+		auto is_supported = [this](AVPixelFormat format) {
+			if (!_codec->pix_fmts) {
+				return true;
+			}
+			for (auto ptr = _codec->pix_fmts; *ptr != AV_PIX_FMT_NONE; ptr++) {
+				if (*ptr == format) {
+					return true;
+				}
+			}
+			return false;
+		};
+#ifdef ENABLE_ENCODER_FFMPEG_VAAPI
+		// VA-API encoders only accept hardware surfaces, so frames are converted as usual and then uploaded.
+		if (::streamfx::ffmpeg::tools::can_hardware_encode(_codec, AV_PIX_FMT_VAAPI)) {
+			if (!reuse_session(settings)) {
+				_hwapi = std::make_shared<::streamfx::ffmpeg::hwapi::vaapi>();
+				create_hwinst(obs_data_get_int(settings, ST_KEY_FFMPEG_ADAPTER));
+			}
+		}
+#endif
+		if (_hwinst && !is_supported(_hwinst->get_pixel_format())) {
+			DLOG_WARNING("[%s] Encoder doesn't accept '%s' surfaces, converting in software instead.", _codec->name,
+						 ::streamfx::ffmpeg::tools::get_pixel_format_name(_hwinst->get_pixel_format()));
+			_hwinst.reset();
+			_hwapi.reset();
+		}
+		if (_hwinst) {
+			// Keep 10-bit input at 10-bit, P010 is the surface format hardware encoders accept for it.
+			_pixfmt_target = ::streamfx::ffmpeg::tools::is_high_bit_depth(_pixfmt_source) ? AV_PIX_FMT_P010
+																						   : AV_PIX_FMT_NV12;
+
+			// The codec only lists the hardware format, the device knows which surfaces it can hold.
+			AVBufferRef* device = _hwinst->create_device_context();
+			if (AVHWFramesConstraints* cst = av_hwdevice_get_hwframe_constraints(device, nullptr); cst) {
+				auto holds = [cst](AVPixelFormat format) {
+					if (!cst->valid_sw_formats) {
+						return true;
+					}
+					for (auto ptr = cst->valid_sw_formats; *ptr != AV_PIX_FMT_NONE; ptr++) {
+						if (*ptr == format) {
+							return true;
+						}
+					}
+					return false;
+				};
+				if (!holds(_pixfmt_target)) {
+					AVPixelFormat other = (_pixfmt_target == AV_PIX_FMT_P010) ? AV_PIX_FMT_NV12 : AV_PIX_FMT_P010;
+					if (!holds(other)) {
+						av_hwframe_constraints_free(&cst);
+						av_buffer_unref(&device);
+						throw std::runtime_error("Hardware device supports neither NV12 nor P010 surfaces.");
+					}
+					DLOG_WARNING("[%s] Hardware device doesn't support '%s' surfaces, using '%s' instead.",
+								 _codec->name, ::streamfx::ffmpeg::tools::get_pixel_format_name(_pixfmt_target),
+								 ::streamfx::ffmpeg::tools::get_pixel_format_name(other));
+					_pixfmt_target = other;
+				}
+				av_hwframe_constraints_free(&cst);
+			}
+			av_buffer_unref(&device);
+		} else if (_pixfmt_target == AV_PIX_FMT_NONE) {
 			// Find the best conversion format.
 			if (_codec->pix_fmts) {
 				_pixfmt_target = ::streamfx::ffmpeg::tools::get_least_lossy_format(_codec->pix_fmts, _pixfmt_source);
@@ -433,18 +1087,18 @@ void ffmpeg_instance::initialize_sw(obs_data_t* settings)
 				_pixfmt_target = _pixfmt_source;
 			}
 
-			if (_handler) // Allow Handler to override the automatic color format for sanity reasons.
+			if (_handler) { // Allow Handler to override the automatic color format for sanity reasons.
+				AVPixelFormat automatic = _pixfmt_target;
 				_handler->override_colorformat(_pixfmt_target, settings, _codec, _context);
-		} else {
-			// Use user override, guaranteed to be supported.
-			bool is_format_supported = false;
-			for (auto ptr = _codec->pix_fmts; *ptr != AV_PIX_FMT_NONE; ptr++) {
-				if (*ptr == _pixfmt_target) {
-					is_format_supported = true;
+				if (!is_supported(_pixfmt_target)) {
+					DLOG_WARNING("[%s] Ignoring unsupported color format '%s' chosen by the handler.", _codec->name,
+								 ::streamfx::ffmpeg::tools::get_pixel_format_name(_pixfmt_target));
+					_pixfmt_target = automatic;
 				}
 			}
-
-			if (!is_format_supported) {
+		} else {
+			// Use user override, which still has to be supported.
+			if (!is_supported(_pixfmt_target)) {
 				std::stringstream sstr;
 				sstr << "Color Format '" << ::streamfx::ffmpeg::tools::get_pixel_format_name(_pixfmt_target)
 					 << "' is not supported by the encoder.";
@@ -456,22 +1110,43 @@ void ffmpeg_instance::initialize_sw(obs_data_t* settings)
 		::streamfx::ffmpeg::tools::context_setup_from_obs(voi, _context);
 
 		// Override with other information.
-		_context->width   = static_cast<int>(obs_encoder_get_width(_self));
-		_context->height  = static_cast<int>(obs_encoder_get_height(_self));
+		uint32_t width    = obs_encoder_get_width(_self);
+		uint32_t height   = obs_encoder_get_height(_self);
+		_context->width   = static_cast<int>(width);
+		_context->height  = static_cast<int>(height);
 		_context->pix_fmt = _pixfmt_target;
 
+		// Grouped encoders receive the full input and scale it down themselves, in a chain shared by the group.
+		std::string group = obs_data_get_string(settings, ST_KEY_FFMPEG_GROUP);
+		if (!group.empty()) {
+			if (auto v = obs_data_get_int(settings, ST_KEY_FFMPEG_GROUP_WIDTH); v > 0) {
+				_context->width = static_cast<int>(v);
+			}
+			if (auto v = obs_data_get_int(settings, ST_KEY_FFMPEG_GROUP_HEIGHT); v > 0) {
+				_context->height = static_cast<int>(v);
+			}
+		}
+
 		// Prevent pixelation by sampling "center" instead of corners. This creates
 		// a smoother look, which may not be H.264/AVC standard compliant, however it
 		// provides better support for scaling algorithms, such as Bicubic.
 		_context->chroma_sample_location = AVCHROMA_LOC_CENTER;
 
-		_scaler.set_source_size(static_cast<uint32_t>(_context->width), static_cast<uint32_t>(_context->height));
+		_scaler.set_source_size(width, height);
 		_scaler.set_source_color(_context->color_range == AVCOL_RANGE_JPEG, _context->colorspace);
 		_scaler.set_source_format(_pixfmt_source);
 
 		_scaler.set_target_size(static_cast<uint32_t>(_context->width), static_cast<uint32_t>(_context->height));
 		_scaler.set_target_color(_context->color_range == AVCOL_RANGE_JPEG, _context->colorspace);
 		_scaler.set_target_format(_pixfmt_target);
+		_scaler.set_threads(static_cast<uint32_t>(obs_data_get_int(settings, ST_KEY_FFMPEG_CONVERSIONTHREADS)));
+
+		// Plane sizes, used to report how much memory each frame moves on the CPU.
+		int frame_source =
+			av_image_get_buffer_size(_pixfmt_source, static_cast<int>(width), static_cast<int>(height), 1);
+		int frame_target = av_image_get_buffer_size(_pixfmt_target, _context->width, _context->height, 1);
+		_stat_frame_source = static_cast<size_t>(std::max(frame_source, 0));
+		_stat_frame_target = static_cast<size_t>(std::max(frame_target, 0));
 
 		// Create Scaler
 		if (!_scaler.initialize(SWS_POINT)) {
@@ -484,24 +1159,96 @@ void ffmpeg_instance::initialize_sw(obs_data_t* settings)
 				 << (_scaler.is_source_full_range() ? "full" : "partial") << " range.";
 			throw std::runtime_error(sstr.str());
 		}
+
+		if (_hwinst) {
+			_context->sw_pix_fmt = _pixfmt_target;
+			_context->pix_fmt    = _hwinst->get_pixel_format();
+			initialize_hw_frames();
+
+			_upload_frame = _hwinst->allocate_upload_frame(_context->width, _context->height, _pixfmt_target);
+			return;
+		}
+
+		if (!group.empty()) {
+			_group = ffmpeg_manager::get()->get_group(group, width, height, _pixfmt_source, _context->colorspace,
+													  _context->color_range == AVCOL_RANGE_JPEG);
+			_group_rung = _group->join(static_cast<uint32_t>(_context->width), static_cast<uint32_t>(_context->height),
+									   _pixfmt_target);
+		}
+
+		// Optionally move the conversion to the GPU, keeping the scaler around as a description of the formats.
+		if (!_group && obs_data_get_bool(settings, ST_KEY_FFMPEG_GPUCONVERSION)
+			&& ::streamfx::ffmpeg::gpu_conversion::is_supported(_pixfmt_source, _pixfmt_target)) {
+			try {
+				_gpu_conversion = std::make_shared<::streamfx::ffmpeg::gpu_conversion>(
+					static_cast<uint32_t>(_context->width), static_cast<uint32_t>(_context->height), _pixfmt_source,
+					_pixfmt_target, _context->colorspace, _context->color_range, ST_GPU_CONVERSION_LATENCY);
+			} catch (const std::exception& ex) {
+				DLOG_WARNING("[%s] GPU conversion is unavailable, falling back to CPU: %s", _codec->name, ex.what());
+			}
+		}
 	}
 }
 
-void ffmpeg_instance::initialize_hw(obs_data_t*)
+void ffmpeg_instance::initialize_hw(obs_data_t* settings)
 {
-#ifndef D_PLATFORM_WINDOWS
-	throw std::runtime_error("OBS Studio currently does not support zero copy encoding for this platform.");
-#else
 	// Initialize Video Encoding
 	const video_output_info* voi = video_output_get_info(obs_encoder_video(_self));
 
 	// Apply pixel format settings.
 	::streamfx::ffmpeg::tools::context_setup_from_obs(voi, _context);
 	_context->sw_pix_fmt = _context->pix_fmt;
-	_context->pix_fmt    = AV_PIX_FMT_D3D11;
+	_context->pix_fmt    = _hwinst->get_pixel_format();
+
+	// Frames have the size of the encoder, copy_from_obs() scales the textures to it on the GPU.
+	_context->width  = static_cast<int>(obs_encoder_get_width(_self));
+	_context->height = static_cast<int>(obs_encoder_get_height(_self));
+	auto quality =
+		static_cast<::streamfx::ffmpeg::hwapi::scaler_quality>(obs_data_get_int(settings, ST_KEY_FFMPEG_SCALER));
+	_hwinst->set_scaler(quality, _context->colorspace, _context->color_range);
+
+	// Other encoders on this adapter may already copy the very same frames, which only needs doing once.
+	if (obs_data_get_bool(settings, ST_KEY_FFMPEG_SHAREDFRAMES)) {
+		try {
+			_shared_frames = ::streamfx::ffmpeg::hwapi::shared_frames::get(
+				{_hwadapter, _context->width, _context->height, _context->pix_fmt, _context->sw_pix_fmt, quality,
+				 _context->colorspace, _context->color_range},
+				_hwinst);
+			_shared_frames->join(this);
+		} catch (const std::exception& ex) {
+			DLOG_WARNING("[%s] Unable to share frames with other encoders: %s", _codec->name, ex.what());
+			_shared_frames.reset();
+		}
+	}
+
+	initialize_hw_frames();
+}
+
+void ffmpeg_instance::initialize_hw_frames()
+{
+	// Shared frames all come from one frames context, which then has to be ours as well.
+	if (_shared_frames) {
+		_session.reset();
+		_context->hw_device_ctx = av_buffer_ref(_shared_frames->get_device_context());
+		_context->hw_frames_ctx = av_buffer_ref(_shared_frames->get_frames_context());
+		return;
+	}
+
+	// A previous encoder may have left matching frames behind, which saves allocating all of them again.
+	if (std::shared_ptr<ffmpeg_session> session = std::move(_session); session) {
+		AVHWFramesContext* frames = reinterpret_cast<AVHWFramesContext*>(session->frames->data);
+		if ((frames->width == _context->width) && (frames->height == _context->height)
+			&& (frames->format == _context->pix_fmt) && (frames->sw_format == _context->sw_pix_fmt)) {
+			_context->hw_device_ctx = av_buffer_ref(session->device.get());
+			_context->hw_frames_ctx = av_buffer_ref(session->frames.get());
+			return;
+		}
 
-	// Try to create a hardware context.
-	_context->hw_device_ctx = _hwinst->create_device_context();
+		_context->hw_device_ctx = av_buffer_ref(session->device.get());
+	} else {
+		// Try to create a hardware context.
+		_context->hw_device_ctx = _hwinst->create_device_context();
+	}
 	_context->hw_frames_ctx = av_hwframe_ctx_alloc(_context->hw_device_ctx);
 	if (!_context->hw_frames_ctx) {
 		throw std::runtime_error("Creating hardware context failed.");
@@ -513,6 +1260,7 @@ void ffmpeg_instance::initialize_hw(obs_data_t*)
 	ctx->height            = _context->height;
 	ctx->format            = _context->pix_fmt;
 	ctx->sw_format         = _context->sw_pix_fmt;
+	_hwinst->prepare_frames(ctx);
 	if (int32_t res = av_hwframe_ctx_init(_context->hw_frames_ctx); res < 0) {
 		std::array<char, 2048> buffer;
 		size_t                 len = static_cast<size_t>(snprintf(buffer.data(), buffer.size(),
@@ -520,50 +1268,44 @@ void ffmpeg_instance::initialize_hw(obs_data_t*)
                                                   ::streamfx::ffmpeg::tools::get_error_description(res), res));
 		throw std::runtime_error(std::string(buffer.data(), buffer.data() + len));
 	}
-#endif
+}
+
+void ffmpeg_instance::initialize_frame_pool()
+{
+	_free_frames.set_resolution(_context->width, _context->height);
+	_free_frames.set_pixel_format(_context->pix_fmt);
+	if (_hwinst) {
+		_free_frames.set_allocator([this]() { return _hwinst->allocate_frame(_context->hw_frames_ctx); });
+	}
+
+	// Everything the encoder may hold on to, the frame currently being filled, and the submission queue.
+	std::size_t lag = std::max<std::size_t>(_lag_in_frames, static_cast<size_t>(std::max<int>(_context->delay, 0)));
+	_free_frames_capacity = lag + ST_FRAME_POOL_MARGIN;
+	if (_async) {
+		_free_frames_capacity += get_async_capacity(_context);
+	}
+
+	_free_frames.clear();
+	_free_frames.precache(_free_frames_capacity);
 }
 
 void ffmpeg_instance::push_free_frame(std::shared_ptr<AVFrame> frame)
 {
-	auto now = std::chrono::high_resolution_clock::now();
-	if (_free_frames.size() > 0) {
-		if ((now - _free_frames_last_used) < std::chrono::seconds(1)) {
-			_free_frames.push(frame);
-		}
-	} else {
-		_free_frames.push(frame);
-		_free_frames_last_used = std::chrono::high_resolution_clock::now();
+	// Frames that wrapped an OBS texture or referenced a shared or ring frame were emptied, see encode_video().
+	if (frame && !frame->buf[0]) {
+		return;
 	}
+	_free_frames.push(std::move(frame));
 }
 
 std::shared_ptr<AVFrame> ffmpeg_instance::pop_free_frame()
 {
-	std::shared_ptr<AVFrame> frame;
-	if (_free_frames.size() > 0) {
-		// Re-use existing frames first.
-		frame = _free_frames.top();
-		_free_frames.pop();
-	} else {
-		if (_hwinst) {
-			frame = _hwinst->allocate_frame(_context->hw_frames_ctx);
-		} else {
-			frame = std::shared_ptr<AVFrame>(av_frame_alloc(), [](AVFrame* frame) {
-				av_frame_unref(frame);
-				av_frame_free(&frame);
-			});
-
-			frame->width  = _context->width;
-			frame->height = _context->height;
-			frame->format = _context->pix_fmt;
-
-			int res = av_frame_get_buffer(frame.get(), 32);
-			if (res < 0) {
-				throw std::runtime_error(::streamfx::ffmpeg::tools::get_error_description(res));
-			}
-		}
+	if (_free_frames.empty()) {
+		// Only happens if the lag estimate was wrong, so grow the pool instead of dropping the frame.
+		_free_frames_capacity++;
+		DLOG_WARNING("[%s] Frame pool exhausted, growing it to %zu frames.", _codec->name, _free_frames_capacity);
 	}
-
-	return frame;
+	return _free_frames.pop();
 }
 
 void ffmpeg_instance::push_used_frame(std::shared_ptr<AVFrame> frame)
@@ -578,6 +1320,210 @@ std::shared_ptr<AVFrame> ffmpeg_instance::pop_used_frame()
 	return frame;
 }
 
+void ffmpeg_instance::capture_timecode(int64_t pts)
+{
+	// OBS counts pts in the time base of its video output, which the context uses as well.
+	auto to_ns = [this](int64_t value) {
+		return static_cast<uint64_t>(av_rescale_q(value, _context->time_base, AVRational{1, 1000000000}));
+	};
+
+	std::unique_lock<std::mutex> lock(_timecode_lock);
+	if (_timecode_base == 0) {
+		_timecode_base   = obs_get_video_frame_time() - to_ns(pts);
+		_timecode_offset = static_cast<int64_t>(::streamfx::encoder::codec::timecode::now())
+						   - static_cast<int64_t>(os_gettime_ns() / 1000);
+	}
+	uint64_t video_time     = _timecode_base + to_ns(pts);
+	_timecode_captured[pts] = static_cast<uint64_t>(static_cast<int64_t>(video_time / 1000) + _timecode_offset);
+	if (_timecode_captured.size() > ST_STATISTICS_MAX_PENDING) {
+		_timecode_captured.erase(_timecode_captured.begin());
+	}
+}
+
+void ffmpeg_instance::embed_timecode(AVPacket& packet)
+{
+	::streamfx::encoder::codec::timecode::frame_times times;
+	{
+		std::unique_lock<std::mutex> lock(_timecode_lock);
+		auto                         fnd = _timecode_captured.find(packet.pts);
+		if (fnd == _timecode_captured.end()) {
+			return;
+		}
+		times.captured = fnd->second;
+		_timecode_captured.erase(fnd);
+	}
+	times.pts     = packet.pts;
+	times.encoded = ::streamfx::encoder::codec::timecode::now();
+
+	bool hevc = (_codec->id == AV_CODEC_ID_HEVC);
+	auto sei  = ::streamfx::encoder::codec::timecode::make_sei(hevc, times);
+
+	// After parameter sets and other SEI, but in front of the first slice of the picture.
+	std::size_t size   = static_cast<std::size_t>(packet.size);
+	std::size_t offset = size;
+	::streamfx::encoder::codec::for_each_nal(packet.data, size, [&](const ::streamfx::encoder::codec::nal_view& nal) {
+		if ((offset == size) && ::streamfx::encoder::codec::timecode::is_picture(hevc, nal)) {
+			offset = static_cast<std::size_t>(nal.begin - packet.data);
+		}
+	});
+
+	if (int res = av_grow_packet(&packet, static_cast<int>(sei.size())); res < 0) {
+		DLOG_WARNING("[%s] Failed to embed timecode: %s (%" PRId32 ").", _codec->name,
+					 ::streamfx::ffmpeg::tools::get_error_description(res), res);
+		return;
+	}
+	memmove(packet.data + offset + sei.size(), packet.data + offset, size - offset);
+	memcpy(packet.data + offset, sei.data(), sei.size());
+}
+
+void ffmpeg_instance::track_latency(int64_t pts)
+{
+	if (auto fnd = _stat_submitted.find(pts); fnd != _stat_submitted.end()) {
+		track_duration(_profile_latency, fnd->second);
+		_stat_submitted.erase(fnd);
+	}
+}
+
+void ffmpeg_instance::track_packet(const AVPacket& packet)
+{
+	if (_stat_packets.empty()) {
+		return;
+	}
+
+	packet_statistics entry;
+	entry.pts      = packet.pts;
+	entry.dts      = packet.dts;
+	entry.size     = packet.size;
+	entry.quality  = -1;
+	entry.type     = '?';
+	entry.keyframe = (packet.flags & AV_PKT_FLAG_KEY) != 0;
+
+	// Quality is stored as a little endian 32-bit integer, followed by the picture type. The side data is searched
+	// directly, as the size type of av_packet_get_side_data() differs between FFmpeg versions.
+	for (int idx = 0; idx < packet.side_data_elems; idx++) {
+		const AVPacketSideData& side = packet.side_data[idx];
+		if ((side.type != AV_PKT_DATA_QUALITY_STATS) || (side.size < 5)) {
+			continue;
+		}
+
+		entry.quality = static_cast<int32_t>(
+			static_cast<uint32_t>(side.data[0]) | (static_cast<uint32_t>(side.data[1]) << 8)
+			| (static_cast<uint32_t>(side.data[2]) << 16) | (static_cast<uint32_t>(side.data[3]) << 24));
+		entry.type = av_get_picture_type_char(static_cast<AVPictureType>(side.data[4]));
+		break;
+	}
+
+	std::unique_lock<std::mutex> lock(_stat_packets_lock);
+	_stat_packets[_stat_packets_total % _stat_packets.size()] = entry;
+	_stat_packets_total++;
+}
+
+void ffmpeg_instance::save_packet_statistics()
+{
+	if (_stat_packets.empty()) {
+		return;
+	}
+
+	// Copy out the recorded packets oldest first, so that encoding can go on while the file is written.
+	auto     packets = std::make_shared<std::vector<packet_statistics>>();
+	uint64_t first   = 0;
+	{
+		std::unique_lock<std::mutex> lock(_stat_packets_lock);
+		if (_stat_packets_total == 0) {
+			return;
+		}
+
+		first = (_stat_packets_total > _stat_packets.size()) ? (_stat_packets_total - _stat_packets.size()) : 0;
+		packets->reserve(static_cast<size_t>(_stat_packets_total - first));
+		for (uint64_t idx = first; idx < _stat_packets_total; idx++) {
+			packets->push_back(_stat_packets[idx % _stat_packets.size()]);
+		}
+	}
+
+	auto pool = streamfx::threadpool();
+	if (!pool)
+		return;
+
+	AVRational  time_base = _context ? _context->time_base : AVRational{0, 1};
+	std::string file      = _stat_packets_file;
+	std::string codec     = _codec->name;
+	pool->push(
+		[packets, first, time_base, file, codec](streamfx::util::threadpool_data_t) {
+			std::ofstream stream(std::filesystem::u8path(file), std::ios::out | std::ios::trunc);
+			if (!stream) {
+				DLOG_ERROR("[%s] Failed to open '%s' for writing.", codec.c_str(), file.c_str());
+				return;
+			}
+
+			stream << "packet,pts,dts,time_base,size,keyframe,type,qp\n";
+			uint64_t index = first;
+			for (auto& entry : *packets) {
+				stream << index++ << "," << entry.pts << "," << entry.dts << "," << time_base.num << "/"
+					   << time_base.den << "," << entry.size << "," << (entry.keyframe ? 1 : 0) << "," << entry.type
+					   << ",";
+				if (entry.quality >= 0) {
+					stream << (static_cast<double_t>(entry.quality) / FF_QP2LAMBDA);
+				}
+				stream << "\n";
+			}
+			DLOG_INFO("[%s] Saved statistics of %zu packets to '%s'.", codec.c_str(), packets->size(), file.c_str());
+		},
+		nullptr);
+}
+
+void ffmpeg_instance::log_statistics()
+{
+	DLOG_INFO("[%s] Statistics:", _codec->name);
+	DLOG_INFO("[%s]   %-10s: %10s %10s %10s %10s %10s", _codec->name, "Task", "Count", "Average", "50.0%ile",
+			  "95.0%ile", "99.0%ile");
+
+	std::pair<const char*, std::shared_ptr<streamfx::util::profiler>> profilers[]{
+		{"Convert", _profile_convert},
+		{"Send", _profile_send},
+		{"Receive", _profile_receive},
+		{"Latency", _profile_latency},
+	};
+	for (auto& kv : profilers) {
+		if (kv.second->count() == 0) {
+			continue;
+		}
+
+		DLOG_INFO("[%s]   %-10s: %10" PRIu64 " %8lldµs %8lldµs %8lldµs %8lldµs", _codec->name, kv.first,
+				  kv.second->count(), static_cast<long long>(kv.second->average_duration() / 1000.0),
+				  static_cast<long long>(
+					  std::chrono::duration_cast<std::chrono::microseconds>(kv.second->percentile(0.50)).count()),
+				  static_cast<long long>(
+					  std::chrono::duration_cast<std::chrono::microseconds>(kv.second->percentile(0.95)).count()),
+				  static_cast<long long>(
+					  std::chrono::duration_cast<std::chrono::microseconds>(kv.second->percentile(0.99)).count()));
+	}
+
+	uint64_t samples = _stat_queue_samples;
+	DLOG_INFO("[%s]   Queue Depth: %.2f average, %" PRIu64 " maximum", _codec->name,
+			  samples ? (static_cast<double_t>(_stat_queue_total) / static_cast<double_t>(samples)) : 0.0,
+			  static_cast<uint64_t>(_stat_queue_max));
+	DLOG_INFO("[%s]   EAGAIN Retries: %" PRIu64, _codec->name, static_cast<uint64_t>(_stat_eagain));
+	if (is_hardware_encode()) {
+		DLOG_INFO("[%s]   Texture Ring Exhausted: %" PRIu64, _codec->name, _stat_ring_exhausted);
+	}
+
+	if (samples > 1) {
+		auto elapsed =
+			std::chrono::duration_cast<std::chrono::duration<double_t>>(_stat_last_frame - _stat_first_frame);
+		DLOG_INFO("[%s]   Throughput: %.2f frames per second", _codec->name,
+				  static_cast<double_t>(samples - 1) / elapsed.count());
+	}
+	if (_stat_bytes_frames > 0) {
+		DLOG_INFO("[%s]   Memory Traffic: %.2f MiB per frame (%.2f MiB in, %.2f MiB out)", _codec->name,
+				  static_cast<double_t>(_stat_bytes_moved) / static_cast<double_t>(_stat_bytes_frames) / 1048576.0,
+				  static_cast<double_t>(_stat_frame_source) / 1048576.0,
+				  static_cast<double_t>(_stat_frame_target) / 1048576.0);
+	}
+	if (_stat_cpu) {
+		DLOG_INFO("[%s]   CPU Usage: %.2f%% (entire process)", _codec->name, os_cpu_usage_info_query(_stat_cpu));
+	}
+}
+
 bool ffmpeg_instance::get_extra_data(uint8_t** data, size_t* size)
 {
 	if (_extra_data.size() == 0)
@@ -608,88 +1554,189 @@ void ffmpeg_instance::get_video_info(struct video_scale_info* info)
 
 int ffmpeg_instance::receive_packet(bool* received_packet, struct encoder_packet* packet)
 {
-	int res = 0;
-
-	av_packet_unref(&_packet);
+	int  res = 0;
+	auto pkt = _packets.pop();
 
 	{
-		auto gctx = streamfx::obs::gs::context();
-		res       = avcodec_receive_packet(_context, &_packet);
+		auto gctx  = streamfx::obs::gs::context();
+		auto begin = std::chrono::high_resolution_clock::now();
+		res        = avcodec_receive_packet(_context, pkt.get());
+		track_duration(_profile_receive, begin);
 	}
 	if (res != 0) {
 		return res;
 	}
 
 	if (!_have_first_frame) {
-		if (_codec->id == AV_CODEC_ID_H264) {
-			uint8_t*    tmp_packet;
-			uint8_t*    tmp_header;
-			uint8_t*    tmp_sei;
-			std::size_t sz_packet, sz_header, sz_sei;
-
-			obs_extract_avc_headers(_packet.data, static_cast<size_t>(_packet.size), &tmp_packet, &sz_packet,
-									&tmp_header, &sz_header, &tmp_sei, &sz_sei);
-
-			if (sz_header) {
-				_extra_data.resize(sz_header);
-				std::memcpy(_extra_data.data(), tmp_header, sz_header);
-			}
-
-			if (sz_sei) {
-				_sei_data.resize(sz_sei);
-				std::memcpy(_sei_data.data(), tmp_sei, sz_sei);
-			}
-
-			// Not required, we only need the Extra Data and SEI Data anyway.
-			//std::memcpy(_current_packet.data, tmp_packet, sz_packet);
-			//_current_packet.size = static_cast<int>(sz_packet);
-
-			bfree(tmp_packet);
-			bfree(tmp_header);
-			bfree(tmp_sei);
-		} else if (_codec->id == AV_CODEC_ID_HEVC) {
-			hevc::extract_header_sei(_packet.data, static_cast<size_t>(_packet.size), _extra_data, _sei_data);
-		} else if (_context->extradata != nullptr) {
-			_extra_data.resize(static_cast<size_t>(_context->extradata_size));
-			std::memcpy(_extra_data.data(), _context->extradata, static_cast<size_t>(_context->extradata_size));
-		}
+		extract_extra_data(pkt->data, static_cast<size_t>(pkt->size));
 		_have_first_frame = true;
 	}
 
 	// Allow Handler Post-Processing
 	if (_handler)
-		_handler->process_avpacket(_packet, _codec, _context);
+		_handler->process_avpacket(*pkt, _codec, _context);
 
-	packet->type          = OBS_ENCODER_VIDEO;
-	packet->pts           = _packet.pts;
-	packet->dts           = _packet.dts;
-	packet->data          = _packet.data;
-	packet->size          = static_cast<size_t>(_packet.size);
-	packet->keyframe      = !!(_packet.flags & AV_PKT_FLAG_KEY);
-	packet->drop_priority = packet->keyframe ? 0 : 1;
-	*received_packet      = true;
+	if (_timecode)
+		embed_timecode(*pkt);
+
+	track_latency(pkt->pts);
+	track_packet(*pkt);
+	hand_packet(pkt, packet, received_packet);
 
 	push_free_frame(pop_used_frame());
 
 	return res;
 }
 
+void ffmpeg_instance::hand_packet(std::shared_ptr<AVPacket> pkt, encoder_packet* packet, bool* received_packet)
+{
+	// libOBS copies the data before the next call, so holding on to the packet until then avoids copying it here.
+	_packet = pkt;
+
+	packet->type          = OBS_ENCODER_VIDEO;
+	packet->pts           = _packet->pts;
+	packet->dts           = _packet->dts;
+	packet->data          = _packet->data;
+	packet->size          = static_cast<size_t>(_packet->size);
+	packet->keyframe      = !!(_packet->flags & AV_PKT_FLAG_KEY);
+	packet->drop_priority = packet->keyframe ? 0 : 1;
+	*received_packet      = true;
+}
+
 int ffmpeg_instance::send_frame(std::shared_ptr<AVFrame> const frame)
 {
+	if (_reconfigure_pending.load(std::memory_order_relaxed)) {
+		apply_reconfigure();
+	}
+
 	int res = 0;
 	{
-		auto gctx = streamfx::obs::gs::context();
-		res       = avcodec_send_frame(_context, frame.get());
+		auto gctx  = streamfx::obs::gs::context();
+		auto begin = std::chrono::high_resolution_clock::now();
+		res        = avcodec_send_frame(_context, frame.get());
+		track_duration(_profile_send, begin);
 	}
 	if (res == 0) {
 		push_used_frame(frame);
+
+		// Frames held by the encoder, plus those still waiting for the submission worker.
+		uint64_t depth = _used_frames.size() + (_async_frames ? _async_frames->size() : 0);
+		_stat_queue_total += depth;
+		_stat_queue_samples++;
+		if (depth > _stat_queue_max) {
+			_stat_queue_max = depth;
+		}
+
+		// Remember when the frame went in, so that the matching packet can report the encoder's latency.
+		auto now = std::chrono::high_resolution_clock::now();
+		_stat_submitted.emplace(frame->pts, now);
+		if (_stat_submitted.size() > ST_STATISTICS_MAX_PENDING) {
+			_stat_submitted.erase(_stat_submitted.begin());
+		}
+		if (_stat_queue_samples == 1) {
+			_stat_first_frame = now;
+		}
+		_stat_last_frame = now;
+	} else if (res == AVERROR(EAGAIN)) {
+		_stat_eagain++;
 	}
 
 	return res;
 }
 
+void ffmpeg_instance::apply_reconfigure()
+{
+	std::shared_ptr<obs_data_t> settings;
+	{
+		std::lock_guard<std::mutex> lock(_reconfigure_lock);
+		settings.swap(_reconfigure);
+		_reconfigure_pending.store(false);
+	}
+	if (!settings) {
+		return;
+	}
+
+	if (_handler && _handler->reconfigure(settings.get(), _codec, _context)) {
+		DLOG_INFO("[%s] Reconfigured to %" PRId64 " kbit/s (maximum %" PRId64 " kbit/s, buffer %i kbit).",
+				  _codec->name, _context->bit_rate / 1000, _context->rc_max_rate / 1000,
+				  _context->rc_buffer_size / 1000);
+	} else {
+		DLOG_WARNING("[%s] Encoder can't change settings while encoding, changes apply when it is restarted.",
+					 _codec->name);
+	}
+}
+
+void ffmpeg_instance::attach_regions_of_interest(AVFrame* frame)
+{
+	// Pooled frames still carry the regions of their previous use.
+	av_frame_remove_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+
+	std::shared_ptr<const ::streamfx::util::tracking::frame> tracked;
+	if (obs_source_t* source = obs_weak_source_get_source(_roi_source.get()); source) {
+		tracked = _roi_tracking.get(source);
+		obs_source_release(source);
+	}
+	if (!tracked || tracked->faces.empty()) {
+		return;
+	}
+
+	// Tracking is relative to the source, which is assumed to fill the whole frame.
+	AVFrameSideData* data = av_frame_new_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST,
+												   tracked->faces.size() * sizeof(AVRegionOfInterest));
+	if (!data) {
+		return;
+	}
+	auto regions = reinterpret_cast<AVRegionOfInterest*>(data->data);
+	for (std::size_t idx = 0; idx < tracked->faces.size(); idx++) {
+		auto& face             = tracked->faces[idx];
+		regions[idx].self_size = sizeof(AVRegionOfInterest);
+		regions[idx].left      = static_cast<int>(std::clamp(face.x, 0.f, 1.f) * frame->width);
+		regions[idx].top       = static_cast<int>(std::clamp(face.y, 0.f, 1.f) * frame->height);
+		regions[idx].right     = static_cast<int>(std::clamp(face.x + face.width, 0.f, 1.f) * frame->width);
+		regions[idx].bottom    = static_cast<int>(std::clamp(face.y + face.height, 0.f, 1.f) * frame->height);
+		regions[idx].qoffset   = _roi_offset;
+	}
+}
+
+void ffmpeg_instance::extract_extra_data(uint8_t* data, std::size_t size)
+{
+	if (_codec->id == AV_CODEC_ID_H264) {
+		h264::extract_header_sei(data, size, _extra_data, _sei_data);
+	} else if (_codec->id == AV_CODEC_ID_HEVC) {
+		hevc::extract_header_sei(data, size, _extra_data, _sei_data);
+	} else if (_codec->id == AV_CODEC_ID_AV1) {
+		av1::extract_header_sei(data, size, _extra_data, _sei_data);
+	} else if (_context->extradata != nullptr) {
+		_extra_data.resize(static_cast<size_t>(_context->extradata_size));
+		std::memcpy(_extra_data.data(), _context->extradata, static_cast<size_t>(_context->extradata_size));
+	}
+}
+
 bool ffmpeg_instance::encode_avframe(std::shared_ptr<AVFrame> frame, encoder_packet* packet, bool* received_packet)
 {
+	// Give the handler a chance to tune itself once the encoder has settled in.
+	if (!_stat_processed && _handler) {
+		auto now = std::chrono::high_resolution_clock::now();
+		if (_stat_warmup_begin == std::chrono::high_resolution_clock::time_point()) {
+			_stat_warmup_begin  = now;
+			_stat_warmup_cpu    = os_cpu_usage_info_start();
+			_stat_warmup_frames = _profile_send->count();
+		} else if ((now - _stat_warmup_begin) > std::chrono::seconds(ST_STATISTICS_WARMUP)) {
+			_stat_processed      = true;
+			obs_data_t* settings = obs_encoder_get_settings(_self);
+			_handler->process_statistics(this, settings);
+			obs_data_release(settings);
+		}
+	}
+
+	if (_roi_source && frame) {
+		attach_regions_of_interest(frame.get());
+	}
+
+	if (_async) {
+		return async_encode_avframe(frame, packet, received_packet);
+	}
+
 	bool sent_frame  = false;
 	bool recv_packet = false;
 	bool should_lag  = (_sent_frames >= _lag_in_frames);
@@ -764,9 +1811,233 @@ bool ffmpeg_instance::encode_avframe(std::shared_ptr<AVFrame> frame, encoder_pac
 	return true;
 }
 
+void ffmpeg_instance::async_start()
+{
+	_async_frames =
+		std::make_shared<streamfx::util::ringbuffer<std::shared_ptr<AVFrame>>>(get_async_capacity(_context));
+	_async_stop   = false;
+	_async_worker = std::thread(std::bind(&ffmpeg_instance::async_work, this));
+}
+
+void ffmpeg_instance::async_stop()
+{
+	if (!_async_worker.joinable()) {
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> ul(_async_frames_lock);
+		_async_stop = true;
+		_async_frames_cv.notify_all();
+	}
+	_async_worker.join();
+
+	{ // Release any packets libOBS never picked up.
+		std::unique_lock<std::mutex> ul(_async_packets_lock);
+		_async_packets.clear();
+	}
+
+	if (_async_backpressure > 0) {
+		DLOG_WARNING("[%s] Asynchronous submission rejected %" PRIu64 " frame(s) due to backpressure.",
+					 _codec->name, _async_backpressure.load());
+	}
+}
+
+void ffmpeg_instance::async_work()
+{
+	std::shared_ptr<AVFrame> frame;
+
+	while (!_async_stop) {
+		// Wait for work, but wake up periodically to drain any packets the encoder still holds.
+		if (!frame && !_async_frames->pop(frame)) {
+			std::unique_lock<std::mutex> ul(_async_frames_lock);
+			_async_frames_cv.wait_for(ul, std::chrono::milliseconds(5),
+									  [this]() { return _async_stop || !_async_frames->empty(); });
+			if (!_async_frames->pop(frame)) {
+				while (async_receive_packet() == 0) {
+				}
+				continue;
+			}
+		}
+
+		int res = send_frame(frame);
+		switch (res) {
+		case 0:
+			frame.reset();
+			break;
+		case AVERROR(EAGAIN):
+			// The encoder is full, so retrieve packets until it accepts the frame again.
+			break;
+		case AVERROR(EOF):
+			DLOG_ERROR("[%s] Skipped frame due to end of stream.", _codec->name);
+			push_free_frame(frame);
+			frame.reset();
+			break;
+		default:
+			DLOG_ERROR("[%s] Failed to encode frame: %s (%" PRId32 ").", _codec->name,
+					   ::streamfx::ffmpeg::tools::get_error_description(res), res);
+			push_free_frame(frame);
+			frame.reset();
+			break;
+		}
+
+		// Drain everything that is ready right now.
+		int recv = 0;
+		do {
+			recv = async_receive_packet();
+		} while (recv == 0);
+
+		if ((res == AVERROR(EAGAIN)) && (recv == AVERROR(EAGAIN))) {
+			// Neither side made progress, give the hardware a moment.
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		} else if ((recv != AVERROR(EAGAIN)) && (recv != AVERROR(EOF))) {
+			DLOG_ERROR("[%s] Failed to receive packet: %s (%" PRId32 ").", _codec->name,
+					   ::streamfx::ffmpeg::tools::get_error_description(recv), recv);
+		}
+	}
+
+	if (frame) {
+		push_free_frame(frame);
+	}
+}
+
+int ffmpeg_instance::async_receive_packet()
+{
+	auto pkt = _packets.pop();
+
+	int res = 0;
+	{
+		auto gctx  = streamfx::obs::gs::context();
+		auto begin = std::chrono::high_resolution_clock::now();
+		res        = avcodec_receive_packet(_context, pkt.get());
+		track_duration(_profile_receive, begin);
+	}
+	if (res != 0) {
+		return res;
+	}
+
+	if (!_have_first_frame) {
+		extract_extra_data(pkt->data, static_cast<size_t>(pkt->size));
+		_have_first_frame = true;
+	}
+
+	// Allow Handler Post-Processing
+	if (_handler)
+		_handler->process_avpacket(*pkt, _codec, _context);
+
+	if (_timecode)
+		embed_timecode(*pkt);
+
+	track_latency(pkt->pts);
+	track_packet(*pkt);
+
+	{ // Hand the packet to the encode thread.
+		std::unique_lock<std::mutex> ul(_async_packets_lock);
+		_async_packets.push_back(pkt);
+	}
+
+	push_free_frame(pop_used_frame());
+
+	return res;
+}
+
+bool ffmpeg_instance::async_encode_avframe(std::shared_ptr<AVFrame> frame, encoder_packet* packet,
+										   bool* received_packet)
+{
+	// Never wait on the worker, instead count the frames it could not keep up with.
+	if (frame) {
+		if (_async_frames->push(frame)) {
+			_async_frames_cv.notify_one();
+		} else {
+			_async_backpressure++;
+			push_free_frame(frame);
+		}
+	}
+
+	// Return the oldest completed packet, if there is one.
+	std::shared_ptr<AVPacket> pkt;
+	{
+		std::unique_lock<std::mutex> ul(_async_packets_lock);
+		if (_async_packets.size() > 0) {
+			pkt = _async_packets.front();
+			_async_packets.pop_front();
+		}
+	}
+	if (pkt) {
+		hand_packet(pkt, packet, received_packet);
+	}
+
+	return true;
+}
+
+void ffmpeg_instance::create_hwinst(int64_t adapter)
+{
+	auto obs_adapter = _hwapi->get_obs_adapter();
+	if (adapter == ST_ADAPTER_OBS) {
+		ffmpeg_manager::get()->acquire_adapter(obs_adapter, _session_limit);
+		_hwadapter = obs_adapter;
+		try {
+			_hwinst = _hwapi->create_from_obs();
+		} catch (...) {
+			ffmpeg_manager::get()->release_adapter(_hwadapter);
+			throw;
+		}
+		return;
+	}
+
+	::streamfx::ffmpeg::hwapi::device target;
+	auto                              adapters = _hwapi->enumerate_adapters();
+	if (adapter == ST_ADAPTER_AUTOMATIC) {
+		target = ffmpeg_manager::get()->acquire_least_used_adapter(adapters, obs_adapter, _session_limit);
+	} else if ((adapter >= 0) && (static_cast<size_t>(adapter) < adapters.size())) {
+		target = *std::next(adapters.begin(), static_cast<ptrdiff_t>(adapter));
+		ffmpeg_manager::get()->acquire_adapter(target.id, _session_limit);
+	} else {
+		throw std::runtime_error("Selected adapter does not exist.");
+	}
+	_hwadapter = target.id;
+
+	try {
+		_hwinst = (target.id == obs_adapter) ? _hwapi->create_from_obs() : _hwapi->create(target);
+	} catch (...) {
+		ffmpeg_manager::get()->release_adapter(_hwadapter);
+		throw;
+	}
+	DLOG_INFO("[%s] Encoding on adapter '%s'.", _codec->name, target.name.c_str());
+}
+
+bool ffmpeg_instance::reuse_session(obs_data_t* settings)
+{
+	_session_keep  = obs_data_get_int(settings, ST_KEY_FFMPEG_SESSIONCACHE);
+	_session_limit = static_cast<size_t>(obs_data_get_int(settings, ST_KEY_FFMPEG_SESSIONLIMIT));
+
+	// Scaled encoders can't take the CUDA path, so they never share a session with unscaled ones.
+	_session_key = std::string(_codec->name) + "|" + std::to_string(obs_data_get_int(settings, ST_KEY_FFMPEG_ADAPTER))
+				   + "|" + (obs_encoder_scaling_enabled(_self) ? "scaled" : "direct");
+	_session = ffmpeg_manager::get()->take_session(_session_key);
+	if (!_session) {
+		return false;
+	}
+
+	// A full adapter keeps the session around for whoever closes an encoder on it next.
+	try {
+		ffmpeg_manager::get()->acquire_adapter(_session->adapter, _session_limit);
+	} catch (...) {
+		ffmpeg_manager::get()->store_session(std::move(_session));
+		throw;
+	}
+
+	_hwapi     = _session->api;
+	_hwinst    = _session->instance;
+	_hwadapter = _session->adapter;
+	DLOG_INFO("[%s] Reusing the hardware session of a previous encoder.", _codec->name);
+	return true;
+}
+
 bool ffmpeg_instance::is_hardware_encode()
 {
-	return _hwinst != nullptr;
+	// Uploaded software frames still take the software path through OBS.
+	return (_hwinst != nullptr) && !_upload_frame;
 }
 
 const AVCodec* ffmpeg_instance::get_avcodec()
@@ -779,6 +2050,53 @@ const AVCodecContext* ffmpeg_instance::get_avcodeccontext()
 	return _context;
 }
 
+void ffmpeg_instance::get_submission_statistics(uint64_t& frames, uint64_t& eagain, uint64_t& max_depth,
+												double_t& framerate)
+{
+	frames    = _stat_queue_samples;
+	eagain    = _stat_eagain;
+	max_depth = _stat_queue_max;
+
+	// Measured on the encode thread, as the submission worker may be updating the frame timestamps concurrently.
+	auto     now     = std::chrono::high_resolution_clock::now();
+	double_t elapsed = std::chrono::duration<double_t>(now - _stat_warmup_begin).count();
+	framerate        = (elapsed > 0) ? (static_cast<double_t>(frames) / elapsed) : 0.0;
+}
+
+double_t ffmpeg_instance::get_encode_capacity()
+{
+	if (!_stat_warmup_cpu) {
+		return 0.;
+	}
+
+	// Time spent in send and receive misses the encoder's own threads, so go by the CPU time of the process instead.
+	// OBS feeds frames at the output rate, and the encoder could keep up with more only as long as CPU time is left.
+	// Encoders stop scaling linearly well before all cores are busy, so the extrapolation ends at four times the load.
+	auto     now     = std::chrono::high_resolution_clock::now();
+	double_t elapsed = std::chrono::duration<double_t>(now - _stat_warmup_begin).count();
+	double_t frames  = static_cast<double_t>(_profile_send->count() - _stat_warmup_frames);
+	double_t usage   = os_cpu_usage_info_query(_stat_warmup_cpu); // Percent of all cores.
+	if ((elapsed <= 0.) || (frames <= 0.) || (usage <= 0.)) {
+		return 0.;
+	}
+	return (frames / elapsed) * std::min(100. / usage, 4.);
+}
+
+double_t ffmpeg_instance::get_pipeline_capacity()
+{
+	uint64_t frames = _profile_send->count();
+	if (frames == 0) {
+		return 0.;
+	}
+
+	auto busy =
+		_profile_convert->total_duration() + _profile_send->total_duration() + _profile_receive->total_duration();
+	if (busy.count() <= 0) {
+		return 0.;
+	}
+	return static_cast<double_t>(frames) / std::chrono::duration<double_t>(busy).count();
+}
+
 void ffmpeg_instance::parse_ffmpeg_commandline(std::string text)
 {
 	// Steps to properly parse a command line:
@@ -996,8 +2314,28 @@ void ffmpeg_factory::get_defaults2(obs_data_t* settings)
 		obs_data_set_default_string(settings, ST_KEY_FFMPEG_CUSTOMSETTINGS, "");
 		obs_data_set_default_int(settings, ST_KEY_FFMPEG_COLORFORMAT, static_cast<int64_t>(AV_PIX_FMT_NONE));
 		obs_data_set_default_int(settings, ST_KEY_FFMPEG_THREADS, 0);
+		obs_data_set_default_int(settings, ST_KEY_FFMPEG_THREADPOLICY,
+								 static_cast<int64_t>(streamfx::util::platform::thread_policy::DEFAULT));
+		obs_data_set_default_int(settings, ST_KEY_FFMPEG_CONVERSIONTHREADS, 1);
+		obs_data_set_default_bool(settings, ST_KEY_FFMPEG_GPUCONVERSION, false);
+		obs_data_set_default_string(settings, ST_KEY_FFMPEG_GROUP, "");
+		obs_data_set_default_int(settings, ST_KEY_FFMPEG_GROUP_WIDTH, 0);
+		obs_data_set_default_int(settings, ST_KEY_FFMPEG_GROUP_HEIGHT, 0);
 		obs_data_set_default_int(settings, ST_KEY_FFMPEG_GPU, -1);
+		obs_data_set_default_int(settings, ST_KEY_FFMPEG_TEXTURERING, 0);
+		obs_data_set_default_int(settings, ST_KEY_FFMPEG_SESSIONCACHE, 0);
+		obs_data_set_default_int(settings, ST_KEY_FFMPEG_SESSIONLIMIT, 0);
+		obs_data_set_default_bool(settings, ST_KEY_FFMPEG_ZEROCOPY, false);
+		obs_data_set_default_bool(settings, ST_KEY_FFMPEG_SHAREDFRAMES, true);
+		obs_data_set_default_int(settings, ST_KEY_FFMPEG_SCALER,
+								 static_cast<int64_t>(::streamfx::ffmpeg::hwapi::scaler_quality::NORMAL));
+		obs_data_set_default_int(settings, ST_KEY_FFMPEG_ADAPTER, ST_ADAPTER_OBS);
 		obs_data_set_default_int(settings, ST_KEY_FFMPEG_STANDARDCOMPLIANCE, FF_COMPLIANCE_STRICT);
+		obs_data_set_default_bool(settings, ST_KEY_FFMPEG_ASYNC, false);
+		obs_data_set_default_string(settings, ST_KEY_FFMPEG_ROI, "");
+		obs_data_set_default_int(settings, ST_KEY_FFMPEG_ROI_STRENGTH, 50);
+		obs_data_set_default_bool(settings, ST_KEY_FFMPEG_TIMECODE, false);
+		obs_data_set_default_string(settings, ST_KEY_STATISTICS_FILE, "");
 	}
 }
 
@@ -1082,11 +2420,101 @@ obs_properties_t* ffmpeg_factory::get_properties2(instance_t* data)
 											std::numeric_limits<uint8_t>::max(), 1);
 		}
 
+#ifdef WIN32
+		if (_handler && _handler->is_hardware_encoder(this)) {
+			auto p = obs_properties_add_list(grp, ST_KEY_FFMPEG_ADAPTER, D_TRANSLATE(ST_I18N_FFMPEG_ADAPTER),
+											 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_FFMPEG_ADAPTER_OBS), ST_ADAPTER_OBS);
+			obs_property_list_add_int(p, D_TRANSLATE(S_STATE_AUTOMATIC), ST_ADAPTER_AUTOMATIC);
+			try {
+				int64_t index = 0;
+				for (auto& adapter : ::streamfx::ffmpeg::hwapi::d3d11().enumerate_adapters()) {
+					obs_property_list_add_int(p, adapter.name.c_str(), index++);
+				}
+			} catch (const std::exception& ex) {
+				DLOG_WARNING("Failed to enumerate adapters: %s", ex.what());
+			}
+		}
+#elif defined(ENABLE_ENCODER_FFMPEG_VAAPI)
+		if ((_avcodec->type == AVMEDIA_TYPE_VIDEO)
+			&& ::streamfx::ffmpeg::tools::can_hardware_encode(_avcodec, AV_PIX_FMT_VAAPI)) {
+			auto p = obs_properties_add_list(grp, ST_KEY_FFMPEG_ADAPTER, D_TRANSLATE(ST_I18N_FFMPEG_ADAPTER),
+											 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_FFMPEG_ADAPTER_OBS), ST_ADAPTER_OBS);
+			obs_property_list_add_int(p, D_TRANSLATE(S_STATE_AUTOMATIC), ST_ADAPTER_AUTOMATIC);
+			try {
+				int64_t index = 0;
+				for (auto& adapter : ::streamfx::ffmpeg::hwapi::vaapi().enumerate_adapters()) {
+					obs_property_list_add_int(p, adapter.name.c_str(), index++);
+				}
+			} catch (const std::exception& ex) {
+				DLOG_WARNING("Failed to enumerate adapters: %s", ex.what());
+			}
+		}
+#endif
+
+		if (_handler && _handler->is_hardware_encoder(this)) {
+			obs_properties_add_int_slider(grp, ST_KEY_FFMPEG_TEXTURERING, D_TRANSLATE(ST_I18N_FFMPEG_TEXTURERING), 0,
+										  8, 1);
+
+			{
+				auto p = obs_properties_add_int_slider(grp, ST_KEY_FFMPEG_SESSIONCACHE,
+													   D_TRANSLATE(ST_I18N_FFMPEG_SESSIONCACHE), 0, 600, 1);
+				obs_property_int_set_suffix(p, " s");
+			}
+
+			obs_properties_add_int_slider(grp, ST_KEY_FFMPEG_SESSIONLIMIT, D_TRANSLATE(ST_I18N_FFMPEG_SESSIONLIMIT), 0,
+										  32, 1);
+
+			obs_properties_add_bool(grp, ST_KEY_FFMPEG_ZEROCOPY, D_TRANSLATE(ST_I18N_FFMPEG_ZEROCOPY));
+			obs_properties_add_bool(grp, ST_KEY_FFMPEG_SHAREDFRAMES, D_TRANSLATE(ST_I18N_FFMPEG_SHAREDFRAMES));
+
+			auto p = obs_properties_add_list(grp, ST_KEY_FFMPEG_SCALER, D_TRANSLATE(ST_I18N_FFMPEG_SCALER),
+											 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_FFMPEG_SCALER_FASTEST),
+									  static_cast<int64_t>(::streamfx::ffmpeg::hwapi::scaler_quality::FASTEST));
+			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_FFMPEG_SCALER_NORMAL),
+									  static_cast<int64_t>(::streamfx::ffmpeg::hwapi::scaler_quality::NORMAL));
+			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_FFMPEG_SCALER_BEST),
+									  static_cast<int64_t>(::streamfx::ffmpeg::hwapi::scaler_quality::BEST));
+		}
+
 		if (_handler && _handler->has_threading_support(this)) {
 			auto p = obs_properties_add_int_slider(grp, ST_KEY_FFMPEG_THREADS, D_TRANSLATE(ST_I18N_FFMPEG_THREADS), 0,
 												   static_cast<int64_t>(std::thread::hardware_concurrency() * 2), 1);
 		}
 
+		if (_handler && _handler->has_threading_support(this)) {
+			auto p = obs_properties_add_list(grp, ST_KEY_FFMPEG_THREADPOLICY,
+											 D_TRANSLATE(ST_I18N_FFMPEG_THREADPOLICY), OBS_COMBO_TYPE_LIST,
+											 OBS_COMBO_FORMAT_INT);
+			obs_property_list_add_int(p, D_TRANSLATE(S_STATE_DEFAULT),
+									  static_cast<int64_t>(streamfx::util::platform::thread_policy::DEFAULT));
+			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_FFMPEG_THREADPOLICY_PERFORMANCE),
+									  static_cast<int64_t>(streamfx::util::platform::thread_policy::PERFORMANCE));
+			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_FFMPEG_THREADPOLICY_BACKGROUND),
+									  static_cast<int64_t>(streamfx::util::platform::thread_policy::BACKGROUND));
+		}
+
+		if (_avcodec->type == AVMEDIA_TYPE_VIDEO) {
+			obs_properties_add_int_slider(grp, ST_KEY_FFMPEG_CONVERSIONTHREADS,
+										  D_TRANSLATE(ST_I18N_FFMPEG_CONVERSIONTHREADS), 0,
+										  static_cast<int64_t>(std::thread::hardware_concurrency()), 1);
+		}
+
+		if (_avcodec->type == AVMEDIA_TYPE_VIDEO) {
+			obs_properties_add_bool(grp, ST_KEY_FFMPEG_GPUCONVERSION, D_TRANSLATE(ST_I18N_FFMPEG_GPUCONVERSION));
+		}
+
+		if (_avcodec->type == AVMEDIA_TYPE_VIDEO) {
+			obs_properties_add_text(grp, ST_KEY_FFMPEG_GROUP, D_TRANSLATE(ST_I18N_FFMPEG_GROUP),
+									obs_text_type::OBS_TEXT_DEFAULT);
+			obs_properties_add_int(grp, ST_KEY_FFMPEG_GROUP_WIDTH, D_TRANSLATE(ST_I18N_FFMPEG_GROUP_WIDTH), 0,
+								   std::numeric_limits<int16_t>::max(), 1);
+			obs_properties_add_int(grp, ST_KEY_FFMPEG_GROUP_HEIGHT, D_TRANSLATE(ST_I18N_FFMPEG_GROUP_HEIGHT), 0,
+								   std::numeric_limits<int16_t>::max(), 1);
+		}
+
 		if (_handler && _handler->has_pixel_format_support(this)) {
 			auto p = obs_properties_add_list(grp, ST_KEY_FFMPEG_COLORFORMAT, D_TRANSLATE(ST_I18N_FFMPEG_COLORFORMAT),
 											 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
@@ -1112,6 +2540,36 @@ obs_properties_t* ffmpeg_factory::get_properties2(instance_t* data)
 			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_FFMPEG_STANDARDCOMPLIANCE ".Experimental"),
 									  FF_COMPLIANCE_EXPERIMENTAL);
 		}
+
+		obs_properties_add_bool(grp, ST_KEY_FFMPEG_ASYNC, D_TRANSLATE(ST_I18N_FFMPEG_ASYNC));
+
+		if (_avcodec->type == AVMEDIA_TYPE_VIDEO) {
+			auto p = obs_properties_add_list(grp, ST_KEY_FFMPEG_ROI, D_TRANSLATE(ST_I18N_FFMPEG_ROI),
+											 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+			obs_property_list_add_string(p, D_TRANSLATE(S_STATE_DISABLED), "");
+			obs_enum_sources(
+				[](void* param, obs_source_t* source) {
+					if ((obs_source_get_output_flags(source) & OBS_SOURCE_VIDEO) != 0) {
+						const char* name = obs_source_get_name(source);
+						obs_property_list_add_string(reinterpret_cast<obs_property_t*>(param), name, name);
+					}
+					return true;
+				},
+				p);
+		}
+
+		if (_avcodec->type == AVMEDIA_TYPE_VIDEO) {
+			auto p = obs_properties_add_int_slider(grp, ST_KEY_FFMPEG_ROI_STRENGTH,
+												   D_TRANSLATE(ST_I18N_FFMPEG_ROI_STRENGTH), 0, 100, 1);
+			obs_property_int_set_suffix(p, " %");
+		}
+
+		if ((_avcodec->id == AV_CODEC_ID_H264) || (_avcodec->id == AV_CODEC_ID_HEVC)) {
+			obs_properties_add_bool(grp, ST_KEY_FFMPEG_TIMECODE, D_TRANSLATE(ST_I18N_FFMPEG_TIMECODE));
+		}
+
+		obs_properties_add_path(grp, ST_KEY_STATISTICS_FILE, D_TRANSLATE(ST_I18N_STATISTICS_FILE), OBS_PATH_FILE_SAVE,
+								"CSV (*.csv)", nullptr);
 	};
 
 	return props;
@@ -1136,30 +2594,61 @@ obs_encoder_info* streamfx::encoder::ffmpeg::ffmpeg_factory::get_info()
 	return &_info;
 }
 
-ffmpeg_manager::ffmpeg_manager() : _factories(), _handlers(), _debug_handler()
+ffmpeg_manager::ffmpeg_manager()
+	: _factories(), _handlers(), _debug_handler(), _groups(), _groups_lock(), _adapter_sessions(),
+	  _adapter_sessions_lock(), _sessions(), _sessions_lock()
 {
 	// Handlers
 	_debug_handler = ::std::make_shared<handler::debug_handler>();
+#ifdef ENABLE_BENCHMARK
+	register_handler("wrapped_avframe", ::std::make_shared<handler::null_handler>());
+#endif
 #ifdef ENABLE_ENCODER_FFMPEG_AMF
 	register_handler("h264_amf", ::std::make_shared<handler::amf_h264_handler>());
 	register_handler("hevc_amf", ::std::make_shared<handler::amf_hevc_handler>());
+	register_handler("av1_amf", ::std::make_shared<handler::amf_av1_handler>());
 #endif
 #ifdef ENABLE_ENCODER_FFMPEG_NVENC
 	register_handler("h264_nvenc", ::std::make_shared<handler::nvenc_h264_handler>());
 	register_handler("hevc_nvenc", ::std::make_shared<handler::nvenc_hevc_handler>());
+	register_handler("av1_nvenc", ::std::make_shared<handler::nvenc_av1_handler>());
 #endif
 #ifdef ENABLE_ENCODER_FFMPEG_PRORES
 	register_handler("prores_aw", ::std::make_shared<handler::prores_aw_handler>());
 #endif
+#ifdef ENABLE_ENCODER_FFMPEG_SOFTWARE
+	{
+		auto software = ::std::make_shared<handler::software_handler>();
+		register_handler("libx264", software);
+		register_handler("libx265", software);
+		register_handler("libsvtav1", software);
+	}
+#endif
+#ifdef ENABLE_ENCODER_FFMPEG_VAAPI
+	register_handler("h264_vaapi", ::std::make_shared<handler::vaapi_handler>());
+	register_handler("hevc_vaapi", ::std::make_shared<handler::vaapi_handler>());
+#endif
+
+	// Stored sessions are released from the graphics thread once they expire.
+	obs_add_tick_callback(tick, this);
 }
 
 ffmpeg_manager::~ffmpeg_manager()
 {
+	obs_remove_tick_callback(tick, this);
+	{
+		auto                         gctx = streamfx::obs::gs::context();
+		std::unique_lock<std::mutex> lock(_sessions_lock);
+		_sessions.clear();
+	}
 	_factories.clear();
 }
 
 void ffmpeg_manager::register_encoders()
 {
+	// Registration only reads static AVCodec information, hardware is probed once an encoder is actually created.
+	auto time_begin = std::chrono::high_resolution_clock::now();
+
 	// Encoders
 #if FF_API_NEXT
 	void* iterator = nullptr;
@@ -1192,6 +2681,11 @@ void ffmpeg_manager::register_encoders()
 		}
 	}
 #endif
+
+	auto time_taken = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::high_resolution_clock::now() - time_begin);
+	DLOG_INFO("Registered %zu FFmpeg encoders in %lld ms.", _factories.size(),
+			  static_cast<long long>(time_taken.count()));
 }
 
 void ffmpeg_manager::register_handler(std::string codec, std::shared_ptr<handler::handler> handler)
@@ -1216,6 +2710,156 @@ bool ffmpeg_manager::has_handler(std::string codec)
 	return (_handlers.find(codec) != _handlers.end());
 }
 
+void ffmpeg_manager::acquire_adapter(std::pair<int64_t, int64_t> id, std::size_t limit)
+{
+	std::unique_lock<std::mutex> lock(_adapter_sessions_lock);
+	std::size_t&                 sessions = _adapter_sessions[id];
+	if ((limit > 0) && (sessions >= limit)) {
+		DLOG_ERROR("Adapter already runs %zu of %zu allowed hardware encoder sessions.", sessions, limit);
+		throw ::streamfx::obs::encoder_no_fallback_error(
+			"Adapter has no hardware encoder sessions left, use fewer encoders or a different adapter.");
+	}
+	sessions++;
+}
+
+void ffmpeg_manager::release_adapter(std::pair<int64_t, int64_t> id)
+{
+	std::unique_lock<std::mutex> lock(_adapter_sessions_lock);
+	if (auto fnd = _adapter_sessions.find(id); fnd != _adapter_sessions.end()) {
+		if (--fnd->second == 0) {
+			_adapter_sessions.erase(fnd);
+		}
+	}
+}
+
+::streamfx::ffmpeg::hwapi::device
+	ffmpeg_manager::acquire_least_used_adapter(std::list<::streamfx::ffmpeg::hwapi::device> adapters,
+											   std::pair<int64_t, int64_t> obs_adapter, std::size_t limit)
+{
+	std::unique_lock<std::mutex> lock(_adapter_sessions_lock);
+
+	if (adapters.empty()) {
+		throw std::runtime_error("No adapters available.");
+	}
+
+	auto        best      = adapters.end();
+	std::size_t best_load = std::numeric_limits<std::size_t>::max();
+	for (auto itr = adapters.begin(); itr != adapters.end(); itr++) {
+		std::size_t sessions = 0;
+		if (auto fnd = _adapter_sessions.find(itr->id); fnd != _adapter_sessions.end()) {
+			sessions = fnd->second;
+		}
+		if ((limit > 0) && (sessions >= limit)) {
+			continue;
+		}
+
+		std::size_t load = sessions + ((itr->id == obs_adapter) ? 1 : 0);
+		if (load < best_load) {
+			best      = itr;
+			best_load = load;
+		}
+	}
+	if (best == adapters.end()) {
+		DLOG_ERROR("All %zu adapters already run %zu allowed hardware encoder sessions.", adapters.size(), limit);
+		throw ::streamfx::obs::encoder_no_fallback_error(
+			"No adapter has hardware encoder sessions left, use fewer encoders.");
+	}
+
+	_adapter_sessions[best->id]++;
+	return *best;
+}
+
+// Sessions hold on to a whole hardware device each, so only keep a few around.
+#define ST_SESSIONS_MAXIMUM 4
+
+void ffmpeg_manager::store_session(std::shared_ptr<ffmpeg_session> session)
+{
+	std::list<std::shared_ptr<ffmpeg_session>> released;
+	{
+		std::unique_lock<std::mutex> lock(_sessions_lock);
+		for (auto itr = _sessions.begin(); itr != _sessions.end();) {
+			if ((*itr)->key == session->key) {
+				released.push_back(*itr);
+				itr = _sessions.erase(itr);
+			} else {
+				itr++;
+			}
+		}
+		_sessions.push_back(session);
+		while (_sessions.size() > ST_SESSIONS_MAXIMUM) {
+			released.push_back(_sessions.front());
+			_sessions.pop_front();
+		}
+	}
+	// Released outside of the lock, as tearing down a device may block for a while.
+}
+
+std::shared_ptr<ffmpeg_session> ffmpeg_manager::take_session(std::string key)
+{
+	std::unique_lock<std::mutex> lock(_sessions_lock);
+	auto                         now = std::chrono::steady_clock::now();
+	for (auto itr = _sessions.begin(); itr != _sessions.end(); itr++) {
+		if (((*itr)->key == key) && ((*itr)->expires > now)) {
+			auto session = *itr;
+			_sessions.erase(itr);
+			return session;
+		}
+	}
+	return nullptr;
+}
+
+void ffmpeg_manager::tick(void* ptr, float_t) noexcept
+{
+	auto self = reinterpret_cast<ffmpeg_manager*>(ptr);
+
+	std::list<std::shared_ptr<ffmpeg_session>> released;
+	{
+		std::unique_lock<std::mutex> lock(self->_sessions_lock);
+		if (self->_sessions.empty()) {
+			return;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		for (auto itr = self->_sessions.begin(); itr != self->_sessions.end();) {
+			if ((*itr)->expires <= now) {
+				released.push_back(*itr);
+				itr = self->_sessions.erase(itr);
+			} else {
+				itr++;
+			}
+		}
+	}
+
+	// Sessions only expire once in a while, so most ticks have nothing to release.
+	if (released.empty()) {
+		return;
+	}
+
+	// Devices are torn down with the graphics context held, just like when an encoder is destroyed.
+	auto gctx = streamfx::obs::gs::context();
+	DLOG_DEBUG("Releasing %zu expired hardware session(s).", released.size());
+	released.clear();
+}
+
+std::shared_ptr<ffmpeg_group> ffmpeg_manager::get_group(std::string name, uint32_t width, uint32_t height,
+														AVPixelFormat format, AVColorSpace colorspace, bool full_range)
+{
+	std::unique_lock<std::mutex> lock(_groups_lock);
+
+	if (auto fnd = _groups.find(name); fnd != _groups.end()) {
+		if (auto group = fnd->second.lock(); group) {
+			if (!group->is_compatible(width, height, format, colorspace, full_range)) {
+				throw std::runtime_error("Encoder input does not match the other members of the group.");
+			}
+			return group;
+		}
+	}
+
+	auto group    = std::make_shared<ffmpeg_group>(name, width, height, format, colorspace, full_range);
+	_groups[name] = group;
+	return group;
+}
+
 std::shared_ptr<ffmpeg_manager> _ffmepg_encoder_factory_instance = nullptr;
 
 void ffmpeg_manager::initialize()
@@ -21,18 +21,28 @@
 
 #pragma once
 #include "common.hpp"
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <map>
 #include <mutex>
 #include <queue>
-#include <stack>
 #include <thread>
 #include <vector>
 #include "ffmpeg/avframe-queue.hpp"
+#include "ffmpeg/avpacket-pool.hpp"
+#include "ffmpeg/gpu-conversion.hpp"
 #include "ffmpeg/hwapi/base.hpp"
+#include "ffmpeg/hwapi/shared-frames.hpp"
 #include "ffmpeg/swscale.hpp"
 #include "handlers/handler.hpp"
 #include "obs/obs-encoder-factory.hpp"
+#include "util/util-profiler.hpp"
+#include "util/util-ringbuffer.hpp"
+#include "util/util-tracking.hpp"
+
+// Also read by the handlers, which tune the threading themselves.
+#define ST_KEY_FFMPEG_THREADS "FFmpeg.Threads"
 
 extern "C" {
 #ifdef _MSC_VER
@@ -50,6 +60,70 @@ extern "C" {
 namespace streamfx::encoder::ffmpeg {
 	class ffmpeg_factory;
 
+	/** Encoders sharing a single conversion of the same input.
+	 *
+	 * Every member adds a rung with its own output size and format. The first member to see a new input frame
+	 * converts it for all rungs at once, largest first, with each smaller rung scaled from the one above it. The
+	 * others then reference the already converted frame instead of converting it themselves.
+	 */
+	class ffmpeg_group {
+		public:
+		struct rung {
+			uint32_t      width;
+			uint32_t      height;
+			AVPixelFormat format;
+			std::size_t   members;
+
+			::streamfx::ffmpeg::swscale           scaler;
+			std::vector<std::shared_ptr<AVFrame>> frames;
+			std::shared_ptr<AVFrame>              current;
+		};
+
+		private:
+		std::string   _name;
+		uint32_t      _width;
+		uint32_t      _height;
+		AVPixelFormat _format;
+		AVColorSpace  _colorspace;
+		bool          _full_range;
+
+		std::mutex                         _lock;
+		std::vector<std::shared_ptr<rung>> _rungs;
+		bool                               _rungs_dirty;
+		uint64_t                           _source; // Identity of the converted input frame.
+
+		public:
+		ffmpeg_group(std::string name, uint32_t width, uint32_t height, AVPixelFormat format, AVColorSpace colorspace,
+					 bool full_range);
+		~ffmpeg_group();
+
+		/** Check if an encoder with this input can join the group. */
+		bool is_compatible(uint32_t width, uint32_t height, AVPixelFormat format, AVColorSpace colorspace,
+						   bool full_range);
+
+		/** Add a rung, or share an existing one with the same output. */
+		std::shared_ptr<rung> join(uint32_t width, uint32_t height, AVPixelFormat format);
+
+		void leave(std::shared_ptr<rung> rung);
+
+		/** Reference the converted frame for a rung, converting the input if no other member has done so yet. */
+		bool convert(std::shared_ptr<rung> rung, struct encoder_frame* frame, AVFrame* output);
+
+		private:
+		void rebuild();
+	};
+
+	/** Hardware resources of a closed encoder, kept alive so that the next matching encoder can start right away. */
+	struct ffmpeg_session {
+		std::string                                          key;
+		std::shared_ptr<::streamfx::ffmpeg::hwapi::base>     api;
+		std::shared_ptr<::streamfx::ffmpeg::hwapi::instance> instance;
+		std::pair<int64_t, int64_t>                          adapter;
+		std::shared_ptr<AVBufferRef>                         device;
+		std::shared_ptr<AVBufferRef>                         frames;
+		std::chrono::steady_clock::time_point                expires;
+	};
+
 	class ffmpeg_instance : public obs::encoder_instance {
 		ffmpeg_factory* _factory;
 		const AVCodec*  _codec;
@@ -57,11 +131,27 @@ namespace streamfx::encoder::ffmpeg {
 
 		std::shared_ptr<handler::handler> _handler;
 
-		::streamfx::ffmpeg::swscale _scaler;
-		AVPacket                    _packet;
+		::streamfx::ffmpeg::swscale                         _scaler;
+		std::shared_ptr<::streamfx::ffmpeg::gpu_conversion> _gpu_conversion;
+		::streamfx::ffmpeg::avpacket_pool                   _packets;
+		std::shared_ptr<AVPacket>                           _packet; // Lent to libOBS until the next call.
 
 		std::shared_ptr<::streamfx::ffmpeg::hwapi::base>     _hwapi;
 		std::shared_ptr<::streamfx::ffmpeg::hwapi::instance> _hwinst;
+		std::pair<int64_t, int64_t>                          _hwadapter;
+		std::shared_ptr<AVFrame>                             _upload_frame;
+
+		// Session Reuse
+		std::string                     _session_key;
+		std::shared_ptr<ffmpeg_session> _session; // Taken over from a previous encoder, until the frames exist.
+		int64_t                         _session_keep; // Seconds
+		std::size_t                     _session_limit; // Sessions per adapter, 0 for no limit.
+
+		// Encode straight from OBS's textures instead of copying them into frames first.
+		bool _zerocopy;
+
+		// Copies of OBS's textures, shared with other encoders that would copy them the same way.
+		std::shared_ptr<::streamfx::ffmpeg::hwapi::shared_frames> _shared_frames;
 
 		std::size_t _lag_in_frames;
 		std::size_t _sent_frames;
@@ -71,10 +161,79 @@ namespace streamfx::encoder::ffmpeg {
 		std::vector<uint8_t> _extra_data;
 		std::vector<uint8_t> _sei_data;
 
-		// Frame Stack and Queue
-		std::stack<std::shared_ptr<AVFrame>>           _free_frames;
-		std::queue<std::shared_ptr<AVFrame>>           _used_frames;
-		std::chrono::high_resolution_clock::time_point _free_frames_last_used;
+		// Frame Pool and Queue
+		::streamfx::ffmpeg::avframe_queue    _free_frames;
+		std::size_t                          _free_frames_capacity;
+		std::queue<std::shared_ptr<AVFrame>> _used_frames;
+
+		// Asynchronous Submission
+		bool                                                                  _async;
+		std::thread                                                           _async_worker;
+		std::atomic_bool                                                      _async_stop;
+		std::shared_ptr<streamfx::util::ringbuffer<std::shared_ptr<AVFrame>>> _async_frames;
+		std::mutex                                                            _async_frames_lock;
+		std::condition_variable                                               _async_frames_cv;
+		std::deque<std::shared_ptr<AVPacket>>                                 _async_packets;
+		std::mutex                                                            _async_packets_lock;
+		std::atomic<uint64_t>                                                 _async_backpressure;
+
+		// Shared Conversion
+		std::shared_ptr<ffmpeg_group>       _group;
+		std::shared_ptr<ffmpeg_group::rung> _group_rung;
+
+		// Live Reconfiguration
+		std::shared_ptr<obs_data_t> _reconfigure;
+		std::mutex                  _reconfigure_lock;
+		std::atomic_bool            _reconfigure_pending;
+
+		// Regions of Interest
+		std::shared_ptr<obs_weak_source_t>       _roi_source;
+		AVRational                               _roi_offset;
+		::streamfx::util::tracking::subscription _roi_tracking;
+
+		// Glass-to-glass Latency, capture times by pts until the packet for the frame leaves the encoder.
+		bool                        _timecode;
+		std::map<int64_t, uint64_t> _timecode_captured;
+		std::mutex                  _timecode_lock;
+		uint64_t                    _timecode_base;   // OBS video time of pts 0, in nanoseconds.
+		int64_t                     _timecode_offset; // Wall clock minus OBS video time, in microseconds.
+
+		// Statistics
+		std::shared_ptr<streamfx::util::profiler>                         _profile_convert;
+		std::shared_ptr<streamfx::util::profiler>                         _profile_send;
+		std::shared_ptr<streamfx::util::profiler>                         _profile_receive;
+		std::atomic<uint64_t>                                             _stat_eagain;
+		std::atomic<uint64_t>                                             _stat_queue_total;
+		std::atomic<uint64_t>                                             _stat_queue_samples;
+		std::atomic<uint64_t>                                             _stat_queue_max;
+		std::shared_ptr<streamfx::util::profiler>                         _profile_latency;
+		std::map<int64_t, std::chrono::high_resolution_clock::time_point> _stat_submitted;
+		std::chrono::high_resolution_clock::time_point                    _stat_first_frame;
+		std::chrono::high_resolution_clock::time_point                    _stat_last_frame;
+		os_cpu_usage_info_t*                                              _stat_cpu;
+		uint64_t                                                          _stat_ring_exhausted;
+		std::chrono::high_resolution_clock::time_point                    _stat_warmup_begin;
+		os_cpu_usage_info_t*                                              _stat_warmup_cpu;
+		uint64_t                                                          _stat_warmup_frames;
+		bool                                                              _stat_processed;
+		std::size_t                                                       _stat_frame_source; // Bytes
+		std::size_t                                                       _stat_frame_target; // Bytes
+		uint64_t                                                          _stat_bytes_moved;
+		uint64_t                                                          _stat_bytes_frames;
+
+		// Per-packet statistics, kept in a fixed ring that is only allocated when a file is set.
+		struct packet_statistics {
+			int64_t pts;
+			int64_t dts;
+			int32_t size;
+			int32_t quality; // In lambda units, or -1 if the encoder doesn't report it.
+			char    type;
+			bool    keyframe;
+		};
+		std::string                    _stat_packets_file;
+		std::vector<packet_statistics> _stat_packets;
+		uint64_t                       _stat_packets_total;
+		std::mutex                     _stat_packets_lock;
 
 		public:
 		ffmpeg_instance(obs_data_t* settings, obs_encoder_t* self, bool is_hw);
@@ -103,6 +262,12 @@ namespace streamfx::encoder::ffmpeg {
 		public:
 		void initialize_sw(obs_data_t* settings);
 		void initialize_hw(obs_data_t* settings);
+		void initialize_hw_frames();
+		void create_hwinst(int64_t adapter);
+
+		/** Take over the hardware of a recently closed encoder with the same configuration, if there is one. */
+		bool reuse_session(obs_data_t* settings);
+		void initialize_frame_pool();
 
 		void                     push_free_frame(std::shared_ptr<AVFrame> frame);
 		std::shared_ptr<AVFrame> pop_free_frame();
@@ -112,10 +277,53 @@ namespace streamfx::encoder::ffmpeg {
 
 		int receive_packet(bool* received_packet, struct encoder_packet* packet);
 
+		void hand_packet(std::shared_ptr<AVPacket> pkt, struct encoder_packet* packet, bool* received_packet);
+
 		int send_frame(std::shared_ptr<AVFrame> frame);
 
+		/** Hand settings changed while encoding to the handler, before the next frame is submitted. */
+		void apply_reconfigure();
+
 		bool encode_avframe(std::shared_ptr<AVFrame> frame, struct encoder_packet* packet, bool* received_packet);
 
+		/** Mark the faces tracked on the selected source, for encoders that spend more bits on such regions. */
+		void attach_regions_of_interest(AVFrame* frame);
+
+		/** Split codec headers and SEI out of a packet, or out of the extra data generated while opening. */
+		void extract_extra_data(uint8_t* data, std::size_t size);
+
+		/** Remember when OBS captured a frame, for the timecode of its packet.
+		 *
+		 * The capture time follows from the pts and the video time of the first frame, and is moved to the wall clock
+		 * by an offset taken once, so that neither the encoder queue nor clock adjustments add jitter to it.
+		 */
+		void capture_timecode(int64_t pts);
+
+		/** Insert the capture and encode times of the frame as an SEI in front of its picture. */
+		void embed_timecode(AVPacket& packet);
+
+		void track_latency(int64_t pts);
+
+		void track_packet(const AVPacket& packet);
+
+		/** Write the recorded per-packet statistics to the configured file as CSV, without blocking. */
+		void save_packet_statistics();
+
+		/** Write timing percentiles, queue depth, retry counts and throughput to the log. */
+		void log_statistics();
+
+		public: // Asynchronous Submission
+		void async_start();
+
+		void async_stop();
+
+		void async_work();
+
+		int async_receive_packet();
+
+		bool async_encode_avframe(std::shared_ptr<AVFrame> frame, struct encoder_packet* packet,
+								  bool* received_packet);
+
 		public: // Handler API
 		bool is_hardware_encode();
 
@@ -123,6 +331,19 @@ namespace streamfx::encoder::ffmpeg {
 
 		const AVCodecContext* get_avcodeccontext();
 
+		/** Submission statistics gathered so far, used by handlers to tune themselves. */
+		void get_submission_statistics(uint64_t& frames, uint64_t& eagain, uint64_t& max_depth, double_t& framerate);
+
+		/** Frames per second the encoder could sustain if it was fed continuously, or 0 if nothing was measured yet.
+		 *
+		 * Extrapolated from the frame rate since the warmup and the CPU time the process used for it, so anything else
+		 * running in OBS lowers the estimate.
+		 */
+		double_t get_encode_capacity();
+
+		/** Like get_encode_capacity(), but includes the time spent copying and converting frames beforehand. */
+		double_t get_pipeline_capacity();
+
 		void parse_ffmpeg_commandline(std::string text);
 	};
 
@@ -159,6 +380,12 @@ namespace streamfx::encoder::ffmpeg {
 		std::map<const AVCodec*, std::shared_ptr<ffmpeg_factory>> _factories;
 		std::map<std::string, std::shared_ptr<handler::handler>>  _handlers;
 		std::shared_ptr<handler::handler>                         _debug_handler;
+		std::map<std::string, std::weak_ptr<ffmpeg_group>>        _groups;
+		std::mutex                                                _groups_lock;
+		std::map<std::pair<int64_t, int64_t>, std::size_t>        _adapter_sessions;
+		std::mutex                                                _adapter_sessions_lock;
+		std::list<std::shared_ptr<ffmpeg_session>>                _sessions;
+		std::mutex                                                _sessions_lock;
 
 		public:
 		ffmpeg_manager();
@@ -172,6 +399,39 @@ namespace streamfx::encoder::ffmpeg {
 
 		bool has_handler(std::string codec);
 
+		/** Find or create the conversion group with this name.
+		 *
+		 * Throws if the group already exists but was created for a different input.
+		 */
+		std::shared_ptr<ffmpeg_group> get_group(std::string name, uint32_t width, uint32_t height, AVPixelFormat format,
+												AVColorSpace colorspace, bool full_range);
+
+		/** Count a hardware encoder session on an adapter.
+		 *
+		 * Throws if the adapter already has limit sessions, unless limit is 0. The error keeps OBS from rerouting to
+		 * the system memory encoder, which would open an uncounted session on the same hardware.
+		 */
+		void acquire_adapter(std::pair<int64_t, int64_t> id, std::size_t limit = 0);
+
+		void release_adapter(std::pair<int64_t, int64_t> id);
+
+		/** Pick and acquire the adapter with the fewest sessions, counting OBS's render adapter as already busy.
+		 *
+		 * Adapters that already have limit sessions are skipped, unless limit is 0.
+		 */
+		::streamfx::ffmpeg::hwapi::device
+			acquire_least_used_adapter(std::list<::streamfx::ffmpeg::hwapi::device> adapters,
+									   std::pair<int64_t, int64_t> obs_adapter, std::size_t limit = 0);
+
+		/** Keep the hardware of a closed encoder until it expires, replacing any older session with the same key. */
+		void store_session(std::shared_ptr<ffmpeg_session> session);
+
+		/** Remove and return the session stored under this key, or nullptr if there is none. */
+		std::shared_ptr<ffmpeg_session> take_session(std::string key);
+
+		private:
+		static void tick(void* ptr, float_t seconds) noexcept;
+
 		public: // Singleton
 		static void initialize();
 
@@ -54,6 +54,8 @@ extern "C" {
 #define ST_I18N_OTHER_ENFORCEHRD ST_I18N_OTHER ".EnforceHRD"
 #define ST_I18N_OTHER_VBAQ ST_I18N_OTHER ".VBAQ"
 #define ST_I18N_OTHER_ACCESSUNITDELIMITER ST_I18N_OTHER ".AccessUnitDelimiter"
+#define ST_I18N_OTHER_LOWLATENCY ST_I18N_OTHER ".LowLatency"
+#define ST_I18N_OTHER_INTRAREFRESH ST_I18N_OTHER ".IntraRefresh"
 
 // Settings
 #define ST_KEY_PRESET "Preset"
@@ -72,6 +74,11 @@ extern "C" {
 #define ST_KEY_OTHER_ENFORCEHRD "Other.EnforceHRD"
 #define ST_KEY_OTHER_VBAQ "Other.VBAQ"
 #define ST_KEY_OTHER_ACCESSUNITDELIMITER "Other.AccessUnitDelimiter"
+#define ST_KEY_OTHER_LOWLATENCY "Other.LowLatency"
+#define ST_KEY_OTHER_INTRAREFRESH "Other.IntraRefresh"
+
+// AMF picks this many reference frames if none are requested.
+#define ST_DEFAULT_REFERENCEFRAMES 4
 
 using namespace streamfx::encoder::ffmpeg::handler;
 
@@ -146,6 +153,8 @@ void amf::get_defaults(obs_data_t* settings, const AVCodec* codec, AVCodecContex
 	obs_data_set_default_int(settings, ST_KEY_OTHER_ENFORCEHRD, -1);
 	obs_data_set_default_int(settings, ST_KEY_OTHER_VBAQ, -1);
 	obs_data_set_default_int(settings, ST_KEY_OTHER_ACCESSUNITDELIMITER, -1);
+	obs_data_set_default_int(settings, ST_KEY_OTHER_LOWLATENCY, -1);
+	obs_data_set_default_int(settings, ST_KEY_OTHER_INTRAREFRESH, 0);
 
 	// Replay Buffer
 	obs_data_set_default_int(settings, "bitrate", 0);
@@ -279,6 +288,13 @@ void amf::get_properties_post(obs_properties_t* props, const AVCodec* codec)
 		streamfx::util::obs_properties_add_tristate(grp, ST_KEY_OTHER_VBAQ, D_TRANSLATE(ST_I18N_OTHER_VBAQ));
 		streamfx::util::obs_properties_add_tristate(grp, ST_KEY_OTHER_ACCESSUNITDELIMITER,
 													D_TRANSLATE(ST_I18N_OTHER_ACCESSUNITDELIMITER));
+		streamfx::util::obs_properties_add_tristate(grp, ST_KEY_OTHER_LOWLATENCY,
+													D_TRANSLATE(ST_I18N_OTHER_LOWLATENCY));
+		if (std::string_view("amf_h264") == codec->name) {
+			auto p = obs_properties_add_int_slider(grp, ST_KEY_OTHER_INTRAREFRESH,
+												   D_TRANSLATE(ST_I18N_OTHER_INTRAREFRESH), 0, 600, 1);
+			obs_property_int_set_suffix(p, " frames");
+		}
 	}
 }
 
@@ -420,6 +436,21 @@ void amf::update(obs_data_t* settings, const AVCodec* codec, AVCodecContext* con
 			av_opt_set_int(context->priv_data, "aud", v, AV_OPT_SEARCH_CHILDREN);
 		}
 
+		// Low Latency (Submit and return every frame immediately instead of batching them)
+		if (int64_t v = obs_data_get_int(settings, ST_KEY_OTHER_LOWLATENCY); !streamfx::util::is_tristate_default(v)) {
+			av_opt_set_int(context->priv_data, "latency", v, AV_OPT_SEARCH_CHILDREN);
+		}
+
+		// Intra Refresh (Spread the key frame over the period instead of sending periodic IDR frames)
+		if (int64_t v = obs_data_get_int(settings, ST_KEY_OTHER_INTRAREFRESH);
+			(v > 0) && (std::string_view("amf_h264") == codec->name)) {
+			// AMF refreshes a number of macroblocks per frame, so divide the picture over the period. Only the
+			// very first frame is an IDR frame, which is also where get_extra_data() finds the headers.
+			int64_t mbs = ((context->width + 15) / 16) * ((context->height + 15) / 16);
+			av_opt_set_int(context->priv_data, "intra_refresh_mb", (mbs + v - 1) / v, AV_OPT_SEARCH_CHILDREN);
+			av_opt_set_int(context->priv_data, "gops_per_idr", 0, AV_OPT_SEARCH_CHILDREN);
+		}
+
 		av_opt_set_int(context->priv_data, "me_half_pel", 1, AV_OPT_SEARCH_CHILDREN);
 		av_opt_set_int(context->priv_data, "me_quarter_pel", 1, AV_OPT_SEARCH_CHILDREN);
 	}
@@ -436,7 +467,7 @@ void amf::log_options(obs_data_t* settings, const AVCodec* codec, AVCodecContext
 								   [](int64_t v, std::string_view o) { return std::string(o); });
 	tools::print_av_option_string2(context, "rc", "    Rate Control",
 								   [](int64_t v, std::string_view o) { return std::string(o); });
-	tools::print_av_option_bool(context, "preanalysis", "      Look-Ahead");
+	tools::print_av_option_bool(context, "preanalysis", "      Pre-Analysis");
 	if (std::string_view("amf_h264") == codec->name) {
 		tools::print_av_option_bool(context, "frame_skipping", "      Frame Skipping");
 	} else {
@@ -468,6 +499,45 @@ void amf::log_options(obs_data_t* settings, const AVCodec* codec, AVCodecContext
 	tools::print_av_option_int(context, "max_au_size", "        Maximum Size", "");
 	tools::print_av_option_bool(context, "me_half_pel", "      Half-Pel Motion Estimation");
 	tools::print_av_option_bool(context, "me_quarter_pel", "      Quarter-Pel Motion Estimation");
+	tools::print_av_option_bool(context, "latency", "      Low Latency");
+	if (std::string_view("amf_h264") == codec->name) {
+		tools::print_av_option_int(context, "intra_refresh_mb", "      Intra Refresh", "Macroblocks");
+		tools::print_av_option_int(context, "gops_per_idr", "        GOPs per IDR", "");
+	}
+
+	DLOG_INFO("[%s]     Estimated Video Memory: %.2f MiB", codec->name,
+			  static_cast<double_t>(estimate_vram(context)) / (1024.0 * 1024.0));
+}
+
+uint64_t amf::estimate_vram(AVCodecContext* context)
+{
+	// Surfaces are padded to whole coding blocks.
+	uint64_t width  = (static_cast<uint64_t>(context->width) + 63) & ~63ull;
+	uint64_t height = (static_cast<uint64_t>(context->height) + 63) & ~63ull;
+
+	// 4:2:0 with 8 or 10 (stored as 16) bits per sample.
+	AVPixelFormat format = (context->sw_pix_fmt != AV_PIX_FMT_NONE) ? context->sw_pix_fmt : context->pix_fmt;
+	uint64_t      depth  = ((format == AV_PIX_FMT_P010) || (format == AV_PIX_FMT_YUV420P10)) ? 2 : 1;
+	uint64_t      frame  = width * height * depth * 3 / 2;
+
+	// References, B-Frames, the reconstructed picture and the input surface.
+	uint64_t frames = static_cast<uint64_t>((context->refs > 0) ? context->refs : ST_DEFAULT_REFERENCEFRAMES)
+					  + static_cast<uint64_t>(std::max<int>(context->max_b_frames, 0)) + 2;
+
+	// Pre-analysis keeps another copy of the input around.
+	int64_t preanalysis = 0;
+	av_opt_get_int(context->priv_data, "preanalysis", AV_OPT_SEARCH_CHILDREN, &preanalysis);
+	if (preanalysis > 0) {
+		frames++;
+	}
+
+	// The bitstream buffer is sized after the rate control buffer, or half a frame if there is none.
+	uint64_t bitstream = frame / 2;
+	if (context->rc_buffer_size > 0) {
+		bitstream = static_cast<uint64_t>(context->rc_buffer_size) / 8;
+	}
+
+	return (frames * frame) + bitstream;
 }
 
 void streamfx::encoder::ffmpeg::handler::amf::get_runtime_properties(obs_properties_t* props, const AVCodec* codec,
@@ -76,6 +76,9 @@ namespace streamfx::encoder::ffmpeg::handler::amf {
 
 	void log_options(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context);
 
+	/** Rough amount of video memory a session with these options occupies, in bytes. */
+	uint64_t estimate_vram(AVCodecContext* context);
+
 } // namespace streamfx::encoder::ffmpeg::handler::amf
 
 /* Parameters by their codec specific name.
@@ -72,6 +72,15 @@ namespace streamfx::encoder::ffmpeg {
 
 			virtual void override_update(ffmpeg_instance* instance, obs_data_t* settings){};
 
+			/** Apply settings changed while encoding to the open encoder, on the thread that submits frames.
+			 *
+			 * @return true if the encoder picks up the changes without being reopened.
+			 */
+			virtual bool reconfigure(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context)
+			{
+				return false;
+			};
+
 			virtual void log_options(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context){};
 
 			public /*instance*/:
@@ -80,6 +89,8 @@ namespace streamfx::encoder::ffmpeg {
 											  AVCodecContext* context){};
 
 			virtual void process_avpacket(AVPacket& packet, const AVCodec* codec, AVCodecContext* context){};
+
+			virtual void process_statistics(ffmpeg_instance* instance, obs_data_t* settings){};
 		};
 	} // namespace handler
 } // namespace streamfx::encoder::ffmpeg
@@ -0,0 +1,72 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2022 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "null_handler.hpp"
+#include "../encoder-ffmpeg.hpp"
+#include "plugin.hpp"
+
+extern "C" {
+#include <obs-module.h>
+}
+
+using namespace streamfx::encoder::ffmpeg::handler;
+
+void null_handler::adjust_info(ffmpeg_factory* factory, const AVCodec*, std::string&, std::string& name,
+							   std::string&)
+{
+	name = "StreamFX Pipeline Benchmark (no encoding)";
+}
+
+bool null_handler::has_keyframe_support(ffmpeg_factory*)
+{
+	return false; // Every packet is a "key frame" already.
+}
+
+void null_handler::process_avpacket(AVPacket& packet, const AVCodec*, AVCodecContext*)
+{
+	// The packet holds a reference to the submitted frame. Let go of it right away, so that frames return to the pool
+	// as quickly as they do with a real encoder, and nothing but an empty packet reaches OBS.
+	int64_t pts   = packet.pts;
+	int64_t dts   = packet.dts;
+	int     flags = packet.flags;
+	av_packet_unref(&packet);
+	av_new_packet(&packet, 0);
+	packet.pts   = pts;
+	packet.dts   = dts;
+	packet.flags = flags;
+}
+
+void null_handler::process_statistics(ffmpeg_instance* instance, obs_data_t*)
+{
+	const AVCodecContext* context = instance->get_avcodeccontext();
+
+	uint64_t frames    = 0;
+	uint64_t eagain    = 0;
+	uint64_t depth     = 0;
+	double_t framerate = 0;
+	instance->get_submission_statistics(frames, eagain, depth, framerate);
+
+	double_t target = static_cast<double_t>(context->time_base.den) / static_cast<double_t>(context->time_base.num);
+	DLOG_INFO("[%s] Pipeline ran at %.2f of %.2f FPS and could sustain up to %.2f FPS at %" PRId32 "x%" PRId32
+			  ", the full breakdown is logged once encoding stops.",
+			  instance->get_avcodec()->name, framerate, target, instance->get_pipeline_capacity(), context->width,
+			  context->height);
+}
@@ -0,0 +1,47 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2022 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include "handler.hpp"
+
+namespace streamfx::encoder::ffmpeg::handler {
+	/** Turns FFmpeg's wrapped_avframe into a null encoder.
+	 *
+	 * Frames take the full path through copying, conversion and submission, but every packet comes out empty, so
+	 * the statistics show the cost of StreamFX's own pipeline without any actual encoding.
+	 */
+	class null_handler : public handler {
+		public:
+		virtual ~null_handler(){};
+
+		public /*factory*/:
+		void adjust_info(ffmpeg_factory* factory, const AVCodec* codec, std::string& id, std::string& name,
+						 std::string& codec_id) override;
+
+		public /*support tests*/:
+		bool has_keyframe_support(ffmpeg_factory* instance) override;
+
+		public /*instance*/:
+		void process_avpacket(AVPacket& packet, const AVCodec* codec, AVCodecContext* context) override;
+
+		void process_statistics(ffmpeg_instance* instance, obs_data_t* settings) override;
+	};
+} // namespace streamfx::encoder::ffmpeg::handler
@@ -0,0 +1,188 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2019 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "nvenc_av1_handler.hpp"
+#include "strings.hpp"
+#include "../codecs/av1.hpp"
+#include "../encoder-ffmpeg.hpp"
+#include "ffmpeg/tools.hpp"
+#include "nvenc_shared.hpp"
+#include "plugin.hpp"
+
+extern "C" {
+#include <obs-module.h>
+#pragma warning(push)
+#pragma warning(disable : 4242 4244 4365)
+#include <libavutil/opt.h>
+#pragma warning(pop)
+}
+
+#define ST_KEY_TIER "AV1.Tier"
+#define ST_KEY_LEVEL "AV1.Level"
+
+using namespace streamfx::encoder::ffmpeg::handler;
+using namespace streamfx::encoder::codec::av1;
+
+static std::map<tier, std::string> tiers{
+	{tier::MAIN, "main"},
+	{tier::HIGH, "high"},
+};
+
+static std::map<level, std::string> levels{
+	{level::L2_0, "2.0"}, {level::L2_1, "2.1"}, {level::L3_0, "3.0"}, {level::L3_1, "3.1"}, {level::L4_0, "4.0"},
+	{level::L4_1, "4.1"}, {level::L5_0, "5.0"}, {level::L5_1, "5.1"}, {level::L5_2, "5.2"}, {level::L5_3, "5.3"},
+	{level::L6_0, "6.0"}, {level::L6_1, "6.1"}, {level::L6_2, "6.2"}, {level::L6_3, "6.3"},
+};
+
+void nvenc_av1_handler::adjust_info(ffmpeg_factory* fac, const AVCodec*, std::string&, std::string& name, std::string&)
+{
+	name = "NVIDIA NVENC AV1 (via FFmpeg)";
+	if (!nvenc::is_available())
+		fac->get_info()->caps |= OBS_ENCODER_CAP_DEPRECATED;
+}
+
+void nvenc_av1_handler::get_defaults(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context, bool)
+{
+	nvenc::get_defaults(settings, codec, context);
+
+	obs_data_set_default_int(settings, ST_KEY_TIER, static_cast<int64_t>(tier::MAIN));
+	obs_data_set_default_int(settings, ST_KEY_LEVEL, static_cast<int64_t>(level::UNKNOWN));
+}
+
+bool nvenc_av1_handler::has_keyframe_support(ffmpeg_factory*)
+{
+	return true;
+}
+
+bool nvenc_av1_handler::is_hardware_encoder(ffmpeg_factory* instance)
+{
+	return true;
+}
+
+bool nvenc_av1_handler::has_threading_support(ffmpeg_factory* instance)
+{
+	return false;
+}
+
+bool nvenc_av1_handler::has_pixel_format_support(ffmpeg_factory* instance)
+{
+	return true;
+}
+
+void nvenc_av1_handler::get_properties(obs_properties_t* props, const AVCodec* codec, AVCodecContext* context, bool)
+{
+	if (!context) {
+		this->get_encoder_properties(props, codec);
+	} else {
+		this->get_runtime_properties(props, codec, context);
+	}
+}
+
+void nvenc_av1_handler::update(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context)
+{
+	nvenc::update(settings, codec, context);
+
+	{ // AV1 Options
+		auto found = tiers.find(static_cast<tier>(obs_data_get_int(settings, ST_KEY_TIER)));
+		if (found != tiers.end()) {
+			// The option takes the seq_tier bit, its named values are just "0" and "1".
+			av_opt_set_int(context->priv_data, "tier", static_cast<int64_t>(found->first), 0);
+		}
+	}
+	{
+		auto found = levels.find(static_cast<level>(obs_data_get_int(settings, ST_KEY_LEVEL)));
+		if (found != levels.end()) {
+			av_opt_set(context->priv_data, "level", found->second.c_str(), 0);
+		} else {
+			av_opt_set(context->priv_data, "level", "auto", 0);
+		}
+	}
+}
+
+void nvenc_av1_handler::override_update(ffmpeg_instance* instance, obs_data_t* settings)
+{
+	nvenc::override_update(instance, settings);
+}
+
+bool nvenc_av1_handler::reconfigure(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context)
+{
+	return nvenc::reconfigure(settings, codec, context);
+}
+
+void nvenc_av1_handler::process_statistics(ffmpeg_instance* instance, obs_data_t* settings)
+{
+	nvenc::process_statistics(instance, settings);
+}
+
+void nvenc_av1_handler::log_options(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context)
+{
+	nvenc::log_options(settings, codec, context);
+
+	DLOG_INFO("[%s]     AV1:", codec->name);
+	::streamfx::ffmpeg::tools::print_av_option_string2(context, "level", "      Level",
+													   [](int64_t v, std::string_view o) { return std::string(o); });
+	::streamfx::ffmpeg::tools::print_av_option_string2(context, "tier", "      Tier",
+													   [](int64_t v, std::string_view o) { return std::string(o); });
+}
+
+void nvenc_av1_handler::get_encoder_properties(obs_properties_t* props, const AVCodec* codec)
+{
+	nvenc::get_properties_pre(props, codec);
+
+	{
+		obs_properties_t* grp = props;
+		if (!streamfx::util::are_property_groups_broken()) {
+			grp = obs_properties_create();
+			obs_properties_add_group(props, S_CODEC_AV1, D_TRANSLATE(S_CODEC_AV1), OBS_GROUP_NORMAL, grp);
+		}
+
+		{
+			auto p = obs_properties_add_list(grp, ST_KEY_TIER, D_TRANSLATE(S_CODEC_AV1_TIER), OBS_COMBO_TYPE_LIST,
+											 OBS_COMBO_FORMAT_INT);
+			obs_property_list_add_int(p, D_TRANSLATE(S_STATE_DEFAULT), static_cast<int64_t>(tier::UNKNOWN));
+			for (auto const kv : tiers) {
+				std::string trans = std::string(S_CODEC_AV1_TIER) + "." + kv.second;
+				obs_property_list_add_int(p, D_TRANSLATE(trans.c_str()), static_cast<int64_t>(kv.first));
+			}
+		}
+		{
+			auto p = obs_properties_add_list(grp, ST_KEY_LEVEL, D_TRANSLATE(S_CODEC_AV1_LEVEL), OBS_COMBO_TYPE_LIST,
+											 OBS_COMBO_FORMAT_INT);
+			obs_property_list_add_int(p, D_TRANSLATE(S_STATE_AUTOMATIC), static_cast<int64_t>(level::UNKNOWN));
+			for (auto const kv : levels) {
+				obs_property_list_add_int(p, kv.second.c_str(), static_cast<int64_t>(kv.first));
+			}
+		}
+	}
+
+	nvenc::get_properties_post(props, codec);
+}
+
+void nvenc_av1_handler::get_runtime_properties(obs_properties_t* props, const AVCodec* codec, AVCodecContext* context)
+{
+	nvenc::get_runtime_properties(props, codec, context);
+}
+
+void streamfx::encoder::ffmpeg::handler::nvenc_av1_handler::migrate(obs_data_t* settings, uint64_t version,
+																	const AVCodec* codec, AVCodecContext* context)
+{
+	nvenc::migrate(settings, version, codec, context);
+}
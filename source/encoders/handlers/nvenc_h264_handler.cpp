@@ -129,6 +129,16 @@ void nvenc_h264_handler::override_update(ffmpeg_instance* instance, obs_data_t*
 	nvenc::override_update(instance, settings);
 }
 
+bool nvenc_h264_handler::reconfigure(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context)
+{
+	return nvenc::reconfigure(settings, codec, context);
+}
+
+void nvenc_h264_handler::process_statistics(ffmpeg_instance* instance, obs_data_t* settings)
+{
+	nvenc::process_statistics(instance, settings);
+}
+
 void nvenc_h264_handler::log_options(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context)
 {
 	nvenc::log_options(settings, codec, context);
@@ -64,8 +64,13 @@ namespace streamfx::encoder::ffmpeg::handler {
 
 		virtual void override_update(ffmpeg_instance* instance, obs_data_t* settings);
 
+		virtual bool reconfigure(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context) override;
+
 		virtual void log_options(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context);
 
+		public /*instance*/:
+		virtual void process_statistics(ffmpeg_instance* instance, obs_data_t* settings);
+
 		private:
 		void get_encoder_properties(obs_properties_t* props, const AVCodec* codec);
 
@@ -32,6 +32,7 @@ extern "C" {
 
 #define ST_I18N_PRESET "FFmpegEncoder.NVENC.Preset"
 #define ST_I18N_PRESET_(x) ST_I18N_PRESET "." D_VSTR(x)
+#define ST_I18N_LOWLATENCY "FFmpegEncoder.NVENC.LowLatency"
 #define ST_I18N_RATECONTROL "FFmpegEncoder.NVENC.RateControl"
 #define ST_I18N_RATECONTROL_MODE ST_I18N_RATECONTROL ".Mode"
 #define ST_I18N_RATECONTROL_MODE_(x) ST_I18N_RATECONTROL_MODE "." D_VSTR(x)
@@ -63,8 +64,11 @@ extern "C" {
 #define ST_I18N_OTHER_NONREFERENCEPFRAMES ST_I18N_OTHER ".NonReferencePFrames"
 #define ST_I18N_OTHER_ACCESSUNITDELIMITER ST_I18N_OTHER ".AccessUnitDelimiter"
 #define ST_I18N_OTHER_DECODEDPICTUREBUFFERSIZE ST_I18N_OTHER ".DecodedPictureBufferSize"
+#define ST_I18N_OTHER_INTRAREFRESH ST_I18N_OTHER ".IntraRefresh"
+#define ST_I18N_OTHER_SURFACES ST_I18N_OTHER ".Surfaces"
 
 #define ST_KEY_PRESET "Preset"
+#define ST_KEY_LOWLATENCY "LowLatency"
 #define ST_KEY_RATECONTROL_MODE "RateControl.Mode"
 #define ST_KEY_RATECONTROL_TWOPASS "RateControl.TwoPass"
 #define ST_KEY_RATECONTROL_LOOKAHEAD "RateControl.LookAhead"
@@ -89,6 +93,13 @@ extern "C" {
 #define ST_KEY_OTHER_NONREFERENCEPFRAMES "Other.NonReferencePFrames"
 #define ST_KEY_OTHER_ACCESSUNITDELIMITER "Other.AccessUnitDelimiter"
 #define ST_KEY_OTHER_DECODEDPICTUREBUFFERSIZE "Other.DecodedPictureBufferSize"
+#define ST_KEY_OTHER_INTRAREFRESH "Other.IntraRefresh"
+#define ST_KEY_OTHER_SURFACES "Other.Surfaces"
+#define ST_KEY_OTHER_SURFACES_ADAPTIVE "Other.Surfaces.Adaptive"
+
+// Limits for the adaptive surface count.
+#define ST_SURFACES_MAXIMUM 64
+#define ST_SURFACES_EAGAIN_PERCENT 1
 
 using namespace streamfx::encoder::ffmpeg::handler;
 
@@ -169,7 +180,7 @@ bool streamfx::encoder::ffmpeg::handler::nvenc::is_available()
 	}
 }
 
-void nvenc::override_update(ffmpeg_instance* instance, obs_data_t*)
+void nvenc::override_update(ffmpeg_instance* instance, obs_data_t* settings)
 {
 	AVCodecContext* context = const_cast<AVCodecContext*>(instance->get_avcodeccontext());
 
@@ -182,7 +193,10 @@ void nvenc::override_update(ffmpeg_instance* instance, obs_data_t*)
 	av_opt_get_int(context, "async_depth", AV_OPT_SEARCH_CHILDREN, &async_depth);
 
 	// Calculate and set the number of surfaces to allocate (if not user overridden).
-	if (surfaces == 0) {
+	if (int64_t manual = obs_data_get_int(settings, ST_KEY_OTHER_SURFACES); (surfaces == 0) && (manual > 0)) {
+		surfaces = manual;
+		av_opt_set_int(context, "surfaces", surfaces, AV_OPT_SEARCH_CHILDREN);
+	} else if (surfaces == 0) {
 		surfaces = std::max<int64_t>(4ll, (context->max_b_frames + 1ll) * 4ll);
 		if (rclookahead > 0) {
 			surfaces = std::max<int64_t>(1ll, std::max<int64_t>(surfaces, rclookahead + (context->max_b_frames + 5ll)));
@@ -192,16 +206,63 @@ void nvenc::override_update(ffmpeg_instance* instance, obs_data_t*)
 			surfaces = 4;
 		}
 
+		// Use what a previous session settled on, but never less than look ahead and B-Frames need.
+		if (int64_t adaptive = obs_data_get_int(settings, ST_KEY_OTHER_SURFACES_ADAPTIVE); adaptive > 0) {
+			surfaces = std::max<int64_t>(adaptive, rclookahead + context->max_b_frames + 2ll);
+		}
+
 		av_opt_set_int(context, "surfaces", surfaces, AV_OPT_SEARCH_CHILDREN);
 	}
 
 	// Set delay
-	context->delay = std::min<int>(std::max<int64_t>(async_depth, 3ll), surfaces - 1);
+	if (obs_data_get_bool(settings, ST_KEY_LOWLATENCY)) {
+		// Every packet is returned as soon as its frame is encoded, so nothing is held back.
+		context->delay = 0;
+	} else {
+		context->delay = std::min<int>(std::max<int64_t>(async_depth, 3ll), surfaces - 1);
+	}
+}
+
+void nvenc::process_statistics(ffmpeg_instance* instance, obs_data_t* settings)
+{
+	if (obs_data_get_int(settings, ST_KEY_OTHER_SURFACES) > 0) {
+		return; // Chosen by the user.
+	}
+
+	AVCodecContext* context  = const_cast<AVCodecContext*>(instance->get_avcodeccontext());
+	int64_t         surfaces = 0;
+	av_opt_get_int(context, "surfaces", AV_OPT_SEARCH_CHILDREN, &surfaces);
+
+	uint64_t frames    = 0;
+	uint64_t eagain    = 0;
+	uint64_t depth     = 0;
+	double_t framerate = 0;
+	instance->get_submission_statistics(frames, eagain, depth, framerate);
+	if ((frames == 0) || (surfaces <= 0)) {
+		return;
+	}
+
+	double_t target = static_cast<double_t>(context->time_base.den) / static_cast<double_t>(context->time_base.num);
+	int64_t  needed = 0;
+	if (((eagain * 100) > (frames * ST_SURFACES_EAGAIN_PERCENT)) || (framerate < (target * 0.95))) {
+		// The encoder ran out of surfaces to work with, so grow generously instead of creeping up over many sessions.
+		needed = surfaces + std::max<int64_t>(2ll, surfaces / 2);
+	} else {
+		// Everything kept up, so only keep what was actually in flight plus the one being filled.
+		needed = static_cast<int64_t>(depth) + 1;
+	}
+	needed = std::min<int64_t>(needed, ST_SURFACES_MAXIMUM);
+
+	DLOG_INFO("[%s] Adaptive Surfaces: %" PRId64 " allocated, %" PRIu64 " in flight, %" PRIu64 " of %" PRIu64
+			  " frames retried, %.2f of %.2f FPS. Using %" PRId64 " surfaces from now on.",
+			  instance->get_avcodec()->name, surfaces, depth, eagain, frames, framerate, target, needed);
+	obs_data_set_int(settings, ST_KEY_OTHER_SURFACES_ADAPTIVE, needed);
 }
 
 void nvenc::get_defaults(obs_data_t* settings, const AVCodec*, AVCodecContext*)
 {
 	obs_data_set_default_int(settings, ST_KEY_PRESET, static_cast<int64_t>(nvenc::preset::DEFAULT));
+	obs_data_set_default_bool(settings, ST_KEY_LOWLATENCY, false);
 
 	obs_data_set_default_int(settings, ST_KEY_RATECONTROL_MODE, static_cast<int64_t>(ratecontrolmode::CBR_HQ));
 	obs_data_set_default_int(settings, ST_KEY_RATECONTROL_TWOPASS, -1);
@@ -231,6 +292,9 @@ void nvenc::get_defaults(obs_data_t* settings, const AVCodec*, AVCodecContext*)
 	obs_data_set_default_int(settings, ST_KEY_OTHER_NONREFERENCEPFRAMES, -1);
 	obs_data_set_default_int(settings, ST_KEY_OTHER_ACCESSUNITDELIMITER, -1);
 	obs_data_set_default_int(settings, ST_KEY_OTHER_DECODEDPICTUREBUFFERSIZE, -1);
+	obs_data_set_default_int(settings, ST_KEY_OTHER_INTRAREFRESH, 0);
+	obs_data_set_default_int(settings, ST_KEY_OTHER_SURFACES, -1);
+	obs_data_set_default_int(settings, ST_KEY_OTHER_SURFACES_ADAPTIVE, 0);
 
 	// Replay Buffer
 	obs_data_set_default_int(settings, "bitrate", 0);
@@ -280,6 +344,18 @@ static bool modified_ratecontrol(obs_properties_t* props, obs_property_t*, obs_d
 	return true;
 }
 
+static bool modified_lowlatency(obs_properties_t* props, obs_property_t*, obs_data_t* settings) noexcept
+{
+	// These are all pinned by the low latency profile, so hide them instead of silently ignoring them.
+	bool editable = !obs_data_get_bool(settings, ST_KEY_LOWLATENCY);
+	obs_property_set_visible(obs_properties_get(props, ST_KEY_RATECONTROL_LOOKAHEAD), editable);
+	obs_property_set_visible(obs_properties_get(props, ST_KEY_RATECONTROL_ADAPTIVEB), editable);
+	obs_property_set_visible(obs_properties_get(props, ST_KEY_OTHER_BFRAMES), editable);
+	obs_property_set_visible(obs_properties_get(props, ST_KEY_OTHER_BFRAMEREFERENCEMODE), editable);
+	obs_property_set_visible(obs_properties_get(props, ST_KEY_OTHER_ZEROLATENCY), editable);
+	return true;
+}
+
 static bool modified_aq(obs_properties_t* props, obs_property_t*, obs_data_t* settings) noexcept
 {
 	bool spatial_aq = streamfx::util::is_tristate_enabled(obs_data_get_int(settings, ST_KEY_AQ_SPATIAL));
@@ -294,6 +370,11 @@ void nvenc::get_properties_pre(obs_properties_t* props, const AVCodec*)
 	for (auto kv : presets) {
 		obs_property_list_add_int(p, D_TRANSLATE(kv.second.c_str()), static_cast<int64_t>(kv.first));
 	}
+
+	{
+		auto p = obs_properties_add_bool(props, ST_KEY_LOWLATENCY, D_TRANSLATE(ST_I18N_LOWLATENCY));
+		obs_property_set_modified_callback(p, modified_lowlatency);
+	}
 }
 
 void nvenc::get_properties_post(obs_properties_t* props, const AVCodec* codec)
@@ -477,12 +558,25 @@ void nvenc::get_properties_post(obs_properties_t* props, const AVCodec* codec)
 												   D_TRANSLATE(ST_I18N_OTHER_DECODEDPICTUREBUFFERSIZE), -1, 16, 1);
 			obs_property_int_set_suffix(p, " frames");
 		}
+
+		{
+			auto p = obs_properties_add_int_slider(grp, ST_KEY_OTHER_INTRAREFRESH,
+												   D_TRANSLATE(ST_I18N_OTHER_INTRAREFRESH), 0, 600, 1);
+			obs_property_int_set_suffix(p, " frames");
+		}
+
+		{
+			auto p = obs_properties_add_int_slider(grp, ST_KEY_OTHER_SURFACES, D_TRANSLATE(ST_I18N_OTHER_SURFACES), -1,
+												   ST_SURFACES_MAXIMUM, 1);
+			obs_property_int_set_suffix(p, " frames");
+		}
 	}
 }
 
 void nvenc::get_runtime_properties(obs_properties_t* props, const AVCodec*, AVCodecContext*)
 {
 	obs_property_set_enabled(obs_properties_get(props, ST_KEY_PRESET), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_LOWLATENCY), false);
 	obs_property_set_enabled(obs_properties_get(props, ST_I18N_RATECONTROL), false);
 	obs_property_set_enabled(obs_properties_get(props, ST_KEY_RATECONTROL_MODE), false);
 	obs_property_set_enabled(obs_properties_get(props, ST_KEY_RATECONTROL_TWOPASS), false);
@@ -512,6 +606,8 @@ void nvenc::get_runtime_properties(obs_properties_t* props, const AVCodec*, AVCo
 	obs_property_set_enabled(obs_properties_get(props, ST_KEY_OTHER_NONREFERENCEPFRAMES), false);
 	obs_property_set_enabled(obs_properties_get(props, ST_KEY_OTHER_ACCESSUNITDELIMITER), false);
 	obs_property_set_enabled(obs_properties_get(props, ST_KEY_OTHER_DECODEDPICTUREBUFFERSIZE), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_OTHER_INTRAREFRESH), false);
+	obs_property_set_enabled(obs_properties_get(props, ST_KEY_OTHER_SURFACES), false);
 }
 
 void nvenc::update(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context)
@@ -679,6 +775,15 @@ void nvenc::update(obs_data_t* settings, const AVCodec* codec, AVCodecContext* c
 		if (int64_t v = obs_data_get_int(settings, ST_KEY_OTHER_DECODEDPICTUREBUFFERSIZE); v > -1)
 			av_opt_set_int(context->priv_data, "dpb_size", v, AV_OPT_SEARCH_CHILDREN);
 
+		// Intra Refresh (Spread the key frame over the period instead of sending periodic IDR frames)
+		if (int64_t v = obs_data_get_int(settings, ST_KEY_OTHER_INTRAREFRESH); v > 0) {
+			// FFmpeg uses the GOP size as the refresh period and switches to an infinite GOP on its own. Only the
+			// very first frame is an IDR frame, which is also where get_extra_data() finds the headers.
+			av_opt_set_int(context->priv_data, "intra-refresh", 1, AV_OPT_SEARCH_CHILDREN);
+			context->gop_size   = static_cast<int>(v);
+			context->keyint_min = context->gop_size;
+		}
+
 		int64_t wp = obs_data_get_int(settings, ST_KEY_OTHER_WEIGHTEDPREDICTION);
 		if ((context->max_b_frames > 0) && streamfx::util::is_tristate_enabled(wp)) {
 			DLOG_WARNING("[%s] Weighted Prediction disabled because of B-Frames being used.", codec->name);
@@ -695,15 +800,57 @@ void nvenc::update(obs_data_t* settings, const AVCodec* codec, AVCodecContext* c
 			}
 		}
 	}
+
+	if (obs_data_get_bool(settings, ST_KEY_LOWLATENCY)) {
+		// Anything that makes NVENC wait for future frames adds at least one frame of latency, so turn it all off.
+		context->max_b_frames = 0;
+		av_opt_set_int(context->priv_data, "rc-lookahead", 0, AV_OPT_SEARCH_CHILDREN);
+		av_opt_set_int(context->priv_data, "zerolatency", 1, AV_OPT_SEARCH_CHILDREN);
+		av_opt_set(context->priv_data, "b_ref_mode", "disabled", AV_OPT_SEARCH_CHILDREN);
+		if (strcmp(codec->name, "h264_nvenc") == 0) {
+			av_opt_set_int(context->priv_data, "b_adapt", 0, AV_OPT_SEARCH_CHILDREN);
+		}
+
+		// Return every packet as soon as it is done instead of keeping a queue of surfaces in flight.
+		av_opt_set_int(context->priv_data, "delay", 0, AV_OPT_SEARCH_CHILDREN);
+	}
+}
+
+bool nvenc::reconfigure(obs_data_t* settings, const AVCodec*, AVCodecContext* context)
+{
+	// The rate control mode is fixed for the session, so only the limits it already uses can change. FFmpeg
+	// reconfigures NVENC whenever they differ from the active ones, provided the GPU supports dynamic bitrate.
+	if (context->bit_rate <= 0) {
+		return false;
+	}
+
+	if (int64_t v = obs_data_get_int(settings, ST_KEY_RATECONTROL_LIMITS_BITRATE_TARGET); v > -1) {
+		context->bit_rate = static_cast<int>(v * 1000);
+
+		// Support for Replay Buffer
+		obs_data_set_int(settings, "bitrate", v);
+	}
+	if (context->rc_max_rate > 0) {
+		if (int64_t v = obs_data_get_int(settings, ST_KEY_RATECONTROL_LIMITS_BITRATE_MAXIMUM); v > 0)
+			context->rc_max_rate = static_cast<int>(v * 1000);
+	}
+	if (context->rc_buffer_size > 0) {
+		if (int64_t v = obs_data_get_int(settings, ST_KEY_RATECONTROL_LIMITS_BUFFERSIZE); v > 0)
+			context->rc_buffer_size = static_cast<int>(v * 1000);
+	}
+
+	return true;
 }
 
-void nvenc::log_options(obs_data_t*, const AVCodec* codec, AVCodecContext* context)
+void nvenc::log_options(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context)
 {
 	using namespace ::streamfx::ffmpeg;
 
 	DLOG_INFO("[%s]   NVIDIA NVENC:", codec->name);
 	tools::print_av_option_string2(context, "preset", "    Preset",
 								   [](int64_t v, std::string_view o) { return std::string(o); });
+	DLOG_INFO("[%s]     Low Latency: %s", codec->name,
+			  obs_data_get_bool(settings, ST_KEY_LOWLATENCY) ? "Enabled" : "Disabled");
 	tools::print_av_option_string2(context, "rc", "    Rate Control",
 								   [](int64_t v, std::string_view o) { return std::string(o); });
 	tools::print_av_option_bool(context, "2pass", "      Two Pass");
@@ -747,10 +894,12 @@ void nvenc::log_options(obs_data_t*, const AVCodec* codec, AVCodecContext* conte
 	tools::print_av_option_bool(context, "nonref_p", "      Non-reference P-Frames");
 	tools::print_av_option_bool(context, "strict_gop", "      Strict GOP");
 	tools::print_av_option_bool(context, "aud", "      Access Unit Delimiters");
+	tools::print_av_option_bool(context, "intra-refresh", "      Intra Refresh");
 	tools::print_av_option_bool(context, "bluray-compat", "      Bluray Compatibility");
 	if (strcmp(codec->name, "h264_nvenc") == 0)
 		tools::print_av_option_bool(context, "a53cc", "      A53 Closed Captions");
 	tools::print_av_option_int(context, "dpb_size", "      DPB Size", "Frames");
+	tools::print_av_option_int(context, "delay", "      Delay", "Frames");
 }
 
 void streamfx::encoder::ffmpeg::handler::nvenc::migrate(obs_data_t* settings, uint64_t version, const AVCodec* codec,
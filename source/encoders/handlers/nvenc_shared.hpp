@@ -94,6 +94,9 @@ namespace streamfx::encoder::ffmpeg::handler::nvenc {
 
 	void override_update(ffmpeg_instance* instance, obs_data_t* settings);
 
+	/** Pick the smallest surface count that kept up with the frame rate, for use by the next session. */
+	void process_statistics(ffmpeg_instance* instance, obs_data_t* settings);
+
 	void get_defaults(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context);
 
 	void get_properties_pre(obs_properties_t* props, const AVCodec* codec);
@@ -106,5 +109,8 @@ namespace streamfx::encoder::ffmpeg::handler::nvenc {
 
 	void update(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context);
 
+	/** Change the bitrate limits of the running session, which FFmpeg forwards to NVENC with the next frame. */
+	bool reconfigure(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context);
+
 	void log_options(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context);
 } // namespace streamfx::encoder::ffmpeg::handler::nvenc
@@ -21,7 +21,9 @@
 
 #include "prores_aw_handler.hpp"
 #include <array>
+#include <thread>
 #include "../codecs/prores.hpp"
+#include "../encoder-ffmpeg.hpp"
 #include "ffmpeg/tools.hpp"
 #include "plugin.hpp"
 
@@ -29,6 +31,15 @@ extern "C" {
 #include <obs-module.h>
 }
 
+#define ST_I18N_PARALLELFRAMES "FFmpegEncoder.ProRes.ParallelFrames"
+#define ST_KEY_PARALLELFRAMES "ProRes.ParallelFrames"
+
+// Shared with the FFmpeg encoder, 0 means the thread count is left to us.
+#define ST_KEY_FFMPEG_THREADS "FFmpeg.Threads"
+
+// Every frame thread holds its own input and output frame, so keep all of them within this budget.
+#define ST_PARALLELFRAMES_MEMORY_BUDGET (1024ull * 1024ull * 1024ull)
+
 using namespace streamfx::encoder::ffmpeg::handler;
 using namespace streamfx::encoder::codec::prores;
 
@@ -54,6 +65,7 @@ void prores_aw_handler::override_colorformat(AVPixelFormat& target_format, obs_d
 void prores_aw_handler::get_defaults(obs_data_t* settings, const AVCodec*, AVCodecContext*, bool)
 {
 	obs_data_set_default_int(settings, S_CODEC_PRORES_PROFILE, 0);
+	obs_data_set_default_bool(settings, ST_KEY_PARALLELFRAMES, true);
 }
 
 bool prores_aw_handler::has_pixel_format_support(ffmpeg_factory* instance)
@@ -89,8 +101,10 @@ void prores_aw_handler::get_properties(obs_properties_t* props, const AVCodec* c
 		for (auto ptr = codec->profiles; ptr->profile != FF_PROFILE_UNKNOWN; ptr++) {
 			obs_property_list_add_int(p, profile_to_name(ptr), static_cast<int64_t>(ptr->profile));
 		}
+		obs_properties_add_bool(props, ST_KEY_PARALLELFRAMES, D_TRANSLATE(ST_I18N_PARALLELFRAMES));
 	} else {
 		obs_property_set_enabled(obs_properties_get(props, S_CODEC_PRORES_PROFILE), false);
+		obs_property_set_enabled(obs_properties_get(props, ST_KEY_PARALLELFRAMES), false);
 	}
 }
 
@@ -113,6 +127,32 @@ void prores_aw_handler::log_options(obs_data_t* settings, const AVCodec* codec,
 	});
 }
 
+void prores_aw_handler::override_update(ffmpeg_instance* instance, obs_data_t* settings)
+{
+	AVCodecContext* context = const_cast<AVCodecContext*>(instance->get_avcodeccontext());
+
+	if (!obs_data_get_bool(settings, ST_KEY_PARALLELFRAMES)) {
+		// One frame at a time, so packets come out as soon as their frame is done.
+		context->thread_type  = 0;
+		context->thread_count = 1;
+		context->delay        = 0;
+		return;
+	} else if (obs_data_get_int(settings, ST_KEY_FFMPEG_THREADS) != 0) {
+		return; // Chosen by the user.
+	}
+
+	// ProRes is intra-only, so every frame is encoded independently and frame threads scale with the core count,
+	// until the frames they hold on to no longer fit. 4:4:4 at 16 bits per sample is the worst case.
+	uint64_t frame   = static_cast<uint64_t>(context->width) * static_cast<uint64_t>(context->height) * 3 * 2 * 2;
+	uint64_t fit     = std::max<uint64_t>(1, ST_PARALLELFRAMES_MEMORY_BUDGET / std::max<uint64_t>(frame, 1));
+	uint64_t cores   = std::max<uint64_t>(1, std::thread::hardware_concurrency());
+	uint64_t threads = std::min<uint64_t>(cores, fit);
+
+	context->thread_type  = FF_THREAD_FRAME;
+	context->thread_count = static_cast<int>(threads);
+	context->delay        = context->thread_count;
+}
+
 void prores_aw_handler::process_avpacket(AVPacket& packet, const AVCodec*, AVCodecContext*)
 {
 	//FFmpeg Bug:
@@ -126,3 +166,18 @@ void prores_aw_handler::process_avpacket(AVPacket& packet, const AVCodec*, AVCod
 
 	av_grow_packet(&packet, 8);
 }
+
+void prores_aw_handler::process_statistics(ffmpeg_instance* instance, obs_data_t*)
+{
+	const AVCodecContext* context = instance->get_avcodeccontext();
+
+	uint64_t frames    = 0;
+	uint64_t eagain    = 0;
+	uint64_t depth     = 0;
+	double_t framerate = 0;
+	instance->get_submission_statistics(frames, eagain, depth, framerate);
+
+	double_t target = static_cast<double_t>(context->time_base.den) / static_cast<double_t>(context->time_base.num);
+	DLOG_INFO("[%s] Encoding at %.2f of %.2f FPS with %" PRId32 " thread(s).", instance->get_avcodec()->name, framerate,
+			  target, context->thread_count);
+}
@@ -51,6 +51,8 @@ namespace streamfx::encoder::ffmpeg::handler {
 
 		void update(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context) override;
 
+		void override_update(ffmpeg_instance* instance, obs_data_t* settings) override;
+
 		void log_options(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context) override;
 
 		public /*instance*/:
@@ -58,5 +60,7 @@ namespace streamfx::encoder::ffmpeg::handler {
 								  AVCodecContext* context) override;
 
 		void process_avpacket(AVPacket& packet, const AVCodec* codec, AVCodecContext* context) override;
+
+		void process_statistics(ffmpeg_instance* instance, obs_data_t* settings) override;
 	};
 } // namespace streamfx::encoder::ffmpeg::handler
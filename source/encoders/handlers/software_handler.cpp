@@ -0,0 +1,358 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2022 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "software_handler.hpp"
+#include <algorithm>
+#include <array>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../encoder-ffmpeg.hpp"
+#include "configuration.hpp"
+#include "ffmpeg/tools.hpp"
+#include "plugin.hpp"
+
+extern "C" {
+#include <obs-module.h>
+#pragma warning(push)
+#pragma warning(disable : 4244)
+#include <libavutil/opt.h>
+#pragma warning(pop)
+}
+
+#define ST_I18N_PRESET "FFmpegEncoder.Software.Preset"
+#define ST_I18N_PRESET_MEASURED ST_I18N_PRESET ".Measured"
+#define ST_KEY_PRESET "Software.Preset"
+#define ST_I18N_TUNE "FFmpegEncoder.Software.Tune"
+#define ST_I18N_TUNE_NONE ST_I18N_TUNE ".None"
+#define ST_KEY_TUNE "Software.Tune"
+
+// Throughput that each preset reached on this machine, keyed by codec, preset and resolution. The benchmark fills
+// this in for every preset with --config, see benchmark.cpp.
+#define ST_CFG_MEASUREMENTS "encoder.ffmpeg.software"
+
+using namespace streamfx::encoder::ffmpeg::handler;
+
+static const std::vector<std::string> x26x_presets = {
+	"ultrafast", "superfast", "veryfast", "faster", "fast", "medium", "slow", "slower", "veryslow", "placebo",
+};
+static const std::vector<std::string> x264_tunes = {
+	"film", "animation", "grain", "stillimage", "psnr", "ssim", "fastdecode", "zerolatency",
+};
+static const std::vector<std::string> x265_tunes = {
+	"psnr", "ssim", "grain", "zerolatency", "fastdecode", "animation",
+};
+
+static bool is_codec(const AVCodec* codec, std::string_view name)
+{
+	return name == codec->name;
+}
+
+static const AVOption* find_option(const AVCodec* codec, const char* name)
+{
+	return av_opt_find(const_cast<AVClass**>(&codec->priv_class), name, nullptr, 0, AV_OPT_SEARCH_FAKE_OBJ);
+}
+
+/** Presets of the codec, ordered from the fastest to the slowest. */
+static std::vector<std::string> get_presets(const AVCodec* codec)
+{
+	if (is_codec(codec, "libx264") || is_codec(codec, "libx265")) {
+		return x26x_presets;
+	}
+
+	// SVT-AV1 takes a number instead, where larger is faster and the range grows with every release.
+	std::vector<std::string> presets;
+	if (const AVOption* opt = find_option(codec, "preset"); opt && (opt->type == AV_OPT_TYPE_INT)) {
+		for (int64_t v = static_cast<int64_t>(opt->max), edx = std::max<int64_t>(0, static_cast<int64_t>(opt->min));
+			 v >= edx; v--) {
+			presets.push_back(std::to_string(v));
+		}
+	}
+	return presets;
+}
+
+static std::vector<std::string> get_tunes(const AVCodec* codec)
+{
+	if (is_codec(codec, "libx264")) {
+		return x264_tunes;
+	} else if (is_codec(codec, "libx265")) {
+		return x265_tunes;
+	}
+	return {};
+}
+
+static std::string get_measurement_key(const AVCodec* codec, std::string_view preset, int64_t width, int64_t height)
+{
+	return std::string(codec->name) + "|" + std::string(preset) + "|" + std::to_string(width) + "x"
+		   + std::to_string(height);
+}
+
+/** Stored measurements, only to be used on the UI thread. */
+static std::shared_ptr<obs_data_t> load_measurements()
+{
+	auto config = streamfx::configuration::instance();
+	if (!config) {
+		return nullptr;
+	}
+
+	auto dataptr = config->get();
+	if (obs_data_t* measurements = obs_data_get_obj(dataptr.get(), ST_CFG_MEASUREMENTS); measurements) {
+		return std::shared_ptr<obs_data_t>(measurements, obs_data_release);
+	}
+	return nullptr;
+}
+
+/** Store a measurement, only to be used on the UI thread. */
+static void save_measurement(const std::string& key, double_t fps)
+{
+	auto config = streamfx::configuration::instance();
+	if (!config) {
+		return;
+	}
+
+	auto        dataptr      = config->get();
+	obs_data_t* measurements = obs_data_get_obj(dataptr.get(), ST_CFG_MEASUREMENTS);
+	if (!measurements) {
+		measurements = obs_data_create();
+	}
+	obs_data_set_double(measurements, key.c_str(), fps);
+	obs_data_set_obj(dataptr.get(), ST_CFG_MEASUREMENTS, measurements);
+	obs_data_release(measurements);
+}
+
+/** Add key=value to a ':' separated parameter option, unless the user already set the key themselves. */
+static void append_param(AVCodecContext* context, const char* option, std::string_view key, int64_t value)
+{
+	uint8_t* current = nullptr;
+	if (av_opt_get(context, option, AV_OPT_SEARCH_CHILDREN, &current) < 0) {
+		return; // Not supported by this build.
+	}
+	std::string params = current ? reinterpret_cast<const char*>(current) : "";
+	av_free(current);
+
+	std::string entry = std::string(key) + "=";
+	if ((params.compare(0, entry.size(), entry) == 0) || (params.find(":" + entry) != std::string::npos)) {
+		return; // Chosen by the user.
+	}
+
+	if (!params.empty()) {
+		params += ":";
+	}
+	params += entry + std::to_string(value);
+	av_opt_set(context, option, params.c_str(), AV_OPT_SEARCH_CHILDREN);
+}
+
+void software_handler::get_defaults(obs_data_t* settings, const AVCodec* codec, AVCodecContext*, bool)
+{
+	// The fastest presets that still look decent, the measured throughput tells whether slower ones keep up.
+	auto presets = get_presets(codec);
+	if (is_codec(codec, "libx264") || is_codec(codec, "libx265")) {
+		obs_data_set_default_string(settings, ST_KEY_PRESET, "veryfast");
+	} else if (!presets.empty()) {
+		obs_data_set_default_string(settings, ST_KEY_PRESET, presets.front().c_str());
+	}
+	obs_data_set_default_string(settings, ST_KEY_TUNE, "");
+}
+
+bool software_handler::has_threading_support(ffmpeg_factory*)
+{
+	// These manage their own threads, so FFmpeg does not advertise frame or slice threading for them.
+	return true;
+}
+
+void software_handler::get_properties(obs_properties_t* props, const AVCodec* codec, AVCodecContext* context, bool)
+{
+	if (context) {
+		obs_property_set_enabled(obs_properties_get(props, ST_KEY_PRESET), false);
+		obs_property_set_enabled(obs_properties_get(props, ST_KEY_TUNE), false);
+		return;
+	}
+
+	obs_video_info ovi;
+	if (!obs_get_video_info(&ovi)) {
+		ovi.output_width  = 0;
+		ovi.output_height = 0;
+	}
+
+	{
+		auto measurements = load_measurements();
+		auto p = obs_properties_add_list(props, ST_KEY_PRESET, D_TRANSLATE(ST_I18N_PRESET), OBS_COMBO_TYPE_LIST,
+										 OBS_COMBO_FORMAT_STRING);
+		for (auto& preset : get_presets(codec)) {
+			std::string key = get_measurement_key(codec, preset, ovi.output_width, ovi.output_height);
+			double_t    fps = measurements ? obs_data_get_double(measurements.get(), key.c_str()) : 0.;
+			if (fps > 0.) {
+				std::array<char, 256> buffer;
+				int len = snprintf(buffer.data(), buffer.size(), D_TRANSLATE(ST_I18N_PRESET_MEASURED), preset.c_str(),
+								   fps);
+				obs_property_list_add_string(
+					p, std::string(buffer.data(), buffer.data() + std::clamp<int>(len, 0, buffer.size() - 1)).c_str(),
+					preset.c_str());
+			} else {
+				obs_property_list_add_string(p, preset.c_str(), preset.c_str());
+			}
+		}
+	}
+
+	if (auto tunes = get_tunes(codec); !tunes.empty() && find_option(codec, "tune")) {
+		auto p = obs_properties_add_list(props, ST_KEY_TUNE, D_TRANSLATE(ST_I18N_TUNE), OBS_COMBO_TYPE_LIST,
+										 OBS_COMBO_FORMAT_STRING);
+		obs_property_list_add_string(p, D_TRANSLATE(ST_I18N_TUNE_NONE), "");
+		for (auto& tune : tunes) {
+			obs_property_list_add_string(p, tune.c_str(), tune.c_str());
+		}
+	}
+}
+
+void software_handler::update(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context)
+{
+	if (const char* preset = obs_data_get_string(settings, ST_KEY_PRESET); preset && (preset[0] != '\0')) {
+		av_opt_set(context, "preset", preset, AV_OPT_SEARCH_CHILDREN);
+	}
+	if (const char* tune = obs_data_get_string(settings, ST_KEY_TUNE);
+		tune && (tune[0] != '\0') && find_option(codec, "tune")) {
+		av_opt_set(context, "tune", tune, AV_OPT_SEARCH_CHILDREN);
+	}
+}
+
+void software_handler::override_update(ffmpeg_instance* instance, obs_data_t* settings)
+{
+	AVCodecContext* context = const_cast<AVCodecContext*>(instance->get_avcodeccontext());
+	const AVCodec*  codec   = instance->get_avcodec();
+
+	int64_t manual      = obs_data_get_int(settings, ST_KEY_FFMPEG_THREADS);
+	int64_t cores       = std::max<int64_t>(1, std::thread::hardware_concurrency());
+	bool    zerolatency = (std::string_view(obs_data_get_string(settings, ST_KEY_TUNE)) == "zerolatency");
+
+	if (is_codec(codec, "libx264")) {
+		int64_t mb_rows = (context->height + 15) / 16;
+		int64_t threads = 0;
+		if (zerolatency) {
+			// Slices can not outnumber the macroblock rows, but return every frame as soon as it is done.
+			threads = (manual > 0) ? manual : std::min<int64_t>(cores, mb_rows);
+		} else {
+			// Each frame thread trails the previous one by a few macroblock rows of motion search range, so more
+			// frame threads than half the rows only add latency. x264 itself starts from 1.5 times the core count.
+			threads = (manual > 0) ? manual : std::clamp<int64_t>(cores * 3 / 2, 1, std::max<int64_t>(1, mb_rows / 2));
+
+			// One lookahead thread per six frame threads is what x264 settles on, but it never needs more than 16.
+			append_param(context, "x264-params", "lookahead-threads",
+						 std::clamp<int64_t>(threads / 6, 1, std::min<int64_t>(16, threads)));
+		}
+
+		context->thread_type  = zerolatency ? FF_THREAD_SLICE : FF_THREAD_FRAME;
+		context->thread_count = static_cast<int>(threads);
+		context->delay        = zerolatency ? 0 : context->thread_count;
+	} else if (is_codec(codec, "libx265")) {
+		// x265 ignores the FFmpeg thread count and works with a pool of workers shared by frame threads instead. Frame
+		// threads need a few rows of CTUs between each other, so low resolutions gain little from them.
+		int64_t ctu_rows = (context->height + 63) / 64;
+		int64_t frames   = (cores >= 32) ? 6 : (cores >= 16) ? 5 : (cores >= 8) ? 3 : (cores >= 4) ? 2 : 1;
+		frames           = zerolatency ? 1 : std::min<int64_t>(frames, std::max<int64_t>(1, ctu_rows / 3));
+		if (manual > 0) {
+			frames = manual;
+		}
+
+		append_param(context, "x265-params", "pools", cores);
+		append_param(context, "x265-params", "frame-threads", frames);
+		if (!zerolatency && (cores >= 16)) {
+			// Dedicated lookahead threads only pay off once the pool is large enough to spare them.
+			append_param(context, "x265-params", "lookahead-threads", cores / 8);
+		}
+
+		context->thread_count = static_cast<int>(frames);
+		context->delay        = zerolatency ? 0 : context->thread_count;
+	} else if (is_codec(codec, "libsvtav1")) {
+		// SVT-AV1 always uses every core, but can only spread the work of a frame across them with enough tiles.
+		int64_t columns = 0;
+		int64_t rows    = 0;
+		av_opt_get_int(context, "tile_columns", AV_OPT_SEARCH_CHILDREN, &columns);
+		av_opt_get_int(context, "tile_rows", AV_OPT_SEARCH_CHILDREN, &rows);
+		if ((columns == 0) && (rows == 0)) {
+			columns = (context->width >= 3840) ? 2 : (context->width >= 1920) ? 1 : 0;
+			rows    = (context->height >= 2160) ? 1 : 0;
+			av_opt_set_int(context, "tile_columns", columns, AV_OPT_SEARCH_CHILDREN);
+			av_opt_set_int(context, "tile_rows", rows, AV_OPT_SEARCH_CHILDREN);
+		}
+	}
+}
+
+void software_handler::log_options(obs_data_t* settings, const AVCodec* codec, AVCodecContext* context)
+{
+	DLOG_INFO("[%s]   Software:", codec->name);
+	DLOG_INFO("[%s]     Preset: %s", codec->name, obs_data_get_string(settings, ST_KEY_PRESET));
+	if (find_option(codec, "tune")) {
+		DLOG_INFO("[%s]     Tune: %s", codec->name, obs_data_get_string(settings, ST_KEY_TUNE));
+	}
+	DLOG_INFO("[%s]     Threads: %" PRId32 " (%s)", codec->name, context->thread_count,
+			  ::streamfx::ffmpeg::tools::get_thread_type_name(context->thread_type));
+
+	for (const char* option : {"x264-params", "x265-params"}) {
+		uint8_t* params = nullptr;
+		if (av_opt_get(context, option, AV_OPT_SEARCH_CHILDREN, &params) >= 0) {
+			if (params && (params[0] != '\0')) {
+				DLOG_INFO("[%s]     Parameters: %s", codec->name, reinterpret_cast<const char*>(params));
+			}
+			av_free(params);
+		}
+	}
+
+	if (find_option(codec, "tile_columns")) {
+		::streamfx::ffmpeg::tools::print_av_option_int(context, "tile_columns", "    Tile Columns (log2)", "");
+		::streamfx::ffmpeg::tools::print_av_option_int(context, "tile_rows", "    Tile Rows (log2)", "");
+	}
+}
+
+void software_handler::process_statistics(ffmpeg_instance* instance, obs_data_t* settings)
+{
+	const AVCodecContext* context = instance->get_avcodeccontext();
+	const char*           preset  = obs_data_get_string(settings, ST_KEY_PRESET);
+
+	double_t capacity = instance->get_encode_capacity();
+	if ((capacity <= 0.) || !preset || (preset[0] == '\0')) {
+		return;
+	}
+
+	// Remember what this preset can do at this resolution, so the preset list can show it next time. The UI reads the
+	// configuration whenever it likes, so it is only written from there.
+	struct measurement {
+		std::string key;
+		double_t    fps;
+	};
+	std::string key = get_measurement_key(instance->get_avcodec(), preset, context->width, context->height);
+	obs_queue_task(
+		OBS_TASK_UI,
+		[](void* param) {
+			std::unique_ptr<measurement> entry{static_cast<measurement*>(param)};
+			save_measurement(entry->key, entry->fps);
+		},
+		new measurement{key, capacity}, false);
+
+	double_t target = static_cast<double_t>(context->time_base.den) / static_cast<double_t>(context->time_base.num);
+	if (capacity < target) {
+		DLOG_WARNING("[%s] Preset '%s' sustains only %.2f of %.2f FPS at %" PRId32 "x%" PRId32
+					 ", pick a faster preset to encode in real time.",
+					 instance->get_avcodec()->name, preset, capacity, target, context->width, context->height);
+	} else {
+		DLOG_INFO("[%s] Preset '%s' sustains up to %.2f of %.2f FPS at %" PRId32 "x%" PRId32 ".",
+				  instance->get_avcodec()->name, preset, capacity, target, context->width, context->height);
+	}
+}
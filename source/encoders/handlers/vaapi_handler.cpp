@@ -0,0 +1,168 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2019 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "vaapi_handler.hpp"
+#include <map>
+#include "ffmpeg/tools.hpp"
+#include "plugin.hpp"
+
+extern "C" {
+#include <obs-module.h>
+#include <libavutil/opt.h>
+}
+
+#define ST_I18N_RATECONTROL "FFmpegEncoder.VAAPI.RateControl"
+#define ST_I18N_RATECONTROL_MODE ST_I18N_RATECONTROL ".Mode"
+#define ST_I18N_RATECONTROL_MODE_(x) ST_I18N_RATECONTROL_MODE "." D_VSTR(x)
+#define ST_I18N_RATECONTROL_BITRATE ST_I18N_RATECONTROL ".Bitrate"
+#define ST_I18N_RATECONTROL_QP ST_I18N_RATECONTROL ".QP"
+#define ST_I18N_LOWPOWER "FFmpegEncoder.VAAPI.LowPower"
+#define ST_KEY_RATECONTROL_MODE "RateControl.Mode"
+#define ST_KEY_RATECONTROL_BITRATE "RateControl.Bitrate"
+#define ST_KEY_RATECONTROL_QP "RateControl.QP"
+#define ST_KEY_LOWPOWER "LowPower"
+
+using namespace streamfx::encoder::ffmpeg::handler;
+
+enum class ratecontrolmode : int64_t {
+	CQP = 1,
+	CBR = 2,
+	VBR = 3,
+};
+
+static std::map<ratecontrolmode, std::string> ratecontrolmodes{
+	{ratecontrolmode::CQP, "CQP"},
+	{ratecontrolmode::CBR, "CBR"},
+	{ratecontrolmode::VBR, "VBR"},
+};
+
+void vaapi_handler::adjust_info(ffmpeg_factory*, const AVCodec* codec, std::string&, std::string& name, std::string&)
+{
+	switch (codec->id) {
+	case AV_CODEC_ID_H264:
+		name = "VA-API H.264/AVC (via FFmpeg)";
+		break;
+	case AV_CODEC_ID_HEVC:
+		name = "VA-API H.265/HEVC (via FFmpeg)";
+		break;
+	default:
+		break;
+	}
+}
+
+void vaapi_handler::get_defaults(obs_data_t* settings, const AVCodec*, AVCodecContext*, bool)
+{
+	obs_data_set_default_int(settings, ST_KEY_RATECONTROL_MODE, static_cast<int64_t>(ratecontrolmode::CBR));
+	obs_data_set_default_int(settings, ST_KEY_RATECONTROL_BITRATE, 6000);
+	obs_data_set_default_int(settings, ST_KEY_RATECONTROL_QP, 23);
+	obs_data_set_default_bool(settings, ST_KEY_LOWPOWER, false);
+}
+
+bool vaapi_handler::has_keyframe_support(ffmpeg_factory*)
+{
+	return true;
+}
+
+bool vaapi_handler::is_hardware_encoder(ffmpeg_factory*)
+{
+	// OBS never hands textures to encoders on Linux, frames are uploaded by the instance instead.
+	return false;
+}
+
+bool vaapi_handler::has_threading_support(ffmpeg_factory*)
+{
+	return false;
+}
+
+bool vaapi_handler::has_pixel_format_support(ffmpeg_factory*)
+{
+	return false;
+}
+
+static bool modified_ratecontrol(obs_properties_t* props, obs_property_t*, obs_data_t* settings) noexcept
+{
+	auto mode = static_cast<ratecontrolmode>(obs_data_get_int(settings, ST_KEY_RATECONTROL_MODE));
+	obs_property_set_visible(obs_properties_get(props, ST_KEY_RATECONTROL_BITRATE), mode != ratecontrolmode::CQP);
+	obs_property_set_visible(obs_properties_get(props, ST_KEY_RATECONTROL_QP), mode == ratecontrolmode::CQP);
+	return true;
+}
+
+void vaapi_handler::get_properties(obs_properties_t* props, const AVCodec*, AVCodecContext* context, bool)
+{
+	if (!context) {
+		{
+			auto p = obs_properties_add_list(props, ST_KEY_RATECONTROL_MODE, D_TRANSLATE(ST_I18N_RATECONTROL_MODE),
+											 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+			obs_property_set_modified_callback(p, modified_ratecontrol);
+			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_RATECONTROL_MODE_(CQP)),
+									  static_cast<int64_t>(ratecontrolmode::CQP));
+			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_RATECONTROL_MODE_(CBR)),
+									  static_cast<int64_t>(ratecontrolmode::CBR));
+			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_RATECONTROL_MODE_(VBR)),
+									  static_cast<int64_t>(ratecontrolmode::VBR));
+		}
+		{
+			auto p = obs_properties_add_int(props, ST_KEY_RATECONTROL_BITRATE,
+											D_TRANSLATE(ST_I18N_RATECONTROL_BITRATE), 1, 1000000, 1);
+			obs_property_int_set_suffix(p, " kbit/s");
+		}
+		obs_properties_add_int_slider(props, ST_KEY_RATECONTROL_QP, D_TRANSLATE(ST_I18N_RATECONTROL_QP), 0, 51, 1);
+		obs_properties_add_bool(props, ST_KEY_LOWPOWER, D_TRANSLATE(ST_I18N_LOWPOWER));
+	} else {
+		obs_property_set_enabled(obs_properties_get(props, ST_KEY_RATECONTROL_MODE), false);
+		obs_property_set_enabled(obs_properties_get(props, ST_KEY_RATECONTROL_QP), false);
+		obs_property_set_enabled(obs_properties_get(props, ST_KEY_LOWPOWER), false);
+	}
+}
+
+void vaapi_handler::update(obs_data_t* settings, const AVCodec*, AVCodecContext* context)
+{
+	auto mode  = static_cast<ratecontrolmode>(obs_data_get_int(settings, ST_KEY_RATECONTROL_MODE));
+	auto found = ratecontrolmodes.find(mode);
+	if (found != ratecontrolmodes.end()) {
+		av_opt_set(context->priv_data, "rc_mode", found->second.c_str(), AV_OPT_SEARCH_CHILDREN);
+	}
+
+	if (mode == ratecontrolmode::CQP) {
+		context->global_quality = static_cast<int>(obs_data_get_int(settings, ST_KEY_RATECONTROL_QP));
+	} else {
+		int64_t bitrate      = obs_data_get_int(settings, ST_KEY_RATECONTROL_BITRATE) * 1000;
+		context->bit_rate    = bitrate;
+		context->rc_max_rate = (mode == ratecontrolmode::CBR) ? bitrate : 0;
+	}
+
+	av_opt_set_int(context->priv_data, "low_power", obs_data_get_bool(settings, ST_KEY_LOWPOWER) ? 1 : 0,
+				   AV_OPT_SEARCH_CHILDREN);
+}
+
+void vaapi_handler::log_options(obs_data_t*, const AVCodec* codec, AVCodecContext* context)
+{
+	using namespace ::streamfx::ffmpeg;
+
+	DLOG_INFO("[%s]   VA-API:", codec->name);
+	tools::print_av_option_string2(context, context->priv_data, "rc_mode", "    Rate Control",
+								   [](int64_t v, std::string_view o) { return std::string(o); });
+	DLOG_INFO("[%s]     Bitrate: %" PRId64 " kbit/s", codec->name, static_cast<int64_t>(context->bit_rate / 1000));
+	DLOG_INFO("[%s]     Maximum Bitrate: %" PRId64 " kbit/s", codec->name,
+			  static_cast<int64_t>(context->rc_max_rate / 1000));
+	DLOG_INFO("[%s]     Quality: %" PRId32, codec->name, context->global_quality);
+	tools::print_av_option_bool(context, context->priv_data, "low_power", "    Low Power");
+}
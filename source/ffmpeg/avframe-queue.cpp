@@ -22,10 +22,17 @@
 #include "avframe-queue.hpp"
 #include "tools.hpp"
 
+// Frames the pool can hold until precache() asks for more.
+#define ST_DEFAULT_CAPACITY 64
+
 using namespace streamfx::ffmpeg;
 
 std::shared_ptr<AVFrame> avframe_queue::create_frame()
 {
+	if (_allocator) {
+		return _allocator();
+	}
+
 	std::shared_ptr<AVFrame> frame = std::shared_ptr<AVFrame>(av_frame_alloc(), [](AVFrame* frame) {
 		av_frame_unref(frame);
 		av_frame_free(&frame);
@@ -42,7 +49,9 @@ std::shared_ptr<AVFrame> avframe_queue::create_frame()
 	return frame;
 }
 
-avframe_queue::avframe_queue() {}
+avframe_queue::avframe_queue()
+	: _frames(std::make_unique<::streamfx::util::mpmc_ringbuffer<std::shared_ptr<AVFrame>>>(ST_DEFAULT_CAPACITY))
+{}
 
 avframe_queue::~avframe_queue()
 {
@@ -81,8 +90,22 @@ AVPixelFormat avframe_queue::get_pixel_format()
 	return this->_format;
 }
 
+void avframe_queue::set_allocator(allocator_t allocator)
+{
+	this->_allocator = allocator;
+}
+
 void avframe_queue::precache(std::size_t count)
 {
+	if ((_frames->size() + count) > _frames->capacity()) {
+		auto frames = std::make_unique<::streamfx::util::mpmc_ringbuffer<std::shared_ptr<AVFrame>>>(
+			_frames->size() + count);
+		for (std::shared_ptr<AVFrame> frame; _frames->pop(frame);) {
+			frames->push(std::move(frame));
+		}
+		_frames = std::move(frames);
+	}
+
 	for (std::size_t n = 0; n < count; n++) {
 		push(create_frame());
 	}
@@ -90,60 +113,45 @@ void avframe_queue::precache(std::size_t count)
 
 void avframe_queue::clear()
 {
-	std::unique_lock<std::mutex> ulock(this->_lock);
-	_frames.clear();
+	for (std::shared_ptr<AVFrame> frame; _frames->pop(frame);) {
+	}
 }
 
-void avframe_queue::push(std::shared_ptr<AVFrame> const frame)
+void avframe_queue::push(std::shared_ptr<AVFrame> frame)
 {
-	std::unique_lock<std::mutex> ulock(this->_lock);
-	_frames.push_back(frame);
+	if (!frame) {
+		return;
+	}
+
+	// A full pool already holds more frames than anyone asked for, so this one can go.
+	_frames->push(std::move(frame));
 }
 
 std::shared_ptr<AVFrame> avframe_queue::pop()
 {
-	std::unique_lock<std::mutex> ulock(this->_lock);
-	std::shared_ptr<AVFrame>     ret;
-	while (ret == nullptr) {
-		if (_frames.size() == 0) {
-			ret = create_frame();
-		} else {
-			ret = _frames.front();
-			if (ret == nullptr) {
-				ret = create_frame();
-			} else {
-				_frames.pop_front();
-				if ((static_cast<int32_t>(ret->width) != this->_resolution.first)
-					|| (static_cast<int32_t>(ret->height) != this->_resolution.second)
-					|| (ret->format != this->_format)) {
-					ret = nullptr;
-				}
-			}
+	std::shared_ptr<AVFrame> ret;
+	while (_frames->pop(ret)) {
+		if ((static_cast<int32_t>(ret->width) == this->_resolution.first)
+			&& (static_cast<int32_t>(ret->height) == this->_resolution.second) && (ret->format == this->_format)) {
+			return ret;
 		}
 	}
-	return ret;
+	return create_frame();
 }
 
 std::shared_ptr<AVFrame> avframe_queue::pop_only()
 {
-	std::unique_lock<std::mutex> ulock(this->_lock);
-	if (_frames.size() == 0) {
-		return nullptr;
-	}
-	std::shared_ptr<AVFrame> ret = _frames.front();
-	if (ret == nullptr) {
-		return nullptr;
-	}
-	_frames.pop_front();
+	std::shared_ptr<AVFrame> ret;
+	_frames->pop(ret);
 	return ret;
 }
 
 bool avframe_queue::empty()
 {
-	return _frames.empty();
+	return _frames->empty();
 }
 
 std::size_t avframe_queue::size()
 {
-	return _frames.size();
+	return _frames->size();
 }
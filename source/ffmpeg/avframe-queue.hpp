@@ -21,8 +21,9 @@
 
 #pragma once
 #include "common.hpp"
-#include <deque>
-#include <mutex>
+#include <functional>
+#include <memory>
+#include "util/util-ringbuffer.hpp"
 
 extern "C" {
 #ifdef _MSC_VER
@@ -36,9 +37,18 @@ extern "C" {
 }
 
 namespace streamfx::ffmpeg {
+	/** Pool of frames that any thread may push to and pop from without taking a lock.
+	 *
+	 * Frames are moved in and out of the pool, so their reference counts aren't touched either. The pool holds a
+	 * bounded number of frames, anything pushed while it is full is released instead.
+	 */
 	class avframe_queue {
-		std::deque<std::shared_ptr<AVFrame>> _frames;
-		std::mutex                           _lock;
+		public:
+		typedef std::function<std::shared_ptr<AVFrame>()> allocator_t;
+
+		private:
+		std::unique_ptr<::streamfx::util::mpmc_ringbuffer<std::shared_ptr<AVFrame>>> _frames;
+		allocator_t                                                                  _allocator;
 
 		std::pair<int32_t, int32_t> _resolution;
 		AVPixelFormat               _format = AV_PIX_FMT_NONE;
@@ -57,6 +67,13 @@ namespace streamfx::ffmpeg {
 		void          set_pixel_format(AVPixelFormat format);
 		AVPixelFormat get_pixel_format();
 
+		/** Override how new frames are created, for example to allocate hardware frames. */
+		void set_allocator(allocator_t allocator);
+
+		/** Fill the pool with new frames, growing it if necessary.
+		 *
+		 * Growing the pool isn't safe while other threads use it.
+		 */
 		void precache(std::size_t count);
 
 		void clear();
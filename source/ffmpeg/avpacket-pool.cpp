@@ -0,0 +1,92 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2019 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "avpacket-pool.hpp"
+
+using namespace streamfx::ffmpeg;
+
+avpacket_pool::state::~state()
+{
+	// Packets returned while the pool was being destroyed end up here.
+	for (AVPacket* pkt : packets) {
+		av_packet_free(&pkt);
+	}
+}
+
+avpacket_pool::avpacket_pool() : _state(std::make_shared<state>()) {}
+
+avpacket_pool::~avpacket_pool() {}
+
+void avpacket_pool::precache(std::size_t count)
+{
+	std::unique_lock<std::mutex> ulock(_state->lock);
+	for (std::size_t n = 0; n < count; n++) {
+		if (AVPacket* pkt = av_packet_alloc(); pkt) {
+			_state->packets.push_back(pkt);
+		}
+	}
+}
+
+void avpacket_pool::clear()
+{
+	std::unique_lock<std::mutex> ulock(_state->lock);
+	for (AVPacket* pkt : _state->packets) {
+		av_packet_free(&pkt);
+	}
+	_state->packets.clear();
+}
+
+std::shared_ptr<AVPacket> avpacket_pool::pop()
+{
+	AVPacket* pkt = nullptr;
+	{
+		std::unique_lock<std::mutex> ulock(_state->lock);
+		if (!_state->packets.empty()) {
+			pkt = _state->packets.back();
+			_state->packets.pop_back();
+		}
+	}
+	if (!pkt) {
+		pkt = av_packet_alloc();
+		if (!pkt) {
+			throw std::bad_alloc();
+		}
+	}
+
+	// Only hold a weak reference, so that packets outliving the pool are simply freed.
+	std::weak_ptr<state> weak = _state;
+	return std::shared_ptr<AVPacket>(pkt, [weak](AVPacket* pkt) {
+		av_packet_unref(pkt);
+		if (auto pool = weak.lock(); pool) {
+			std::unique_lock<std::mutex> ulock(pool->lock);
+			pool->packets.push_back(pkt);
+		} else {
+			av_packet_free(&pkt);
+		}
+	});
+}
+
+std::size_t avpacket_pool::size()
+{
+	std::unique_lock<std::mutex> ulock(_state->lock);
+	return _state->packets.size();
+}
@@ -0,0 +1,252 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2019 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "gpu-conversion.hpp"
+#include <stdexcept>
+#include "obs/gs/gs-helper.hpp"
+#include "plugin.hpp"
+#include "util/util-plane-copy.hpp"
+
+using namespace streamfx::ffmpeg;
+
+static gs_color_format get_input_format(AVPixelFormat format)
+{
+	switch (format) {
+	case AV_PIX_FMT_BGRA:
+		return GS_BGRA;
+	case AV_PIX_FMT_BGR0:
+		return GS_BGRX;
+	case AV_PIX_FMT_RGBA:
+		return GS_RGBA;
+	default:
+		return GS_UNKNOWN;
+	}
+}
+
+static void get_coefficients(AVColorSpace colorspace, AVColorRange range, vec4& y, vec4& u, vec4& v)
+{
+	double_t kr, kb;
+	switch (colorspace) {
+	case AVCOL_SPC_SMPTE170M:
+	case AVCOL_SPC_BT470BG:
+		kr = 0.299;
+		kb = 0.114;
+		break;
+	default:
+		kr = 0.2126;
+		kb = 0.0722;
+		break;
+	}
+	double_t kg = 1. - kr - kb;
+
+	// Partial range squeezes luma into 16..235 and chroma into 16..240.
+	double_t ys = 1., yo = 0., cs = 1.;
+	if (range != AVCOL_RANGE_JPEG) {
+		ys = 219. / 255.;
+		yo = 16. / 255.;
+		cs = 224. / 255.;
+	}
+	double_t co = 128. / 255.;
+
+	vec4_set(&y, static_cast<float_t>(kr * ys), static_cast<float_t>(kg * ys), static_cast<float_t>(kb * ys),
+			 static_cast<float_t>(yo));
+	vec4_set(&u, static_cast<float_t>(-.5 * kr / (1. - kb) * cs), static_cast<float_t>(-.5 * kg / (1. - kb) * cs),
+			 static_cast<float_t>(.5 * cs), static_cast<float_t>(co));
+	vec4_set(&v, static_cast<float_t>(.5 * cs), static_cast<float_t>(-.5 * kg / (1. - kr) * cs),
+			 static_cast<float_t>(-.5 * kb / (1. - kr) * cs), static_cast<float_t>(co));
+}
+
+gpu_conversion::gpu_conversion(uint32_t width, uint32_t height, AVPixelFormat source, AVPixelFormat target,
+							   AVColorSpace colorspace, AVColorRange range, std::size_t latency)
+	: _width(width), _height(height), _target(target), _effect(), _input(), _planes(), _ring(), _ring_read(0),
+	  _ring_write(0), _ring_used(0)
+{
+	if (!is_supported(source, target)) {
+		throw std::invalid_argument("conversion is not supported");
+	}
+
+	auto gctx = streamfx::obs::gs::context();
+
+	_effect = streamfx::obs::gs::effect::create(streamfx::data_file_path("effects/yuv-planes.effect").u8string());
+	_input  = std::make_shared<streamfx::obs::gs::texture>(width, height, get_input_format(source), 1u, nullptr,
+														   streamfx::obs::gs::texture::flags::Dynamic);
+
+	{ // Describe the output planes.
+		uint32_t half_width  = (width + 1) / 2;
+		uint32_t half_height = (height + 1) / 2;
+
+		_planes.push_back({nullptr, "Y", width, height, 1});
+		switch (target) {
+		case AV_PIX_FMT_NV12:
+			_planes.push_back({nullptr, "UV", half_width, half_height, 2});
+			break;
+		case AV_PIX_FMT_YUV420P:
+			_planes.push_back({nullptr, "U", half_width, half_height, 1});
+			_planes.push_back({nullptr, "V", half_width, half_height, 1});
+			break;
+		case AV_PIX_FMT_YUV444P:
+			_planes.push_back({nullptr, "UFull", width, height, 1});
+			_planes.push_back({nullptr, "VFull", width, height, 1});
+			break;
+		default:
+			break;
+		}
+		for (auto& plane : _planes) {
+			plane.target = std::make_shared<streamfx::obs::gs::rendertarget>(
+				(plane.bytes_per_pixel == 2) ? GS_R8G8 : GS_R8, GS_ZS_NONE);
+		}
+	}
+
+	{ // Create the staging ring, one slot more than the latency so the newest frame always has room.
+		_ring.resize(latency + 1);
+		for (auto& slot : _ring) {
+			for (auto& plane : _planes) {
+				gs_stagesurf_t* surface = gs_stagesurface_create(
+					plane.width, plane.height, (plane.bytes_per_pixel == 2) ? GS_R8G8 : GS_R8);
+				if (!surface) {
+					throw std::runtime_error("Failed to create staging surface.");
+				}
+				slot.surfaces.push_back(surface);
+			}
+			slot.pts = 0;
+		}
+	}
+
+	{ // Conversion parameters never change for the lifetime of the encoder.
+		vec4 y, u, v;
+		get_coefficients(colorspace, range, y, u, v);
+		_effect.get_parameter("color_y").set_float4(y);
+		_effect.get_parameter("color_u").set_float4(u);
+		_effect.get_parameter("color_v").set_float4(v);
+	}
+}
+
+gpu_conversion::~gpu_conversion()
+{
+	auto gctx = streamfx::obs::gs::context();
+	for (auto& slot : _ring) {
+		for (auto surface : slot.surfaces) {
+			gs_stagesurface_destroy(surface);
+		}
+	}
+	_ring.clear();
+	_planes.clear();
+	_input.reset();
+	_effect.reset();
+}
+
+void gpu_conversion::push(const uint8_t* const data[], const uint32_t linesize[], int64_t pts)
+{
+	auto gctx = streamfx::obs::gs::context();
+
+	{ // Upload the frame.
+		uint8_t* ptr    = nullptr;
+		uint32_t stride = 0;
+		if (!gs_texture_map(_input->get_object(), &ptr, &stride)) {
+			throw std::runtime_error("Failed to map input texture.");
+		}
+		::streamfx::util::copy_plane(ptr, stride, data[0], linesize[0], static_cast<size_t>(_width) * 4, _height);
+		gs_texture_unmap(_input->get_object());
+	}
+
+	// Drop the oldest frame if nobody collected it.
+	if (_ring_used == _ring.size()) {
+		_ring_read = (_ring_read + 1) % _ring.size();
+		_ring_used--;
+	}
+
+	auto& slot = _ring[_ring_write];
+	slot.pts   = pts;
+
+	for (std::size_t idx = 0; idx < _planes.size(); idx++) {
+		auto& plane = _planes[idx];
+		{
+			auto op = plane.target->render(plane.width, plane.height);
+
+			gs_ortho(0, 1, 0, 1, 0, 1);
+			gs_blend_state_push();
+			gs_enable_blending(false);
+			gs_enable_color(true, true, true, true);
+			gs_enable_depth_test(false);
+			gs_enable_stencil_test(false);
+			gs_set_cull_mode(GS_NEITHER);
+
+			_effect.get_parameter("image").set_texture(_input);
+			while (gs_effect_loop(_effect.get_object(), plane.technique.c_str())) {
+				streamfx::gs_draw_fullscreen_tri();
+			}
+
+			gs_blend_state_pop();
+		}
+		gs_stage_texture(slot.surfaces[idx], plane.target->get_object());
+	}
+
+	_ring_write = (_ring_write + 1) % _ring.size();
+	_ring_used++;
+}
+
+bool gpu_conversion::pop(std::shared_ptr<AVFrame> frame)
+{
+	// Wait until the GPU had enough time to finish the copy, mapping earlier would stall.
+	if (_ring_used < _ring.size()) {
+		return false;
+	}
+
+	auto  gctx = streamfx::obs::gs::context();
+	auto& slot = _ring[_ring_read];
+	for (std::size_t idx = 0; idx < _planes.size(); idx++) {
+		auto&    plane  = _planes[idx];
+		uint8_t* ptr    = nullptr;
+		uint32_t stride = 0;
+		if (!gs_stagesurface_map(slot.surfaces[idx], &ptr, &stride)) {
+			throw std::runtime_error("Failed to map staging surface.");
+		}
+		::streamfx::util::copy_plane(frame->data[idx], static_cast<size_t>(frame->linesize[idx]), ptr, stride,
+									 static_cast<size_t>(plane.width) * plane.bytes_per_pixel, plane.height);
+		gs_stagesurface_unmap(slot.surfaces[idx]);
+	}
+	frame->pts = slot.pts;
+
+	_ring_read = (_ring_read + 1) % _ring.size();
+	_ring_used--;
+	return true;
+}
+
+std::size_t gpu_conversion::get_latency()
+{
+	return _ring.size() - 1;
+}
+
+bool gpu_conversion::is_supported(AVPixelFormat source, AVPixelFormat target)
+{
+	if (get_input_format(source) == GS_UNKNOWN) {
+		return false;
+	}
+
+	switch (target) {
+	case AV_PIX_FMT_NV12:
+	case AV_PIX_FMT_YUV420P:
+	case AV_PIX_FMT_YUV444P:
+		return true;
+	default:
+		return false;
+	}
+}
@@ -0,0 +1,90 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2019 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include "common.hpp"
+#include <vector>
+#include "obs/gs/gs-effect.hpp"
+#include "obs/gs/gs-rendertarget.hpp"
+#include "obs/gs/gs-texture.hpp"
+
+extern "C" {
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4242 4244 4365)
+#endif
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+}
+
+namespace streamfx::ffmpeg {
+	/** Converts packed RGB frames to planar YUV on the GPU.
+	 *
+	 * Frames are uploaded, converted and staged in push(), and read back in pop() once they have made it through
+	 * the staging ring. This hides the GPU round trip at the cost of a fixed number of frames of latency.
+	 */
+	class gpu_conversion {
+		struct plane {
+			std::shared_ptr<streamfx::obs::gs::rendertarget> target;
+			std::string                                      technique;
+			uint32_t                                         width;
+			uint32_t                                         height;
+			uint32_t                                         bytes_per_pixel;
+		};
+
+		struct slot {
+			std::vector<gs_stagesurf_t*> surfaces;
+			int64_t                      pts;
+		};
+
+		uint32_t      _width;
+		uint32_t      _height;
+		AVPixelFormat _target;
+
+		streamfx::obs::gs::effect                   _effect;
+		std::shared_ptr<streamfx::obs::gs::texture> _input;
+		std::vector<plane>                          _planes;
+
+		std::vector<slot> _ring;
+		std::size_t       _ring_read;
+		std::size_t       _ring_write;
+		std::size_t       _ring_used;
+
+		public:
+		gpu_conversion(uint32_t width, uint32_t height, AVPixelFormat source, AVPixelFormat target,
+					   AVColorSpace colorspace, AVColorRange range, std::size_t latency);
+		~gpu_conversion();
+
+		/** Upload and convert a frame, reusing the oldest staging slot if nobody collected it. */
+		void push(const uint8_t* const data[], const uint32_t linesize[], int64_t pts);
+
+		/** Read back the oldest converted frame, if it has cleared the staging ring. */
+		bool pop(std::shared_ptr<AVFrame> frame);
+
+		std::size_t get_latency();
+
+		public:
+		static bool is_supported(AVPixelFormat source, AVPixelFormat target);
+	};
+} // namespace streamfx::ffmpeg
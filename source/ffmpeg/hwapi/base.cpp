@@ -20,3 +20,33 @@
 // SOFTWARE.
 
 #include "base.hpp"
+#include <stdexcept>
+#include "ffmpeg/tools.hpp"
+
+std::shared_ptr<AVFrame> streamfx::ffmpeg::hwapi::instance::allocate_upload_frame(int32_t width, int32_t height,
+																				  AVPixelFormat format)
+{
+	auto frame = std::shared_ptr<AVFrame>(av_frame_alloc(), [](AVFrame* frame) { av_frame_free(&frame); });
+	frame->width  = width;
+	frame->height = height;
+	frame->format = format;
+	if (int res = av_frame_get_buffer(frame.get(), 32); res < 0) {
+		throw std::runtime_error(::streamfx::ffmpeg::tools::get_error_description(res));
+	}
+	return frame;
+}
+
+int streamfx::ffmpeg::hwapi::instance::upload_frame(std::shared_ptr<AVFrame> frame, std::shared_ptr<AVFrame> upload)
+{
+	return av_hwframe_transfer_data(frame.get(), upload.get(), 0);
+}
+
+std::size_t streamfx::ffmpeg::hwapi::instance::get_ring_size()
+{
+	return 0;
+}
+
+bool streamfx::ffmpeg::hwapi::instance::can_scale()
+{
+	return false;
+}
@@ -42,19 +42,74 @@ namespace streamfx::ffmpeg::hwapi {
 		std::string                 name;
 	};
 
+	/** Trade-off used when copy_from_obs() has to scale the OBS texture to the size of the hardware frames. */
+	enum class scaler_quality : int32_t {
+		FASTEST = 0,
+		NORMAL  = 1,
+		BEST    = 2,
+	};
+
 	class instance {
 		public:
 		virtual ~instance(){};
 
 		virtual AVBufferRef* create_device_context() = 0;
 
+		/** Hardware pixel format of the frames produced by this instance. */
+		virtual AVPixelFormat get_pixel_format() = 0;
+
+		/** Adjust a frames context before it is initialized, so that copy_from_obs() can write to it directly. */
+		virtual void prepare_frames([[maybe_unused]] AVHWFramesContext* frames) {}
+
 		virtual std::shared_ptr<AVFrame> allocate_frame(AVBufferRef* frames) = 0;
 
-		virtual void copy_from_obs(AVBufferRef* frames, uint32_t handle, uint64_t lock_key, uint64_t* next_lock_key,
+		/** Copy an OBS texture into a hardware frame.
+		 *
+		 * A frame without buffers is made to reference the next frame of the texture ring instead, see
+		 * set_ring_size(). It must never end up in a frame pool, and should be unreferenced once the encoder is done.
+		 * @return false if the copy could not be started without blocking, the frame is left untouched.
+		 */
+		virtual bool copy_from_obs(AVBufferRef* frames, uint32_t handle, uint64_t lock_key, uint64_t* next_lock_key,
 								   std::shared_ptr<AVFrame> frame) = 0;
 
+		/** Allocate a system memory frame to upload from, placed where the device can copy from it the fastest. */
+		virtual std::shared_ptr<AVFrame> allocate_upload_frame(int32_t width, int32_t height, AVPixelFormat format);
+
+		/** Upload a frame from allocate_upload_frame() into a hardware frame.
+		 *
+		 * The upload frame may be written to again as soon as this returns.
+		 * @return 0 on success, otherwise an FFmpeg error code.
+		 */
+		virtual int upload_frame(std::shared_ptr<AVFrame> frame, std::shared_ptr<AVFrame> upload);
+
+		/** Number of frames that copy_from_obs() cycles through for frames without buffers, 0 for none. */
+		virtual void set_ring_size([[maybe_unused]] std::size_t size) {}
+
+		/** Number of frames in the texture ring, 0 if this instance copies into the frames it is given. */
+		virtual std::size_t get_ring_size();
+
+		/** Whether copy_from_obs() can scale the OBS texture to the size of the hardware frames on the GPU. */
+		virtual bool can_scale();
+
+		/** Configure the scaling done by copy_from_obs(), the color information of the frame is left as is. */
+		virtual void set_scaler([[maybe_unused]] scaler_quality quality, [[maybe_unused]] AVColorSpace colorspace,
+								[[maybe_unused]] AVColorRange range)
+		{}
+
+		/** Wrap an OBS texture as a hardware frame, without copying it.
+		 *
+		 * The texture stays locked until unlock_from_obs() or until the last reference to the frame is gone,
+		 * whichever comes first, which has to happen before OBS gets control back. These frames must never end up in
+		 * a frame pool.
+		 * @return nullptr if the texture can't be used as a frame directly, copy_from_obs() has to be used instead.
+		 */
 		virtual std::shared_ptr<AVFrame> avframe_from_obs(AVBufferRef* frames, uint32_t handle, uint64_t lock_key,
 														  uint64_t* next_lock_key) = 0;
+
+		/** Hand the texture of a frame from avframe_from_obs() back to OBS once it was submitted to the encoder,
+		 * even if the encoder still references the frame.
+		 */
+		virtual void unlock_from_obs([[maybe_unused]] std::shared_ptr<AVFrame> frame) {}
 	};
 
 	class base {
@@ -66,5 +121,8 @@ namespace streamfx::ffmpeg::hwapi {
 		virtual std::shared_ptr<hwapi::instance> create(hwapi::device target) = 0;
 
 		virtual std::shared_ptr<hwapi::instance> create_from_obs() = 0;
+
+		/** Identifier of the adapter OBS renders on, as reported by enumerate_adapters(). */
+		virtual std::pair<int64_t, int64_t> get_obs_adapter() = 0;
 	};
 } // namespace streamfx::ffmpeg::hwapi
@@ -0,0 +1,272 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2019 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "cuda.hpp"
+#include "nvidia/cuda/nvidia-cuda-host-memory.hpp"
+#include "obs/gs/gs-helper.hpp"
+
+extern "C" {
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4242 4244 4365)
+#endif
+// hwcontext_cuda.h only needs the opaque handle types from the CUDA SDK, which are provided here instead.
+#ifndef CUDA_VERSION
+#define CUDA_VERSION 0
+typedef struct CUctx_st*    CUcontext;
+typedef struct CUstream_st* CUstream;
+#endif
+#include <libavutil/hwcontext_cuda.h>
+#include <libavutil/imgutils.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+}
+
+using namespace streamfx::ffmpeg::hwapi;
+
+cuda::cuda() : _cuda(::streamfx::nvidia::cuda::obs::get()) {}
+
+cuda::~cuda() {}
+
+std::list<device> cuda::enumerate_adapters()
+{
+	// Only the device OBS renders on can share textures with us, so that is the only one we offer.
+	std::list<device> adapters;
+
+	device dev;
+	dev.name      = "NVIDIA CUDA (OBS)";
+	dev.id.first  = 0;
+	dev.id.second = 0;
+	adapters.push_back(dev);
+
+	return adapters;
+}
+
+std::shared_ptr<instance> cuda::create(device)
+{
+	return create_from_obs();
+}
+
+std::shared_ptr<instance> cuda::create_from_obs()
+{
+	return std::make_shared<cuda_instance>(_cuda);
+}
+
+std::pair<int64_t, int64_t> cuda::get_obs_adapter()
+{
+	return {0, 0};
+}
+
+cuda_instance::cuda_instance(std::shared_ptr<::streamfx::nvidia::cuda::obs> cuda) : _cuda(cuda), _textures() {}
+
+cuda_instance::~cuda_instance()
+{
+	// Texture registrations must be released with the graphics context held.
+	auto gctx = streamfx::obs::gs::context();
+	_textures.clear();
+}
+
+AVBufferRef* cuda_instance::create_device_context()
+{
+	AVBufferRef* dctx_ref = av_hwdevice_ctx_alloc(AV_HWDEVICE_TYPE_CUDA);
+	if (!dctx_ref)
+		throw std::runtime_error("Failed to allocate AVHWDeviceContext.");
+
+	AVHWDeviceContext*   dctx   = reinterpret_cast<AVHWDeviceContext*>(dctx_ref->data);
+	AVCUDADeviceContext* cudadc = reinterpret_cast<AVCUDADeviceContext*>(dctx->hwctx);
+
+	// Share the context and stream with the rest of StreamFX, this is what keeps the frames on the GPU.
+	cudadc->cuda_ctx = reinterpret_cast<CUcontext>(_cuda->get_context()->get());
+	cudadc->stream   = reinterpret_cast<CUstream>(_cuda->get_stream()->get());
+
+	int ret = av_hwdevice_ctx_init(dctx_ref);
+	if (ret < 0) {
+		av_buffer_unref(&dctx_ref);
+		throw std::runtime_error("Failed to initialize AVHWDeviceContext.");
+	}
+
+	return dctx_ref;
+}
+
+AVPixelFormat cuda_instance::get_pixel_format()
+{
+	return AV_PIX_FMT_CUDA;
+}
+
+std::shared_ptr<AVFrame> cuda_instance::allocate_frame(AVBufferRef* frames)
+{
+	auto stack = _cuda->get_context()->enter();
+
+	// Allocate a frame.
+	auto frame = std::shared_ptr<AVFrame>(av_frame_alloc(), [](AVFrame* frame) {
+		av_frame_unref(frame);
+		av_frame_free(&frame);
+	});
+
+	// Create the necessary buffers.
+	if (av_hwframe_get_buffer(frames, frame.get(), 0) < 0) {
+		throw std::runtime_error("Failed to create AVFrame.");
+	}
+
+	return frame;
+}
+
+static void release_host_memory(void* opaque, uint8_t*)
+{
+	delete reinterpret_cast<std::shared_ptr<::streamfx::nvidia::cuda::host_memory>*>(opaque);
+}
+
+std::shared_ptr<AVFrame> cuda_instance::allocate_upload_frame(int32_t width, int32_t height, AVPixelFormat format)
+{
+	if (!::streamfx::nvidia::cuda::host_memory::is_available()) {
+		return instance::allocate_upload_frame(width, height, format);
+	}
+
+	int size = av_image_get_buffer_size(format, width, height, 32);
+	if (size < 0) {
+		throw std::runtime_error("Failed to calculate size of upload frame.");
+	}
+
+	// Uploads from pinned memory are a single DMA transfer, instead of a copy into a driver owned staging buffer first.
+	auto memory = std::make_shared<::streamfx::nvidia::cuda::host_memory>(_cuda->get_context(),
+																		  static_cast<std::size_t>(size));
+	auto frame  = std::shared_ptr<AVFrame>(av_frame_alloc(), [](AVFrame* frame) { av_frame_free(&frame); });
+	frame->width  = width;
+	frame->height = height;
+	frame->format = format;
+
+	// The buffer keeps the memory alive for as long as anything references the frame.
+	auto* owner   = new std::shared_ptr<::streamfx::nvidia::cuda::host_memory>(memory);
+	frame->buf[0] = av_buffer_create(reinterpret_cast<uint8_t*>(memory->get()), size, release_host_memory, owner, 0);
+	if (!frame->buf[0]) {
+		delete owner;
+		throw std::runtime_error("Failed to create upload frame.");
+	}
+
+	if (av_image_fill_arrays(frame->data, frame->linesize, frame->buf[0]->data, format, width, height, 32) < 0) {
+		throw std::runtime_error("Failed to lay out upload frame.");
+	}
+
+	return frame;
+}
+
+int cuda_instance::upload_frame(std::shared_ptr<AVFrame> frame, std::shared_ptr<AVFrame> upload)
+{
+	auto stack = _cuda->get_context()->enter();
+
+	if (int res = instance::upload_frame(frame, upload); res < 0) {
+		return res;
+	}
+
+	// FFmpeg doesn't wait for uploads, which from pinned memory really are asynchronous.
+	_cuda->get_stream()->synchronize();
+	return 0;
+}
+
+bool cuda_instance::copy_from_obs(AVBufferRef*, uint32_t handle, uint64_t lock_key, uint64_t*,
+								  std::shared_ptr<AVFrame> frame)
+{
+	using namespace ::streamfx::nvidia::cuda;
+
+	auto gctx    = streamfx::obs::gs::context();
+	auto texture = get_texture(handle);
+	auto api     = _cuda->get_cuda();
+	auto stream  = _cuda->get_stream();
+
+#ifdef WIN32
+	// Attempt to acquire texture lock.
+	if (gs_texture_acquire_sync(texture->get_texture()->get_object(), lock_key, 1000) != 0) {
+		throw std::runtime_error("Failed to acquire lock on input texture.");
+	}
+#endif
+
+	try {
+		auto stack = _cuda->get_context()->enter();
+
+		// NV12 and P010 are exposed as two arrays: full resolution luma, and half resolution interleaved chroma.
+		array_t planes[2] = {texture->map(stream), nullptr};
+		if (api->cuGraphicsSubResourceGetMappedArray(&planes[1], texture->get(), 1, 0) != result::SUCCESS) {
+			throw std::runtime_error("Failed to retrieve chroma plane of input texture.");
+		}
+
+		// P010 stores every sample in 16 bits.
+		AVHWFramesContext* frames = reinterpret_cast<AVHWFramesContext*>(frame->hw_frames_ctx->data);
+		std::size_t        bpp    = (frames->sw_format == AV_PIX_FMT_P010) ? 2 : 1;
+
+		for (std::size_t idx = 0; idx < 2; idx++) {
+			memcpy2d_v2_t mc    = {};
+			mc.src_memory_type  = memory_type::ARRAY;
+			mc.src_array        = planes[idx];
+			mc.dst_memory_type  = memory_type::DEVICE;
+			mc.dst_device       = reinterpret_cast<device_ptr_t>(frame->data[idx]);
+			mc.dst_pitch        = static_cast<std::size_t>(frame->linesize[idx]);
+			mc.width_in_bytes   = static_cast<std::size_t>(frame->width) * bpp;
+			mc.height           = static_cast<std::size_t>(idx == 0 ? frame->height : (frame->height + 1) / 2);
+			if (api->cuMemcpy2DAsync(&mc, stream->get()) != result::SUCCESS) {
+				throw std::runtime_error("Failed to copy input texture.");
+			}
+		}
+
+		texture->unmap();
+		stream->synchronize();
+	} catch (...) {
+		texture->unmap();
+#ifdef WIN32
+		gs_texture_release_sync(texture->get_texture()->get_object(), lock_key);
+#endif
+		throw;
+	}
+
+#ifdef WIN32
+	// Release the acquired lock.
+	gs_texture_release_sync(texture->get_texture()->get_object(), lock_key);
+#endif
+
+	return true;
+}
+
+std::shared_ptr<AVFrame> cuda_instance::avframe_from_obs(AVBufferRef*, uint32_t, uint64_t, uint64_t*)
+{
+	// Mapped OBS textures are CUDA arrays, while encoders expect linear device memory, so it always takes a copy.
+	return nullptr;
+}
+
+std::shared_ptr<::streamfx::nvidia::cuda::gstexture> cuda_instance::get_texture(uint32_t handle)
+{
+	if (auto kv = _textures.find(handle); kv != _textures.end()) {
+		return kv->second;
+	}
+
+#ifdef WIN32
+	gs_texture_t* tex = gs_texture_open_shared(handle);
+	if (!tex) {
+		throw std::runtime_error("Failed to open shared texture resource.");
+	}
+
+	auto texture = std::make_shared<::streamfx::nvidia::cuda::gstexture>(
+		std::make_shared<streamfx::obs::gs::texture>(tex, true));
+	_textures.emplace(handle, texture);
+	return texture;
+#else
+	throw std::runtime_error("OBS Studio does not expose shared textures on this platform.");
+#endif
+}
@@ -22,6 +22,8 @@
 #ifdef WIN32
 
 #include "d3d11.hpp"
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 #include <vector>
 #include "obs/gs/gs-helper.hpp"
@@ -81,8 +83,12 @@ std::list<device> d3d11::enumerate_adapters()
 	std::list<device> adapters;
 
 	// Enumerate Adapters
-	IDXGIAdapter1* dxgi_adapter = nullptr;
-	for (UINT idx = 0; !FAILED(_dxgifactory->EnumAdapters1(idx, &dxgi_adapter)); idx++) {
+	for (UINT idx = 0;; idx++) {
+		ATL::CComPtr<IDXGIAdapter1> dxgi_adapter;
+		if (FAILED(_dxgifactory->EnumAdapters1(idx, &dxgi_adapter))) {
+			break;
+		}
+
 		DXGI_ADAPTER_DESC1 desc = DXGI_ADAPTER_DESC1();
 		dxgi_adapter->GetDesc1(&desc);
 
@@ -107,11 +113,15 @@ std::shared_ptr<instance> d3d11::create(device target)
 	std::shared_ptr<d3d11_instance>   inst;
 	ATL::CComPtr<ID3D11Device>        device;
 	ATL::CComPtr<ID3D11DeviceContext> context;
-	IDXGIAdapter1*                    adapter = nullptr;
+	ATL::CComPtr<IDXGIAdapter1>       adapter;
 
 	// Find the correct "Adapter" (device).
-	IDXGIAdapter1* dxgi_adapter = nullptr;
-	for (UINT idx = 0; !FAILED(_dxgifactory->EnumAdapters1(idx, &dxgi_adapter)); idx++) {
+	for (UINT idx = 0;; idx++) {
+		ATL::CComPtr<IDXGIAdapter1> dxgi_adapter;
+		if (FAILED(_dxgifactory->EnumAdapters1(idx, &dxgi_adapter))) {
+			break;
+		}
+
 		DXGI_ADAPTER_DESC1 desc = DXGI_ADAPTER_DESC1();
 		dxgi_adapter->GetDesc1(&desc);
 
@@ -120,19 +130,30 @@ std::shared_ptr<instance> d3d11::create(device target)
 			break;
 		}
 	}
+	if (!adapter) {
+		throw std::runtime_error("Failed to find adapter for target.");
+	}
 
 	// Create a D3D11 Device
 	UINT                           device_flags   = D3D11_CREATE_DEVICE_VIDEO_SUPPORT;
 	std::vector<D3D_FEATURE_LEVEL> feature_levels = {D3D_FEATURE_LEVEL_12_1, D3D_FEATURE_LEVEL_12_0,
 													 D3D_FEATURE_LEVEL_11_1};
 
-	if (FAILED(_D3D11CreateDevice(adapter, D3D_DRIVER_TYPE_HARDWARE, NULL, device_flags, feature_levels.data(),
+	// An explicit adapter requires the "unknown" driver type, anything else is rejected as an invalid argument.
+	if (FAILED(_D3D11CreateDevice(adapter, D3D_DRIVER_TYPE_UNKNOWN, NULL, device_flags, feature_levels.data(),
 								  static_cast<UINT>(feature_levels.size()), D3D11_SDK_VERSION, &device, NULL,
 								  &context))) {
 		throw std::runtime_error("Failed to create D3D11 device for target.");
 	}
 
-	return std::make_shared<d3d11_instance>(device, context);
+	// Shared textures can't be opened on another adapter, so those need OBS's device to read them back.
+	auto                       gctx = streamfx::obs::gs::context();
+	ATL::CComPtr<ID3D11Device> obs_device;
+	if (target.id != get_obs_adapter()) {
+		obs_device = reinterpret_cast<ID3D11Device*>(gs_get_device_obj());
+	}
+
+	return std::make_shared<d3d11_instance>(device, context, obs_device);
 }
 
 std::shared_ptr<instance> d3d11::create_from_obs()
@@ -151,14 +172,51 @@ std::shared_ptr<instance> d3d11::create_from_obs()
 	return std::make_shared<d3d11_instance>(device, context);
 }
 
+std::pair<int64_t, int64_t> d3d11::get_obs_adapter()
+{
+	auto gctx = streamfx::obs::gs::context();
+
+	if (GS_DEVICE_DIRECT3D_11 != gs_get_device_type()) {
+		throw std::runtime_error("OBS Device is not a D3D11 Device.");
+	}
+
+	ATL::CComPtr<IDXGIDevice>  dxgi_device;
+	ATL::CComPtr<IDXGIAdapter> dxgi_adapter;
+	auto                       device = reinterpret_cast<ID3D11Device*>(gs_get_device_obj());
+	if (FAILED(device->QueryInterface(__uuidof(IDXGIDevice), reinterpret_cast<void**>(&dxgi_device)))
+		|| FAILED(dxgi_device->GetAdapter(&dxgi_adapter))) {
+		throw std::runtime_error("Failed to retrieve adapter of OBS device.");
+	}
+
+	DXGI_ADAPTER_DESC desc = DXGI_ADAPTER_DESC();
+	dxgi_adapter->GetDesc(&desc);
+	return {desc.AdapterLuid.HighPart, desc.AdapterLuid.LowPart};
+}
+
 struct D3D11AVFrame {
 	ATL::CComPtr<ID3D11Texture2D> handle;
 };
 
-d3d11_instance::d3d11_instance(ATL::CComPtr<ID3D11Device> device, ATL::CComPtr<ID3D11DeviceContext> context)
+d3d11_instance::d3d11_instance(ATL::CComPtr<ID3D11Device> device, ATL::CComPtr<ID3D11DeviceContext> context,
+							   ATL::CComPtr<ID3D11Device> obs_device)
+	: _obs_device(obs_device), _obs_context(), _transfer_download(), _transfer_upload(), _transfer_texture(),
+	  _ring(), _ring_size(0), _ring_index(0), _scratch(), _video_device(), _video_context(), _scaler_enum(),
+	  _scaler(), _scaler_desc(), _scaler_color(), _scaler_quality(scaler_quality::NORMAL), _shared()
 {
 	_device  = device;
 	_context = context;
+	if (_obs_device) {
+		_obs_device->GetImmediateContext(&_obs_context);
+	}
+
+	// Scaling relies on the video processor, which is missing on devices without video support.
+	if (FAILED(_device->QueryInterface(__uuidof(ID3D11VideoDevice), reinterpret_cast<void**>(&_video_device)))
+		|| FAILED(
+			_context->QueryInterface(__uuidof(ID3D11VideoContext), reinterpret_cast<void**>(&_video_context)))) {
+		_video_device.Release();
+		_video_context.Release();
+	}
+	set_scaler(scaler_quality::NORMAL, AVCOL_SPC_BT709, AVCOL_RANGE_MPEG);
 }
 
 d3d11_instance::~d3d11_instance() {}
@@ -187,6 +245,22 @@ AVBufferRef* d3d11_instance::create_device_context()
 	return dctx_ref;
 }
 
+AVPixelFormat d3d11_instance::get_pixel_format()
+{
+	return AV_PIX_FMT_D3D11;
+}
+
+void d3d11_instance::prepare_frames(AVHWFramesContext* frames)
+{
+	// Lets the video processor scale straight into the frames, instead of into a texture that is then copied.
+	UINT        support = 0;
+	DXGI_FORMAT format  = (frames->sw_format == AV_PIX_FMT_P010) ? DXGI_FORMAT_P010 : DXGI_FORMAT_NV12;
+	if (can_scale() && SUCCEEDED(_device->CheckFormatSupport(format, &support))
+		&& ((support & D3D11_FORMAT_SUPPORT_RENDER_TARGET) != 0)) {
+		reinterpret_cast<AVD3D11VAFramesContext*>(frames->hwctx)->BindFlags |= D3D11_BIND_RENDER_TARGET;
+	}
+}
+
 std::shared_ptr<AVFrame> d3d11_instance::allocate_frame(AVBufferRef* frames)
 {
 	auto gctx = streamfx::obs::gs::context();
@@ -208,26 +282,78 @@ std::shared_ptr<AVFrame> d3d11_instance::allocate_frame(AVBufferRef* frames)
 	return frame;
 }
 
-void d3d11_instance::copy_from_obs(AVBufferRef*, uint32_t handle, uint64_t lock_key, uint64_t* next_lock_key,
+bool d3d11_instance::copy_from_obs(AVBufferRef* frames, uint32_t handle, uint64_t lock_key, uint64_t* next_lock_key,
 								   std::shared_ptr<AVFrame> frame)
 {
 	auto gctx = streamfx::obs::gs::context();
 
-	// Attempt to acquire shared texture.
-	ATL::CComPtr<ID3D11Texture2D> input;
-	if (FAILED(_device->OpenSharedResource(reinterpret_cast<HANDLE>(static_cast<uintptr_t>(handle)),
-										   __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&input)))) {
-		throw std::runtime_error("Failed to open shared texture resource.");
+	// Frames without buffers take the next frame of the ring, but never wait for the encoder to let go of it.
+	std::shared_ptr<AVFrame> slot = frame;
+	if (!frame->buf[0]) {
+		if (_ring_size == 0) {
+			throw std::invalid_argument("Frame has no buffers, and there is no texture ring to take them from.");
+		}
+		if ((_ring.size() != _ring_size) || (_ring[0]->hw_frames_ctx->data != frames->data)) {
+			allocate_ring(frames);
+		}
+
+		slot = _ring[_ring_index];
+		if (av_buffer_get_ref_count(slot->buf[0]) > 1) {
+			return false;
+		}
 	}
 
-	// Attempt to acquire texture mutex.
+	// Frames may be slices of a texture array, with the slice index stored in the second data pointer.
+	auto target       = reinterpret_cast<ID3D11Texture2D*>(slot->data[0]);
+	UINT target_index = static_cast<UINT>(reinterpret_cast<intptr_t>(slot->data[1]));
+
+	// Attempt to acquire shared texture, which on another adapter is a copy that no longer needs the lock.
+	ATL::CComPtr<ID3D11Texture2D> input;
 	ATL::CComPtr<IDXGIKeyedMutex> mutex;
-	if (FAILED(input->QueryInterface(__uuidof(IDXGIKeyedMutex), reinterpret_cast<void**>(&mutex)))) {
-		throw std::runtime_error("Failed to retrieve mutex for texture resource.");
+	if (_obs_device) {
+		input = transfer_from_obs(handle, lock_key, next_lock_key);
+	} else {
+		if (FAILED(_device->OpenSharedResource(reinterpret_cast<HANDLE>(static_cast<uintptr_t>(handle)),
+											   __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&input)))) {
+			throw std::runtime_error("Failed to open shared texture resource.");
+		}
+
+		// Attempt to acquire texture mutex.
+		if (FAILED(input->QueryInterface(__uuidof(IDXGIKeyedMutex), reinterpret_cast<void**>(&mutex)))) {
+			throw std::runtime_error("Failed to retrieve mutex for texture resource.");
+		}
+	}
+
+	// Textures of a different size than the frames are scaled, straight into the frame if it is a render target.
+	D3D11_TEXTURE2D_DESC input_desc;
+	D3D11_TEXTURE2D_DESC target_desc;
+	input->GetDesc(&input_desc);
+	target->GetDesc(&target_desc);
+	bool scaled  = (input_desc.Width != target_desc.Width) || (input_desc.Height != target_desc.Height);
+	bool scratch = scaled && ((target_desc.BindFlags & D3D11_BIND_RENDER_TARGET) == 0);
+	if (scratch) {
+		D3D11_TEXTURE2D_DESC desc = D3D11_TEXTURE2D_DESC();
+		if (_scratch) {
+			_scratch->GetDesc(&desc);
+		}
+		if (!_scratch || (desc.Width != target_desc.Width) || (desc.Height != target_desc.Height)
+			|| (desc.Format != target_desc.Format)) {
+			desc                = target_desc;
+			desc.ArraySize      = 1;
+			desc.MipLevels      = 1;
+			desc.BindFlags      = D3D11_BIND_RENDER_TARGET;
+			desc.MiscFlags      = 0;
+			desc.Usage          = D3D11_USAGE_DEFAULT;
+			desc.CPUAccessFlags = 0;
+			_scratch.Release();
+			if (FAILED(_device->CreateTexture2D(&desc, nullptr, &_scratch))) {
+				throw std::runtime_error("Failed to create intermediate texture.");
+			}
+		}
 	}
 
 	// Attempt to acquire texture lock.
-	if (FAILED(mutex->AcquireSync(lock_key, 1000))) {
+	if (mutex && FAILED(mutex->AcquireSync(lock_key, 1000))) {
 		throw std::runtime_error("Failed to acquire lock on input texture.");
 	}
 
@@ -236,19 +362,292 @@ void d3d11_instance::copy_from_obs(AVBufferRef*, uint32_t handle, uint64_t lock_
 	input->SetEvictionPriority(DXGI_RESOURCE_PRIORITY_MAXIMUM);
 
 	// Clone the content of the input texture.
-	_context->CopyResource(reinterpret_cast<ID3D11Texture2D*>(frame->data[0]), input);
+	if (scratch) {
+		D3D11_TEXTURE2D_DESC desc;
+		_scratch->GetDesc(&desc);
+		scale(input, input_desc, _scratch, 0, desc);
+	} else if (scaled) {
+		scale(input, input_desc, target, target_index, target_desc);
+	} else {
+		_context->CopySubresourceRegion(target, target_index, 0, 0, 0, input, 0, nullptr);
+	}
 
 	// Restore original parameters on input.
 	input->SetEvictionPriority(evict);
 
-	// Release the acquired lock.
+	if (mutex) {
+		// Release the acquired lock.
+		if (FAILED(mutex->ReleaseSync(lock_key))) {
+			throw std::runtime_error("Failed to release lock on input texture.");
+		}
+
+		// Release the lock on the next texture.
+		// TODO: Determine if this is necessary.
+		mutex->ReleaseSync(*next_lock_key);
+	}
+
+	// The scaled copy no longer depends on OBS's texture, so it is moved into the frame without holding the lock.
+	if (scratch) {
+		_context->CopySubresourceRegion(target, target_index, 0, 0, 0, _scratch, 0, nullptr);
+	}
+
+	// The encoder consumes the ring's frame directly, which keeps it in use until the encoder lets go of it.
+	if (slot != frame) {
+		if (av_frame_ref(frame.get(), slot.get()) < 0) {
+			throw std::runtime_error("Failed to reference frame of the texture ring.");
+		}
+		_ring_index = (_ring_index + 1) % _ring.size();
+	}
+
+	return true;
+}
+
+ATL::CComPtr<ID3D11Texture2D> d3d11_instance::transfer_from_obs(uint32_t handle, uint64_t lock_key,
+																uint64_t* next_lock_key)
+{
+	// Open the shared texture on OBS's own device, the only one that can.
+	ATL::CComPtr<ID3D11Texture2D> shared;
+	if (FAILED(_obs_device->OpenSharedResource(reinterpret_cast<HANDLE>(static_cast<uintptr_t>(handle)),
+											   __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&shared)))) {
+		throw std::runtime_error("Failed to open shared texture resource.");
+	}
+	ATL::CComPtr<IDXGIKeyedMutex> mutex;
+	if (FAILED(shared->QueryInterface(__uuidof(IDXGIKeyedMutex), reinterpret_cast<void**>(&mutex)))) {
+		throw std::runtime_error("Failed to retrieve mutex for texture resource.");
+	}
+
+	// One texture to read back on OBS's adapter, one to write to and one to work with on ours.
+	D3D11_TEXTURE2D_DESC shared_desc;
+	D3D11_TEXTURE2D_DESC desc = D3D11_TEXTURE2D_DESC();
+	shared->GetDesc(&shared_desc);
+	if (_transfer_texture) {
+		_transfer_texture->GetDesc(&desc);
+	}
+	if (!_transfer_texture || (desc.Width != shared_desc.Width) || (desc.Height != shared_desc.Height)
+		|| (desc.Format != shared_desc.Format)) {
+		_transfer_download.Release();
+		_transfer_upload.Release();
+		_transfer_texture.Release();
+
+		desc                = shared_desc;
+		desc.ArraySize      = 1;
+		desc.MipLevels      = 1;
+		desc.MiscFlags      = 0;
+		desc.BindFlags      = 0;
+		desc.Usage          = D3D11_USAGE_STAGING;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+		if (FAILED(_obs_device->CreateTexture2D(&desc, nullptr, &_transfer_download))) {
+			throw std::runtime_error("Failed to create texture to read back from.");
+		}
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		if (FAILED(_device->CreateTexture2D(&desc, nullptr, &_transfer_upload))) {
+			throw std::runtime_error("Failed to create texture to upload from.");
+		}
+		desc.BindFlags      = shared_desc.BindFlags;
+		desc.Usage          = D3D11_USAGE_DEFAULT;
+		desc.CPUAccessFlags = 0;
+		if (FAILED(_device->CreateTexture2D(&desc, nullptr, &_transfer_texture))) {
+			throw std::runtime_error("Failed to create intermediate texture.");
+		}
+	}
+
+	// OBS's texture is only locked for the copy on its own adapter, not for the trip through system memory.
+	if (FAILED(mutex->AcquireSync(lock_key, 1000))) {
+		throw std::runtime_error("Failed to acquire lock on input texture.");
+	}
+	_obs_context->CopyResource(_transfer_download, shared);
 	if (FAILED(mutex->ReleaseSync(lock_key))) {
 		throw std::runtime_error("Failed to release lock on input texture.");
 	}
-
-	// Release the lock on the next texture.
-	// TODO: Determine if this is necessary.
 	mutex->ReleaseSync(*next_lock_key);
+
+	// Mapping waits for the copy to finish. The planes of NV12 and P010 follow each other with the same pitch.
+	D3D11_MAPPED_SUBRESOURCE source;
+	D3D11_MAPPED_SUBRESOURCE target;
+	if (FAILED(_obs_context->Map(_transfer_download, 0, D3D11_MAP_READ, 0, &source))) {
+		throw std::runtime_error("Failed to read back texture.");
+	}
+	if (FAILED(_context->Map(_transfer_upload, 0, D3D11_MAP_WRITE, 0, &target))) {
+		_obs_context->Unmap(_transfer_download, 0);
+		throw std::runtime_error("Failed to map texture for upload.");
+	}
+	bool        planar = (shared_desc.Format == DXGI_FORMAT_NV12) || (shared_desc.Format == DXGI_FORMAT_P010);
+	std::size_t rows   = planar ? (shared_desc.Height + (shared_desc.Height + 1) / 2) : shared_desc.Height;
+	std::size_t length = std::min(source.RowPitch, target.RowPitch);
+	for (std::size_t row = 0; row < rows; row++) {
+		memcpy(reinterpret_cast<uint8_t*>(target.pData) + row * target.RowPitch,
+			   reinterpret_cast<const uint8_t*>(source.pData) + row * source.RowPitch, length);
+	}
+	_context->Unmap(_transfer_upload, 0);
+	_obs_context->Unmap(_transfer_download, 0);
+
+	_context->CopyResource(_transfer_texture, _transfer_upload);
+	return _transfer_texture;
+}
+
+void d3d11_instance::set_ring_size(std::size_t size)
+{
+	auto gctx = streamfx::obs::gs::context();
+
+	_ring_size  = size;
+	_ring_index = 0;
+	_ring.clear();
+}
+
+std::size_t d3d11_instance::get_ring_size()
+{
+	return _ring_size;
+}
+
+bool d3d11_instance::can_scale()
+{
+	return (_video_device != nullptr) && (_video_context != nullptr);
+}
+
+void d3d11_instance::set_scaler(scaler_quality quality, AVColorSpace colorspace, AVColorRange range)
+{
+	auto gctx = streamfx::obs::gs::context();
+
+	// Input and output share the color space, so the video processor only ever scales.
+	_scaler_quality             = quality;
+	_scaler_color               = D3D11_VIDEO_PROCESSOR_COLOR_SPACE();
+	_scaler_color.YCbCr_Matrix  = ((colorspace == AVCOL_SPC_BT470BG) || (colorspace == AVCOL_SPC_SMPTE170M)) ? 0 : 1;
+	_scaler_color.Nominal_Range = (range == AVCOL_RANGE_JPEG) ? D3D11_VIDEO_PROCESSOR_NOMINAL_RANGE_0_255
+															  : D3D11_VIDEO_PROCESSOR_NOMINAL_RANGE_16_235;
+	_scaler.Release();
+	_scaler_enum.Release();
+}
+
+void d3d11_instance::allocate_ring(AVBufferRef* frames)
+{
+	_ring.clear();
+	_ring_index = 0;
+
+	// Taken from the encoder's frames context, so the encoder can use them like any other frame.
+	_ring.reserve(_ring_size);
+	for (std::size_t idx = 0; idx < _ring_size; idx++) {
+		_ring.push_back(allocate_frame(frames));
+	}
+}
+
+void d3d11_instance::allocate_scaler(const D3D11_TEXTURE2D_DESC& input, const D3D11_TEXTURE2D_DESC& output)
+{
+	_scaler.Release();
+	_scaler_enum.Release();
+
+	// The scaling algorithm is up to the driver, the usage only hints at how much time it may spend on it.
+	_scaler_desc                  = D3D11_VIDEO_PROCESSOR_CONTENT_DESC();
+	_scaler_desc.InputFrameFormat = D3D11_VIDEO_FRAME_FORMAT_PROGRESSIVE;
+	_scaler_desc.InputFrameRate   = {1, 1};
+	_scaler_desc.InputWidth       = input.Width;
+	_scaler_desc.InputHeight      = input.Height;
+	_scaler_desc.OutputFrameRate  = {1, 1};
+	_scaler_desc.OutputWidth      = output.Width;
+	_scaler_desc.OutputHeight     = output.Height;
+	switch (_scaler_quality) {
+	case scaler_quality::FASTEST:
+		_scaler_desc.Usage = D3D11_VIDEO_USAGE_OPTIMAL_SPEED;
+		break;
+	case scaler_quality::BEST:
+		_scaler_desc.Usage = D3D11_VIDEO_USAGE_OPTIMAL_QUALITY;
+		break;
+	default:
+		_scaler_desc.Usage = D3D11_VIDEO_USAGE_PLAYBACK_NORMAL;
+		break;
+	}
+	if (FAILED(_video_device->CreateVideoProcessorEnumerator(&_scaler_desc, &_scaler_enum))) {
+		throw std::runtime_error("Failed to create video processor enumerator.");
+	}
+
+	UINT flags = 0;
+	if (FAILED(_scaler_enum->CheckVideoProcessorFormat(input.Format, &flags))
+		|| ((flags & D3D11_VIDEO_PROCESSOR_FORMAT_SUPPORT_INPUT) == 0)
+		|| FAILED(_scaler_enum->CheckVideoProcessorFormat(output.Format, &flags))
+		|| ((flags & D3D11_VIDEO_PROCESSOR_FORMAT_SUPPORT_OUTPUT) == 0)) {
+		_scaler_enum.Release();
+		throw std::runtime_error("Video processor does not support scaling this texture format.");
+	}
+
+	if (FAILED(_video_device->CreateVideoProcessor(_scaler_enum, 0, &_scaler))) {
+		_scaler_enum.Release();
+		throw std::runtime_error("Failed to create video processor.");
+	}
+
+	// Disable everything the driver may do on its own, such as denoising or edge enhancement.
+	_video_context->VideoProcessorSetStreamFrameFormat(_scaler, 0, D3D11_VIDEO_FRAME_FORMAT_PROGRESSIVE);
+	_video_context->VideoProcessorSetStreamAutoProcessingMode(_scaler, 0, FALSE);
+	_video_context->VideoProcessorSetStreamColorSpace(_scaler, 0, &_scaler_color);
+	_video_context->VideoProcessorSetOutputColorSpace(_scaler, &_scaler_color);
+}
+
+void d3d11_instance::scale(ID3D11Texture2D* input, const D3D11_TEXTURE2D_DESC& input_desc, ID3D11Texture2D* output,
+						   UINT output_index, const D3D11_TEXTURE2D_DESC& output_desc)
+{
+	if (!can_scale()) {
+		throw std::runtime_error("Device does not support video processing.");
+	}
+
+	if (!_scaler || (_scaler_desc.InputWidth != input_desc.Width) || (_scaler_desc.InputHeight != input_desc.Height)
+		|| (_scaler_desc.OutputWidth != output_desc.Width) || (_scaler_desc.OutputHeight != output_desc.Height)) {
+		allocate_scaler(input_desc, output_desc);
+	}
+
+	// OBS hands out a freshly opened texture every frame, so views can't be kept around.
+	D3D11_VIDEO_PROCESSOR_INPUT_VIEW_DESC input_view_desc = D3D11_VIDEO_PROCESSOR_INPUT_VIEW_DESC();
+	input_view_desc.ViewDimension                         = D3D11_VPIV_DIMENSION_TEXTURE2D;
+	ATL::CComPtr<ID3D11VideoProcessorInputView> input_view;
+	if (FAILED(_video_device->CreateVideoProcessorInputView(input, _scaler_enum, &input_view_desc, &input_view))) {
+		throw std::runtime_error("Failed to create video processor input view.");
+	}
+
+	D3D11_VIDEO_PROCESSOR_OUTPUT_VIEW_DESC output_view_desc = D3D11_VIDEO_PROCESSOR_OUTPUT_VIEW_DESC();
+	if (output_desc.ArraySize > 1) {
+		output_view_desc.ViewDimension                  = D3D11_VPOV_DIMENSION_TEXTURE2DARRAY;
+		output_view_desc.Texture2DArray.FirstArraySlice = output_index;
+		output_view_desc.Texture2DArray.ArraySize       = 1;
+	} else {
+		output_view_desc.ViewDimension = D3D11_VPOV_DIMENSION_TEXTURE2D;
+	}
+	ATL::CComPtr<ID3D11VideoProcessorOutputView> output_view;
+	if (FAILED(
+			_video_device->CreateVideoProcessorOutputView(output, _scaler_enum, &output_view_desc, &output_view))) {
+		throw std::runtime_error("Failed to create video processor output view.");
+	}
+
+	D3D11_VIDEO_PROCESSOR_STREAM stream = D3D11_VIDEO_PROCESSOR_STREAM();
+	stream.Enable                       = TRUE;
+	stream.pInputSurface                = input_view;
+	if (FAILED(_video_context->VideoProcessorBlt(_scaler, output_view, 0, 1, &stream))) {
+		throw std::runtime_error("Failed to scale texture.");
+	}
+}
+
+struct d3d11_wrapped_texture {
+	ATL::CComPtr<ID3D11Texture2D> texture;
+	ATL::CComPtr<IDXGIKeyedMutex> mutex;
+	uint64_t                      lock_key;
+	UINT                          evict;
+	bool                          locked;
+};
+
+// Called with the graphics context held.
+static void unlock_wrapped_texture(d3d11_wrapped_texture* wrapped)
+{
+	if (wrapped->locked) {
+		wrapped->texture->SetEvictionPriority(wrapped->evict);
+		wrapped->mutex->ReleaseSync(wrapped->lock_key);
+		wrapped->locked = false;
+	}
+}
+
+static void release_wrapped_texture(void* opaque, uint8_t*)
+{
+	auto wrapped = reinterpret_cast<d3d11_wrapped_texture*>(opaque);
+	{
+		auto gctx = streamfx::obs::gs::context();
+		unlock_wrapped_texture(wrapped);
+	}
+	delete wrapped;
 }
 
 std::shared_ptr<AVFrame> d3d11_instance::avframe_from_obs(AVBufferRef* frames, uint32_t handle, uint64_t lock_key,
@@ -256,9 +655,79 @@ std::shared_ptr<AVFrame> d3d11_instance::avframe_from_obs(AVBufferRef* frames, u
 {
 	auto gctx = streamfx::obs::gs::context();
 
-	auto frame = this->allocate_frame(frames);
-	this->copy_from_obs(frames, handle, lock_key, next_lock_key, frame);
+	// Textures of OBS's adapter can't be wrapped for another one.
+	if (_obs_device) {
+		return nullptr;
+	}
+
+	// Encoders register the textures they are given, so hand out the same texture for the same handle every time.
+	ATL::CComPtr<ID3D11Texture2D> input;
+	if (auto kv = _shared.find(handle); kv != _shared.end()) {
+		input = kv->second;
+	} else {
+		if (FAILED(_device->OpenSharedResource(reinterpret_cast<HANDLE>(static_cast<uintptr_t>(handle)),
+											   __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&input)))) {
+			throw std::runtime_error("Failed to open shared texture resource.");
+		}
+		_shared.emplace(handle, input);
+	}
+
+	// Only textures that look exactly like the frames the encoder would have allocated can take their place.
+	AVHWFramesContext*   frames_ctx = reinterpret_cast<AVHWFramesContext*>(frames->data);
+	D3D11_TEXTURE2D_DESC input_desc;
+	input->GetDesc(&input_desc);
+	DXGI_FORMAT format = (frames_ctx->sw_format == AV_PIX_FMT_P010) ? DXGI_FORMAT_P010 : DXGI_FORMAT_NV12;
+	if ((input_desc.Width != static_cast<UINT>(frames_ctx->width))
+		|| (input_desc.Height != static_cast<UINT>(frames_ctx->height)) || (input_desc.Format != format)
+		|| (input_desc.ArraySize != 1)) {
+		return nullptr;
+	}
+
+	auto wrapped = std::make_unique<d3d11_wrapped_texture>();
+	if (FAILED(input->QueryInterface(__uuidof(IDXGIKeyedMutex), reinterpret_cast<void**>(&wrapped->mutex)))) {
+		throw std::runtime_error("Failed to retrieve mutex for texture resource.");
+	}
+	if (FAILED(wrapped->mutex->AcquireSync(lock_key, 1000))) {
+		throw std::runtime_error("Failed to acquire lock on input texture.");
+	}
+	wrapped->texture  = input;
+	wrapped->lock_key = lock_key;
+	wrapped->evict    = input->GetEvictionPriority();
+	wrapped->locked   = true;
+	input->SetEvictionPriority(DXGI_RESOURCE_PRIORITY_MAXIMUM);
+	*next_lock_key = lock_key;
+
+	auto frame = std::shared_ptr<AVFrame>(av_frame_alloc(), [](AVFrame* frame) {
+		av_frame_unref(frame);
+		av_frame_free(&frame);
+	});
+
+	// The buffer owns the lock, so it is released once the encoder and we both let go of the frame.
+	frame->buf[0] = av_buffer_create(reinterpret_cast<uint8_t*>(static_cast<ID3D11Texture2D*>(input)), 0,
+									 release_wrapped_texture, wrapped.get(), 0);
+	if (!frame->buf[0]) {
+		release_wrapped_texture(wrapped.release(), nullptr);
+		throw std::runtime_error("Failed to wrap texture resource.");
+	}
+	wrapped.release();
+
+	frame->data[0]       = reinterpret_cast<uint8_t*>(static_cast<ID3D11Texture2D*>(input));
+	frame->data[1]       = nullptr; // Not part of a texture array, so always the first slice.
+	frame->format        = AV_PIX_FMT_D3D11;
+	frame->width         = frames_ctx->width;
+	frame->height        = frames_ctx->height;
+	frame->hw_frames_ctx = av_buffer_ref(frames);
 	return frame;
 }
 
+void d3d11_instance::unlock_from_obs(std::shared_ptr<AVFrame> frame)
+{
+	if (!frame || !frame->buf[0] || (av_buffer_get_opaque(frame->buf[0]) == nullptr)) {
+		return;
+	}
+
+	auto gctx = streamfx::obs::gs::context();
+	unlock_wrapped_texture(reinterpret_cast<d3d11_wrapped_texture*>(av_buffer_get_opaque(frame->buf[0])));
+}
+
 #endif
@@ -21,6 +21,7 @@
 
 #pragma once
 #include "base.hpp"
+#include <map>
 
 #ifdef _MSC_VER
 #pragma warning(push)
@@ -60,24 +61,78 @@ namespace streamfx::ffmpeg::hwapi {
 		virtual std::shared_ptr<hwapi::instance> create(hwapi::device target) override;
 
 		virtual std::shared_ptr<hwapi::instance> create_from_obs() override;
+
+		virtual std::pair<int64_t, int64_t> get_obs_adapter() override;
 	};
 
 	class d3d11_instance : public streamfx::ffmpeg::hwapi::instance {
 		ATL::CComPtr<ID3D11Device>        _device;
 		ATL::CComPtr<ID3D11DeviceContext> _context;
 
+		// OBS's device, if it renders on another adapter. Its textures then take a trip through system memory.
+		ATL::CComPtr<ID3D11Device>        _obs_device;
+		ATL::CComPtr<ID3D11DeviceContext> _obs_context;
+		ATL::CComPtr<ID3D11Texture2D>     _transfer_download;
+		ATL::CComPtr<ID3D11Texture2D>     _transfer_upload;
+		ATL::CComPtr<ID3D11Texture2D>     _transfer_texture;
+
+		// Frames handed to the encoder in turn, the keyed mutex is only held while copying into one of them.
+		std::vector<std::shared_ptr<AVFrame>> _ring;
+		std::size_t                           _ring_size;
+		std::size_t                           _ring_index;
+
+		// Scaled copy of the OBS texture, for frames that the video processor can't render to.
+		ATL::CComPtr<ID3D11Texture2D> _scratch;
+
+		// Scales the OBS texture when the encoder runs at a different resolution than OBS.
+		ATL::CComPtr<ID3D11VideoDevice>              _video_device;
+		ATL::CComPtr<ID3D11VideoContext>             _video_context;
+		ATL::CComPtr<ID3D11VideoProcessorEnumerator> _scaler_enum;
+		ATL::CComPtr<ID3D11VideoProcessor>           _scaler;
+		D3D11_VIDEO_PROCESSOR_CONTENT_DESC           _scaler_desc;
+		D3D11_VIDEO_PROCESSOR_COLOR_SPACE            _scaler_color;
+		scaler_quality                               _scaler_quality;
+
+		// OBS textures that were opened for avframe_from_obs(), kept so encoders see the same texture every time.
+		std::map<uint32_t, ATL::CComPtr<ID3D11Texture2D>> _shared;
+
 		public:
-		d3d11_instance(ATL::CComPtr<ID3D11Device> device, ATL::CComPtr<ID3D11DeviceContext> context);
+		d3d11_instance(ATL::CComPtr<ID3D11Device> device, ATL::CComPtr<ID3D11DeviceContext> context,
+					   ATL::CComPtr<ID3D11Device> obs_device = nullptr);
 		virtual ~d3d11_instance();
 
 		virtual AVBufferRef* create_device_context() override;
 
+		virtual AVPixelFormat get_pixel_format() override;
+
+		virtual void prepare_frames(AVHWFramesContext* frames) override;
+
 		virtual std::shared_ptr<AVFrame> allocate_frame(AVBufferRef* frames) override;
 
-		virtual void copy_from_obs(AVBufferRef* frames, uint32_t handle, uint64_t lock_key, uint64_t* next_lock_key,
+		virtual bool copy_from_obs(AVBufferRef* frames, uint32_t handle, uint64_t lock_key, uint64_t* next_lock_key,
 								   std::shared_ptr<AVFrame> frame) override;
 
+		virtual void set_ring_size(std::size_t size) override;
+
+		virtual std::size_t get_ring_size() override;
+
+		virtual bool can_scale() override;
+
+		virtual void set_scaler(scaler_quality quality, AVColorSpace colorspace, AVColorRange range) override;
+
 		virtual std::shared_ptr<AVFrame> avframe_from_obs(AVBufferRef* frames, uint32_t handle, uint64_t lock_key,
 														  uint64_t* next_lock_key) override;
+
+		virtual void unlock_from_obs(std::shared_ptr<AVFrame> frame) override;
+
+		private:
+		ATL::CComPtr<ID3D11Texture2D> transfer_from_obs(uint32_t handle, uint64_t lock_key, uint64_t* next_lock_key);
+
+		void allocate_ring(AVBufferRef* frames);
+
+		void allocate_scaler(const D3D11_TEXTURE2D_DESC& input, const D3D11_TEXTURE2D_DESC& output);
+
+		void scale(ID3D11Texture2D* input, const D3D11_TEXTURE2D_DESC& input_desc, ID3D11Texture2D* output,
+				   UINT output_index, const D3D11_TEXTURE2D_DESC& output_desc);
 	};
 } // namespace streamfx::ffmpeg::hwapi
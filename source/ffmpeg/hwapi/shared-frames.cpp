@@ -0,0 +1,147 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2022 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "shared-frames.hpp"
+#include <stdexcept>
+#include "ffmpeg/tools.hpp"
+#include "plugin.hpp"
+
+#define ST_PREFIX "<ffmpeg::hwapi::shared_frames> "
+
+std::mutex streamfx::ffmpeg::hwapi::shared_frames::_registry_lock;
+std::map<streamfx::ffmpeg::hwapi::shared_frames::key_t, std::weak_ptr<streamfx::ffmpeg::hwapi::shared_frames>>
+	streamfx::ffmpeg::hwapi::shared_frames::_registry;
+
+streamfx::ffmpeg::hwapi::shared_frames::shared_frames(const key_t& key, std::shared_ptr<hwapi::instance> instance)
+	: _key(key), _instance(instance), _device(nullptr), _frames(nullptr), _lock(), _sequence(0), _entries(),
+	  _members()
+{
+	_device = _instance->create_device_context();
+	if (!_device) {
+		throw std::runtime_error("Creating hardware device failed.");
+	}
+
+	_frames = av_hwframe_ctx_alloc(_device);
+	if (!_frames) {
+		av_buffer_unref(&_device);
+		throw std::runtime_error("Creating hardware frames failed.");
+	}
+
+	AVHWFramesContext* ctx = reinterpret_cast<AVHWFramesContext*>(_frames->data);
+	ctx->width             = std::get<1>(key);
+	ctx->height            = std::get<2>(key);
+	ctx->format            = std::get<3>(key);
+	ctx->sw_format         = std::get<4>(key);
+	_instance->prepare_frames(ctx);
+	if (int32_t res = av_hwframe_ctx_init(_frames); res < 0) {
+		av_buffer_unref(&_frames);
+		av_buffer_unref(&_device);
+		throw std::runtime_error(std::string("Initializing hardware frames failed: ")
+								 + ::streamfx::ffmpeg::tools::get_error_description(res));
+	}
+}
+
+streamfx::ffmpeg::hwapi::shared_frames::~shared_frames()
+{
+	// Frames still held by encoders keep the frames context alive on their own.
+	_entries.clear();
+	av_buffer_unref(&_frames);
+	av_buffer_unref(&_device);
+}
+
+AVBufferRef* streamfx::ffmpeg::hwapi::shared_frames::get_device_context()
+{
+	return _device;
+}
+
+AVBufferRef* streamfx::ffmpeg::hwapi::shared_frames::get_frames_context()
+{
+	return _frames;
+}
+
+void streamfx::ffmpeg::hwapi::shared_frames::join(const void* member)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	// Copies made before joining may be of any age, so only those made afterwards are taken.
+	_members[member] = _sequence;
+	if (_members.size() > 1) {
+		DLOG_INFO(ST_PREFIX "%zu encoders now share one copy of every frame.", _members.size());
+	}
+}
+
+void streamfx::ffmpeg::hwapi::shared_frames::leave(const void* member)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	_members.erase(member);
+	for (auto& kv : _entries) {
+		kv.second.consumers.erase(member);
+	}
+}
+
+std::shared_ptr<AVFrame> streamfx::ffmpeg::hwapi::shared_frames::acquire(const void* member, uint32_t handle,
+																		  uint64_t lock_key, uint64_t* next_lock_key)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	uint64_t&                    seen = _members[member];
+
+	auto iter = _entries.find(handle);
+	if ((iter == _entries.end()) || (iter->second.sequence <= seen) || iter->second.consumers.count(member)) {
+		// Either nobody copied this texture yet, or OBS has since written a new frame to it.
+		auto frame = _instance->allocate_frame(_frames);
+		if (!_instance->copy_from_obs(_frames, handle, lock_key, next_lock_key, frame)) {
+			return nullptr;
+		}
+
+		auto& value     = _entries[handle];
+		value.frame     = frame;
+		value.sequence  = ++_sequence;
+		value.consumers = {};
+		iter            = _entries.find(handle);
+	} else {
+		// The copy is done already, so the texture is not even opened and its lock is passed on unchanged.
+		*next_lock_key = lock_key;
+	}
+
+	iter->second.consumers.insert(member);
+	seen = iter->second.sequence;
+
+	// Every encoder changes the timestamp and color information of its frame, so each gets its own.
+	return std::shared_ptr<AVFrame>(av_frame_clone(iter->second.frame.get()), [](AVFrame* frame) {
+		av_frame_unref(frame);
+		av_frame_free(&frame);
+	});
+}
+
+std::shared_ptr<streamfx::ffmpeg::hwapi::shared_frames>
+	streamfx::ffmpeg::hwapi::shared_frames::get(const key_t& key, std::shared_ptr<hwapi::instance> instance)
+{
+	std::unique_lock<std::mutex> lock(_registry_lock);
+	if (auto iter = _registry.find(key); iter != _registry.end()) {
+		if (auto value = iter->second.lock(); value) {
+			return value;
+		}
+	}
+
+	auto value     = std::make_shared<hwapi::shared_frames>(key, instance);
+	_registry[key] = value;
+	return value;
+}
@@ -0,0 +1,97 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2022 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+#include "common.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include "base.hpp"
+
+namespace streamfx::ffmpeg::hwapi {
+	/** Hardware frames shared by every encoder that copies the same OBS textures on the same adapter.
+	 *
+	 * OBS hands every texture encoder the same texture one after another, so the first encoder to see a texture
+	 * copies it and all others only take another reference to that copy. Whoever sees a texture again, after having
+	 * already taken it, knows that OBS has moved on and copies the new content. Encoders only share if their frames
+	 * would be identical anyway, which includes the scaling and color conversion done by copy_from_obs().
+	 *
+	 * All frames are taken from one frames context, whose buffers only return to it once every encoder let go of
+	 * them, so frames handed out must never be written to.
+	 */
+	class shared_frames {
+		public:
+		/** Adapter, width, height, hardware and software pixel format, scaler quality, color space and range. */
+		typedef std::tuple<std::pair<int64_t, int64_t>, int32_t, int32_t, AVPixelFormat, AVPixelFormat, scaler_quality,
+						   AVColorSpace, AVColorRange>
+			key_t;
+
+		private:
+		struct entry {
+			std::shared_ptr<AVFrame> frame;
+			uint64_t                 sequence;
+			std::set<const void*>    consumers;
+		};
+
+		key_t                            _key;
+		std::shared_ptr<hwapi::instance> _instance; // Of the first encoder, which does all the copying.
+		AVBufferRef*                     _device;
+		AVBufferRef*                     _frames;
+		std::mutex                       _lock;
+		uint64_t                         _sequence;
+		std::map<uint32_t, entry>        _entries; // By OBS texture handle.
+		std::map<const void*, uint64_t>  _members; // Sequence of the newest copy each member has seen.
+
+		public:
+		shared_frames(const key_t& key, std::shared_ptr<hwapi::instance> instance);
+		~shared_frames();
+
+		shared_frames(const shared_frames&) = delete;
+		shared_frames& operator=(const shared_frames&) = delete;
+
+		AVBufferRef* get_device_context();
+
+		AVBufferRef* get_frames_context();
+
+		void join(const void* member);
+
+		void leave(const void* member);
+
+		/** Frame holding the content of an OBS texture, copied if no other member did so already.
+		 *
+		 * @return nullptr if the copy could not be started without blocking, in which case next_lock_key is untouched.
+		 */
+		std::shared_ptr<AVFrame> acquire(const void* member, uint32_t handle, uint64_t lock_key,
+										 uint64_t* next_lock_key);
+
+		private:
+		static std::mutex                                           _registry_lock;
+		static std::map<key_t, std::weak_ptr<hwapi::shared_frames>> _registry;
+
+		public:
+		/** Frames shared with other encoders of the same configuration, created from the given instance if none exist.
+		 */
+		static std::shared_ptr<hwapi::shared_frames> get(const key_t& key, std::shared_ptr<hwapi::instance> instance);
+	};
+} // namespace streamfx::ffmpeg::hwapi
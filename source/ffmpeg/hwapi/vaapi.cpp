@@ -0,0 +1,148 @@
+// FFMPEG Video Encoder Integration for OBS Studio
+// Copyright (c) 2019 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "vaapi.hpp"
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include "ffmpeg/tools.hpp"
+
+extern "C" {
+#include <libavutil/hwcontext.h>
+}
+
+// Render nodes are numbered from here on, one per GPU.
+#define ST_RENDER_NODE_PATH "/dev/dri"
+#define ST_RENDER_NODE_PREFIX "renderD"
+
+using namespace streamfx::ffmpeg::hwapi;
+
+static std::string get_render_node(int64_t number)
+{
+	std::stringstream sstr;
+	sstr << ST_RENDER_NODE_PATH << "/" << ST_RENDER_NODE_PREFIX << number;
+	return sstr.str();
+}
+
+vaapi::vaapi() {}
+
+vaapi::~vaapi() {}
+
+std::list<device> vaapi::enumerate_adapters()
+{
+	std::list<device> adapters;
+
+	std::error_code ec;
+	for (auto& entry : std::filesystem::directory_iterator(ST_RENDER_NODE_PATH, ec)) {
+		std::string name = entry.path().filename().string();
+		if (name.rfind(ST_RENDER_NODE_PREFIX, 0) != 0) {
+			continue;
+		}
+
+		device dev;
+		dev.name      = entry.path().string();
+		dev.id.first  = std::strtoll(name.c_str() + strlen(ST_RENDER_NODE_PREFIX), nullptr, 10);
+		dev.id.second = 0;
+		adapters.push_back(dev);
+	}
+
+	// Directory order is arbitrary, but selections are stored by index.
+	adapters.sort([](const device& a, const device& b) { return a.id < b.id; });
+	return adapters;
+}
+
+std::shared_ptr<instance> vaapi::create(device target)
+{
+	return std::make_shared<vaapi_instance>(get_render_node(target.id.first));
+}
+
+std::shared_ptr<instance> vaapi::create_from_obs()
+{
+	auto adapters = enumerate_adapters();
+	if (adapters.empty()) {
+		throw std::runtime_error("No VA-API render nodes available.");
+	}
+	return create(adapters.front());
+}
+
+std::pair<int64_t, int64_t> vaapi::get_obs_adapter()
+{
+	// There is no portable way to ask OBS's OpenGL context for its render node, so assume the first one.
+	auto adapters = enumerate_adapters();
+	if (adapters.empty()) {
+		throw std::runtime_error("No VA-API render nodes available.");
+	}
+	return adapters.front().id;
+}
+
+vaapi_instance::vaapi_instance(std::string path) : _device(nullptr)
+{
+	if (int res = av_hwdevice_ctx_create(&_device, AV_HWDEVICE_TYPE_VAAPI, path.c_str(), nullptr, 0); res < 0) {
+		std::stringstream sstr;
+		sstr << "Failed to open VA-API device '" << path << "': "
+			 << ::streamfx::ffmpeg::tools::get_error_description(res);
+		throw std::runtime_error(sstr.str());
+	}
+}
+
+vaapi_instance::~vaapi_instance()
+{
+	av_buffer_unref(&_device);
+}
+
+AVBufferRef* vaapi_instance::create_device_context()
+{
+	AVBufferRef* dctx_ref = av_buffer_ref(_device);
+	if (!dctx_ref)
+		throw std::runtime_error("Failed to reference AVHWDeviceContext.");
+	return dctx_ref;
+}
+
+AVPixelFormat vaapi_instance::get_pixel_format()
+{
+	return AV_PIX_FMT_VAAPI;
+}
+
+std::shared_ptr<AVFrame> vaapi_instance::allocate_frame(AVBufferRef* frames)
+{
+	// Allocate a frame.
+	auto frame = std::shared_ptr<AVFrame>(av_frame_alloc(), [](AVFrame* frame) {
+		av_frame_unref(frame);
+		av_frame_free(&frame);
+	});
+
+	// Create the necessary buffers.
+	if (av_hwframe_get_buffer(frames, frame.get(), 0) < 0) {
+		throw std::runtime_error("Failed to create AVFrame.");
+	}
+
+	return frame;
+}
+
+bool vaapi_instance::copy_from_obs(AVBufferRef*, uint32_t, uint64_t, uint64_t*, std::shared_ptr<AVFrame>)
+{
+	throw std::runtime_error("OBS does not share textures with VA-API.");
+}
+
+std::shared_ptr<AVFrame> vaapi_instance::avframe_from_obs(AVBufferRef*, uint32_t, uint64_t, uint64_t*)
+{
+	return nullptr; // OBS does not share textures with VA-API.
+}
@@ -20,7 +20,27 @@
 // SOFTWARE.
 
 #include "swscale.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include "plugin.hpp"
+#include "util/util-threadpool.hpp"
+
+extern "C" {
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4242 4244 4365)
+#endif
+#include <libavutil/pixdesc.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+}
+
+// Bands smaller than this cost more in dispatch than they save.
+#define ST_MINIMUM_SLICE_HEIGHT 64
 
 using namespace streamfx::ffmpeg;
 
@@ -157,6 +177,56 @@ bool swscale::is_target_full_range()
 	return this->target_full_range;
 }
 
+void swscale::set_threads(uint32_t threads)
+{
+	this->threads = threads;
+}
+
+uint32_t swscale::get_threads()
+{
+	return this->threads;
+}
+
+uint32_t swscale::get_active_threads()
+{
+	return std::max<uint32_t>(static_cast<uint32_t>(slice_contexts.size()), 1);
+}
+
+static SwsContext* create_context(int width, int height, AVPixelFormat source_format, bool source_full_range,
+								  AVColorSpace source_colorspace, int target_width, int target_height,
+								  AVPixelFormat target_format, bool target_full_range, AVColorSpace target_colorspace,
+								  int flags)
+{
+	SwsContext* context = sws_getContext(width, height, source_format, target_width, target_height, target_format,
+										 flags, nullptr, nullptr, nullptr);
+	if (!context) {
+		return nullptr;
+	}
+
+	sws_setColorspaceDetails(context, sws_getCoefficients(source_colorspace), source_full_range ? 1 : 0,
+							 sws_getCoefficients(target_colorspace), target_full_range ? 1 : 0, 1L << 16 | 0L,
+							 1L << 16 | 0L, 1L << 16 | 0L);
+	return context;
+}
+
+static int32_t get_vertical_alignment(AVPixelFormat format)
+{
+	const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(format);
+	return desc ? (1 << desc->log2_chroma_h) : 1;
+}
+
+static void offset_planes(AVPixelFormat format, int32_t row, const int stride[], const uint8_t* const data[],
+						  const uint8_t* out[])
+{
+	const AVPixFmtDescriptor* desc   = av_pix_fmt_desc_get(format);
+	int                       planes = av_pix_fmt_count_planes(format);
+	for (int idx = 0; idx < planes; idx++) {
+		// Only the chroma planes of YUV formats are subsampled vertically.
+		int32_t shift = ((idx == 1) || (idx == 2)) ? desc->log2_chroma_h : 0;
+		out[idx]      = data[idx] + static_cast<ptrdiff_t>(row >> shift) * stride[idx];
+	}
+}
+
 bool swscale::initialize(int flags)
 {
 	if (this->context) {
@@ -172,22 +242,50 @@ bool swscale::initialize(int flags)
 	}
 
 	this->context =
-		sws_getContext(static_cast<int>(source_size.first), static_cast<int>(source_size.second), source_format,
-					   static_cast<int>(target_size.first), static_cast<int>(target_size.second), target_format, flags,
-					   nullptr, nullptr, nullptr);
+		create_context(static_cast<int>(source_size.first), static_cast<int>(source_size.second), source_format,
+					   source_full_range, source_colorspace, static_cast<int>(target_size.first),
+					   static_cast<int>(target_size.second), target_format, target_full_range, target_colorspace,
+					   flags);
 	if (!this->context) {
 		return false;
 	}
 
-	sws_setColorspaceDetails(this->context, sws_getCoefficients(source_colorspace), source_full_range ? 1 : 0,
-							 sws_getCoefficients(target_colorspace), target_full_range ? 1 : 0, 1L << 16 | 0L,
-							 1L << 16 | 0L, 1L << 16 | 0L);
+	// Split the image into bands if parallel conversion was requested. Scaling needs neighbouring rows, so only
+	// pure conversions can be split without visible seams.
+	if ((threads != 1) && (source_size == target_size)) {
+		int32_t height = static_cast<int32_t>(source_size.second);
+		int32_t align  = std::max(get_vertical_alignment(source_format), get_vertical_alignment(target_format));
+		int32_t count  = static_cast<int32_t>(threads > 0 ? threads : std::thread::hardware_concurrency());
+		count          = std::max(std::min(count, height / ST_MINIMUM_SLICE_HEIGHT), 1);
+
+		int32_t band = ((height / count) + align - 1) / align * align;
+		for (int32_t row = 0; (count > 1) && (row < height); row += band) {
+			int32_t     rows  = std::min(band, height - row);
+			SwsContext* slice = create_context(static_cast<int>(source_size.first), rows, source_format,
+											   source_full_range, source_colorspace,
+											   static_cast<int>(target_size.first), rows, target_format,
+											   target_full_range, target_colorspace, flags);
+			if (!slice) {
+				finalize();
+				return false;
+			}
+
+			slices.emplace_back(row, rows);
+			slice_contexts.push_back(slice);
+		}
+	}
 
 	return true;
 }
 
 bool swscale::finalize()
 {
+	for (auto slice : slice_contexts) {
+		sws_freeContext(slice);
+	}
+	slice_contexts.clear();
+	slices.clear();
+
 	if (this->context) {
 		sws_freeContext(this->context);
 		this->context = nullptr;
@@ -202,6 +300,51 @@ int32_t swscale::convert(const uint8_t* const source_data[], const int source_st
 	if (!this->context) {
 		return 0;
 	}
+
+	if ((slice_contexts.size() > 1) && (source_row == 0)
+		&& (source_rows == static_cast<int32_t>(source_size.second))) {
+		struct join_t {
+			std::mutex              lock;
+			std::condition_variable cv;
+			std::size_t             remaining;
+			int32_t                 height;
+		} join;
+		join.remaining = slice_contexts.size();
+		join.height    = 0;
+
+		auto work = [&](std::size_t idx) {
+			const uint8_t* src[4] = {nullptr, nullptr, nullptr, nullptr};
+			const uint8_t* dst[4] = {nullptr, nullptr, nullptr, nullptr};
+			offset_planes(source_format, slices[idx].first, source_stride, source_data, src);
+			offset_planes(target_format, slices[idx].first, target_stride, target_data, dst);
+
+			int rows = sws_scale(slice_contexts[idx], src, source_stride, 0, slices[idx].second,
+								 const_cast<uint8_t* const*>(dst), target_stride);
+
+			std::unique_lock<std::mutex> ul(join.lock);
+			join.height += rows;
+			if (--join.remaining == 0) {
+				join.cv.notify_all();
+			}
+		};
+
+		// Hand all but the last band to the thread pool, and convert the last one on this thread. A worker of the pool
+		// converts every band itself, waiting on the others could deadlock once all workers do the same.
+		auto pool = ::streamfx::threadpool();
+		for (std::size_t idx = 0; idx < (slice_contexts.size() - 1); idx++) {
+			if (pool->is_worker()) {
+				work(idx);
+			} else {
+				pool->push([&work, idx](::streamfx::util::threadpool_data_t) { work(idx); }, nullptr);
+			}
+		}
+		work(slice_contexts.size() - 1);
+
+		std::unique_lock<std::mutex> ul(join.lock);
+		join.cv.wait(ul, [&join]() { return join.remaining == 0; });
+		return join.height;
+	}
+
 	int height =
 		sws_scale(this->context, source_data, source_stride, source_row, source_rows, target_data, target_stride);
 	return height;
@@ -22,6 +22,7 @@
 #pragma once
 #include "common.hpp"
 #include <utility>
+#include <vector>
 
 extern "C" {
 #ifdef _MSC_VER
@@ -49,6 +50,11 @@ namespace streamfx::ffmpeg {
 
 		SwsContext* context = nullptr;
 
+		// Optional horizontal bands, each with their own context, converted in parallel.
+		uint32_t                                 threads = 1;
+		std::vector<std::pair<int32_t, int32_t>> slices;
+		std::vector<SwsContext*>                 slice_contexts;
+
 		public:
 		swscale();
 		~swscale();
@@ -79,6 +85,16 @@ namespace streamfx::ffmpeg {
 		void                          set_target_full_range(bool full_range);
 		bool                          is_target_full_range();
 
+		/** Number of horizontal bands to convert in parallel. 0 picks a count automatically.
+		 *
+		 * Only takes effect on the next call to initialize(), and only for conversions that don't scale.
+		 */
+		void     set_threads(uint32_t threads);
+		uint32_t get_threads();
+
+		/** Number of bands actually in use after initialize(). */
+		uint32_t get_active_threads();
+
 		bool initialize(int flags);
 		bool finalize();
 
@@ -101,6 +101,10 @@ static std::map<video_format, AVPixelFormat> const obs_to_av_format_map = {
 	{VIDEO_FORMAT_I40A, AV_PIX_FMT_YUVA420P}, //
 	{VIDEO_FORMAT_I42A, AV_PIX_FMT_YUVA422P}, //
 	{VIDEO_FORMAT_YUVA, AV_PIX_FMT_YUVA444P}, //
+#if LIBOBS_API_MAJOR_VER >= 28
+	{VIDEO_FORMAT_I010, AV_PIX_FMT_YUV420P10}, // 10-bit YUV 4:2:0
+	{VIDEO_FORMAT_P010, AV_PIX_FMT_P010},      // 10-bit NV12
+#endif
 											  //{VIDEO_FORMAT_AYUV, AV_PIX_FMT_AYUV444P}, //
 };
 
@@ -122,6 +126,12 @@ video_format tools::avpixelformat_to_obs_videoformat(AVPixelFormat v)
 	return VIDEO_FORMAT_NONE;
 }
 
+bool tools::is_high_bit_depth(AVPixelFormat v)
+{
+	auto desc = av_pix_fmt_desc_get(v);
+	return desc && (desc->comp[0].depth > 8);
+}
+
 AVPixelFormat tools::get_least_lossy_format(const AVPixelFormat* haystack, AVPixelFormat needle)
 {
 	int data_loss = 0;
@@ -149,6 +159,11 @@ AVColorSpace tools::obs_to_av_color_space(video_colorspace v)
 	case VIDEO_CS_709:  // BT.709
 	case VIDEO_CS_SRGB: // sRGB
 		return AVCOL_SPC_BT709;
+#if LIBOBS_API_MAJOR_VER >= 28
+	case VIDEO_CS_2100_PQ:  // BT.2100 with Perceptual Quantizer
+	case VIDEO_CS_2100_HLG: // BT.2100 with Hybrid Log-Gamma
+		return AVCOL_SPC_BT2020_NCL;
+#endif
 	default:
 		throw std::invalid_argument("Unknown Color Space");
 	}
@@ -163,6 +178,11 @@ AVColorPrimaries streamfx::ffmpeg::tools::obs_to_av_color_primary(video_colorspa
 	case VIDEO_CS_709:  // BT.709
 	case VIDEO_CS_SRGB: // sRGB
 		return AVCOL_PRI_BT709;
+#if LIBOBS_API_MAJOR_VER >= 28
+	case VIDEO_CS_2100_PQ:  // BT.2100 with Perceptual Quantizer
+	case VIDEO_CS_2100_HLG: // BT.2100 with Hybrid Log-Gamma
+		return AVCOL_PRI_BT2020;
+#endif
 	default:
 		throw std::invalid_argument("Unknown Color Primaries");
 	}
@@ -178,6 +198,12 @@ AVColorTransferCharacteristic streamfx::ffmpeg::tools::obs_to_av_color_transfer_
 		return AVCOL_TRC_BT709;
 	case VIDEO_CS_SRGB: // sRGB with IEC 61966-2-1
 		return AVCOL_TRC_IEC61966_2_1;
+#if LIBOBS_API_MAJOR_VER >= 28
+	case VIDEO_CS_2100_PQ: // SMPTE ST 2084
+		return AVCOL_TRC_SMPTE2084;
+	case VIDEO_CS_2100_HLG: // ARIB STD-B67
+		return AVCOL_TRC_ARIB_STD_B67;
+#endif
 	default:
 		throw std::invalid_argument("Unknown Color Transfer Characteristics");
 	}
@@ -185,13 +211,21 @@ AVColorTransferCharacteristic streamfx::ffmpeg::tools::obs_to_av_color_transfer_
 
 bool tools::can_hardware_encode(const AVCodec* codec)
 {
-	AVPixelFormat hardware_formats[] = {AV_PIX_FMT_D3D11};
+	AVPixelFormat hardware_formats[] = {AV_PIX_FMT_D3D11, AV_PIX_FMT_CUDA};
 
+	for (auto cmp : hardware_formats) {
+		if (can_hardware_encode(codec, cmp)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool tools::can_hardware_encode(const AVCodec* codec, AVPixelFormat format)
+{
 	for (const AVPixelFormat* fmt = codec->pix_fmts; (fmt != nullptr) && (*fmt != AV_PIX_FMT_NONE); fmt++) {
-		for (auto cmp : hardware_formats) {
-			if (*fmt == cmp) {
-				return true;
-			}
+		if (*fmt == format) {
+			return true;
 		}
 	}
 	return false;
@@ -47,12 +47,15 @@ namespace streamfx::ffmpeg::tools {
 
 	AVPixelFormat get_least_lossy_format(const AVPixelFormat* haystack, AVPixelFormat needle);
 
+	bool is_high_bit_depth(AVPixelFormat v);
+
 	AVColorRange                  obs_to_av_color_range(video_range_type v);
 	AVColorSpace                  obs_to_av_color_space(video_colorspace v);
 	AVColorPrimaries              obs_to_av_color_primary(video_colorspace v);
 	AVColorTransferCharacteristic obs_to_av_color_transfer_characteristics(video_colorspace v);
 
 	bool can_hardware_encode(const AVCodec* codec);
+	bool can_hardware_encode(const AVCodec* codec, AVPixelFormat format);
 
 	std::vector<AVPixelFormat> get_software_formats(const AVPixelFormat* list);
 
@@ -19,18 +19,26 @@
 
 #include "filter-blur.hpp"
 #include "strings.hpp"
+#include "configuration.hpp"
+#include <algorithm>
 #include <cfloat>
 #include <cinttypes>
 #include <cmath>
+#include <limits>
 #include <map>
 #include <stdexcept>
+#include <vector>
 #include "gfx/blur/gfx-blur-box-linear.hpp"
 #include "gfx/blur/gfx-blur-box.hpp"
 #include "gfx/blur/gfx-blur-dual-filtering.hpp"
 #include "gfx/blur/gfx-blur-gaussian-linear.hpp"
 #include "gfx/blur/gfx-blur-gaussian.hpp"
+#include "gfx/blur/gfx-blur-mipmap.hpp"
+#include "gfx/blur/gfx-blur-summed-area.hpp"
+#include "obs/gs/gs-creation-queue.hpp"
 #include "obs/gs/gs-helper.hpp"
 #include "obs/obs-source-tracker.hpp"
+#include "obs/obs-tools.hpp"
 
 // OBS
 #ifdef _MSC_VER
@@ -45,6 +53,20 @@
 #pragma warning(pop)
 #endif
 
+#ifdef _WIN32
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4191 4242 4244 4365 4777 4986 5039 5204)
+#endif
+#include <Windows.h>
+#include <atlutil.h>
+#include <d3d11.h>
+#include <dxgi.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+#endif
+
 // Translation Strings
 #define ST_I18N "Filter.Blur"
 
@@ -88,16 +110,47 @@
 #define ST_KEY_MASK_REGION_FEATHER_SHIFT "Filter.Blur.Mask.Region.Feather.Shift"
 #define ST_I18N_MASK_REGION_INVERT "Filter.Blur.Mask.Region.Invert"
 #define ST_KEY_MASK_REGION_INVERT "Filter.Blur.Mask.Region.Invert"
+#define ST_I18N_MASK_REGION_TRACKING "Filter.Blur.Mask.Region.Tracking"
+#define ST_KEY_MASK_REGION_TRACKING "Filter.Blur.Mask.Region.Tracking"
 #define ST_I18N_MASK_IMAGE "Filter.Blur.Mask.Image"
 #define ST_KEY_MASK_IMAGE "Filter.Blur.Mask.Image"
 #define ST_I18N_MASK_SOURCE "Filter.Blur.Mask.Source"
 #define ST_KEY_MASK_SOURCE "Filter.Blur.Mask.Source"
+#define ST_I18N_MASK_SOURCE_SCALE "Filter.Blur.Mask.Source.Scale"
+#define ST_KEY_MASK_SOURCE_SCALE "Filter.Blur.Mask.Source.Scale"
 #define ST_I18N_MASK_COLOR "Filter.Blur.Mask.Color"
 #define ST_KEY_MASK_COLOR "Filter.Blur.Mask.Color"
 #define ST_I18N_MASK_ALPHA "Filter.Blur.Mask.Alpha"
 #define ST_KEY_MASK_ALPHA "Filter.Blur.Mask.Alpha"
 #define ST_I18N_MASK_MULTIPLIER "Filter.Blur.Mask.Multiplier"
 #define ST_KEY_MASK_MULTIPLIER "Filter.Blur.Mask.Multiplier"
+#define ST_I18N_CACHE "Filter.Blur.Cache"
+#define ST_KEY_CACHE "Filter.Blur.Cache"
+#define ST_I18N_CACHE_HITRATE "Filter.Blur.Cache.HitRate"
+#define ST_KEY_CACHE_HITRATE "Filter.Blur.Cache.HitRate"
+#define ST_I18N_SHARE "Filter.Blur.Share"
+#define ST_KEY_SHARE "Filter.Blur.Share"
+#define ST_I18N_SHARED "Filter.Blur.Shared"
+#define ST_KEY_SHARED "Filter.Blur.Shared"
+#define ST_I18N_SHARED_OFFSET_X "Filter.Blur.Shared.Offset.X"
+#define ST_KEY_SHARED_OFFSET_X "Filter.Blur.Shared.Offset.X"
+#define ST_I18N_SHARED_OFFSET_Y "Filter.Blur.Shared.Offset.Y"
+#define ST_KEY_SHARED_OFFSET_Y "Filter.Blur.Shared.Offset.Y"
+#define ST_I18N_BENCHMARK "Filter.Blur.Benchmark"
+#define ST_KEY_BENCHMARK "Filter.Blur.Benchmark"
+
+#define ST_CFG_CALIBRATION "filter.blur.calibration"
+#define ST_CFG_CALIBRATION_DEVICE "device"
+#define ST_CFG_CALIBRATION_RESULTS "results"
+
+// Blur types that "Automatic" picks from, in order of preference when they are equally fast.
+static const char* automatic_types[] = {"gaussian_linear", "box_linear", "dual_filtering"};
+
+// Largest side of the thumbnail that is compared between frames.
+#define ST_CACHE_THUMBNAIL_SIZE 32
+
+// Extra texels around the region of interest, covers bilinear taps and the downsampled blur path.
+#define ST_REGION_PADDING 16
 
 using namespace streamfx::filter::blur;
 
@@ -118,6 +171,8 @@ static std::map<std::string, local_blur_type_t> list_of_types = {
 	{"gaussian", {&::streamfx::gfx::blur::gaussian_factory::get, S_BLUR_TYPE_GAUSSIAN}},
 	{"gaussian_linear", {&::streamfx::gfx::blur::gaussian_linear_factory::get, S_BLUR_TYPE_GAUSSIAN_LINEAR}},
 	{"dual_filtering", {&::streamfx::gfx::blur::dual_filtering_factory::get, S_BLUR_TYPE_DUALFILTERING}},
+	{"mipmap", {&::streamfx::gfx::blur::mipmap_factory::get, S_BLUR_TYPE_MIPMAP}},
+	{"summed_area", {&::streamfx::gfx::blur::summed_area_factory::get, S_BLUR_TYPE_SUMMEDAREA}},
 };
 static std::map<std::string, local_blur_subtype_t> list_of_subtypes = {
 	{"area", {::streamfx::gfx::blur::type::Area, S_BLUR_SUBTYPE_AREA}},
@@ -126,92 +181,321 @@ static std::map<std::string, local_blur_subtype_t> list_of_subtypes = {
 	{"zoom", {::streamfx::gfx::blur::type::Zoom, S_BLUR_SUBTYPE_ZOOM}},
 };
 
+// "Automatic" takes a radius in pixels like Gaussian Linear, which also supports every subtype it can pick.
+static std::map<std::string, local_blur_type_t>::iterator find_type(const char* name)
+{
+	if (strcmp(name, "automatic") == 0) {
+		return list_of_types.find("gaussian_linear");
+	}
+	return list_of_types.find(name);
+}
+
+// Dual Filtering doubles its reach with every level, so the radius maps to the number of levels.
+static double_t radius_to_levels(double_t radius)
+{
+	return std::max(std::round(std::log2(std::max(radius, 1.0))), 1.0);
+}
+
+static bool is_single_channel(gs_color_format format)
+{
+	return (format == GS_R8) || (format == GS_R16);
+}
+
+// Opaque gray mask images only need one channel, which is a quarter of the memory and of the bandwidth that the mask
+// pass reads every frame. Everything else stays as it was decoded.
+static void reduce_mask_image(streamfx::gfx::texture_file::image& image)
+{
+	if (image.mips.size() != 1)
+		return;
+
+	auto&       pixels = image.mips.front();
+	std::size_t count  = static_cast<std::size_t>(image.width) * image.height;
+	if ((image.format == GS_RGBA) || (image.format == GS_BGRA) || (image.format == GS_BGRX)) {
+		bool                 opaque = (image.format == GS_BGRX);
+		std::vector<uint8_t> gray(count);
+		for (std::size_t idx = 0; idx < count; idx++) {
+			const uint8_t* px = pixels.data() + idx * 4;
+			if ((px[0] != px[1]) || (px[1] != px[2]) || (!opaque && (px[3] != 255)))
+				return;
+			gray[idx] = px[0];
+		}
+		pixels       = std::move(gray);
+		image.format = GS_R8;
+	} else if (image.format == GS_RGBA16) {
+		// Sixteen bit images keep their precision.
+		std::vector<uint8_t> gray(count * sizeof(uint16_t));
+		for (std::size_t idx = 0; idx < count; idx++) {
+			const uint16_t* px = reinterpret_cast<const uint16_t*>(pixels.data()) + idx * 4;
+			if ((px[0] != px[1]) || (px[1] != px[2]) || (px[3] != 65535))
+				return;
+			reinterpret_cast<uint16_t*>(gray.data())[idx] = px[0];
+		}
+		pixels       = std::move(gray);
+		image.format = GS_R16;
+	}
+}
+
+static std::string get_device_identifier()
+{
+	auto gctx = streamfx::obs::gs::context();
+#ifdef _WIN32
+	if (gs_get_device_type() == GS_DEVICE_DIRECT3D_11) {
+		ATL::CComPtr<IDXGIDevice>  dxgi_device;
+		ATL::CComPtr<IDXGIAdapter> dxgi_adapter;
+		auto                       device = reinterpret_cast<ID3D11Device*>(gs_get_device_obj());
+		DXGI_ADAPTER_DESC          desc   = DXGI_ADAPTER_DESC();
+		if (SUCCEEDED(device->QueryInterface(__uuidof(IDXGIDevice), reinterpret_cast<void**>(&dxgi_device)))
+			&& SUCCEEDED(dxgi_device->GetAdapter(&dxgi_adapter)) && SUCCEEDED(dxgi_adapter->GetDesc(&desc))) {
+			std::vector<char> buffer(64);
+			snprintf(buffer.data(), buffer.size(), "d3d11:%04x:%04x:%08x:%04x", desc.VendorId, desc.DeviceId,
+					 desc.SubSysId, desc.Revision);
+			return std::string(buffer.data());
+		}
+	}
+#endif
+	// FixMe! Identify the adapter behind OpenGL, all OpenGL devices currently share one calibration.
+	return gs_get_device_type() == GS_DEVICE_OPENGL ? "opengl" : "unknown";
+}
+
 blur_instance::blur_instance(obs_data_t* settings, obs_source_t* self)
-	: obs::source_instance(settings, self), _source_rendered(false), _output_rendered(false)
+	: obs::source_instance(settings, self), obs::degradable(0, 2), _created(false), _source_rendered(false),
+	  _output_rendered(false), _visible(), _cache(), _shared(), _blur_automatic(false),
+	  _blur_subtype(::streamfx::gfx::blur::type::Area), _degrade_downsampler()
 {
-	{
+#ifdef ENABLE_PROFILING
+	_gpu_timer = streamfx::obs::gs::gpu_timer::get("Blur");
+#endif
+
+	this->_pool = streamfx::obs::gs::rendertarget_pool::instance();
+
+	// Render targets and effects are created later on the graphics thread, until then the source passes through.
+	if (auto queue = streamfx::obs::gs::creation_queue::get(); queue) {
+		queue->push(this, [this]() { create(); });
+	} else {
 		auto gctx = streamfx::obs::gs::context();
+		create();
+	}
 
-		// Create RenderTargets
-		this->_source_rt = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-		this->_output_rt = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	update(settings);
+	enable_idle_tracking();
+	enable_render_sharing();
+	enable_update_coalescing(0.05f);
+	enable_preview_profile();
+	enable_prewarm();
+}
 
-		// Load Effects
-		{
-			auto file = streamfx::data_file_path("effects/mask.effect").string();
-			try {
-				_effect_mask = streamfx::obs::gs::effect::create(file);
-			} catch (std::runtime_error& ex) {
-				DLOG_ERROR("<filter-blur> Loading effect '%s' failed with error(s): %s", file.c_str(), ex.what());
-			}
+blur_instance::~blur_instance()
+{
+	if (auto queue = streamfx::obs::gs::creation_queue::get(); queue) {
+		queue->cancel(this);
+	}
+	if (auto factory = blur_factory::get(); factory && !_shared.share.empty()) {
+		factory->unshare(_shared.share, _shared.rt);
+	}
+}
+
+void blur_instance::create()
+{
+	// Create RenderTargets
+	this->_source_rt = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	this->_output_rt = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+
+	// Load Effects
+	{
+		auto file = streamfx::data_file_path("effects/mask.effect");
+		try {
+			_effect_mask = streamfx::obs::gs::effect::create_shared(file);
+
+			_effect_mask_parameters = {_effect_mask,
+									   {"image_orig", "image_blur", "mask_region_left", "mask_region_right",
+									    "mask_region_top", "mask_region_bottom", "mask_region_feather",
+									    "mask_region_feather_shift", "mask_image", "mask_color", "mask_multiplier"}};
+		} catch (std::runtime_error& ex) {
+			DLOG_ERROR("<filter-blur> Loading effect '%s' failed with error(s): %s", file.u8string().c_str(),
+					   ex.what());
 		}
 	}
 
-	update(settings);
+	_created = true;
 }
 
-blur_instance::~blur_instance() {}
+double_t blur_instance::get_cache_hit_rate()
+{
+	return _cache.total ? (static_cast<double_t>(_cache.hits) / static_cast<double_t>(_cache.total)) : 0.;
+}
+
+bool blur_instance::is_source_unchanged(uint32_t width, uint32_t height)
+{
+	// Reduce the source to a small thumbnail, every halving averages 2x2 texels so that no part of it is skipped.
+	uint32_t factor = 1;
+	while (((width / factor) > ST_CACHE_THUMBNAIL_SIZE) || ((height / factor) > ST_CACHE_THUMBNAIL_SIZE)) {
+		factor <<= 1;
+	}
+	auto thumbnail = _cache.downsampler.downsample(_source_texture, factor);
+	if (!thumbnail) {
+		return false; // Source is already tiny, blurring it costs less than comparing it.
+	}
+
+	uint32_t thumb_width  = std::max<uint32_t>(width / factor, 1);
+	uint32_t thumb_height = std::max<uint32_t>(height / factor, 1);
+	if ((_cache.width != thumb_width) || (_cache.height != thumb_height)) {
+		_cache.readback.reset();
+		_cache.width  = thumb_width;
+		_cache.height = thumb_height;
+		_cache.frame  = 0;
+		_cache.valid  = false;
+	}
+
+	// The thumbnail is read back a frame later, mapping it right away would stall until the GPU caught up.
+	_cache.readback.stage(thumbnail->get_object(),
+						  [this](const uint8_t* ptr, uint32_t stride, uint32_t cols, uint32_t rows) {
+							  if (!ptr) {
+								  _cache.changed = true;
+								  return;
+							  }
+
+							  uint64_t hash = 14695981039346656037ull; // FNV-1a
+							  for (uint32_t y = 0; y < rows; y++) {
+								  const uint8_t* row = ptr + static_cast<size_t>(y) * stride;
+								  for (size_t x = 0; x < static_cast<size_t>(cols) * 4; x++) {
+									  hash = (hash ^ row[x]) * 1099511628211ull;
+								  }
+							  }
+
+							  _cache.changed = (_cache.frame < 2) || (hash != _cache.hash);
+							  _cache.hash    = hash;
+						  });
+	_cache.frame++;
+
+	// A change is only seen one frame late, so the previous output is used for at most one frame too long.
+	return (_cache.frame > 2) && !_cache.changed;
+}
+
+bool blur_instance::get_region_of_interest(uint32_t width, uint32_t height, uint32_t inner[4], uint32_t outer[4])
+{
+	// Only a plain region mask or the scenes showing the source limit which part of the blur is visible, everything
+	// else may show all of it.
+	bool is_region = _mask.enabled && (_mask.type == mask_type::Region) && !_mask.region.invert;
+	if (!is_region && !_visible.known) {
+		return false;
+	}
+
+	// Rotational and Zoom blurs sample along arcs and rays, which can reach anywhere in the image. Dual Filtering
+	// reaches twice as far with every iteration, so it is left alone as well.
+	auto type = _blur->get_type();
+	if ((type != ::streamfx::gfx::blur::type::Area) && (type != ::streamfx::gfx::blur::type::Directional)) {
+		return false;
+	}
+	if (std::dynamic_pointer_cast<::streamfx::gfx::blur::dual_filtering>(_blur)) {
+		return false;
+	}
+
+	// The visible area is the region plus however far the feather reaches outwards.
+	if (is_region) {
+		float_t feather = _mask.region.feather * (0.5f + std::fabs(_mask.region.feather_shift));
+		float_t bounds[4]{
+			(_mask.region.left - feather) * width,
+			(_mask.region.top - feather) * height,
+			(_mask.region.right + feather) * width,
+			(_mask.region.bottom + feather) * height,
+		};
+		for (size_t idx = 0; idx < 4; idx++) {
+			float_t limit = static_cast<float_t>((idx % 2) ? height : width);
+			float_t value = (idx < 2) ? std::floor(bounds[idx]) : std::ceil(bounds[idx]);
+			inner[idx]    = static_cast<uint32_t>(std::clamp<float_t>(value, 0.f, limit));
+		}
+	} else {
+		inner[0] = inner[1] = 0;
+		inner[2]            = width;
+		inner[3]            = height;
+	}
+	if (_visible.known) {
+		inner[0] = std::max(inner[0], _visible.region[0]);
+		inner[1] = std::max(inner[1], _visible.region[1]);
+		inner[2] = std::min(inner[2], _visible.region[2]);
+		inner[3] = std::min(inner[3], _visible.region[3]);
+	}
+	if ((inner[0] >= inner[2]) || (inner[1] >= inner[3])) {
+		return false;
+	}
+
+	// Pad by the distance the blur samples from, so that the visible area does not pick up the crop edges. The
+	// Gaussian blurs sample up to twice their size away.
+	double_t step_x = _blur_step_scaling ? _blur_step_scale.first : 1.0;
+	double_t step_y = _blur_step_scaling ? _blur_step_scale.second : 1.0;
+	double_t reach  = _blur->get_size() * 2.0 * std::max(std::max(step_x, step_y), 1.0);
+	uint32_t pad    = static_cast<uint32_t>(std::ceil(reach)) + ST_REGION_PADDING;
+	outer[0] = (inner[0] > pad) ? (inner[0] - pad) : 0;
+	outer[1] = (inner[1] > pad) ? (inner[1] - pad) : 0;
+	outer[2] = std::min(inner[2] + pad, width);
+	outer[3] = std::min(inner[3] + pad, height);
+
+	// Not worth the extra passes if nearly the whole source is blurred anyway.
+	uint64_t area = static_cast<uint64_t>(outer[2] - outer[0]) * static_cast<uint64_t>(outer[3] - outer[1]);
+	return (area * 4) < (static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * 3);
+}
 
-bool blur_instance::apply_mask_parameters(streamfx::obs::gs::effect effect, gs_texture_t* original_texture,
-										  gs_texture_t* blurred_texture)
+bool blur_instance::apply_mask_parameters(gs_texture_t* original_texture, gs_texture_t* blurred_texture)
 {
-	if (effect.has_parameter("image_orig")) {
-		effect.get_parameter("image_orig").set_texture(original_texture);
+	auto& params = _effect_mask_parameters;
+
+	if (auto& param = params[IMAGE_ORIG]; param) {
+		param.set_texture(original_texture);
 	}
-	if (effect.has_parameter("image_blur")) {
-		effect.get_parameter("image_blur").set_texture(blurred_texture);
+	if (auto& param = params[IMAGE_BLUR]; param) {
+		param.set_texture(blurred_texture);
 	}
 
 	// Region
 	if (_mask.type == mask_type::Region) {
-		if (effect.has_parameter("mask_region_left")) {
-			effect.get_parameter("mask_region_left").set_float(_mask.region.left);
+		if (auto& param = params[MASK_REGION_LEFT]; param) {
+			param.set_float(_mask.region.left);
 		}
-		if (effect.has_parameter("mask_region_right")) {
-			effect.get_parameter("mask_region_right").set_float(_mask.region.right);
+		if (auto& param = params[MASK_REGION_RIGHT]; param) {
+			param.set_float(_mask.region.right);
 		}
-		if (effect.has_parameter("mask_region_top")) {
-			effect.get_parameter("mask_region_top").set_float(_mask.region.top);
+		if (auto& param = params[MASK_REGION_TOP]; param) {
+			param.set_float(_mask.region.top);
 		}
-		if (effect.has_parameter("mask_region_bottom")) {
-			effect.get_parameter("mask_region_bottom").set_float(_mask.region.bottom);
+		if (auto& param = params[MASK_REGION_BOTTOM]; param) {
+			param.set_float(_mask.region.bottom);
 		}
-		if (effect.has_parameter("mask_region_feather")) {
-			effect.get_parameter("mask_region_feather").set_float(_mask.region.feather);
+		if (auto& param = params[MASK_REGION_FEATHER]; param) {
+			param.set_float(_mask.region.feather);
 		}
-		if (effect.has_parameter("mask_region_feather_shift")) {
-			effect.get_parameter("mask_region_feather_shift").set_float(_mask.region.feather_shift);
+		if (auto& param = params[MASK_REGION_FEATHER_SHIFT]; param) {
+			param.set_float(_mask.region.feather_shift);
 		}
 	}
 
 	// Image
 	if (_mask.type == mask_type::Image) {
-		if (effect.has_parameter("mask_image")) {
+		if (auto& param = params[MASK_IMAGE]; param) {
 			if (_mask.image.texture) {
-				effect.get_parameter("mask_image").set_texture(_mask.image.texture);
+				param.set_texture(_mask.image.texture);
 			} else {
-				effect.get_parameter("mask_image").set_texture(nullptr);
+				param.set_texture(nullptr);
 			}
 		}
 	}
 
 	// Source
 	if (_mask.type == mask_type::Source) {
-		if (effect.has_parameter("mask_image")) {
+		if (auto& param = params[MASK_IMAGE]; param) {
 			if (_mask.source.texture) {
-				effect.get_parameter("mask_image").set_texture(_mask.source.texture);
+				param.set_texture(_mask.source.texture);
 			} else {
-				effect.get_parameter("mask_image").set_texture(nullptr);
+				param.set_texture(nullptr);
 			}
 		}
 	}
 
 	// Shared
-	if (effect.has_parameter("mask_color")) {
-		effect.get_parameter("mask_color").set_float4(_mask.color.r, _mask.color.g, _mask.color.b, _mask.color.a);
+	if (auto& param = params[MASK_COLOR]; param) {
+		param.set_float4(_mask.color.r, _mask.color.g, _mask.color.b, _mask.color.a);
 	}
-	if (effect.has_parameter("mask_multiplier")) {
-		effect.get_parameter("mask_multiplier").set_float(_mask.multiplier);
+	if (auto& param = params[MASK_MULTIPLIER]; param) {
+		param.set_float(_mask.multiplier);
 	}
 
 	return true;
@@ -262,13 +546,36 @@ void blur_instance::migrate(obs_data_t* settings, uint64_t version)
 
 void blur_instance::update(obs_data_t* settings)
 {
+	_cache.enabled = obs_data_get_bool(settings, ST_KEY_CACHE);
+	_cache.valid   = false;
+
+	{ // Shared Background
+		std::string share = obs_data_get_string(settings, ST_KEY_SHARE);
+		if (share != _shared.share) {
+			if (!_shared.share.empty()) {
+				blur_factory::get()->unshare(_shared.share, _shared.rt);
+			}
+			_shared.share = share;
+		}
+		_shared.name     = obs_data_get_string(settings, ST_KEY_SHARED);
+		_shared.offset_x = static_cast<int32_t>(obs_data_get_int(settings, ST_KEY_SHARED_OFFSET_X));
+		_shared.offset_y = static_cast<int32_t>(obs_data_get_int(settings, ST_KEY_SHARED_OFFSET_Y));
+	}
+
 	{ // Blur Type
 		const char* blur_type      = obs_data_get_string(settings, ST_KEY_TYPE);
 		const char* blur_subtype   = obs_data_get_string(settings, ST_KEY_SUBTYPE);
 		const char* last_blur_type = obs_data_get_string(settings, ST_KEY_TYPE ".last");
 
+		// "Automatic" creates its blur in video_tick, once the size of the source is known.
+		_blur_automatic = (strcmp(blur_type, "automatic") == 0);
+		if (auto subtype_found = list_of_subtypes.find(blur_subtype); subtype_found != list_of_subtypes.end()) {
+			_blur_subtype = subtype_found->second.type;
+		}
+
 		auto type_found = list_of_types.find(blur_type);
 		if (type_found != list_of_types.end()) {
+			_blur_automatic_type.clear();
 			auto subtype_found = list_of_subtypes.find(blur_subtype);
 			if (subtype_found != list_of_subtypes.end()) {
 				if ((strcmp(last_blur_type, blur_type) != 0) || (_blur->get_type() != subtype_found->second.type)) {
@@ -305,13 +612,16 @@ void blur_instance::update(obs_data_t* settings)
 				_mask.region.feather = float_t(obs_data_get_double(settings, ST_KEY_MASK_REGION_FEATHER) / 100.0);
 				_mask.region.feather_shift =
 					float_t(obs_data_get_double(settings, ST_KEY_MASK_REGION_FEATHER_SHIFT) / 100.0);
-				_mask.region.invert = obs_data_get_bool(settings, ST_KEY_MASK_REGION_INVERT);
+				_mask.region.invert   = obs_data_get_bool(settings, ST_KEY_MASK_REGION_INVERT);
+				_mask.region.tracking = obs_data_get_bool(settings, ST_KEY_MASK_REGION_TRACKING);
 				break;
 			case mask_type::Image:
 				_mask.image.path = obs_data_get_string(settings, ST_KEY_MASK_IMAGE);
 				break;
 			case mask_type::Source:
-				_mask.source.name = obs_data_get_string(settings, ST_KEY_MASK_SOURCE);
+				_mask.source.name  = obs_data_get_string(settings, ST_KEY_MASK_SOURCE);
+				_mask.source.scale = static_cast<float_t>(
+					std::clamp(obs_data_get_double(settings, ST_KEY_MASK_SOURCE_SCALE) / 100.0, 0.125, 1.0));
 				break;
 			}
 			if ((_mask.type == mask_type::Image) || (_mask.type == mask_type::Source)) {
@@ -326,11 +636,41 @@ void blur_instance::update(obs_data_t* settings)
 	}
 }
 
+void blur_instance::idle()
+{
+	if (!_created) {
+		return;
+	}
+
+	// Shrinking the targets frees their memory, while keeping them valid for anything that still refers to them.
+	vec4 transparent = {0, 0, 0, 0};
+	for (auto rt : {_source_rt, _output_rt}) {
+		auto op = rt->render(1, 1);
+		gs_clear(GS_CLEAR_COLOR, &transparent, 0, 0);
+	}
+	_source_texture.reset();
+	_output_texture.reset();
+	_output_lease.reset();
+	_cache.valid = false;
+}
+
 void blur_instance::video_tick(float)
 {
+	double_t blur_size = _blur_size;
+	if (_blur_automatic) {
+		obs_source_t* target = obs_filter_get_target(_self);
+		std::string   type   = blur_factory::get()->find_fastest_type(
+			_blur_subtype, blur_size, obs_source_get_base_width(target), obs_source_get_base_height(target));
+		if (!type.empty() && (!_blur || (type != _blur_automatic_type) || (_blur->get_type() != _blur_subtype))) {
+			_blur                = list_of_types.at(type).fn().create(_blur_subtype);
+			_blur_automatic_type = type;
+			_cache.valid         = false;
+		}
+	}
+
 	// Blur
 	if (_blur) {
-		_blur->set_size(_blur_size);
+		_blur->set_size(blur_size);
 		if (_blur_step_scaling) {
 			_blur->set_step_scale(_blur_step_scale.first, _blur_step_scale.second);
 		} else {
@@ -348,17 +688,43 @@ void blur_instance::video_tick(float)
 		}
 	}
 
+	// Follow the face found by a tracker on the same source, keeping the last known position while it is lost.
+	if (_mask.enabled && (_mask.type == mask_type::Region) && _mask.region.tracking) {
+		if (auto frame = _mask.region.tracked.get(obs_filter_get_parent(_self)); frame && !frame->faces.empty()) {
+			auto& face = frame->faces.front();
+			if ((_mask.region.left != face.x) || (_mask.region.top != face.y)
+				|| (_mask.region.right != (face.x + face.width)) || (_mask.region.bottom != (face.y + face.height))) {
+				_mask.region.left   = face.x;
+				_mask.region.top    = face.y;
+				_mask.region.right  = face.x + face.width;
+				_mask.region.bottom = face.y + face.height;
+				_cache.valid        = false;
+			}
+		}
+	}
+
 	// Load Mask
 	if (_mask.type == mask_type::Image) {
 		if (_mask.image.path_old != _mask.image.path) {
 			try {
-				_mask.image.texture  = std::make_shared<streamfx::obs::gs::texture>(_mask.image.path);
+				_mask.image.file     = streamfx::gfx::texture_file::load(std::filesystem::u8path(_mask.image.path),
+																	 "mask", reduce_mask_image);
+				_mask.image.texture  = nullptr;
 				_mask.image.path_old = _mask.image.path;
+				_cache.valid         = false;
 			} catch (...) {
 				DLOG_ERROR("<filter-blur> Instance '%s' failed to load image '%s'.", obs_source_get_name(_self),
 						   _mask.image.path.c_str());
 			}
 		}
+
+		// Decoded on the thread pool, so the mask only applies once it is ready.
+		if (_mask.image.file && _mask.image.file->is_ready()) {
+			if (auto texture = _mask.image.file->get_texture(); texture != _mask.image.texture) {
+				_mask.image.texture = texture;
+				_cache.valid        = false;
+			}
+		}
 	} else if (_mask.type == mask_type::Source) {
 		if (_mask.source.name_old != _mask.source.name) {
 			try {
@@ -372,6 +738,20 @@ void blur_instance::video_tick(float)
 		}
 	}
 
+	// Cropped or partly off-canvas sources only need the part that is actually shown.
+	{
+		obs_source_t* target = obs_filter_get_target(_self);
+		uint32_t      width  = obs_source_get_base_width(target);
+		uint32_t      height = obs_source_get_base_height(target);
+		uint32_t      region[4];
+		bool          known = streamfx::obs::tools::visible_region(_self, width, height, region);
+		if ((known != _visible.known) || (known && !std::equal(region, region + 4, _visible.region))) {
+			_visible.known = known;
+			std::copy(region, region + 4, _visible.region);
+			_cache.valid = false;
+		}
+	}
+
 	_source_rendered = false;
 	_output_rendered = false;
 }
@@ -385,7 +765,7 @@ void blur_instance::video_render(gs_effect_t* effect)
 	uint32_t      baseH         = obs_source_get_base_height(target);
 
 	// Verify that we can actually run first.
-	if (!target || !parent || !this->_self || !this->_blur || (baseW == 0) || (baseH == 0)) {
+	if (!_created || !target || !parent || !this->_self || !this->_blur || (baseW == 0) || (baseH == 0)) {
 		obs_source_skip_video_filter(this->_self);
 		return;
 	}
@@ -393,6 +773,8 @@ void blur_instance::video_render(gs_effect_t* effect)
 #ifdef ENABLE_PROFILING
 	streamfx::obs::gs::debug_marker gdmp{streamfx::obs::gs::debug_color_source, "Blur '%s'",
 										 obs_source_get_name(_self)};
+
+	streamfx::obs::gs::gpu_timer::scope gpt{_gpu_timer};
 #endif
 
 	if (!_source_rendered) {
@@ -444,20 +826,196 @@ void blur_instance::video_render(gs_effect_t* effect)
 		}
 
 		_source_rendered = true;
+
+		// Skip the blur entirely while the input stays the same. Source masks and shared backgrounds change on their
+		// own, so never cache them.
+		if (_cache.enabled && (!_mask.enabled || (_mask.type != mask_type::Source)) && _shared.name.empty()) {
+#ifdef ENABLE_PROFILING
+			streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_cache, "Compare"};
+#endif
+
+			bool unchanged = is_source_unchanged(baseW, baseH);
+			if (unchanged && _cache.valid && _output_texture) {
+				_output_rendered = true;
+				_cache.hits++;
+			}
+			_cache.total++;
+			_statistics->track_cache(_output_rendered);
+		}
 	}
 
 	if (!_output_rendered) {
-		{
+		std::shared_ptr<streamfx::obs::gs::rendertarget> region_rt;
+		bool                                             variable_radius = false;
+
+		// A shared background is a blur of whatever is behind us, so we only need the part of it that we cover.
+		std::shared_ptr<streamfx::obs::gs::rendertarget> shared;
+		if (!_shared.name.empty() && (_shared.name != _shared.share)) {
+			shared = blur_factory::get()->get_shared(_shared.name);
+		}
+
+		if (shared) {
+#ifdef ENABLE_PROFILING
+			streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_convert, "Shared '%s'",
+												_shared.name.c_str()};
+#endif
+
+			auto         texture = shared->get_texture();
+			gs_eparam_t* param   = gs_effect_get_param_by_name(defaultEffect, "image");
+			vec4         black   = {0, 0, 0, 0};
+
+			gs_blend_state_push();
+			gs_reset_blend_state();
+			gs_enable_blending(false);
+			gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+			gs_set_cull_mode(GS_NEITHER);
+			gs_enable_color(true, true, true, true);
+			gs_enable_depth_test(false);
+			gs_enable_stencil_test(false);
+			gs_enable_stencil_write(false);
+
+			region_rt = _pool->acquire(baseW, baseH);
+			{
+				auto op = region_rt->render(baseW, baseH);
+				gs_ortho(0, static_cast<float>(baseW), 0, static_cast<float>(baseH), -1., 1.);
+				gs_clear(GS_CLEAR_COLOR, &black, 0, 0);
+
+				gs_matrix_push();
+				gs_matrix_translate3f(-static_cast<float>(_shared.offset_x), -static_cast<float>(_shared.offset_y), 0.);
+				gs_effect_set_texture(param, texture->get_object());
+				while (gs_effect_loop(defaultEffect, "Draw")) {
+					gs_draw_sprite(texture->get_object(), 0, texture->get_width(), texture->get_height());
+				}
+				gs_matrix_pop();
+			}
+
+			gs_blend_state_pop();
+			_output_texture = region_rt->get_texture();
+			_output_lease   = region_rt;
+		} else {
 #ifdef ENABLE_PROFILING
 			streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_convert, "Blur"};
 #endif
 
-			_blur->set_input(_source_texture);
-			_output_texture = _blur->render();
+			// The summed area table can apply an image mask directly, by scaling the radius per pixel instead of
+			// blending a full blur with the original.
+			if (auto sat = std::dynamic_pointer_cast<::streamfx::gfx::blur::summed_area>(_blur); sat) {
+				variable_radius = _mask.enabled && (_mask.type == mask_type::Image) && _mask.image.texture;
+				if (variable_radius) {
+					// Same weighting as the Image and ImageGray techniques in mask.effect.
+					auto& color = _mask.color;
+					vec4  weights;
+					vec4_set(&weights, color.r, color.g, color.b, color.a);
+					if (is_single_channel(_mask.image.texture->get_color_format())) {
+						vec4_set(&weights, color.r + color.g + color.b, 0.f, 0.f, color.a);
+					}
+					vec4_mulf(&weights, &weights, _mask.multiplier);
+					sat->set_radius_map(_mask.image.texture, weights);
+				} else {
+					sat->set_radius_map(nullptr, vec4{});
+				}
+			}
+
+			uint32_t inner[4], outer[4];
+			if (!variable_radius && get_region_of_interest(baseW, baseH, inner, outer)) {
+				uint32_t width  = outer[2] - outer[0];
+				uint32_t height = outer[3] - outer[1];
+
+				gs_blend_state_push();
+				gs_reset_blend_state();
+				gs_enable_blending(false);
+				gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+				gs_set_cull_mode(GS_NEITHER);
+				gs_enable_color(true, true, true, true);
+				gs_enable_depth_test(false);
+				gs_depth_function(GS_ALWAYS);
+				gs_enable_stencil_test(false);
+				gs_enable_stencil_write(false);
+				gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
+				gs_stencil_op(GS_STENCIL_BOTH, GS_KEEP, GS_KEEP, GS_KEEP);
+
+				// Crop the source down to the padded region.
+				gs_eparam_t* param = gs_effect_get_param_by_name(defaultEffect, "image");
+				region_rt          = _pool->acquire(width, height);
+				{
+					auto op = region_rt->render(width, height);
+					gs_ortho(0, static_cast<float>(width), 0, static_cast<float>(height), -1., 1.);
+					gs_effect_set_texture(param, _source_texture->get_object());
+					while (gs_effect_loop(defaultEffect, "Draw")) {
+						gs_draw_sprite_subregion(_source_texture->get_object(), 0, outer[0], outer[1], width, height);
+					}
+				}
+
+				_blur->set_input(region_rt->get_texture());
+				auto blurred = _blur->render();
+				region_rt    = _pool->acquire(baseW, baseH);
+
+				// Paste the visible part back into a copy of the source, the mask takes care of the rest.
+				{
+					auto op = region_rt->render(baseW, baseH);
+					gs_ortho(0, static_cast<float>(baseW), 0, static_cast<float>(baseH), -1., 1.);
+					gs_effect_set_texture(param, _source_texture->get_object());
+					while (gs_effect_loop(defaultEffect, "Draw")) {
+						gs_draw_sprite(_source_texture->get_object(), 0, baseW, baseH);
+					}
+
+					gs_matrix_push();
+					gs_matrix_translate3f(static_cast<float>(inner[0]), static_cast<float>(inner[1]), 0.);
+					gs_effect_set_texture(param, blurred->get_object());
+					while (gs_effect_loop(defaultEffect, "Draw")) {
+						gs_draw_sprite_subregion(blurred->get_object(), 0, inner[0] - outer[0], inner[1] - outer[1],
+												 inner[2] - inner[0], inner[3] - inner[1]);
+					}
+					gs_matrix_pop();
+				}
+
+				gs_blend_state_pop();
+				_output_texture = region_rt->get_texture();
+				_output_lease   = region_rt;
+			} else if (uint32_t level = degrade_level(is_preview_render()); level > 0) {
+				// The governor asked for less work, or nothing shows this in program, so blur a smaller copy with a
+				// proportionally smaller radius.
+				uint32_t factor = uint32_t(1) << level;
+				double_t size   = _blur->get_size();
+				auto     input  = _degrade_downsampler.downsample(_source_texture, factor);
+				_blur->set_input(input->get_texture());
+				_blur->set_size(size / factor);
+				_output_texture = _blur->render();
+				_output_lease.reset();
+				_blur->set_size(size);
+			} else {
+				_blur->set_input(_source_texture);
+				_output_texture = _blur->render();
+				_output_lease.reset();
+			}
+
+			// Keep a copy of the unmasked blur for others, the texture above may belong to a pooled target.
+			if (!_shared.share.empty()) {
+				if (!_shared.rt) {
+					_shared.rt = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+				}
+
+				gs_blend_state_push();
+				gs_reset_blend_state();
+				gs_enable_blending(false);
+				gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+				{
+					auto         op    = _shared.rt->render(baseW, baseH);
+					gs_eparam_t* param = gs_effect_get_param_by_name(defaultEffect, "image");
+					gs_ortho(0, static_cast<float>(baseW), 0, static_cast<float>(baseH), -1., 1.);
+					gs_effect_set_texture(param, _output_texture->get_object());
+					while (gs_effect_loop(defaultEffect, "Draw")) {
+						gs_draw_sprite(_output_texture->get_object(), 0, baseW, baseH);
+					}
+				}
+				gs_blend_state_pop();
+
+				blur_factory::get()->share(_shared.share, _shared.rt);
+			}
 		}
 
 		// Mask
-		if (_mask.enabled) {
+		if (_mask.enabled && !variable_radius) {
 #ifdef ENABLE_PROFILING
 			streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_convert, "Mask"};
 #endif
@@ -475,7 +1033,7 @@ void blur_instance::video_render(gs_effect_t* effect)
 			gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
 			gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
-			std::string technique = "";
+			const char* technique = "";
 			switch (this->_mask.type) {
 			case mask_type::Region:
 				if (this->_mask.region.feather > std::numeric_limits<float_t>::epsilon()) {
@@ -493,6 +1051,12 @@ void blur_instance::video_render(gs_effect_t* effect)
 				}
 				break;
 			case mask_type::Image:
+				if (_mask.image.texture && is_single_channel(_mask.image.texture->get_color_format())) {
+					technique = "ImageGray";
+				} else {
+					technique = "Image";
+				}
+				break;
 			case mask_type::Source:
 				technique = "Image";
 				break;
@@ -521,17 +1085,21 @@ void blur_instance::video_render(gs_effect_t* effect)
 													obs_source_get_name(_mask.source.source_texture->get_object())};
 #endif
 
+				// Masks are mostly soft, so a smaller capture is stretched by the linear sampler in mask.effect.
+				source_width  = std::max<uint32_t>(static_cast<uint32_t>(source_width * _mask.source.scale), 1);
+				source_height = std::max<uint32_t>(static_cast<uint32_t>(source_height * _mask.source.scale), 1);
+
 				this->_mask.source.texture = this->_mask.source.source_texture->render(source_width, source_height);
 			}
 
-			apply_mask_parameters(_effect_mask, _source_texture->get_object(), _output_texture->get_object());
+			apply_mask_parameters(_source_texture->get_object(), _output_texture->get_object());
 
 			try {
 				auto op = this->_output_rt->render(baseW, baseH);
 				gs_ortho(0, 1, 0, 1, -1, 1);
 
 				// Render
-				while (gs_effect_loop(_effect_mask.get_object(), technique.c_str())) {
+				while (gs_effect_loop(_effect_mask.get_object(), technique)) {
 					streamfx::gs_draw_fullscreen_tri();
 				}
 			} catch (const std::exception&) {
@@ -541,6 +1109,7 @@ void blur_instance::video_render(gs_effect_t* effect)
 			}
 			gs_blend_state_pop();
 
+			_output_lease.reset();
 			if (!(_output_texture = this->_output_rt->get_texture())) {
 				obs_source_skip_video_filter(this->_self);
 				return;
@@ -548,6 +1117,10 @@ void blur_instance::video_render(gs_effect_t* effect)
 		}
 
 		_output_rendered = true;
+		_cache.valid     = true;
+
+		_statistics->set_video_memory(streamfx::obs::statistics::texture_memory(_source_texture)
+									  + streamfx::obs::statistics::texture_memory(_output_texture));
 	}
 
 	// Draw source
@@ -583,7 +1156,7 @@ void blur_instance::video_render(gs_effect_t* effect)
 	}
 }
 
-blur_factory::blur_factory()
+blur_factory::blur_factory() : _benchmark_loaded(false), _benchmark_run()
 {
 	_info.id           = S_PREFIX "filter-blur";
 	_info.type         = OBS_SOURCE_TYPE_FILTER;
@@ -594,7 +1167,13 @@ blur_factory::blur_factory()
 	register_proxy("obs-stream-effects-filter-blur");
 }
 
-blur_factory::~blur_factory() {}
+blur_factory::~blur_factory()
+{
+	if (_benchmark_run) {
+		obs_remove_main_render_callback(benchmark_callback, this);
+		_benchmark_run.reset();
+	}
+}
 
 const char* blur_factory::get_name()
 {
@@ -626,10 +1205,21 @@ void blur_factory::get_defaults2(obs_data_t* settings)
 	obs_data_set_default_double(settings, ST_KEY_MASK_REGION_FEATHER, 0.0);
 	obs_data_set_default_double(settings, ST_KEY_MASK_REGION_FEATHER_SHIFT, 0.0);
 	obs_data_set_default_bool(settings, ST_KEY_MASK_REGION_INVERT, false);
+	obs_data_set_default_bool(settings, ST_KEY_MASK_REGION_TRACKING, false);
 	obs_data_set_default_string(settings, ST_KEY_MASK_IMAGE, streamfx::data_file_path("white.png").u8string().c_str());
 	obs_data_set_default_string(settings, ST_KEY_MASK_SOURCE, "");
+	obs_data_set_default_double(settings, ST_KEY_MASK_SOURCE_SCALE, 100.0);
 	obs_data_set_default_int(settings, ST_KEY_MASK_COLOR, 0xFFFFFFFFull);
 	obs_data_set_default_double(settings, ST_KEY_MASK_MULTIPLIER, 1.0);
+
+	// Cache
+	obs_data_set_default_bool(settings, ST_KEY_CACHE, false);
+
+	// Shared Background
+	obs_data_set_default_string(settings, ST_KEY_SHARE, "");
+	obs_data_set_default_string(settings, ST_KEY_SHARED, "");
+	obs_data_set_default_int(settings, ST_KEY_SHARED_OFFSET_X, 0);
+	obs_data_set_default_int(settings, ST_KEY_SHARED_OFFSET_Y, 0);
 }
 
 bool modified_properties(void*, obs_properties_t* props, obs_property* prop, obs_data_t* settings) noexcept
@@ -640,7 +1230,7 @@ try {
 	const char*     vsubtype = obs_data_get_string(settings, ST_KEY_SUBTYPE);
 
 	// Find new Type
-	auto type_found = list_of_types.find(vtype);
+	auto type_found = find_type(vtype);
 	if (type_found == list_of_types.end()) {
 		return false;
 	}
@@ -749,8 +1339,10 @@ try {
 		obs_property_set_visible(obs_properties_get(props, ST_KEY_MASK_REGION_FEATHER), show_region);
 		obs_property_set_visible(obs_properties_get(props, ST_KEY_MASK_REGION_FEATHER_SHIFT), show_region);
 		obs_property_set_visible(obs_properties_get(props, ST_KEY_MASK_REGION_INVERT), show_region);
+		obs_property_set_visible(obs_properties_get(props, ST_KEY_MASK_REGION_TRACKING), show_region);
 		obs_property_set_visible(obs_properties_get(props, ST_KEY_MASK_IMAGE), show_image);
 		obs_property_set_visible(obs_properties_get(props, ST_KEY_MASK_SOURCE), show_source);
+		obs_property_set_visible(obs_properties_get(props, ST_KEY_MASK_SOURCE_SCALE), show_source);
 		obs_property_set_visible(obs_properties_get(props, ST_KEY_MASK_COLOR), show_image || show_source);
 		obs_property_set_visible(obs_properties_get(props, ST_KEY_MASK_ALPHA), show_image || show_source);
 		obs_property_set_visible(obs_properties_get(props, ST_KEY_MASK_MULTIPLIER), show_image || show_source);
@@ -784,6 +1376,9 @@ obs_properties_t* blur_factory::get_properties2(blur_instance* data)
 		obs_property_list_add_string(p, D_TRANSLATE(S_BLUR_TYPE_GAUSSIAN), "gaussian");
 		obs_property_list_add_string(p, D_TRANSLATE(S_BLUR_TYPE_GAUSSIAN_LINEAR), "gaussian_linear");
 		obs_property_list_add_string(p, D_TRANSLATE(S_BLUR_TYPE_DUALFILTERING), "dual_filtering");
+		obs_property_list_add_string(p, D_TRANSLATE(S_BLUR_TYPE_MIPMAP), "mipmap");
+		obs_property_list_add_string(p, D_TRANSLATE(S_BLUR_TYPE_SUMMEDAREA), "summed_area");
+		obs_property_list_add_string(p, D_TRANSLATE(S_BLUR_TYPE_AUTOMATIC), "automatic");
 
 		p = obs_properties_add_list(pr, ST_KEY_SUBTYPE, D_TRANSLATE(ST_I18N_SUBTYPE), OBS_COMBO_TYPE_LIST,
 									OBS_COMBO_FORMAT_STRING);
@@ -833,6 +1428,7 @@ obs_properties_t* blur_factory::get_properties2(blur_instance* data)
 		p = obs_properties_add_float_slider(pr, ST_KEY_MASK_REGION_FEATHER_SHIFT,
 											D_TRANSLATE(ST_I18N_MASK_REGION_FEATHER_SHIFT), -100.0, 100.0, 0.01);
 		p = obs_properties_add_bool(pr, ST_KEY_MASK_REGION_INVERT, D_TRANSLATE(ST_I18N_MASK_REGION_INVERT));
+		p = obs_properties_add_bool(pr, ST_KEY_MASK_REGION_TRACKING, D_TRANSLATE(ST_I18N_MASK_REGION_TRACKING));
 		/// Image
 		{
 			std::string filter =
@@ -857,6 +1453,9 @@ obs_properties_t* blur_factory::get_properties2(blur_instance* data)
 				return false;
 			},
 			obs::source_tracker::filter_scenes);
+		p = obs_properties_add_float_slider(pr, ST_KEY_MASK_SOURCE_SCALE, D_TRANSLATE(ST_I18N_MASK_SOURCE_SCALE),
+											12.5, 100.0, 0.1);
+		obs_property_float_set_suffix(p, " %");
 
 		/// Shared
 		p = obs_properties_add_color(pr, ST_KEY_MASK_COLOR, D_TRANSLATE(ST_I18N_MASK_COLOR));
@@ -865,6 +1464,28 @@ obs_properties_t* blur_factory::get_properties2(blur_instance* data)
 											0.01);
 	}
 
+	// Cache
+	{
+		p = obs_properties_add_bool(pr, ST_KEY_CACHE, D_TRANSLATE(ST_I18N_CACHE));
+		if (data) {
+			std::string text = translate_string(D_TRANSLATE(ST_I18N_CACHE_HITRATE), data->get_cache_hit_rate() * 100.);
+			p                = obs_properties_add_text(pr, ST_KEY_CACHE_HITRATE, text.c_str(), OBS_TEXT_INFO);
+		}
+	}
+
+	// Shared Background
+	{
+		p = obs_properties_add_text(pr, ST_KEY_SHARE, D_TRANSLATE(ST_I18N_SHARE), OBS_TEXT_DEFAULT);
+		p = obs_properties_add_text(pr, ST_KEY_SHARED, D_TRANSLATE(ST_I18N_SHARED), OBS_TEXT_DEFAULT);
+		p = obs_properties_add_int(pr, ST_KEY_SHARED_OFFSET_X, D_TRANSLATE(ST_I18N_SHARED_OFFSET_X), -16384, 16384, 1);
+		p = obs_properties_add_int(pr, ST_KEY_SHARED_OFFSET_Y, D_TRANSLATE(ST_I18N_SHARED_OFFSET_Y), -16384, 16384, 1);
+	}
+
+	// Benchmark
+	{
+		p = obs_properties_add_button2(pr, ST_KEY_BENCHMARK, D_TRANSLATE(ST_I18N_BENCHMARK), on_benchmark, this);
+	}
+
 	return pr;
 }
 
@@ -878,6 +1499,258 @@ std::string blur_factory::translate_string(const char* format, ...)
 	return std::string(buffer.data(), buffer.data() + len);
 }
 
+void blur_factory::run_benchmark()
+{
+	std::unique_lock<std::mutex> lock(_benchmark_lock);
+	if (_benchmark_run) {
+		DLOG_INFO("<filter-blur> Blur algorithms are already being benchmarked.");
+		return;
+	}
+
+	std::vector<std::pair<std::string, ::streamfx::gfx::blur::ifactory*>> factories;
+	for (auto& kv : list_of_types) {
+		factories.emplace_back(kv.first, &kv.second.fn());
+	}
+	_benchmark_run = std::make_shared<::streamfx::gfx::blur::benchmark>(factories);
+
+	// Each frame only renders a single step, so this runs alongside everything else until the results are in.
+	DLOG_INFO("<filter-blur> Benchmarking all blur algorithms in the background, this may take a while...");
+	obs_add_main_render_callback(benchmark_callback, this);
+}
+
+void blur_factory::step_benchmark()
+{
+	std::shared_ptr<::streamfx::gfx::blur::benchmark> run;
+	{
+		std::unique_lock<std::mutex> lock(_benchmark_lock);
+		run = _benchmark_run;
+	}
+	if (!run || !run->step()) {
+		return;
+	}
+
+	auto results = run->get_results();
+	for (auto& result : results) {
+		const char* subtype = "";
+		for (auto& kv : list_of_subtypes) {
+			if (kv.second.type == result.type) {
+				subtype = kv.first.c_str();
+			}
+		}
+
+		if (result.time < 0) {
+			DLOG_INFO("<filter-blur>   %-16s %-12s %4" PRIu32 "x%-4" PRIu32 " Size %6.1f: unavailable",
+					  result.name.c_str(), subtype, result.width, result.height, result.size);
+		} else {
+			DLOG_INFO("<filter-blur>   %-16s %-12s %4" PRIu32 "x%-4" PRIu32 " Size %6.1f: %10.1fµs",
+					  result.name.c_str(), subtype, result.width, result.height, result.size, result.time);
+		}
+	}
+
+	std::string device = get_device_identifier();
+
+	{
+		std::unique_lock<std::mutex> lock(_benchmark_lock);
+		_benchmark        = std::move(results);
+		_benchmark_loaded = true;
+		save_calibration(device);
+		_benchmark_run.reset();
+	}
+
+	// libobs walks the callbacks backwards under a recursive lock, so they may remove themselves.
+	obs_remove_main_render_callback(benchmark_callback, this);
+}
+
+void blur_factory::benchmark_callback(void* data, uint32_t, uint32_t)
+{
+	reinterpret_cast<blur_factory*>(data)->step_benchmark();
+}
+
+std::string blur_factory::find_fastest_type(::streamfx::gfx::blur::type type, double_t& size, uint32_t width,
+											uint32_t height)
+{
+	std::unique_lock<std::mutex> lock(_benchmark_lock);
+	if (!_benchmark_loaded) {
+		load_calibration();
+	}
+
+	double_t    pixels       = double_t(std::max<uint32_t>(width, 1)) * double_t(std::max<uint32_t>(height, 1));
+	std::string best_type;
+	double_t    best_size    = size;
+	double_t    best_time    = std::numeric_limits<double_t>::max();
+	bool        uncalibrated = false;
+	for (const char* name : automatic_types) {
+		auto& factory = list_of_types.at(name).fn();
+		if (!factory.is_type_supported(type)) {
+			continue;
+		}
+
+		double_t candidate_size = (strcmp(name, "dual_filtering") == 0) ? radius_to_levels(size) : size;
+		candidate_size = std::clamp(candidate_size, factory.get_min_size(type), factory.get_max_size(type));
+
+		// Use the measured resolution closest to the source, then the measured sizes on either side.
+		double_t                                        closest = std::numeric_limits<double_t>::max();
+		const ::streamfx::gfx::blur::benchmark::result* lower   = nullptr;
+		const ::streamfx::gfx::blur::benchmark::result* upper   = nullptr;
+		for (auto& result : _benchmark) {
+			if ((result.name != name) || (result.type != type) || (result.time < 0)) {
+				continue;
+			}
+
+			double_t distance = std::abs(std::log(double_t(result.width) * double_t(result.height) / pixels));
+			if (distance < closest - DBL_EPSILON) {
+				closest = distance;
+				lower   = nullptr;
+				upper   = nullptr;
+			} else if (distance > closest + DBL_EPSILON) {
+				continue;
+			}
+
+			if ((result.size <= candidate_size) && (!lower || (result.size > lower->size))) {
+				lower = &result;
+			}
+			if ((result.size >= candidate_size) && (!upper || (result.size < upper->size))) {
+				upper = &result;
+			}
+		}
+
+		if (!lower && !upper) {
+			uncalibrated = true;
+			break;
+		}
+
+		double_t time;
+		auto     edge = lower ? lower : upper;
+		if (lower && upper && (upper->size > lower->size)) {
+			double_t t = (candidate_size - lower->size) / (upper->size - lower->size);
+			time       = lower->time + (upper->time - lower->time) * t;
+		} else {
+			// Outside of the measured range, the cost grows about linearly with the size.
+			time = edge->time * std::max(candidate_size / edge->size, 1.0);
+		}
+		time *= pixels / (double_t(edge->width) * double_t(edge->height));
+
+		if (time < best_time) {
+			best_type = name;
+			best_size = candidate_size;
+			best_time = time;
+		}
+	}
+
+	if (uncalibrated) {
+		// Without a calibration, expect linear blurs to scale with the radius and dual filtering to stay cheap.
+		bool use_dual = (type == ::streamfx::gfx::blur::type::Area) && (size > 8.0);
+		best_type     = use_dual ? "dual_filtering" : "gaussian_linear";
+		auto& factory = list_of_types.at(best_type).fn();
+		best_size     = use_dual ? radius_to_levels(size) : size;
+		best_size     = std::clamp(best_size, factory.get_min_size(type), factory.get_max_size(type));
+	}
+
+	size = best_size;
+	return best_type;
+}
+
+void blur_factory::share(const std::string& name, std::shared_ptr<streamfx::obs::gs::rendertarget> rt)
+{
+	std::unique_lock<std::mutex> lock(_shared_lock);
+	_shared[name] = std::move(rt);
+}
+
+void blur_factory::unshare(const std::string& name, const std::shared_ptr<streamfx::obs::gs::rendertarget>& rt)
+{
+	std::unique_lock<std::mutex> lock(_shared_lock);
+	if (auto kv = _shared.find(name); (kv != _shared.end()) && (kv->second == rt)) {
+		_shared.erase(kv);
+	}
+}
+
+std::shared_ptr<streamfx::obs::gs::rendertarget> blur_factory::get_shared(const std::string& name)
+{
+	std::unique_lock<std::mutex> lock(_shared_lock);
+	if (auto kv = _shared.find(name); kv != _shared.end()) {
+		return kv->second;
+	}
+	return nullptr;
+}
+
+void blur_factory::load_calibration()
+{
+	_benchmark_loaded = true;
+
+	auto config = streamfx::configuration::instance();
+	if (!config) {
+		return;
+	}
+
+	auto        dataptr     = config->get();
+	obs_data_t* calibration = obs_data_get_obj(dataptr.get(), ST_CFG_CALIBRATION);
+	if (!calibration) {
+		return;
+	}
+
+	// A calibration is only valid for the GPU that it was measured on.
+	if (get_device_identifier() == obs_data_get_string(calibration, ST_CFG_CALIBRATION_DEVICE)) {
+		obs_data_array_t* results = obs_data_get_array(calibration, ST_CFG_CALIBRATION_RESULTS);
+		for (std::size_t idx = 0, edx = obs_data_array_count(results); idx < edx; idx++) {
+			obs_data_t* item = obs_data_array_item(results, idx);
+
+			::streamfx::gfx::blur::benchmark::result result;
+			result.name   = obs_data_get_string(item, "name");
+			result.type   = static_cast<::streamfx::gfx::blur::type>(obs_data_get_int(item, "type"));
+			result.width  = static_cast<uint32_t>(obs_data_get_int(item, "width"));
+			result.height = static_cast<uint32_t>(obs_data_get_int(item, "height"));
+			result.size   = obs_data_get_double(item, "size");
+			result.time   = obs_data_get_double(item, "time");
+			_benchmark.push_back(result);
+
+			obs_data_release(item);
+		}
+		obs_data_array_release(results);
+	}
+	obs_data_release(calibration);
+}
+
+void blur_factory::save_calibration(const std::string& device)
+{
+	auto config = streamfx::configuration::instance();
+	if (!config) {
+		return;
+	}
+
+	// Only the types that "Automatic" picks from are worth keeping.
+	obs_data_array_t* results = obs_data_array_create();
+	for (auto& result : _benchmark) {
+		if (std::find_if(std::begin(automatic_types), std::end(automatic_types),
+						 [&result](const char* name) { return result.name == name; })
+			== std::end(automatic_types)) {
+			continue;
+		}
+
+		obs_data_t* item = obs_data_create();
+		obs_data_set_string(item, "name", result.name.c_str());
+		obs_data_set_int(item, "type", static_cast<long long>(result.type));
+		obs_data_set_int(item, "width", result.width);
+		obs_data_set_int(item, "height", result.height);
+		obs_data_set_double(item, "size", result.size);
+		obs_data_set_double(item, "time", result.time);
+		obs_data_array_push_back(results, item);
+		obs_data_release(item);
+	}
+
+	obs_data_t* calibration = obs_data_create();
+	obs_data_set_string(calibration, ST_CFG_CALIBRATION_DEVICE, device.c_str());
+	obs_data_set_array(calibration, ST_CFG_CALIBRATION_RESULTS, results);
+	obs_data_set_obj(config->get().get(), ST_CFG_CALIBRATION, calibration);
+	obs_data_release(calibration);
+	obs_data_array_release(results);
+}
+
+bool blur_factory::on_benchmark(obs_properties_t*, obs_property_t*, void* data)
+{
+	reinterpret_cast<blur_factory*>(data)->run_benchmark();
+	return false;
+}
+
 #ifdef ENABLE_FRONTEND
 bool blur_factory::on_manual_open(obs_properties_t* props, obs_property_t* property, void* data)
 {
@@ -23,13 +23,22 @@
 #include <functional>
 #include <list>
 #include <map>
+#include <mutex>
 #include "gfx/blur/gfx-blur-base.hpp"
+#include "gfx/blur/gfx-blur-benchmark.hpp"
+#include "gfx/blur/gfx-blur-downsample.hpp"
 #include "gfx/gfx-source-texture.hpp"
+#include "gfx/gfx-texture-file.hpp"
 #include "obs/gs/gs-effect.hpp"
 #include "obs/gs/gs-helper.hpp"
+#include "obs/gs/gs-readback.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-texture.hpp"
+#include "obs/gs/gs-timer.hpp"
+#include "obs/obs-governor.hpp"
 #include "obs/obs-source-factory.hpp"
+#include "util/util-tracking.hpp"
 
 namespace streamfx::filter::blur {
 	enum class mask_type : int64_t {
@@ -38,9 +47,26 @@ namespace streamfx::filter::blur {
 		Source,
 	};
 
-	class blur_instance : public obs::source_instance {
+	class blur_instance : public obs::source_instance, public obs::degradable {
 		// Effects
-		streamfx::obs::gs::effect _effect_mask;
+		enum mask_parameter {
+			IMAGE_ORIG,
+			IMAGE_BLUR,
+			MASK_REGION_LEFT,
+			MASK_REGION_RIGHT,
+			MASK_REGION_TOP,
+			MASK_REGION_BOTTOM,
+			MASK_REGION_FEATHER,
+			MASK_REGION_FEATHER_SHIFT,
+			MASK_IMAGE,
+			MASK_COLOR,
+			MASK_MULTIPLIER,
+			_MASK_COUNT,
+		};
+		streamfx::obs::gs::effect                         _effect_mask;
+		streamfx::obs::gs::effect_parameters<_MASK_COUNT> _effect_mask_parameters;
+
+		bool _created; // Render targets and effects exist.
 
 		// Input
 		std::shared_ptr<streamfx::obs::gs::rendertarget> _source_rt;
@@ -52,8 +78,47 @@ namespace streamfx::filter::blur {
 		std::shared_ptr<streamfx::obs::gs::rendertarget> _output_rt;
 		bool                                             _output_rendered;
 
+		// Pooled target that _output_texture belongs to, held so the pool can't hand it out again.
+		std::shared_ptr<streamfx::obs::gs::rendertarget> _output_lease;
+
+		// Part of the output any scene shows, see obs::tools::visible_region.
+		struct {
+			bool     known;
+			uint32_t region[4];
+		} _visible;
+
+		// Intermediate targets, only held while rendering.
+		std::shared_ptr<streamfx::obs::gs::rendertarget_pool> _pool;
+
+		// Temporal Cache
+		struct {
+			bool                               enabled;
+			bool                               valid;   // Output matches the current settings.
+			bool                               changed; // Input changed in the last frame that was read back.
+			::streamfx::gfx::blur::downsampler downsampler;
+			::streamfx::obs::gs::readback      readback;
+			uint32_t                           width;
+			uint32_t                           height;
+			uint64_t                           frame;
+			uint64_t                           hash;
+			uint64_t                           hits;
+			uint64_t                           total;
+		} _cache;
+
+		// Shared Background, see blur_factory::share.
+		struct {
+			std::string                                      share; // Name the blurred input is published under.
+			std::shared_ptr<streamfx::obs::gs::rendertarget> rt;
+			std::string                                      name; // Name of the blur used instead of an own one.
+			int32_t                                          offset_x;
+			int32_t                                          offset_y;
+		} _shared;
+
 		// Blur
 		std::shared_ptr<::streamfx::gfx::blur::base> _blur;
+		bool                                         _blur_automatic;
+		std::string                                  _blur_automatic_type;
+		::streamfx::gfx::blur::type                  _blur_subtype;
 		double_t                                     _blur_size;
 		double_t                                     _blur_angle;
 		std::pair<double_t, double_t>                _blur_center;
@@ -72,15 +137,20 @@ namespace streamfx::filter::blur {
 				float_t feather;
 				float_t feather_shift;
 				bool    invert;
+				bool    tracking; // Follow the first face found by a tracker on the same source.
+
+				::streamfx::util::tracking::subscription tracked;
 			} region;
 			struct {
-				std::string                                 path;
-				std::string                                 path_old;
-				std::shared_ptr<streamfx::obs::gs::texture> texture;
+				std::string                                  path;
+				std::string                                  path_old;
+				std::shared_ptr<streamfx::gfx::texture_file> file;
+				std::shared_ptr<streamfx::obs::gs::texture>  texture;
 			} image;
 			struct {
 				std::string                                    name_old;
 				std::string                                    name;
+				float_t                                        scale; // Of the capture, relative to the source.
 				bool                                           is_scene;
 				std::shared_ptr<streamfx::gfx::source_texture> source_texture;
 				std::shared_ptr<streamfx::obs::gs::texture>    texture;
@@ -94,26 +164,51 @@ namespace streamfx::filter::blur {
 			float_t multiplier;
 		} _mask;
 
+		// Governor
+		::streamfx::gfx::blur::downsampler _degrade_downsampler;
+
+#ifdef ENABLE_PROFILING
+		// Profiling
+		std::shared_ptr<streamfx::obs::gs::gpu_timer> _gpu_timer;
+#endif
+
 		public:
 		blur_instance(obs_data_t* settings, obs_source_t* self);
 		~blur_instance();
 
+		private:
+		void create();
+
 		public:
 		virtual void load(obs_data_t* settings) override;
 		virtual void migrate(obs_data_t* settings, uint64_t version) override;
 		virtual void update(obs_data_t* settings) override;
 
 		virtual void video_tick(float_t time) override;
+		virtual void idle() override;
 		virtual void video_render(gs_effect_t* effect) override;
 
+		double_t get_cache_hit_rate();
+
 		private:
-		bool apply_mask_parameters(streamfx::obs::gs::effect effect, gs_texture_t* original_texture,
-								   gs_texture_t* blurred_texture);
+		bool is_source_unchanged(uint32_t width, uint32_t height);
+
+		bool get_region_of_interest(uint32_t width, uint32_t height, uint32_t inner[4], uint32_t outer[4]);
+
+		bool apply_mask_parameters(gs_texture_t* original_texture, gs_texture_t* blurred_texture);
 	};
 
 	class blur_factory : public obs::source_factory<filter::blur::blur_factory, filter::blur::blur_instance> {
 		std::vector<std::string> _translation_cache;
 
+		std::mutex                                            _benchmark_lock;
+		std::vector<::streamfx::gfx::blur::benchmark::result> _benchmark;
+		bool                                                  _benchmark_loaded;
+		std::shared_ptr<::streamfx::gfx::blur::benchmark>     _benchmark_run; // Advanced once per frame.
+
+		std::mutex                                                              _shared_lock;
+		std::map<std::string, std::shared_ptr<streamfx::obs::gs::rendertarget>> _shared;
+
 		public:
 		blur_factory();
 		virtual ~blur_factory();
@@ -126,6 +221,41 @@ namespace streamfx::filter::blur {
 
 		std::string translate_string(const char* format, ...);
 
+		void run_benchmark();
+
+		/** Pick the fastest blur type for an "Automatic" instance.
+		 *
+		 * @param type Blur subtype that has to be supported.
+		 * @param size Blur radius in pixels, replaced with the size the chosen type expects.
+		 * @return Key of the chosen entry in the list of types.
+		 */
+		std::string find_fastest_type(::streamfx::gfx::blur::type type, double_t& size, uint32_t width,
+									  uint32_t height);
+
+		/** Publish a blurred background under a name, so that other instances can use it instead of blurring the
+		 * same content again. Many frosted panels over one background then only cost a single blur.
+		 */
+		void share(const std::string& name, std::shared_ptr<streamfx::obs::gs::rendertarget> rt);
+
+		/** Withdraw a blurred background, unless someone else took over the name in the meantime. */
+		void unshare(const std::string& name, const std::shared_ptr<streamfx::obs::gs::rendertarget>& rt);
+
+		/** Find the blurred background published under a name, it holds the latest frame of its blur. */
+		std::shared_ptr<streamfx::obs::gs::rendertarget> get_shared(const std::string& name);
+
+		private:
+		void load_calibration();
+
+		void save_calibration(const std::string& device);
+
+		void step_benchmark();
+
+		static void benchmark_callback(void* data, uint32_t cx, uint32_t cy);
+
+		public:
+
+		static bool on_benchmark(obs_properties_t* props, obs_property_t* property, void* data);
+
 #ifdef ENABLE_FRONTEND
 		static bool on_manual_open(obs_properties_t* props, obs_property_t* property, void* data);
 #endif
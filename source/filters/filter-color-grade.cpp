@@ -19,8 +19,11 @@
 
 #include "filter-color-grade.hpp"
 #include "strings.hpp"
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
+#include "obs/obs-tools.hpp"
 
 // OBS
 #ifdef _MSC_VER
@@ -73,6 +76,15 @@
 #define ST_KEY_CORRECTION_(x) ST_KEY_CORRECTION "." x
 #define ST_I18N_CORRECTION ST_I18N ".Correction"
 #define ST_I18N_CORRECTION_(x) ST_I18N_CORRECTION "." x
+// Automatic Adjustment
+#define ST_KEY_AUTOMATIC "Filter.ColorGrade.Automatic"
+#define ST_I18N_AUTOMATIC ST_I18N ".Automatic"
+#define ST_KEY_AUTOMATIC_WHITEBALANCE ST_KEY_AUTOMATIC ".WhiteBalance"
+#define ST_I18N_AUTOMATIC_WHITEBALANCE ST_I18N_AUTOMATIC ".WhiteBalance"
+#define ST_KEY_AUTOMATIC_EXPOSURE ST_KEY_AUTOMATIC ".Exposure"
+#define ST_I18N_AUTOMATIC_EXPOSURE ST_I18N_AUTOMATIC ".Exposure"
+#define ST_KEY_AUTOMATIC_SPEED ST_KEY_AUTOMATIC ".Speed"
+#define ST_I18N_AUTOMATIC_SPEED ST_I18N_AUTOMATIC ".Speed"
 // Render Mode
 #define ST_KEY_RENDERMODE "Filter.ColorGrade.RenderMode"
 #define ST_I18N_RENDERMODE ST_I18N ".RenderMode"
@@ -82,6 +94,17 @@
 #define ST_I18N_RENDERMODE_LUT_6BIT ST_I18N_RENDERMODE ".LUT.6Bit"
 #define ST_I18N_RENDERMODE_LUT_8BIT ST_I18N_RENDERMODE ".LUT.8Bit"
 #define ST_I18N_RENDERMODE_LUT_10BIT ST_I18N_RENDERMODE ".LUT.10Bit"
+// LUT File
+#define ST_KEY_LUT_FILE "Filter.ColorGrade.LUT.File"
+#define ST_I18N_LUT_FILE ST_I18N ".LUT.File"
+// LUT Interpolation
+#define ST_KEY_LUT_INTERPOLATION "Filter.ColorGrade.LUT.Interpolation"
+#define ST_I18N_LUT_INTERPOLATION ST_I18N ".LUT.Interpolation"
+#define ST_I18N_LUT_INTERPOLATION_TRILINEAR ST_I18N_LUT_INTERPOLATION ".Trilinear"
+#define ST_I18N_LUT_INTERPOLATION_TETRAHEDRAL ST_I18N_LUT_INTERPOLATION ".Tetrahedral"
+// LUT Error
+#define ST_KEY_LUT_ERROR "Filter.ColorGrade.LUT.MaximumError"
+#define ST_I18N_LUT_ERROR ST_I18N ".LUT.MaximumError"
 
 #define ST_RED "Red"
 #define ST_GREEN "Green"
@@ -112,18 +135,51 @@ static constexpr std::string_view HELP_URL = "https://github.com/Xaymar/obs-Stre
 
 #define ST_PREFIX "<filter::color-grade> "
 
+// Frames without a change to the settings before the automatic render mode bakes the grade into a LUT.
+#define ST_LUT_BAKE_FRAMES 30
+
+// Mean luma that automatic exposure aims for, which is middle grey in sRGB.
+#define ST_AUTO_EXPOSURE_TARGET 0.46f
+// Share of the highlights that automatic exposure keeps from clipping.
+#define ST_AUTO_EXPOSURE_HIGHLIGHTS 0.99f
+// Automatic gains never go past this factor in either direction.
+#define ST_AUTO_GAIN_LIMIT 4.f
+// Change in an automatic gain that is worth grading again for, smaller steps are held back.
+#define ST_AUTO_GAIN_STEP (1.f / 256.f)
+
+// Permutations of color-grade.effect, in the order they are listed there.
+#define ST_VARIANT_TINT_HSL (1u << 0)
+#define ST_VARIANT_TINT_YUV_SDR (1u << 1)
+#define ST_VARIANT_TINT_EXP (1u << 2)
+#define ST_VARIANT_TINT_EXP2 (1u << 3)
+#define ST_VARIANT_TINT_LOG (1u << 4)
+#define ST_VARIANT_TINT_LOG10 (1u << 5)
+#define ST_VARIANT_NO_TINT (1u << 6)
+#define ST_VARIANT_NO_CORRECTION (1u << 7)
+
 color_grade_instance::~color_grade_instance() {}
 
 color_grade_instance::color_grade_instance(obs_data_t* data, obs_source_t* self)
-	: obs::source_instance(data, self), _effect(),
+	: obs::source_instance(data, self), _effects(), _effect(),
 
 	  _lift(), _gamma(), _gain(), _offset(), _tint_detection(), _tint_luma(), _tint_exponent(), _tint_low(),
-	  _tint_mid(), _tint_hig(), _correction(), _lut_enabled(true), _lut_depth(),
+	  _tint_mid(), _tint_hig(), _correction(), _lut_enabled(true), _lut_depth(), _lut_depth_recommended(false),
+	  _lut_file_path(), _lut_interpolation(), _lut_error(), _auto_white_balance(false), _auto_exposure(false),
+	  _auto_speed(1.f),
+
+	  _auto_statistics(), _auto_gain(), _auto_applied(),
 
 	  _cache_rt(), _cache_texture(), _cache_fresh(false),
 
-	  _lut_initialized(false), _lut_dirty(true), _lut_producer(), _lut_consumer()
+	  _lut_initialized(false), _lut_dirty(true), _lut_producer(), _lut_consumer(), _lut_cache(), _lut_file(),
+	  _lut_file_watch(), _lut_file_applied(false), _lut_automatic(false), _lut_static_frames(0),
+
+	  _direct_input(false), _renders(0)
 {
+#ifdef ENABLE_PROFILING
+	_gpu_timer = streamfx::obs::gs::gpu_timer::get("Color Grading");
+#endif
+
 	// Load the color grading effect.
 	auto path = streamfx::data_file_path("effects/color-grade.effect");
 	if (!std::filesystem::exists(path)) {
@@ -131,7 +187,10 @@ color_grade_instance::color_grade_instance(obs_data_t* data, obs_source_t* self)
 		throw std::runtime_error("Failed to load color grade effect.");
 	} else {
 		try {
-			_effect = streamfx::obs::gs::effect::create(path.u8string());
+			_effects = streamfx::obs::gs::effect_permutations(path, {"TINT_HSL", "TINT_YUV_SDR", "TINT_EXP",
+																	  "TINT_EXP2", "TINT_LOG", "TINT_LOG10", "NO_TINT",
+																	  "NO_CORRECTION"});
+			_effect  = _effects.get(0);
 		} catch (std::exception const& ex) {
 			DLOG_ERROR(ST_PREFIX "Failed to load effect '%s': %s", path.u8string().c_str(), ex.what());
 			throw;
@@ -142,6 +201,7 @@ color_grade_instance::color_grade_instance(obs_data_t* data, obs_source_t* self)
 	try {
 		_lut_producer    = std::make_shared<streamfx::gfx::lut::producer>();
 		_lut_consumer    = std::make_shared<streamfx::gfx::lut::consumer>();
+		_lut_cache       = streamfx::gfx::lut::cache::instance();
 		_lut_initialized = true;
 	} catch (std::exception const& ex) {
 		DLOG_WARNING(ST_PREFIX "Failed to initialize LUT rendering, falling back to direct rendering.\n%s", ex.what());
@@ -156,7 +216,16 @@ color_grade_instance::color_grade_instance(obs_data_t* data, obs_source_t* self)
 		throw;
 	}
 
+	vec4_set(&_auto_gain, 1.f, 1.f, 1.f, 1.f);
+	_auto_applied = _auto_gain;
+
 	update(data);
+	_lut_static_frames = ST_LUT_BAKE_FRAMES;
+	enable_idle_tracking();
+	enable_render_sharing();
+	enable_update_coalescing(0.05f);
+	enable_preview_profile();
+	enable_prewarm();
 }
 
 void color_grade_instance::allocate_rendertarget(gs_color_format format)
@@ -176,6 +245,7 @@ float_t fix_gamma_value(double_t v)
 void color_grade_instance::load(obs_data_t* data)
 {
 	update(data);
+	_lut_static_frames = ST_LUT_BAKE_FRAMES;
 }
 
 void color_grade_instance::migrate(obs_data_t* data, uint64_t version) {}
@@ -215,21 +285,114 @@ void color_grade_instance::update(obs_data_t* data)
 	_correction.z   = static_cast<float_t>(obs_data_get_double(data, ST_KEY_CORRECTION_(ST_LIGHTNESS)) / 100.0);
 	_correction.w   = static_cast<float_t>(obs_data_get_double(data, ST_KEY_CORRECTION_(ST_CONTRAST)) / 100.0);
 
+	_auto_white_balance = obs_data_get_bool(data, ST_KEY_AUTOMATIC_WHITEBALANCE);
+	_auto_exposure      = obs_data_get_bool(data, ST_KEY_AUTOMATIC_EXPOSURE);
+	_auto_speed         = static_cast<float_t>(obs_data_get_double(data, ST_KEY_AUTOMATIC_SPEED));
+
+	// Disabled adjustments stop right away instead of fading out.
+	if (!_auto_white_balance) {
+		_auto_gain.x    = _auto_gain.y = _auto_gain.z = 1.f;
+		_auto_applied.x = _auto_applied.y = _auto_applied.z = 1.f;
+	}
+	if (!_auto_exposure) {
+		_auto_gain.w = _auto_applied.w = 1.f;
+	}
+	if (!is_automatic()) {
+		_auto_statistics.reset();
+	}
+
+	{ // Use the variant of the effect that only has the code these settings need.
+		uint32_t variant = 0;
+		switch (_tint_detection) {
+		case detection_mode::HSL:
+			variant |= ST_VARIANT_TINT_HSL;
+			break;
+		case detection_mode::YUV_SDR:
+			variant |= ST_VARIANT_TINT_YUV_SDR;
+			break;
+		default:
+			break;
+		}
+		switch (_tint_luma) {
+		case luma_mode::Exp:
+			variant |= ST_VARIANT_TINT_EXP;
+			break;
+		case luma_mode::Exp2:
+			variant |= ST_VARIANT_TINT_EXP2;
+			break;
+		case luma_mode::Log:
+			variant |= ST_VARIANT_TINT_LOG;
+			break;
+		case luma_mode::Log10:
+			variant |= ST_VARIANT_TINT_LOG10;
+			break;
+		default:
+			break;
+		}
+
+		auto is_white = [](const vec3& v) { return (v.x == 1.f) && (v.y == 1.f) && (v.z == 1.f); };
+		if (is_white(_tint_low) && is_white(_tint_mid) && is_white(_tint_hig)) {
+			variant |= ST_VARIANT_NO_TINT;
+		}
+		if ((_correction.x == 0.f) && (_correction.y == 1.f) && (_correction.z == 1.f)) {
+			variant |= ST_VARIANT_NO_CORRECTION;
+		}
+
+		try {
+			// Keep the previous variant if this one failed, it is at least close to the settings.
+			if (auto effect = _effects.get(variant); effect) {
+				_effect = effect;
+			}
+		} catch (const std::exception& ex) {
+			DLOG_ERROR(ST_PREFIX "Failed to compile variant %" PRIu32 " of the effect: %s", variant, ex.what());
+		}
+	}
+
+	_lut_interpolation =
+		static_cast<streamfx::gfx::lut::interpolation>(obs_data_get_int(data, ST_KEY_LUT_INTERPOLATION));
+	_lut_error = static_cast<float_t>(obs_data_get_double(data, ST_KEY_LUT_ERROR));
+
 	{
 		int64_t v = obs_data_get_int(data, ST_KEY_RENDERMODE);
 
 		// LUT status depends on selected option.
-		_lut_enabled = v != 0; // 0 (Direct)
-
-		if (v == -1) {
-			_lut_depth = streamfx::gfx::lut::color_depth::_8;
-		} else if (v > 0) {
+		_lut_enabled   = v != 0; // 0 (Direct)
+		_lut_automatic = v == -1;
+
+		// Direct rendering still needs a depth for the LUT that is used outside of program.
+		_lut_depth_recommended = (v <= 0);
+		if (v <= 0) {
+			_lut_depth = recommend_depth();
+		} else {
 			_lut_depth = static_cast<streamfx::gfx::lut::color_depth>(v);
 		}
 	}
 
-	if (_lut_enabled && _lut_initialized)
+	if (std::string path = obs_data_get_string(data, ST_KEY_LUT_FILE); path != _lut_file_path) {
+		_lut_file_path = path;
+		_lut_file.reset();
+		_lut_file_watch.reset();
+	}
+	if (!_lut_file_path.empty()) {
+		// An imported LUT can only be applied through a LUT, so direct rendering is not an option.
+		if (!_lut_enabled) {
+			_lut_enabled           = true;
+			_lut_depth             = streamfx::gfx::lut::color_depth::_8;
+			_lut_depth_recommended = false;
+		}
+
+		load_lut_file();
+		if (!_lut_file_watch) {
+			_lut_file_watch = streamfx::util::file_watcher::instance()->add(std::filesystem::u8path(_lut_file_path));
+		}
+	}
+
+	if (_lut_initialized)
 		_lut_dirty = true;
+
+	// Settings are usually changed many times in a row while a slider is dragged, so the automatic render mode
+	// renders directly until they settle instead of baking a LUT that is thrown away on the next frame.
+	_lut_static_frames = 0;
 }
 
 void color_grade_instance::prepare_effect()
@@ -243,7 +406,9 @@ void color_grade_instance::prepare_effect()
 	}
 
 	if (auto p = _effect.get_parameter("pGain"); p) {
-		p.set_float4(_gain);
+		vec4 gain;
+		vec4_mul(&gain, &_gain, &_auto_applied);
+		p.set_float4(gain);
 	}
 
 	if (auto p = _effect.get_parameter("pOffset"); p) {
@@ -254,14 +419,6 @@ void color_grade_instance::prepare_effect()
 		p.set_float4(_lift);
 	}
 
-	if (auto p = _effect.get_parameter("pTintDetection"); p) {
-		p.set_int(static_cast<int32_t>(_tint_detection));
-	}
-
-	if (auto p = _effect.get_parameter("pTintMode"); p) {
-		p.set_int(static_cast<int32_t>(_tint_luma));
-	}
-
 	if (auto p = _effect.get_parameter("pTintExponent"); p) {
 		p.set_float(_tint_exponent);
 	}
@@ -283,22 +440,105 @@ void color_grade_instance::prepare_effect()
 	}
 }
 
+uint64_t color_grade_instance::hash_lut()
+{
+	// Everything that ends up in the LUT, see prepare_effect().
+	float_t values[] = {
+		_lift.x,       _lift.y,       _lift.z,       _lift.w,       _gamma.x,      _gamma.y,      _gamma.z,
+		_gamma.w,      _gain.x,       _gain.y,       _gain.z,       _gain.w,       _offset.x,     _offset.y,
+		_offset.z,     _offset.w,     _tint_low.x,   _tint_low.y,   _tint_low.z,   _tint_mid.x,   _tint_mid.y,
+		_tint_mid.z,   _tint_hig.x,   _tint_hig.y,   _tint_hig.z,   _correction.x, _correction.y, _correction.z,
+		_correction.w, _tint_exponent, _auto_applied.x, _auto_applied.y, _auto_applied.z, _auto_applied.w,
+	};
+	int32_t modes[] = {static_cast<int32_t>(_tint_detection), static_cast<int32_t>(_tint_luma)};
+
+	uint64_t hash = 14695981039346656037ull; // FNV-1a
+	auto     feed = [&hash](const void* ptr, std::size_t size) {
+		for (auto byte = reinterpret_cast<const uint8_t*>(ptr); size > 0; size--, byte++) {
+			hash = (hash ^ *byte) * 1099511628211ull;
+		}
+	};
+	feed(values, sizeof(values));
+	feed(modes, sizeof(modes));
+	if (_lut_file && _lut_file->get_texture()) {
+		uint64_t file_hash = _lut_file->hash();
+		feed(&file_hash, sizeof(file_hash));
+	}
+	return hash;
+}
+
+streamfx::gfx::lut::color_depth color_grade_instance::recommend_depth()
+{
+	// Nearly all of the curvature comes from the per-channel part of the grade, which is evaluated here for every
+	// candidate depth. Tint and color correction are close to linear within a single cell, and are left out. As they
+	// are left out, 4 bits is the least that is recommended, 2 bits is too coarse for them even on a flat grade.
+	auto curve = [this](std::size_t c, float_t v) {
+		v = 1.f - (1.f - v) * (1.f - _lift.ptr[c]) * (1.f - _lift.w);
+		v = std::copysign(std::pow(std::abs(v), _gamma.ptr[c] * _gamma.w), v);
+		v = v * _gain.ptr[c] * _gain.w * _auto_applied.ptr[c] * _auto_applied.w;
+		v = v + _offset.ptr[c] + _offset.w;
+		v = v * _correction.z;
+		v = (v - .5f) * _correction.w + .5f;
+		return std::clamp(v, 0.f, 1.f);
+	};
+
+	for (auto depth : {streamfx::gfx::lut::color_depth::_4, streamfx::gfx::lut::color_depth::_6}) {
+		uint32_t cells = (1u << static_cast<uint32_t>(depth)) - 1;
+		float_t  error = 0.;
+
+		for (std::size_t c = 0; c < 3; c++) {
+			for (uint32_t cell = 0; cell < cells; cell++) {
+				float_t lo = curve(c, static_cast<float_t>(cell) / cells);
+				float_t hi = curve(c, static_cast<float_t>(cell + 1) / cells);
+				for (uint32_t step = 1; step < 8; step++) {
+					float_t t = static_cast<float_t>(step) / 8.f;
+					float_t v = curve(c, (static_cast<float_t>(cell) + t) / cells);
+					error     = std::max(error, std::abs(v - (lo + (hi - lo) * t)));
+				}
+			}
+		}
+
+		// The bound is given in steps of an 8-bit output.
+		if ((error * 255.f) <= _lut_error) {
+			return depth;
+		}
+	}
+
+	return streamfx::gfx::lut::color_depth::_8;
+}
+
 void color_grade_instance::rebuild_lut()
 {
 #ifdef ENABLE_PROFILING
 	streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_cache, "Rebuild LUT"};
 #endif
 
-	// Generate a fresh LUT texture.
-	auto lut_texture = _lut_producer->produce(_lut_depth);
+	// An imported LUT replaces the identity LUT once it has been read, which applies the grade on top of it.
+	std::shared_ptr<streamfx::obs::gs::texture> file_texture;
+	if (_lut_file && _lut_file->is_ready()) {
+		file_texture      = _lut_file->get_texture();
+		_lut_file_applied = true;
+	}
+
+	// Instances with the same grade share one LUT, so there is nothing to render if one already exists.
+	uint64_t hash = hash_lut();
+	if (auto lut = _lut_cache->find(hash, _lut_depth); lut) {
+		_lut_rt = lut;
+		_lut_rt->get_texture(_lut_texture);
+		if (!_lut_texture) {
+			throw std::runtime_error("Failed to retrieve shared LUT texture.");
+		}
+		_lut_dirty = false;
+		return;
+	}
+
+	// Generate a fresh LUT texture, unless there is an imported one.
+	auto lut_texture = file_texture ? file_texture : _lut_producer->produce(_lut_depth);
 
 	// Modify the LUT with our color grade.
 	if (lut_texture) {
-		// Check if we have a render target to work with and if it's the correct format.
-		if (!_lut_rt || (lut_texture->get_color_format() != _lut_rt->get_color_format())) {
-			// Create a new render target with new format.
-			_lut_rt = std::make_unique<streamfx::obs::gs::rendertarget>(lut_texture->get_color_format(), GS_ZS_NONE);
-		}
+		// Always use a new render target, as the previous one may be shared with other instances.
+		_lut_rt = std::make_shared<streamfx::obs::gs::rendertarget>(lut_texture->get_color_format(), GS_ZS_NONE);
 
 		// Prepare our color grade effect.
 		prepare_effect();
@@ -330,6 +570,7 @@ void color_grade_instance::rebuild_lut()
 		if (!_lut_texture) {
 			throw std::runtime_error("Failed to produce modified LUT texture.");
 		}
+		_lut_cache->insert(hash, _lut_depth, _lut_rt);
 	} else {
 		throw std::runtime_error("Failed to produce LUT texture.");
 	}
@@ -337,8 +578,124 @@ void color_grade_instance::rebuild_lut()
 	_lut_dirty = false;
 }
 
-void color_grade_instance::video_tick(float)
+bool color_grade_instance::is_automatic()
 {
+	return _auto_white_balance || _auto_exposure;
+}
+
+void color_grade_instance::update_automatic(float_t time)
+{
+	const streamfx::gfx::image_statistics::result* stats = _auto_statistics ? _auto_statistics->get() : nullptr;
+	if (!stats) {
+		return;
+	}
+
+	// Both are measured on the input, so that the grade does not feed back into what it is adjusted by.
+	vec4 target = _auto_gain;
+	auto limit  = [](float_t v) { return std::clamp(v, 1.f / ST_AUTO_GAIN_LIMIT, ST_AUTO_GAIN_LIMIT); };
+
+	// Nearly black or flat frames say nothing about either, so the last adjustment is kept for those.
+	bool is_usable = (stats->mean.w > (1.f / 64.f)) && ((stats->maximum.w - stats->minimum.w) > (1.f / 64.f));
+	if (is_usable && _auto_white_balance) {
+		// Gray world: the average color of a scene is assumed to be neutral, at the brightness it already has.
+		for (std::size_t c = 0; c < 3; c++) {
+			target.ptr[c] = limit(stats->mean.w / std::max(stats->mean.ptr[c], 1.f / 255.f));
+		}
+	}
+	if (is_usable && _auto_exposure) {
+		// Bring the mean to middle grey, but do not push the brightest highlights past white to get there.
+		float_t highlights = stats->percentile(stats->luma, ST_AUTO_EXPOSURE_HIGHLIGHTS);
+		float_t exposure   = ST_AUTO_EXPOSURE_TARGET / stats->mean.w;
+		if (exposure > 1.f) {
+			exposure = std::max(1.f, std::min(exposure, 1.f / std::max(highlights, 1.f / 255.f)));
+		}
+		target.w = limit(exposure);
+	}
+
+	// Ease towards the target, reaching about two thirds of the way within the configured time.
+	float_t blend = 1.f - std::exp(-time / std::max(_auto_speed, 0.01f));
+	bool    moved = false;
+	for (std::size_t c = 0; c < 4; c++) {
+		_auto_gain.ptr[c] += (target.ptr[c] - _auto_gain.ptr[c]) * blend;
+		if (std::abs(_auto_gain.ptr[c] - _auto_applied.ptr[c]) >= ST_AUTO_GAIN_STEP) {
+			moved = true;
+		}
+	}
+
+	// Every step needs a new LUT, so they are only taken once they are large enough to be seen.
+	if (moved) {
+		_auto_applied = _auto_gain;
+		if (_lut_depth_recommended && _lut_file_path.empty()) {
+			_lut_depth = recommend_depth();
+		}
+		if (_lut_enabled && _lut_initialized) {
+			_lut_dirty = true;
+		}
+		_lut_static_frames = 0;
+	}
+}
+
+void color_grade_instance::load_lut_file()
+{
+	// Files are shared by path, modification time and depth, so asking again is cheap.
+	try {
+		_lut_file = streamfx::gfx::lut::file::load(std::filesystem::u8path(_lut_file_path), _lut_depth);
+	} catch (const std::exception& ex) {
+		DLOG_WARNING(ST_PREFIX "Failed to load LUT '%s': %s", _lut_file_path.c_str(), ex.what());
+		_lut_file.reset();
+	}
+	_lut_file_applied = false;
+}
+
+bool color_grade_instance::is_lut_active()
+{
+	if (!_lut_initialized) {
+		return false;
+	}
+	if (is_preview_render()) {
+		// Outside of program a LUT is always good enough, no matter how the grade is rendered otherwise.
+		return true;
+	}
+	if (!_lut_enabled) {
+		return false;
+	}
+	if (_lut_automatic && !_lut_file && (_lut_static_frames < ST_LUT_BAKE_FRAMES)) {
+		return false;
+	}
+	return true;
+}
+
+void color_grade_instance::idle()
+{
+	// Both caches are re-created on the next render, only the LUT is kept as it is expensive to bake.
+	_ccache_rt.reset();
+	_ccache_texture.reset();
+	_ccache_fresh = false;
+	_auto_statistics.reset();
+	allocate_rendertarget(_cache_rt->get_color_format());
+	_cache_texture.reset();
+	_cache_fresh = false;
+	_statistics->set_video_memory(streamfx::obs::statistics::texture_memory(_lut_texture));
+}
+
+void color_grade_instance::video_tick(float_t time)
+{
+	if (is_automatic()) {
+		update_automatic(time);
+	}
+
+	// A file saved over the imported LUT has a new modification time, under which it is read again.
+	if (_lut_file_watch && _lut_file_watch->changed()) {
+		load_lut_file();
+	}
+
+	// Only skip the caches if nothing else needed them in the last frame, as every render would grade again.
+	_direct_input = (_renders <= 1);
+	_renders      = 0;
+
+	if (_lut_static_frames < ST_LUT_BAKE_FRAMES) {
+		_lut_static_frames++;
+	}
 	_ccache_fresh = false;
 	_cache_fresh  = false;
 }
@@ -362,10 +719,42 @@ void color_grade_instance::video_render(gs_effect_t* shader)
 #ifdef ENABLE_PROFILING
 	streamfx::obs::gs::debug_marker gdmp{streamfx::obs::gs::debug_color_source, "Color Grading '%s'",
 										 obs_source_get_name(_self)};
+
+	streamfx::obs::gs::gpu_timer::scope gpt{_gpu_timer};
 #endif
 
-	// TODO: Optimize this once (https://github.com/obsproject/obs-studio/pull/4199) is merged.
-	// - We can skip the original capture and reduce the overall impact of this.
+	// The imported LUT finished reading since the last rebuild.
+	if (_lut_file && !_lut_file_applied && _lut_file->is_ready()) {
+		_lut_dirty = true;
+	}
+
+	// 0. Grade the input while it is rendered, which skips both caches entirely. Automatic adjustment needs the input
+	//    cache to measure it.
+	_renders++;
+	if (_direct_input && (_renders == 1) && !is_automatic()) {
+		if (is_lut_active()) {
+			try {
+				if (_lut_dirty) {
+					rebuild_lut();
+				}
+
+				auto effect = _lut_consumer->prepare(_lut_depth, _lut_texture);
+				streamfx::obs::tools::filter_direct_render(_self, effect->get_object(),
+														   streamfx::gfx::lut::consumer::technique(_lut_interpolation),
+														   width, height);
+				return;
+			} catch (std::exception const& ex) {
+				_lut_rt.reset();
+				_lut_texture.reset();
+				_lut_enabled = false;
+				DLOG_WARNING(ST_PREFIX "Reverting to direct rendering due to error: %s", ex.what());
+			}
+		}
+
+		prepare_effect();
+		streamfx::obs::tools::filter_direct_render(_self, _effect.get_object(), "Draw", width, height);
+		return;
+	}
 
 	// 1. Capture the filter/source rendered above this.
 	if (!_ccache_fresh || !_ccache_texture) {
@@ -420,10 +809,27 @@ void color_grade_instance::video_render(gs_effect_t* shader)
 
 		// Mark the input cache as valid.
 		_ccache_fresh = true;
+
+		// Measure the fresh input, the results arrive a few frames later and are applied in video_tick(). Outside of
+		// program the last adjustment is kept.
+		if (is_automatic() && !is_preview_render()) {
+			try {
+				if (!_auto_statistics) {
+					_auto_statistics = std::make_shared<streamfx::gfx::image_statistics>();
+				}
+				_auto_statistics->update(_ccache_texture);
+			} catch (std::exception const& ex) {
+				DLOG_WARNING(ST_PREFIX "Disabling automatic adjustment due to error: %s", ex.what());
+				_auto_statistics.reset();
+				_auto_white_balance = false;
+				_auto_exposure      = false;
+			}
+		}
 	}
 
 	// 2. Apply one of the two rendering methods (LUT or Direct).
-	if (_lut_initialized && _lut_enabled) { // Try to apply with the LUT based method.
+	bool use_lut = is_lut_active();
+	if (use_lut) { // Try to apply with the LUT based method.
 		try {
 #ifdef ENABLE_PROFILING
 			streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_convert, "LUT Rendering"};
@@ -468,7 +874,8 @@ void color_grade_instance::video_render(gs_effect_t* shader)
 
 					auto effect = _lut_consumer->prepare(_lut_depth, _lut_texture);
 					effect->get_parameter("image").set_texture(_ccache_texture);
-					while (gs_effect_loop(effect->get_object(), "Draw")) {
+					while (gs_effect_loop(effect->get_object(),
+										  streamfx::gfx::lut::consumer::technique(_lut_interpolation))) {
 						streamfx::gs_draw_fullscreen_tri();
 					}
 
@@ -487,10 +894,11 @@ void color_grade_instance::video_render(gs_effect_t* shader)
 			_lut_rt.reset();
 			_lut_texture.reset();
 			_lut_enabled = false;
+			use_lut      = false;
 			DLOG_WARNING(ST_PREFIX "Reverting to direct rendering due to error: %s", ex.what());
 		}
 	}
-	if ((!_lut_initialized || !_lut_enabled) && !_cache_fresh) {
+	if (!use_lut && !_cache_fresh) {
 #ifdef ENABLE_PROFILING
 		streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_convert, "Direct Rendering"};
 #endif
@@ -546,6 +954,8 @@ void color_grade_instance::video_render(gs_effect_t* shader)
 	}
 
 	// 3. Render the output cache.
+	_statistics->set_video_memory(streamfx::obs::statistics::texture_memory(_cache_texture)
+								  + streamfx::obs::statistics::texture_memory(_lut_texture));
 	{
 #ifdef ENABLE_PROFILING
 		streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_cache_render, "Draw Cache"};
@@ -616,8 +1026,22 @@ void color_grade_factory::get_defaults2(obs_data_t* data)
 	obs_data_set_default_double(data, ST_KEY_CORRECTION_(ST_SATURATION), 100.0);
 	obs_data_set_default_double(data, ST_KEY_CORRECTION_(ST_LIGHTNESS), 100.0);
 	obs_data_set_default_double(data, ST_KEY_CORRECTION_(ST_CONTRAST), 100.0);
+	obs_data_set_default_bool(data, ST_KEY_AUTOMATIC_WHITEBALANCE, false);
+	obs_data_set_default_bool(data, ST_KEY_AUTOMATIC_EXPOSURE, false);
+	obs_data_set_default_double(data, ST_KEY_AUTOMATIC_SPEED, 1.0);
 
 	obs_data_set_default_int(data, ST_KEY_RENDERMODE, -1);
+	obs_data_set_default_string(data, ST_KEY_LUT_FILE, "");
+	obs_data_set_default_int(data, ST_KEY_LUT_INTERPOLATION,
+							 static_cast<int64_t>(streamfx::gfx::lut::interpolation::Trilinear));
+	obs_data_set_default_double(data, ST_KEY_LUT_ERROR, 1.0);
+}
+
+static bool modified_rendermode(obs_properties_t* props, obs_property_t*, obs_data_t* settings) noexcept
+{
+	obs_property_set_visible(obs_properties_get(props, ST_KEY_LUT_ERROR),
+							 obs_data_get_int(settings, ST_KEY_RENDERMODE) == -1);
+	return true;
 }
 
 obs_properties_t* color_grade_factory::get_properties2(color_grade_instance* data)
@@ -814,6 +1238,19 @@ obs_properties_t* color_grade_factory::get_properties2(color_grade_instance* dat
 		}
 	}
 
+	{
+		obs_properties_t* grp = obs_properties_create();
+		obs_properties_add_group(pr, ST_KEY_AUTOMATIC, D_TRANSLATE(ST_I18N_AUTOMATIC), OBS_GROUP_NORMAL, grp);
+
+		obs_properties_add_bool(grp, ST_KEY_AUTOMATIC_WHITEBALANCE, D_TRANSLATE(ST_I18N_AUTOMATIC_WHITEBALANCE));
+		obs_properties_add_bool(grp, ST_KEY_AUTOMATIC_EXPOSURE, D_TRANSLATE(ST_I18N_AUTOMATIC_EXPOSURE));
+		{
+			auto p = obs_properties_add_float_slider(grp, ST_KEY_AUTOMATIC_SPEED, D_TRANSLATE(ST_I18N_AUTOMATIC_SPEED),
+													 0.1, 10., .1);
+			obs_property_float_set_suffix(p, " s");
+		}
+	}
+
 	{
 		obs_properties_t* grp = obs_properties_create();
 		obs_properties_add_group(pr, S_ADVANCED, D_TRANSLATE(S_ADVANCED), OBS_GROUP_NORMAL, grp);
@@ -845,6 +1282,12 @@ obs_properties_t* color_grade_factory::get_properties2(color_grade_instance* dat
 
 		obs_properties_add_float_slider(grp, ST_KEY_TINT_EXPONENT, D_TRANSLATE(ST_I18N_TINT_EXPONENT), 0., 10., .01);
 
+		{
+			std::string filter = std::string(D_TRANSLATE(S_FILETYPE_LUTS)) + " (" S_FILEFILTERS_LUT ")";
+			obs_properties_add_path(grp, ST_KEY_LUT_FILE, D_TRANSLATE(ST_I18N_LUT_FILE), OBS_PATH_FILE, filter.c_str(),
+									nullptr);
+		}
+
 		{
 			auto p = obs_properties_add_list(grp, ST_KEY_RENDERMODE, D_TRANSLATE(ST_I18N_RENDERMODE),
 											 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
@@ -860,6 +1303,18 @@ obs_properties_t* color_grade_factory::get_properties2(color_grade_instance* dat
 			for (auto kv : els) {
 				obs_property_list_add_int(p, D_TRANSLATE(kv.first), kv.second);
 			}
+			obs_property_set_modified_callback(p, modified_rendermode);
+		}
+
+		obs_properties_add_float_slider(grp, ST_KEY_LUT_ERROR, D_TRANSLATE(ST_I18N_LUT_ERROR), 0.1, 16., .1);
+
+		{
+			auto p = obs_properties_add_list(grp, ST_KEY_LUT_INTERPOLATION, D_TRANSLATE(ST_I18N_LUT_INTERPOLATION),
+											 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_LUT_INTERPOLATION_TRILINEAR),
+									  static_cast<int64_t>(streamfx::gfx::lut::interpolation::Trilinear));
+			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_LUT_INTERPOLATION_TETRAHEDRAL),
+									  static_cast<int64_t>(streamfx::gfx::lut::interpolation::Tetrahedral));
 		}
 	}
 
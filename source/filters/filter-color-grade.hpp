@@ -19,15 +19,20 @@
 
 #pragma once
 #include <vector>
+#include "gfx/gfx-image-statistics.hpp"
+#include "gfx/lut/gfx-lut-cache.hpp"
 #include "gfx/lut/gfx-lut-consumer.hpp"
+#include "gfx/lut/gfx-lut-file.hpp"
 #include "gfx/lut/gfx-lut-producer.hpp"
 #include "gfx/lut/gfx-lut.hpp"
 #include "obs/gs/gs-mipmapper.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-texture.hpp"
+#include "obs/gs/gs-timer.hpp"
 #include "obs/gs/gs-vertexbuffer.hpp"
 #include "obs/obs-source-factory.hpp"
 #include "plugin.hpp"
+#include "util/util-file-watcher.hpp"
 
 namespace streamfx::filter::color_grade {
 	enum class detection_mode {
@@ -45,22 +50,30 @@ namespace streamfx::filter::color_grade {
 	};
 
 	class color_grade_instance : public obs::source_instance {
-		streamfx::obs::gs::effect _effect;
+		streamfx::obs::gs::effect_permutations _effects;
+		streamfx::obs::gs::effect              _effect; // Variant for the current settings.
 
 		// User Configuration
-		vec4                            _lift;
-		vec4                            _gamma;
-		vec4                            _gain;
-		vec4                            _offset;
-		detection_mode                  _tint_detection;
-		luma_mode                       _tint_luma;
-		float_t                         _tint_exponent;
-		vec3                            _tint_low;
-		vec3                            _tint_mid;
-		vec3                            _tint_hig;
-		vec4                            _correction;
-		bool                            _lut_enabled;
-		streamfx::gfx::lut::color_depth _lut_depth;
+		vec4                              _lift;
+		vec4                              _gamma;
+		vec4                              _gain;
+		vec4                              _offset;
+		detection_mode                    _tint_detection;
+		luma_mode                         _tint_luma;
+		float_t                           _tint_exponent;
+		vec3                              _tint_low;
+		vec3                              _tint_mid;
+		vec3                              _tint_hig;
+		vec4                              _correction;
+		bool                              _lut_enabled;
+		streamfx::gfx::lut::color_depth   _lut_depth;
+		bool                              _lut_depth_recommended; // Follows recommend_depth() as the grade changes.
+		std::string                       _lut_file_path;
+		streamfx::gfx::lut::interpolation _lut_interpolation;
+		float_t                           _lut_error;
+		bool                              _auto_white_balance;
+		bool                              _auto_exposure;
+		float_t                           _auto_speed;
 
 		// Capture Cache
 		std::shared_ptr<streamfx::obs::gs::rendertarget> _ccache_rt;
@@ -68,18 +81,38 @@ namespace streamfx::filter::color_grade {
 		bool                                             _ccache_fresh;
 
 		// LUT work flow
-		bool                                             _lut_initialized;
-		bool                                             _lut_dirty;
-		std::shared_ptr<streamfx::gfx::lut::producer>    _lut_producer;
-		std::shared_ptr<streamfx::gfx::lut::consumer>    _lut_consumer;
-		std::shared_ptr<streamfx::obs::gs::rendertarget> _lut_rt;
-		std::shared_ptr<streamfx::obs::gs::texture>      _lut_texture;
+		bool                                                 _lut_initialized;
+		bool                                                 _lut_dirty;
+		std::shared_ptr<streamfx::gfx::lut::producer>        _lut_producer;
+		std::shared_ptr<streamfx::gfx::lut::consumer>        _lut_consumer;
+		std::shared_ptr<streamfx::gfx::lut::cache>           _lut_cache;
+		std::shared_ptr<streamfx::gfx::lut::file>            _lut_file;
+		std::shared_ptr<streamfx::util::file_watcher::watch> _lut_file_watch;
+		bool                                                 _lut_file_applied;
+		bool                                                 _lut_automatic;
+		uint32_t                                             _lut_static_frames;
+		std::shared_ptr<streamfx::obs::gs::rendertarget>     _lut_rt;
+		std::shared_ptr<streamfx::obs::gs::texture>          _lut_texture;
+
+		// Automatic Adjustment
+		std::shared_ptr<streamfx::gfx::image_statistics> _auto_statistics;
+		vec4                                             _auto_gain;    // Follows the statistics, w is the exposure.
+		vec4                                             _auto_applied; // What is actually graded with.
 
 		// Render Cache
 		std::shared_ptr<streamfx::obs::gs::rendertarget> _cache_rt;
 		std::shared_ptr<streamfx::obs::gs::texture>      _cache_texture;
 		bool                                             _cache_fresh;
 
+		// Direct Input
+		bool     _direct_input;
+		uint32_t _renders;
+
+#ifdef ENABLE_PROFILING
+		// Profiling
+		std::shared_ptr<streamfx::obs::gs::gpu_timer> _gpu_timer;
+#endif
+
 		public:
 		color_grade_instance(obs_data_t* data, obs_source_t* self);
 		virtual ~color_grade_instance();
@@ -92,9 +125,22 @@ namespace streamfx::filter::color_grade {
 
 		void prepare_effect();
 
+		uint64_t hash_lut();
+
+		streamfx::gfx::lut::color_depth recommend_depth();
+
+		bool is_automatic();
+
+		void update_automatic(float_t time);
+
 		void rebuild_lut();
 
+		void load_lut_file();
+
+		bool is_lut_active();
+
 		virtual void video_tick(float_t time) override;
+		virtual void idle() override;
 		virtual void video_render(gs_effect_t* effect) override;
 	};
 
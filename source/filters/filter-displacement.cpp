@@ -19,9 +19,17 @@
 
 #include "filter-displacement.hpp"
 #include "strings.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <sstream>
 #include <stdexcept>
+#include <vector>
 #include <sys/stat.h>
 #include "obs/gs/gs-helper.hpp"
+#include "obs/obs-source-tracker.hpp"
+#include "plugin.hpp"
+#include "util/utility.hpp"
 
 #define ST_I18N "Filter.Displacement"
 #define ST_I18N_FILE "Filter.Displacement.File"
@@ -30,22 +38,122 @@
 #define ST_KEY_SCALE "Filter.Displacement.Scale"
 #define ST_I18N_SCALE_TYPE "Filter.Displacement.Scale.Type"
 #define ST_KEY_SCALE_TYPE "Filter.Displacement.Scale.Type"
+#define ST_I18N_COMPACT "Filter.Displacement.Compact"
+#define ST_KEY_COMPACT "Filter.Displacement.Compact"
+#define ST_I18N_TYPE "Filter.Displacement.Type"
+#define ST_I18N_TYPE_FILE ST_I18N_TYPE ".File"
+#define ST_I18N_TYPE_SOURCE ST_I18N_TYPE ".Source"
+#define ST_KEY_TYPE "Filter.Displacement.Type"
+#define ST_I18N_SOURCE "Filter.Displacement.Source"
+#define ST_KEY_SOURCE "Filter.Displacement.Source"
+#define ST_I18N_SOURCE_RESOLUTION ST_I18N_SOURCE ".Resolution"
+#define ST_I18N_SOURCE_RESOLUTION_(x) ST_I18N_SOURCE_RESOLUTION "." D_VSTR(x)
+#define ST_KEY_SOURCE_RESOLUTION "Filter.Displacement.Source.Resolution"
+#define ST_I18N_SOURCE_SKIP ST_I18N_SOURCE ".SkipUnchanged"
+#define ST_KEY_SOURCE_SKIP "Filter.Displacement.Source.SkipUnchanged"
+
+// Size of the thumbnail compared to find out whether the map source changed, large enough that small moving details
+// still show up in it.
+#define ST_THUMBNAIL_SIZE 128
+
+// Captures in a row that have to match before any are skipped, and frames between captures from then on. A change
+// shows up at most that many frames late, which is barely visible for anything that stayed static before.
+#define ST_SKIP_AFTER 4
+#define ST_SKIP_INTERVAL 8
+
+enum class map_type : int64_t {
+	File   = 0,
+	Source = 1,
+};
+
+#define ST_PREFIX "<filter::displacement> "
 
 using namespace streamfx::filter::displacement;
 
-displacement_instance::displacement_instance(obs_data_t* data, obs_source_t* context)
-	: obs::source_instance(data, context)
+static void convert_displacement_map(streamfx::gfx::texture_file::image& map, bool compact)
 {
-	_effect = streamfx::obs::gs::effect::create(streamfx::data_file_path("effects/displace.effect").u8string());
+	// Only red and green are used by displace.effect, so the compact format drops the rest.
+	std::size_t in_channels[4] = {0, 1, 2, 3};
+	if ((map.format == GS_BGRA) || (map.format == GS_BGRX)) {
+		in_channels[0] = 2;
+		in_channels[2] = 0;
+	} else if (map.format != GS_RGBA) {
+		throw std::runtime_error("Unsupported image format.");
+	}
+	std::size_t          channels = compact ? 2 : 4;
+	std::vector<uint8_t> pixels   = std::move(map.mips.front());
+	uint32_t             width    = map.width;
+	uint32_t             height   = map.height;
+	map.format                    = compact ? GS_R8G8 : GS_RGBA;
+	map.mips.clear();
 
-	update(data);
+	// Mip mapping requires a power of two size, so resample to the next one with wrapping, like the sampler.
+	map.width  = uint32_t(1) << streamfx::util::math::get_power_of_two_exponent_ceil(width);
+	map.height = uint32_t(1) << streamfx::util::math::get_power_of_two_exponent_ceil(height);
+	{
+		std::vector<uint8_t> level(std::size_t(map.width) * map.height * channels);
+		for (uint32_t y = 0; y < map.height; y++) {
+			float_t     fy = (static_cast<float_t>(y) + .5f) * height / map.height - .5f;
+			float_t     ty = fy - std::floor(fy);
+			std::size_t y0 = static_cast<std::size_t>(std::floor(fy) + height) % height;
+			std::size_t y1 = (y0 + 1) % height;
+			for (uint32_t x = 0; x < map.width; x++) {
+				float_t     fx = (static_cast<float_t>(x) + .5f) * width / map.width - .5f;
+				float_t     tx = fx - std::floor(fx);
+				std::size_t x0 = static_cast<std::size_t>(std::floor(fx) + width) % width;
+				std::size_t x1 = (x0 + 1) % width;
+				for (std::size_t c = 0; c < channels; c++) {
+					auto at = [&](std::size_t px, std::size_t py) {
+						return static_cast<float_t>(pixels[(py * width + px) * 4 + in_channels[c]]);
+					};
+					float_t top    = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * tx;
+					float_t bottom = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * tx;
+					level[(std::size_t(y) * map.width + x) * channels + c] =
+						static_cast<uint8_t>(std::round(top + (bottom - top) * ty));
+				}
+			}
+		}
+		map.mips.push_back(std::move(level));
+	}
+
+	// Every further level is the average of four texels of the previous one.
+	for (uint32_t w = map.width, h = map.height; (w > 1) || (h > 1);) {
+		uint32_t nw = std::max<uint32_t>(w / 2, 1);
+		uint32_t nh = std::max<uint32_t>(h / 2, 1);
+
+		const std::vector<uint8_t>& src = map.mips.back();
+		std::vector<uint8_t>        level(std::size_t(nw) * nh * channels);
+		for (uint32_t y = 0; y < nh; y++) {
+			std::size_t y0 = std::min<std::size_t>(y * 2, h - 1);
+			std::size_t y1 = std::min<std::size_t>(y * 2 + 1, h - 1);
+			for (uint32_t x = 0; x < nw; x++) {
+				std::size_t x0 = std::min<std::size_t>(x * 2, w - 1);
+				std::size_t x1 = std::min<std::size_t>(x * 2 + 1, w - 1);
+				for (std::size_t c = 0; c < channels; c++) {
+					uint32_t sum = src[(y0 * w + x0) * channels + c] + src[(y0 * w + x1) * channels + c]
+								   + src[(y1 * w + x0) * channels + c] + src[(y1 * w + x1) * channels + c];
+					level[(std::size_t(y) * nw + x) * channels + c] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+		map.mips.push_back(std::move(level));
+
+		w = nw;
+		h = nh;
+	}
 }
 
-displacement_instance::~displacement_instance()
+displacement_instance::displacement_instance(obs_data_t* data, obs_source_t* context)
+	: obs::source_instance(data, context), _texture(), _texture_pending(), _texture_file(), _texture_compact(true),
+	  _source_name(), _source(), _source_divisor(1), _source_skip(false), _source_map(), _source_change()
 {
-	_texture.reset();
+	_effect = streamfx::obs::gs::effect::create_shared(streamfx::data_file_path("effects/displace.effect"));
+
+	update(data);
 }
 
+displacement_instance::~displacement_instance() {}
+
 void displacement_instance::load(obs_data_t* settings)
 {
 	update(settings);
@@ -68,13 +176,54 @@ void displacement_instance::update(obs_data_t* settings)
 	_scale[0] = _scale[1] = static_cast<float_t>(obs_data_get_double(settings, ST_KEY_SCALE));
 	_scale_type           = static_cast<float_t>(obs_data_get_double(settings, ST_KEY_SCALE_TYPE) / 100.0);
 
-	std::string new_file = obs_data_get_string(settings, ST_KEY_FILE);
-	if (new_file != _texture_file) {
+	// A source replaces the file entirely, so neither is held on to while the other is in use.
+	if (static_cast<map_type>(obs_data_get_int(settings, ST_KEY_TYPE)) == map_type::Source) {
+		_texture.reset();
+		_texture_pending.reset();
+		_texture_file.clear();
+
+		_source_divisor =
+			static_cast<uint32_t>(std::clamp<int64_t>(obs_data_get_int(settings, ST_KEY_SOURCE_RESOLUTION), 1, 8));
+		_source_skip = obs_data_get_bool(settings, ST_KEY_SOURCE_SKIP);
+		if (std::string name = obs_data_get_string(settings, ST_KEY_SOURCE); !_source || (name != _source_name)) {
+			_source_name = name;
+			_source.reset();
+			_source_map.reset();
+			try {
+				if (!name.empty()) {
+					_source = std::make_shared<streamfx::gfx::source_texture>(name, _self);
+				}
+			} catch (const std::exception& ex) {
+				DLOG_ERROR(ST_PREFIX "Failed to use source '%s' as displacement map: %s", name.c_str(), ex.what());
+			}
+		}
+		return;
+	}
+	_source_name.clear();
+	_source.reset();
+	_source_map.reset();
+
+	// Decoding and mip mapping happen on the thread pool, the current map stays in use until the new one is ready.
+	std::string new_file    = obs_data_get_string(settings, ST_KEY_FILE);
+	bool        new_compact = obs_data_get_bool(settings, ST_KEY_COMPACT);
+	if ((new_file != _texture_file) || (new_compact != _texture_compact)) {
+		_texture_file    = new_file;
+		_texture_compact = new_compact;
+
+		// Shared with every other displacement filter that uses the same file in the same way.
 		try {
-			_texture      = std::make_shared<streamfx::obs::gs::texture>(new_file);
-			_texture_file = new_file;
-		} catch (...) {
+			_texture_pending = streamfx::gfx::texture_file::load(
+				std::filesystem::u8path(new_file), new_compact ? "displacement.compact" : "displacement",
+				[new_compact](streamfx::gfx::texture_file::image& map) {
+					convert_displacement_map(map, new_compact);
+				},
+				false); // Offsets need every bit of precision.
+		} catch (const std::exception& ex) {
+			if (!new_file.empty()) {
+				DLOG_ERROR(ST_PREFIX "Failed to load displacement map '%s': %s", new_file.c_str(), ex.what());
+			}
 			_texture.reset();
+			_texture_pending.reset();
 		}
 	}
 }
@@ -87,7 +236,17 @@ void displacement_instance::video_tick(float_t)
 
 void displacement_instance::video_render(gs_effect_t*)
 {
-	if (!_texture) { // No displacement map, so just skip us for now.
+	if (_texture_pending && _texture_pending->is_ready()) {
+		_texture = std::move(_texture_pending);
+	}
+
+	std::shared_ptr<streamfx::obs::gs::texture> texture;
+	if (_source) {
+		texture = render_source_map();
+	} else if (_texture) {
+		texture = _texture->get_texture();
+	}
+	if (!texture) { // No displacement map, so just skip us for now.
 		obs_source_skip_video_filter(_self);
 		return;
 	}
@@ -105,7 +264,7 @@ void displacement_instance::video_render(gs_effect_t*)
 	_effect.get_parameter("image_size").set_float2(static_cast<float_t>(_width), static_cast<float_t>(_height));
 	_effect.get_parameter("image_inverse_size")
 		.set_float2(static_cast<float_t>(1.0 / _width), static_cast<float_t>(1.0 / _height));
-	_effect.get_parameter("normal").set_texture(_texture->get_object());
+	_effect.get_parameter("normal").set_texture(texture->get_object());
 	_effect.get_parameter("scale").set_float2(_scale[0], _scale[1]);
 	_effect.get_parameter("scale_type").set_float(_scale_type);
 
@@ -117,6 +276,93 @@ std::string displacement_instance::get_file()
 	return _texture_file;
 }
 
+std::shared_ptr<streamfx::obs::gs::texture> displacement_instance::render_source_map()
+{
+	obs_source_t* source = _source->get_object();
+	uint32_t      width  = obs_source_get_width(source) / _source_divisor;
+	uint32_t      height = obs_source_get_height(source) / _source_divisor;
+	if ((width == 0) || (height == 0)) {
+		return nullptr;
+	}
+
+	// Media and capture devices deliver new frames on their own, comparing them would only ever delay the map.
+	bool animated = (obs_source_get_output_flags(source) & OBS_SOURCE_ASYNC) != 0;
+	bool resized  = !_source_map || (_source_map->get_width() != width) || (_source_map->get_height() != height);
+	if (_source_skip && !animated && !resized && (_source_change.unchanged >= ST_SKIP_AFTER)
+		&& (++_source_change.skipped < ST_SKIP_INTERVAL)) {
+		return _source_map;
+	}
+	_source_change.skipped = 0;
+
+#ifdef ENABLE_PROFILING
+	streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_capture, "Displacement Source '%s'",
+										_source_name.c_str()};
+#endif
+
+	// Other filters using the same source at the same size share this capture.
+	auto capture = _source->render(width, height);
+	if (!capture || !_source_skip) {
+		return capture;
+	}
+
+	// The shared capture is replaced by the next frame, so skipping frames needs a copy of its own.
+	if (resized) {
+		_source_map = std::make_shared<streamfx::obs::gs::texture>(width, height, GS_RGBA, uint32_t(1), nullptr,
+																	streamfx::obs::gs::texture::flags::None);
+	}
+	gs_copy_texture(_source_map->get_object(), capture->get_object());
+	detect_source_change(capture);
+
+	return _source_map;
+}
+
+void displacement_instance::detect_source_change(std::shared_ptr<streamfx::obs::gs::texture> capture)
+{
+	// Reduce the capture to a small thumbnail, every halving averages 2x2 texels so that no part of it is skipped.
+	uint32_t width  = capture->get_width();
+	uint32_t height = capture->get_height();
+	uint32_t factor = 1;
+	while (((width / factor) > ST_THUMBNAIL_SIZE) || ((height / factor) > ST_THUMBNAIL_SIZE)) {
+		factor <<= 1;
+	}
+	auto thumbnail = _source_change.downsampler.downsample(capture, factor);
+	if (!thumbnail) {
+		_source_change.unchanged = 0; // Tiny already, capturing it every frame costs less than comparing it.
+		return;
+	}
+
+	uint32_t thumb_width  = std::max<uint32_t>(width / factor, 1);
+	uint32_t thumb_height = std::max<uint32_t>(height / factor, 1);
+	if ((_source_change.width != thumb_width) || (_source_change.height != thumb_height)) {
+		_source_change.readback.reset();
+		_source_change.width     = thumb_width;
+		_source_change.height    = thumb_height;
+		_source_change.hash      = 0;
+		_source_change.unchanged = 0;
+	}
+
+	// The thumbnail is read back a frame later, mapping it right away would stall until the GPU caught up.
+	_source_change.readback.stage(thumbnail->get_object(),
+								  [this](const uint8_t* ptr, uint32_t stride, uint32_t cols, uint32_t rows) {
+									  if (!ptr) {
+										  _source_change.unchanged = 0;
+										  return;
+									  }
+
+									  uint64_t hash = 14695981039346656037ull; // FNV-1a
+									  for (uint32_t y = 0; y < rows; y++) {
+										  const uint8_t* row = ptr + static_cast<size_t>(y) * stride;
+										  for (size_t x = 0; x < static_cast<size_t>(cols) * 4; x++) {
+											  hash = (hash ^ row[x]) * 1099511628211ull;
+										  }
+									  }
+
+									  _source_change.unchanged =
+										  (hash == _source_change.hash) ? _source_change.unchanged + 1 : 0;
+									  _source_change.hash = hash;
+								  });
+}
+
 displacement_factory::displacement_factory()
 {
 	_info.id           = S_PREFIX "filter-displacement";
@@ -141,6 +387,24 @@ void displacement_factory::get_defaults2(obs_data_t* data)
 								streamfx::data_file_path("examples/normal-maps/neutral.png").u8string().c_str());
 	obs_data_set_default_double(data, ST_KEY_SCALE, 0.0);
 	obs_data_set_default_double(data, ST_KEY_SCALE_TYPE, 0.0);
+	obs_data_set_default_bool(data, ST_KEY_COMPACT, true);
+	obs_data_set_default_int(data, ST_KEY_TYPE, static_cast<int64_t>(map_type::File));
+	obs_data_set_default_string(data, ST_KEY_SOURCE, "");
+	obs_data_set_default_int(data, ST_KEY_SOURCE_RESOLUTION, 1);
+	obs_data_set_default_bool(data, ST_KEY_SOURCE_SKIP, false);
+}
+
+static bool modified_type(obs_properties_t* pr, obs_property_t*, obs_data_t* data) noexcept
+try {
+	bool is_source = static_cast<map_type>(obs_data_get_int(data, ST_KEY_TYPE)) == map_type::Source;
+	obs_property_set_visible(obs_properties_get(pr, ST_KEY_FILE), !is_source);
+	obs_property_set_visible(obs_properties_get(pr, ST_KEY_COMPACT), !is_source);
+	obs_property_set_visible(obs_properties_get(pr, ST_KEY_SOURCE), is_source);
+	obs_property_set_visible(obs_properties_get(pr, ST_KEY_SOURCE_RESOLUTION), is_source);
+	obs_property_set_visible(obs_properties_get(pr, ST_KEY_SOURCE_SKIP), is_source);
+	return true;
+} catch (...) {
+	return false;
 }
 
 obs_properties_t* displacement_factory::get_properties2(displacement_instance* data)
@@ -154,10 +418,48 @@ obs_properties_t* displacement_factory::get_properties2(displacement_instance* d
 		path = streamfx::data_file_path("examples/normal-maps/neutral.png").u8string();
 	}
 
+	{
+		auto p = obs_properties_add_list(pr, ST_KEY_TYPE, D_TRANSLATE(ST_I18N_TYPE), OBS_COMBO_TYPE_LIST,
+										 OBS_COMBO_FORMAT_INT);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_TYPE_FILE), static_cast<int64_t>(map_type::File));
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_TYPE_SOURCE), static_cast<int64_t>(map_type::Source));
+		obs_property_set_modified_callback(p, modified_type);
+	}
 	obs_properties_add_path(pr, ST_KEY_FILE, D_TRANSLATE(ST_I18N_FILE), obs_path_type::OBS_PATH_FILE,
 							D_TRANSLATE(S_FILEFILTERS_TEXTURE), path.c_str());
+	{
+		auto p = obs_properties_add_list(pr, ST_KEY_SOURCE, D_TRANSLATE(ST_I18N_SOURCE), OBS_COMBO_TYPE_LIST,
+										 OBS_COMBO_FORMAT_STRING);
+		obs_property_list_add_string(p, "", "");
+		obs::source_tracker::get()->enumerate(
+			[&p](std::string name, obs_source_t*) {
+				std::stringstream sstr;
+				sstr << name << " (" << D_TRANSLATE(S_SOURCETYPE_SOURCE) << ")";
+				obs_property_list_add_string(p, sstr.str().c_str(), name.c_str());
+				return false;
+			},
+			obs::source_tracker::filter_sources);
+		obs::source_tracker::get()->enumerate(
+			[&p](std::string name, obs_source_t*) {
+				std::stringstream sstr;
+				sstr << name << " (" << D_TRANSLATE(S_SOURCETYPE_SCENE) << ")";
+				obs_property_list_add_string(p, sstr.str().c_str(), name.c_str());
+				return false;
+			},
+			obs::source_tracker::filter_scenes);
+	}
+	{
+		auto p = obs_properties_add_list(pr, ST_KEY_SOURCE_RESOLUTION, D_TRANSLATE(ST_I18N_SOURCE_RESOLUTION),
+										 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_SOURCE_RESOLUTION_(Full)), 1);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_SOURCE_RESOLUTION_(Half)), 2);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_SOURCE_RESOLUTION_(Quarter)), 4);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_SOURCE_RESOLUTION_(Eighth)), 8);
+	}
+	obs_properties_add_bool(pr, ST_KEY_SOURCE_SKIP, D_TRANSLATE(ST_I18N_SOURCE_SKIP));
 	obs_properties_add_float(pr, ST_KEY_SCALE, D_TRANSLATE(ST_I18N_SCALE), -10000000.0, 10000000.0, 0.01);
 	obs_properties_add_float_slider(pr, ST_KEY_SCALE_TYPE, D_TRANSLATE(ST_I18N_SCALE_TYPE), 0.0, 100.0, 0.01);
+	obs_properties_add_bool(pr, ST_KEY_COMPACT, D_TRANSLATE(ST_I18N_COMPACT));
 
 	return pr;
 }
@@ -19,7 +19,12 @@
 
 #pragma once
 #include "common.hpp"
+#include <string>
+#include "gfx/blur/gfx-blur-downsample.hpp"
+#include "gfx/gfx-source-texture.hpp"
+#include "gfx/gfx-texture-file.hpp"
 #include "obs/gs/gs-effect.hpp"
+#include "obs/gs/gs-readback.hpp"
 #include "obs/obs-source-factory.hpp"
 
 namespace streamfx::filter::displacement {
@@ -27,10 +32,29 @@ namespace streamfx::filter::displacement {
 		streamfx::obs::gs::effect _effect;
 
 		// Displacement Map
-		std::shared_ptr<streamfx::obs::gs::texture> _texture;
-		std::string                                 _texture_file;
-		float_t                                     _scale[2];
-		float_t                                     _scale_type;
+		std::shared_ptr<streamfx::gfx::texture_file> _texture;
+		std::shared_ptr<streamfx::gfx::texture_file> _texture_pending; // Replaces _texture once it is decoded.
+		std::string                                  _texture_file;
+		bool                                         _texture_compact;
+
+		// Displacement Source, rendered once per frame and size for all users, see gfx::source_texture.
+		std::string                                    _source_name;
+		std::shared_ptr<streamfx::gfx::source_texture> _source;
+		uint32_t                                       _source_divisor; // Renders at 1/N of the source size.
+		bool                                           _source_skip;    // Only look for changes while it is static.
+		std::shared_ptr<streamfx::obs::gs::texture>    _source_map;     // Last capture, while captures are skipped.
+		struct {
+			::streamfx::gfx::blur::downsampler downsampler;
+			::streamfx::obs::gs::readback      readback;
+			uint32_t                           width;
+			uint32_t                           height;
+			uint64_t                           hash;
+			uint64_t                           unchanged; // Captures in a row that matched the one before.
+			uint64_t                           skipped;   // Frames since the last capture.
+		} _source_change;
+
+		float_t _scale[2];
+		float_t _scale_type;
 
 		// Cache
 		uint32_t _width;
@@ -48,6 +72,13 @@ namespace streamfx::filter::displacement {
 		virtual void video_render(gs_effect_t*) override;
 
 		std::string get_file();
+
+		private:
+		/** Capture the source as the map, or reuse the last capture while the source stays unchanged. */
+		std::shared_ptr<streamfx::obs::gs::texture> render_source_map();
+
+		/** Compare a thumbnail of the capture with that of the previous one, whose result arrives later. */
+		void detect_source_change(std::shared_ptr<streamfx::obs::gs::texture> capture);
 	};
 
 	class displacement_factory : public obs::source_factory<filter::displacement::displacement_factory,
@@ -19,6 +19,7 @@
 
 #include "filter-dynamic-mask.hpp"
 #include "strings.hpp"
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
 #include <vector>
@@ -37,6 +38,8 @@
 
 #define ST_I18N_INPUT "Filter.DynamicMask.Input"
 #define ST_KEY_INPUT "Filter.DynamicMask.Input"
+#define ST_I18N_INPUT_SCALE "Filter.DynamicMask.Input.Scale"
+#define ST_KEY_INPUT_SCALE "Filter.DynamicMask.Input.Scale"
 #define ST_I18N_CHANNEL "Filter.DynamicMask.Channel"
 #define ST_KEY_CHANNEL "Filter.DynamicMask.Channel"
 #define ST_I18N_CHANNEL_VALUE "Filter.DynamicMask.Channel.Value"
@@ -57,21 +60,33 @@ static std::pair<channel, const char*> channel_translations[] = {
 	{channel::Alpha, S_CHANNEL_ALPHA},
 };
 
-dynamic_mask_instance::dynamic_mask_instance(obs_data_t* settings, obs_source_t* self)
-	: obs::source_instance(settings, self), _translation_map(), _effect(), _have_filter_texture(false), _filter_rt(),
-	  _filter_texture(), _have_input_texture(false), _input(), _input_capture(), _input_texture(),
-	  _have_final_texture(false), _final_rt(), _final_texture(), _channels(), _precalc()
+static vec4* channel_row(matrix4& matrix, channel ch)
 {
-	_filter_rt = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-	_final_rt  = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	switch (ch) {
+	case channel::Green:
+		return &matrix.y;
+	case channel::Blue:
+		return &matrix.z;
+	case channel::Alpha:
+		return &matrix.t;
+	default:
+		return &matrix.x;
+	}
+}
 
+dynamic_mask_instance::dynamic_mask_instance(obs_data_t* settings, obs_source_t* self)
+	: obs::source_instance(settings, self), _effect(), _have_input_texture(false), _input(), _input_capture(),
+	  _input_texture(), _input_scale(1.0f), _have_final_texture(false), _graph(), _final_texture(),
+	  _direct_input(false), _renders(0), _precalc(), _mask()
+{
 	try {
-		_effect = streamfx::obs::gs::effect::create(streamfx::data_file_path("effects/channel-mask.effect").u8string());
+		_effect = streamfx::obs::gs::effect::create_shared(streamfx::data_file_path("effects/channel-mask.effect"));
 	} catch (const std::exception& ex) {
 		DLOG_ERROR("Loading channel mask effect failed with error(s):\n%s", ex.what());
 	}
 
 	update(settings);
+	enable_idle_tracking();
 }
 
 dynamic_mask_instance::~dynamic_mask_instance() {}
@@ -108,52 +123,63 @@ void dynamic_mask_instance::update(obs_data_t* settings)
 
 		DLOG_ERROR("Failed to update input: %s", ex.what());
 	}
+	_input_scale =
+		static_cast<float_t>(std::clamp(obs_data_get_double(settings, ST_KEY_INPUT_SCALE) / 100.0, 0.125, 1.0));
 
 	// Update data store
 	for (auto kv1 : channel_translations) {
-		auto found = _channels.find(kv1.first);
-		if (found == _channels.end()) {
-			_channels.insert({kv1.first, channel_data()});
-			found = _channels.find(kv1.first);
-			if (found == _channels.end()) {
-				assert(found != _channels.end());
-				throw std::runtime_error("Unable to insert element into data _store.");
-			}
-		}
-
 		std::string chv_key = std::string(ST_KEY_CHANNEL_VALUE) + "." + kv1.second;
-		found->second.value = static_cast<float_t>(obs_data_get_double(settings, chv_key.c_str()));
-		_precalc.base.ptr[static_cast<size_t>(kv1.first)] = found->second.value;
+		_precalc.base.ptr[static_cast<size_t>(kv1.first)] =
+			static_cast<float_t>(obs_data_get_double(settings, chv_key.c_str()));
 
 		std::string chm_key = std::string(ST_KEY_CHANNEL_MULTIPLIER) + "." + kv1.second;
-		found->second.scale = static_cast<float_t>(obs_data_get_double(settings, chm_key.c_str()));
-		_precalc.scale.ptr[static_cast<size_t>(kv1.first)] = found->second.scale;
-
-		vec4* ch = &_precalc.matrix.x;
-		switch (kv1.first) {
-		case channel::Red:
-			ch = &_precalc.matrix.x;
-			break;
-		case channel::Green:
-			ch = &_precalc.matrix.y;
-			break;
-		case channel::Blue:
-			ch = &_precalc.matrix.z;
-			break;
-		case channel::Alpha:
-			ch = &_precalc.matrix.t;
-			break;
-		default:
-			break;
-		}
+		_precalc.scale.ptr[static_cast<size_t>(kv1.first)] =
+			static_cast<float_t>(obs_data_get_double(settings, chm_key.c_str()));
 
+		vec4* ch = channel_row(_precalc.matrix, kv1.first);
 		for (auto kv2 : channel_translations) {
 			std::string ab_key = std::string(ST_KEY_CHANNEL_INPUT) + "." + kv1.second + "." + kv2.second;
-			found->second.values.ptr[static_cast<size_t>(kv2.first)] =
+			ch->ptr[static_cast<size_t>(kv2.first)] =
 				static_cast<float_t>(obs_data_get_double(settings, ab_key.c_str()));
-			ch->ptr[static_cast<size_t>(kv2.first)] = found->second.values.ptr[static_cast<size_t>(kv2.first)];
 		}
 	}
+
+	// Fold the multiplier into the matrix and base, which leaves a single multiply-add per input channel.
+	for (auto kv : channel_translations) {
+		vec4* from = channel_row(_precalc.matrix, kv.first);
+		vec4* to   = channel_row(_mask.matrix, kv.first);
+		vec4_mul(to, from, &_precalc.scale);
+	}
+	vec4_mul(&_mask.bias, &_precalc.base, &_precalc.scale);
+
+	// Most masks only drive the alpha channel, or drive all channels the same. Both only need one dot product.
+	vec4 columns[4];
+	for (std::size_t out = 0; out < 4; out++) {
+		vec4_set(&columns[out], _mask.matrix.x.ptr[out], _mask.matrix.y.ptr[out], _mask.matrix.z.ptr[out],
+				 _mask.matrix.t.ptr[out]);
+	}
+	auto is_equal = [](const vec4& a, const vec4& b) {
+		return (a.x == b.x) && (a.y == b.y) && (a.z == b.z) && (a.w == b.w);
+	};
+	vec4 zero;
+	vec4_zero(&zero);
+	bool is_alpha_only = true;
+	bool is_uniform    = true;
+	for (std::size_t out = 0; out < 3; out++) {
+		is_alpha_only &= is_equal(columns[out], zero) && (_mask.bias.ptr[out] == 1.f);
+		is_uniform &= is_equal(columns[out], columns[3]) && (_mask.bias.ptr[out] == _mask.bias.w);
+	}
+	vec4_copy(&_mask.vector, &columns[3]);
+	if (is_alpha_only) {
+		_mask.technique        = "MaskAlpha";
+		_mask.technique_direct = "MaskAlphaDirect";
+	} else if (is_uniform) {
+		_mask.technique        = "MaskUniform";
+		_mask.technique_direct = "MaskUniformDirect";
+	} else {
+		_mask.technique        = "Mask";
+		_mask.technique_direct = "MaskDirect";
+	}
 }
 
 void dynamic_mask_instance::save(obs_data_t* settings)
@@ -163,26 +189,19 @@ void dynamic_mask_instance::save(obs_data_t* settings)
 	}
 
 	for (auto kv1 : channel_translations) {
-		auto found = _channels.find(kv1.first);
-		if (found == _channels.end()) {
-			_channels.insert({kv1.first, channel_data()});
-			found = _channels.find(kv1.first);
-			if (found == _channels.end()) {
-				assert(found != _channels.end());
-				throw std::runtime_error("Unable to insert element into data _store.");
-			}
-		}
-
 		std::string chv_key = std::string(ST_KEY_CHANNEL_VALUE) + "." + kv1.second;
-		obs_data_set_double(settings, chv_key.c_str(), static_cast<double_t>(found->second.value));
+		obs_data_set_double(settings, chv_key.c_str(),
+							static_cast<double_t>(_precalc.base.ptr[static_cast<size_t>(kv1.first)]));
 
 		std::string chm_key = std::string(ST_KEY_CHANNEL_MULTIPLIER) + "." + kv1.second;
-		obs_data_set_double(settings, chm_key.c_str(), static_cast<double_t>(found->second.scale));
+		obs_data_set_double(settings, chm_key.c_str(),
+							static_cast<double_t>(_precalc.scale.ptr[static_cast<size_t>(kv1.first)]));
 
+		vec4* ch = channel_row(_precalc.matrix, kv1.first);
 		for (auto kv2 : channel_translations) {
 			std::string ab_key = std::string(ST_KEY_CHANNEL_INPUT) + "." + kv1.second + "." + kv2.second;
 			obs_data_set_double(settings, ab_key.c_str(),
-								static_cast<double_t>(found->second.values.ptr[static_cast<size_t>(kv2.first)]));
+								static_cast<double_t>(ch->ptr[static_cast<size_t>(kv2.first)]));
 		}
 	}
 }
@@ -194,11 +213,42 @@ void dynamic_mask_instance::input_renamed(obs::deprecated_source*, std::string o
 	obs_source_update(_self, settings);
 }
 
+void dynamic_mask_instance::prepare_state()
+{
+	gs_blend_state_push();
+	gs_reset_blend_state();
+	gs_enable_blending(false);
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+
+	gs_set_cull_mode(GS_NEITHER);
+	gs_enable_color(true, true, true, true);
+
+	gs_enable_depth_test(false);
+	gs_depth_function(GS_ALWAYS);
+
+	gs_enable_stencil_test(false);
+	gs_enable_stencil_write(false);
+	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
+	gs_stencil_op(GS_STENCIL_BOTH, GS_KEEP, GS_KEEP, GS_KEEP);
+}
+
+void dynamic_mask_instance::idle()
+{
+	_graph.reset();
+	_final_texture.reset();
+	_input_texture.reset();
+	_have_final_texture = false;
+	_have_input_texture = false;
+}
+
 void dynamic_mask_instance::video_tick(float)
 {
-	_have_input_texture  = false;
-	_have_filter_texture = false;
-	_have_final_texture  = false;
+	_have_input_texture = false;
+	_have_final_texture = false;
+
+	// Same as Color Grade, the caches are only skipped if nothing else needed them in the last frame.
+	_direct_input = (_renders <= 1);
+	_renders      = 0;
 }
 
 void dynamic_mask_instance::video_render(gs_effect_t* in_effect)
@@ -224,93 +274,81 @@ void dynamic_mask_instance::video_render(gs_effect_t* in_effect)
 	gs_effect_t* default_effect = obs_get_base_effect(obs_base_effect::OBS_EFFECT_DEFAULT);
 
 	try { // Capture filter and input
-		if (!_have_filter_texture) {
-#ifdef ENABLE_PROFILING
-			streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_cache, "Cache"};
-#endif
-
-			if (obs_source_process_filter_begin(_self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
-				auto op = _filter_rt->render(width, height);
-
-				gs_blend_state_push();
-				gs_reset_blend_state();
-				gs_enable_blending(false);
-				gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
-
-				gs_set_cull_mode(GS_NEITHER);
-				gs_enable_color(true, true, true, true);
-
-				gs_enable_depth_test(false);
-				gs_depth_function(GS_ALWAYS);
-
-				gs_enable_stencil_test(false);
-				gs_enable_stencil_write(false);
-				gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
-				gs_stencil_op(GS_STENCIL_BOTH, GS_KEEP, GS_KEEP, GS_KEEP);
-				gs_ortho(0, static_cast<float>(width), 0, static_cast<float>(height), -1., 1.);
-
-				obs_source_process_filter_end(_self, default_effect, width, height);
-
-				gs_blend_state_pop();
-			} else {
-				throw std::runtime_error("Failed to render filter.");
-			}
-
-			_filter_texture      = _filter_rt->get_texture();
-			_have_filter_texture = true;
-		}
-
 		if (!_have_input_texture) {
 #ifdef ENABLE_PROFILING
 			streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_capture, "Capture '%s'",
 												obs_source_get_name(_input_capture->get_object())};
 #endif
 
-			_input_texture      = _input_capture->render(_input->width(), _input->height());
+			// A smaller capture is stretched back up by the linear sampler of channel-mask.effect.
+			uint32_t input_width  = std::max<uint32_t>(static_cast<uint32_t>(_input->width() * _input_scale), 1);
+			uint32_t input_height = std::max<uint32_t>(static_cast<uint32_t>(_input->height() * _input_scale), 1);
+			_input_texture        = _input_capture->render(input_width, input_height);
 			_have_input_texture = true;
 		}
 
-		// Draw source
-		if (!_have_final_texture) {
+		// Mask the filter above while it is rendered, so neither it nor the result have to be cached. Any
+		// filter after this one then samples the masked result straight from its own capture.
+		_renders++;
+		if (_direct_input && (_renders == 1)) {
+			if (!_input_texture || !_input_texture->get_object()) {
+				throw std::runtime_error("Failed to capture input.");
+			}
+
 #ifdef ENABLE_PROFILING
 			streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_convert, "Masking"};
 #endif
+			_effect.get_parameter("pMaskInputB").set_texture(_input_texture);
+			_effect.get_parameter("pMaskMatrix").set_matrix(_mask.matrix);
+			_effect.get_parameter("pMaskBias").set_float4(_mask.bias);
+			_effect.get_parameter("pMaskVector").set_float4(_mask.vector);
+			streamfx::obs::tools::filter_direct_render(_self, _effect.get_object(), _mask.technique_direct, width,
+													   height);
+			return;
+		}
 
-			{
-				auto op = _final_rt->render(width, height);
-
-				gs_blend_state_push();
-				gs_reset_blend_state();
-				gs_enable_blending(false);
-				gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
-
-				gs_set_cull_mode(GS_NEITHER);
-				gs_enable_color(true, true, true, true);
-
-				gs_enable_depth_test(false);
-				gs_depth_function(GS_ALWAYS);
+		// Only the masked result has to outlive this frame, the capture of the filter above goes back to the pool
+		// as soon as it was masked.
+		if (!_have_final_texture) {
+			_graph.reset();
+			auto filter = _graph.create(width, height);
+			auto input  = _graph.import(_input_texture);
+			auto result = _graph.create(width, height);
+			_graph.keep(result);
+
+			auto cache = [this, default_effect](streamfx::obs::gs::rendertarget& rt, uint32_t width, uint32_t height) {
+				if (!obs_source_process_filter_begin(_self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
+					throw std::runtime_error("Failed to render filter.");
+				}
 
-				gs_enable_stencil_test(false);
-				gs_enable_stencil_write(false);
-				gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
-				gs_stencil_op(GS_STENCIL_BOTH, GS_KEEP, GS_KEEP, GS_KEEP);
+				auto op = rt.render(width, height);
+				prepare_state();
+				gs_ortho(0, static_cast<float>(width), 0, static_cast<float>(height), -1., 1.);
+				obs_source_process_filter_end(_self, default_effect, width, height);
+				gs_blend_state_pop();
+			};
+			auto mask = [this, filter, input](streamfx::obs::gs::rendertarget& rt, uint32_t width, uint32_t height) {
+				auto op = rt.render(width, height);
+				prepare_state();
 				gs_ortho(0, 1, 0, 1, -1., 1.);
 
-				_effect.get_parameter("pMaskInputA").set_texture(_filter_texture);
-				_effect.get_parameter("pMaskInputB").set_texture(_input_texture);
+				_effect.get_parameter("pMaskInputA").set_texture(_graph.get_texture(filter));
+				_effect.get_parameter("pMaskInputB").set_texture(_graph.get_texture(input));
 
-				_effect.get_parameter("pMaskBase").set_float4(_precalc.base);
-				_effect.get_parameter("pMaskMatrix").set_matrix(_precalc.matrix);
-				_effect.get_parameter("pMaskMultiplier").set_float4(_precalc.scale);
+				_effect.get_parameter("pMaskMatrix").set_matrix(_mask.matrix);
+				_effect.get_parameter("pMaskBias").set_float4(_mask.bias);
+				_effect.get_parameter("pMaskVector").set_float4(_mask.vector);
 
-				while (gs_effect_loop(_effect.get(), "Mask")) {
+				while (gs_effect_loop(_effect.get(), _mask.technique)) {
 					streamfx::gs_draw_fullscreen_tri();
 				}
-
 				gs_blend_state_pop();
-			}
+			};
+			_graph.add_pass("Cache", {}, filter, cache);
+			_graph.add_pass("Masking", {filter, input}, result, mask);
+			_graph.execute();
 
-			_final_texture      = _final_rt->get_texture();
+			_final_texture      = _graph.get_texture(result);
 			_have_final_texture = true;
 		}
 	} catch (...) {
@@ -318,11 +356,11 @@ void dynamic_mask_instance::video_render(gs_effect_t* in_effect)
 		return;
 	}
 
-	if (!_have_filter_texture || !_have_input_texture || !_have_final_texture) {
+	if (!_have_input_texture || !_have_final_texture) {
 		obs_source_skip_video_filter(_self);
 		return;
 	}
-	if (!_filter_texture->get_object() || !_input_texture->get_object() || !_final_texture->get_object()) {
+	if (!_input_texture->get_object() || !_final_texture || !_final_texture->get_object()) {
 		obs_source_skip_video_filter(_self);
 		return;
 	}
@@ -420,6 +458,7 @@ const char* dynamic_mask_factory::get_name()
 
 void dynamic_mask_factory::get_defaults2(obs_data_t* data)
 {
+	obs_data_set_default_double(data, ST_KEY_INPUT_SCALE, 100.0);
 	obs_data_set_default_int(data, ST_KEY_CHANNEL, static_cast<int64_t>(channel::Red));
 	for (auto kv : channel_translations) {
 		obs_data_set_default_double(data, (std::string(ST_KEY_CHANNEL_VALUE) + "." + kv.second).c_str(), 1.0);
@@ -465,6 +504,10 @@ obs_properties_t* dynamic_mask_factory::get_properties2(dynamic_mask_instance* d
 				return false;
 			},
 			obs::source_tracker::filter_scenes);
+
+		p = obs_properties_add_float_slider(props, ST_KEY_INPUT_SCALE, D_TRANSLATE(ST_I18N_INPUT_SCALE), 12.5, 100.0,
+											0.1);
+		obs_property_float_set_suffix(p, " %");
 	}
 
 	const char* pri_chs[] = {S_CHANNEL_RED, S_CHANNEL_GREEN, S_CHANNEL_BLUE, S_CHANNEL_ALPHA};
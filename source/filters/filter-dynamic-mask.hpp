@@ -20,9 +20,9 @@
 #pragma once
 #include "common.hpp"
 #include <list>
-#include <map>
 #include "gfx/gfx-source-texture.hpp"
 #include "obs/gs/gs-effect.hpp"
+#include "obs/gs/gs-rendergraph.hpp"
 #include "obs/obs-source-factory.hpp"
 #include "obs/obs-source-tracker.hpp"
 #include "obs/obs-source.hpp"
@@ -32,31 +32,22 @@ namespace streamfx::filter::dynamic_mask {
 	enum class channel : int8_t { Invalid = -1, Red, Green, Blue, Alpha };
 
 	class dynamic_mask_instance : public obs::source_instance {
-		std::map<std::tuple<channel, channel, std::string>, std::string> _translation_map;
-
 		streamfx::obs::gs::effect _effect;
 
-		bool                                             _have_filter_texture;
-		std::shared_ptr<streamfx::obs::gs::rendertarget> _filter_rt;
-		std::shared_ptr<streamfx::obs::gs::texture>      _filter_texture;
-
 		bool                                           _have_input_texture;
 		std::shared_ptr<obs::deprecated_source>        _input;
 		std::shared_ptr<streamfx::gfx::source_texture> _input_capture;
 		std::shared_ptr<streamfx::obs::gs::texture>    _input_texture;
 		std::shared_ptr<obs::tools::visible_source>    _input_vs;
 		std::shared_ptr<obs::tools::active_source>     _input_ac;
+		float_t                                        _input_scale; // Of the capture, relative to the input.
 
-		bool                                             _have_final_texture;
-		std::shared_ptr<streamfx::obs::gs::rendertarget> _final_rt;
-		std::shared_ptr<streamfx::obs::gs::texture>      _final_texture;
+		bool                                        _have_final_texture;
+		streamfx::obs::gs::rendergraph              _graph;
+		std::shared_ptr<streamfx::obs::gs::texture> _final_texture;
 
-		struct channel_data {
-			float_t value  = 0.0;
-			float_t scale  = 1.0;
-			vec4    values = {0, 0, 0, 0};
-		};
-		std::map<channel, channel_data> _channels;
+		bool     _direct_input;
+		uint32_t _renders;
 
 		struct _precalc {
 			vec4    base;
@@ -64,6 +55,15 @@ namespace streamfx::filter::dynamic_mask {
 			matrix4 matrix;
 		} _precalc;
 
+		// The settings above folded into "mask = matrix * input + bias", see channel-mask.effect.
+		struct _mask {
+			matrix4     matrix;
+			vec4        bias;
+			vec4        vector; // Used instead of the matrix if only one output is needed.
+			const char* technique;
+			const char* technique_direct; // Same as technique, but masking the "image" parameter instead.
+		} _mask;
+
 		public:
 		dynamic_mask_instance(obs_data_t* data, obs_source_t* self);
 		virtual ~dynamic_mask_instance();
@@ -75,7 +75,10 @@ namespace streamfx::filter::dynamic_mask {
 
 		void input_renamed(obs::deprecated_source* src, std::string old_name, std::string new_name);
 
+		void prepare_state();
+
 		virtual void video_tick(float_t _time) override;
+		virtual void idle() override;
 		virtual void video_render(gs_effect_t* effect) override;
 
 		void enum_active_sources(obs_source_enum_proc_t enum_callback, void* param) override;
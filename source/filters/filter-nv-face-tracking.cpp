@@ -20,10 +20,12 @@
 #include "filter-nv-face-tracking.hpp"
 #include <algorithm>
 #include <filesystem>
+#include <limits>
 #include <util/platform.h>
 #include "nvidia/cuda/nvidia-cuda-context.hpp"
 #include "obs/gs/gs-helper.hpp"
 #include "obs/obs-tools.hpp"
+#include "strings.hpp"
 
 #define ST_I18N "Filter.NVIDIA.FaceTracking"
 #define ST_I18N_ROI ST_I18N ".ROI"
@@ -32,33 +34,56 @@
 #define ST_I18N_ROI_OFFSET_X ST_I18N_ROI_OFFSET ".X"
 #define ST_I18N_ROI_OFFSET_Y ST_I18N_ROI_OFFSET ".Y"
 #define ST_I18N_ROI_STABILITY ST_I18N_ROI ".Stability"
+#define ST_I18N_TRACKING ST_I18N ".Tracking"
+#define ST_I18N_TRACKING_FREQUENCY ST_I18N_TRACKING ".Frequency"
+#define ST_I18N_TRACKING_RESOLUTION ST_I18N_TRACKING ".Resolution"
+#define ST_I18N_TRACKING_REFINE ST_I18N_TRACKING ".Refine"
+#define ST_I18N_TRACKING_LANDMARKS ST_I18N_TRACKING ".Landmarks"
+#define ST_I18N_TRACKING_BODYPOSE ST_I18N_TRACKING ".BodyPose"
+#define ST_I18N_TRACKING_FACES ST_I18N_TRACKING ".Faces"
+#define ST_I18N_ROI_APPLY ST_I18N_ROI ".Apply"
+#define ST_I18N_STATE_INITIALIZING ST_I18N ".State.Initializing"
+#define ST_I18N_STATE_UNAVAILABLE ST_I18N ".State.Unavailable"
 
 #define ST_KEY_ROI_ZOOM "ROI.Zoom"
 #define ST_KEY_ROI_OFFSET_X "ROI.Offset.X"
 #define ST_KEY_ROI_OFFSET_Y "ROI.Offset.Y"
 #define ST_KEY_ROI_STABILITY "ROI.Stability"
+#define ST_KEY_TRACKING_FREQUENCY "Tracking.Frequency"
+#define ST_KEY_TRACKING_RESOLUTION "Tracking.Resolution"
+#define ST_KEY_TRACKING_REFINE "Tracking.Refine"
+#define ST_KEY_TRACKING_LANDMARKS "Tracking.Landmarks"
+#define ST_KEY_TRACKING_BODYPOSE "Tracking.BodyPose"
+#define ST_KEY_TRACKING_FACES "Tracking.Faces"
+#define ST_KEY_ROI_APPLY "ROI.Apply"
+#define ST_KEY_STATE "State"
+
+// Most faces one instance follows, and how long a lost face keeps its index before another face may take it.
+#define ST_MAX_FACES 8
+#define ST_TRACK_HOLD 1000000000ull
 
 using namespace streamfx::filter::nvidia;
 
-void ar_feature_deleter(NvAR_FeatureHandle v)
-{
-	face_tracking_factory::get()->get_ar()->destroy(v);
-}
-
 face_tracking_instance::face_tracking_instance(obs_data_t* settings, obs_source_t* self)
-	: obs::source_instance(settings, self),
+	: obs::source_instance(settings, self), obs::degradable(2, 2),
 
 	  _rt_is_fresh(false), _rt(),
 
-	  _cfg_zoom(1.0), _cfg_offset({0., 0.}), _cfg_stability(1.0),
+	  _cfg_zoom(1.0), _cfg_offset({0., 0.}), _cfg_stability(1.0), _cfg_frequency(30.0),
+	  _cfg_resolution(0), _cfg_refine(0), _cfg_landmarks(false), _cfg_body_pose(false), _cfg_faces(1),
+	  _cfg_apply(true),
 
-	  _geometry(), _filters(), _values(),
+	  _geometry(), _filters(), _values(), _track_timer(0.),
 
-	  _cuda(::streamfx::nvidia::cuda::obs::get()), _cuda_stream(),
+	  _cuda(), _cuda_capture_stream(),
 
-	  _ar_library(face_tracking_factory::get()->get_ar()), _ar_loaded(false), _ar_feature(), _ar_is_tracking(false),
-	  _ar_bboxes_confidence(), _ar_bboxes_data(), _ar_bboxes(), _ar_texture(), _ar_texture_cuda_fresh(false),
-	  _ar_texture_cuda(), _ar_texture_cuda_mem(), _ar_image(), _ar_image_bgr(), _ar_image_temp()
+	  _ar_library(), _ar_runtime(),
+	  _ar_is_tracking(false), _ar_redetect(false), _ar_refined(0),
+	  _ar_bboxes_confidence(), _ar_bboxes_data(), _ar_bboxes(), _ar_landmarks(),
+	  _ar_landmarks_confidence(), _ar_body(), _ar_body_3d(), _ar_body_angles(), _ar_body_confidence(),
+	  _ar_body_bboxes_data(), _ar_body_bboxes(), _ar_image_bgr(), _ar_image_temp(), _ar_tracks(),
+	  _tracking_channel(::streamfx::util::tracking::channel::instance()), _tracking(), _ar_scale_rt(),
+	  _ar_slots_lock(), _ar_slots()
 {
 #ifdef ENABLE_PROFILING
 	// Profiling
@@ -67,70 +92,267 @@ face_tracking_instance::face_tracking_instance(obs_data_t* settings, obs_source_
 	_profile_capture_copy    = streamfx::util::profiler::create();
 	_profile_ar_realloc      = streamfx::util::profiler::create();
 	_profile_ar_copy         = streamfx::util::profiler::create();
+	_profile_ar_wait         = streamfx::util::profiler::create();
 	_profile_ar_transfer     = streamfx::util::profiler::create();
 	_profile_ar_run          = streamfx::util::profiler::create();
 	_profile_ar_calc         = streamfx::util::profiler::create();
+	_profile_ar_latency      = streamfx::util::profiler::create();
 #endif
 
-	{ // Create render target, vertex buffer, and CUDA stream.
-		auto gctx = streamfx::obs::gs::context{};
-		_rt       = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA_UNORM, GS_ZS_NONE);
-		_geometry = std::make_shared<streamfx::obs::gs::vertex_buffer>(uint32_t(4), uint8_t(1));
-		auto cctx = _cuda->get_context()->enter();
-		_cuda_stream =
-			std::make_shared<::streamfx::nvidia::cuda::stream>(::streamfx::nvidia::cuda::stream_flags::NON_BLOCKING, 0);
+	{ // Create render target and vertex buffer.
+		auto gctx    = streamfx::obs::gs::context{};
+		_rt          = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA_UNORM, GS_ZS_NONE);
+		_ar_scale_rt = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA_UNORM, GS_ZS_NONE);
+		_geometry    = std::make_shared<streamfx::obs::gs::vertex_buffer>(uint32_t(4), uint8_t(1));
+	}
+
+	{ // Create Bounding Boxes Data, which is bound to the shared feature for every detection.
+		// Room for the most faces up front, as the buffers may be in use by the tracking thread when settings change.
+		_ar_bboxes_data.assign(ST_MAX_FACES, {0., 0., 0., 0.});
+		_ar_bboxes.boxes     = _ar_bboxes_data.data();
+		_ar_bboxes.max_boxes = std::clamp<uint8_t>(static_cast<uint8_t>(_ar_bboxes_data.size()), 0, 255);
+		_ar_bboxes.num_boxes = 0;
+		_ar_bboxes_confidence.resize(_ar_bboxes_data.size());
 	}
 
-	{ // Asynchronously load Face Tracking.
-		async_initialize();
+	{ // Body pose comes with its own bounding box, which has to be bound even if only the key points are used.
+		_ar_body_bboxes_data.assign(1, {0., 0., 0., 0.});
+		_ar_body_bboxes.boxes     = _ar_body_bboxes_data.data();
+		_ar_body_bboxes.max_boxes = static_cast<uint8_t>(_ar_body_bboxes_data.size());
+		_ar_body_bboxes.num_boxes = 0;
 	}
 
 	{ // Set up initial tracking data.
 		_values.center[0] = _values.center[1] = .5;
 		_values.size[0] = _values.size[1] = 1.;
+		_values.detected[0] = _values.detected[1] = .5;
 		refresh_region_of_interest();
 	}
+
+	// Filters stay transparent until the SDKs are ready, see acquire_runtime().
+	face_tracking_factory::get()->request_sdk();
+
+	enable_idle_tracking();
+	enable_preview_profile();
+	enable_prewarm();
 }
 
 face_tracking_instance::~face_tracking_instance()
 {
 	// Kill pending tasks.
-	streamfx::threadpool()->pop(_async_initialize);
-	streamfx::threadpool()->pop(_async_track);
+	std::shared_ptr<::streamfx::util::threadpool::task> task;
+	{
+		std::unique_lock<std::mutex> slk{_ar_slots_lock};
+		task = _async_track;
+	}
+	streamfx::threadpool()->pop(task);
 
-	_ar_loaded.store(false);
 	std::unique_lock<std::mutex> alk{_ar_lock};
-	_ar_library->image_dealloc(&_ar_image_temp);
-	_ar_library->image_dealloc(&_ar_image_bgr);
+	if (_cuda) {
+		auto gctx = streamfx::obs::gs::context();
+		auto cctx = _cuda->get_context()->enter();
+		for (auto& slot : _ar_slots) {
+			if (slot.texture_cuda) {
+				slot.texture_cuda->unmap();
+			}
+		}
+	}
+	if (_ar_library) {
+		_ar_library->image_dealloc(&_ar_image_temp);
+		_ar_library->image_dealloc(&_ar_image_bgr);
+	}
 }
 
-void face_tracking_instance::async_initialize(std::shared_ptr<void> ptr)
+void face_tracking_instance::async_track(std::shared_ptr<void> ptr)
 {
 	struct async_data {
 		std::shared_ptr<obs_weak_source_t> source;
-		std::string                        models_path;
 	};
 
+	if (!_ar_runtime || !_ar_runtime->get(ar_feature_type::FaceDetection).loaded)
+		return;
+
 	if (!ptr) {
-		// Spawn the work for the threadpool.
-		std::shared_ptr<async_data> data = std::make_shared<async_data>();
-		data->source =
-			std::shared_ptr<obs_weak_source_t>(obs_source_get_weak_source(_self), obs::obs_weak_source_deleter);
+		// Pick a slot that the tracking thread isn't reading from, preferring one that still holds an untracked frame.
+		capture_slot* slot = nullptr;
+		{
+			std::unique_lock<std::mutex> slk{_ar_slots_lock};
+			for (auto& candidate : _ar_slots) {
+				if ((candidate.state == capture_state::Pending)
+					|| ((candidate.state == capture_state::Free) && !slot)) {
+					slot = &candidate;
+				}
+			}
+			if (!slot)
+				return; // Both frames are still in use.
+			slot->state = capture_state::Capturing;
+		}
+
+#ifdef ENABLE_PROFILING
+		streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_convert, "Start Asynchronous Tracking"};
+#endif
+
+		try {
+			// Update the current CUDA context for working.
+			auto cctx = _cuda->get_context()->enter();
+
+			// The detector works at a far lower resolution internally, so only copy what it can use.
+			uint32_t width  = _size.first;
+			uint32_t height = _size.second;
+			if ((_cfg_resolution > 0) && (height > _cfg_resolution)) {
+				uint64_t scaled = static_cast<uint64_t>(width) * _cfg_resolution / height;
+				width           = std::max<uint32_t>(static_cast<uint32_t>(scaled), 1);
+				height          = _cfg_resolution;
+			}
+
+			// In between full frame detections, only the area around the face is captured, but at full resolution.
+			// Body pose and following several faces need the entire frame, so they always detect on the full frame.
+			NvAR_Rect region{0., 0., static_cast<float_t>(_size.first), static_cast<float_t>(_size.second)};
+			bool      refine = false;
+			if ((_cfg_refine > 0) && !_cfg_body_pose && (_cfg_faces == 1) && !_ar_redetect
+				&& (_ar_refined < _cfg_refine)) {
+				std::unique_lock<std::mutex> tlk{_values.lock};
+				if ((_values.face[2] > 0.) && (_values.face[3] > 0.)) {
+					// Follow the predicted movement, and leave the face as much room again to move into.
+					double_t cx = _values.face[0] + _values.face[2] / 2. + (_values.center[0] - _values.detected[0]);
+					double_t cy = _values.face[1] + _values.face[3] / 2. + (_values.center[1] - _values.detected[1]);
+
+					// Round up to 64 pixels, so that the buffers don't have to be reallocated for every frame.
+					uint32_t rw = static_cast<uint32_t>(_values.face[2] * 2. * _size.first);
+					uint32_t rh = static_cast<uint32_t>(_values.face[3] * 2. * _size.second);
+					rw          = std::min(std::max<uint32_t>((rw + 63) & ~63u, 128), _size.first);
+					rh          = std::min(std::max<uint32_t>((rh + 63) & ~63u, 128), _size.second);
+					if ((rw < _size.first) || (rh < _size.second)) {
+						double_t rx   = std::clamp(cx * _size.first - rw / 2., 0., double_t(_size.first - rw));
+						double_t ry   = std::clamp(cy * _size.second - rh / 2., 0., double_t(_size.second - rh));
+						region.x      = std::floor(static_cast<float_t>(rx));
+						region.y      = std::floor(static_cast<float_t>(ry));
+						region.width  = static_cast<float_t>(rw);
+						region.height = static_cast<float_t>(rh);
+						width         = rw;
+						height        = rh;
+						refine        = true;
+					}
+				}
+			}
+			if (refine) {
+				_ar_refined++;
+			} else {
+				_ar_refined  = 0;
+				_ar_redetect = false;
+			}
+
+			// Check if things exist as planned.
+			if (!slot->texture || (slot->texture->get_width() != width) || (slot->texture->get_height() != height)) {
+#ifdef ENABLE_PROFILING
+				auto                            prof = _profile_capture_realloc->track();
+				streamfx::obs::gs::debug_marker marker{streamfx::obs::gs::debug_color_allocate,
+													   "Reallocate GPU Buffer"};
+#endif
+				if (slot->texture_cuda) {
+					slot->texture_cuda->unmap();
+				}
+				slot->texture_cuda.reset();
+				slot->texture      = std::make_shared<streamfx::obs::gs::texture>(
+                    width, height, GS_RGBA_UNORM, uint32_t(1), nullptr, streamfx::obs::gs::texture::flags::None);
+				slot->texture_cuda = ::streamfx::nvidia::cuda::gstexture_cache::instance()->get(slot->texture);
+				if (!slot->ready) {
+					slot->ready = std::make_shared<::streamfx::nvidia::cuda::event>();
+				}
+			} else {
+				// The previous frame was tracked already, and the texture can't be written to while it is mapped.
+				slot->texture_cuda->unmap();
+			}
+
+			{ // Copy texture
+#ifdef ENABLE_PROFILING
+				auto                            prof = _profile_capture_copy->track();
+				streamfx::obs::gs::debug_marker marker{streamfx::obs::gs::debug_color_copy, "Copy Capture",
+													   obs_source_get_name(_self)};
+#endif
+				if (refine) {
+					gs_copy_texture_region(slot->texture->get_object(), 0, 0, _rt->get_texture()->get_object(),
+										   static_cast<uint32_t>(region.x), static_cast<uint32_t>(region.y), width,
+										   height);
+				} else if ((width != _size.first) || (height != _size.second)) {
+					gs_effect_t* default_effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+					{
+						auto op  = _ar_scale_rt->render(width, height);
+						vec4 clr = {0., 0., 0., 0.};
+
+						gs_ortho(0., 1., 0., 1., -1., 1.);
+						gs_clear(GS_CLEAR_COLOR, &clr, 0., 0);
+						gs_blend_state_push();
+						gs_reset_blend_state();
+						gs_enable_blending(false);
+						gs_enable_color(true, true, true, true);
+						auto old_fbsrgb = gs_framebuffer_srgb_enabled();
+						gs_enable_framebuffer_srgb(false);
+						gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"),
+											  _rt->get_texture()->get_object());
+						while (gs_effect_loop(default_effect, "Draw")) {
+							gs_draw_sprite(nullptr, 0, 1, 1);
+						}
+						gs_enable_framebuffer_srgb(old_fbsrgb);
+						gs_blend_state_pop();
+					}
+					gs_copy_texture(slot->texture->get_object(), _ar_scale_rt->get_texture()->get_object());
+				} else {
+					gs_copy_texture(slot->texture->get_object(), _rt->get_texture()->get_object());
+				}
+				slot->timestamp = obs_get_video_frame_time();
+				slot->region    = region;
+				slot->frame     = _size;
+			}
+
+			{ // Map the texture for tracking, which then converts straight from the CUDA array.
+#ifdef ENABLE_PROFILING
+				auto prof = _profile_ar_copy->track();
+#endif
+				auto array = slot->texture_cuda->map(_cuda_capture_stream);
+				if (auto res = _ar_library->image_init(&slot->image, static_cast<unsigned int>(width),
+													   static_cast<unsigned int>(height),
+													   static_cast<int>(width * 4ul), reinterpret_cast<void*>(array),
+													   NVCV_RGBA, NVCV_U8, NVCV_INTERLEAVED, NVCV_CUDA_ARRAY);
+					res != NVCV_SUCCESS) {
+					slot->texture_cuda->unmap();
+					throw std::runtime_error("Failed to prepare buffers for tracking.");
+				}
+				slot->ready->record(_cuda_capture_stream);
+			}
+		} catch (const std::exception& ex) {
+			DLOG_ERROR("<%s> %s", obs_source_get_name(_self), ex.what());
+			std::unique_lock<std::mutex> slk{_ar_slots_lock};
+			slot->state = capture_state::Free;
+			return;
+		}
 
 		{
-			std::filesystem::path models_path = _ar_library->get_ar_sdk_path();
-			models_path                       = models_path.append("models");
-			models_path                       = std::filesystem::absolute(models_path);
-			models_path.concat("\\");
-			data->models_path = models_path.string();
+			std::unique_lock<std::mutex> slk{_ar_slots_lock};
+			slot->state = capture_state::Pending;
 		}
 
-		_async_initialize = streamfx::threadpool()->push(
-			std::bind(&face_tracking_instance::async_initialize, this, std::placeholders::_1), data);
+		// Wake up the tracking thread, unless it is already running and will pick up the frame by itself.
+		if (!_ar_is_tracking.exchange(true)) {
+			std::shared_ptr<async_data> data = std::make_shared<async_data>();
+			data->source =
+				std::shared_ptr<obs_weak_source_t>(obs_source_get_weak_source(_self), obs::obs_weak_source_deleter);
+			auto task = streamfx::threadpool()->push(
+				std::bind(&face_tracking_instance::async_track, this, std::placeholders::_1), data,
+				streamfx::util::threadpool::priority::High);
+
+			// The worker clears this too, so it is only ever touched with the slots locked.
+			std::unique_lock<std::mutex> slk{_ar_slots_lock};
+			_async_track = task;
+		}
 	} else {
-		std::shared_ptr<async_data> data = std::static_pointer_cast<async_data>(ptr);
+		// Prevent conflicts.
+		std::unique_lock<std::mutex> alk{_ar_lock};
+		if (!_ar_runtime || !_ar_runtime->get(ar_feature_type::FaceDetection).loaded)
+			return;
 
 		// Try and acquire a strong source reference.
+		std::shared_ptr<async_data>   data = std::static_pointer_cast<async_data>(ptr);
 		std::shared_ptr<obs_source_t> remote_work =
 			std::shared_ptr<obs_source_t>(obs_weak_source_get_source(data->source.get()), obs::obs_source_deleter);
 		if (!remote_work) { // If that failed, the source we are working for was deleted - abort now.
@@ -138,309 +360,489 @@ void face_tracking_instance::async_initialize(std::shared_ptr<void> ptr)
 		}
 
 		// Update the current CUDA context for working.
-		streamfx::obs::gs::context gctx;
-		auto                       cctx = _cuda->get_context()->enter();
+		auto cctx = _cuda->get_context()->enter();
 
-		// Create Face Detection feature.
-		{
-			NvAR_FeatureHandle fd_inst;
-			if (NvCV_Status res = _ar_library->create(NvAR_Feature_FaceDetection, &fd_inst); res != NVCV_SUCCESS) {
-				throw std::runtime_error("Failed to create Face Detection feature.");
+		// Keep tracking frames for as long as the render thread captures new ones.
+		while (true) {
+			capture_slot* slot = nullptr;
+			{
+				std::unique_lock<std::mutex> slk{_ar_slots_lock};
+				for (auto& candidate : _ar_slots) {
+					if (candidate.state == capture_state::Pending) {
+						slot = &candidate;
+						break;
+					}
+				}
+				if (!slot) {
+					// Allow new work to be queued again.
+					_ar_is_tracking = false;
+					_async_track.reset();
+					break;
+				}
+				slot->state = capture_state::Processing;
+			}
+
+			track(*slot);
+
+			{
+				std::unique_lock<std::mutex> slk{_ar_slots_lock};
+				slot->state = capture_state::Free;
 			}
-			_ar_feature = std::shared_ptr<nvAR_Feature>{fd_inst, ar_feature_deleter};
 		}
+	}
+}
 
-		// Set the correct CUDA stream for processing.
-		if (NvCV_Status res = _ar_library->set_cuda_stream(_ar_feature.get(), NvAR_Parameter_Config(CUDAStream),
-														   reinterpret_cast<CUstream>(_cuda_stream->get()));
+void face_tracking_instance::track(capture_slot& slot)
+{
+	// Refresh any now broken buffers.
+	if ((_ar_image_bgr.width != slot.image.width) || (_ar_image_bgr.height != slot.image.height)) {
+#ifdef ENABLE_PROFILING
+		auto prof = _profile_ar_realloc->track();
+#endif
+		// Reallocate transposed buffer.
+		_ar_library->image_dealloc(&_ar_image_temp);
+		_ar_library->image_dealloc(&_ar_image_bgr);
+		if (auto res = _ar_library->image_alloc(&_ar_image_bgr, slot.image.width, slot.image.height, NVCV_BGR, NVCV_U8,
+												NVCV_INTERLEAVED, NVCV_CUDA, 0);
 			res != NVCV_SUCCESS) {
-			throw std::runtime_error("Failed to set CUDA stream.");
+			DLOG_ERROR("<%s> Failed to allocate image for color conversion.", obs_source_get_name(_self));
+			return;
 		}
+	}
 
-		// Set the correct models path.
-		if (NvCV_Status res =
-				_ar_library->set_string(_ar_feature.get(), NvAR_Parameter_Config(ModelDir), data->models_path.c_str());
-			res != NVCV_SUCCESS) {
-			throw std::runtime_error("Unable to set model path.");
+	// Wait for the shared features, which only handle one frame at a time.
+#ifdef ENABLE_PROFILING
+	auto prof_wait = _profile_ar_wait->track();
+#endif
+	std::unique_lock<std::mutex> dlk{_ar_runtime->lock};
+#ifdef ENABLE_PROFILING
+	prof_wait.reset();
+#endif
+	auto feature = _ar_runtime->get(ar_feature_type::FaceDetection).feature;
+	auto stream  = _ar_runtime->stream;
+
+	{ // Convert from RGBA 32-bit to BGR 24-bit, once the capture has arrived.
+#ifdef ENABLE_PROFILING
+		auto prof = _profile_ar_transfer->track();
+#endif
+		if (::streamfx::nvidia::cuda::result res =
+				_cuda->get_cuda()->cuStreamWaitEvent(stream->get(), slot.ready->get(), 0);
+			res != ::streamfx::nvidia::cuda::result::SUCCESS) {
+			DLOG_ERROR("<%s> Failed to wait for the captured frame.", obs_source_get_name(_self));
+			return;
 		}
 
-		// Finally enable Temporal tracking if possible.
-		if (NvCV_Status res = _ar_library->set_uint32(_ar_feature.get(), NvAR_Parameter_Config(Temporal), 1);
+		if (NvCV_Status res = _ar_library->image_transfer(&slot.image, &_ar_image_bgr, 1.0,
+														  reinterpret_cast<CUstream_st*>(stream->get()),
+														  &_ar_image_temp);
 			res != NVCV_SUCCESS) {
-			DLOG_WARNING("<%s> Unable to enable Temporal tracking mode.", obs_source_get_name(remote_work.get()));
+			DLOG_ERROR("<%s> Failed to convert from RGBX 32-bit to BGR 24-bit.", obs_source_get_name(_self));
+			return;
 		}
+	}
 
-		// Create Bounding Boxes Data
-		_ar_bboxes_data.assign(1, {0., 0., 0., 0.});
-		_ar_bboxes.boxes     = _ar_bboxes_data.data();
-		_ar_bboxes.max_boxes = std::clamp<uint8_t>(static_cast<uint8_t>(_ar_bboxes_data.size()), 0, 255);
-		_ar_bboxes.num_boxes = 0;
-		_ar_bboxes_confidence.resize(_ar_bboxes_data.size());
-		if (NvCV_Status res = _ar_library->set_object(_ar_feature.get(), NvAR_Parameter_Output(BoundingBoxes),
-													  &_ar_bboxes, sizeof(NvAR_BBoxes));
+	{ // Track any faces.
+#ifdef ENABLE_PROFILING
+		auto prof = _profile_ar_run->track();
+#endif
+		// Bind our own input and outputs, as the previous detection may have been for another instance.
+		_ar_bboxes.max_boxes = static_cast<uint8_t>(std::clamp<uint32_t>(_cfg_faces, 1, ST_MAX_FACES));
+		if (NvCV_Status res = feature->set_object(NvAR_Parameter_Input(Image), &_ar_image_bgr, sizeof(NvCVImage));
 			res != NVCV_SUCCESS) {
-			throw std::runtime_error("Failed to set BoundingBoxes for Face Tracking feature.");
+			DLOG_ERROR("<%s> Failed to update input image for tracking.", obs_source_get_name(_self));
+			return;
 		}
-		if (NvCV_Status res = _ar_library->set_float32_array(
-				_ar_feature.get(), NvAR_Parameter_Output(BoundingBoxesConfidence), _ar_bboxes_confidence.data(),
-				static_cast<int>(_ar_bboxes_confidence.size()));
+		if (NvCV_Status res =
+				feature->set_object(NvAR_Parameter_Output(BoundingBoxes), &_ar_bboxes, sizeof(NvAR_BBoxes));
 			res != NVCV_SUCCESS) {
-			throw std::runtime_error("Failed to set BoundingBoxesConfidence for Face Tracking feature.");
+			DLOG_ERROR("<%s> Failed to set BoundingBoxes for Face Tracking feature.", obs_source_get_name(_self));
+			return;
 		}
-
-		// And finally, load the feature (takes long).
-		if (NvCV_Status res = _ar_library->load(_ar_feature.get()); res != NVCV_SUCCESS) {
-			DLOG_ERROR("<%s> Failed to load Face Tracking feature.", obs_source_get_name(_self));
-			_ar_loaded = false;
+		if (NvCV_Status res = feature->set_float32_array(NvAR_Parameter_Output(BoundingBoxesConfidence),
+														 _ar_bboxes_confidence.data(), _ar_bboxes_confidence.size());
+			res != NVCV_SUCCESS) {
+			DLOG_ERROR("<%s> Failed to set BoundingBoxesConfidence for Face Tracking feature.",
+					   obs_source_get_name(_self));
 			return;
-		} else {
-			_ar_loaded = true;
 		}
 
-		_async_initialize.reset();
+		// Runs on the same stream as the conversion, so it is ordered after it without any synchronization.
+		if (NvCV_Status res = feature->run(); res != NVCV_SUCCESS) {
+			DLOG_ERROR("<%s> Failed to run tracking.", obs_source_get_name(_self));
+			return;
+		}
 	}
-}
 
-void face_tracking_instance::async_track(std::shared_ptr<void> ptr)
-{
-	struct async_data {
-		std::shared_ptr<obs_weak_source_t> source;
-	};
+	prioritize_primary(slot);
 
-	if (!_ar_loaded)
-		return;
-
-	if (!ptr) {
-		// Check if we can track.
-		if (_ar_is_tracking)
-			return; // Can't track a new frame right now.
+	// Feed the same converted frame through any other enabled features, which share the stream.
+	bool has_landmarks = false;
+	if (auto& landmarks = _ar_runtime->get(ar_feature_type::Landmarks); _cfg_landmarks && landmarks.loaded) {
+		has_landmarks = track_landmarks(landmarks);
+	}
+	bool has_body = false;
+	if (auto& body_pose = _ar_runtime->get(ar_feature_type::BodyPose); _cfg_body_pose && body_pose.loaded) {
+		has_body = track_body_pose(body_pose);
+	}
+	dlk.unlock();
+
+	{ // Move all results into frame pixels, as the image may only cover a part of the frame and at another scale.
+		float_t scale_x = slot.region.width / static_cast<float_t>(_ar_image_bgr.width);
+		float_t scale_y = slot.region.height / static_cast<float_t>(_ar_image_bgr.height);
+		for (std::size_t idx = 0; idx < _ar_bboxes.num_boxes; idx++) {
+			NvAR_Rect& box = _ar_bboxes.boxes[idx];
+			box.x          = slot.region.x + box.x * scale_x;
+			box.y          = slot.region.y + box.y * scale_y;
+			box.width *= scale_x;
+			box.height *= scale_y;
+		}
+		if (has_landmarks) {
+			for (NvAR_Point2f& point : _ar_landmarks) {
+				point.x = slot.region.x + point.x * scale_x;
+				point.y = slot.region.y + point.y * scale_y;
+			}
+		}
+		if (has_body) {
+			for (NvAR_Point2f& point : _ar_body) {
+				point.x = slot.region.x + point.x * scale_x;
+				point.y = slot.region.y + point.y * scale_y;
+			}
+		}
+	}
 
-#ifdef ENABLE_PROFILING
-		streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_convert, "Start Asynchronous Tracking"};
-#endif
+	assign_tracks(slot);
 
-		// Don't push additional tracking frames while processing one.
-		_ar_is_tracking = true;
+	{ // Publish the results for other filters, normalized so that they don't depend on the tracking resolution.
+		obs_source_t* parent = obs_filter_get_parent(_self);
+		if (!_tracking || (_tracking->source() != parent)) {
+			_tracking = _tracking_channel->acquire(parent);
+		}
 
-		// Spawn the work for the threadpool.
-		std::shared_ptr<async_data> data = std::make_shared<async_data>();
-		data->source =
-			std::shared_ptr<obs_weak_source_t>(obs_source_get_weak_source(_self), obs::obs_weak_source_deleter);
+		float_t width  = static_cast<float_t>(slot.frame.first);
+		float_t height = static_cast<float_t>(slot.frame.second);
 
-		// Check if things exist as planned.
-		if (!_ar_texture || (_ar_texture->get_width() != _size.first) || (_ar_texture->get_height() != _size.second)) {
-#ifdef ENABLE_PROFILING
-			auto                            prof = _profile_capture_realloc->track();
-			streamfx::obs::gs::debug_marker marker{streamfx::obs::gs::debug_color_allocate, "Reallocate GPU Buffer"};
-#endif
-			_ar_texture =
-				std::make_shared<streamfx::obs::gs::texture>(_size.first, _size.second, GS_RGBA_UNORM, uint32_t(1),
-															 nullptr, streamfx::obs::gs::texture::flags::None);
-			_ar_texture_cuda_fresh = false;
+		auto data       = std::make_shared<::streamfx::util::tracking::frame>();
+		data->timestamp = slot.timestamp;
+		data->framed    = _cfg_apply;
+		for (std::size_t idx = 0; idx < _ar_bboxes.num_boxes; idx++) {
+			const NvAR_Rect& box = _ar_bboxes.boxes[idx];
+			data->faces.push_back({box.x / width, box.y / height, box.width / width, box.height / height});
+			data->faces_confidence.push_back(_ar_bboxes_confidence[idx]);
+		}
+		for (const face_track& face : _ar_tracks) {
+			data->tracks.push_back(
+				{face.box.x / width, face.box.y / height, face.box.width / width, face.box.height / height});
+		}
+		if (has_landmarks) {
+			for (const NvAR_Point2f& point : _ar_landmarks) {
+				data->landmarks.push_back({point.x / width, point.y / height});
+			}
+			data->landmarks_confidence = _ar_landmarks_confidence;
+		}
+		if (has_body) {
+			for (const NvAR_Point2f& point : _ar_body) {
+				data->body.push_back({point.x / width, point.y / height});
+			}
+			data->body_confidence = _ar_body_confidence;
 		}
 
-		{ // Copy texture
+		_tracking->publish(data);
+	}
+
 #ifdef ENABLE_PROFILING
-			auto                            prof = _profile_capture_copy->track();
-			streamfx::obs::gs::debug_marker marker{streamfx::obs::gs::debug_color_copy, "Copy Capture",
-												   obs_source_get_name(_self)};
+	// Time from capturing the frame to having its result.
+	_profile_ar_latency->track(std::chrono::nanoseconds(os_gettime_ns() - slot.timestamp));
 #endif
-			gs_copy_texture(_ar_texture->get_object(), _rt->get_texture()->get_object());
-		}
-
-		// Push work
-		_async_track = streamfx::threadpool()->push(
-			std::bind(&face_tracking_instance::async_track, this, std::placeholders::_1), data);
-	} else {
-		// Prevent conflicts.
-		std::unique_lock<std::mutex> alk{_ar_lock};
-		if (!_ar_loaded)
-			return;
 
-		// Try and acquire a strong source reference.
-		std::shared_ptr<async_data>   data = std::static_pointer_cast<async_data>(ptr);
-		std::shared_ptr<obs_source_t> remote_work =
-			std::shared_ptr<obs_source_t>(obs_weak_source_get_source(data->source.get()), obs::obs_source_deleter);
-		if (!remote_work) { // If that failed, the source we are working for was deleted - abort now.
+	// Are we following a face? The first track keeps its face across frames, unlike the order of the detections.
+	const NvAR_Rect& primary = _ar_tracks.at(0).box;
+	if ((primary.width <= 0.) || (primary.height <= 0.)) {
+		bool partial = (slot.region.width < static_cast<float_t>(slot.frame.first))
+					   || (slot.region.height < static_cast<float_t>(slot.frame.second));
+		if (partial) {
+			// The face may just have left the region, so look for it on the full frame before giving up.
+			_ar_redetect = true;
 			return;
 		}
 
-		// Acquire GS context.
-		streamfx::obs::gs::context gctx{};
-
-		// Update the current CUDA context for working.
-		auto cctx = _cuda->get_context()->enter();
-
-		// Refresh any now broken buffers.
-		if (!_ar_texture_cuda_fresh) {
+		// If not, just return to full frame.
+		std::unique_lock<std::mutex> tlk{_values.lock};
+		_values.center[0]   = .5;
+		_values.center[1]   = .5;
+		_values.size[0]     = 1.;
+		_values.size[1]     = 1.;
+		_values.velocity[0] = 0;
+		_values.velocity[1] = 0;
+		_values.detected[0] = .5;
+		_values.detected[1] = .5;
+		_values.face[2]     = 0.;
+		_values.face[3]     = 0.;
+		_values.timestamp   = slot.timestamp;
+	} else {
+		// If yes, begin tracking.
 #ifdef ENABLE_PROFILING
-			auto                            prof = _profile_ar_realloc->track();
-			streamfx::obs::gs::debug_marker marker{streamfx::obs::gs::debug_color_allocate,
-												   "%s: Reallocate CUDA Buffers", obs_source_get_name(_self)};
+		auto prof = _profile_ar_calc->track();
 #endif
-			// Assign new texture and allocate new memory.
-			std::size_t pitch = _ar_texture->get_width() * 4ul;
-			_ar_texture_cuda  = std::make_shared<::streamfx::nvidia::cuda::gstexture>(_ar_texture);
-			_ar_texture_cuda_mem =
-				std::make_shared<::streamfx::nvidia::cuda::memory>(pitch * _ar_texture->get_height());
-			if (auto res = _ar_library->image_init(&_ar_image, static_cast<unsigned int>(_ar_texture->get_width()),
-												   static_cast<unsigned int>(_ar_texture->get_height()),
-												   static_cast<int>(pitch),
-												   reinterpret_cast<void*>(_ar_texture_cuda_mem->get()), NVCV_RGBA,
-												   NVCV_U8, NVCV_INTERLEAVED, NVCV_CUDA);
-				res != NVCV_SUCCESS) {
-				DLOG_ERROR("<%s> Failed to allocate image for tracking.", obs_source_get_name(_self));
-				return;
-			}
 
-			// Reallocate transposed buffer.
-			_ar_library->image_dealloc(&_ar_image_temp);
-			_ar_library->image_dealloc(&_ar_image_bgr);
-			if (auto res = _ar_library->image_alloc(&_ar_image_bgr, _ar_image.width, _ar_image.height, NVCV_BGR,
-													NVCV_U8, NVCV_INTERLEAVED, NVCV_CUDA, 0);
-				res != NVCV_SUCCESS) {
-				DLOG_ERROR("<%s> Failed to allocate image for color conversion.", obs_source_get_name(_self));
-				return;
-			}
-
-			// Synchronize Streams.
-			_cuda_stream->synchronize();
+		double_t sx     = static_cast<double_t>(slot.frame.first);
+		double_t sy     = static_cast<double_t>(slot.frame.second);
+		double_t aspect = double_t(sx) / double_t(sy);
+
+		// Store values and center.
+		double_t bsx = primary.width;
+		double_t bsy = primary.height;
+		double_t bcx = primary.x + bsx / 2.0;
+		double_t bcy = primary.y + bsy / 2.0;
+
+		// Zoom, Aspect Ratio, Offset
+		bsy = streamfx::util::math::lerp<double_t>(sy, bsy, _cfg_zoom);
+		bsy = std::clamp(bsy, 10 * aspect, sy);
+		bsx = bsy * aspect;
+		bcx += primary.width * _cfg_offset.first;
+		bcy += primary.height * _cfg_offset.second;
+
+		// Fit back into the frame
+		// - Above code guarantees that height is never bigger than the height of the frame.
+		// - Which also guarantees that width is never bigger than the width of the frame.
+		// Only cx and cy need to be adjusted now to always be in the frame.
+		bcx = std::clamp(bcx, (bsx / 2.), sx - (bsx / 2.));
+		bcy = std::clamp(bcy, (bsy / 2.), sy - (bsy / 2.));
+
+		{ // Update target values.
+			std::unique_lock<std::mutex> tlk{_values.lock};
 
-			// Finally set the input object.
-			if (NvCV_Status res = _ar_library->set_object(_ar_feature.get(), NvAR_Parameter_Input(Image),
-														  &_ar_image_bgr, sizeof(NvCVImage));
-				res != NVCV_SUCCESS) {
-				DLOG_ERROR("<%s> Failed to update input image for tracking.", obs_source_get_name(_self));
-				return;
+			// Detections can be several frames apart, so the velocity uses the time between them. In between, the
+			// center is extrapolated from it in video_tick.
+			double_t delta = static_cast<double_t>(slot.timestamp - _values.timestamp) / 1000000000.;
+			if ((_values.timestamp != 0) && (slot.timestamp > _values.timestamp) && (delta < 1.)) {
+				_values.velocity[0] = (bcx / sx - _values.detected[0]) / delta;
+				_values.velocity[1] = (bcy / sy - _values.detected[1]) / delta;
+			} else {
+				_values.velocity[0] = 0;
+				_values.velocity[1] = 0;
 			}
+			_values.center[0] = _values.detected[0] = bcx / sx;
+			_values.center[1] = _values.detected[1] = bcy / sy;
+			_values.size[0]   = bsx / sx;
+			_values.size[1]   = bsy / sy;
+			_values.face[0]   = primary.x / sx;
+			_values.face[1]   = primary.y / sy;
+			_values.face[2]   = primary.width / sx;
+			_values.face[3]   = primary.height / sy;
+			_values.timestamp = slot.timestamp;
+		}
+	}
+}
+
+void face_tracking_instance::assign_tracks(const capture_slot& slot)
+{
+	_ar_tracks.resize(std::clamp<uint32_t>(_cfg_faces, 1, ST_MAX_FACES));
 
-			// And mark the new texture as fresh.
-			_ar_texture_cuda_fresh = true;
+	// Only confident detections count, the others are too likely to be something else.
+	std::vector<const NvAR_Rect*> detections;
+	for (std::size_t idx = 0; idx < _ar_bboxes.num_boxes; idx++) {
+		if (_ar_bboxes_confidence[idx] >= 0.3333) {
+			detections.push_back(&_ar_bboxes.boxes[idx]);
 		}
+	}
 
-		{ // Copy from CUDA array to CUDA device memory.
-#ifdef ENABLE_PROFILING
-			auto prof = _profile_ar_copy->track();
-#endif
-			::streamfx::nvidia::cuda::memcpy2d_v2_t mc;
-			mc.src_x_in_bytes  = 0;
-			mc.src_y           = 0;
-			mc.src_memory_type = ::streamfx::nvidia::cuda::memory_type::ARRAY;
-			mc.src_host        = nullptr;
-			mc.src_device      = 0;
-			mc.src_array       = _ar_texture_cuda->map(_cuda_stream);
-			mc.src_pitch       = static_cast<size_t>(_ar_image.pitch);
-			mc.dst_x_in_bytes  = 0;
-			mc.dst_y           = 0;
-			mc.dst_memory_type = ::streamfx::nvidia::cuda::memory_type::DEVICE;
-			mc.dst_host        = 0;
-			mc.dst_device      = reinterpret_cast<::streamfx::nvidia::cuda::device_ptr_t>(_ar_image.pixels);
-			mc.dst_array       = 0;
-			mc.dst_pitch       = static_cast<size_t>(_ar_image.pitch);
-			mc.width_in_bytes  = static_cast<size_t>(_ar_image.pitch);
-			mc.height          = _ar_image.height;
-
-			if (::streamfx::nvidia::cuda::result res = _cuda->get_cuda()->cuMemcpy2DAsync(&mc, _cuda_stream->get());
-				res != ::streamfx::nvidia::cuda::result::SUCCESS) {
-				DLOG_ERROR("<%s> Failed to prepare buffers for tracking.", obs_source_get_name(_self));
-				return;
-			}
+	auto center_distance = [](const NvAR_Rect& a, const NvAR_Rect& b) {
+		double_t dx = (a.x + a.width / 2.) - (b.x + b.width / 2.);
+		double_t dy = (a.y + a.height / 2.) - (b.y + b.height / 2.);
+		return std::sqrt(dx * dx + dy * dy);
+	};
+
+	// Every followed face takes the closest detection that moved by less than its own size.
+	for (face_track& face : _ar_tracks) {
+		if ((face.box.width <= 0.) || (face.box.height <= 0.)) {
+			continue;
 		}
 
-		{ // Convert from RGBA 32-bit to BGR 24-bit.
-#ifdef ENABLE_PROFILING
-			auto prof = _profile_ar_transfer->track();
-#endif
-			if (NvCV_Status res =
-					_ar_library->image_transfer(&_ar_image, &_ar_image_bgr, 1.0,
-												reinterpret_cast<CUstream_st*>(_cuda_stream->get()), &_ar_image_temp);
-				res != NVCV_SUCCESS) {
-				DLOG_ERROR("<%s> Failed to convert from RGBX 32-bit to BGR 24-bit.", obs_source_get_name(_self));
-				return;
+		auto     best          = detections.end();
+		double_t best_distance = std::max(face.box.width, face.box.height);
+		for (auto iter = detections.begin(); iter != detections.end(); iter++) {
+			if (double_t distance = center_distance(face.box, **iter); distance < best_distance) {
+				best          = iter;
+				best_distance = distance;
 			}
+		}
+		if (best != detections.end()) {
+			face.box  = **best;
+			face.seen = slot.timestamp;
+			detections.erase(best);
+		} else if ((slot.timestamp - face.seen) > ST_TRACK_HOLD) {
+			face.box = {0., 0., 0., 0.};
+		}
+	}
 
-			// Synchronize Streams.
-			_cuda_stream->synchronize();
-			_cuda->get_context()->synchronize();
+	// New faces take the free indexes from left to right, so that people who appear together are numbered in order.
+	std::sort(detections.begin(), detections.end(), [](const NvAR_Rect* a, const NvAR_Rect* b) { return a->x < b->x; });
+	auto detection = detections.begin();
+	for (face_track& face : _ar_tracks) {
+		if (detection == detections.end()) {
+			break;
+		}
+		if ((face.box.width <= 0.) || (face.box.height <= 0.)) {
+			face.box  = **(detection++);
+			face.seen = slot.timestamp;
 		}
+	}
+}
 
-		{ // Track any faces.
-#ifdef ENABLE_PROFILING
-			auto prof = _profile_ar_run->track();
-#endif
-			if (NvCV_Status res = _ar_library->run(_ar_feature.get()); res != NVCV_SUCCESS) {
-				DLOG_ERROR("<%s> Failed to run tracking.", obs_source_get_name(_self));
-				return;
-			}
+void face_tracking_instance::prioritize_primary(const capture_slot& slot)
+{
+	if (_ar_tracks.empty() || (_ar_bboxes.num_boxes < 2)) {
+		return;
+	}
+	const NvAR_Rect& primary = _ar_tracks[0].box;
+	if ((primary.width <= 0.) || (primary.height <= 0.)) {
+		return;
+	}
+
+	// The detections are still in image pixels, while the tracks are in frame pixels.
+	float_t scale_x = slot.region.width / static_cast<float_t>(_ar_image_bgr.width);
+	float_t scale_y = slot.region.height / static_cast<float_t>(_ar_image_bgr.height);
+	double_t px     = (primary.x + primary.width / 2. - slot.region.x) / scale_x;
+	double_t py     = (primary.y + primary.height / 2. - slot.region.y) / scale_y;
+
+	std::size_t best          = 0;
+	double_t    best_distance = std::numeric_limits<double_t>::max();
+	for (std::size_t idx = 0; idx < _ar_bboxes.num_boxes; idx++) {
+		const NvAR_Rect& box = _ar_bboxes.boxes[idx];
+		double_t         dx  = box.x + box.width / 2. - px;
+		double_t         dy  = box.y + box.height / 2. - py;
+		if (double_t distance = dx * dx + dy * dy; distance < best_distance) {
+			best          = idx;
+			best_distance = distance;
 		}
+	}
+	if (best != 0) {
+		std::swap(_ar_bboxes.boxes[0], _ar_bboxes.boxes[best]);
+		std::swap(_ar_bboxes_confidence[0], _ar_bboxes_confidence[best]);
+	}
+}
 
-		// Are we tracking anything, and confident enough in the tracking?
-		if ((_ar_bboxes.num_boxes == 0) || (_ar_bboxes_confidence.at(0) < 0.3333)) {
-			// If not, just return to full frame.
-			std::unique_lock<std::mutex> tlk{_values.lock};
-			_values.center[0]   = .5;
-			_values.center[1]   = .5;
-			_values.size[0]     = 1.;
-			_values.size[1]     = 1.;
-			_values.velocity[0] = 0;
-			_values.velocity[1] = 0;
-		} else {
-			// If yes, begin tracking.
-#ifdef ENABLE_PROFILING
-			auto prof = _profile_ar_calc->track();
-#endif
+bool face_tracking_instance::track_landmarks(ar_shared_feature& landmarks)
+{
+	// Landmarks are only tracked for the face found by the detection, which also saves the feature its own.
+	if ((_ar_bboxes.num_boxes == 0) || (_ar_bboxes_confidence.at(0) < 0.3333)) {
+		return false;
+	}
 
-			double_t sx     = static_cast<double_t>(_ar_image_bgr.width);
-			double_t sy     = static_cast<double_t>(_ar_image_bgr.height);
-			double_t aspect = double_t(sx) / double_t(sy);
-			double_t fps    = 0.;
+	if (_ar_landmarks.size() != landmarks.points) {
+		_ar_landmarks.resize(landmarks.points);
+		_ar_landmarks_confidence.resize(landmarks.points);
+	}
 
-			{
-				obs_video_info ovi;
-				obs_get_video_info(&ovi);
-				fps = static_cast<double_t>(ovi.fps_num) / static_cast<double_t>(ovi.fps_den);
-			}
+	auto feature = landmarks.feature;
+	if (NvCV_Status res = feature->set_object(NvAR_Parameter_Input(Image), &_ar_image_bgr, sizeof(NvCVImage));
+		res != NVCV_SUCCESS) {
+		DLOG_ERROR("<%s> Failed to update input image for landmark tracking.", obs_source_get_name(_self));
+		return false;
+	}
+	if (NvCV_Status res =
+			feature->set_object(NvAR_Parameter_Input(BoundingBoxes), &_ar_bboxes, sizeof(NvAR_BBoxes));
+		res != NVCV_SUCCESS) {
+		DLOG_ERROR("<%s> Failed to set BoundingBoxes for landmark tracking.", obs_source_get_name(_self));
+		return false;
+	}
+	if (NvCV_Status res = feature->set_object(NvAR_Parameter_Output(Landmarks), _ar_landmarks.data(),
+											  sizeof(NvAR_Point2f));
+		res != NVCV_SUCCESS) {
+		DLOG_ERROR("<%s> Failed to set Landmarks for landmark tracking.", obs_source_get_name(_self));
+		return false;
+	}
+	if (NvCV_Status res = feature->set_float32_array(NvAR_Parameter_Output(LandmarksConfidence),
+													 _ar_landmarks_confidence.data(), _ar_landmarks_confidence.size());
+		res != NVCV_SUCCESS) {
+		DLOG_ERROR("<%s> Failed to set LandmarksConfidence for landmark tracking.", obs_source_get_name(_self));
+		return false;
+	}
 
-			// Store values and center.
-			double_t bsx = _ar_bboxes.boxes[0].width;
-			double_t bsy = _ar_bboxes.boxes[0].height;
-			double_t bcx = _ar_bboxes.boxes[0].x + bsx / 2.0;
-			double_t bcy = _ar_bboxes.boxes[0].y + bsy / 2.0;
-
-			// Zoom, Aspect Ratio, Offset
-			bsy = streamfx::util::math::lerp<double_t>(sy, bsy, _cfg_zoom);
-			bsy = std::clamp(bsy, 10 * aspect, static_cast<double_t>(_size.second));
-			bsx = bsy * aspect;
-			bcx += _ar_bboxes.boxes[0].width * _cfg_offset.first;
-			bcy += _ar_bboxes.boxes[0].height * _cfg_offset.second;
-
-			// Fit back into the frame
-			// - Above code guarantees that height is never bigger than the height of the frame.
-			// - Which also guarantees that width is never bigger than the width of the frame.
-			// Only cx and cy need to be adjusted now to always be in the frame.
-			bcx = std::clamp(bcx, (bsx / 2.), sx - (bsx / 2.));
-			bcy = std::clamp(bcy, (bsy / 2.), sy - (bsy / 2.));
-
-			{ // Update target values.
-				std::unique_lock<std::mutex> tlk{_values.lock};
-				_values.velocity[0] = -_values.center[0];
-				_values.velocity[1] = -_values.center[1];
-				_values.center[0]   = bcx / sx;
-				_values.center[1]   = bcy / sy;
-				_values.velocity[0] += _values.center[0];
-				_values.velocity[1] += _values.center[1];
-				_values.velocity[0] *= fps;
-				_values.velocity[1] *= fps;
-				_values.size[0] = bsx / sx;
-				_values.size[1] = bsy / sy;
-			}
-		}
+	if (NvCV_Status res = feature->run(); res != NVCV_SUCCESS) {
+		DLOG_ERROR("<%s> Failed to run landmark tracking.", obs_source_get_name(_self));
+		return false;
+	}
+	return true;
+}
+
+bool face_tracking_instance::track_body_pose(ar_shared_feature& body_pose)
+{
+	if (_ar_body.size() != body_pose.points) {
+		_ar_body.resize(body_pose.points);
+		_ar_body_3d.resize(body_pose.points);
+		_ar_body_angles.resize(body_pose.points);
+		_ar_body_confidence.resize(body_pose.points);
+	}
+
+	auto feature = body_pose.feature;
+	if (NvCV_Status res = feature->set_object(NvAR_Parameter_Input(Image), &_ar_image_bgr, sizeof(NvCVImage));
+		res != NVCV_SUCCESS) {
+		DLOG_ERROR("<%s> Failed to update input image for body pose tracking.", obs_source_get_name(_self));
+		return false;
+	}
+	if (NvCV_Status res =
+			feature->set_object(NvAR_Parameter_Output(KeyPoints), _ar_body.data(), sizeof(NvAR_Point2f));
+		res != NVCV_SUCCESS) {
+		DLOG_ERROR("<%s> Failed to set KeyPoints for body pose tracking.", obs_source_get_name(_self));
+		return false;
+	}
+	if (NvCV_Status res =
+			feature->set_object(NvAR_Parameter_Output(KeyPoints3D), _ar_body_3d.data(), sizeof(NvAR_Point3f));
+		res != NVCV_SUCCESS) {
+		DLOG_ERROR("<%s> Failed to set KeyPoints3D for body pose tracking.", obs_source_get_name(_self));
+		return false;
+	}
+	if (NvCV_Status res = feature->set_object(NvAR_Parameter_Output(JointAngles), _ar_body_angles.data(),
+											  sizeof(NvAR_Quaternion));
+		res != NVCV_SUCCESS) {
+		DLOG_ERROR("<%s> Failed to set JointAngles for body pose tracking.", obs_source_get_name(_self));
+		return false;
+	}
+	if (NvCV_Status res = feature->set_float32_array(NvAR_Parameter_Output(KeyPointsConfidence),
+													 _ar_body_confidence.data(), _ar_body_confidence.size());
+		res != NVCV_SUCCESS) {
+		DLOG_ERROR("<%s> Failed to set KeyPointsConfidence for body pose tracking.", obs_source_get_name(_self));
+		return false;
+	}
+	if (NvCV_Status res =
+			feature->set_object(NvAR_Parameter_Output(BoundingBoxes), &_ar_body_bboxes, sizeof(NvAR_BBoxes));
+		res != NVCV_SUCCESS) {
+		DLOG_ERROR("<%s> Failed to set BoundingBoxes for body pose tracking.", obs_source_get_name(_self));
+		return false;
+	}
 
-		_async_track.reset();
+	if (NvCV_Status res = feature->run(); res != NVCV_SUCCESS) {
+		DLOG_ERROR("<%s> Failed to run body pose tracking.", obs_source_get_name(_self));
+		return false;
+	}
+	return true;
+}
+
+bool face_tracking_instance::acquire_runtime()
+{
+	if (_ar_runtime) {
+		return true;
+	}
 
-		// Allow new frames to be queued again.
-		_ar_is_tracking = false;
+	auto factory = face_tracking_factory::get();
+	if (!factory->is_sdk_available()) {
+		return false;
 	}
+
+	_cuda                = factory->get_cuda();
+	_ar_library          = factory->get_ar();
+	_cuda_capture_stream = _cuda->get_worker_stream();
+	_ar_runtime          = factory->get_runtime();
+
+	// Settings may have asked for more features before there was a runtime to load them into.
+	if (_cfg_landmarks) {
+		factory->request_feature(_ar_runtime, ar_feature_type::Landmarks);
+	}
+	if (_cfg_body_pose) {
+		factory->request_feature(_ar_runtime, ar_feature_type::BodyPose);
+	}
+	return true;
 }
 
 void face_tracking_instance::refresh_geometry()
@@ -496,6 +898,22 @@ void face_tracking_instance::update(obs_data_t* data)
 	_cfg_offset.first  = obs_data_get_double(data, ST_KEY_ROI_OFFSET_X) / 100.0;
 	_cfg_offset.second = obs_data_get_double(data, ST_KEY_ROI_OFFSET_Y) / 100.0;
 	_cfg_stability     = obs_data_get_double(data, ST_KEY_ROI_STABILITY) / 100.0;
+	_cfg_frequency     = obs_data_get_double(data, ST_KEY_TRACKING_FREQUENCY);
+	_cfg_resolution    = static_cast<uint32_t>(obs_data_get_int(data, ST_KEY_TRACKING_RESOLUTION));
+	_cfg_refine        = static_cast<uint32_t>(obs_data_get_int(data, ST_KEY_TRACKING_REFINE));
+	_cfg_landmarks     = obs_data_get_bool(data, ST_KEY_TRACKING_LANDMARKS);
+	_cfg_body_pose     = obs_data_get_bool(data, ST_KEY_TRACKING_BODYPOSE);
+	_cfg_faces         = static_cast<uint32_t>(std::clamp<int64_t>(obs_data_get_int(data, ST_KEY_TRACKING_FACES), 1,
+																	ST_MAX_FACES));
+	_cfg_apply         = obs_data_get_bool(data, ST_KEY_ROI_APPLY);
+
+	// Features beyond detection are only loaded once an instance asks for them.
+	if (_ar_runtime && _cfg_landmarks) {
+		face_tracking_factory::get()->request_feature(_ar_runtime, ar_feature_type::Landmarks);
+	}
+	if (_ar_runtime && _cfg_body_pose) {
+		face_tracking_factory::get()->request_feature(_ar_runtime, ar_feature_type::BodyPose);
+	}
 
 	// Refresh the Region Of Interest
 	refresh_region_of_interest();
@@ -504,7 +922,7 @@ void face_tracking_instance::update(obs_data_t* data)
 void face_tracking_instance::video_tick(float_t seconds)
 {
 	// If we aren't yet ready to do work, abort for now.
-	if (!_ar_loaded) {
+	if (!acquire_runtime() || !_ar_runtime->get(ar_feature_type::FaceDetection).loaded) {
 		return;
 	}
 
@@ -523,7 +941,12 @@ void face_tracking_instance::video_tick(float_t seconds)
 		_filters.size[1].filter(_values.size[1]);
 		_values.center[0] += _values.velocity[0] * seconds;
 		_values.center[1] += _values.velocity[1] * seconds;
+
+		// Don't let the prediction drift the region out of the frame.
+		_values.center[0] = std::clamp(_values.center[0], _values.size[0] / 2., 1. - _values.size[0] / 2.);
+		_values.center[1] = std::clamp(_values.center[1], _values.size[1] / 2., 1. - _values.size[1] / 2.);
 	}
+	_track_timer += seconds;
 	refresh_geometry();
 
 	_rt_is_fresh = false;
@@ -535,7 +958,8 @@ void face_tracking_instance::video_render(gs_effect_t*)
 	obs_source_t* filter_target  = obs_filter_get_target(_self);
 	gs_effect_t*  default_effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
 
-	if (!filter_parent || !filter_target || !_size.first || !_size.second || !_ar_loaded) {
+	if (!filter_parent || !filter_target || !_size.first || !_size.second || !_ar_runtime
+		|| !_ar_runtime->get(ar_feature_type::FaceDetection).loaded) {
 		obs_source_skip_video_filter(_self);
 		return;
 	}
@@ -575,10 +999,23 @@ void face_tracking_instance::video_render(gs_effect_t*)
 			}
 		}
 
-		// Probably spawn new work.
-		async_track(nullptr);
+		// Probably spawn new work, but only as often as configured. Frames in between are predicted instead. When the
+		// governor asks for less work, the rate is halved for every level. Outside of program, the results of the last
+		// tracking are kept until program shows this again.
+		double_t frequency = _cfg_frequency / double_t(uint32_t(1) << degrade_level());
+		if (double_t interval = 1. / std::max(frequency, 1.); (_track_timer >= interval) && !is_preview_render()) {
+			_track_timer = std::min(_track_timer - interval, interval);
+			async_track(nullptr);
+		}
 
 		_rt_is_fresh = true;
+
+		uint64_t memory = streamfx::obs::statistics::texture_memory(_rt->get_texture())
+						  + streamfx::obs::statistics::texture_memory(_ar_scale_rt->get_texture());
+		for (auto& slot : _ar_slots) {
+			memory += streamfx::obs::statistics::texture_memory(slot.texture);
+		}
+		_statistics->set_video_memory(memory);
 	}
 
 	{ // Draw Texture
@@ -587,24 +1024,65 @@ void face_tracking_instance::video_render(gs_effect_t*)
 #endif
 
 		gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"), _rt->get_texture()->get_object());
-		gs_load_vertexbuffer(_geometry->update(false));
-		while (gs_effect_loop(default_effect, "Draw")) {
-			gs_draw(gs_draw_mode::GS_TRISTRIP, 0, 0);
+		if (!_cfg_apply) {
+			// Only tracking for others, such as Face Crop sources that each frame one of the faces.
+			while (gs_effect_loop(default_effect, "Draw")) {
+				gs_draw_sprite(nullptr, 0, _size.first, _size.second);
+			}
+		} else {
+			gs_load_vertexbuffer(_geometry->update(false));
+			while (gs_effect_loop(default_effect, "Draw")) {
+				gs_draw(gs_draw_mode::GS_TRISTRIP, 0, 0);
+			}
+			gs_load_vertexbuffer(nullptr);
 		}
-		gs_load_vertexbuffer(nullptr);
 	}
 }
 
+void face_tracking_instance::idle()
+{
+	// The tracking thread holds the lock while it works on a frame, which then stays until the next time this idles.
+	std::unique_lock<std::mutex> alk{_ar_lock, std::try_to_lock};
+	if (!alk.owns_lock() || !_cuda || !_ar_library) {
+		return;
+	}
+
+	auto cctx = _cuda->get_context()->enter();
+	{
+		std::unique_lock<std::mutex> slk{_ar_slots_lock};
+		for (auto& slot : _ar_slots) {
+			if (slot.state != capture_state::Free) {
+				continue;
+			}
+			if (slot.texture_cuda) {
+				slot.texture_cuda->unmap();
+			}
+			slot.texture_cuda.reset();
+			slot.texture.reset();
+		}
+	}
+	_ar_library->image_dealloc(&_ar_image_temp);
+	_ar_library->image_dealloc(&_ar_image_bgr);
+	_ar_image_temp = NvCVImage{};
+	_ar_image_bgr  = NvCVImage{};
+
+	// Both are allocated again on their first render.
+	_rt          = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA_UNORM, GS_ZS_NONE);
+	_ar_scale_rt = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA_UNORM, GS_ZS_NONE);
+	_rt_is_fresh = false;
+}
+
 #ifdef ENABLE_PROFILING
 bool face_tracking_instance::button_profile(obs_properties_t* props, obs_property_t* property)
 {
 	DLOG_INFO("%-22s: %-10s %-10s %-10s %-10s %-10s", "Task", "Total", "Count", "Average", "99.9%ile", "95.0%ile");
 
 	std::pair<std::string, std::shared_ptr<streamfx::util::profiler>> profilers[]{
-		{"Capture", _profile_capture},   {"Reallocate", _profile_capture_realloc},
-		{"Copy", _profile_capture_copy}, {"AR Reallocate", _profile_ar_realloc},
-		{"AR Copy", _profile_ar_copy},   {"AR Convert", _profile_ar_transfer},
-		{"AR Run", _profile_ar_run},     {"AR Calculate", _profile_ar_calc},
+		{"Capture", _profile_capture},        {"Reallocate", _profile_capture_realloc},
+		{"Copy", _profile_capture_copy},      {"AR Reallocate", _profile_ar_realloc},
+		{"AR Copy", _profile_ar_copy},        {"AR Wait", _profile_ar_wait},
+		{"AR Convert", _profile_ar_transfer}, {"AR Run", _profile_ar_run},
+		{"AR Calculate", _profile_ar_calc},   {"AR Latency", _profile_ar_latency},
 	};
 	for (auto& kv : profilers) {
 		DLOG_INFO("  %-20s: %8lldµs %10lld %8lldµs %8lldµs %8lldµs", kv.first.c_str(),
@@ -619,13 +1097,8 @@ bool face_tracking_instance::button_profile(obs_properties_t* props, obs_propert
 #endif
 
 face_tracking_factory::face_tracking_factory()
+	: _cuda(), _ar(), _runtime_lock(), _runtime(), _sdk_lock(), _sdk_requested(false), _sdk_loaded(false)
 {
-	// Try and load CUDA.
-	_cuda = ::streamfx::nvidia::cuda::obs::get();
-
-	// Try and load AR.
-	_ar = std::make_shared<::streamfx::nvidia::ar::ar>();
-
 	// Info
 	_info.id           = S_PREFIX "filter-nvidia-face-tracking";
 	_info.type         = OBS_SOURCE_TYPE_FILTER;
@@ -649,15 +1122,31 @@ void face_tracking_factory::get_defaults2(obs_data_t* data)
 	obs_data_set_default_double(data, ST_KEY_ROI_OFFSET_X, 0.0);
 	obs_data_set_default_double(data, ST_KEY_ROI_OFFSET_Y, -15.0);
 	obs_data_set_default_double(data, ST_KEY_ROI_STABILITY, 50.0);
+	obs_data_set_default_double(data, ST_KEY_TRACKING_FREQUENCY, 30.0);
+	obs_data_set_default_int(data, ST_KEY_TRACKING_RESOLUTION, 360);
+	obs_data_set_default_int(data, ST_KEY_TRACKING_REFINE, 0);
+	obs_data_set_default_bool(data, ST_KEY_TRACKING_LANDMARKS, false);
+	obs_data_set_default_bool(data, ST_KEY_TRACKING_BODYPOSE, false);
+	obs_data_set_default_int(data, ST_KEY_TRACKING_FACES, 1);
+	obs_data_set_default_bool(data, ST_KEY_ROI_APPLY, true);
 }
 
 obs_properties_t* face_tracking_factory::get_properties2(face_tracking_instance* data)
 {
 	obs_properties_t* pr = obs_properties_create();
 
+	if (!is_sdk_loaded()) {
+		obs_properties_add_text(pr, ST_KEY_STATE, D_TRANSLATE(ST_I18N_STATE_INITIALIZING), OBS_TEXT_INFO);
+	} else if (!is_sdk_available()) {
+		obs_properties_add_text(pr, ST_KEY_STATE, D_TRANSLATE(ST_I18N_STATE_UNAVAILABLE), OBS_TEXT_INFO);
+	}
+
 	{
 		auto grp = obs_properties_create();
 		obs_properties_add_group(pr, ST_I18N_ROI, D_TRANSLATE(ST_I18N_ROI), OBS_GROUP_NORMAL, grp);
+		{
+			obs_properties_add_bool(grp, ST_KEY_ROI_APPLY, D_TRANSLATE(ST_I18N_ROI_APPLY));
+		}
 		{
 			auto p = obs_properties_add_float_slider(grp, ST_KEY_ROI_STABILITY, D_TRANSLATE(ST_I18N_ROI_STABILITY), 0,
 													 100.0, 0.01);
@@ -684,6 +1173,37 @@ obs_properties_t* face_tracking_factory::get_properties2(face_tracking_instance*
 			}
 		}
 	}
+	{
+		auto grp = obs_properties_create();
+		obs_properties_add_group(pr, ST_I18N_TRACKING, D_TRANSLATE(ST_I18N_TRACKING), OBS_GROUP_NORMAL, grp);
+		{
+			auto p = obs_properties_add_float_slider(grp, ST_KEY_TRACKING_FREQUENCY,
+													 D_TRANSLATE(ST_I18N_TRACKING_FREQUENCY), 1.0, 120.0, 0.01);
+			obs_property_float_set_suffix(p, " Hz");
+		}
+		{
+			auto p = obs_properties_add_list(grp, ST_KEY_TRACKING_RESOLUTION, D_TRANSLATE(ST_I18N_TRACKING_RESOLUTION),
+											 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+			obs_property_list_add_int(p, D_TRANSLATE(S_STATE_DISABLED), 0);
+			obs_property_list_add_int(p, "1080p", 1080);
+			obs_property_list_add_int(p, "720p", 720);
+			obs_property_list_add_int(p, "540p", 540);
+			obs_property_list_add_int(p, "360p", 360);
+		}
+		{
+			auto p = obs_properties_add_int_slider(grp, ST_KEY_TRACKING_REFINE, D_TRANSLATE(ST_I18N_TRACKING_REFINE),
+												   0, 30, 1);
+			obs_property_int_set_suffix(p, " frames");
+		}
+		{
+			obs_properties_add_int_slider(grp, ST_KEY_TRACKING_FACES, D_TRANSLATE(ST_I18N_TRACKING_FACES), 1,
+										  ST_MAX_FACES, 1);
+		}
+		{
+			obs_properties_add_bool(grp, ST_KEY_TRACKING_LANDMARKS, D_TRANSLATE(ST_I18N_TRACKING_LANDMARKS));
+			obs_properties_add_bool(grp, ST_KEY_TRACKING_BODYPOSE, D_TRANSLATE(ST_I18N_TRACKING_BODYPOSE));
+		}
+	}
 #ifdef ENABLE_PROFILING
 	{
 		obs_properties_add_button2(
@@ -698,11 +1218,165 @@ obs_properties_t* face_tracking_factory::get_properties2(face_tracking_instance*
 	return pr;
 }
 
+void face_tracking_factory::request_sdk()
+{
+	if (_sdk_requested.exchange(true)) {
+		return;
+	}
+
+	streamfx::threadpool()->push(
+		[](streamfx::util::threadpool_data_t) {
+			if (auto factory = face_tracking_factory::get(); factory) {
+				factory->load_sdk();
+			}
+		},
+		nullptr);
+}
+
+bool face_tracking_factory::load_sdk()
+{
+	std::unique_lock<std::mutex> lock{_sdk_lock};
+	if (!_sdk_loaded) {
+		try {
+			// Try and load CUDA.
+			_cuda = ::streamfx::nvidia::cuda::obs::get();
+
+			// Try and load AR.
+			_ar = std::make_shared<::streamfx::nvidia::ar::ar>();
+		} catch (const std::exception& ex) {
+			_ar.reset();
+			_cuda.reset();
+			DLOG_ERROR("<%s> Failed to load NVIDIA SDKs: %s", D_TRANSLATE(ST_I18N), ex.what());
+		}
+		_sdk_loaded = true;
+	}
+	return _ar != nullptr;
+}
+
+bool face_tracking_factory::is_sdk_loaded()
+{
+	return _sdk_loaded;
+}
+
+bool face_tracking_factory::is_sdk_available()
+{
+	// Never written again once loaded, so no lock is needed.
+	return _sdk_loaded && _ar;
+}
+
+std::shared_ptr<::streamfx::nvidia::cuda::obs> face_tracking_factory::get_cuda()
+{
+	return _cuda;
+}
+
 std::shared_ptr<::streamfx::nvidia::ar::ar> face_tracking_factory::get_ar()
 {
 	return _ar;
 }
 
+std::shared_ptr<ar_runtime> face_tracking_factory::get_runtime()
+{
+	std::unique_lock<std::mutex> lock{_runtime_lock};
+	if (auto runtime = _runtime.lock(); runtime) {
+		return runtime;
+	}
+
+	// Created on first use and released with the last instance. Every instance needs detection, anything else is
+	// only loaded once an instance enables it.
+	auto runtime    = std::make_shared<ar_runtime>();
+	runtime->stream = _cuda->get_worker_stream();
+	_runtime        = runtime;
+
+	request_feature(runtime, ar_feature_type::FaceDetection);
+
+	return runtime;
+}
+
+void face_tracking_factory::request_feature(std::shared_ptr<ar_runtime> runtime, ar_feature_type type)
+{
+	if (runtime->get(type).requested.exchange(true)) {
+		return;
+	}
+
+	std::filesystem::path models_path = _ar->get_ar_sdk_path();
+	models_path                       = models_path.append("models");
+	models_path                       = std::filesystem::absolute(models_path);
+	models_path.concat("\\");
+
+	// Loading a model takes long so it happens in the background, instances simply skip the feature until it is done.
+	std::weak_ptr<ar_runtime> weak = runtime;
+	streamfx::threadpool()->push(
+		[weak, type, ar = _ar, cuda = _cuda, models = models_path.string()](streamfx::util::threadpool_data_t) {
+			auto runtime = weak.lock();
+			if (!runtime) {
+				return;
+			}
+			auto& shared = runtime->get(type);
+
+			try {
+				// Update the current CUDA context for working.
+				streamfx::obs::gs::context gctx;
+				auto                       cctx = cuda->get_context()->enter();
+
+				NvAR_FeatureID id = NvAR_Feature_FaceDetection;
+				switch (type) {
+				case ar_feature_type::FaceDetection:
+					id = NvAR_Feature_FaceDetection;
+					break;
+				case ar_feature_type::Landmarks:
+					id = NvAR_Feature_LandmarkDetection;
+					break;
+				case ar_feature_type::BodyPose:
+					id = NvAR_Feature_BodyPoseEstimation;
+					break;
+				}
+
+				// Built without holding the runtime lock, so instances keep tracking with the features they have.
+				auto feature = std::make_shared<::streamfx::nvidia::ar::feature>(ar, id);
+
+				// Set the correct CUDA stream for processing.
+				if (NvCV_Status res = feature->set(NvAR_Parameter_Config(CUDAStream), runtime->stream);
+					res != NVCV_SUCCESS) {
+					throw std::runtime_error("Failed to set CUDA stream.");
+				}
+
+				// Set the correct models path.
+				if (NvCV_Status res = feature->set(NvAR_Parameter_Config(ModelDir), models);
+					res != NVCV_SUCCESS) {
+					throw std::runtime_error("Unable to set model path.");
+				}
+
+				// Temporal tracking assumes consecutive frames of one video, which is no longer the case when
+				// instances take turns. The Kalman filters of each instance do the smoothing instead.
+				if (NvCV_Status res = feature->set(NvAR_Parameter_Config(Temporal), static_cast<uint32_t>(0));
+					res != NVCV_SUCCESS) {
+					DLOG_WARNING("<%s> Unable to disable Temporal tracking mode.", D_TRANSLATE(ST_I18N));
+				}
+
+				// And finally, load the feature (takes long).
+				if (NvCV_Status res = feature->load(); res != NVCV_SUCCESS) {
+					throw std::runtime_error("Failed to load NVIDIA AR feature.");
+				}
+
+				// The number of points is only known once the model is loaded.
+				uint32_t points = 0;
+				if (type == ar_feature_type::Landmarks) {
+					feature->get(NvAR_Parameter_Config(Landmarks_Size), points);
+				} else if (type == ar_feature_type::BodyPose) {
+					feature->get(NvAR_Parameter_Config(NumKeyPoints), points);
+				}
+
+				std::unique_lock<std::mutex> lk{runtime->lock};
+				shared.feature = feature;
+				shared.points  = points;
+				shared.loaded  = true;
+			} catch (const std::exception& ex) {
+				DLOG_ERROR("<%s> %s", D_TRANSLATE(ST_I18N), ex.what());
+			}
+		},
+		nullptr);
+}
+
 std::shared_ptr<face_tracking_factory> _filter_nvidia_face_tracking_factory_instance = nullptr;
 
 void streamfx::filter::nvidia::face_tracking_factory::initialize()
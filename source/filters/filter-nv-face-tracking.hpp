@@ -19,16 +19,21 @@
 
 #pragma once
 #include "common.hpp"
+#include <array>
 #include <atomic>
 #include <vector>
 #include "obs/gs/gs-effect.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-vertexbuffer.hpp"
+#include "obs/obs-governor.hpp"
 #include "obs/obs-source-factory.hpp"
+#include "util/util-tracking.hpp"
 
 // Nvidia
+#include "nvidia/ar/nvidia-ar-feature.hpp"
 #include "nvidia/ar/nvidia-ar.hpp"
 #include "nvidia/cuda/nvidia-cuda-context.hpp"
+#include "nvidia/cuda/nvidia-cuda-event.hpp"
 #include "nvidia/cuda/nvidia-cuda-gs-texture.hpp"
 #include "nvidia/cuda/nvidia-cuda-memory.hpp"
 #include "nvidia/cuda/nvidia-cuda-obs.hpp"
@@ -36,7 +41,57 @@
 #include "nvidia/cuda/nvidia-cuda.hpp"
 
 namespace streamfx::filter::nvidia {
-	class face_tracking_instance : public obs::source_instance {
+	enum class capture_state {
+		Free,       // Not in use, may be captured into.
+		Capturing,  // The render thread is copying a frame into it.
+		Pending,    // Holds a frame that has not been tracked yet.
+		Processing, // The tracking thread is reading from it.
+	};
+
+	struct capture_slot {
+		capture_state                                        state = capture_state::Free;
+		std::shared_ptr<streamfx::obs::gs::texture>          texture;
+		std::shared_ptr<::streamfx::nvidia::cuda::gstexture> texture_cuda; // Mapped while the frame is tracked.
+		std::shared_ptr<::streamfx::nvidia::cuda::event>     ready;        // Recorded once texture_cuda is mapped.
+		NvCVImage                                            image{};      // View of the mapped CUDA array.
+		uint64_t                                             timestamp = 0; // Video time of the frame.
+		NvAR_Rect                                            region{};      // Area of the frame the image covers.
+		std::pair<uint32_t, uint32_t>                        frame;         // Size of that frame, in pixels.
+	};
+
+	// A face followed across detections, so that it keeps its index while others come and go.
+	struct face_track {
+		NvAR_Rect box{};  // In frame pixels, empty while no face is assigned.
+		uint64_t  seen{}; // Video time of the last detection.
+	};
+
+	enum class ar_feature_type : std::size_t {
+		FaceDetection = 0,
+		Landmarks     = 1, // Facial landmarks of the first followed face.
+		BodyPose      = 2,
+	};
+
+	// An NvAR feature shared by all instances, as every feature costs a model load and its own VRAM.
+	struct ar_shared_feature {
+		std::atomic_bool                                 requested{false};
+		std::atomic_bool                                 loaded{false};
+		std::shared_ptr<::streamfx::nvidia::ar::feature> feature;
+		uint32_t                                         points = 0; // Number of points in the output, if any.
+	};
+
+	// All features run on the same stream, so one converted frame is fed through several of them in sequence.
+	struct ar_runtime {
+		std::mutex                                        lock; // Held from converting a frame to its last feature.
+		std::shared_ptr<::streamfx::nvidia::cuda::stream> stream;
+		std::array<ar_shared_feature, 3>                  features;
+
+		ar_shared_feature& get(ar_feature_type type)
+		{
+			return features[static_cast<std::size_t>(type)];
+		}
+	};
+
+	class face_tracking_instance : public obs::source_instance, public obs::degradable {
 		// Filter Cache
 		std::pair<uint32_t, uint32_t>                    _size;
 		bool                                             _rt_is_fresh;
@@ -48,6 +103,13 @@ namespace streamfx::filter::nvidia {
 		double_t                      _cfg_zoom;
 		std::pair<double_t, double_t> _cfg_offset;
 		double_t                      _cfg_stability;
+		double_t                      _cfg_frequency;
+		uint32_t                      _cfg_resolution; // Height of the tracked image, or 0 for the input height.
+		uint32_t                      _cfg_refine;     // Frames tracked around the face between full detections.
+		bool                          _cfg_landmarks;
+		bool                          _cfg_body_pose;
+		uint32_t                      _cfg_faces; // Faces to detect and follow, all published for other sources.
+		bool                          _cfg_apply; // Frame the first face, or pass the source through unchanged.
 
 		// Operational Data
 		std::shared_ptr<streamfx::obs::gs::vertex_buffer> _geometry;
@@ -60,31 +122,48 @@ namespace streamfx::filter::nvidia {
 			double_t   center[2];
 			double_t   size[2];
 			double_t   velocity[2];
+			double_t   detected[2]; // Center of the last detection.
+			double_t   face[4];     // Last detected face as x, y, width and height, or empty if there is none.
+			uint64_t   timestamp;   // Video time of the last detection.
 		} _values;
+		double_t _track_timer; // Seconds since the last frame was submitted for tracking.
 
 		// Nvidia CUDA interop
 		std::shared_ptr<::streamfx::nvidia::cuda::obs>    _cuda;
-		std::shared_ptr<::streamfx::nvidia::cuda::stream> _cuda_stream;
+		std::shared_ptr<::streamfx::nvidia::cuda::stream> _cuda_capture_stream;
 
 		// Nvidia AR interop
 		std::shared_ptr<::streamfx::nvidia::ar::ar>          _ar_library;
-		std::atomic_bool                                     _ar_loaded;
-		std::shared_ptr<nvAR_Feature>                        _ar_feature;
+		std::shared_ptr<ar_runtime>                          _ar_runtime;
 		std::atomic_bool                                     _ar_is_tracking;
+		std::atomic_bool                                     _ar_redetect; // Set once a region lost the face.
+		uint32_t                                             _ar_refined;  // Regions captured since the last detection.
 		std::mutex                                           _ar_lock;
 		std::vector<float_t>                                 _ar_bboxes_confidence;
 		std::vector<NvAR_Rect>                               _ar_bboxes_data;
 		NvAR_BBoxes                                          _ar_bboxes;
-		std::shared_ptr<streamfx::obs::gs::texture>          _ar_texture;
-		bool                                                 _ar_texture_cuda_fresh;
-		std::shared_ptr<::streamfx::nvidia::cuda::gstexture> _ar_texture_cuda;
-		std::shared_ptr<::streamfx::nvidia::cuda::memory>    _ar_texture_cuda_mem;
-		NvCVImage                                            _ar_image;
+		std::vector<NvAR_Point2f>                            _ar_landmarks;
+		std::vector<float_t>                                 _ar_landmarks_confidence;
+		std::vector<NvAR_Point2f>                            _ar_body;
+		std::vector<NvAR_Point3f>                            _ar_body_3d;
+		std::vector<NvAR_Quaternion>                         _ar_body_angles;
+		std::vector<float_t>                                 _ar_body_confidence;
+		std::vector<NvAR_Rect>                               _ar_body_bboxes_data;
+		NvAR_BBoxes                                          _ar_body_bboxes;
 		NvCVImage                                            _ar_image_bgr;
 		NvCVImage                                            _ar_image_temp;
+		std::vector<face_track>                              _ar_tracks;
 
-		// Tasks
-		std::shared_ptr<::streamfx::util::threadpool::task> _async_initialize;
+		// Latest results, shared with other filters on the same source.
+		std::shared_ptr<::streamfx::util::tracking::channel> _tracking_channel;
+		std::shared_ptr<::streamfx::util::tracking::slot>    _tracking;
+
+		// Captured frames, so that one can be copied while the other is tracked.
+		std::shared_ptr<streamfx::obs::gs::rendertarget> _ar_scale_rt;
+		std::mutex                  _ar_slots_lock;
+		std::array<capture_slot, 2> _ar_slots;
+
+		// Tasks, guarded by _ar_slots_lock.
 		std::shared_ptr<::streamfx::util::threadpool::task> _async_track;
 
 #ifdef ENABLE_PROFILING
@@ -94,9 +173,11 @@ namespace streamfx::filter::nvidia {
 		std::shared_ptr<streamfx::util::profiler> _profile_capture_copy;
 		std::shared_ptr<streamfx::util::profiler> _profile_ar_realloc;
 		std::shared_ptr<streamfx::util::profiler> _profile_ar_copy;
+		std::shared_ptr<streamfx::util::profiler> _profile_ar_wait;
 		std::shared_ptr<streamfx::util::profiler> _profile_ar_transfer;
 		std::shared_ptr<streamfx::util::profiler> _profile_ar_run;
 		std::shared_ptr<streamfx::util::profiler> _profile_ar_calc;
+		std::shared_ptr<streamfx::util::profiler> _profile_ar_latency;
 #endif
 
 		public:
@@ -104,10 +185,23 @@ namespace streamfx::filter::nvidia {
 		virtual ~face_tracking_instance() override;
 
 		// Tasks
-		void async_initialize(std::shared_ptr<void> = nullptr);
-
 		void async_track(std::shared_ptr<void> = nullptr);
 
+		void track(capture_slot& slot);
+
+		/** Match the detected faces to the followed ones, by the distance between their centers. */
+		void assign_tracks(const capture_slot& slot);
+
+		/** Move the detection of the first followed face to the front, as landmarks only look at the first one. */
+		void prioritize_primary(const capture_slot& slot);
+
+		bool track_landmarks(ar_shared_feature& feature);
+
+		bool track_body_pose(ar_shared_feature& feature);
+
+		/** Pick up the shared runtime once the SDKs are loaded. */
+		bool acquire_runtime();
+
 		void refresh_geometry();
 
 		void refresh_region_of_interest();
@@ -122,6 +216,8 @@ namespace streamfx::filter::nvidia {
 
 		virtual void video_render(gs_effect_t* effect) override;
 
+		virtual void idle() override;
+
 #ifdef ENABLE_PROFILING
 		bool button_profile(obs_properties_t* props, obs_property_t* property);
 #endif
@@ -131,6 +227,13 @@ namespace streamfx::filter::nvidia {
 		: public obs::source_factory<filter::nvidia::face_tracking_factory, filter::nvidia::face_tracking_instance> {
 		std::shared_ptr<::streamfx::nvidia::cuda::obs> _cuda;
 		std::shared_ptr<::streamfx::nvidia::ar::ar>    _ar;
+		std::mutex                                     _runtime_lock;
+		std::weak_ptr<ar_runtime>                      _runtime;
+
+		// The SDKs take long to load, so they are only loaded in the background once a filter is created.
+		std::mutex       _sdk_lock; // Held while loading.
+		std::atomic_bool _sdk_requested;
+		std::atomic_bool _sdk_loaded; // Set once loading finished, even if it failed.
 
 		public:
 		face_tracking_factory();
@@ -142,8 +245,25 @@ namespace streamfx::filter::nvidia {
 
 		virtual obs_properties_t* get_properties2(filter::nvidia::face_tracking_instance* data) override;
 
+		/** Start loading the SDKs in the background, unless that already happened. */
+		void request_sdk();
+
+		/** Load the SDKs right away, or wait for a load that is already in progress. */
+		bool load_sdk();
+
+		bool is_sdk_loaded();
+
+		bool is_sdk_available();
+
+		std::shared_ptr<::streamfx::nvidia::cuda::obs> get_cuda();
+
 		std::shared_ptr<::streamfx::nvidia::ar::ar> get_ar();
 
+		std::shared_ptr<ar_runtime> get_runtime();
+
+		/** Load a feature into the runtime in the background, unless that already happened. */
+		void request_feature(std::shared_ptr<ar_runtime> runtime, ar_feature_type type);
+
 		public: // Singleton
 		static void initialize();
 
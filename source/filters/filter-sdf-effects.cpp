@@ -19,8 +19,14 @@
 
 #include "filter-sdf-effects.hpp"
 #include "strings.hpp"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
 #include <stdexcept>
+#include "obs/gs/gs-creation-queue.hpp"
 #include "obs/gs/gs-helper.hpp"
+#include "obs/obs-tools.hpp"
 
 #define ST_PREFIX "<filter-sdf-effects> "
 
@@ -96,56 +102,117 @@
 #define ST_KEY_SDF_SCALE "Filter.SDFEffects.SDF.Scale"
 #define ST_I18N_SDF_THRESHOLD "Filter.SDFEffects.SDF.Threshold"
 #define ST_KEY_SDF_THRESHOLD "Filter.SDFEffects.SDF.Threshold"
+#define ST_I18N_SDF_SCALE_AUTOMATIC "Filter.SDFEffects.SDF.Scale.Automatic"
+#define ST_KEY_SDF_SCALE_AUTOMATIC "Filter.SDFEffects.SDF.Scale.Automatic"
+#define ST_I18N_SDF_FORMAT "Filter.SDFEffects.SDF.Format"
+#define ST_KEY_SDF_FORMAT "Filter.SDFEffects.SDF.Format"
+#define ST_I18N_SDF_FORMAT_RGBA32F "Filter.SDFEffects.SDF.Format.RGBA32F"
+#define ST_I18N_SDF_FORMAT_RG16F "Filter.SDFEffects.SDF.Format.RG16F"
+#define ST_I18N_SDF_CACHE "Filter.SDFEffects.SDF.Cache"
+#define ST_KEY_SDF_CACHE "Filter.SDFEffects.SDF.Cache"
+#define ST_I18N_SDF_PRODUCER "Filter.SDFEffects.SDF.Producer"
+#define ST_KEY_SDF_PRODUCER "Filter.SDFEffects.SDF.Producer"
+#define ST_I18N_SDF_PRODUCER_ITERATIVE "Filter.SDFEffects.SDF.Producer.Iterative"
+#define ST_I18N_SDF_PRODUCER_JUMPFLOODING "Filter.SDFEffects.SDF.Producer.JumpFlooding"
+
+// Bits selecting which effects are compiled into a variant of sdf-consumer.effect.
+#define ST_VARIANT_SHADOW_OUTER (1u << 0)
+#define ST_VARIANT_SHADOW_INNER (1u << 1)
+#define ST_VARIANT_GLOW_OUTER (1u << 2)
+#define ST_VARIANT_GLOW_INNER (1u << 3)
+#define ST_VARIANT_OUTLINE (1u << 4)
+
+// The automatic scale keeps the largest effect range at about this many texels, but never goes below the minimum.
+#define ST_AUTOMATIC_RANGE 8.0
+#define ST_AUTOMATIC_SCALE_MINIMUM 0.25
+
+// The iterative producer moves the distance field outwards by this many texels per frame.
+#define ST_ITERATIVE_REACH 3
+// Every texel of the alpha signature covers this many pixels in each direction, see sdf-producer.effect. The four float
+// channels hold two rows of 8 bits each, so this can't grow without changing the effect.
+#define ST_SIGNATURE_BLOCK 8
 
 using namespace streamfx::filter::sdf_effects;
 
 static constexpr std::string_view HELP_URL = "https://github.com/Xaymar/obs-StreamFX/wiki/Filter-SDF-Effects";
 
 sdf_effects_instance::sdf_effects_instance(obs_data_t* settings, obs_source_t* self)
-	: obs::source_instance(settings, self), _source_rendered(false), _sdf_scale(1.0), _sdf_threshold(),
+	: obs::source_instance(settings, self), obs::degradable(1, 2), _created(false), _source_rendered(false),
+	  _sdf_scale(1.0),
+	  _sdf_threshold(), _sdf_producer(sdf_producer::Iterative), _sdf_range(), _sdf_format(GS_RGBA32F),
+	  _sdf_distance_scale(1.0f), _pool(streamfx::obs::gs::rendertarget_pool::instance()), _sdf_cache(), _visible(),
 	  _output_rendered(false), _inner_shadow(false), _inner_shadow_color(), _inner_shadow_range_min(),
 	  _inner_shadow_range_max(), _inner_shadow_offset_x(), _inner_shadow_offset_y(), _outer_shadow(false),
 	  _outer_shadow_color(), _outer_shadow_range_min(), _outer_shadow_range_max(), _outer_shadow_offset_x(),
 	  _outer_shadow_offset_y(), _inner_glow(false), _inner_glow_color(), _inner_glow_width(), _inner_glow_sharpness(),
 	  _inner_glow_sharpness_inv(), _outer_glow(false), _outer_glow_color(), _outer_glow_width(),
 	  _outer_glow_sharpness(), _outer_glow_sharpness_inv(), _outline(false), _outline_color(), _outline_width(),
-	  _outline_offset(), _outline_sharpness(), _outline_sharpness_inv()
+	  _outline_offset(), _outline_sharpness(), _outline_sharpness_inv(), _sdf_degrade_level(0)
 {
-	{
-		auto gctx        = streamfx::obs::gs::context();
-		vec4 transparent = {0, 0, 0, 0};
+#ifdef ENABLE_PROFILING
+	_gpu_timer = streamfx::obs::gs::gpu_timer::get("SDF Effects");
+#endif
 
-		_source_rt = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-		_sdf_write = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE);
-		_sdf_read  = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE);
-		_output_rt = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	// Render targets and effects are created later on the graphics thread, until then the source passes through.
+	if (auto queue = streamfx::obs::gs::creation_queue::get(); queue) {
+		queue->push(this, [this]() { create(); });
+	} else {
+		auto gctx = streamfx::obs::gs::context();
+		create();
+	}
 
-		std::shared_ptr<streamfx::obs::gs::rendertarget> initialize_rts[] = {_source_rt, _sdf_write, _sdf_read,
-																			 _output_rt};
-		for (auto rt : initialize_rts) {
-			auto op = rt->render(1, 1);
-			gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &transparent, 0, 0);
-		}
+	update(settings);
+	enable_idle_tracking();
+	enable_render_sharing();
+	enable_preview_profile();
+	enable_prewarm();
+}
 
-		std::pair<const char*, streamfx::obs::gs::effect&> load_arr[] = {
-			{"effects/sdf/sdf-producer.effect", _sdf_producer_effect},
-			{"effects/sdf/sdf-consumer.effect", _sdf_consumer_effect},
-		};
-		for (auto& kv : load_arr) {
-			auto path = streamfx::data_file_path(kv.first).u8string();
-			try {
-				kv.second = streamfx::obs::gs::effect::create(path);
-			} catch (const std::exception& ex) {
-				DLOG_ERROR(ST_PREFIX "Failed to load effect '%s' (located at '%s') with error(s): %s", kv.first,
-						   path.c_str(), ex.what());
-			}
+sdf_effects_instance::~sdf_effects_instance()
+{
+	if (auto queue = streamfx::obs::gs::creation_queue::get(); queue) {
+		queue->cancel(this);
+	}
+}
+
+void sdf_effects_instance::create()
+{
+	vec4 transparent = {0, 0, 0, 0};
+
+	_source_rt = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	_sdf_write = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE);
+	_sdf_read  = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE);
+	_output_rt = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+
+	_sdf_cache.signature = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA32F, GS_ZS_NONE);
+
+	std::shared_ptr<streamfx::obs::gs::rendertarget> initialize_rts[] = {_source_rt, _sdf_write, _sdf_read, _output_rt};
+	for (auto rt : initialize_rts) {
+		auto op = rt->render(1, 1);
+		gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &transparent, 0, 0);
+	}
+
+	std::pair<const char*, streamfx::obs::gs::effect&> load_arr[] = {
+		{"effects/sdf/sdf-producer.effect", _sdf_producer_effect},
+		{"effects/sdf/sdf-jfa.effect", _sdf_jfa_effect},
+	};
+	for (auto& kv : load_arr) {
+		auto path = streamfx::data_file_path(kv.first);
+		try {
+			kv.second = streamfx::obs::gs::effect::create_shared(path);
+		} catch (const std::exception& ex) {
+			DLOG_ERROR(ST_PREFIX "Failed to load effect '%s' (located at '%s') with error(s): %s", kv.first,
+					   path.u8string().c_str(), ex.what());
 		}
 	}
 
-	update(settings);
-}
+	// In the order of the ST_VARIANT_ bits, see sdf-consumer.effect.
+	_sdf_consumer = streamfx::obs::gs::effect_permutations(
+		streamfx::data_file_path("effects/sdf/sdf-consumer.effect"),
+		{"SDF_SHADOW_OUTER", "SDF_SHADOW_INNER", "SDF_GLOW_OUTER", "SDF_GLOW_INNER", "SDF_OUTLINE"});
 
-sdf_effects_instance::~sdf_effects_instance() {}
+	_created = true;
+}
 
 void sdf_effects_instance::load(obs_data_t* settings)
 {
@@ -289,6 +356,60 @@ void sdf_effects_instance::update(obs_data_t* data)
 
 	_sdf_scale     = double_t(obs_data_get_double(data, ST_KEY_SDF_SCALE) / 100.0);
 	_sdf_threshold = float_t(obs_data_get_double(data, ST_KEY_SDF_THRESHOLD) / 100.0);
+	_sdf_producer  = static_cast<sdf_producer>(obs_data_get_int(data, ST_KEY_SDF_PRODUCER));
+	_sdf_format    = static_cast<gs_color_format>(obs_data_get_int(data, ST_KEY_SDF_FORMAT));
+	if ((_sdf_format != GS_RGBA32F) && (_sdf_format != GS_RG16F)) {
+		_sdf_format = GS_RGBA32F;
+	}
+
+	// Furthest distance any of the enabled effects looks at, everything beyond it may stay unresolved.
+	_sdf_range = 1.0f;
+	if (_outer_shadow) {
+		_sdf_range = std::max({_sdf_range, std::abs(_outer_shadow_range_min), std::abs(_outer_shadow_range_max)});
+	}
+	if (_inner_shadow) {
+		_sdf_range = std::max({_sdf_range, std::abs(_inner_shadow_range_min), std::abs(_inner_shadow_range_max)});
+	}
+	if (_outer_glow) {
+		_sdf_range = std::max(_sdf_range, _outer_glow_width);
+	}
+	if (_inner_glow) {
+		_sdf_range = std::max(_sdf_range, _inner_glow_width);
+	}
+	if (_outline) {
+		_sdf_range = std::max(_sdf_range, _outline_width + std::abs(_outline_offset));
+	}
+
+	// Large ranges do not need a texel for every source pixel. The automatic scale picks the smallest distance
+	// field that still resolves them, and converts all distances from source pixels into its texels.
+	if (obs_data_get_bool(data, ST_KEY_SDF_SCALE_AUTOMATIC)) {
+		_sdf_scale          = std::clamp(ST_AUTOMATIC_RANGE / double_t(_sdf_range), ST_AUTOMATIC_SCALE_MINIMUM, 1.0);
+		_sdf_distance_scale = float_t(_sdf_scale);
+	} else {
+		_sdf_distance_scale = 1.0f;
+	}
+	_sdf_range *= _sdf_distance_scale;
+
+	_sdf_cache.enabled = obs_data_get_bool(data, ST_KEY_SDF_CACHE);
+	_sdf_cache.valid   = false;
+}
+
+void sdf_effects_instance::idle()
+{
+	if (!_created) {
+		return;
+	}
+
+	// Back to the state after construction, the next render resizes everything again.
+	vec4 transparent = {0, 0, 0, 0};
+	for (auto rt : {_source_rt, _sdf_write, _sdf_read, _output_rt}) {
+		auto op = rt->render(1, 1);
+		gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &transparent, 0, 0);
+	}
+	_source_texture.reset();
+	_sdf_texture.reset();
+	_output_texture.reset();
+	_sdf_cache.valid = false;
 }
 
 void sdf_effects_instance::video_tick(float_t)
@@ -296,19 +417,28 @@ void sdf_effects_instance::video_tick(float_t)
 	if (obs_source_t* target = obs_filter_get_target(_self); target != nullptr) {
 		_source_rendered = false;
 		_output_rendered = false;
+
+		// Cropped or partly off-canvas sources only need the part that is actually shown.
+		uint32_t region[4];
+		bool     known = streamfx::obs::tools::visible_region(_self, obs_source_get_base_width(target),
+															  obs_source_get_base_height(target), region);
+		if ((known != _visible.known) || (known && !std::equal(region, region + 4, _visible.region))) {
+			_visible.known = known;
+			std::copy(region, region + 4, _visible.region);
+			_sdf_cache.valid = false;
+		}
 	}
 }
 
 void sdf_effects_instance::video_render(gs_effect_t* effect)
 {
-	obs_source_t* parent         = obs_filter_get_parent(_self);
-	obs_source_t* target         = obs_filter_get_target(_self);
-	uint32_t      baseW          = obs_source_get_base_width(target);
-	uint32_t      baseH          = obs_source_get_base_height(target);
-	gs_effect_t*  final_effect   = effect ? effect : obs_get_base_effect(obs_base_effect::OBS_EFFECT_DEFAULT);
-	gs_effect_t*  default_effect = obs_get_base_effect(obs_base_effect::OBS_EFFECT_DEFAULT);
-
-	if (!_self || !parent || !target || !baseW || !baseH || !final_effect) {
+	obs_source_t* parent       = obs_filter_get_parent(_self);
+	obs_source_t* target       = obs_filter_get_target(_self);
+	uint32_t      baseW        = obs_source_get_base_width(target);
+	uint32_t      baseH        = obs_source_get_base_height(target);
+	gs_effect_t*  final_effect = effect ? effect : obs_get_base_effect(obs_base_effect::OBS_EFFECT_DEFAULT);
+
+	if (!_created || !_self || !parent || !target || !baseW || !baseH || !final_effect) {
 		obs_source_skip_video_filter(_self);
 		return;
 	}
@@ -316,11 +446,37 @@ void sdf_effects_instance::video_render(gs_effect_t* effect)
 #ifdef ENABLE_PROFILING
 	streamfx::obs::gs::debug_marker gdmp{streamfx::obs::gs::debug_color_source, "SDF Effects '%s' on '%s'",
 										 obs_source_get_name(_self), obs_source_get_name(obs_filter_get_parent(_self))};
+
+	streamfx::obs::gs::gpu_timer::scope gpt{_gpu_timer};
 #endif
 
 	auto gctx              = streamfx::obs::gs::context();
 	vec4 color_transparent = {0, 0, 0, 0};
 
+	// Everything is processed in the visible part of the source only, padded by the furthest any effect reaches.
+	uint32_t area[4] = {0, 0, baseW, baseH};
+	if (_visible.known) {
+		float_t  offset = std::max({std::abs(_outer_shadow_offset_x), std::abs(_outer_shadow_offset_y),
+									std::abs(_inner_shadow_offset_x), std::abs(_inner_shadow_offset_y)});
+		uint32_t pad    = static_cast<uint32_t>(std::ceil(_sdf_range + offset)) + 2;
+		area[0]         = (_visible.region[0] > pad) ? (_visible.region[0] - pad) : 0;
+		area[1]         = (_visible.region[1] > pad) ? (_visible.region[1] - pad) : 0;
+		area[2]         = std::min(_visible.region[2] + pad, baseW);
+		area[3]         = std::min(_visible.region[3] + pad, baseH);
+	}
+	uint32_t areaW = area[2] - area[0];
+	uint32_t areaH = area[3] - area[1];
+
+	// The governor may ask for a distance field at a lower resolution, which also shrinks all distances in it. The
+	// same is good enough while nothing shows this in program.
+	uint32_t level          = degrade_level(is_preview_render());
+	double_t degrade        = 1. / double_t(uint32_t(1) << level);
+	float_t  distance_scale = _sdf_distance_scale * float_t(degrade);
+	if (level != _sdf_degrade_level) {
+		_sdf_degrade_level = level;
+		_sdf_cache.valid   = false;
+	}
+
 	try {
 		gs_blend_state_push();
 		gs_reset_blend_state();
@@ -343,8 +499,9 @@ void sdf_effects_instance::video_render(gs_effect_t* effect)
 				streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_cache, "Cache"};
 #endif
 
-				auto op = _source_rt->render(baseW, baseH);
-				gs_ortho(0, static_cast<float>(baseW), 0, static_cast<float>(baseH), -1, 1);
+				auto op = _source_rt->render(areaW, areaH);
+				gs_ortho(static_cast<float>(area[0]), static_cast<float>(area[2]), static_cast<float>(area[1]),
+						 static_cast<float>(area[3]), -1, 1);
 				gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &color_transparent, 0, 0);
 
 				if (obs_source_process_filter_begin(_self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
@@ -360,19 +517,10 @@ void sdf_effects_instance::video_render(gs_effect_t* effect)
 
 			// Generate SDF Buffers
 			{
-				_sdf_read->get_texture(_sdf_texture);
-				if (!_sdf_texture) {
-					throw std::runtime_error("SDF Backbuffer empty");
-				}
-
-				if (!_sdf_producer_effect) {
-					throw std::runtime_error("SDF Effect no loaded");
-				}
-
 				// Scale SDF Size
 				double_t sdfW, sdfH;
-				sdfW = baseW * _sdf_scale;
-				sdfH = baseH * _sdf_scale;
+				sdfW = areaW * _sdf_scale * degrade;
+				sdfH = areaH * _sdf_scale * degrade;
 				if (sdfW <= 1) {
 					sdfW = 1.0;
 				}
@@ -380,29 +528,21 @@ void sdf_effects_instance::video_render(gs_effect_t* effect)
 					sdfH = 1.0;
 				}
 
-				{
-#ifdef ENABLE_PROFILING
-					streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_convert,
-														"Update Distance Field"};
-#endif
-
-					auto op = _sdf_write->render(uint32_t(sdfW), uint32_t(sdfH));
-					gs_ortho(0, 1, 0, 1, -1, 1);
-					gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &color_transparent, 0, 0);
-
-					_sdf_producer_effect.get_parameter("_image").set_texture(_source_texture);
-					_sdf_producer_effect.get_parameter("_size").set_float2(float_t(sdfW), float_t(sdfH));
-					_sdf_producer_effect.get_parameter("_sdf").set_texture(_sdf_texture);
-					_sdf_producer_effect.get_parameter("_threshold").set_float(_sdf_threshold);
-
-					while (gs_effect_loop(_sdf_producer_effect.get_object(), "Draw")) {
-						streamfx::gs_draw_fullscreen_tri();
+				// Rebuilding the distance field costs far more than comparing the alpha mask, so skip it while the
+				// mask stays the same. The iterative producer still needs a few frames more to finish converging.
+				bool unchanged = _sdf_cache.enabled && is_source_unchanged(areaW, areaH);
+				if (!unchanged || !_sdf_cache.valid) {
+					_sdf_cache.pending = 1;
+					if (_sdf_producer == sdf_producer::Iterative) {
+						_sdf_cache.pending +=
+							static_cast<std::size_t>(std::ceil(_sdf_range * degrade / ST_ITERATIVE_REACH));
 					}
+					_sdf_cache.valid = true;
 				}
-				std::swap(_sdf_read, _sdf_write);
-				_sdf_read->get_texture(_sdf_texture);
-				if (!_sdf_texture) {
-					throw std::runtime_error("SDF Backbuffer empty");
+
+				if (_sdf_cache.pending > 0) {
+					generate_sdf(_sdf_producer, uint32_t(sdfW), uint32_t(sdfH));
+					_sdf_cache.pending--;
 				}
 			}
 
@@ -419,116 +559,90 @@ void sdf_effects_instance::video_render(gs_effect_t* effect)
 	if (!_output_rendered) {
 		_output_texture = _source_texture;
 
-		if (!_sdf_consumer_effect) {
-			obs_source_skip_video_filter(_self);
-			return;
-		}
-
-		gs_blend_state_push();
-		gs_reset_blend_state();
-		gs_enable_color(true, true, true, true);
-		gs_enable_depth_test(false);
-		gs_set_cull_mode(GS_NEITHER);
+		uint32_t variant = 0;
+		variant |= _outer_shadow ? ST_VARIANT_SHADOW_OUTER : 0;
+		variant |= _inner_shadow ? ST_VARIANT_SHADOW_INNER : 0;
+		variant |= _outer_glow ? ST_VARIANT_GLOW_OUTER : 0;
+		variant |= _inner_glow ? ST_VARIANT_GLOW_INNER : 0;
+		variant |= _outline ? ST_VARIANT_OUTLINE : 0;
+
+		// Without any effects, the source is passed through as is.
+		if (variant != 0) {
+			auto& consumer = get_consumer_effect(variant);
+			if (!consumer.effect) {
+				obs_source_skip_video_filter(_self);
+				return;
+			}
 
-		// SDF Effects Stack:
-		//   Normal Source
-		//   Outer Shadow
-		//   Inner Shadow
-		//   Outer Glow
-		//   Inner Glow
-		//   Outline
+			gs_blend_state_push();
+			gs_reset_blend_state();
+			gs_enable_blending(false);
+			gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+			gs_enable_color(true, true, true, true);
+			gs_enable_depth_test(false);
+			gs_set_cull_mode(GS_NEITHER);
 
-		// Optimized Render path.
-		try {
+			// All enabled effects are stacked on top of the source in a single pass, see sdf-consumer.effect.
+			try {
 #ifdef ENABLE_PROFILING
-			streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_convert, "Calculate"};
+				streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_convert, "Calculate"};
 #endif
 
-			auto op = _output_rt->render(baseW, baseH);
-			gs_ortho(0, 1, 0, 1, 0, 1);
-
-			gs_enable_blending(false);
-			gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
-			auto param = gs_effect_get_param_by_name(default_effect, "image");
-			if (param) {
-				gs_effect_set_texture(param, _output_texture->get_object());
-			}
-			while (gs_effect_loop(default_effect, "Draw")) {
-				streamfx::gs_draw_fullscreen_tri();
-			}
-
-			gs_enable_blending(true);
-			gs_blend_function_separate(GS_BLEND_SRCALPHA, GS_BLEND_INVSRCALPHA, GS_BLEND_ONE, GS_BLEND_ONE);
-			if (_outer_shadow) {
-				_sdf_consumer_effect.get_parameter("pSDFTexture").set_texture(_sdf_texture);
-				_sdf_consumer_effect.get_parameter("pSDFThreshold").set_float(_sdf_threshold);
-				_sdf_consumer_effect.get_parameter("pImageTexture").set_texture(_source_texture->get_object());
-				_sdf_consumer_effect.get_parameter("pShadowColor").set_float4(_outer_shadow_color);
-				_sdf_consumer_effect.get_parameter("pShadowMin").set_float(_outer_shadow_range_min);
-				_sdf_consumer_effect.get_parameter("pShadowMax").set_float(_outer_shadow_range_max);
-				_sdf_consumer_effect.get_parameter("pShadowOffset")
-					.set_float2(_outer_shadow_offset_x / float_t(baseW), _outer_shadow_offset_y / float_t(baseH));
-				while (gs_effect_loop(_sdf_consumer_effect.get_object(), "ShadowOuter")) {
-					streamfx::gs_draw_fullscreen_tri();
+				auto  op     = _output_rt->render(areaW, areaH);
+				auto& params = consumer.parameters;
+				gs_ortho(0, 1, 0, 1, 0, 1);
+
+				params[SDF_TEXTURE].set_texture(_sdf_texture);
+				params[SDF_THRESHOLD].set_float(_sdf_threshold);
+				params[IMAGE_TEXTURE].set_texture(_source_texture->get_object());
+				if (_outer_shadow) {
+					params[SHADOW_OUTER_COLOR].set_float4(_outer_shadow_color);
+					params[SHADOW_OUTER_MIN].set_float(_outer_shadow_range_min * distance_scale);
+					params[SHADOW_OUTER_MAX].set_float(_outer_shadow_range_max * distance_scale);
+					params[SHADOW_OUTER_OFFSET]
+						.set_float2(_outer_shadow_offset_x / float_t(areaW), _outer_shadow_offset_y / float_t(areaH));
 				}
-			}
-			if (_inner_shadow) {
-				_sdf_consumer_effect.get_parameter("pSDFTexture").set_texture(_sdf_texture);
-				_sdf_consumer_effect.get_parameter("pSDFThreshold").set_float(_sdf_threshold);
-				_sdf_consumer_effect.get_parameter("pImageTexture").set_texture(_source_texture->get_object());
-				_sdf_consumer_effect.get_parameter("pShadowColor").set_float4(_inner_shadow_color);
-				_sdf_consumer_effect.get_parameter("pShadowMin").set_float(_inner_shadow_range_min);
-				_sdf_consumer_effect.get_parameter("pShadowMax").set_float(_inner_shadow_range_max);
-				_sdf_consumer_effect.get_parameter("pShadowOffset")
-					.set_float2(_inner_shadow_offset_x / float_t(baseW), _inner_shadow_offset_y / float_t(baseH));
-				while (gs_effect_loop(_sdf_consumer_effect.get_object(), "ShadowInner")) {
-					streamfx::gs_draw_fullscreen_tri();
+				if (_inner_shadow) {
+					params[SHADOW_INNER_COLOR].set_float4(_inner_shadow_color);
+					params[SHADOW_INNER_MIN].set_float(_inner_shadow_range_min * distance_scale);
+					params[SHADOW_INNER_MAX].set_float(_inner_shadow_range_max * distance_scale);
+					params[SHADOW_INNER_OFFSET]
+						.set_float2(_inner_shadow_offset_x / float_t(areaW), _inner_shadow_offset_y / float_t(areaH));
 				}
-			}
-			if (_outer_glow) {
-				_sdf_consumer_effect.get_parameter("pSDFTexture").set_texture(_sdf_texture);
-				_sdf_consumer_effect.get_parameter("pSDFThreshold").set_float(_sdf_threshold);
-				_sdf_consumer_effect.get_parameter("pImageTexture").set_texture(_source_texture->get_object());
-				_sdf_consumer_effect.get_parameter("pGlowColor").set_float4(_outer_glow_color);
-				_sdf_consumer_effect.get_parameter("pGlowWidth").set_float(_outer_glow_width);
-				_sdf_consumer_effect.get_parameter("pGlowSharpness").set_float(_outer_glow_sharpness);
-				_sdf_consumer_effect.get_parameter("pGlowSharpnessInverse").set_float(_outer_glow_sharpness_inv);
-				while (gs_effect_loop(_sdf_consumer_effect.get_object(), "GlowOuter")) {
-					streamfx::gs_draw_fullscreen_tri();
+				if (_outer_glow) {
+					params[GLOW_OUTER_COLOR].set_float4(_outer_glow_color);
+					params[GLOW_OUTER_WIDTH].set_float(_outer_glow_width * distance_scale);
+					params[GLOW_OUTER_SHARPNESS].set_float(_outer_glow_sharpness);
+					params[GLOW_OUTER_SHARPNESS_INVERSE].set_float(_outer_glow_sharpness_inv);
 				}
-			}
-			if (_inner_glow) {
-				_sdf_consumer_effect.get_parameter("pSDFTexture").set_texture(_sdf_texture);
-				_sdf_consumer_effect.get_parameter("pSDFThreshold").set_float(_sdf_threshold);
-				_sdf_consumer_effect.get_parameter("pImageTexture").set_texture(_source_texture->get_object());
-				_sdf_consumer_effect.get_parameter("pGlowColor").set_float4(_inner_glow_color);
-				_sdf_consumer_effect.get_parameter("pGlowWidth").set_float(_inner_glow_width);
-				_sdf_consumer_effect.get_parameter("pGlowSharpness").set_float(_inner_glow_sharpness);
-				_sdf_consumer_effect.get_parameter("pGlowSharpnessInverse").set_float(_inner_glow_sharpness_inv);
-				while (gs_effect_loop(_sdf_consumer_effect.get_object(), "GlowInner")) {
-					streamfx::gs_draw_fullscreen_tri();
+				if (_inner_glow) {
+					params[GLOW_INNER_COLOR].set_float4(_inner_glow_color);
+					params[GLOW_INNER_WIDTH].set_float(_inner_glow_width * distance_scale);
+					params[GLOW_INNER_SHARPNESS].set_float(_inner_glow_sharpness);
+					params[GLOW_INNER_SHARPNESS_INVERSE].set_float(_inner_glow_sharpness_inv);
 				}
-			}
-			if (_outline) {
-				_sdf_consumer_effect.get_parameter("pSDFTexture").set_texture(_sdf_texture);
-				_sdf_consumer_effect.get_parameter("pSDFThreshold").set_float(_sdf_threshold);
-				_sdf_consumer_effect.get_parameter("pImageTexture").set_texture(_source_texture->get_object());
-				_sdf_consumer_effect.get_parameter("pOutlineColor").set_float4(_outline_color);
-				_sdf_consumer_effect.get_parameter("pOutlineWidth").set_float(_outline_width);
-				_sdf_consumer_effect.get_parameter("pOutlineOffset").set_float(_outline_offset);
-				_sdf_consumer_effect.get_parameter("pOutlineSharpness").set_float(_outline_sharpness);
-				_sdf_consumer_effect.get_parameter("pOutlineSharpnessInverse").set_float(_outline_sharpness_inv);
-				while (gs_effect_loop(_sdf_consumer_effect.get_object(), "Outline")) {
+				if (_outline) {
+					params[OUTLINE_COLOR].set_float4(_outline_color);
+					params[OUTLINE_WIDTH].set_float(_outline_width * distance_scale);
+					params[OUTLINE_OFFSET].set_float(_outline_offset * distance_scale);
+					params[OUTLINE_SHARPNESS].set_float(_outline_sharpness);
+					params[OUTLINE_SHARPNESS_INVERSE].set_float(_outline_sharpness_inv);
+				}
+				while (gs_effect_loop(consumer.effect.get_object(), "Composite")) {
 					streamfx::gs_draw_fullscreen_tri();
 				}
+			} catch (...) {
 			}
-		} catch (...) {
-		}
 
-		_output_rt->get_texture(_output_texture);
+			_output_rt->get_texture(_output_texture);
 
-		gs_blend_state_pop();
+			gs_blend_state_pop();
+		}
 		_output_rendered = true;
+
+		_statistics->set_video_memory(streamfx::obs::statistics::texture_memory(_source_texture)
+									  + streamfx::obs::statistics::texture_memory(_sdf_texture)
+									  + streamfx::obs::statistics::texture_memory(_output_texture));
 	}
 
 	if (!_output_texture) {
@@ -545,12 +659,201 @@ void sdf_effects_instance::video_render(gs_effect_t* effect)
 		if (ep) {
 			gs_effect_set_texture(ep, _output_texture->get_object());
 		}
+		gs_matrix_push();
+		gs_matrix_translate3f(static_cast<float>(area[0]), static_cast<float>(area[1]), 0.);
 		while (gs_effect_loop(final_effect, "Draw")) {
-			gs_draw_sprite(0, 0, baseW, baseH);
+			gs_draw_sprite(0, 0, areaW, areaH);
 		}
+		gs_matrix_pop();
 	}
 }
 
+std::size_t sdf_effects_instance::generate_sdf(sdf_producer producer, uint32_t width, uint32_t height)
+{
+	vec4        color_transparent = {0, 0, 0, 0};
+	std::size_t passes            = 0;
+
+#ifdef ENABLE_PROFILING
+	streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_convert, "Update Distance Field"};
+#endif
+
+	if (_sdf_write->get_color_format() != _sdf_format) {
+		_sdf_write = std::make_shared<streamfx::obs::gs::rendertarget>(_sdf_format, GS_ZS_NONE);
+		_sdf_read  = std::make_shared<streamfx::obs::gs::rendertarget>(_sdf_format, GS_ZS_NONE);
+		for (auto rt : {_sdf_write, _sdf_read}) {
+			auto op = rt->render(1, 1);
+			gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &color_transparent, 0, 0);
+		}
+	}
+
+	if (producer == sdf_producer::JumpFlooding) {
+		if (!_sdf_jfa_effect) {
+			throw std::runtime_error("SDF Effect no loaded");
+		}
+
+		// Seeds within twice the initial step size are found, so the pass count only depends on the range.
+		uint32_t step = 1;
+		while ((step < _sdf_range) && (step < std::max(width, height))) {
+			step <<= 1;
+		}
+
+		auto read  = _pool->acquire(width, height, GS_RGBA32F);
+		auto write = _pool->acquire(width, height, GS_RGBA32F);
+
+		_sdf_jfa_effect.get_parameter("_image").set_texture(_source_texture);
+		_sdf_jfa_effect.get_parameter("_size").set_float2(float_t(width), float_t(height));
+		_sdf_jfa_effect.get_parameter("_threshold").set_float(_sdf_threshold);
+		_sdf_jfa_effect.get_parameter("_jfa").set_texture(static_cast<gs_texture_t*>(nullptr));
+
+		{
+			auto op = write->render(width, height);
+			gs_ortho(0, 1, 0, 1, -1, 1);
+			while (gs_effect_loop(_sdf_jfa_effect.get_object(), "Seed")) {
+				streamfx::gs_draw_fullscreen_tri();
+			}
+		}
+		std::swap(read, write);
+
+		for (; step > 0; step >>= 1, passes++) {
+			{
+				auto op = write->render(width, height);
+				gs_ortho(0, 1, 0, 1, -1, 1);
+				_sdf_jfa_effect.get_parameter("_jfa").set_texture(read->get_texture());
+				_sdf_jfa_effect.get_parameter("_step").set_float(float_t(step));
+				while (gs_effect_loop(_sdf_jfa_effect.get_object(), "Step")) {
+					streamfx::gs_draw_fullscreen_tri();
+				}
+			}
+			std::swap(read, write);
+		}
+
+		{
+			auto op = _sdf_write->render(width, height);
+			gs_ortho(0, 1, 0, 1, -1, 1);
+			_sdf_jfa_effect.get_parameter("_jfa").set_texture(read->get_texture());
+			while (gs_effect_loop(_sdf_jfa_effect.get_object(), "Resolve")) {
+				streamfx::gs_draw_fullscreen_tri();
+			}
+		}
+	} else {
+		if (!_sdf_producer_effect) {
+			throw std::runtime_error("SDF Effect no loaded");
+		}
+
+		_sdf_read->get_texture(_sdf_texture);
+		if (!_sdf_texture) {
+			throw std::runtime_error("SDF Backbuffer empty");
+		}
+
+		{
+			auto op = _sdf_write->render(width, height);
+			gs_ortho(0, 1, 0, 1, -1, 1);
+			gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &color_transparent, 0, 0);
+
+			_sdf_producer_effect.get_parameter("_image").set_texture(_source_texture);
+			_sdf_producer_effect.get_parameter("_size").set_float2(float_t(width), float_t(height));
+			_sdf_producer_effect.get_parameter("_sdf").set_texture(_sdf_texture);
+			_sdf_producer_effect.get_parameter("_threshold").set_float(_sdf_threshold);
+
+			while (gs_effect_loop(_sdf_producer_effect.get_object(), "Draw")) {
+				streamfx::gs_draw_fullscreen_tri();
+			}
+		}
+		passes = 1;
+	}
+
+	std::swap(_sdf_read, _sdf_write);
+	_sdf_read->get_texture(_sdf_texture);
+	if (!_sdf_texture) {
+		throw std::runtime_error("SDF Backbuffer empty");
+	}
+
+	return passes;
+}
+
+sdf_effects_instance::consumer_effect& sdf_effects_instance::get_consumer_effect(uint32_t variant)
+{
+	if (auto found = _sdf_consumer_effects.find(variant); found != _sdf_consumer_effects.end()) {
+		return found->second;
+	}
+
+	// Failed variants are remembered as well, so that they are not compiled again every frame.
+	consumer_effect consumer;
+	try {
+		consumer.effect = _sdf_consumer.get(variant);
+
+		// Parameters are resolved once here, instead of by name on every frame.
+		consumer.parameters = {consumer.effect,
+							   {"pSDFTexture", "pSDFThreshold", "pImageTexture", "pShadowOuterColor", "pShadowOuterMin",
+							    "pShadowOuterMax", "pShadowOuterOffset", "pShadowInnerColor", "pShadowInnerMin",
+							    "pShadowInnerMax", "pShadowInnerOffset", "pGlowOuterColor", "pGlowOuterWidth",
+							    "pGlowOuterSharpness", "pGlowOuterSharpnessInverse", "pGlowInnerColor",
+							    "pGlowInnerWidth", "pGlowInnerSharpness", "pGlowInnerSharpnessInverse", "pOutlineColor",
+							    "pOutlineWidth", "pOutlineOffset", "pOutlineSharpness", "pOutlineSharpnessInverse"}};
+	} catch (const std::exception& ex) {
+		DLOG_ERROR(ST_PREFIX "Failed to load variant %" PRIu32 " of effect '%s' with error(s): %s", variant,
+				   "effects/sdf/sdf-consumer.effect", ex.what());
+	}
+	return _sdf_consumer_effects.emplace(variant, consumer).first->second;
+}
+
+bool sdf_effects_instance::is_source_unchanged(uint32_t width, uint32_t height)
+{
+	if (!_sdf_producer_effect) {
+		return false;
+	}
+
+	uint32_t sig_width  = (width + ST_SIGNATURE_BLOCK - 1) / ST_SIGNATURE_BLOCK;
+	uint32_t sig_height = (height + ST_SIGNATURE_BLOCK - 1) / ST_SIGNATURE_BLOCK;
+	if ((_sdf_cache.width != sig_width) || (_sdf_cache.height != sig_height)) {
+		_sdf_cache.readback.reset();
+		_sdf_cache.width  = sig_width;
+		_sdf_cache.height = sig_height;
+		_sdf_cache.frame  = 0;
+	}
+
+	{
+		auto op = _sdf_cache.signature->render(sig_width, sig_height);
+		gs_ortho(0, 1, 0, 1, -1, 1);
+
+		_sdf_producer_effect.get_parameter("_image").set_texture(_source_texture);
+		_sdf_producer_effect.get_parameter("_image_size").set_float2(float_t(width), float_t(height));
+		_sdf_producer_effect.get_parameter("_signature_size").set_float2(float_t(sig_width), float_t(sig_height));
+		_sdf_producer_effect.get_parameter("_threshold").set_float(_sdf_threshold);
+		while (gs_effect_loop(_sdf_producer_effect.get_object(), "Signature")) {
+			streamfx::gs_draw_fullscreen_tri();
+		}
+	}
+
+	// The signature is read back a frame later, mapping it right away would stall until the GPU caught up.
+	_sdf_cache.readback.stage(_sdf_cache.signature->get_object(),
+							  [this](const uint8_t* ptr, uint32_t stride, uint32_t cols, uint32_t rows) {
+								  if (!ptr) {
+									  _sdf_cache.changed = true;
+									  return;
+								  }
+
+								  // The signature is the mask itself, so comparing it to the last one can't miss a change.
+								  size_t line = static_cast<size_t>(cols) * 4 * sizeof(float_t);
+								  bool   same = (_sdf_cache.last.size() == line * rows);
+								  _sdf_cache.last.resize(line * rows);
+								  for (uint32_t y = 0; y < rows; y++) {
+									  const uint8_t* row  = ptr + static_cast<size_t>(y) * stride;
+									  uint8_t*       last = _sdf_cache.last.data() + line * y;
+									  if (same && (memcmp(last, row, line) != 0)) {
+										  same = false;
+									  }
+									  memcpy(last, row, line);
+								  }
+
+								  _sdf_cache.changed = (_sdf_cache.frame < 2) || !same;
+							  });
+	_sdf_cache.frame++;
+
+	// A change is only seen one frame late, so the previous distance field is used for at most one frame too long.
+	return (_sdf_cache.frame > 2) && !_sdf_cache.changed;
+}
+
 sdf_effects_factory::sdf_effects_factory()
 {
 	_info.id           = S_PREFIX "filter-sdf-effects";
@@ -606,8 +909,19 @@ void sdf_effects_factory::get_defaults2(obs_data_t* data)
 	obs_data_set_default_double(data, ST_KEY_OUTLINE_OFFSET, 0.0);
 	obs_data_set_default_double(data, ST_KEY_OUTLINE_SHARPNESS, 50.0);
 
+	obs_data_set_default_bool(data, ST_KEY_SDF_SCALE_AUTOMATIC, false);
 	obs_data_set_default_double(data, ST_KEY_SDF_SCALE, 100.0);
+	obs_data_set_default_int(data, ST_KEY_SDF_FORMAT, GS_RGBA32F);
 	obs_data_set_default_double(data, ST_KEY_SDF_THRESHOLD, 50.0);
+	obs_data_set_default_int(data, ST_KEY_SDF_PRODUCER, static_cast<int64_t>(sdf_producer::Iterative));
+	obs_data_set_default_bool(data, ST_KEY_SDF_CACHE, true);
+}
+
+static bool modified_scale_automatic(obs_properties_t* props, obs_property_t*, obs_data_t* settings) noexcept
+{
+	obs_property_set_visible(obs_properties_get(props, ST_KEY_SDF_SCALE),
+							 !obs_data_get_bool(settings, ST_KEY_SDF_SCALE_AUTOMATIC));
+	return true;
 }
 
 obs_properties_t* sdf_effects_factory::get_properties2(sdf_effects_instance* data)
@@ -702,8 +1016,22 @@ obs_properties_t* sdf_effects_factory::get_properties2(sdf_effects_instance* dat
 		auto pr = obs_properties_create();
 		obs_properties_add_group(prs, S_ADVANCED, D_TRANSLATE(S_ADVANCED), OBS_GROUP_NORMAL, pr);
 
+		p = obs_properties_add_bool(pr, ST_KEY_SDF_SCALE_AUTOMATIC, D_TRANSLATE(ST_I18N_SDF_SCALE_AUTOMATIC));
+		obs_property_set_modified_callback(p, modified_scale_automatic);
 		obs_properties_add_float_slider(pr, ST_KEY_SDF_SCALE, D_TRANSLATE(ST_I18N_SDF_SCALE), 0.1, 500.0, 0.1);
+		p = obs_properties_add_list(pr, ST_KEY_SDF_FORMAT, D_TRANSLATE(ST_I18N_SDF_FORMAT), OBS_COMBO_TYPE_LIST,
+									OBS_COMBO_FORMAT_INT);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_SDF_FORMAT_RGBA32F), GS_RGBA32F);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_SDF_FORMAT_RG16F), GS_RG16F);
 		obs_properties_add_float_slider(pr, ST_KEY_SDF_THRESHOLD, D_TRANSLATE(ST_I18N_SDF_THRESHOLD), 0.0, 100.0, 0.01);
+
+		p = obs_properties_add_list(pr, ST_KEY_SDF_PRODUCER, D_TRANSLATE(ST_I18N_SDF_PRODUCER), OBS_COMBO_TYPE_LIST,
+									OBS_COMBO_FORMAT_INT);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_SDF_PRODUCER_ITERATIVE),
+								  static_cast<int64_t>(sdf_producer::Iterative));
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_SDF_PRODUCER_JUMPFLOODING),
+								  static_cast<int64_t>(sdf_producer::JumpFlooding));
+		obs_properties_add_bool(pr, ST_KEY_SDF_CACHE, D_TRANSLATE(ST_I18N_SDF_CACHE));
 	}
 
 	return prs;
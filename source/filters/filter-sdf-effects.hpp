@@ -19,17 +19,65 @@
 
 #pragma once
 #include "common.hpp"
+#include <map>
+#include <vector>
 #include "obs/gs/gs-effect.hpp"
+#include "obs/gs/gs-readback.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-sampler.hpp"
 #include "obs/gs/gs-texture.hpp"
+#include "obs/gs/gs-timer.hpp"
 #include "obs/gs/gs-vertexbuffer.hpp"
+#include "obs/obs-governor.hpp"
 #include "obs/obs-source-factory.hpp"
 
 namespace streamfx::filter::sdf_effects {
-	class sdf_effects_instance : public obs::source_instance {
+	enum class sdf_producer : int64_t {
+		Iterative    = 0,
+		JumpFlooding = 1,
+	};
+
+	class sdf_effects_instance : public obs::source_instance, public obs::degradable {
 		streamfx::obs::gs::effect _sdf_producer_effect;
-		streamfx::obs::gs::effect _sdf_consumer_effect;
+		streamfx::obs::gs::effect _sdf_jfa_effect;
+
+		// Variants of the consumer, by the set of effects compiled into them.
+		enum consumer_parameter {
+			SDF_TEXTURE,
+			SDF_THRESHOLD,
+			IMAGE_TEXTURE,
+			SHADOW_OUTER_COLOR,
+			SHADOW_OUTER_MIN,
+			SHADOW_OUTER_MAX,
+			SHADOW_OUTER_OFFSET,
+			SHADOW_INNER_COLOR,
+			SHADOW_INNER_MIN,
+			SHADOW_INNER_MAX,
+			SHADOW_INNER_OFFSET,
+			GLOW_OUTER_COLOR,
+			GLOW_OUTER_WIDTH,
+			GLOW_OUTER_SHARPNESS,
+			GLOW_OUTER_SHARPNESS_INVERSE,
+			GLOW_INNER_COLOR,
+			GLOW_INNER_WIDTH,
+			GLOW_INNER_SHARPNESS,
+			GLOW_INNER_SHARPNESS_INVERSE,
+			OUTLINE_COLOR,
+			OUTLINE_WIDTH,
+			OUTLINE_OFFSET,
+			OUTLINE_SHARPNESS,
+			OUTLINE_SHARPNESS_INVERSE,
+			_CONSUMER_COUNT,
+		};
+		struct consumer_effect {
+			streamfx::obs::gs::effect                             effect;
+			streamfx::obs::gs::effect_parameters<_CONSUMER_COUNT> parameters;
+		};
+		streamfx::obs::gs::effect_permutations _sdf_consumer;
+		std::map<uint32_t, consumer_effect>    _sdf_consumer_effects;
+
+		bool _created; // Render targets and effects exist.
 
 		// Input
 		std::shared_ptr<streamfx::obs::gs::rendertarget> _source_rt;
@@ -42,6 +90,32 @@ namespace streamfx::filter::sdf_effects {
 		std::shared_ptr<streamfx::obs::gs::texture>      _sdf_texture;
 		double_t                                         _sdf_scale;
 		float_t                                          _sdf_threshold;
+		sdf_producer                                     _sdf_producer;
+		float_t                                          _sdf_range;
+		gs_color_format                                  _sdf_format;
+		float_t                                          _sdf_distance_scale;
+
+		std::shared_ptr<streamfx::obs::gs::rendertarget_pool> _pool;
+
+		// Change Detection
+		struct {
+			bool                                             enabled;
+			bool                                             valid;   // Distance field matches the current settings.
+			bool                                             changed; // Input changed in the last frame read back.
+			std::shared_ptr<streamfx::obs::gs::rendertarget> signature;
+			streamfx::obs::gs::readback                      readback;
+			uint32_t                                         width;
+			uint32_t                                         height;
+			uint64_t                                         frame;
+			std::vector<uint8_t>                             last; // Signature read back last.
+			std::size_t                                      pending; // Frames left until the field has converged.
+		} _sdf_cache;
+
+		// Part of the output any scene shows, see obs::tools::visible_region.
+		struct {
+			bool     known;
+			uint32_t region[4];
+		} _visible;
 
 		// Effects
 		bool                                             _output_rendered;
@@ -81,6 +155,14 @@ namespace streamfx::filter::sdf_effects {
 		float_t _outline_sharpness;
 		float_t _outline_sharpness_inv;
 
+		// Governor
+		uint32_t _sdf_degrade_level;
+
+#ifdef ENABLE_PROFILING
+		// Profiling
+		std::shared_ptr<streamfx::obs::gs::gpu_timer> _gpu_timer;
+#endif
+
 		public:
 		sdf_effects_instance(obs_data_t* settings, obs_source_t* self);
 		virtual ~sdf_effects_instance();
@@ -90,7 +172,19 @@ namespace streamfx::filter::sdf_effects {
 		virtual void update(obs_data_t* settings) override;
 
 		virtual void video_tick(float_t) override;
+		virtual void idle() override;
 		virtual void video_render(gs_effect_t*) override;
+
+		private:
+		void create();
+
+		/** Update the distance field from the cached source, and return the number of passes it took. */
+		std::size_t generate_sdf(sdf_producer producer, uint32_t width, uint32_t height);
+
+		/** Check if the alpha mask of the cached source is the same as in the previous frame. */
+		bool is_source_unchanged(uint32_t width, uint32_t height);
+
+		consumer_effect& get_consumer_effect(uint32_t variant);
 	};
 
 	class sdf_effects_factory : public obs::source_factory<filter::sdf_effects::sdf_effects_factory,
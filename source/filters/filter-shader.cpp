@@ -19,22 +19,31 @@
 
 #include "filter-shader.hpp"
 #include "strings.hpp"
+#include <algorithm>
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
 
 #define ST_I18N "Filter.Shader"
 
+// Largest side of the thumbnail that is compared between frames.
+#define ST_INPUT_THUMBNAIL_SIZE 32
+
+// Frames after which a static shader runs again even if the thumbnail looks the same, as small changes like a
+// ticking clock or a moving cursor can average out completely.
+#define ST_INPUT_REFRESH_INTERVAL 30
+
 using namespace streamfx::filter::shader;
 
 static constexpr std::string_view HELP_URL =
 	"https://github.com/Xaymar/obs-StreamFX/wiki/Source-Filter-Transition-Shader";
 
-shader_instance::shader_instance(obs_data_t* data, obs_source_t* self) : obs::source_instance(data, self)
+shader_instance::shader_instance(obs_data_t* data, obs_source_t* self) : obs::source_instance(data, self), _input()
 {
 	_fx = std::make_shared<streamfx::gfx::shader::shader>(self, streamfx::gfx::shader::shader_mode::Filter);
 	_rt = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
 
 	update(data);
+	enable_update_coalescing(0.1f);
 }
 
 shader_instance::~shader_instance() {}
@@ -88,6 +97,12 @@ void shader_instance::video_render(gs_effect_t* effect)
 			throw std::runtime_error("No effect, or invalid base size.");
 		}
 
+		// Pass the input through until the shader finished compiling.
+		if (!_fx->is_loaded()) {
+			obs_source_skip_video_filter(_self);
+			return;
+		}
+
 #ifdef ENABLE_PROFILING
 		streamfx::obs::gs::debug_marker gdmp{streamfx::obs::gs::debug_color_source, "Shader Filter '%s' on '%s'",
 											 obs_source_get_name(_self),
@@ -128,6 +143,15 @@ void shader_instance::video_render(gs_effect_t* effect)
 			streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_render, "Render"};
 #endif
 
+			// A static shader only has to run again once its input changed.
+			if (_fx->is_static()) {
+				if (!is_input_unchanged(_fx->base_width(), _fx->base_height())) {
+					_fx->invalidate();
+				}
+			} else {
+				_input.frame = 0;
+			}
+
 			_fx->prepare_render();
 			_fx->set_input_a(_rt->get_texture());
 			_fx->render(effect);
@@ -138,6 +162,55 @@ void shader_instance::video_render(gs_effect_t* effect)
 	}
 }
 
+bool shader_instance::is_input_unchanged(uint32_t width, uint32_t height)
+{
+	// Reduce the input to a small thumbnail, every halving averages 2x2 texels so that no part of it is skipped.
+	uint32_t factor = 1;
+	while (((width / factor) > ST_INPUT_THUMBNAIL_SIZE) || ((height / factor) > ST_INPUT_THUMBNAIL_SIZE)) {
+		factor <<= 1;
+	}
+	auto thumbnail = _input.downsampler.downsample(_rt->get_texture(), factor);
+	if (!thumbnail) {
+		return false; // Input is already tiny, running the shader costs less than comparing it.
+	}
+
+	uint32_t thumb_width  = std::max<uint32_t>(width / factor, 1);
+	uint32_t thumb_height = std::max<uint32_t>(height / factor, 1);
+	if ((_input.width != thumb_width) || (_input.height != thumb_height)) {
+		_input.readback.reset();
+		_input.width  = thumb_width;
+		_input.height = thumb_height;
+		_input.frame  = 0;
+	}
+
+	// The thumbnail is read back a frame later, mapping it right away would stall until the GPU caught up.
+	_input.readback.stage(thumbnail->get_object(),
+						  [this](const uint8_t* ptr, uint32_t stride, uint32_t cols, uint32_t rows) {
+							  if (!ptr) {
+								  _input.changed = true;
+								  return;
+							  }
+
+							  uint64_t hash = 14695981039346656037ull; // FNV-1a
+							  for (uint32_t y = 0; y < rows; y++) {
+								  const uint8_t* row = ptr + static_cast<size_t>(y) * stride;
+								  for (size_t x = 0; x < static_cast<size_t>(cols) * 4; x++) {
+									  hash = (hash ^ row[x]) * 1099511628211ull;
+								  }
+							  }
+
+							  _input.changed = (_input.frame < 2) || (hash != _input.hash);
+							  _input.hash    = hash;
+						  });
+	_input.frame++;
+
+	// A change is only seen one frame late, so the previous output is shown for at most one frame too long.
+	if ((_input.frame % ST_INPUT_REFRESH_INTERVAL) == 0) {
+		return false;
+	}
+	return (_input.frame > 2) && !_input.changed;
+}
+
 void streamfx::filter::shader::shader_instance::activate()
 {
 	_fx->set_active(true);
@@ -19,7 +19,9 @@
 
 #pragma once
 #include "common.hpp"
+#include "gfx/blur/gfx-blur-downsample.hpp"
 #include "gfx/shader/gfx-shader.hpp"
+#include "obs/gs/gs-readback.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/obs-source-factory.hpp"
 
@@ -28,6 +30,17 @@ namespace streamfx::filter::shader {
 		std::shared_ptr<streamfx::gfx::shader::shader>   _fx;
 		std::shared_ptr<streamfx::obs::gs::rendertarget> _rt;
 
+		// Input change detection, only while the shader is static.
+		struct {
+			::streamfx::gfx::blur::downsampler downsampler;
+			::streamfx::obs::gs::readback      readback;
+			uint32_t                           width;
+			uint32_t                           height;
+			uint64_t                           frame;
+			uint64_t                           hash;
+			bool                               changed;
+		} _input;
+
 		public:
 		shader_instance(obs_data_t* data, obs_source_t* self);
 		virtual ~shader_instance();
@@ -46,6 +59,10 @@ namespace streamfx::filter::shader {
 
 		void activate() override;
 		void deactivate() override;
+
+		private:
+		/** Check if the captured input is the same as in the previous frame. */
+		bool is_input_unchanged(uint32_t width, uint32_t height);
 	};
 
 	class shader_factory : public obs::source_factory<filter::shader::shader_factory, filter::shader::shader_instance> {
@@ -20,8 +20,10 @@
 #include "filter-transform.hpp"
 #include "strings.hpp"
 #include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
+#include "obs/obs-tools.hpp"
 
 // OBS
 #ifdef _MSC_VER
@@ -47,6 +49,8 @@
 #define ST_KEY_POSITION_X "Filter.Transform.Position.X"
 #define ST_KEY_POSITION_Y "Filter.Transform.Position.Y"
 #define ST_KEY_POSITION_Z "Filter.Transform.Position.Z"
+#define ST_I18N_POSITION_TRACKING "Filter.Transform.Position.Tracking"
+#define ST_KEY_POSITION_TRACKING "Filter.Transform.Position.Tracking"
 #define ST_I18N_ROTATION "Filter.Transform.Rotation"
 #define ST_KEY_ROTATION "Filter.Transform.Rotation"
 #define ST_KEY_ROTATION_X "Filter.Transform.Rotation.X"
@@ -70,6 +74,8 @@
 #define ST_I18N_ROTATION_ORDER_ZYX "Filter.Transform.Rotation.Order.ZYX"
 #define ST_I18N_MIPMAPPING "Filter.Transform.Mipmapping"
 #define ST_KEY_MIPMAPPING "Filter.Transform.Mipmapping"
+#define ST_I18N_ANISOTROPY "Filter.Transform.Anisotropy"
+#define ST_KEY_ANISOTROPY "Filter.Transform.Anisotropy"
 
 using namespace streamfx::filter::transform;
 
@@ -78,6 +84,66 @@ static constexpr std::string_view HELP_URL = "https://github.com/Xaymar/obs-Stre
 static const float_t farZ  = 2097152.0f; // 2 pow 21
 static const float_t nearZ = 1.0f / farZ;
 
+// Anything closer than this to the identity is treated as the identity.
+static const float_t identity_epsilon = 0.0001f;
+
+// Largest number of input texels covered by a single output pixel anywhere on the mesh. The mesh is a parallelogram,
+// so the Jacobian of the projection is evaluated at each corner, which is where it peaks under perspective.
+//
+// An anisotropic sampler takes up to 'anisotropy' samples along the longer axis of the footprint, so only the shorter
+// axis, or the longer one divided by the sample count, is left for the mip chain to cover.
+static float_t calculate_minification(streamfx::obs::gs::vertex_buffer& vb, bool orthographic, float_t fov,
+									  uint32_t width, uint32_t height, float_t anisotropy = 1.f)
+{
+	// Pixels covered by one unit of normalized device coordinates.
+	float_t scale_x = static_cast<float_t>(width) / 2.f;
+	float_t scale_y = static_cast<float_t>(height) / 2.f;
+	if (!orthographic) {
+		float_t focal = 1.f / std::tan(fov / 360.f * static_cast<float_t>(S_PI));
+		scale_x *= focal * static_cast<float_t>(height) / static_cast<float_t>(width);
+		scale_y *= focal;
+	}
+
+	vec3 corners[4];
+	for (uint32_t idx = 0; idx < 4; idx++) {
+		vec3_copy(&corners[idx], vb.at(idx).position);
+	}
+	vec3 edge_u, edge_v;
+	vec3_sub(&edge_u, &corners[1], &corners[0]);
+	vec3_sub(&edge_v, &corners[2], &corners[0]);
+
+	float_t value = 0.f;
+	for (uint32_t idx = 0; idx < 4; idx++) {
+		const vec3& pos = corners[idx];
+
+		// The camera sits one unit in front of the mesh, so depth shrinks the projection by 1 / (1 - z).
+		float_t depth   = orthographic ? 1.f : (1.f - pos.z);
+		float_t depth_u = orthographic ? 0.f : -edge_u.z;
+		float_t depth_v = orthographic ? 0.f : -edge_v.z;
+		if (depth <= nearZ) {
+			return std::numeric_limits<float_t>::infinity();
+		}
+
+		// Output pixels moved per input texel along u and v.
+		float_t depth2 = depth * depth * static_cast<float_t>(width);
+		float_t ux     = (edge_u.x * depth - pos.x * depth_u) * scale_x / depth2;
+		float_t uy     = (edge_u.y * depth - pos.y * depth_u) * scale_y / depth2;
+		depth2         = depth * depth * static_cast<float_t>(height);
+		float_t vx     = (edge_v.x * depth - pos.x * depth_v) * scale_x / depth2;
+		float_t vy     = (edge_v.y * depth - pos.y * depth_v) * scale_y / depth2;
+
+		// Invert to get input texels per output pixel, which is what the sampler uses to pick a level.
+		float_t det = std::abs(ux * vy - vx * uy);
+		if (det <= std::numeric_limits<float_t>::epsilon()) {
+			return std::numeric_limits<float_t>::infinity();
+		}
+		float_t axis_u = std::sqrt(vy * vy + uy * uy) / det;
+		float_t axis_v = std::sqrt(vx * vx + ux * ux) / det;
+		value          = std::max(value, std::max(std::min(axis_u, axis_v), std::max(axis_u, axis_v) / anisotropy));
+	}
+	return value;
+}
+
 enum class CameraMode : int64_t { Orthographic, Perspective };
 
 enum RotationOrder : int64_t {
@@ -89,14 +155,75 @@ enum RotationOrder : int64_t {
 	ZYX,
 };
 
+// Same result as chaining matrix4_rotate_aa4f for each axis, but without a quaternion and a full matrix multiply per
+// axis. Rotations use the row vector convention of libobs, so the first axis in the order is applied first.
+static void build_rotation(matrix4& m, uint32_t order, const vec3& rotation)
+{
+	float_t sx = std::sin(rotation.x), cx = std::cos(rotation.x);
+	float_t sy = std::sin(rotation.y), cy = std::cos(rotation.y);
+	float_t sz = std::sin(rotation.z), cz = std::cos(rotation.z);
+
+	matrix4 rx, ry, rz;
+	matrix4_identity(&rx);
+	rx.y.y = cx;
+	rx.y.z = sx;
+	rx.z.y = -sx;
+	rx.z.z = cx;
+	matrix4_identity(&ry);
+	ry.x.x = cy;
+	ry.x.z = -sy;
+	ry.z.x = sy;
+	ry.z.z = cy;
+	matrix4_identity(&rz);
+	rz.x.x = cz;
+	rz.x.y = sz;
+	rz.y.x = -sz;
+	rz.y.y = cz;
+
+	const matrix4* axes[3] = {&rx, &ry, &rz};
+	switch (order) {
+	case RotationOrder::XZY:
+		axes[1] = &rz;
+		axes[2] = &ry;
+		break;
+	case RotationOrder::YXZ:
+		axes[0] = &ry;
+		axes[1] = &rx;
+		break;
+	case RotationOrder::YZX:
+		axes[0] = &ry;
+		axes[1] = &rz;
+		axes[2] = &rx;
+		break;
+	case RotationOrder::ZXY:
+		axes[0] = &rz;
+		axes[1] = &rx;
+		axes[2] = &ry;
+		break;
+	case RotationOrder::ZYX:
+		axes[0] = &rz;
+		axes[2] = &rx;
+		break;
+	}
+	matrix4_mul(&m, axes[0], axes[1]);
+	matrix4_mul(&m, &m, axes[2]);
+}
+
 transform_instance::transform_instance(obs_data_t* data, obs_source_t* context)
-	: obs::source_instance(data, context), _cache_rendered(), _mipmap_enabled(), _source_rendered(), _source_size(),
-	  _update_mesh(), _rotation_order(), _camera_orthographic(), _camera_fov()
+	: obs::source_instance(data, context), _cache_rendered(), _mipmap_enabled(), _mipmap_minification(), _anisotropy(1),
+	  _source_rendered(), _source_size(), _update_mesh(true), _rotation_order(), _camera_orthographic(), _camera_fov(),
+	  _tracking_enabled(false), _tracking_offset(0.f, 0.f), _tracking(), _passthrough(passthrough_mode::None)
 {
 	_cache_rt      = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
 	_source_rt     = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
 	_vertex_buffer = std::make_shared<streamfx::obs::gs::vertex_buffer>(uint32_t(4u), uint8_t(1u));
 
+	// Same as the default effect, except for the filter. The sampler state itself is only created once it is drawn.
+	_anisotropic_sampler = std::make_shared<streamfx::obs::gs::sampler>();
+	_anisotropic_sampler->set_filter(GS_FILTER_ANISOTROPIC);
+	_anisotropic_sampler->set_address_mode_u(GS_ADDRESS_CLAMP);
+	_anisotropic_sampler->set_address_mode_v(GS_ADDRESS_CLAMP);
+
 	_position = std::make_unique<streamfx::util::vec3a>();
 	_rotation = std::make_unique<streamfx::util::vec3a>();
 	_scale    = std::make_unique<streamfx::util::vec3a>();
@@ -119,6 +246,11 @@ transform_instance::~transform_instance()
 	_cache_rt.reset();
 	_cache_texture.reset();
 	_mipmap_texture.reset();
+
+	if (_anisotropic_sampler) {
+		streamfx::obs::gs::context gctx;
+		_anisotropic_sampler.reset();
+	}
 }
 
 void transform_instance::load(obs_data_t* settings)
@@ -137,6 +269,20 @@ void transform_instance::migrate(obs_data_t* data, uint64_t version)
 
 void transform_instance::update(obs_data_t* settings)
 {
+	// Remember the current state, so that the mesh is only rebuilt if something that affects it changed.
+	auto is_same = [](const vec3& a, const vec3& b) { return (a.x == b.x) && (a.y == b.y) && (a.z == b.z); };
+
+	bool     was_orthographic = _camera_orthographic;
+	float_t  old_fov          = _camera_fov;
+	uint32_t old_order        = _rotation_order;
+	bool     was_tracking     = _tracking_enabled;
+	int32_t  old_anisotropy   = _anisotropy;
+	vec3     old_position, old_rotation, old_scale, old_shear;
+	vec3_copy(&old_position, _position.get());
+	vec3_copy(&old_rotation, _rotation.get());
+	vec3_copy(&old_scale, _scale.get());
+	vec3_copy(&old_shear, _shear.get());
+
 	// Camera
 	_camera_orthographic = obs_data_get_int(settings, ST_KEY_CAMERA) == 0;
 	_camera_fov          = static_cast<float_t>(obs_data_get_double(settings, ST_KEY_CAMERA_FIELDOFVIEW));
@@ -156,10 +302,53 @@ void transform_instance::update(obs_data_t* settings)
 	_shear->y       = static_cast<float_t>(obs_data_get_double(settings, ST_KEY_SHEAR_Y) / 100.0);
 	_shear->z       = 0.0f;
 
+	// Tracking
+	_tracking_enabled = obs_data_get_bool(settings, ST_KEY_POSITION_TRACKING);
+	if (!_tracking_enabled) {
+		_tracking_offset = {0.f, 0.f};
+	}
+
 	// Mipmapping
 	_mipmap_enabled = obs_data_get_bool(settings, ST_KEY_MIPMAPPING);
 
-	_update_mesh = true;
+	// Anisotropic Filtering
+	_anisotropy = std::clamp(static_cast<int32_t>(obs_data_get_int(settings, ST_KEY_ANISOTROPY)), 1, 16);
+	_anisotropic_sampler->set_max_anisotropy(_anisotropy);
+
+	// Passthrough
+	{
+		auto is_zero = [](float_t v) { return std::abs(v) < identity_epsilon; };
+
+		// Only an orthographic camera without rotation or shear keeps the input flat and axis aligned. Depth has no
+		// visible effect in that case.
+		bool is_flat         = _camera_orthographic && is_zero(_rotation->x) && is_zero(_rotation->y)
+					   && is_zero(_rotation->z) && is_zero(_shear->x) && is_zero(_shear->y);
+		bool is_unscaled     = is_zero(_scale->x - 1.f) && is_zero(_scale->y - 1.f);
+		bool is_untranslated = is_zero(_position->x) && is_zero(_position->y);
+
+		// A blit draws outside of the input if the result does not fit, which the full render would have clipped.
+		// It also misses out on mip mapping, so it is only used while magnifying if that is enabled.
+		bool is_contained = ((std::abs(_scale->x) + std::abs(_position->x)) <= (1.f + identity_epsilon))
+							&& ((std::abs(_scale->y) + std::abs(_position->y)) <= (1.f + identity_epsilon));
+		bool is_magnified = (std::abs(_scale->x) >= 1.f) && (std::abs(_scale->y) >= 1.f);
+
+		if (_tracking_enabled) {
+			// The offset changes with every tracked frame, which neither shortcut accounts for.
+			_passthrough = passthrough_mode::None;
+		} else if (is_flat && is_unscaled && is_untranslated) {
+			_passthrough = passthrough_mode::Skip;
+		} else if (is_flat && is_contained && (!_mipmap_enabled || is_magnified)) {
+			_passthrough = passthrough_mode::Blit;
+		} else {
+			_passthrough = passthrough_mode::None;
+		}
+	}
+
+	if ((was_orthographic != _camera_orthographic) || (old_fov != _camera_fov) || (old_order != _rotation_order)
+		|| (was_tracking != _tracking_enabled) || (old_anisotropy != _anisotropy) || !is_same(old_position, *_position)
+		|| !is_same(old_rotation, *_rotation) || !is_same(old_scale, *_scale) || !is_same(old_shear, *_shear)) {
+		_update_mesh = true;
+	}
 }
 
 void transform_instance::video_tick(float_t)
@@ -175,6 +364,18 @@ void transform_instance::video_tick(float_t)
 		height = obs_source_get_base_height(target);
 	}
 
+	// Move the first face found by a tracker on the same source to the center, or keep the last offset if it is lost.
+	if (_tracking_enabled) {
+		if (auto frame = _tracking.get(obs_filter_get_parent(_self)); frame && !frame->faces.empty()) {
+			auto&                       face = frame->faces.front();
+			std::pair<float_t, float_t> offset{.5f - (face.x + face.width / 2.f), .5f - (face.y + face.height / 2.f)};
+			if (offset != _tracking_offset) {
+				_tracking_offset = offset;
+				_update_mesh     = true;
+			}
+		}
+	}
+
 	// If size mismatch, force an update.
 	if (width != _source_size.first) {
 		_update_mesh = true;
@@ -201,78 +402,54 @@ void transform_instance::video_tick(float_t)
 
 		// Mesh
 		matrix4 ident;
-		matrix4_identity(&ident);
-		switch (_rotation_order) {
-		case RotationOrder::XYZ: // XYZ
-			matrix4_rotate_aa4f(&ident, &ident, 1, 0, 0, _rotation->x);
-			matrix4_rotate_aa4f(&ident, &ident, 0, 1, 0, _rotation->y);
-			matrix4_rotate_aa4f(&ident, &ident, 0, 0, 1, _rotation->z);
-			break;
-		case RotationOrder::XZY: // XZY
-			matrix4_rotate_aa4f(&ident, &ident, 1, 0, 0, _rotation->x);
-			matrix4_rotate_aa4f(&ident, &ident, 0, 0, 1, _rotation->z);
-			matrix4_rotate_aa4f(&ident, &ident, 0, 1, 0, _rotation->y);
-			break;
-		case RotationOrder::YXZ: // YXZ
-			matrix4_rotate_aa4f(&ident, &ident, 0, 1, 0, _rotation->y);
-			matrix4_rotate_aa4f(&ident, &ident, 1, 0, 0, _rotation->x);
-			matrix4_rotate_aa4f(&ident, &ident, 0, 0, 1, _rotation->z);
-			break;
-		case RotationOrder::YZX: // YZX
-			matrix4_rotate_aa4f(&ident, &ident, 0, 1, 0, _rotation->y);
-			matrix4_rotate_aa4f(&ident, &ident, 0, 0, 1, _rotation->z);
-			matrix4_rotate_aa4f(&ident, &ident, 1, 0, 0, _rotation->x);
-			break;
-		case RotationOrder::ZXY: // ZXY
-			matrix4_rotate_aa4f(&ident, &ident, 0, 0, 1, _rotation->z);
-			matrix4_rotate_aa4f(&ident, &ident, 1, 0, 0, _rotation->x);
-			matrix4_rotate_aa4f(&ident, &ident, 0, 1, 0, _rotation->y);
-			break;
-		case RotationOrder::ZYX: // ZYX
-			matrix4_rotate_aa4f(&ident, &ident, 0, 0, 1, _rotation->z);
-			matrix4_rotate_aa4f(&ident, &ident, 0, 1, 0, _rotation->y);
-			matrix4_rotate_aa4f(&ident, &ident, 1, 0, 0, _rotation->x);
-			break;
-		}
-		matrix4_translate3f(&ident, &ident, _position->x, _position->y, _position->z);
+		build_rotation(ident, _rotation_order, *_rotation);
+		vec4_set(&ident.t, _position->x, _position->y, _position->z, 1.f);
 		//matrix4_scale3f(&ident, &ident, _source_size.first / 2.f, _source_size.second / 2.f, 1.f);
 
 		/// Calculate vertex position once only.
 		float_t p_x = aspectRatioX * _scale->x;
 		float_t p_y = 1.0f * _scale->y;
 
+		/// The tracking offset is in texture space, so it is applied before rotating.
+		float_t o_x = _tracking_offset.first * 2.f * p_x;
+		float_t o_y = _tracking_offset.second * 2.f * p_y;
+
 		/// Generate mesh
 		{
 			auto vtx   = _vertex_buffer->at(0);
 			*vtx.color = 0xFFFFFFFF;
 			vec4_set(vtx.uv[0], 0, 0, 0, 0);
-			vec3_set(vtx.position, -p_x + _shear->x, -p_y - _shear->y, 0);
+			vec3_set(vtx.position, -p_x + _shear->x + o_x, -p_y - _shear->y + o_y, 0);
 			vec3_transform(vtx.position, vtx.position, &ident);
 		}
 		{
 			auto vtx   = _vertex_buffer->at(1);
 			*vtx.color = 0xFFFFFFFF;
 			vec4_set(vtx.uv[0], 1, 0, 0, 0);
-			vec3_set(vtx.position, p_x + _shear->x, -p_y + _shear->y, 0);
+			vec3_set(vtx.position, p_x + _shear->x + o_x, -p_y + _shear->y + o_y, 0);
 			vec3_transform(vtx.position, vtx.position, &ident);
 		}
 		{
 			auto vtx   = _vertex_buffer->at(2);
 			*vtx.color = 0xFFFFFFFF;
 			vec4_set(vtx.uv[0], 0, 1, 0, 0);
-			vec3_set(vtx.position, -p_x - _shear->x, p_y - _shear->y, 0);
+			vec3_set(vtx.position, -p_x - _shear->x + o_x, p_y - _shear->y + o_y, 0);
 			vec3_transform(vtx.position, vtx.position, &ident);
 		}
 		{
 			auto vtx   = _vertex_buffer->at(3);
 			*vtx.color = 0xFFFFFFFF;
 			vec4_set(vtx.uv[0], 1, 1, 0, 0);
-			vec3_set(vtx.position, p_x - _shear->x, p_y + _shear->y, 0);
+			vec3_set(vtx.position, p_x - _shear->x + o_x, p_y + _shear->y + o_y, 0);
 			vec3_transform(vtx.position, vtx.position, &ident);
 		}
 
 		_vertex_buffer->update(true);
 		_update_mesh = false;
+
+		_mipmap_minification =
+			calculate_minification(*_vertex_buffer, _camera_orthographic, _camera_fov, width, height,
+								   static_cast<float_t>(_anisotropy));
 	}
 
 	_cache_rendered  = false;
@@ -295,11 +472,31 @@ void transform_instance::video_render(gs_effect_t* effect)
 		return;
 	}
 
+	if (_passthrough == passthrough_mode::Skip) {
+		obs_source_skip_video_filter(_self);
+		return;
+	}
+
 #ifdef ENABLE_PROFILING
 	streamfx::obs::gs::debug_marker gdmp{streamfx::obs::gs::debug_color_source, "3D Transform '%s' on '%s'",
 										 obs_source_get_name(_self), obs_source_get_name(obs_filter_get_parent(_self))};
 #endif
 
+	if (_passthrough == passthrough_mode::Blit) {
+		// Same as the orthographic mesh, but in the pixel space of the input: Scale around the center, then move.
+		float_t half_width  = static_cast<float_t>(base_width) / 2.f;
+		float_t half_height = static_cast<float_t>(base_height) / 2.f;
+
+		gs_matrix_push();
+		gs_matrix_translate3f(half_width * (1.f + _position->x), half_height * (1.f + _position->y), 0.);
+		gs_matrix_scale3f(_scale->x, _scale->y, 1.);
+		gs_matrix_translate3f(-half_width, -half_height, 0.);
+		gs_set_cull_mode(GS_NEITHER);
+		streamfx::obs::tools::filter_direct_render(_self, effect, "Draw", base_width, base_height);
+		gs_matrix_pop();
+		return;
+	}
+
 	uint32_t cache_width  = base_width;
 	uint32_t cache_height = base_height;
 
@@ -362,7 +559,19 @@ void transform_instance::video_render(gs_effect_t* effect)
 		return;
 	}
 
+	// Only generate the levels that the sampler will actually reach, which may be none at all.
+	std::size_t mip_levels = 1;
 	if (_mipmap_enabled) {
+		float_t texels = _mipmap_minification
+						 * std::max(static_cast<float_t>(cache_width) / static_cast<float_t>(base_width),
+									static_cast<float_t>(cache_height) / static_cast<float_t>(base_height));
+		if (texels > 1.f) {
+			// Trilinear filtering blends towards the next level, so one more than the selected level is required.
+			mip_levels += static_cast<std::size_t>(std::ceil(std::min(std::log2(texels), 32.f)));
+		}
+	}
+
+	if (mip_levels > 1) {
 #ifdef ENABLE_PROFILING
 		streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_convert, "Mipmap"};
 #endif
@@ -373,13 +582,13 @@ void transform_instance::video_render(gs_effect_t* effect)
 			streamfx::obs::gs::debug_marker gdr{streamfx::obs::gs::debug_color_allocate, "Allocate Mipmapped Texture"};
 #endif
 
-			std::size_t mip_levels = std::max(streamfx::util::math::get_power_of_two_exponent_ceil(cache_width),
+			std::size_t max_levels = std::max(streamfx::util::math::get_power_of_two_exponent_ceil(cache_width),
 											  streamfx::util::math::get_power_of_two_exponent_ceil(cache_height));
 			_mipmap_texture        = std::make_shared<streamfx::obs::gs::texture>(cache_width, cache_height, GS_RGBA,
-                                                                           static_cast<uint32_t>(mip_levels), nullptr,
+                                                                           static_cast<uint32_t>(max_levels), nullptr,
                                                                            streamfx::obs::gs::texture::flags::None);
 		}
-		_mipmapper.rebuild(_cache_texture, _mipmap_texture);
+		_mipmapper.rebuild(_cache_texture, _mipmap_texture, mip_levels);
 
 		_mipmap_rendered = true;
 		if (!_mipmap_texture) {
@@ -419,10 +628,11 @@ void transform_instance::video_render(gs_effect_t* effect)
 
 		gs_load_vertexbuffer(_vertex_buffer->update(false));
 		gs_load_indexbuffer(nullptr);
-		gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"),
-							  _mipmap_enabled
-								  ? (_mipmap_texture ? _mipmap_texture->get_object() : _cache_texture->get_object())
-								  : _cache_texture->get_object());
+		gs_eparam_t* image = gs_effect_get_param_by_name(default_effect, "image");
+		gs_effect_set_texture(image, _mipmap_rendered ? _mipmap_texture->get_object() : _cache_texture->get_object());
+		if (_anisotropy > 1) {
+			gs_effect_set_next_sampler(image, _anisotropic_sampler->get_object());
+		}
 		while (gs_effect_loop(default_effect, "Draw")) {
 			gs_draw(GS_TRISTRIP, 0, 4);
 		}
@@ -473,6 +683,7 @@ void transform_factory::get_defaults2(obs_data_t* settings)
 	obs_data_set_default_double(settings, ST_KEY_POSITION_X, 0);
 	obs_data_set_default_double(settings, ST_KEY_POSITION_Y, 0);
 	obs_data_set_default_double(settings, ST_KEY_POSITION_Z, 0);
+	obs_data_set_default_bool(settings, ST_KEY_POSITION_TRACKING, false);
 	obs_data_set_default_double(settings, ST_KEY_ROTATION_X, 0);
 	obs_data_set_default_double(settings, ST_KEY_ROTATION_Y, 0);
 	obs_data_set_default_double(settings, ST_KEY_ROTATION_Z, 0);
@@ -482,6 +693,7 @@ void transform_factory::get_defaults2(obs_data_t* settings)
 	obs_data_set_default_double(settings, ST_KEY_SHEAR_X, 0);
 	obs_data_set_default_double(settings, ST_KEY_SHEAR_Y, 0);
 	obs_data_set_default_bool(settings, ST_KEY_MIPMAPPING, false);
+	obs_data_set_default_int(settings, ST_KEY_ANISOTROPY, 1);
 }
 
 static bool modified_properties(obs_properties_t* pr, obs_property_t*, obs_data_t* d) noexcept
@@ -547,6 +759,7 @@ obs_properties_t* transform_factory::get_properties2(transform_instance* data)
 			auto p = obs_properties_add_float(grp, opt, D_TRANSLATE(opt), std::numeric_limits<float_t>::lowest(),
 											  std::numeric_limits<float_t>::max(), 0.01);
 		}
+		obs_properties_add_bool(grp, ST_KEY_POSITION_TRACKING, D_TRANSLATE(ST_I18N_POSITION_TRACKING));
 
 		obs_properties_add_group(pr, ST_KEY_POSITION, D_TRANSLATE(ST_I18N_POSITION), OBS_GROUP_NORMAL, grp);
 	}
@@ -594,6 +807,16 @@ obs_properties_t* transform_factory::get_properties2(transform_instance* data)
 			auto p = obs_properties_add_bool(grp, ST_KEY_MIPMAPPING, D_TRANSLATE(ST_I18N_MIPMAPPING));
 		}
 
+		{ // Anisotropic Filtering
+			auto p = obs_properties_add_list(grp, ST_KEY_ANISOTROPY, D_TRANSLATE(ST_I18N_ANISOTROPY),
+											 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+			obs_property_list_add_int(p, D_TRANSLATE(S_STATE_DISABLED), 1);
+			obs_property_list_add_int(p, "2x", 2);
+			obs_property_list_add_int(p, "4x", 4);
+			obs_property_list_add_int(p, "8x", 8);
+			obs_property_list_add_int(p, "16x", 16);
+		}
+
 		{ // Order
 			auto p = obs_properties_add_list(grp, ST_KEY_ROTATION_ORDER, D_TRANSLATE(ST_I18N_ROTATION_ORDER),
 											 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
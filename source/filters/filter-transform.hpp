@@ -22,11 +22,19 @@
 #include <vector>
 #include "obs/gs/gs-mipmapper.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
+#include "obs/gs/gs-sampler.hpp"
 #include "obs/gs/gs-texture.hpp"
 #include "obs/gs/gs-vertexbuffer.hpp"
 #include "obs/obs-source-factory.hpp"
+#include "util/util-tracking.hpp"
 
 namespace streamfx::filter::transform {
+	enum class passthrough_mode {
+		None, // Full render through the mesh.
+		Skip, // The transform does nothing, so the filter is skipped.
+		Blit, // The transform is a 2D scale and translation, drawn straight from the input.
+	};
+
 	class transform_instance : public obs::source_instance {
 		// Cache
 		bool                                             _cache_rendered;
@@ -36,9 +44,14 @@ namespace streamfx::filter::transform {
 		// Mip-mapping
 		bool                                        _mipmap_enabled;
 		bool                                        _mipmap_rendered;
+		float_t                                     _mipmap_minification; // Input texels per output pixel.
 		streamfx::obs::gs::mipmapper                _mipmapper;
 		std::shared_ptr<streamfx::obs::gs::texture> _mipmap_texture;
 
+		// Anisotropic Filtering
+		int32_t                                     _anisotropy; // 1 if disabled.
+		std::shared_ptr<streamfx::obs::gs::sampler> _anisotropic_sampler;
+
 		// Input
 		bool                                             _source_rendered;
 		std::pair<uint32_t, uint32_t>                    _source_size;
@@ -58,6 +71,14 @@ namespace streamfx::filter::transform {
 		bool    _camera_orthographic;
 		float_t _camera_fov;
 
+		// Tracking
+		bool                                     _tracking_enabled; // Keep a tracked face in the center.
+		std::pair<float_t, float_t>              _tracking_offset;
+		::streamfx::util::tracking::subscription _tracking;
+
+		// Passthrough
+		passthrough_mode _passthrough;
+
 		public:
 		transform_instance(obs_data_t*, obs_source_t*);
 		virtual ~transform_instance() override;
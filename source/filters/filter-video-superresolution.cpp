@@ -20,6 +20,12 @@
 
 #include "filter-video-superresolution.hpp"
 #include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <thread>
+#include <vector>
 #include "obs/gs/gs-helper.hpp"
 #include "plugin.hpp"
 #include "util/util-logging.hpp"
@@ -42,6 +48,9 @@
 #define ST_KEY_PROVIDER "Provider"
 #define ST_I18N_PROVIDER ST_I18N "." ST_KEY_PROVIDER
 #define ST_I18N_PROVIDER_NVIDIA_SUPERRES ST_I18N_PROVIDER ".NVIDIAVideoSuperResolution"
+#define ST_I18N_PROVIDER_EDGE_UPSCALE ST_I18N_PROVIDER ".EdgeAdaptiveUpscale"
+#define ST_KEY_STATE "State"
+#define ST_I18N_STATE_INITIALIZING ST_I18N ".State.Initializing"
 
 #ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
 #define ST_KEY_NVIDIA_SUPERRES "NVIDIA.SuperRes"
@@ -50,8 +59,29 @@
 #define ST_I18N_NVIDIA_SUPERRES_STRENGTH ST_I18N "." ST_KEY_NVIDIA_SUPERRES_STRENGTH
 #define ST_I18N_NVIDIA_SUPERRES_STRENGTH_WEAK ST_I18N_NVIDIA_SUPERRES_STRENGTH ".Weak"
 #define ST_I18N_NVIDIA_SUPERRES_STRENGTH_STRONG ST_I18N_NVIDIA_SUPERRES_STRENGTH ".Strong"
+#define ST_KEY_NVIDIA_SUPERRES_ARTIFACTREDUCTION "NVIDIA.SuperRes.ArtifactReduction"
+#define ST_I18N_NVIDIA_SUPERRES_ARTIFACTREDUCTION ST_I18N "." ST_KEY_NVIDIA_SUPERRES_ARTIFACTREDUCTION
 #define ST_KEY_NVIDIA_SUPERRES_SCALE "NVIDIA.SuperRes.Scale"
 #define ST_I18N_NVIDIA_SUPERRES_SCALE ST_I18N "." ST_KEY_NVIDIA_SUPERRES_SCALE
+#define ST_KEY_NVIDIA_SUPERRES_DEVICE "NVIDIA.SuperRes.Device"
+#define ST_I18N_NVIDIA_SUPERRES_DEVICE ST_I18N "." ST_KEY_NVIDIA_SUPERRES_DEVICE
+#define ST_KEY_NVIDIA_SUPERRES_ASYNCHRONOUS "NVIDIA.SuperRes.Asynchronous"
+#define ST_I18N_NVIDIA_SUPERRES_ASYNCHRONOUS ST_I18N "." ST_KEY_NVIDIA_SUPERRES_ASYNCHRONOUS
+#define ST_KEY_NVIDIA_SUPERRES_GRAPHS "NVIDIA.SuperRes.Graphs"
+#define ST_I18N_NVIDIA_SUPERRES_GRAPHS ST_I18N "." ST_KEY_NVIDIA_SUPERRES_GRAPHS
+#define ST_KEY_NVIDIA_SUPERRES_MEMORYBUDGET "NVIDIA.SuperRes.MemoryBudget"
+#define ST_I18N_NVIDIA_SUPERRES_MEMORYBUDGET ST_I18N "." ST_KEY_NVIDIA_SUPERRES_MEMORYBUDGET
+#define ST_KEY_NVIDIA_SUPERRES_MEMORYUSAGE "NVIDIA.SuperRes.MemoryUsage"
+#define ST_I18N_NVIDIA_SUPERRES_MEMORYUSAGE ST_I18N "." ST_KEY_NVIDIA_SUPERRES_MEMORYUSAGE
+#endif
+
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+#define ST_KEY_EDGE_UPSCALE "Edge.Upscale"
+#define ST_I18N_EDGE_UPSCALE ST_I18N "." ST_KEY_EDGE_UPSCALE
+#define ST_KEY_EDGE_UPSCALE_SCALE "Edge.Upscale.Scale"
+#define ST_I18N_EDGE_UPSCALE_SCALE ST_I18N "." ST_KEY_EDGE_UPSCALE_SCALE
+#define ST_KEY_EDGE_UPSCALE_SHARPNESS "Edge.Upscale.Sharpness"
+#define ST_I18N_EDGE_UPSCALE_SHARPNESS ST_I18N "." ST_KEY_EDGE_UPSCALE_SHARPNESS
 #endif
 
 using streamfx::filter::video_superresolution::video_superresolution_factory;
@@ -66,6 +96,7 @@ static constexpr std::string_view HELP_URL =
  */
 static video_superresolution_provider provider_priority[] = {
 	video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION,
+	video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE,
 };
 
 const char* streamfx::filter::video_superresolution::cstring(video_superresolution_provider provider)
@@ -77,6 +108,8 @@ const char* streamfx::filter::video_superresolution::cstring(video_superresoluti
 		return D_TRANSLATE(S_STATE_AUTOMATIC);
 	case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION:
 		return D_TRANSLATE(ST_I18N_PROVIDER_NVIDIA_SUPERRES);
+	case video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE:
+		return D_TRANSLATE(ST_I18N_PROVIDER_EDGE_UPSCALE);
 	default:
 		throw std::runtime_error("Missing Conversion Entry");
 	}
@@ -91,11 +124,17 @@ std::string streamfx::filter::video_superresolution::string(video_superresolutio
 // Instance
 //------------------------------------------------------------------------------
 video_superresolution_instance::video_superresolution_instance(obs_data_t* data, obs_source_t* self)
-	: obs::source_instance(data, self),
+	: obs::source_instance(data, self), obs::degradable(3, 2),
 
-	  _in_size(1, 1), _out_size(1, 1), _provider_ready(false), _provider(video_superresolution_provider::INVALID),
-	  _provider_lock(), _provider_task(), _input(), _output(), _dirty(false)
+	  _in_size(1, 1), _out_size(1, 1), _provider_ready(std::make_shared<std::atomic<bool>>(false)),
+	  _provider(video_superresolution_provider::INVALID), _provider_automatic(false), _provider_lock(),
+	  _provider_task(), _provider_publish(), _input(), _output(), _dirty(false), _skipped(0)
 {
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+	_edge_scale     = 1.f;
+	_edge_sharpness = 0.f;
+#endif
+
 	{
 		::streamfx::obs::gs::context gctx;
 
@@ -108,10 +147,24 @@ video_superresolution_instance::video_superresolution_instance(obs_data_t* data,
 	if (data) {
 		load(data);
 	}
+	enable_idle_tracking();
+	enable_prewarm();
 }
 
 video_superresolution_instance::~video_superresolution_instance()
 {
+	// The publishing continuation only refers to _provider_ready, but the switch itself refers to this instance. A
+	// popped switch completes right away, one that is already running has to finish first.
+	if (_provider_publish) {
+		streamfx::threadpool()->pop(_provider_publish);
+	}
+	if (_provider_task) {
+		streamfx::threadpool()->pop(_provider_task);
+		while (!_provider_task->is_done()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
 	// TODO: Make this asynchronous.
 	std::unique_lock<std::mutex> ul(_provider_lock);
 	switch (_provider) {
@@ -119,6 +172,11 @@ video_superresolution_instance::~video_superresolution_instance()
 	case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION:
 		nvvfxsr_unload();
 		break;
+#endif
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+	case video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE:
+		edge_unload();
+		break;
 #endif
 	default:
 		break;
@@ -137,7 +195,9 @@ void video_superresolution_instance::update(obs_data_t* data)
 	// Check if the user changed which Denoising provider we use.
 	video_superresolution_provider provider =
 		static_cast<video_superresolution_provider>(obs_data_get_int(data, ST_KEY_PROVIDER));
+	_provider_automatic = (provider == video_superresolution_provider::AUTOMATIC);
 	if (provider == video_superresolution_provider::AUTOMATIC) {
+		// Providers that were never loaded count as available, the switch falls back if loading them fails.
 		for (auto v : provider_priority) {
 			if (video_superresolution_factory::get()->is_provider_available(v)) {
 				provider = v;
@@ -151,7 +211,20 @@ void video_superresolution_instance::update(obs_data_t* data)
 		switch_provider(provider);
 	}
 
-	if (_provider_ready) {
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
+	// The effect and its buffers are bound to the device, so switching means loading it again in the background.
+	if (*_provider_ready && (_provider == video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION)) {
+		std::unique_lock<std::mutex> ul(_provider_lock);
+
+		int32_t device = static_cast<int32_t>(obs_data_get_int(data, ST_KEY_NVIDIA_SUPERRES_DEVICE));
+		if (_nvidia_fx && (device != _nvidia_fx->device())) {
+			D_LOG_INFO("Instance '%s' is moving to device %" PRId32 ".", obs_source_get_name(_self), device);
+			queue_provider(_provider);
+		}
+	}
+#endif
+
+	if (*_provider_ready) {
 		std::unique_lock<std::mutex> ul(_provider_lock);
 
 		switch (_provider) {
@@ -159,6 +232,11 @@ void video_superresolution_instance::update(obs_data_t* data)
 		case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION:
 			nvvfxsr_update(data);
 			break;
+#endif
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+		case video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE:
+			edge_update(data);
+			break;
 #endif
 		default:
 			break;
@@ -168,7 +246,7 @@ void video_superresolution_instance::update(obs_data_t* data)
 
 void streamfx::filter::video_superresolution::video_superresolution_instance::properties(obs_properties_t* properties)
 {
-	if (_provider_ready) {
+	if (*_provider_ready) {
 		std::unique_lock<std::mutex> ul(_provider_lock);
 
 		switch (_provider) {
@@ -176,6 +254,11 @@ void streamfx::filter::video_superresolution::video_superresolution_instance::pr
 		case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION:
 			nvvfxsr_properties(properties);
 			break;
+#endif
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+		case video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE:
+			edge_properties(properties);
+			break;
 #endif
 		default:
 			break;
@@ -202,7 +285,7 @@ void video_superresolution_instance::video_tick(float_t time)
 	_out_size   = _in_size;
 
 	// Allow the provider to restrict the size.
-	if (target && _provider_ready) {
+	if (target && *_provider_ready) {
 		std::unique_lock<std::mutex> ul(_provider_lock);
 
 		switch (_provider) {
@@ -210,13 +293,46 @@ void video_superresolution_instance::video_tick(float_t time)
 		case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION:
 			nvvfxsr_size();
 			break;
+#endif
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+		case video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE:
+			edge_size();
+			break;
 #endif
 		default:
 			break;
 		}
 	}
 
-	_dirty = true;
+	// When the governor asks for less work, only every 2^level-th frame is processed and the previous result is
+	// shown in between. A change in size always needs a new result.
+	uint32_t cadence = uint32_t(1) << degrade_level();
+	if (!_output || (_output->get_width() != _out_size.first) || (_output->get_height() != _out_size.second)
+		|| (++_skipped >= cadence)) {
+		_skipped = 0;
+		_dirty   = true;
+	}
+}
+
+void video_superresolution_instance::idle()
+{
+	// A provider switch in progress replaces everything anyway.
+	std::unique_lock<std::mutex> ul(_provider_lock, std::try_to_lock);
+	if (!ul.owns_lock() || !*_provider_ready) {
+		return;
+	}
+
+	switch (_provider) {
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
+	case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION:
+		if (_nvidia_fx) {
+			_nvidia_fx->idle();
+		}
+		break;
+#endif
+	default:
+		break;
+	}
 }
 
 void video_superresolution_instance::video_render(gs_effect_t* effect)
@@ -235,7 +351,7 @@ void video_superresolution_instance::video_render(gs_effect_t* effect)
 	// - The Provider isn't ready yet.
 	// - We don't have a target.
 	// - The width/height of the next filter in the chain is empty.
-	if (!_provider_ready || !target || (width == 0) || (height == 0)) {
+	if (!*_provider_ready || !target || (width == 0) || (height == 0)) {
 		obs_source_skip_video_filter(_self);
 		return;
 	}
@@ -297,6 +413,11 @@ void video_superresolution_instance::video_render(gs_effect_t* effect)
 			case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION:
 				nvvfxsr_process();
 				break;
+#endif
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+			case video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE:
+				edge_process();
+				break;
 #endif
 			default:
 				_output.reset();
@@ -329,8 +450,17 @@ void video_superresolution_instance::video_render(gs_effect_t* effect)
 
 struct switch_provider_data_t {
 	video_superresolution_provider provider;
+	bool                           automatic = false; // Try the next provider in priority if loading fails.
+	bool                           ready     = false; // Set once the new provider loaded successfully.
 };
 
+static video_superresolution_provider next_provider(video_superresolution_provider provider)
+{
+	auto end = std::end(provider_priority);
+	auto pos = std::find(std::begin(provider_priority), end, provider);
+	return ((pos == end) || (std::next(pos) == end)) ? video_superresolution_provider::INVALID : *std::next(pos);
+}
+
 void streamfx::filter::video_superresolution::video_superresolution_instance::switch_provider(
 	video_superresolution_provider provider)
 {
@@ -349,19 +479,34 @@ void streamfx::filter::video_superresolution::video_superresolution_instance::sw
 	D_LOG_INFO("Instance '%s' is switching provider from '%s' to '%s'.", obs_source_get_name(_self), cstring(_provider),
 			   cstring(provider));
 
+	queue_provider(provider);
+}
+
+void streamfx::filter::video_superresolution::video_superresolution_instance::queue_provider(
+	video_superresolution_provider provider)
+{
+	// Expects _provider_lock to be held. The provider may be the current one, which then is loaded again.
+
 	// 1.If there is an existing task, attempt to cancel it.
 	if (_provider_task) {
 		streamfx::threadpool()->pop(_provider_task);
 	}
 
 	// 2. Build data to pass into the task.
-	auto spd      = std::make_shared<switch_provider_data_t>();
-	spd->provider = _provider;
-	_provider     = provider;
+	auto spd       = std::make_shared<switch_provider_data_t>();
+	spd->provider  = _provider;
+	spd->automatic = _provider_automatic;
+	_provider      = provider;
 
-	// 3. Then spawn a new task to switch provider.
+	// 3. Then spawn a new task to switch provider, which is published on the graphics thread between two frames.
 	_provider_task = streamfx::threadpool()->push(
 		std::bind(&video_superresolution_instance::task_switch_provider, this, std::placeholders::_1), spd);
+	// The graphics thread may already be running it when the instance is destroyed, so it must not refer to us.
+	_provider_publish = _provider_task->then(
+		[ready = _provider_ready](util::threadpool_data_t data) {
+			*ready = std::static_pointer_cast<switch_provider_data_t>(data)->ready;
+		},
+		util::threadpool::resume::Graphics);
 }
 
 void streamfx::filter::video_superresolution::video_superresolution_instance::task_switch_provider(
@@ -370,7 +515,7 @@ void streamfx::filter::video_superresolution::video_superresolution_instance::ta
 	std::shared_ptr<switch_provider_data_t> spd = std::static_pointer_cast<switch_provider_data_t>(data);
 
 	// 1. Mark the provider as no longer ready.
-	_provider_ready = false;
+	*_provider_ready = false;
 
 	// 2. Lock the provider from being used.
 	std::unique_lock<std::mutex> ul(_provider_lock);
@@ -382,25 +527,70 @@ void streamfx::filter::video_superresolution::video_superresolution_instance::ta
 		case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION:
 			nvvfxsr_unload();
 			break;
+#endif
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+		case video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE:
+			edge_unload();
+			break;
 #endif
 		default:
 			break;
 		}
 
-		// 4. Load the new provider.
-		switch (_provider) {
+		// 4. Load the new provider. Only loading actually tells if a provider works on this system, so an automatic
+		// choice falls back to the next provider in priority until one does.
+		for (;;) {
+			try {
+				switch (_provider) {
 #ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
-		case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION:
-			nvvfxsr_load();
-			{
-				auto data = obs_source_get_settings(_self);
-				nvvfxsr_update(data);
-				obs_data_release(data);
-			}
-			break;
+				case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION:
+					nvvfxsr_load();
+					{
+						auto data = obs_source_get_settings(_self);
+						nvvfxsr_update(data);
+						obs_data_release(data);
+					}
+					break;
 #endif
-		default:
-			break;
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+				case video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE:
+					edge_load();
+					{
+						auto data = obs_source_get_settings(_self);
+						edge_update(data);
+						obs_data_release(data);
+					}
+					break;
+#endif
+				default:
+					break;
+				}
+				break;
+			} catch (std::exception const& ex) {
+				video_superresolution_provider next =
+					spd->automatic ? next_provider(_provider) : video_superresolution_provider::INVALID;
+				if (next == video_superresolution_provider::INVALID) {
+					throw;
+				}
+
+				D_LOG_WARNING("Instance '%s' failed to load provider '%s', falling back to '%s': %s",
+							  obs_source_get_name(_self), cstring(_provider), cstring(next), ex.what());
+				switch (_provider) {
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
+				case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION:
+					nvvfxsr_unload();
+					break;
+#endif
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+				case video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE:
+					edge_unload();
+					break;
+#endif
+				default:
+					break;
+				}
+				_provider = next;
+			}
 		}
 
 		// Log information.
@@ -408,7 +598,7 @@ void streamfx::filter::video_superresolution::video_superresolution_instance::ta
 				   cstring(spd->provider), cstring(_provider));
 
 		// 5. Set the new provider as valid.
-		_provider_ready = true;
+		spd->ready = true;
 	} catch (std::exception const& ex) {
 		// Log information.
 		D_LOG_ERROR("Instance '%s' failed switching provider with error: %s", obs_source_get_name(_self), ex.what());
@@ -418,7 +608,17 @@ void streamfx::filter::video_superresolution::video_superresolution_instance::ta
 #ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
 void streamfx::filter::video_superresolution::video_superresolution_instance::nvvfxsr_load()
 {
-	_nvidia_fx = std::make_shared<::streamfx::nvidia::vfx::superresolution>();
+	// Runs in the provider task, so this is where the SDKs are loaded for the first instance.
+	auto factory = video_superresolution_factory::get();
+	if (!factory->load_provider(video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION)) {
+		throw std::runtime_error("NVIDIA Video Super-Resolution is unavailable.");
+	}
+
+	auto    data   = obs_source_get_settings(_self);
+	int32_t device = static_cast<int32_t>(obs_data_get_int(data, ST_KEY_NVIDIA_SUPERRES_DEVICE));
+	obs_data_release(data);
+
+	_nvidia_fx = std::make_shared<::streamfx::nvidia::vfx::superresolution>(device);
 }
 
 void streamfx::filter::video_superresolution::video_superresolution_instance::nvvfxsr_unload()
@@ -444,6 +644,9 @@ void streamfx::filter::video_superresolution::video_superresolution_instance::nv
 	}
 
 	_output = _nvidia_fx->process(_input->get_texture());
+
+	// The models take up far more than the buffers, and stay loaded for as long as the effect is kept.
+	_statistics->set_video_memory(_nvidia_fx->memory_usage() + _nvidia_fx->model_memory());
 }
 
 void streamfx::filter::video_superresolution::video_superresolution_instance::nvvfxsr_properties(
@@ -461,11 +664,55 @@ void streamfx::filter::video_superresolution::video_superresolution_instance::nv
 		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_NVIDIA_SUPERRES_STRENGTH_STRONG), 1);
 	}
 
+	{
+		auto p = obs_properties_add_list(grp, ST_KEY_NVIDIA_SUPERRES_ARTIFACTREDUCTION,
+										 D_TRANSLATE(ST_I18N_NVIDIA_SUPERRES_ARTIFACTREDUCTION), OBS_COMBO_TYPE_LIST,
+										 OBS_COMBO_FORMAT_INT);
+		obs_property_list_add_int(p, D_TRANSLATE(S_STATE_DISABLED), -1);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_NVIDIA_SUPERRES_STRENGTH_WEAK), 0);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_NVIDIA_SUPERRES_STRENGTH_STRONG), 1);
+	}
+
 	{
 		auto p = obs_properties_add_float_slider(grp, ST_KEY_NVIDIA_SUPERRES_SCALE,
 												 D_TRANSLATE(ST_I18N_NVIDIA_SUPERRES_SCALE), 100.00, 400.00, .01);
 		obs_property_float_set_suffix(p, " %");
 	}
+
+	{
+		auto p =
+			obs_properties_add_list(grp, ST_KEY_NVIDIA_SUPERRES_DEVICE, D_TRANSLATE(ST_I18N_NVIDIA_SUPERRES_DEVICE),
+									OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+		obs_property_list_add_int(p, D_TRANSLATE(S_STATE_AUTOMATIC), -1);
+		if (_nvidia_fx) {
+			auto devices = ::streamfx::nvidia::cuda::obs::get()->get_devices();
+			for (std::size_t idx = 0; idx < devices.size(); idx++) {
+				obs_property_list_add_int(p, devices[idx].c_str(), static_cast<int64_t>(idx));
+			}
+		}
+	}
+
+	{
+		obs_properties_add_bool(grp, ST_KEY_NVIDIA_SUPERRES_ASYNCHRONOUS,
+								D_TRANSLATE(ST_I18N_NVIDIA_SUPERRES_ASYNCHRONOUS));
+	}
+
+	{
+		obs_properties_add_bool(grp, ST_KEY_NVIDIA_SUPERRES_GRAPHS, D_TRANSLATE(ST_I18N_NVIDIA_SUPERRES_GRAPHS));
+	}
+
+	{
+		auto p = obs_properties_add_int_slider(grp, ST_KEY_NVIDIA_SUPERRES_MEMORYBUDGET,
+											   D_TRANSLATE(ST_I18N_NVIDIA_SUPERRES_MEMORYBUDGET), 0, 4096, 16);
+		obs_property_int_set_suffix(p, " MB");
+	}
+
+	if (_nvidia_fx) {
+		std::vector<char> buffer(256);
+		snprintf(buffer.data(), buffer.size(), D_TRANSLATE(ST_I18N_NVIDIA_SUPERRES_MEMORYUSAGE),
+				 static_cast<double>(_nvidia_fx->memory_usage()) / 1048576., _nvidia_fx->tiles());
+		obs_properties_add_text(grp, ST_KEY_NVIDIA_SUPERRES_MEMORYUSAGE, buffer.data(), OBS_TEXT_INFO);
+	}
 }
 
 void streamfx::filter::video_superresolution::video_superresolution_instance::nvvfxsr_update(obs_data_t* data)
@@ -476,8 +723,130 @@ void streamfx::filter::video_superresolution::video_superresolution_instance::nv
 	_nvidia_fx->set_strength(
 		static_cast<float>(obs_data_get_int(data, ST_KEY_NVIDIA_SUPERRES_STRENGTH) == 0 ? 0. : 1.));
 	_nvidia_fx->set_scale(static_cast<float>(obs_data_get_double(data, ST_KEY_NVIDIA_SUPERRES_SCALE) / 100.));
+	{
+		int64_t mode = obs_data_get_int(data, ST_KEY_NVIDIA_SUPERRES_ARTIFACTREDUCTION);
+		_nvidia_fx->set_artifact_reduction_strength(mode == 1 ? 1.f : 0.f);
+		_nvidia_fx->set_artifact_reduction(mode >= 0);
+	}
+	_nvidia_fx->set_asynchronous(obs_data_get_bool(data, ST_KEY_NVIDIA_SUPERRES_ASYNCHRONOUS));
+	_nvidia_fx->set_graphs(obs_data_get_bool(data, ST_KEY_NVIDIA_SUPERRES_GRAPHS));
+	_nvidia_fx->set_memory_budget(static_cast<uint64_t>(obs_data_get_int(data, ST_KEY_NVIDIA_SUPERRES_MEMORYBUDGET))
+								  << 20);
+}
+
+#endif
+
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+void streamfx::filter::video_superresolution::video_superresolution_instance::edge_load()
+{
+	auto path = streamfx::data_file_path("effects/edge-adaptive-upscale.effect");
+	try {
+		_edge_effect = ::streamfx::obs::gs::effect::create_shared(path);
+	} catch (const std::exception& ex) {
+		D_LOG_ERROR("Failed to load '%s': %s", path.u8string().c_str(), ex.what());
+		throw;
+	}
+
+	_edge_upscale = std::make_shared<::streamfx::obs::gs::rendertarget>(GS_RGBA_UNORM, GS_ZS_NONE);
+	_edge_sharpen = std::make_shared<::streamfx::obs::gs::rendertarget>(GS_RGBA_UNORM, GS_ZS_NONE);
+}
+
+void streamfx::filter::video_superresolution::video_superresolution_instance::edge_unload()
+{
+	_edge_sharpen.reset();
+	_edge_upscale.reset();
+	_edge_effect.reset();
+}
+
+void streamfx::filter::video_superresolution::video_superresolution_instance::edge_size()
+{
+	auto scale = [this](uint32_t v) {
+		long scaled = std::lround(static_cast<float_t>(v) * _edge_scale);
+		return std::clamp<uint32_t>(static_cast<uint32_t>(scaled), 1, 16384);
+	};
+	_out_size = {scale(_in_size.first), scale(_in_size.second)};
+}
+
+void streamfx::filter::video_superresolution::video_superresolution_instance::edge_process()
+{
+	if (!_edge_effect || !_edge_upscale || !_edge_sharpen) {
+		_output = _input->get_texture();
+		return;
+	}
+
+	gs_blend_state_push();
+	gs_reset_blend_state();
+	gs_enable_blending(false);
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	gs_enable_color(true, true, true, true);
+	gs_enable_depth_test(false);
+	gs_enable_stencil_test(false);
+	gs_enable_stencil_write(false);
+	gs_set_cull_mode(GS_NEITHER);
+
+	{ // Upscale from the input resolution.
+#ifdef ENABLE_PROFILING
+		::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_convert, "Upscale"};
+#endif
+		auto op = _edge_upscale->render(_out_size.first, _out_size.second);
+		gs_ortho(0., 1., 0., 1., 0., 1.);
+
+		_edge_effect.get_parameter("image").set_texture(_input->get_texture());
+		_edge_effect.get_parameter("imageSize")
+			.set_float2(static_cast<float_t>(_in_size.first), static_cast<float_t>(_in_size.second));
+		_edge_effect.get_parameter("imageTexel")
+			.set_float2(1.f / static_cast<float_t>(_in_size.first), 1.f / static_cast<float_t>(_in_size.second));
+		while (gs_effect_loop(_edge_effect.get_object(), "Upscale")) {
+			streamfx::gs_draw_fullscreen_tri();
+		}
+	}
+	_output = _edge_upscale->get_texture();
+
+	if (_edge_sharpness > 0.f) { // Sharpen at the output resolution.
+#ifdef ENABLE_PROFILING
+		::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_convert, "Sharpen"};
+#endif
+		auto op = _edge_sharpen->render(_out_size.first, _out_size.second);
+		gs_ortho(0., 1., 0., 1., 0., 1.);
+
+		_edge_effect.get_parameter("image").set_texture(_output);
+		_edge_effect.get_parameter("imageSize")
+			.set_float2(static_cast<float_t>(_out_size.first), static_cast<float_t>(_out_size.second));
+		_edge_effect.get_parameter("imageTexel")
+			.set_float2(1.f / static_cast<float_t>(_out_size.first), 1.f / static_cast<float_t>(_out_size.second));
+		_edge_effect.get_parameter("sharpness").set_float(_edge_sharpness);
+		while (gs_effect_loop(_edge_effect.get_object(), "Sharpen")) {
+			streamfx::gs_draw_fullscreen_tri();
+		}
+		_output = _edge_sharpen->get_texture();
+	}
+
+	gs_blend_state_pop();
+}
+
+void streamfx::filter::video_superresolution::video_superresolution_instance::edge_properties(obs_properties_t* props)
+{
+	obs_properties_t* grp = obs_properties_create();
+	obs_properties_add_group(props, ST_KEY_EDGE_UPSCALE, D_TRANSLATE(ST_I18N_EDGE_UPSCALE), OBS_GROUP_NORMAL, grp);
+
+	{
+		auto p = obs_properties_add_float_slider(grp, ST_KEY_EDGE_UPSCALE_SCALE,
+												 D_TRANSLATE(ST_I18N_EDGE_UPSCALE_SCALE), 100.00, 400.00, .01);
+		obs_property_float_set_suffix(p, " %");
+	}
+
+	{
+		auto p = obs_properties_add_float_slider(grp, ST_KEY_EDGE_UPSCALE_SHARPNESS,
+												 D_TRANSLATE(ST_I18N_EDGE_UPSCALE_SHARPNESS), 0.00, 100.00, .01);
+		obs_property_float_set_suffix(p, " %");
+	}
 }
 
+void streamfx::filter::video_superresolution::video_superresolution_instance::edge_update(obs_data_t* data)
+{
+	_edge_scale     = static_cast<float_t>(obs_data_get_double(data, ST_KEY_EDGE_UPSCALE_SCALE) / 100.);
+	_edge_sharpness = static_cast<float_t>(obs_data_get_double(data, ST_KEY_EDGE_UPSCALE_SHARPNESS) / 100.);
+}
 #endif
 
 //------------------------------------------------------------------------------
@@ -489,27 +858,19 @@ video_superresolution_factory::video_superresolution_factory()
 {
 	bool any_available = false;
 
-	// 1. Try and load any configured providers.
+	// 1. Providers take long to load, so they are only loaded once an instance needs them.
 #ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
-	try {
-		// Load CVImage and Video Effects SDK.
-		_nvcuda           = ::streamfx::nvidia::cuda::obs::get();
-		_nvcvi            = ::streamfx::nvidia::cv::cv::get();
-		_nvvfx            = ::streamfx::nvidia::vfx::vfx::get();
-		_nvidia_available = true;
-		any_available |= _nvidia_available;
-	} catch (const std::exception& ex) {
-		_nvidia_available = false;
-		_nvvfx.reset();
-		_nvcvi.reset();
-		_nvcuda.reset();
-		D_LOG_WARNING("Failed to make NVIDIA Super-Resolution available due to error: %s", ex.what());
-	}
+	_nvidia_loaded    = false;
+	_nvidia_available = false;
+	any_available     = true;
+#endif
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+	any_available = true;
 #endif
 
-	// 2. Check if any of them managed to load at all.
+	// 2. Check if any of them are built in at all.
 	if (!any_available) {
-		D_LOG_ERROR("All supported Super-Resolution providers failed to initialize, disabling effect.", 0);
+		D_LOG_ERROR("No supported Super-Resolution providers are available, disabling effect.", 0);
 		return;
 	}
 
@@ -534,6 +895,16 @@ void video_superresolution_factory::get_defaults2(obs_data_t* data)
 #ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
 	obs_data_set_default_double(data, ST_KEY_NVIDIA_SUPERRES_SCALE, 150.);
 	obs_data_set_default_double(data, ST_KEY_NVIDIA_SUPERRES_STRENGTH, 0.);
+	obs_data_set_default_int(data, ST_KEY_NVIDIA_SUPERRES_ARTIFACTREDUCTION, -1);
+	obs_data_set_default_int(data, ST_KEY_NVIDIA_SUPERRES_DEVICE, -1);
+	obs_data_set_default_bool(data, ST_KEY_NVIDIA_SUPERRES_ASYNCHRONOUS, false);
+	obs_data_set_default_bool(data, ST_KEY_NVIDIA_SUPERRES_GRAPHS, false);
+	obs_data_set_default_int(data, ST_KEY_NVIDIA_SUPERRES_MEMORYBUDGET, 0);
+#endif
+
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+	obs_data_set_default_double(data, ST_KEY_EDGE_UPSCALE_SCALE, 150.);
+	obs_data_set_default_double(data, ST_KEY_EDGE_UPSCALE_SHARPNESS, 25.);
 #endif
 }
 
@@ -548,6 +919,13 @@ obs_properties_t* video_superresolution_factory::get_properties2(video_superreso
 	}
 #endif
 
+	for (auto v : provider_priority) {
+		if (is_provider_available(v) && !is_provider_loaded(v)) {
+			obs_properties_add_text(pr, ST_KEY_STATE, D_TRANSLATE(ST_I18N_STATE_INITIALIZING), OBS_TEXT_INFO);
+			break;
+		}
+	}
+
 	if (data) {
 		data->properties(pr);
 	}
@@ -564,6 +942,8 @@ obs_properties_t* video_superresolution_factory::get_properties2(video_superreso
 			obs_property_list_add_int(
 				p, D_TRANSLATE(ST_I18N_PROVIDER_NVIDIA_SUPERRES),
 				static_cast<int64_t>(video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION));
+			obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_PROVIDER_EDGE_UPSCALE),
+									  static_cast<int64_t>(video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE));
 		}
 	}
 
@@ -584,7 +964,63 @@ bool streamfx::filter::video_superresolution::video_superresolution_factory::is_
 	switch (provider) {
 #ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
 	case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION:
+		return !_nvidia_loaded || _nvidia_available;
+#endif
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+	case video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+bool streamfx::filter::video_superresolution::video_superresolution_factory::load_provider(
+	video_superresolution_provider provider)
+{
+	switch (provider) {
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
+	case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION: {
+		std::unique_lock<std::mutex> lock{_nvidia_lock};
+		if (!_nvidia_loaded) {
+			try {
+				// Load CVImage and Video Effects SDK.
+				_nvcuda           = ::streamfx::nvidia::cuda::obs::get();
+				_nvcvi            = ::streamfx::nvidia::cv::cv::get();
+				_nvvfx            = ::streamfx::nvidia::vfx::vfx::get();
+				_nvidia_available = true;
+			} catch (const std::exception& ex) {
+				_nvidia_available = false;
+				_nvvfx.reset();
+				_nvcvi.reset();
+				_nvcuda.reset();
+				D_LOG_WARNING("Failed to make NVIDIA Super-Resolution available due to error: %s", ex.what());
+			}
+			_nvidia_loaded = true;
+		}
 		return _nvidia_available;
+	}
+#endif
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+	case video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE:
+		return true; // Only needs the effect, which each instance loads.
+#endif
+	default:
+		return false;
+	}
+}
+
+bool streamfx::filter::video_superresolution::video_superresolution_factory::is_provider_loaded(
+	video_superresolution_provider provider)
+{
+	switch (provider) {
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
+	case video_superresolution_provider::NVIDIA_VIDEO_SUPERRESOLUTION:
+		return _nvidia_loaded;
+#endif
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+	case video_superresolution_provider::EDGE_ADAPTIVE_UPSCALE:
+		return true;
 #endif
 	default:
 		return false;
@@ -22,8 +22,10 @@
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include "obs/gs/gs-effect.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-texture.hpp"
+#include "obs/obs-governor.hpp"
 #include "obs/obs-source-factory.hpp"
 #include "plugin.hpp"
 #include "util/util-threadpool.hpp"
@@ -37,29 +39,41 @@ namespace streamfx::filter::video_superresolution {
 		INVALID                      = -1,
 		AUTOMATIC                    = 0,
 		NVIDIA_VIDEO_SUPERRESOLUTION = 1,
+		EDGE_ADAPTIVE_UPSCALE        = 2,
 	};
 
 	const char* cstring(video_superresolution_provider provider);
 
 	std::string string(video_superresolution_provider provider);
 
-	class video_superresolution_instance : public ::streamfx::obs::source_instance {
+	class video_superresolution_instance : public ::streamfx::obs::source_instance, public ::streamfx::obs::degradable {
 		std::pair<uint32_t, uint32_t> _in_size;
 		std::pair<uint32_t, uint32_t> _out_size;
 
-		std::atomic<bool>                           _provider_ready;
+		std::shared_ptr<std::atomic<bool>>          _provider_ready; // Shared with _provider_publish.
 		std::atomic<video_superresolution_provider> _provider;
+		std::atomic<bool>                           _provider_automatic; // Falls back if _provider fails to load.
 		std::mutex                                  _provider_lock;
 		std::shared_ptr<util::threadpool::task>     _provider_task;
+		std::shared_ptr<util::threadpool::task>     _provider_publish; // Continuation of _provider_task.
 
 		std::shared_ptr<::streamfx::obs::gs::rendertarget> _input;
 		std::shared_ptr<::streamfx::obs::gs::texture>      _output;
 		bool                                               _dirty;
+		uint32_t                                           _skipped; // Frames since the last processed one.
 
 #ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
 		std::shared_ptr<::streamfx::nvidia::vfx::superresolution> _nvidia_fx;
 #endif
 
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+		::streamfx::obs::gs::effect                        _edge_effect;
+		std::shared_ptr<::streamfx::obs::gs::rendertarget> _edge_upscale;
+		std::shared_ptr<::streamfx::obs::gs::rendertarget> _edge_sharpen;
+		float_t                                            _edge_scale;
+		float_t                                            _edge_sharpness;
+#endif
+
 		public:
 		video_superresolution_instance(obs_data_t* data, obs_source_t* self);
 		~video_superresolution_instance() override;
@@ -75,8 +89,11 @@ namespace streamfx::filter::video_superresolution {
 		void video_tick(float_t time) override;
 		void video_render(gs_effect_t* effect) override;
 
+		virtual void idle() override;
+
 		private:
 		void switch_provider(video_superresolution_provider provider);
+		void queue_provider(video_superresolution_provider provider);
 		void task_switch_provider(util::threadpool_data_t data);
 
 #ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
@@ -87,6 +104,15 @@ namespace streamfx::filter::video_superresolution {
 		void nvvfxsr_properties(obs_properties_t* props);
 		void nvvfxsr_update(obs_data_t* data);
 #endif
+
+#ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_EDGE
+		void edge_load();
+		void edge_unload();
+		void edge_size();
+		void edge_process();
+		void edge_properties(obs_properties_t* props);
+		void edge_update(obs_data_t* data);
+#endif
 	};
 
 	class video_superresolution_factory
@@ -94,6 +120,8 @@ namespace streamfx::filter::video_superresolution {
 			  ::streamfx::filter::video_superresolution::video_superresolution_factory,
 			  ::streamfx::filter::video_superresolution::video_superresolution_instance> {
 #ifdef ENABLE_FILTER_VIDEO_SUPERRESOLUTION_NVIDIA
+		std::mutex                                     _nvidia_lock; // Held while loading the SDKs.
+		std::atomic_bool                               _nvidia_loaded; // Set once loading finished, even if it failed.
 		bool                                           _nvidia_available;
 		std::shared_ptr<::streamfx::nvidia::cuda::obs> _nvcuda;
 		std::shared_ptr<::streamfx::nvidia::cv::cv>    _nvcvi;
@@ -113,8 +141,14 @@ namespace streamfx::filter::video_superresolution {
 		static bool on_manual_open(obs_properties_t* props, obs_property_t* property, void* data);
 #endif
 
+		/** Whether a provider is usable, which is assumed until loading it failed. */
 		bool is_provider_available(video_superresolution_provider);
 
+		/** Load a provider right away, or wait for a load that is already in progress. */
+		bool load_provider(video_superresolution_provider);
+
+		bool is_provider_loaded(video_superresolution_provider);
+
 		public: // Singleton
 		static void                                                                                      initialize();
 		static void                                                                                      finalize();
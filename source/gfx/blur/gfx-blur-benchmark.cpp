@@ -0,0 +1,190 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#include "gfx-blur-benchmark.hpp"
+#include <algorithm>
+#include "obs/gs/gs-helper.hpp"
+#include "obs/gs/gs-rendertarget.hpp"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <obs.h>
+#include <util/platform.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+// Give up on a query if the GPU has not answered within this time.
+#define ST_QUERY_TIMEOUT 1000000000ull // ns
+
+static const std::pair<uint32_t, uint32_t> resolutions[] = {
+	{1280, 720},
+	{1920, 1080},
+	{3840, 2160},
+};
+static const double_t sizes[] = {2., 8., 16., 32., 64., 128.};
+
+streamfx::gfx::blur::benchmark::benchmark(
+	const std::vector<std::pair<std::string, ::streamfx::gfx::blur::ifactory*>>& factories, std::size_t iterations)
+	: _jobs(), _pending(), _iterations(iterations), _current(0), _step(0), _input(), _input_width(0), _input_height(0),
+	  _blur(), _blur_job(0)
+{
+	::streamfx::gfx::blur::type types[] = {
+		::streamfx::gfx::blur::type::Area,
+		::streamfx::gfx::blur::type::Directional,
+		::streamfx::gfx::blur::type::Rotational,
+		::streamfx::gfx::blur::type::Zoom,
+	};
+
+	for (auto resolution : resolutions) {
+		for (auto& kv : factories) {
+			for (auto type : types) {
+				if (!kv.second->is_type_supported(type)) {
+					continue;
+				}
+
+				double_t last_size = -1.;
+				for (auto size : sizes) {
+					size = std::clamp(size, kv.second->get_min_size(type), kv.second->get_max_size(type));
+					if (size == last_size) {
+						continue;
+					}
+					last_size = size;
+
+					_jobs.push_back({kv.first, kv.second, type, resolution.first, resolution.second, size, 0., 0,
+									 false});
+				}
+			}
+		}
+	}
+}
+
+streamfx::gfx::blur::benchmark::~benchmark()
+{
+	auto gctx = streamfx::obs::gs::context();
+	for (auto& entry : _pending) {
+		gs_timer_destroy(entry.timer);
+		gs_timer_range_destroy(entry.range);
+	}
+	_pending.clear();
+	_blur.reset();
+	_input.reset();
+}
+
+bool streamfx::gfx::blur::benchmark::step()
+{
+	poll();
+	if (_current >= _jobs.size()) {
+		return _pending.empty();
+	}
+
+	auto& current = _jobs[_current];
+	if (_step == 0) {
+		if (!_input || (_input_width != current.width) || (_input_height != current.height)) {
+			if (!_input) {
+				_input = std::make_shared<::streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+			}
+			{ // The content does not matter to any of the algorithms, only its size does.
+				auto op = _input->render(current.width, current.height);
+				vec4 color;
+				vec4_set(&color, 0.5f, 0.5f, 0.5f, 1.0f);
+				gs_clear(GS_CLEAR_COLOR, &color, 0, 0);
+			}
+			_input_width  = current.width;
+			_input_height = current.height;
+			_blur.reset();
+		}
+
+		if (!_blur || (_jobs[_blur_job].factory != current.factory) || (_jobs[_blur_job].type != current.type)) {
+			_blur     = current.factory->create(current.type);
+			_blur_job = _current;
+			_blur->set_input(_input->get_texture());
+			if (auto obj = std::dynamic_pointer_cast<::streamfx::gfx::blur::base_angle>(_blur); obj) {
+				obj->set_angle(45.);
+			}
+			if (auto obj = std::dynamic_pointer_cast<::streamfx::gfx::blur::base_center>(_blur); obj) {
+				obj->set_center(0.5, 0.5);
+			}
+		}
+		_blur->set_size(current.size);
+
+		// The first render allocates all intermediate targets, so keep it out of the measurement.
+		_blur->render();
+	} else {
+		gs_timer_range_t* range = gs_timer_range_create();
+		gs_timer_t*       timer = gs_timer_create();
+		if (range && timer) {
+			gs_timer_range_begin(range);
+			gs_timer_begin(timer);
+			_blur->render();
+			gs_timer_end(timer);
+			gs_timer_range_end(range);
+			_pending.push_back({_current, timer, range, os_gettime_ns()});
+		} else {
+			gs_timer_destroy(timer);
+			gs_timer_range_destroy(range);
+			current.failed = true;
+		}
+	}
+
+	if (++_step > _iterations) {
+		_step = 0;
+		_current++;
+	}
+	return false;
+}
+
+void streamfx::gfx::blur::benchmark::poll()
+{
+	for (auto iter = _pending.begin(); iter != _pending.end();) {
+		uint64_t ticks     = 0;
+		uint64_t frequency = 0;
+		bool     disjoint  = true;
+		bool     ready     = gs_timer_range_get_data(iter->range, &disjoint, &frequency)
+					 && gs_timer_get_data(iter->timer, &ticks);
+		if (!ready && ((os_gettime_ns() - iter->issued) < ST_QUERY_TIMEOUT)) {
+			++iter;
+			continue;
+		}
+
+		// Disjoint or unanswered queries are reported as unavailable instead of guessed.
+		auto& owner = _jobs[iter->job];
+		if (ready && !disjoint && (frequency != 0)) {
+			owner.total += (static_cast<double_t>(ticks) * 1000000.0) / static_cast<double_t>(frequency);
+			owner.samples++;
+		} else {
+			owner.failed = true;
+		}
+
+		gs_timer_destroy(iter->timer);
+		gs_timer_range_destroy(iter->range);
+		iter = _pending.erase(iter);
+	}
+}
+
+std::vector<streamfx::gfx::blur::benchmark::result> streamfx::gfx::blur::benchmark::get_results()
+{
+	std::vector<result> results;
+	results.reserve(_jobs.size());
+	for (auto& entry : _jobs) {
+		double_t time = (entry.failed || (entry.samples == 0)) ? -1. : entry.total / entry.samples;
+		results.push_back({entry.name, entry.type, entry.width, entry.height, entry.size, time});
+	}
+	return results;
+}
@@ -0,0 +1,95 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#pragma once
+#include "common.hpp"
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gfx-blur-base.hpp"
+#include "obs/gs/gs-rendertarget.hpp"
+
+namespace streamfx::gfx {
+	namespace blur {
+		/** Measures the GPU time taken by blur algorithms.
+		 *
+		 * Every supported subtype is rendered offscreen against a flat input at each resolution and size, and timed
+		 * with GPU timestamp queries. The work is split into steps of a single render each, one per frame, and the
+		 * queries are only ever polled. So the graphics thread never waits on the GPU for it.
+		 */
+		class benchmark {
+			public:
+			struct result {
+				std::string                 name;
+				::streamfx::gfx::blur::type type;
+				uint32_t                    width;
+				uint32_t                    height;
+				double_t                    size;
+				double_t                    time; // Microseconds per render, negative if unavailable.
+			};
+
+			private:
+			struct job {
+				std::string                      name;
+				::streamfx::gfx::blur::ifactory* factory;
+				::streamfx::gfx::blur::type      type;
+				uint32_t                         width;
+				uint32_t                         height;
+				double_t                         size;
+				double_t                         total; // Microseconds, over all samples.
+				std::size_t                      samples;
+				bool                             failed;
+			};
+			struct query {
+				std::size_t       job;
+				gs_timer_t*       timer;
+				gs_timer_range_t* range;
+				uint64_t          issued;
+			};
+
+			std::vector<job> _jobs;
+			std::list<query> _pending;
+			std::size_t      _iterations;
+			std::size_t      _current;
+			std::size_t      _step; // 0 is the warm-up render, the others are measured.
+
+			std::shared_ptr<::streamfx::obs::gs::rendertarget> _input;
+			uint32_t                                           _input_width;
+			uint32_t                                           _input_height;
+			std::shared_ptr<::streamfx::gfx::blur::base>       _blur;
+			std::size_t                                        _blur_job;
+
+			public:
+			benchmark(const std::vector<std::pair<std::string, ::streamfx::gfx::blur::ifactory*>>& factories,
+					  std::size_t iterations = 8);
+			~benchmark();
+
+			/** Render the next step and collect any timings the GPU has answered since.
+			 *
+			 * Must be called with the graphics context entered, usually once per frame.
+			 * @return true once every result is in.
+			 */
+			bool step();
+
+			std::vector<result> get_results();
+
+			private:
+			void poll();
+		};
+	} // namespace blur
+} // namespace streamfx::gfx
@@ -67,6 +67,10 @@ bool streamfx::gfx::blur::box_linear_factory::is_type_supported(::streamfx::gfx:
 		return true;
 	case ::streamfx::gfx::blur::type::Directional:
 		return true;
+	case ::streamfx::gfx::blur::type::Rotational:
+		return true;
+	case ::streamfx::gfx::blur::type::Zoom:
+		return true;
 	default:
 		return false;
 	}
@@ -80,6 +84,10 @@ std::shared_ptr<::streamfx::gfx::blur::base>
 		return std::make_shared<::streamfx::gfx::blur::box_linear>();
 	case ::streamfx::gfx::blur::type::Directional:
 		return std::make_shared<::streamfx::gfx::blur::box_linear_directional>();
+	case ::streamfx::gfx::blur::type::Rotational:
+		return std::make_shared<::streamfx::gfx::blur::box_linear_rotational>();
+	case ::streamfx::gfx::blur::type::Zoom:
+		return std::make_shared<::streamfx::gfx::blur::box_linear_zoom>();
 	default:
 		throw std::runtime_error("Invalid type.");
 	}
@@ -190,7 +198,7 @@ streamfx::gfx::blur::box_linear::box_linear()
 	: _data(::streamfx::gfx::blur::box_linear_factory::get().data()), _size(1.), _step_scale({1., 1.})
 {
 	_rendertarget  = std::make_shared<::streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-	_rendertarget2 = std::make_shared<::streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	_pool          = ::streamfx::obs::gs::rendertarget_pool::instance();
 }
 
 streamfx::gfx::blur::box_linear::~box_linear() {}
@@ -267,6 +275,7 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::box_linear::r
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
 	// Two Pass Blur
+	auto rendertarget2 = _pool->acquire(uint32_t(width), uint32_t(height));
 	streamfx::obs::gs::effect effect = _data->get_effect();
 	if (effect) {
 		// Pass 1
@@ -281,7 +290,7 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::box_linear::r
 			auto gdm = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Horizontal");
 #endif
 
-			auto op = _rendertarget2->render(uint32_t(width), uint32_t(height));
+			auto op = rendertarget2->render(uint32_t(width), uint32_t(height));
 			gs_ortho(0, 1., 0, 1., 0, 1.);
 			while (gs_effect_loop(effect.get_object(), "Draw")) {
 				streamfx::gs_draw_fullscreen_tri();
@@ -289,7 +298,7 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::box_linear::r
 		}
 
 		// Pass 2
-		effect.get_parameter("pImage").set_texture(_rendertarget2->get_texture());
+		effect.get_parameter("pImage").set_texture(rendertarget2->get_texture());
 		effect.get_parameter("pImageTexel").set_float2(0., float_t(1.f / height));
 
 		{
@@ -380,3 +389,149 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::box_linear_di
 
 	return _rendertarget->get_texture();
 }
+
+streamfx::gfx::blur::box_linear_rotational::box_linear_rotational() : _center({0.5, 0.5}), _angle(0) {}
+
+::streamfx::gfx::blur::type streamfx::gfx::blur::box_linear_rotational::get_type()
+{
+	return ::streamfx::gfx::blur::type::Rotational;
+}
+
+void streamfx::gfx::blur::box_linear_rotational::set_center(double_t x, double_t y)
+{
+	_center.first  = x;
+	_center.second = y;
+}
+
+void streamfx::gfx::blur::box_linear_rotational::get_center(double_t& x, double_t& y)
+{
+	x = _center.first;
+	y = _center.second;
+}
+
+double_t streamfx::gfx::blur::box_linear_rotational::get_angle()
+{
+	return D_RAD_TO_DEG(_angle);
+}
+
+void streamfx::gfx::blur::box_linear_rotational::set_angle(double_t angle)
+{
+	_angle = D_DEG_TO_RAD(angle);
+}
+
+std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::box_linear_rotational::render()
+{
+	auto gctx = streamfx::obs::gs::context();
+
+#ifdef ENABLE_PROFILING
+	auto gdmp =
+		streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Box Linear Rotational Blur");
+#endif
+
+	float_t width  = float_t(_input_texture->get_width());
+	float_t height = float_t(_input_texture->get_height());
+
+	gs_blend_state_push();
+	gs_reset_blend_state();
+	gs_enable_color(true, true, true, true);
+	gs_enable_blending(false);
+	gs_enable_depth_test(false);
+	gs_enable_stencil_test(false);
+	gs_enable_stencil_write(false);
+	gs_set_cull_mode(GS_NEITHER);
+	gs_depth_function(GS_ALWAYS);
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
+	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
+
+	// One Pass Blur
+	streamfx::obs::gs::effect effect = _data->get_effect();
+	if (effect) {
+		effect.get_parameter("pImage").set_texture(_input_texture);
+		effect.get_parameter("pImageTexel").set_float2(float_t(1.f / width), float_t(1.f / height));
+		effect.get_parameter("pStepScale").set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
+		effect.get_parameter("pSize").set_float(float_t(_size));
+		effect.get_parameter("pSizeInverseMul").set_float(float_t(1.0f / (float_t(_size) * 2.0f + 1.0f)));
+		effect.get_parameter("pAngle").set_float(float_t(_angle / _size));
+		effect.get_parameter("pCenter").set_float2(float_t(_center.first), float_t(_center.second));
+
+		{
+			auto op = _rendertarget->render(uint32_t(width), uint32_t(height));
+			gs_ortho(0, 1., 0, 1., 0, 1.);
+			while (gs_effect_loop(effect.get_object(), "Rotate")) {
+				streamfx::gs_draw_fullscreen_tri();
+			}
+		}
+	}
+
+	gs_blend_state_pop();
+
+	return _rendertarget->get_texture();
+}
+
+streamfx::gfx::blur::box_linear_zoom::box_linear_zoom() : _center({0.5, 0.5}) {}
+
+::streamfx::gfx::blur::type streamfx::gfx::blur::box_linear_zoom::get_type()
+{
+	return ::streamfx::gfx::blur::type::Zoom;
+}
+
+void streamfx::gfx::blur::box_linear_zoom::set_center(double_t x, double_t y)
+{
+	_center.first  = x;
+	_center.second = y;
+}
+
+void streamfx::gfx::blur::box_linear_zoom::get_center(double_t& x, double_t& y)
+{
+	x = _center.first;
+	y = _center.second;
+}
+
+std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::box_linear_zoom::render()
+{
+	auto gctx = streamfx::obs::gs::context();
+
+#ifdef ENABLE_PROFILING
+	auto gdmp = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Box Linear Zoom Blur");
+#endif
+
+	float_t width  = float_t(_input_texture->get_width());
+	float_t height = float_t(_input_texture->get_height());
+
+	gs_blend_state_push();
+	gs_reset_blend_state();
+	gs_enable_color(true, true, true, true);
+	gs_enable_blending(false);
+	gs_enable_depth_test(false);
+	gs_enable_stencil_test(false);
+	gs_enable_stencil_write(false);
+	gs_set_cull_mode(GS_NEITHER);
+	gs_depth_function(GS_ALWAYS);
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
+	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
+
+	// One Pass Blur
+	streamfx::obs::gs::effect effect = _data->get_effect();
+	if (effect) {
+		effect.get_parameter("pImage").set_texture(_input_texture);
+		effect.get_parameter("pImageTexel").set_float2(float_t(1.f / width), float_t(1.f / height));
+		effect.get_parameter("pStepScale").set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
+		effect.get_parameter("pSize").set_float(float_t(_size));
+		effect.get_parameter("pSizeInverseMul").set_float(float_t(1.0f / (float_t(_size) * 2.0f + 1.0f)));
+		effect.get_parameter("pCenter").set_float2(float_t(_center.first), float_t(_center.second));
+
+		{
+			auto op = _rendertarget->render(uint32_t(width), uint32_t(height));
+			gs_ortho(0, 1., 0, 1., 0, 1.);
+			while (gs_effect_loop(effect.get_object(), "Zoom")) {
+				streamfx::gs_draw_fullscreen_tri();
+			}
+		}
+	}
+
+	gs_blend_state_pop();
+
+	return _rendertarget->get_texture();
+}
@@ -20,6 +20,7 @@
 #include <mutex>
 #include "gfx-blur-base.hpp"
 #include "obs/gs/gs-effect.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-texture.hpp"
 
@@ -89,7 +90,7 @@ namespace streamfx::gfx {
 			std::shared_ptr<::streamfx::obs::gs::rendertarget> _rendertarget;
 
 			private:
-			std::shared_ptr<::streamfx::obs::gs::rendertarget> _rendertarget2;
+			std::shared_ptr<::streamfx::obs::gs::rendertarget_pool> _pool;
 
 			public:
 			box_linear();
@@ -123,6 +124,39 @@ namespace streamfx::gfx {
 			virtual double_t get_angle() override;
 			virtual void     set_angle(double_t angle) override;
 
+			virtual std::shared_ptr<::streamfx::obs::gs::texture> render() override;
+		};
+		class box_linear_rotational : public ::streamfx::gfx::blur::box_linear,
+									  public ::streamfx::gfx::blur::base_angle,
+									  public ::streamfx::gfx::blur::base_center {
+			std::pair<double_t, double_t> _center;
+			double_t                      _angle;
+
+			public:
+			box_linear_rotational();
+
+			virtual ::streamfx::gfx::blur::type get_type() override;
+
+			virtual void set_center(double_t x, double_t y) override;
+			virtual void get_center(double_t& x, double_t& y) override;
+
+			virtual double_t get_angle() override;
+			virtual void     set_angle(double_t angle) override;
+
+			virtual std::shared_ptr<::streamfx::obs::gs::texture> render() override;
+		};
+
+		class box_linear_zoom : public ::streamfx::gfx::blur::box_linear, public ::streamfx::gfx::blur::base_center {
+			std::pair<double_t, double_t> _center;
+
+			public:
+			box_linear_zoom();
+
+			virtual ::streamfx::gfx::blur::type get_type() override;
+
+			virtual void set_center(double_t x, double_t y) override;
+			virtual void get_center(double_t& x, double_t& y) override;
+
 			virtual std::shared_ptr<::streamfx::obs::gs::texture> render() override;
 		};
 	} // namespace blur
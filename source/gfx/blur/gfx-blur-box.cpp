@@ -19,6 +19,7 @@
 #include <cmath>
 #include <memory>
 #include <stdexcept>
+#include <utility>
 #include "obs/gs/gs-helper.hpp"
 #include "plugin.hpp"
 
@@ -198,7 +199,7 @@ streamfx::gfx::blur::box::box()
 {
 	auto gctx      = streamfx::obs::gs::context();
 	_rendertarget  = std::make_shared<::streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-	_rendertarget2 = std::make_shared<::streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	_pool          = ::streamfx::obs::gs::rendertarget_pool::instance();
 }
 
 streamfx::gfx::blur::box::~box() {}
@@ -274,22 +275,39 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::box::render()
 	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
+	// Large radii are blurred at a lower resolution, see downsampler.
+	uint32_t factor = downsampler::get_factor(_size);
+	double_t size   = _size / factor;
+	auto     input  = _input_texture;
+
+	std::shared_ptr<::streamfx::obs::gs::rendertarget> downsampled;
+	if (factor > 1) {
+		downsampled = _downsampler.downsample(_input_texture, factor);
+		input       = downsampled->get_texture();
+		width       = float_t(input->get_width());
+		height      = float_t(input->get_height());
+	}
+	// The second pass goes into the output, unless it is upsampled into it. Leases go back to the pool once the render
+	// is done.
+	auto rendertarget2 = _pool->acquire(uint32_t(width), uint32_t(height));
+	auto rendertarget3 = (factor > 1) ? _pool->acquire(uint32_t(width), uint32_t(height)) : _rendertarget;
+
 	// Two Pass Blur
 	streamfx::obs::gs::effect effect = _data->get_effect();
 	if (effect) {
 		// Pass 1
-		effect.get_parameter("pImage").set_texture(_input_texture);
+		effect.get_parameter("pImage").set_texture(input);
 		effect.get_parameter("pImageTexel").set_float2(float_t(1.f / width), 0.f);
 		effect.get_parameter("pStepScale").set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
-		effect.get_parameter("pSize").set_float(float_t(_size));
-		effect.get_parameter("pSizeInverseMul").set_float(float_t(1.0f / (float_t(_size) * 2.0f + 1.0f)));
+		effect.get_parameter("pSize").set_float(float_t(size));
+		effect.get_parameter("pSizeInverseMul").set_float(float_t(1.0f / (float_t(size) * 2.0f + 1.0f)));
 
 		{
 #ifdef ENABLE_PROFILING
 			auto gdm = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Horizontal");
 #endif
 
-			auto op = _rendertarget2->render(uint32_t(width), uint32_t(height));
+			auto op = rendertarget2->render(uint32_t(width), uint32_t(height));
 			gs_ortho(0, 1., 0, 1., 0, 1.);
 			while (gs_effect_loop(effect.get_object(), "Draw")) {
 				streamfx::gs_draw_fullscreen_tri();
@@ -297,7 +315,7 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::box::render()
 		}
 
 		// Pass 2
-		effect.get_parameter("pImage").set_texture(_rendertarget2->get_texture());
+		effect.get_parameter("pImage").set_texture(rendertarget2->get_texture());
 		effect.get_parameter("pImageTexel").set_float2(0.f, float_t(1.f / height));
 
 		{
@@ -305,12 +323,17 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::box::render()
 			auto gdm = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Vertical");
 #endif
 
-			auto op = _rendertarget->render(uint32_t(width), uint32_t(height));
+			auto op = rendertarget3->render(uint32_t(width), uint32_t(height));
 			gs_ortho(0, 1., 0, 1., 0, 1.);
 			while (gs_effect_loop(effect.get_object(), "Draw")) {
 				streamfx::gs_draw_fullscreen_tri();
 			}
 		}
+
+		if (factor > 1) {
+			_downsampler.upsample(rendertarget3->get_texture(), _rendertarget, _input_texture->get_width(),
+								  _input_texture->get_height());
+		}
 	}
 
 	gs_blend_state_pop();
@@ -19,7 +19,9 @@
 #include "common.hpp"
 #include <mutex>
 #include "gfx-blur-base.hpp"
+#include "gfx-blur-downsample.hpp"
 #include "obs/gs/gs-effect.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-texture.hpp"
 
@@ -89,7 +91,8 @@ namespace streamfx::gfx {
 			std::shared_ptr<::streamfx::obs::gs::rendertarget> _rendertarget;
 
 			private:
-			std::shared_ptr<::streamfx::obs::gs::rendertarget> _rendertarget2;
+			std::shared_ptr<::streamfx::obs::gs::rendertarget_pool> _pool;
+			::streamfx::gfx::blur::downsampler                      _downsampler;
 
 			public:
 			box();
@@ -0,0 +1,93 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#include "gfx-blur-downsample.hpp"
+#include <algorithm>
+#include "obs/gs/gs-helper.hpp"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <obs.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+// Largest radius that is still blurred at full resolution.
+#define ST_DOWNSAMPLE_THRESHOLD 32.
+// Limit for the scaling factor, beyond this the upsampled result starts to show blocks.
+#define ST_DOWNSAMPLE_MAX_FACTOR 8u
+
+static void draw_scaled(std::shared_ptr<::streamfx::obs::gs::texture>      input,
+						std::shared_ptr<::streamfx::obs::gs::rendertarget> output, uint32_t width, uint32_t height)
+{
+	// The default effect samples bilinearly, so every halving averages exactly 2x2 texels.
+	gs_effect_t* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+	auto         op     = output->render(width, height);
+	gs_ortho(0, 1., 0, 1., 0, 1.);
+	gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), input->get_object());
+	while (gs_effect_loop(effect, "Draw")) {
+		gs_draw_sprite(nullptr, 0, 1, 1);
+	}
+}
+
+streamfx::gfx::blur::downsampler::downsampler() : _pool(::streamfx::obs::gs::rendertarget_pool::instance()) {}
+
+streamfx::gfx::blur::downsampler::~downsampler() {}
+
+uint32_t streamfx::gfx::blur::downsampler::get_factor(double_t size)
+{
+	uint32_t factor = 1;
+	while (((size / factor) > ST_DOWNSAMPLE_THRESHOLD) && (factor < ST_DOWNSAMPLE_MAX_FACTOR)) {
+		factor <<= 1;
+	}
+	return factor;
+}
+
+std::shared_ptr<::streamfx::obs::gs::rendertarget>
+	streamfx::gfx::blur::downsampler::downsample(std::shared_ptr<::streamfx::obs::gs::texture> input, uint32_t factor)
+{
+#ifdef ENABLE_PROFILING
+	auto gdm = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Downsample");
+#endif
+
+	// Every step only needs the previous one, so at most two targets are leased at once.
+	std::shared_ptr<::streamfx::obs::gs::rendertarget> output;
+	uint32_t                                           width  = input->get_width();
+	uint32_t                                           height = input->get_height();
+	for (uint32_t step = 1; step < factor; step <<= 1) {
+		width       = std::max<uint32_t>(width / 2, 1);
+		height      = std::max<uint32_t>(height / 2, 1);
+		auto target = _pool->acquire(width, height);
+		draw_scaled(input, target, width, height);
+		input  = target->get_texture();
+		output = target;
+	}
+	return output;
+}
+
+void streamfx::gfx::blur::downsampler::upsample(std::shared_ptr<::streamfx::obs::gs::texture>      input,
+												 std::shared_ptr<::streamfx::obs::gs::rendertarget> output,
+												 uint32_t width, uint32_t height)
+{
+#ifdef ENABLE_PROFILING
+	auto gdm = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Upsample");
+#endif
+
+	draw_scaled(input, output, width, height);
+}
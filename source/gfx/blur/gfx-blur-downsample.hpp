@@ -0,0 +1,50 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#pragma once
+#include "common.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
+#include "obs/gs/gs-rendertarget.hpp"
+#include "obs/gs/gs-texture.hpp"
+
+namespace streamfx::gfx {
+	namespace blur {
+		/** Resolution scaling for large blur radii.
+		 *
+		 * The input is halved until the remaining radius is small enough, blurred at that resolution and then scaled
+		 * back up bilinearly. Since a blurred image has no high frequency detail left, the result looks the same while
+		 * the cost of the blur itself stays close to constant in the radius.
+		 */
+		class downsampler {
+			std::shared_ptr<::streamfx::obs::gs::rendertarget_pool> _pool;
+
+			public:
+			downsampler();
+			~downsampler();
+
+			/** Power of two factor to scale the input down by for the given radius, 1 if not needed. */
+			static uint32_t get_factor(double_t size);
+
+			/** Scale the input down, the returned target stays valid for as long as it is held. */
+			std::shared_ptr<::streamfx::obs::gs::rendertarget>
+				downsample(std::shared_ptr<::streamfx::obs::gs::texture> input, uint32_t factor);
+
+			void upsample(std::shared_ptr<::streamfx::obs::gs::texture>      input,
+						  std::shared_ptr<::streamfx::obs::gs::rendertarget> output, uint32_t width, uint32_t height);
+		};
+	} // namespace blur
+} // namespace streamfx::gfx
@@ -20,6 +20,7 @@
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
 #include "plugin.hpp"
+#include "util/util-memory.hpp"
 
 #ifdef _MSC_VER
 #pragma warning(push)
@@ -183,17 +184,9 @@ std::shared_ptr<::streamfx::gfx::blur::dual_filtering_data> streamfx::gfx::blur:
 streamfx::gfx::blur::dual_filtering::dual_filtering()
 	: _data(::streamfx::gfx::blur::dual_filtering_factory::get().data()), _size(0), _iterations(0)
 {
-	auto gctx = streamfx::obs::gs::context();
-	_rts.resize(ST_MAX_LEVELS + 1);
-	for (std::size_t n = 0; n <= ST_MAX_LEVELS; n++) {
-		gs_color_format cf = GS_RGBA;
-#if 0
-		cf = GS_RGBA16F;
-#elif 0
-		cf = GS_RGBA32F;
-#endif
-		_rts[n] = std::make_shared<streamfx::obs::gs::rendertarget>(cf, GS_ZS_NONE);
-	}
+	auto gctx     = streamfx::obs::gs::context();
+	_rendertarget = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	_pool         = ::streamfx::obs::gs::rendertarget_pool::instance();
 }
 
 streamfx::gfx::blur::dual_filtering::~dual_filtering() {}
@@ -253,6 +246,22 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::dual_filterin
 	uint32_t height     = _input_texture->get_height();
 	size_t   iterations = _iterations;
 
+	// Stop at the last level that still has at least one pixel.
+	while ((iterations > 0) && (((width >> iterations) == 0) || ((height >> iterations) == 0))) {
+		iterations--;
+	}
+	if (iterations == 0) {
+		gs_blend_state_pop();
+		return _input_texture;
+	}
+
+	// Only the levels that are actually used are leased, the output level is kept.
+	streamfx::util::frame_vector<std::shared_ptr<streamfx::obs::gs::rendertarget>> rts(iterations + 1);
+	rts[0] = _rendertarget;
+	for (std::size_t n = 1; n <= iterations; n++) {
+		rts[n] = _pool->acquire(width >> n, height >> n, GS_RGBA);
+	}
+
 	// Downsample
 	for (std::size_t n = 1; n <= iterations; n++) {
 #ifdef ENABLE_PROFILING
@@ -262,7 +271,7 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::dual_filterin
 		// Select Texture
 		std::shared_ptr<streamfx::obs::gs::texture> tex;
 		if (n > 1) {
-			tex = _rts[n - 1]->get_texture();
+			tex = rts[n - 1]->get_texture();
 		} else { // Idx 0 is a simply considered as a straight copy of the original and not rendered to.
 			tex = _input_texture;
 		}
@@ -270,10 +279,6 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::dual_filterin
 		// Reduce Size
 		uint32_t owidth  = width >> n;
 		uint32_t oheight = height >> n;
-		if ((owidth == 0) || (oheight == 0)) {
-			iterations = n - 1;
-			break;
-		}
 
 		// Apply
 		effect.get_parameter("pImage").set_texture(tex);
@@ -281,7 +286,7 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::dual_filterin
 		effect.get_parameter("pImageTexel").set_float2(0.5f / owidth, 0.5f / oheight);
 
 		{
-			auto op = _rts[n]->render(owidth, oheight);
+			auto op = rts[n]->render(owidth, oheight);
 			gs_ortho(0., 1., 0., 1., 0., 1.);
 			while (gs_effect_loop(effect.get_object(), "Down")) {
 				streamfx::gs_draw_fullscreen_tri();
@@ -296,7 +301,7 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::dual_filterin
 #endif
 
 		// Select Texture
-		std::shared_ptr<streamfx::obs::gs::texture> tex = _rts[n]->get_texture();
+		std::shared_ptr<streamfx::obs::gs::texture> tex = rts[n]->get_texture();
 
 		// Get Size
 		uint32_t iwidth  = tex->get_width();
@@ -310,7 +315,7 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::dual_filterin
 		effect.get_parameter("pImageTexel").set_float2(0.5f / iwidth, 0.5f / iheight);
 
 		{
-			auto op = _rts[n - 1]->render(owidth, oheight);
+			auto op = rts[n - 1]->render(owidth, oheight);
 			gs_ortho(0., 1., 0., 1., 0., 1.);
 			while (gs_effect_loop(effect.get_object(), "Up")) {
 				streamfx::gs_draw_fullscreen_tri();
@@ -320,10 +325,10 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::dual_filterin
 
 	gs_blend_state_pop();
 
-	return _rts[0]->get_texture();
+	return _rendertarget->get_texture();
 }
 
 std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::dual_filtering::get()
 {
-	return _rts[0]->get_texture();
+	return _rendertarget->get_texture();
 }
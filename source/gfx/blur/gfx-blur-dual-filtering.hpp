@@ -21,6 +21,7 @@
 #include <vector>
 #include "gfx-blur-base.hpp"
 #include "obs/gs/gs-effect.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-texture.hpp"
 
@@ -88,7 +89,8 @@ namespace streamfx::gfx {
 
 			std::shared_ptr<streamfx::obs::gs::texture> _input_texture;
 
-			std::vector<std::shared_ptr<streamfx::obs::gs::rendertarget>> _rts;
+			std::shared_ptr<streamfx::obs::gs::rendertarget>      _rendertarget;
+			std::shared_ptr<streamfx::obs::gs::rendertarget_pool> _pool;
 
 			public:
 			dual_filtering();
@@ -16,6 +16,7 @@
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
 
 #include "gfx-blur-gaussian-linear.hpp"
+#include <algorithm>
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
 
@@ -40,46 +41,45 @@
 #define ST_SEARCH_EXTENSION 1
 #define ST_SEARCH_RANGE ST_MAX_KERNEL_SIZE * 2
 
-streamfx::gfx::blur::gaussian_linear_data::gaussian_linear_data()
+static void generate_kernel(std::size_t kernel_size, std::vector<float_t>& kernel_data)
 {
-	auto gctx = streamfx::obs::gs::context();
-	_effect =
-		streamfx::obs::gs::effect::create(streamfx::data_file_path("effects/blur/gaussian-linear.effect").u8string());
-
-	// Precalculate Kernels
-	for (std::size_t kernel_size = 1; kernel_size <= ST_MAX_BLUR_SIZE; kernel_size++) {
-		std::vector<double_t> kernel_math(ST_MAX_KERNEL_SIZE);
-		std::vector<float_t>  kernel_data(ST_MAX_KERNEL_SIZE);
-		double_t              actual_width = 1.;
-
-		// Find actual kernel width.
-		for (double_t h = ST_SEARCH_DENSITY; h < ST_SEARCH_RANGE; h += ST_SEARCH_DENSITY) {
-			if (streamfx::util::math::gaussian<double_t>(double_t(kernel_size + ST_SEARCH_EXTENSION), h)
-				> ST_SEARCH_THRESHOLD) {
-				actual_width = h;
-				break;
-			}
-		}
+	std::vector<double_t> kernel_math(ST_MAX_KERNEL_SIZE);
+	double_t              actual_width = 1.;
 
-		// Calculate and normalize
-		double_t sum = 0;
-		for (std::size_t p = 0; p <= kernel_size; p++) {
-			kernel_math[p] = streamfx::util::math::gaussian<double_t>(double_t(p), actual_width);
-			sum += kernel_math[p] * (p > 0 ? 2 : 1);
+	// Find actual kernel width.
+	for (double_t h = ST_SEARCH_DENSITY; h < ST_SEARCH_RANGE; h += ST_SEARCH_DENSITY) {
+		if (streamfx::util::math::gaussian<double_t>(double_t(kernel_size + ST_SEARCH_EXTENSION), h)
+			> ST_SEARCH_THRESHOLD) {
+			actual_width = h;
+			break;
 		}
+	}
 
-		// Normalize to fill the entire 0..1 range over the width.
-		double_t inverse_sum = 1.0 / sum;
-		for (std::size_t p = 0; p <= kernel_size; p++) {
-			kernel_data.at(p) = float_t(kernel_math[p] * inverse_sum);
-		}
+	// Calculate and normalize
+	double_t sum = 0;
+	for (std::size_t p = 0; p <= kernel_size; p++) {
+		kernel_math[p] = streamfx::util::math::gaussian<double_t>(double_t(p), actual_width);
+		sum += kernel_math[p] * (p > 0 ? 2 : 1);
+	}
 
-		_kernels.push_back(std::move(kernel_data));
+	// Normalize to fill the entire 0..1 range over the width.
+	double_t inverse_sum = 1.0 / sum;
+	for (std::size_t p = 0; p <= kernel_size; p++) {
+		kernel_data.at(p) = float_t(kernel_math[p] * inverse_sum);
 	}
 }
 
+streamfx::gfx::blur::gaussian_linear_data::gaussian_linear_data() : _kernels(kernel_cache::instance())
+{
+	auto gctx = streamfx::obs::gs::context();
+	_effect =
+		streamfx::obs::gs::effect::create(streamfx::data_file_path("effects/blur/gaussian-linear.effect").u8string());
+}
+
 streamfx::gfx::blur::gaussian_linear_data::~gaussian_linear_data()
 {
+	auto gctx = streamfx::obs::gs::context();
+	_kernel_textures.clear();
 	_effect.reset();
 }
 
@@ -88,14 +88,30 @@ streamfx::obs::gs::effect streamfx::gfx::blur::gaussian_linear_data::get_effect(
 	return _effect;
 }
 
-std::vector<float_t> const& streamfx::gfx::blur::gaussian_linear_data::get_kernel(std::size_t width)
+streamfx::gfx::blur::kernel_cache::kernel_t streamfx::gfx::blur::gaussian_linear_data::get_kernel(std::size_t width)
 {
 	if (width < 1)
 		width = 1;
 	if (width > ST_MAX_BLUR_SIZE)
 		width = ST_MAX_BLUR_SIZE;
-	width -= 1;
-	return _kernels[width];
+	return _kernels->get(kernel_type::GaussianLinear, width, ST_MAX_KERNEL_SIZE, generate_kernel);
+}
+
+std::shared_ptr<streamfx::obs::gs::texture>
+	streamfx::gfx::blur::gaussian_linear_data::get_kernel_texture(std::size_t width)
+{
+	width = std::clamp<size_t>(width, 1, ST_MAX_BLUR_SIZE);
+	if (auto found = _kernel_textures.find(width); found != _kernel_textures.end()) {
+		return found->second;
+	}
+
+	auto           kernel = get_kernel(width);
+	const uint8_t* data   = reinterpret_cast<const uint8_t*>(kernel->data());
+
+	auto texture = std::make_shared<streamfx::obs::gs::texture>(ST_MAX_KERNEL_SIZE, 1, GS_R32F, 1, &data,
+																streamfx::obs::gs::texture::flags::None);
+	_kernel_textures.emplace(width, texture);
+	return texture;
 }
 
 streamfx::gfx::blur::gaussian_linear_factory::gaussian_linear_factory() {}
@@ -109,6 +125,10 @@ bool streamfx::gfx::blur::gaussian_linear_factory::is_type_supported(::streamfx:
 		return true;
 	case ::streamfx::gfx::blur::type::Directional:
 		return true;
+	case ::streamfx::gfx::blur::type::Rotational:
+		return true;
+	case ::streamfx::gfx::blur::type::Zoom:
+		return true;
 	default:
 		return false;
 	}
@@ -123,6 +143,12 @@ std::shared_ptr<::streamfx::gfx::blur::base>
 	case ::streamfx::gfx::blur::type::Directional:
 		return std::static_pointer_cast<::streamfx::gfx::blur::gaussian_linear>(
 			std::make_shared<::streamfx::gfx::blur::gaussian_linear_directional>());
+	case ::streamfx::gfx::blur::type::Rotational:
+		return std::static_pointer_cast<::streamfx::gfx::blur::gaussian_linear>(
+			std::make_shared<::streamfx::gfx::blur::gaussian_linear_rotational>());
+	case ::streamfx::gfx::blur::type::Zoom:
+		return std::static_pointer_cast<::streamfx::gfx::blur::gaussian_linear>(
+			std::make_shared<::streamfx::gfx::blur::gaussian_linear_zoom>());
 	default:
 		throw std::runtime_error("Invalid type.");
 	}
@@ -235,7 +261,7 @@ streamfx::gfx::blur::gaussian_linear::gaussian_linear()
 	auto gctx = streamfx::obs::gs::context();
 
 	_rendertarget  = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-	_rendertarget2 = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	_pool          = ::streamfx::obs::gs::rendertarget_pool::instance();
 }
 
 streamfx::gfx::blur::gaussian_linear::~gaussian_linear() {}
@@ -295,7 +321,7 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_line
 #endif
 
 	streamfx::obs::gs::effect effect = _data->get_effect();
-	auto                      kernel = _data->get_kernel(size_t(_size));
+	auto                      kernel = _data->get_kernel_texture(size_t(_size));
 
 	if (!effect || ((_step_scale.first + _step_scale.second) < std::numeric_limits<double_t>::epsilon())) {
 		return _input_texture;
@@ -304,6 +330,10 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_line
 	float_t width  = float_t(_input_texture->get_width());
 	float_t height = float_t(_input_texture->get_height());
 
+	// Only the last pass goes into the output, the lease in between goes back to the pool once the render is done.
+	bool vertical = _step_scale.second > std::numeric_limits<double_t>::epsilon();
+	std::shared_ptr<::streamfx::obs::gs::rendertarget> rendertarget2;
+
 	// Setup
 	gs_set_cull_mode(GS_NEITHER);
 	gs_enable_color(true, true, true, true);
@@ -321,7 +351,7 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_line
 	effect.get_parameter("pImage").set_texture(_input_texture);
 	effect.get_parameter("pStepScale").set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
 	effect.get_parameter("pSize").set_float(float_t(_size));
-	effect.get_parameter("pKernel").set_value(kernel.data(), ST_MAX_KERNEL_SIZE);
+	effect.get_parameter("pKernel").set_texture(kernel);
 
 	// First Pass
 	if (_step_scale.first > std::numeric_limits<double_t>::epsilon()) {
@@ -332,19 +362,19 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_line
 			auto gdm = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Horizontal");
 #endif
 
-			auto op = _rendertarget2->render(uint32_t(width), uint32_t(height));
+			rendertarget2 = vertical ? _pool->acquire(uint32_t(width), uint32_t(height)) : _rendertarget;
+			auto op       = rendertarget2->render(uint32_t(width), uint32_t(height));
 			gs_ortho(0, 1., 0, 1., 0, 1.);
 			while (gs_effect_loop(effect.get_object(), "Draw")) {
 				streamfx::gs_draw_fullscreen_tri();
 			}
 		}
 
-		std::swap(_rendertarget, _rendertarget2);
-		effect.get_parameter("pImage").set_texture(_rendertarget->get_texture());
+		effect.get_parameter("pImage").set_texture(rendertarget2->get_texture());
 	}
 
 	// Second Pass
-	if (_step_scale.second > std::numeric_limits<double_t>::epsilon()) {
+	if (vertical) {
 		effect.get_parameter("pImageTexel").set_float2(0.f, float_t(1.f / height));
 
 		{
@@ -352,14 +382,12 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_line
 			auto gdm = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Vertical");
 #endif
 
-			auto op = _rendertarget2->render(uint32_t(width), uint32_t(height));
+			auto op = _rendertarget->render(uint32_t(width), uint32_t(height));
 			gs_ortho(0, 1., 0, 1., 0, 1.);
 			while (gs_effect_loop(effect.get_object(), "Draw")) {
 				streamfx::gs_draw_fullscreen_tri();
 			}
 		}
-
-		std::swap(_rendertarget, _rendertarget2);
 	}
 
 	gs_blend_state_pop();
@@ -401,7 +429,7 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_line
 #endif
 
 	streamfx::obs::gs::effect effect = _data->get_effect();
-	auto                      kernel = _data->get_kernel(size_t(_size));
+	auto                      kernel = _data->get_kernel_texture(size_t(_size));
 
 	if (!effect || ((_step_scale.first + _step_scale.second) < std::numeric_limits<double_t>::epsilon())) {
 		return _input_texture;
@@ -429,7 +457,7 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_line
 		.set_float2(float_t(1.f / width * cos(_angle)), float_t(1.f / height * sin(_angle)));
 	effect.get_parameter("pStepScale").set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
 	effect.get_parameter("pSize").set_float(float_t(_size));
-	effect.get_parameter("pKernel").set_value(kernel.data(), ST_MAX_KERNEL_SIZE);
+	effect.get_parameter("pKernel").set_texture(kernel);
 
 	// First Pass
 	{
@@ -444,3 +472,160 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_line
 
 	return this->get();
 }
+
+streamfx::gfx::blur::gaussian_linear_rotational::gaussian_linear_rotational() : _center({0.5, 0.5}), _angle(0) {}
+
+::streamfx::gfx::blur::type streamfx::gfx::blur::gaussian_linear_rotational::get_type()
+{
+	return ::streamfx::gfx::blur::type::Rotational;
+}
+
+void streamfx::gfx::blur::gaussian_linear_rotational::set_center(double_t x, double_t y)
+{
+	_center.first  = x;
+	_center.second = y;
+}
+
+void streamfx::gfx::blur::gaussian_linear_rotational::get_center(double_t& x, double_t& y)
+{
+	x = _center.first;
+	y = _center.second;
+}
+
+double_t streamfx::gfx::blur::gaussian_linear_rotational::get_angle()
+{
+	return D_RAD_TO_DEG(_angle);
+}
+
+void streamfx::gfx::blur::gaussian_linear_rotational::set_angle(double_t angle)
+{
+	_angle = D_DEG_TO_RAD(angle);
+}
+
+std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_linear_rotational::render()
+{
+	auto gctx = streamfx::obs::gs::context();
+
+#ifdef ENABLE_PROFILING
+	auto gdmp = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance,
+												"Gaussian Linear Rotational Blur");
+#endif
+
+	streamfx::obs::gs::effect effect = _data->get_effect();
+	auto                      kernel = _data->get_kernel_texture(size_t(_size));
+
+	if (!effect || ((_step_scale.first + _step_scale.second) < std::numeric_limits<double_t>::epsilon())) {
+		return _input_texture;
+	}
+
+	float_t width  = float_t(_input_texture->get_width());
+	float_t height = float_t(_input_texture->get_height());
+
+	// Setup
+	gs_blend_state_push();
+	gs_reset_blend_state();
+	gs_enable_color(true, true, true, true);
+	gs_enable_blending(false);
+	gs_enable_depth_test(false);
+	gs_enable_stencil_test(false);
+	gs_enable_stencil_write(false);
+	gs_set_cull_mode(GS_NEITHER);
+	gs_depth_function(GS_ALWAYS);
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
+	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
+
+	effect.get_parameter("pImage").set_texture(_input_texture);
+	effect.get_parameter("pImageTexel").set_float2(float_t(1.f / width), float_t(1.f / height));
+	effect.get_parameter("pStepScale").set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
+	effect.get_parameter("pSize").set_float(float_t(_size));
+	effect.get_parameter("pAngle").set_float(float_t(_angle / _size));
+	effect.get_parameter("pCenter").set_float2(float_t(_center.first), float_t(_center.second));
+	effect.get_parameter("pKernel").set_texture(kernel);
+
+	// First Pass
+	{
+		auto op = _rendertarget->render(uint32_t(width), uint32_t(height));
+		gs_ortho(0, 1., 0, 1., 0, 1.);
+		while (gs_effect_loop(effect.get_object(), "Rotate")) {
+			streamfx::gs_draw_fullscreen_tri();
+		}
+	}
+
+	gs_blend_state_pop();
+
+	return this->get();
+}
+
+streamfx::gfx::blur::gaussian_linear_zoom::gaussian_linear_zoom() : _center({0.5, 0.5}) {}
+
+::streamfx::gfx::blur::type streamfx::gfx::blur::gaussian_linear_zoom::get_type()
+{
+	return ::streamfx::gfx::blur::type::Zoom;
+}
+
+void streamfx::gfx::blur::gaussian_linear_zoom::set_center(double_t x, double_t y)
+{
+	_center.first  = x;
+	_center.second = y;
+}
+
+void streamfx::gfx::blur::gaussian_linear_zoom::get_center(double_t& x, double_t& y)
+{
+	x = _center.first;
+	y = _center.second;
+}
+
+std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_linear_zoom::render()
+{
+	auto gctx = streamfx::obs::gs::context();
+
+#ifdef ENABLE_PROFILING
+	auto gdmp = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance,
+												"Gaussian Linear Zoom Blur");
+#endif
+
+	streamfx::obs::gs::effect effect = _data->get_effect();
+	auto                      kernel = _data->get_kernel_texture(size_t(_size));
+
+	if (!effect || ((_step_scale.first + _step_scale.second) < std::numeric_limits<double_t>::epsilon())) {
+		return _input_texture;
+	}
+
+	float_t width  = float_t(_input_texture->get_width());
+	float_t height = float_t(_input_texture->get_height());
+
+	// Setup
+	gs_blend_state_push();
+	gs_reset_blend_state();
+	gs_enable_color(true, true, true, true);
+	gs_enable_blending(false);
+	gs_enable_depth_test(false);
+	gs_enable_stencil_test(false);
+	gs_enable_stencil_write(false);
+	gs_set_cull_mode(GS_NEITHER);
+	gs_depth_function(GS_ALWAYS);
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
+	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
+
+	effect.get_parameter("pImage").set_texture(_input_texture);
+	effect.get_parameter("pImageTexel").set_float2(float_t(1.f / width), float_t(1.f / height));
+	effect.get_parameter("pStepScale").set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
+	effect.get_parameter("pSize").set_float(float_t(_size));
+	effect.get_parameter("pCenter").set_float2(float_t(_center.first), float_t(_center.second));
+	effect.get_parameter("pKernel").set_texture(kernel);
+
+	// First Pass
+	{
+		auto op = _rendertarget->render(uint32_t(width), uint32_t(height));
+		gs_ortho(0, 1., 0, 1., 0, 1.);
+		while (gs_effect_loop(effect.get_object(), "Zoom")) {
+			streamfx::gs_draw_fullscreen_tri();
+		}
+	}
+
+	gs_blend_state_pop();
+
+	return this->get();
+}
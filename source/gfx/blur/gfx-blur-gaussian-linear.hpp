@@ -17,18 +17,24 @@
 
 #pragma once
 #include "common.hpp"
+#include <map>
 #include <mutex>
 #include <vector>
 #include "gfx-blur-base.hpp"
+#include "gfx-blur-kernel-cache.hpp"
 #include "obs/gs/gs-effect.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-texture.hpp"
 
 namespace streamfx::gfx {
 	namespace blur {
 		class gaussian_linear_data {
-			streamfx::obs::gs::effect         _effect;
-			std::vector<std::vector<float_t>> _kernels;
+			streamfx::obs::gs::effect     _effect;
+			std::shared_ptr<kernel_cache> _kernels;
+
+			// Kernels uploaded once per width, so that rendering only has to bind them.
+			std::map<std::size_t, std::shared_ptr<streamfx::obs::gs::texture>> _kernel_textures;
 
 			public:
 			gaussian_linear_data();
@@ -36,7 +42,10 @@ namespace streamfx::gfx {
 
 			streamfx::obs::gs::effect get_effect();
 
-			std::vector<float_t> const& get_kernel(std::size_t width);
+			kernel_cache::kernel_t get_kernel(std::size_t width);
+
+			/** Kernel for this width as a texture, must be called with the graphics context held. */
+			std::shared_ptr<streamfx::obs::gs::texture> get_kernel_texture(std::size_t width);
 		};
 
 		class gaussian_linear_factory : public ::streamfx::gfx::blur::ifactory {
@@ -93,7 +102,7 @@ namespace streamfx::gfx {
 			std::shared_ptr<::streamfx::obs::gs::rendertarget> _rendertarget;
 
 			private:
-			std::shared_ptr<::streamfx::obs::gs::rendertarget> _rendertarget2;
+			std::shared_ptr<::streamfx::obs::gs::rendertarget_pool> _pool;
 
 			public:
 			gaussian_linear();
@@ -134,6 +143,40 @@ namespace streamfx::gfx {
 
 			virtual void set_angle(double_t angle) override;
 
+			virtual std::shared_ptr<::streamfx::obs::gs::texture> render() override;
+		};
+		class gaussian_linear_rotational : public ::streamfx::gfx::blur::gaussian_linear,
+										   public ::streamfx::gfx::blur::base_angle,
+										   public ::streamfx::gfx::blur::base_center {
+			std::pair<double_t, double_t> _center;
+			double_t                      _angle;
+
+			public:
+			gaussian_linear_rotational();
+
+			virtual ::streamfx::gfx::blur::type get_type() override;
+
+			virtual void set_center(double_t x, double_t y) override;
+			virtual void get_center(double_t& x, double_t& y) override;
+
+			virtual double_t get_angle() override;
+			virtual void     set_angle(double_t angle) override;
+
+			virtual std::shared_ptr<::streamfx::obs::gs::texture> render() override;
+		};
+
+		class gaussian_linear_zoom : public ::streamfx::gfx::blur::gaussian_linear,
+									 public ::streamfx::gfx::blur::base_center {
+			std::pair<double_t, double_t> _center;
+
+			public:
+			gaussian_linear_zoom();
+
+			virtual ::streamfx::gfx::blur::type get_type() override;
+
+			virtual void set_center(double_t x, double_t y) override;
+			virtual void get_center(double_t& x, double_t& y) override;
+
 			virtual std::shared_ptr<::streamfx::obs::gs::texture> render() override;
 		};
 	} // namespace blur
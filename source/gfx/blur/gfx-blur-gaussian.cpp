@@ -37,74 +37,69 @@
 #define ST_OVERSAMPLE_MULTIPLIER 2
 #define ST_MAX_BLUR_SIZE ST_KERNEL_SIZE / ST_OVERSAMPLE_MULTIPLIER
 
-streamfx::gfx::blur::gaussian_data::gaussian_data()
+static void generate_kernel(std::size_t size, std::vector<float_t>& kernel)
 {
 	using namespace streamfx::util;
 
 	std::vector<double> kernel_dbl(ST_KERNEL_SIZE);
-	std::vector<float>  kernel(ST_KERNEL_SIZE);
-
-	{
-		auto gctx = streamfx::obs::gs::context();
-		_effect =
-			streamfx::obs::gs::effect::create(streamfx::data_file_path("effects/blur/gaussian.effect").u8string());
-	}
 
 	//#define ST_USE_PASCAL_TRIANGLE
-
-	// Pre-calculate Kernel Information for all Kernel sizes
-	for (size_t size = 1; size <= ST_MAX_BLUR_SIZE; size++) {
 #ifdef ST_USE_PASCAL_TRIANGLE
-		// The Pascal Triangle can be used to generate Gaussian Kernels, which is
-		// significantly faster than doing the same task with searching. It is also
-		// much more accurate at the same time, so it is a 2-in-1 solution.
-
-		// Generate the required row and sum.
-		size_t offset   = size;
-		size_t row      = size * 2;
-		auto   triangle = math::pascal_triangle<double>(row);
-		double sum      = pow(2, row);
-
-		// Convert all integers to floats.
-		double accum = 0.;
-		for (size_t idx = offset; idx < std::min<size_t>(triangle.size(), ST_KERNEL_SIZE); idx++) {
-			double v                 = static_cast<double>(triangle[idx]) / sum;
-			kernel_dbl[idx - offset] = v;
-			// Accumulator needed as we end up with float inaccuracies above a certain threshold.
-			accum += v * (idx > offset ? 2 : 1);
-		}
+	// The Pascal Triangle can be used to generate Gaussian Kernels, which is
+	// significantly faster than doing the same task with searching. It is also
+	// much more accurate at the same time, so it is a 2-in-1 solution.
+
+	// Generate the required row and sum.
+	size_t offset   = size;
+	size_t row      = size * 2;
+	auto   triangle = math::pascal_triangle<double>(row);
+	double sum      = pow(2, row);
+
+	// Convert all integers to floats.
+	double accum = 0.;
+	for (size_t idx = offset; idx < std::min<size_t>(triangle.size(), ST_KERNEL_SIZE); idx++) {
+		double v                 = static_cast<double>(triangle[idx]) / sum;
+		kernel_dbl[idx - offset] = v;
+		// Accumulator needed as we end up with float inaccuracies above a certain threshold.
+		accum += v * (idx > offset ? 2 : 1);
+	}
 
-		// Rescale all values back into useful ranges.
-		accum = 1. / accum;
-		for (size_t idx = offset; idx < ST_KERNEL_SIZE; idx++) {
-			kernel[idx - offset] = kernel_dbl[idx - offset] * accum;
-		}
+	// Rescale all values back into useful ranges.
+	accum = 1. / accum;
+	for (size_t idx = offset; idx < ST_KERNEL_SIZE; idx++) {
+		kernel[idx - offset] = kernel_dbl[idx - offset] * accum;
+	}
 #else
-		size_t oversample = size * ST_OVERSAMPLE_MULTIPLIER;
-
-		// Generate initial weights and calculate a total from them.
-		double total = 0.;
-		for (size_t idx = 0; (idx < oversample) && (idx < ST_KERNEL_SIZE); idx++) {
-			kernel_dbl[idx] = math::gaussian<double>(static_cast<double>(idx), static_cast<double>(size));
-			total += kernel_dbl[idx] * (idx > 0 ? 2 : 1);
-		}
+	size_t oversample = size * ST_OVERSAMPLE_MULTIPLIER;
 
-		// Scale the weights according to the total gathered, and convert to float.
-		for (size_t idx = 0; (idx < oversample) && (idx < ST_KERNEL_SIZE); idx++) {
-			kernel_dbl[idx] /= total;
-			kernel[idx] = static_cast<float>(kernel_dbl[idx]);
-		}
+	// Generate initial weights and calculate a total from them.
+	double total = 0.;
+	for (size_t idx = 0; (idx < oversample) && (idx < ST_KERNEL_SIZE); idx++) {
+		kernel_dbl[idx] = math::gaussian<double>(static_cast<double>(idx), static_cast<double>(size));
+		total += kernel_dbl[idx] * (idx > 0 ? 2 : 1);
+	}
 
+	// Scale the weights according to the total gathered, and convert to float.
+	for (size_t idx = 0; (idx < oversample) && (idx < ST_KERNEL_SIZE); idx++) {
+		kernel_dbl[idx] /= total;
+		kernel[idx] = static_cast<float>(kernel_dbl[idx]);
+	}
 #endif
+}
 
-		// Store Kernel
-		_kernels.insert_or_assign(size, kernel);
-	}
+streamfx::gfx::blur::gaussian_data::gaussian_data() : _kernels(kernel_cache::instance())
+{
+	auto gctx = streamfx::obs::gs::context();
+	_effect   = streamfx::obs::gs::effect::create(streamfx::data_file_path("effects/blur/gaussian.effect").u8string());
+
+	_parameters = {_effect, {"pImage", "pImageTexel", "pStepScale", "pSize", "pAngle", "pCenter", "pKernel"}};
 }
 
 streamfx::gfx::blur::gaussian_data::~gaussian_data()
 {
 	auto gctx = streamfx::obs::gs::context();
+	_kernel_textures.clear();
+	_parameters.reset();
 	_effect.reset();
 }
 
@@ -113,10 +108,32 @@ streamfx::obs::gs::effect streamfx::gfx::blur::gaussian_data::get_effect()
 	return _effect;
 }
 
-std::vector<float_t> const& streamfx::gfx::blur::gaussian_data::get_kernel(std::size_t width)
+streamfx::obs::gs::effect_parameters<streamfx::gfx::blur::gaussian_data::_COUNT>&
+	streamfx::gfx::blur::gaussian_data::get_parameters()
+{
+	return _parameters;
+}
+
+streamfx::gfx::blur::kernel_cache::kernel_t streamfx::gfx::blur::gaussian_data::get_kernel(std::size_t width)
 {
 	width = std::clamp<size_t>(width, 1, ST_MAX_BLUR_SIZE);
-	return _kernels.at(width);
+	return _kernels->get(kernel_type::Gaussian, width, ST_KERNEL_SIZE, generate_kernel);
+}
+
+std::shared_ptr<streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_data::get_kernel_texture(std::size_t width)
+{
+	width = std::clamp<size_t>(width, 1, ST_MAX_BLUR_SIZE);
+	if (auto found = _kernel_textures.find(width); found != _kernel_textures.end()) {
+		return found->second;
+	}
+
+	auto           kernel = get_kernel(width);
+	const uint8_t* data   = reinterpret_cast<const uint8_t*>(kernel->data());
+
+	auto texture = std::make_shared<streamfx::obs::gs::texture>(ST_KERNEL_SIZE, 1, GS_R32F, 1, &data,
+																streamfx::obs::gs::texture::flags::None);
+	_kernel_textures.emplace(width, texture);
+	return texture;
 }
 
 streamfx::gfx::blur::gaussian_factory::gaussian_factory() {}
@@ -263,7 +280,7 @@ streamfx::gfx::blur::gaussian::gaussian()
 {
 	auto gctx      = streamfx::obs::gs::context();
 	_rendertarget  = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
-	_rendertarget2 = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	_pool          = ::streamfx::obs::gs::rendertarget_pool::instance();
 }
 
 streamfx::gfx::blur::gaussian::~gaussian() {}
@@ -323,12 +340,20 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian::ren
 #endif
 
 	streamfx::obs::gs::effect effect = _data->get_effect();
+	auto&                     params = _data->get_parameters();
 
 	if (!effect || ((_step_scale.first + _step_scale.second) < std::numeric_limits<double_t>::epsilon())) {
 		return _input_texture;
 	}
 
-	auto    kernel = _data->get_kernel(size_t(_size));
+	// Large radii are blurred at a lower resolution, see downsampler.
+	uint32_t factor = downsampler::get_factor(_size);
+	double_t size   = _size / factor;
+	auto     input  = _input_texture;
+
+	std::shared_ptr<::streamfx::obs::gs::rendertarget> downsampled;
+
+	auto    kernel = _data->get_kernel_texture(size_t(size));
 	float_t width  = float_t(_input_texture->get_width());
 	float_t height = float_t(_input_texture->get_height());
 
@@ -346,48 +371,70 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian::ren
 	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
-	effect.get_parameter("pStepScale").set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
-	effect.get_parameter("pSize").set_float(float_t(_size * ST_OVERSAMPLE_MULTIPLIER));
-	effect.get_parameter("pKernel").set_value(kernel.data(), ST_KERNEL_SIZE);
+	if (factor > 1) {
+		downsampled = _downsampler.downsample(_input_texture, factor);
+		input       = downsampled->get_texture();
+		width       = float_t(input->get_width());
+		height      = float_t(input->get_height());
+	}
+
+	// Only the last pass goes into the output, unless it is upsampled into it. Leases in between are held until the
+	// render is done, and then go back to the pool.
+	bool vertical = _step_scale.second > std::numeric_limits<double_t>::epsilon();
+	auto target   = [this, factor, width, height](bool last) {
+		return (last && (factor <= 1)) ? _rendertarget : _pool->acquire(uint32_t(width), uint32_t(height));
+	};
+	std::shared_ptr<::streamfx::obs::gs::rendertarget> horizontal_rt;
+	std::shared_ptr<::streamfx::obs::gs::rendertarget> vertical_rt;
+
+	params[gaussian_data::STEP_SCALE].set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
+	params[gaussian_data::SIZE].set_float(float_t(size * ST_OVERSAMPLE_MULTIPLIER));
+	params[gaussian_data::KERNEL].set_texture(kernel);
 
 	// First Pass
 	if (_step_scale.first > std::numeric_limits<double_t>::epsilon()) {
-		effect.get_parameter("pImage").set_texture(_input_texture);
-		effect.get_parameter("pImageTexel").set_float2(float_t(1.f / width), 0.f);
+		params[gaussian_data::IMAGE].set_texture(input);
+		params[gaussian_data::IMAGE_TEXEL].set_float2(float_t(1.f / width), 0.f);
 
 		{
 #ifdef ENABLE_PROFILING
 			auto gdm = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Horizontal");
 #endif
 
-			auto op = _rendertarget2->render(uint32_t(width), uint32_t(height));
+			horizontal_rt = target(!vertical);
+			auto op       = horizontal_rt->render(uint32_t(width), uint32_t(height));
 			gs_ortho(0, 1., 0, 1., 0, 1.);
 			while (gs_effect_loop(effect.get_object(), "Draw")) {
 				streamfx::gs_draw_fullscreen_tri();
 			}
 		}
 
-		std::swap(_rendertarget, _rendertarget2);
+		input = horizontal_rt->get_texture();
 	}
 
 	// Second Pass
-	if (_step_scale.second > std::numeric_limits<double_t>::epsilon()) {
-		effect.get_parameter("pImage").set_texture(_rendertarget->get_texture());
-		effect.get_parameter("pImageTexel").set_float2(0.f, float_t(1.f / height));
+	if (vertical) {
+		params[gaussian_data::IMAGE].set_texture(input);
+		params[gaussian_data::IMAGE_TEXEL].set_float2(0.f, float_t(1.f / height));
 
 		{
 #ifdef ENABLE_PROFILING
 			auto gdm = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Vertical");
 #endif
 
-			auto op = _rendertarget2->render(uint32_t(width), uint32_t(height));
+			vertical_rt = target(true);
+			auto op     = vertical_rt->render(uint32_t(width), uint32_t(height));
 			gs_ortho(0, 1., 0, 1., 0, 1.);
 			while (gs_effect_loop(effect.get_object(), "Draw")) {
 				streamfx::gs_draw_fullscreen_tri();
 			}
 		}
 
-		std::swap(_rendertarget, _rendertarget2);
+		input = vertical_rt->get_texture();
+	}
+
+	if (factor > 1) {
+		_downsampler.upsample(input, _rendertarget, _input_texture->get_width(), _input_texture->get_height());
 	}
 
 	gs_blend_state_pop();
@@ -429,12 +476,13 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_dire
 #endif
 
 	streamfx::obs::gs::effect effect = _data->get_effect();
+	auto&                     params = _data->get_parameters();
 
 	if (!effect || ((_step_scale.first + _step_scale.second) < std::numeric_limits<double_t>::epsilon())) {
 		return _input_texture;
 	}
 
-	auto    kernel = _data->get_kernel(size_t(_size));
+	auto    kernel = _data->get_kernel_texture(size_t(_size));
 	float_t width  = float_t(_input_texture->get_width());
 	float_t height = float_t(_input_texture->get_height());
 
@@ -452,12 +500,12 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_dire
 	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
-	effect.get_parameter("pImage").set_texture(_input_texture);
-	effect.get_parameter("pImageTexel")
+	params[gaussian_data::IMAGE].set_texture(_input_texture);
+	params[gaussian_data::IMAGE_TEXEL]
 		.set_float2(float_t(1.f / width * cos(m_angle)), float_t(1.f / height * sin(m_angle)));
-	effect.get_parameter("pStepScale").set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
-	effect.get_parameter("pSize").set_float(float_t(_size * ST_OVERSAMPLE_MULTIPLIER));
-	effect.get_parameter("pKernel").set_value(kernel.data(), ST_KERNEL_SIZE);
+	params[gaussian_data::STEP_SCALE].set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
+	params[gaussian_data::SIZE].set_float(float_t(_size * ST_OVERSAMPLE_MULTIPLIER));
+	params[gaussian_data::KERNEL].set_texture(kernel);
 
 	{
 		auto op = _rendertarget->render(uint32_t(width), uint32_t(height));
@@ -487,12 +535,13 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_rota
 #endif
 
 	streamfx::obs::gs::effect effect = _data->get_effect();
+	auto&                     params = _data->get_parameters();
 
 	if (!effect || ((_step_scale.first + _step_scale.second) < std::numeric_limits<double_t>::epsilon())) {
 		return _input_texture;
 	}
 
-	auto    kernel = _data->get_kernel(size_t(_size));
+	auto    kernel = _data->get_kernel_texture(size_t(_size));
 	float_t width  = float_t(_input_texture->get_width());
 	float_t height = float_t(_input_texture->get_height());
 
@@ -510,13 +559,13 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_rota
 	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
-	effect.get_parameter("pImage").set_texture(_input_texture);
-	effect.get_parameter("pImageTexel").set_float2(float_t(1.f / width), float_t(1.f / height));
-	effect.get_parameter("pStepScale").set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
-	effect.get_parameter("pSize").set_float(float_t(_size * ST_OVERSAMPLE_MULTIPLIER));
-	effect.get_parameter("pAngle").set_float(float_t(m_angle / _size));
-	effect.get_parameter("pCenter").set_float2(float_t(m_center.first), float_t(m_center.second));
-	effect.get_parameter("pKernel").set_value(kernel.data(), ST_KERNEL_SIZE);
+	params[gaussian_data::IMAGE].set_texture(_input_texture);
+	params[gaussian_data::IMAGE_TEXEL].set_float2(float_t(1.f / width), float_t(1.f / height));
+	params[gaussian_data::STEP_SCALE].set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
+	params[gaussian_data::SIZE].set_float(float_t(_size * ST_OVERSAMPLE_MULTIPLIER));
+	params[gaussian_data::ANGLE].set_float(float_t(m_angle / _size));
+	params[gaussian_data::CENTER].set_float2(float_t(m_center.first), float_t(m_center.second));
+	params[gaussian_data::KERNEL].set_texture(kernel);
 
 	// First Pass
 	{
@@ -568,7 +617,8 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_zoom
 #endif
 
 	streamfx::obs::gs::effect effect = _data->get_effect();
-	auto                      kernel = _data->get_kernel(size_t(_size));
+	auto&                     params = _data->get_parameters();
+	auto                      kernel = _data->get_kernel_texture(size_t(_size));
 
 	if (!effect || ((_step_scale.first + _step_scale.second) < std::numeric_limits<double_t>::epsilon())) {
 		return _input_texture;
@@ -591,12 +641,12 @@ std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::gaussian_zoom
 	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
 	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
 
-	effect.get_parameter("pImage").set_texture(_input_texture);
-	effect.get_parameter("pImageTexel").set_float2(float_t(1.f / width), float_t(1.f / height));
-	effect.get_parameter("pStepScale").set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
-	effect.get_parameter("pSize").set_float(float_t(_size));
-	effect.get_parameter("pCenter").set_float2(float_t(m_center.first), float_t(m_center.second));
-	effect.get_parameter("pKernel").set_value(kernel.data(), ST_KERNEL_SIZE);
+	params[gaussian_data::IMAGE].set_texture(_input_texture);
+	params[gaussian_data::IMAGE_TEXEL].set_float2(float_t(1.f / width), float_t(1.f / height));
+	params[gaussian_data::STEP_SCALE].set_float2(float_t(_step_scale.first), float_t(_step_scale.second));
+	params[gaussian_data::SIZE].set_float(float_t(_size));
+	params[gaussian_data::CENTER].set_float2(float_t(m_center.first), float_t(m_center.second));
+	params[gaussian_data::KERNEL].set_texture(kernel);
 
 	// First Pass
 	{
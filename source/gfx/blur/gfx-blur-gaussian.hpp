@@ -17,18 +17,39 @@
 
 #pragma once
 #include "common.hpp"
+#include <map>
 #include <mutex>
 #include <vector>
 #include "gfx-blur-base.hpp"
+#include "gfx-blur-downsample.hpp"
+#include "gfx-blur-kernel-cache.hpp"
 #include "obs/gs/gs-effect.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
 #include "obs/gs/gs-texture.hpp"
 
 namespace streamfx::gfx {
 	namespace blur {
 		class gaussian_data {
-			streamfx::obs::gs::effect            _effect;
-			std::map<size_t, std::vector<float>> _kernels;
+			public:
+			enum parameter {
+				IMAGE,
+				IMAGE_TEXEL,
+				STEP_SCALE,
+				SIZE,
+				ANGLE,
+				CENTER,
+				KERNEL,
+				_COUNT,
+			};
+
+			private:
+			streamfx::obs::gs::effect                    _effect;
+			streamfx::obs::gs::effect_parameters<_COUNT> _parameters;
+			std::shared_ptr<kernel_cache>                _kernels;
+
+			// Kernels uploaded once per width, so that rendering only has to bind them.
+			std::map<std::size_t, std::shared_ptr<streamfx::obs::gs::texture>> _kernel_textures;
 
 			public:
 			gaussian_data();
@@ -36,7 +57,12 @@ namespace streamfx::gfx {
 
 			streamfx::obs::gs::effect get_effect();
 
-			std::vector<float_t> const& get_kernel(std::size_t width);
+			streamfx::obs::gs::effect_parameters<_COUNT>& get_parameters();
+
+			kernel_cache::kernel_t get_kernel(std::size_t width);
+
+			/** Kernel for this width as a texture, must be called with the graphics context held. */
+			std::shared_ptr<streamfx::obs::gs::texture> get_kernel_texture(std::size_t width);
 		};
 
 		class gaussian_factory : public ::streamfx::gfx::blur::ifactory {
@@ -93,7 +119,8 @@ namespace streamfx::gfx {
 			std::shared_ptr<::streamfx::obs::gs::rendertarget> _rendertarget;
 
 			private:
-			std::shared_ptr<::streamfx::obs::gs::rendertarget> _rendertarget2;
+			std::shared_ptr<::streamfx::obs::gs::rendertarget_pool> _pool;
+			::streamfx::gfx::blur::downsampler                      _downsampler;
 
 			public:
 			gaussian();
@@ -0,0 +1,73 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#include "gfx-blur-kernel-cache.hpp"
+
+// Widths up to this are never evicted, they cover the default and most commonly used blur sizes.
+#define ST_PINNED_WIDTH 8
+// Number of other kernels to keep around.
+#define ST_LRU_SIZE 16
+
+streamfx::gfx::blur::kernel_cache::kernel_cache() : _lock(), _pinned(), _lru(), _lru_map() {}
+
+streamfx::gfx::blur::kernel_cache::~kernel_cache() {}
+
+streamfx::gfx::blur::kernel_cache::kernel_t streamfx::gfx::blur::kernel_cache::get(kernel_type type, std::size_t width,
+																					std::size_t size,
+																					generator_t generator)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	key_t                        key{type, width};
+
+	if (auto found = _pinned.find(key); found != _pinned.end()) {
+		return found->second;
+	}
+	if (auto found = _lru_map.find(key); found != _lru_map.end()) {
+		_lru.splice(_lru.begin(), _lru, found->second);
+		return found->second->second;
+	}
+
+	// Generated while holding the lock, which only happens once per width.
+	auto kernel = std::make_shared<std::vector<float_t>>(size, 0.f);
+	generator(width, *kernel);
+
+	if (width <= ST_PINNED_WIDTH) {
+		_pinned.emplace(key, kernel);
+	} else {
+		_lru.emplace_front(key, kernel);
+		_lru_map.emplace(key, _lru.begin());
+		if (_lru.size() > ST_LRU_SIZE) {
+			_lru_map.erase(_lru.back().first);
+			_lru.pop_back();
+		}
+	}
+
+	return kernel;
+}
+
+std::shared_ptr<streamfx::gfx::blur::kernel_cache> streamfx::gfx::blur::kernel_cache::instance()
+{
+	static std::mutex                  lock;
+	static std::weak_ptr<kernel_cache> weak;
+	std::unique_lock<std::mutex>       ul(lock);
+	std::shared_ptr<kernel_cache>      ptr = weak.lock();
+	if (!ptr) {
+		ptr  = std::make_shared<kernel_cache>();
+		weak = ptr;
+	}
+	return ptr;
+}
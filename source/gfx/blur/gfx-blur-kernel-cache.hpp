@@ -0,0 +1,60 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#pragma once
+#include "common.hpp"
+#include <list>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace streamfx::gfx {
+	namespace blur {
+		enum class kernel_type {
+			Gaussian,
+			GaussianLinear,
+		};
+
+		/** Lazily generated blur kernels, shared by all blur implementations.
+		 *
+		 * Kernels are generated on first request. Small widths are kept forever since nearly every scene uses them,
+		 * all others are kept in a small least-recently-used list.
+		 */
+		class kernel_cache {
+			public:
+			typedef std::shared_ptr<const std::vector<float_t>> kernel_t;
+			typedef void (*generator_t)(std::size_t width, std::vector<float_t>& kernel);
+
+			private:
+			typedef std::pair<kernel_type, std::size_t> key_t;
+
+			std::mutex                                                       _lock;
+			std::map<key_t, kernel_t>                                        _pinned;
+			std::list<std::pair<key_t, kernel_t>>                            _lru;
+			std::map<key_t, std::list<std::pair<key_t, kernel_t>>::iterator> _lru_map;
+
+			public:
+			kernel_cache();
+			~kernel_cache();
+
+			kernel_t get(kernel_type type, std::size_t width, std::size_t size, generator_t generator);
+
+			public:
+			static std::shared_ptr<kernel_cache> instance();
+		};
+	} // namespace blur
+} // namespace streamfx::gfx
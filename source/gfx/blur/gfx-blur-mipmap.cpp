@@ -0,0 +1,281 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#include "gfx-blur-mipmap.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "obs/gs/gs-helper.hpp"
+#include "plugin.hpp"
+#include "util/utility.hpp"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <obs.h>
+#include <obs-module.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+// Mipmap Blur
+//
+// A mip level n already holds the average of 2^n by 2^n texels, and the tent filter in the effect spreads that over
+//  one more texel of the level in each direction. Sampling level log2(size) - 1 therefore reaches about size pixels.
+
+#define ST_MAX_BLUR_SIZE 512
+
+streamfx::gfx::blur::mipmap_data::mipmap_data()
+{
+	auto gctx = streamfx::obs::gs::context();
+	try {
+		_effect = streamfx::obs::gs::effect::create(streamfx::data_file_path("effects/blur/mipmap.effect").u8string());
+	} catch (...) {
+		DLOG_ERROR("<gfx::blur::mipmap> Failed to load _effect.");
+	}
+}
+
+streamfx::gfx::blur::mipmap_data::~mipmap_data()
+{
+	auto gctx = streamfx::obs::gs::context();
+	_effect.reset();
+}
+
+streamfx::obs::gs::effect streamfx::gfx::blur::mipmap_data::get_effect()
+{
+	return _effect;
+}
+
+streamfx::gfx::blur::mipmap_factory::mipmap_factory() {}
+
+streamfx::gfx::blur::mipmap_factory::~mipmap_factory() {}
+
+bool streamfx::gfx::blur::mipmap_factory::is_type_supported(::streamfx::gfx::blur::type type)
+{
+	switch (type) {
+	case ::streamfx::gfx::blur::type::Area:
+		return true;
+	default:
+		return false;
+	}
+}
+
+std::shared_ptr<::streamfx::gfx::blur::base>
+	streamfx::gfx::blur::mipmap_factory::create(::streamfx::gfx::blur::type type)
+{
+	switch (type) {
+	case ::streamfx::gfx::blur::type::Area:
+		return std::make_shared<::streamfx::gfx::blur::mipmap>();
+	default:
+		throw std::runtime_error("Invalid type.");
+	}
+}
+
+double_t streamfx::gfx::blur::mipmap_factory::get_min_size(::streamfx::gfx::blur::type)
+{
+	return double_t(1.);
+}
+
+double_t streamfx::gfx::blur::mipmap_factory::get_step_size(::streamfx::gfx::blur::type)
+{
+	return double_t(1.);
+}
+
+double_t streamfx::gfx::blur::mipmap_factory::get_max_size(::streamfx::gfx::blur::type)
+{
+	return double_t(ST_MAX_BLUR_SIZE);
+}
+
+double_t streamfx::gfx::blur::mipmap_factory::get_min_angle(::streamfx::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t streamfx::gfx::blur::mipmap_factory::get_step_angle(::streamfx::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t streamfx::gfx::blur::mipmap_factory::get_max_angle(::streamfx::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+bool streamfx::gfx::blur::mipmap_factory::is_step_scale_supported(::streamfx::gfx::blur::type)
+{
+	return false;
+}
+
+double_t streamfx::gfx::blur::mipmap_factory::get_min_step_scale_x(::streamfx::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t streamfx::gfx::blur::mipmap_factory::get_step_step_scale_x(::streamfx::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t streamfx::gfx::blur::mipmap_factory::get_max_step_scale_x(::streamfx::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t streamfx::gfx::blur::mipmap_factory::get_min_step_scale_y(::streamfx::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t streamfx::gfx::blur::mipmap_factory::get_step_step_scale_y(::streamfx::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t streamfx::gfx::blur::mipmap_factory::get_max_step_scale_y(::streamfx::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+std::shared_ptr<::streamfx::gfx::blur::mipmap_data> streamfx::gfx::blur::mipmap_factory::data()
+{
+	std::unique_lock<std::mutex>                        ulock(_data_lock);
+	std::shared_ptr<::streamfx::gfx::blur::mipmap_data> data = _data.lock();
+	if (!data) {
+		data  = std::make_shared<::streamfx::gfx::blur::mipmap_data>();
+		_data = data;
+	}
+	return data;
+}
+
+::streamfx::gfx::blur::mipmap_factory& streamfx::gfx::blur::mipmap_factory::get()
+{
+	static ::streamfx::gfx::blur::mipmap_factory instance;
+	return instance;
+}
+
+streamfx::gfx::blur::mipmap::mipmap() : _data(::streamfx::gfx::blur::mipmap_factory::get().data()), _size(1.)
+{
+	auto gctx     = streamfx::obs::gs::context();
+	_rendertarget = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+}
+
+streamfx::gfx::blur::mipmap::~mipmap() {}
+
+void streamfx::gfx::blur::mipmap::set_input(std::shared_ptr<::streamfx::obs::gs::texture> texture)
+{
+	_input_texture = texture;
+}
+
+::streamfx::gfx::blur::type streamfx::gfx::blur::mipmap::get_type()
+{
+	return ::streamfx::gfx::blur::type::Area;
+}
+
+double_t streamfx::gfx::blur::mipmap::get_size()
+{
+	return _size;
+}
+
+void streamfx::gfx::blur::mipmap::set_size(double_t width)
+{
+	_size = std::clamp(width, 1., double_t(ST_MAX_BLUR_SIZE));
+}
+
+void streamfx::gfx::blur::mipmap::set_step_scale(double_t, double_t) {}
+
+void streamfx::gfx::blur::mipmap::get_step_scale(double_t&, double_t&) {}
+
+std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::mipmap::render()
+{
+	auto gctx = streamfx::obs::gs::context();
+
+#ifdef ENABLE_PROFILING
+	auto gdmp = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Mipmap Blur");
+#endif
+
+	auto effect = _data->get_effect();
+	if (!effect) {
+		return _input_texture;
+	}
+
+	uint32_t width     = _input_texture->get_width();
+	uint32_t height    = _input_texture->get_height();
+	uint64_t mip_count = std::max<uint64_t>(std::max(streamfx::util::math::get_power_of_two_exponent_ceil(width),
+													 streamfx::util::math::get_power_of_two_exponent_ceil(height)),
+											1);
+	double_t level     = std::clamp(std::log2(_size) - 1., 0., double_t(mip_count - 1));
+
+	std::shared_ptr<streamfx::obs::gs::texture>      texture = _input_texture;
+	std::shared_ptr<streamfx::obs::gs::rendertarget> downsampled;
+	if (gs_get_device_type() == GS_DEVICE_DIRECT3D_11) {
+		if (!_mipmap_texture || (_mipmap_texture->get_width() != width)
+			|| (_mipmap_texture->get_height() != height)) {
+#ifdef ENABLE_PROFILING
+			auto gdr = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_allocate, "Allocate Mipmap");
+#endif
+			_mipmap_texture = std::make_shared<streamfx::obs::gs::texture>(width, height, GS_RGBA,
+																		   static_cast<uint32_t>(mip_count), nullptr,
+																		   streamfx::obs::gs::texture::flags::None);
+		}
+		_mipmapper.rebuild(_input_texture, _mipmap_texture);
+		texture = _mipmap_texture;
+	} else {
+		// Without a mip chain, scale down by the whole levels and sample the result at full detail.
+		uint32_t factor = 1u << static_cast<uint32_t>(level);
+		if (factor > 1) {
+			downsampled = _downsampler.downsample(_input_texture, factor);
+			texture     = downsampled->get_texture();
+		}
+		level = 0.;
+	}
+
+	gs_blend_state_push();
+	gs_reset_blend_state();
+	gs_enable_color(true, true, true, true);
+	gs_enable_blending(false);
+	gs_enable_depth_test(false);
+	gs_enable_stencil_test(false);
+	gs_enable_stencil_write(false);
+	gs_set_cull_mode(GS_NEITHER);
+	gs_depth_function(GS_ALWAYS);
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
+	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
+
+	effect.get_parameter("pImage").set_texture(texture);
+	effect.get_parameter("pImageTexel")
+		.set_float2(1.f / float_t(texture->get_width()), 1.f / float_t(texture->get_height()));
+	effect.get_parameter("pLevel").set_float(float_t(level));
+
+	{
+		auto op = _rendertarget->render(width, height);
+		gs_ortho(0., 1., 0., 1., 0., 1.);
+		while (gs_effect_loop(effect.get_object(), "Draw")) {
+			streamfx::gs_draw_fullscreen_tri();
+		}
+	}
+
+	gs_blend_state_pop();
+
+	return _rendertarget->get_texture();
+}
+
+std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::mipmap::get()
+{
+	return _rendertarget->get_texture();
+}
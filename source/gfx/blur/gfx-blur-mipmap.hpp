@@ -0,0 +1,122 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2019 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#pragma once
+#include "common.hpp"
+#include <mutex>
+#include "gfx-blur-base.hpp"
+#include "gfx-blur-downsample.hpp"
+#include "obs/gs/gs-effect.hpp"
+#include "obs/gs/gs-mipmapper.hpp"
+#include "obs/gs/gs-rendertarget.hpp"
+#include "obs/gs/gs-texture.hpp"
+
+namespace streamfx::gfx {
+	namespace blur {
+		class mipmap_data {
+			streamfx::obs::gs::effect _effect;
+
+			public:
+			mipmap_data();
+			virtual ~mipmap_data();
+
+			streamfx::obs::gs::effect get_effect();
+		};
+
+		class mipmap_factory : public ::streamfx::gfx::blur::ifactory {
+			std::mutex                                        _data_lock;
+			std::weak_ptr<::streamfx::gfx::blur::mipmap_data> _data;
+
+			public:
+			mipmap_factory();
+			virtual ~mipmap_factory() override;
+
+			virtual bool is_type_supported(::streamfx::gfx::blur::type type) override;
+
+			virtual std::shared_ptr<::streamfx::gfx::blur::base> create(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_min_size(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_step_size(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_max_size(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_min_angle(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_step_angle(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_max_angle(::streamfx::gfx::blur::type type) override;
+
+			virtual bool is_step_scale_supported(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_min_step_scale_x(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_step_step_scale_x(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_max_step_scale_x(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_min_step_scale_y(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_step_step_scale_y(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_max_step_scale_y(::streamfx::gfx::blur::type type) override;
+
+			std::shared_ptr<::streamfx::gfx::blur::mipmap_data> data();
+
+			public: // Singleton
+			static ::streamfx::gfx::blur::mipmap_factory& get();
+		};
+
+		/** Approximate blur that samples a fractional mip level of the input with a small tent filter.
+		 *
+		 * The cost is one mip chain generation and a single pass, no matter the radius. Where gs::mipmapper can not
+		 * build the chain (it only supports Direct3D 11), the input is scaled down by the whole levels instead.
+		 */
+		class mipmap : public ::streamfx::gfx::blur::base {
+			std::shared_ptr<::streamfx::gfx::blur::mipmap_data> _data;
+
+			double_t _size;
+
+			std::shared_ptr<streamfx::obs::gs::texture> _input_texture;
+
+			streamfx::obs::gs::mipmapper                     _mipmapper;
+			std::shared_ptr<streamfx::obs::gs::texture>      _mipmap_texture;
+			::streamfx::gfx::blur::downsampler               _downsampler;
+			std::shared_ptr<streamfx::obs::gs::rendertarget> _rendertarget;
+
+			public:
+			mipmap();
+			virtual ~mipmap() override;
+
+			virtual void set_input(std::shared_ptr<::streamfx::obs::gs::texture> texture) override;
+
+			virtual ::streamfx::gfx::blur::type get_type() override;
+
+			virtual double_t get_size() override;
+
+			virtual void set_size(double_t width) override;
+
+			virtual void set_step_scale(double_t x, double_t y) override;
+
+			virtual void get_step_scale(double_t& x, double_t& y) override;
+
+			virtual std::shared_ptr<::streamfx::obs::gs::texture> render() override;
+
+			virtual std::shared_ptr<::streamfx::obs::gs::texture> get() override;
+		};
+	} // namespace blur
+} // namespace streamfx::gfx
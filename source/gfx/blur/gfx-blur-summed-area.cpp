@@ -0,0 +1,327 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2022 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#include "gfx-blur-summed-area.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "obs/gs/gs-helper.hpp"
+#include "plugin.hpp"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <obs.h>
+#include <obs-module.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+// Summed Area Table Blur
+//
+// Every texel of the table holds the sum of all texels above and to the left of it, including itself. The sum of any
+//  box is then four fetches away, no matter how large it is. Building the table takes one pass per power of two in
+//  each direction, where every texel adds the texel that is that power of two in front of it.
+
+#define ST_MAX_BLUR_SIZE 512
+
+streamfx::gfx::blur::summed_area_data::summed_area_data()
+{
+	auto gctx = streamfx::obs::gs::context();
+	try {
+		_effect =
+			streamfx::obs::gs::effect::create(streamfx::data_file_path("effects/blur/summed-area.effect").u8string());
+	} catch (...) {
+		DLOG_ERROR("<gfx::blur::summed_area> Failed to load _effect.");
+	}
+}
+
+streamfx::gfx::blur::summed_area_data::~summed_area_data()
+{
+	auto gctx = streamfx::obs::gs::context();
+	_effect.reset();
+}
+
+streamfx::obs::gs::effect streamfx::gfx::blur::summed_area_data::get_effect()
+{
+	return _effect;
+}
+
+streamfx::gfx::blur::summed_area_factory::summed_area_factory() {}
+
+streamfx::gfx::blur::summed_area_factory::~summed_area_factory() {}
+
+bool streamfx::gfx::blur::summed_area_factory::is_type_supported(::streamfx::gfx::blur::type type)
+{
+	switch (type) {
+	case ::streamfx::gfx::blur::type::Area:
+		return true;
+	default:
+		return false;
+	}
+}
+
+std::shared_ptr<::streamfx::gfx::blur::base>
+	streamfx::gfx::blur::summed_area_factory::create(::streamfx::gfx::blur::type type)
+{
+	switch (type) {
+	case ::streamfx::gfx::blur::type::Area:
+		return std::make_shared<::streamfx::gfx::blur::summed_area>();
+	default:
+		throw std::runtime_error("Invalid type.");
+	}
+}
+
+double_t streamfx::gfx::blur::summed_area_factory::get_min_size(::streamfx::gfx::blur::type)
+{
+	return double_t(1.);
+}
+
+double_t streamfx::gfx::blur::summed_area_factory::get_step_size(::streamfx::gfx::blur::type)
+{
+	return double_t(1.);
+}
+
+double_t streamfx::gfx::blur::summed_area_factory::get_max_size(::streamfx::gfx::blur::type)
+{
+	return double_t(ST_MAX_BLUR_SIZE);
+}
+
+double_t streamfx::gfx::blur::summed_area_factory::get_min_angle(::streamfx::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t streamfx::gfx::blur::summed_area_factory::get_step_angle(::streamfx::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+double_t streamfx::gfx::blur::summed_area_factory::get_max_angle(::streamfx::gfx::blur::type)
+{
+	return double_t(0);
+}
+
+bool streamfx::gfx::blur::summed_area_factory::is_step_scale_supported(::streamfx::gfx::blur::type)
+{
+	return true;
+}
+
+double_t streamfx::gfx::blur::summed_area_factory::get_min_step_scale_x(::streamfx::gfx::blur::type)
+{
+	return double_t(0.01);
+}
+
+double_t streamfx::gfx::blur::summed_area_factory::get_step_step_scale_x(::streamfx::gfx::blur::type)
+{
+	return double_t(0.01);
+}
+
+double_t streamfx::gfx::blur::summed_area_factory::get_max_step_scale_x(::streamfx::gfx::blur::type)
+{
+	return double_t(1000.0);
+}
+
+double_t streamfx::gfx::blur::summed_area_factory::get_min_step_scale_y(::streamfx::gfx::blur::type)
+{
+	return double_t(0.01);
+}
+
+double_t streamfx::gfx::blur::summed_area_factory::get_step_step_scale_y(::streamfx::gfx::blur::type)
+{
+	return double_t(0.01);
+}
+
+double_t streamfx::gfx::blur::summed_area_factory::get_max_step_scale_y(::streamfx::gfx::blur::type)
+{
+	return double_t(1000.0);
+}
+
+std::shared_ptr<::streamfx::gfx::blur::summed_area_data> streamfx::gfx::blur::summed_area_factory::data()
+{
+	std::unique_lock<std::mutex>                             ulock(_data_lock);
+	std::shared_ptr<::streamfx::gfx::blur::summed_area_data> data = _data.lock();
+	if (!data) {
+		data  = std::make_shared<::streamfx::gfx::blur::summed_area_data>();
+		_data = data;
+	}
+	return data;
+}
+
+::streamfx::gfx::blur::summed_area_factory& streamfx::gfx::blur::summed_area_factory::get()
+{
+	static ::streamfx::gfx::blur::summed_area_factory instance;
+	return instance;
+}
+
+streamfx::gfx::blur::summed_area::summed_area()
+	: _data(::streamfx::gfx::blur::summed_area_factory::get().data()), _size(1.), _step_scale({1., 1.}),
+	  _radius_map_weights()
+{
+	auto gctx     = streamfx::obs::gs::context();
+	_rendertarget = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	_pool         = streamfx::obs::gs::rendertarget_pool::instance();
+}
+
+streamfx::gfx::blur::summed_area::~summed_area() {}
+
+void streamfx::gfx::blur::summed_area::set_input(std::shared_ptr<::streamfx::obs::gs::texture> texture)
+{
+	_input_texture = texture;
+}
+
+::streamfx::gfx::blur::type streamfx::gfx::blur::summed_area::get_type()
+{
+	return ::streamfx::gfx::blur::type::Area;
+}
+
+double_t streamfx::gfx::blur::summed_area::get_size()
+{
+	return _size;
+}
+
+void streamfx::gfx::blur::summed_area::set_size(double_t width)
+{
+	_size = std::clamp(width, 1., double_t(ST_MAX_BLUR_SIZE));
+}
+
+void streamfx::gfx::blur::summed_area::set_step_scale(double_t x, double_t y)
+{
+	_step_scale = {x, y};
+}
+
+void streamfx::gfx::blur::summed_area::get_step_scale(double_t& x, double_t& y)
+{
+	x = _step_scale.first;
+	y = _step_scale.second;
+}
+
+double_t streamfx::gfx::blur::summed_area::get_step_scale_x()
+{
+	return _step_scale.first;
+}
+
+double_t streamfx::gfx::blur::summed_area::get_step_scale_y()
+{
+	return _step_scale.second;
+}
+
+void streamfx::gfx::blur::summed_area::set_radius_map(std::shared_ptr<::streamfx::obs::gs::texture> texture,
+													   const vec4&                                   weights)
+{
+	_radius_map = texture;
+	vec4_copy(&_radius_map_weights, &weights);
+}
+
+std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::summed_area::render()
+{
+	auto gctx = streamfx::obs::gs::context();
+
+#ifdef ENABLE_PROFILING
+	auto gdmp = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Summed Area Blur");
+#endif
+
+	auto effect = _data->get_effect();
+	if (!effect) {
+		return _input_texture;
+	}
+
+	uint32_t width  = _input_texture->get_width();
+	uint32_t height = _input_texture->get_height();
+
+	gs_blend_state_push();
+	gs_reset_blend_state();
+	gs_enable_color(true, true, true, true);
+	gs_enable_blending(false);
+	gs_enable_depth_test(false);
+	gs_enable_stencil_test(false);
+	gs_enable_stencil_write(false);
+	gs_set_cull_mode(GS_NEITHER);
+	gs_depth_function(GS_ALWAYS);
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+	gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
+	gs_stencil_op(GS_STENCIL_BOTH, GS_ZERO, GS_ZERO, GS_ZERO);
+
+	// Build the table by ping-ponging between two float targets, first along rows and then along columns. The first
+	//  pass also centers the values around zero, which keeps the sums small enough for float precision. It always runs,
+	//  even for a single texel, as the evaluation expects centered values.
+	std::shared_ptr<streamfx::obs::gs::rendertarget> targets[2] = {
+		_pool->acquire(width, height, GS_RGBA32F),
+		_pool->acquire(width, height, GS_RGBA32F),
+	};
+	std::shared_ptr<streamfx::obs::gs::texture> table = _input_texture;
+	{
+#ifdef ENABLE_PROFILING
+		auto gdm = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Table");
+#endif
+
+		size_t pass = 0;
+		for (size_t axis = 0; axis < 2; axis++) {
+			uint32_t length = axis ? height : width;
+			for (uint32_t offset = 1; (offset < length) || (pass == 0); offset <<= 1, pass++) {
+				auto& target = targets[pass % 2];
+
+				effect.get_parameter("pImage").set_texture(table);
+				effect.get_parameter("pOffset")
+					.set_float2(axis ? 0.f : float_t(offset) / float_t(width),
+								axis ? float_t(offset) / float_t(height) : 0.f);
+				{
+					auto op = target->render(width, height);
+					gs_ortho(0., 1., 0., 1., 0., 1.);
+					while (gs_effect_loop(effect.get_object(), pass ? "Prefix" : "PrefixFirst")) {
+						streamfx::gs_draw_fullscreen_tri();
+					}
+				}
+				table = target->get_texture();
+			}
+		}
+	}
+
+	// Evaluate the box around every pixel.
+	{
+#ifdef ENABLE_PROFILING
+		auto gdm = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Box");
+#endif
+
+		effect.get_parameter("pImage").set_texture(_input_texture);
+		effect.get_parameter("pImageSize").set_float2(float_t(width), float_t(height));
+		effect.get_parameter("pImageTexel").set_float2(1.f / float_t(width), 1.f / float_t(height));
+		effect.get_parameter("pSummedArea").set_texture(table);
+		effect.get_parameter("pRadius")
+			.set_float2(float_t(_size * _step_scale.first), float_t(_size * _step_scale.second));
+		if (_radius_map) {
+			effect.get_parameter("pRadiusMap").set_texture(_radius_map);
+			effect.get_parameter("pRadiusMapWeights").set_float4(_radius_map_weights);
+		}
+
+		auto op = _rendertarget->render(width, height);
+		gs_ortho(0., 1., 0., 1., 0., 1.);
+		while (gs_effect_loop(effect.get_object(), _radius_map ? "DrawVariable" : "Draw")) {
+			streamfx::gs_draw_fullscreen_tri();
+		}
+	}
+
+	gs_blend_state_pop();
+
+	return _rendertarget->get_texture();
+}
+
+std::shared_ptr<::streamfx::obs::gs::texture> streamfx::gfx::blur::summed_area::get()
+{
+	return _rendertarget->get_texture();
+}
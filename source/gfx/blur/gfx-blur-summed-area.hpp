@@ -0,0 +1,137 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2022 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#pragma once
+#include "common.hpp"
+#include <mutex>
+#include "gfx-blur-base.hpp"
+#include "obs/gs/gs-effect.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
+#include "obs/gs/gs-rendertarget.hpp"
+#include "obs/gs/gs-texture.hpp"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <graphics/vec4.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+namespace streamfx::gfx {
+	namespace blur {
+		class summed_area_data {
+			streamfx::obs::gs::effect _effect;
+
+			public:
+			summed_area_data();
+			virtual ~summed_area_data();
+
+			streamfx::obs::gs::effect get_effect();
+		};
+
+		class summed_area_factory : public ::streamfx::gfx::blur::ifactory {
+			std::mutex                                             _data_lock;
+			std::weak_ptr<::streamfx::gfx::blur::summed_area_data> _data;
+
+			public:
+			summed_area_factory();
+			virtual ~summed_area_factory() override;
+
+			virtual bool is_type_supported(::streamfx::gfx::blur::type type) override;
+
+			virtual std::shared_ptr<::streamfx::gfx::blur::base> create(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_min_size(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_step_size(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_max_size(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_min_angle(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_step_angle(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_max_angle(::streamfx::gfx::blur::type type) override;
+
+			virtual bool is_step_scale_supported(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_min_step_scale_x(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_step_step_scale_x(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_max_step_scale_x(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_min_step_scale_y(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_step_step_scale_y(::streamfx::gfx::blur::type type) override;
+
+			virtual double_t get_max_step_scale_y(::streamfx::gfx::blur::type type) override;
+
+			std::shared_ptr<::streamfx::gfx::blur::summed_area_data> data();
+
+			public: // Singleton
+			static ::streamfx::gfx::blur::summed_area_factory& get();
+		};
+
+		/** Box blur that reads any radius from a summed area table with four fetches.
+		 *
+		 * The table is built with log2(width) + log2(height) prefix sum passes into a float target, after which the
+		 * radius no longer affects the cost. This also allows the radius to change per pixel, see set_radius_map().
+		 */
+		class summed_area : public ::streamfx::gfx::blur::base {
+			std::shared_ptr<::streamfx::gfx::blur::summed_area_data> _data;
+
+			double_t                      _size;
+			std::pair<double_t, double_t> _step_scale;
+
+			std::shared_ptr<::streamfx::obs::gs::texture> _input_texture;
+			std::shared_ptr<::streamfx::obs::gs::texture> _radius_map;
+			vec4                                          _radius_map_weights;
+
+			std::shared_ptr<::streamfx::obs::gs::rendertarget_pool> _pool;
+			std::shared_ptr<::streamfx::obs::gs::rendertarget>      _rendertarget;
+
+			public:
+			summed_area();
+			virtual ~summed_area() override;
+
+			virtual void set_input(std::shared_ptr<::streamfx::obs::gs::texture> texture) override;
+
+			virtual ::streamfx::gfx::blur::type get_type() override;
+
+			virtual double_t get_size() override;
+			virtual void     set_size(double_t width) override;
+
+			virtual void     set_step_scale(double_t x, double_t y) override;
+			virtual void     get_step_scale(double_t& x, double_t& y) override;
+			virtual double_t get_step_scale_x() override;
+			virtual double_t get_step_scale_y() override;
+
+			/** Scale the radius per pixel by a texture, for example a mask.
+			 *
+			 * The radius at a pixel is the size multiplied by the saturated dot product of the map and the weights,
+			 * so a map that is zero somewhere leaves that pixel untouched. Pass nullptr to use the size everywhere.
+			 */
+			void set_radius_map(std::shared_ptr<::streamfx::obs::gs::texture> texture, const vec4& weights);
+
+			virtual std::shared_ptr<::streamfx::obs::gs::texture> render() override;
+			virtual std::shared_ptr<::streamfx::obs::gs::texture> get() override;
+		};
+	} // namespace blur
+} // namespace streamfx::gfx
@@ -0,0 +1,229 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "gfx-image-statistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "obs/gs/gs-helper.hpp"
+#include "plugin.hpp"
+
+// Texels left in the level the histograms are built from, and in the levels the range is read from.
+#define ST_HISTOGRAM_TEXELS 16384
+#define ST_RANGE_TEXELS 64
+
+// Copies still on the GPU before a result is read, see gs::readback.
+#define ST_READBACK_LATENCY 2
+
+// Every part of a result, which are all delivered during the same update().
+#define ST_PART_MEAN (1u << 0)
+#define ST_PART_MINIMUM (1u << 1)
+#define ST_PART_MAXIMUM (1u << 2)
+#define ST_PART_ALL (ST_PART_MEAN | ST_PART_MINIMUM | ST_PART_MAXIMUM)
+
+float_t streamfx::gfx::image_statistics::result::percentile(const std::array<uint32_t, 256>& histogram,
+															  float_t                           fraction) const
+{
+	uint64_t threshold = static_cast<uint64_t>(std::ceil(static_cast<double_t>(samples) * fraction));
+	uint64_t count     = 0;
+	for (std::size_t bin = 0; bin < histogram.size(); bin++) {
+		count += histogram[bin];
+		if (count >= threshold) {
+			return static_cast<float_t>(bin) / 255.f;
+		}
+	}
+	return 1.f;
+}
+
+streamfx::gfx::image_statistics::image_statistics()
+	: _effect(), _pool(streamfx::obs::gs::rendertarget_pool::instance()), _mean_readback(ST_READBACK_LATENCY),
+	  _minimum_readback(ST_READBACK_LATENCY), _maximum_readback(ST_READBACK_LATENCY), _pending(), _pending_parts(0),
+	  _result(), _have_result(false)
+{
+	auto gctx = streamfx::obs::gs::context();
+	_effect   = streamfx::obs::gs::effect::create_shared(streamfx::data_file_path("effects/image-statistics.effect"));
+	if (!_effect) {
+		throw std::runtime_error("Failed to load image statistics effect.");
+	}
+}
+
+streamfx::gfx::image_statistics::~image_statistics()
+{
+	auto gctx = streamfx::obs::gs::context();
+	reset();
+	_effect.reset();
+}
+
+std::shared_ptr<streamfx::obs::gs::rendertarget>
+	streamfx::gfx::image_statistics::reduce(std::shared_ptr<streamfx::obs::gs::texture> image, const char* technique,
+											uint64_t limit)
+{
+	std::shared_ptr<streamfx::obs::gs::rendertarget> rt;
+	std::shared_ptr<streamfx::obs::gs::texture>      tex    = image;
+	uint32_t                                         width  = image->get_width();
+	uint32_t                                         height = image->get_height();
+
+	// Always reduce at least once, as only the reduced levels hold the luma.
+	do {
+		uint32_t owidth  = (width + 3) / 4;
+		uint32_t oheight = (height + 3) / 4;
+
+		// Levels that are no longer needed return to the pool right away.
+		auto next = _pool->acquire(owidth, oheight, GS_RGBA32F);
+
+		_effect.get_parameter("image").set_texture(tex);
+		_effect.get_parameter("imageSize").set_float2(static_cast<float_t>(width), static_cast<float_t>(height));
+		_effect.get_parameter("outputSize").set_float2(static_cast<float_t>(owidth), static_cast<float_t>(oheight));
+		_effect.get_parameter("convert").set_float(rt ? 0.f : 1.f);
+
+		{
+			auto op = next->render(owidth, oheight);
+			gs_ortho(0., 1., 0., 1., 0., 1.);
+			while (gs_effect_loop(_effect.get_object(), technique)) {
+				streamfx::gs_draw_fullscreen_tri();
+			}
+		}
+
+		rt     = next;
+		tex    = rt->get_texture();
+		width  = owidth;
+		height = oheight;
+	} while ((static_cast<uint64_t>(width) * height) > limit);
+
+	return rt;
+}
+
+void streamfx::gfx::image_statistics::read_mean(const uint8_t* data, uint32_t stride, uint32_t width,
+												 uint32_t height)
+{
+	if (!data) {
+		return;
+	}
+
+	_pending.luma.fill(0);
+	_pending.red.fill(0);
+	_pending.green.fill(0);
+	_pending.blue.fill(0);
+	_pending.samples = width * height;
+
+	auto     bin    = [](float_t v) { return static_cast<std::size_t>(std::clamp(v, 0.f, 1.f) * 255.f + .5f); };
+	double_t sum[4] = {0., 0., 0., 0.};
+	for (uint32_t y = 0; y < height; y++) {
+		auto row = reinterpret_cast<const float_t*>(data + static_cast<std::size_t>(stride) * y);
+		for (uint32_t x = 0; x < width; x++) {
+			const float_t* px = row + x * 4;
+			_pending.red[bin(px[0])]++;
+			_pending.green[bin(px[1])]++;
+			_pending.blue[bin(px[2])]++;
+			_pending.luma[bin(px[3])]++;
+			for (std::size_t c = 0; c < 4; c++) {
+				sum[c] += px[c];
+			}
+		}
+	}
+	for (std::size_t c = 0; c < 4; c++) {
+		_pending.mean.ptr[c] = static_cast<float_t>(sum[c] / _pending.samples);
+	}
+	_pending_parts |= ST_PART_MEAN;
+}
+
+void streamfx::gfx::image_statistics::read_range(vec4& value, uint32_t part, const uint8_t* data, uint32_t stride,
+												  uint32_t width, uint32_t height)
+{
+	if (!data) {
+		return;
+	}
+
+	// The minimum chain keeps the smallest values and the maximum chain the largest, which is all that differs here.
+	bool is_minimum = (part == ST_PART_MINIMUM);
+	for (uint32_t y = 0; y < height; y++) {
+		auto row = reinterpret_cast<const float_t*>(data + static_cast<std::size_t>(stride) * y);
+		for (uint32_t x = 0; x < width; x++) {
+			const float_t* px = row + x * 4;
+			for (std::size_t c = 0; c < 4; c++) {
+				if (((x == 0) && (y == 0)) || (is_minimum ? (px[c] < value.ptr[c]) : (px[c] > value.ptr[c]))) {
+					value.ptr[c] = px[c];
+				}
+			}
+		}
+	}
+	_pending_parts |= part;
+}
+
+void streamfx::gfx::image_statistics::update(std::shared_ptr<streamfx::obs::gs::texture> image)
+{
+	auto gctx = streamfx::obs::gs::context();
+
+#ifdef ENABLE_PROFILING
+	auto gdmp = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance, "Image Statistics");
+#endif
+
+	if (!image) {
+		return;
+	}
+
+	gs_blend_state_push();
+	gs_reset_blend_state();
+	gs_enable_color(true, true, true, true);
+	gs_enable_blending(false);
+	gs_enable_depth_test(false);
+	gs_enable_stencil_test(false);
+	gs_enable_stencil_write(false);
+	gs_set_cull_mode(GS_NEITHER);
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+
+	auto mean    = reduce(image, "Mean", ST_HISTOGRAM_TEXELS);
+	auto minimum = reduce(image, "Minimum", ST_RANGE_TEXELS);
+	auto maximum = reduce(image, "Maximum", ST_RANGE_TEXELS);
+
+	gs_blend_state_pop();
+
+	_pending_parts = 0;
+	_mean_readback.stage(mean->get_object(), [this](const uint8_t* data, uint32_t stride, uint32_t w, uint32_t h) {
+		read_mean(data, stride, w, h);
+	});
+	_minimum_readback.stage(minimum->get_object(),
+							[this](const uint8_t* data, uint32_t stride, uint32_t w, uint32_t h) {
+								read_range(_pending.minimum, ST_PART_MINIMUM, data, stride, w, h);
+							});
+	_maximum_readback.stage(maximum->get_object(),
+							[this](const uint8_t* data, uint32_t stride, uint32_t w, uint32_t h) {
+								read_range(_pending.maximum, ST_PART_MAXIMUM, data, stride, w, h);
+							});
+
+	// A result is only published once all of its parts arrived, so that they always describe the same frame.
+	if (_pending_parts == ST_PART_ALL) {
+		_result      = _pending;
+		_have_result = true;
+	}
+}
+
+const streamfx::gfx::image_statistics::result* streamfx::gfx::image_statistics::get()
+{
+	return _have_result ? &_result : nullptr;
+}
+
+void streamfx::gfx::image_statistics::reset()
+{
+	_mean_readback.reset();
+	_minimum_readback.reset();
+	_maximum_readback.reset();
+	_pending_parts = 0;
+	_have_result   = false;
+}
@@ -0,0 +1,93 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <array>
+#include <memory>
+#include "obs/gs/gs-effect.hpp"
+#include "obs/gs/gs-readback.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
+#include "obs/gs/gs-texture.hpp"
+
+namespace streamfx::gfx {
+	/** Measures the brightness and colors of an image on the GPU.
+	 *
+	 * The image is reduced by 4x4 blocks per pass into a mean, a minimum and a maximum chain, and only the last levels
+	 * of those are read back. Nothing waits for the GPU, the results of a call to update() become available a few
+	 * calls later. The histograms are built from the last level of the mean chain, so they count block averages
+	 * rather than single pixels, which makes them narrower than those of the full image but is plenty for exposure.
+	 *
+	 * All methods must be called from within the graphics context.
+	 */
+	class image_statistics {
+		public:
+		struct result {
+			vec4 minimum; // Red, green, blue and luma.
+			vec4 maximum;
+			vec4 mean;
+
+			std::array<uint32_t, 256> luma;
+			std::array<uint32_t, 256> red;
+			std::array<uint32_t, 256> green;
+			std::array<uint32_t, 256> blue;
+			uint32_t                  samples;
+
+			/** Smallest value that at least the given fraction of the samples of a histogram lie at or below. */
+			float_t percentile(const std::array<uint32_t, 256>& histogram, float_t fraction) const;
+		};
+
+		private:
+		streamfx::obs::gs::effect                             _effect;
+		std::shared_ptr<streamfx::obs::gs::rendertarget_pool> _pool;
+
+		streamfx::obs::gs::readback _mean_readback;
+		streamfx::obs::gs::readback _minimum_readback;
+		streamfx::obs::gs::readback _maximum_readback;
+
+		result   _pending;
+		uint32_t _pending_parts;
+		result   _result;
+		bool     _have_result;
+
+		std::shared_ptr<streamfx::obs::gs::rendertarget> reduce(std::shared_ptr<streamfx::obs::gs::texture> image,
+																const char* technique, uint64_t limit);
+
+		void read_mean(const uint8_t* data, uint32_t stride, uint32_t width, uint32_t height);
+
+		void read_range(vec4& value, uint32_t part, const uint8_t* data, uint32_t stride, uint32_t width,
+						uint32_t height);
+
+		public:
+		image_statistics();
+		~image_statistics();
+
+		image_statistics(const image_statistics&) = delete;
+		image_statistics& operator=(const image_statistics&) = delete;
+
+		/** Queue a measurement of the image, and pick up the results of an earlier one if they arrived. */
+		void update(std::shared_ptr<streamfx::obs::gs::texture> image);
+
+		/** Latest results, or nullptr if none have arrived yet. */
+		const result* get();
+
+		/** Drop all results, including those that are still on the way. */
+		void reset();
+	};
+} // namespace streamfx::gfx
@@ -16,11 +16,61 @@
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
 
 #include "gfx-source-texture.hpp"
+#include <list>
+#include <mutex>
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
 
+namespace {
+	// Every source is only rendered once per size and frame, no matter how many source_textures reference it.
+	struct render_memo_entry {
+		streamfx::gfx::source_texture*              owner;
+		obs_source_t*                               source;
+		std::size_t                                 width;
+		std::size_t                                 height;
+		std::shared_ptr<streamfx::obs::gs::texture> texture;
+	};
+
+	struct render_memo {
+		std::mutex                   lock; // Only held briefly, as rendering a source may render further sources.
+		uint64_t                     frame = 0;
+		std::list<render_memo_entry> entries;
+
+		std::shared_ptr<streamfx::obs::gs::texture> find(obs_source_t* source, std::size_t width, std::size_t height)
+		{
+			std::lock_guard<std::mutex> lg(lock);
+			if (uint64_t now = obs_get_video_frame_time(); frame != now) {
+				frame = now;
+				entries.clear();
+			}
+			for (auto& entry : entries) {
+				if ((entry.source == source) && (entry.width == width) && (entry.height == height)) {
+					return entry.texture;
+				}
+			}
+			return nullptr;
+		}
+
+		void insert(render_memo_entry entry)
+		{
+			std::lock_guard<std::mutex> lg(lock);
+			entries.push_back(entry);
+		}
+
+		void forget(streamfx::gfx::source_texture* owner)
+		{
+			std::lock_guard<std::mutex> lg(lock);
+			entries.remove_if([owner](const render_memo_entry& entry) { return entry.owner == owner; });
+		}
+	};
+
+	render_memo _render_memo;
+} // namespace
+
 streamfx::gfx::source_texture::~source_texture()
 {
+	_render_memo.forget(this);
+
 	if (_child && _parent) {
 		obs_source_remove_active_child(_parent->get(), _child->get());
 	}
@@ -120,6 +170,15 @@ std::shared_ptr<streamfx::obs::gs::texture> streamfx::gfx::source_texture::rende
 		return nullptr;
 	}
 
+	if (_child) {
+		if (auto tex = _render_memo.find(_child->get(), width, height); tex) {
+			return tex;
+		}
+	}
+
+	// Rendering replaces the content of our render target, so anything remembered from it is no longer valid.
+	_render_memo.forget(this);
+
 	if (_child) {
 #ifdef ENABLE_PROFILING
 		auto cctr = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_capture, "gfx::source_texture '%s'",
@@ -128,12 +187,23 @@ std::shared_ptr<streamfx::obs::gs::texture> streamfx::gfx::source_texture::rende
 		auto op = _rt->render(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
 		vec4 black;
 		vec4_zero(&black);
-		gs_ortho(0, static_cast<float>(width), 0, static_cast<float_t>(height), 0, 1);
+
+		// Map the whole source onto the target, so that a smaller size scales it down instead of cropping it.
+		float_t cx = static_cast<float_t>(obs_source_get_width(_child->get()));
+		float_t cy = static_cast<float_t>(obs_source_get_height(_child->get()));
+		if ((cx <= 0) || (cy <= 0)) {
+			cx = static_cast<float_t>(width);
+			cy = static_cast<float_t>(height);
+		}
+		gs_ortho(0, cx, 0, cy, 0, 1);
 		gs_clear(GS_CLEAR_COLOR, &black, 0, 0);
 		obs_source_video_render(_child->get());
 	}
 
 	std::shared_ptr<streamfx::obs::gs::texture> tex;
 	_rt->get_texture(tex);
+	if (_child) {
+		_render_memo.insert({this, _child->get(), width, height, tex});
+	}
 	return tex;
 }
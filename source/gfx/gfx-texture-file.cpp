@@ -0,0 +1,541 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "gfx-texture-file.hpp"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+#include "configuration.hpp"
+#include "obs/gs/gs-helper.hpp"
+#include "plugin.hpp"
+
+#define ST_PREFIX "<gfx::texture_file> "
+
+#define ST_CFG_COMPRESSION "Texture.Compression"
+
+// Identifies the layout of cached images, and is part of their hash so that a new layout never reads an old file.
+#define ST_CACHE_MAGIC 0x54584653u // 'SFXT'
+#define ST_CACHE_VERSION 1u
+
+// Size the cache of compressed images is trimmed to at startup, dropping the least recently used ones first.
+#define ST_CACHE_LIMIT (256ull << 20)
+
+namespace {
+	// Block compression as specified by S3TC, also known as BC1 and BC3. libobs has no formats for BC4, BC5 or BC7, and
+	// none for ASTC or ETC either. The end points are taken from the bounding box of each block instead of searched
+	// for, which is plenty for masks and shader inputs that are sampled with filtering anyway.
+	typedef uint8_t block_t[16][4];
+
+	uint16_t pack_565(const int32_t rgb[3])
+	{
+		return static_cast<uint16_t>((((rgb[0] * 31 + 127) / 255) << 11) | (((rgb[1] * 63 + 127) / 255) << 5)
+									 | ((rgb[2] * 31 + 127) / 255));
+	}
+
+	void unpack_565(uint16_t v, int32_t rgb[3])
+	{
+		int32_t r = (v >> 11) & 0x1F;
+		int32_t g = (v >> 5) & 0x3F;
+		int32_t b = v & 0x1F;
+		rgb[0]    = (r << 3) | (r >> 2);
+		rgb[1]    = (g << 2) | (g >> 4);
+		rgb[2]    = (b << 3) | (b >> 2);
+	}
+
+	void encode_color(const block_t& block, uint8_t* out)
+	{
+		int32_t lo[3] = {255, 255, 255};
+		int32_t hi[3] = {0, 0, 0};
+		for (std::size_t idx = 0; idx < 16; idx++) {
+			for (std::size_t c = 0; c < 3; c++) {
+				lo[c] = std::min<int32_t>(lo[c], block[idx][c]);
+				hi[c] = std::max<int32_t>(hi[c], block[idx][c]);
+			}
+		}
+
+		// Pulling the box in a little lowers the error of the colors in between, which are the majority.
+		for (std::size_t c = 0; c < 3; c++) {
+			int32_t inset = (hi[c] - lo[c]) / 16;
+			lo[c] += inset;
+			hi[c] -= inset;
+		}
+
+		// The larger end point goes first, which selects the mode with four colors instead of three and transparency.
+		uint16_t c0 = pack_565(hi);
+		uint16_t c1 = pack_565(lo);
+		if (c0 < c1) {
+			std::swap(c0, c1);
+		}
+
+		uint32_t indices = 0;
+		if (c0 != c1) {
+			int32_t palette[4][3];
+			unpack_565(c0, palette[0]);
+			unpack_565(c1, palette[1]);
+			for (std::size_t c = 0; c < 3; c++) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (std::size_t idx = 0; idx < 16; idx++) {
+				uint32_t best       = 0;
+				int32_t  best_error = std::numeric_limits<int32_t>::max();
+				for (uint32_t entry = 0; entry < 4; entry++) {
+					int32_t error = 0;
+					for (std::size_t c = 0; c < 3; c++) {
+						int32_t d = static_cast<int32_t>(block[idx][c]) - palette[entry][c];
+						error += d * d;
+					}
+					if (error < best_error) {
+						best       = entry;
+						best_error = error;
+					}
+				}
+				indices |= best << (idx * 2);
+			}
+		}
+
+		out[0] = static_cast<uint8_t>(c0 & 0xFF);
+		out[1] = static_cast<uint8_t>(c0 >> 8);
+		out[2] = static_cast<uint8_t>(c1 & 0xFF);
+		out[3] = static_cast<uint8_t>(c1 >> 8);
+		for (std::size_t idx = 0; idx < 4; idx++) {
+			out[4 + idx] = static_cast<uint8_t>(indices >> (idx * 8));
+		}
+	}
+
+	void encode_alpha(const block_t& block, uint8_t* out)
+	{
+		int32_t a0 = 0;
+		int32_t a1 = 255;
+		for (std::size_t idx = 0; idx < 16; idx++) {
+			a0 = std::max<int32_t>(a0, block[idx][3]);
+			a1 = std::min<int32_t>(a1, block[idx][3]);
+		}
+
+		// With the larger end point first, the six values in between are interpolated.
+		uint64_t indices = 0;
+		if (a0 != a1) {
+			int32_t palette[8] = {a0, a1};
+			for (int32_t entry = 2; entry < 8; entry++) {
+				palette[entry] = ((8 - entry) * a0 + (entry - 1) * a1) / 7;
+			}
+
+			for (std::size_t idx = 0; idx < 16; idx++) {
+				uint64_t best       = 0;
+				int32_t  best_error = std::numeric_limits<int32_t>::max();
+				for (uint64_t entry = 0; entry < 8; entry++) {
+					int32_t error = std::abs(static_cast<int32_t>(block[idx][3]) - palette[entry]);
+					if (error < best_error) {
+						best       = entry;
+						best_error = error;
+					}
+				}
+				indices |= best << (idx * 3);
+			}
+		}
+
+		out[0] = static_cast<uint8_t>(a0);
+		out[1] = static_cast<uint8_t>(a1);
+		for (std::size_t idx = 0; idx < 6; idx++) {
+			out[2 + idx] = static_cast<uint8_t>(indices >> (idx * 8));
+		}
+	}
+
+	/** Compress an image in place, or leave it alone and return false if its format or size does not allow it. */
+	bool compress_image(streamfx::gfx::texture_file::image& image)
+	{
+		std::size_t order[4] = {0, 1, 2, 3};
+		if ((image.format == GS_BGRA) || (image.format == GS_BGRX)) {
+			order[0] = 2;
+			order[2] = 0;
+		} else if (image.format != GS_RGBA) {
+			return false;
+		}
+
+		// Direct3D 11 requires the full size level to consist of whole blocks, smaller levels are padded.
+		if (image.mips.empty() || (image.width % 4) || (image.height % 4)) {
+			return false;
+		}
+
+		bool opaque = (image.format == GS_BGRX);
+		if (!opaque) {
+			opaque = true;
+			for (std::size_t idx = 3; idx < image.mips.front().size(); idx += 4) {
+				if (image.mips.front()[idx] != 255) {
+					opaque = false;
+					break;
+				}
+			}
+		}
+
+		// Opaque images need no alpha block, which halves their size once more.
+		std::size_t                       block_size = opaque ? 8 : 16;
+		std::vector<std::vector<uint8_t>> mips;
+		for (std::size_t level = 0; level < image.mips.size(); level++) {
+			uint32_t width   = std::max<uint32_t>(image.width >> level, 1);
+			uint32_t height  = std::max<uint32_t>(image.height >> level, 1);
+			uint32_t columns = (width + 3) / 4;
+			uint32_t rows    = (height + 3) / 4;
+			auto&    pixels  = image.mips[level];
+
+			std::vector<uint8_t> blocks(static_cast<std::size_t>(columns) * rows * block_size);
+			uint8_t*             out = blocks.data();
+			for (uint32_t by = 0; by < rows; by++) {
+				for (uint32_t bx = 0; bx < columns; bx++, out += block_size) {
+					block_t block;
+					for (uint32_t idx = 0; idx < 16; idx++) {
+						// Blocks past the edge of a small level repeat its last texel.
+						std::size_t x  = std::min<uint32_t>(bx * 4 + (idx % 4), width - 1);
+						std::size_t y  = std::min<uint32_t>(by * 4 + (idx / 4), height - 1);
+						const auto* px = pixels.data() + (y * width + x) * 4;
+						for (std::size_t c = 0; c < 4; c++) {
+							block[idx][c] = px[order[c]];
+						}
+					}
+
+					if (opaque) {
+						encode_color(block, out);
+					} else {
+						encode_alpha(block, out);
+						encode_color(block, out + 8);
+					}
+				}
+			}
+			mips.push_back(std::move(blocks));
+		}
+
+		image.format = opaque ? GS_DXT1 : GS_DXT5;
+		image.mips   = std::move(mips);
+		return true;
+	}
+
+	/** Whether compression is enabled, and the graphics backend can sample compressed textures at all. */
+	bool is_compression_enabled()
+	{
+		if (auto config = streamfx::configuration::instance(); config) {
+			if (!obs_data_get_bool(config->get().get(), ST_CFG_COMPRESSION)) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+
+		// Asked once by creating the smallest possible texture, as libobs has no way to query supported formats.
+		static std::once_flag probed;
+		static bool           supported = false;
+		std::call_once(probed, []() {
+			uint8_t        block[8] = {};
+			const uint8_t* data     = block;
+			auto           gctx     = streamfx::obs::gs::context();
+			if (gs_texture_t* texture = gs_texture_create(4, 4, GS_DXT1, 1, &data, 0); texture) {
+				gs_texture_destroy(texture);
+				supported = true;
+			} else {
+				DLOG_WARNING(ST_PREFIX "Graphics backend does not support block compressed textures.");
+			}
+		});
+		return supported;
+	}
+
+	void trim_cache(std::filesystem::path path)
+	{
+		std::error_code ec;
+		if (!std::filesystem::is_directory(path, ec)) {
+			return;
+		}
+
+		std::vector<std::tuple<std::filesystem::file_time_type, uintmax_t, std::filesystem::path>> files;
+		for (auto& entry : std::filesystem::directory_iterator(path, ec)) {
+			if (entry.is_regular_file(ec) && (entry.path().extension() == ".bin")) {
+				files.emplace_back(entry.last_write_time(ec), entry.file_size(ec), entry.path());
+			}
+		}
+
+		// Newest first, as a cache hit refreshes the modification time.
+		std::sort(files.begin(), files.end(), [](auto& a, auto& b) { return std::get<0>(a) > std::get<0>(b); });
+
+		uintmax_t total   = 0;
+		size_t    removed = 0;
+		for (auto& file : files) {
+			total += std::get<1>(file);
+			if ((total > ST_CACHE_LIMIT) && std::filesystem::remove(std::get<2>(file), ec)) {
+				removed++;
+			}
+		}
+		if (removed > 0) {
+			DLOG_INFO(ST_PREFIX "Removed %zu least recently used image(s) from the cache.", removed);
+		}
+	}
+} // namespace
+
+void streamfx::gfx::texture_file::initialize()
+{
+	if (auto config = streamfx::configuration::instance(); config) {
+		obs_data_set_default_bool(config->get().get(), ST_CFG_COMPRESSION, false);
+	}
+
+	try {
+		streamfx::threadpool()->push(
+			[path = streamfx::config_file_path("cache/textures")](streamfx::util::threadpool_data_t) {
+				trim_cache(path);
+			},
+			nullptr);
+	} catch (const std::exception& ex) {
+		DLOG_WARNING(ST_PREFIX "Failed to trim the cache: %s", ex.what());
+	}
+}
+
+std::shared_ptr<streamfx::gfx::texture_file>
+	streamfx::gfx::texture_file::load(std::filesystem::path path, std::string variant, converter_t converter,
+									  bool compressible)
+{
+	typedef std::tuple<std::string, int64_t, std::string, bool>           key_t;
+	static std::map<key_t, std::weak_ptr<streamfx::gfx::texture_file>> _files;
+	static std::mutex                                                    _mutex;
+
+	int64_t mtime = static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	for (auto iter = _files.begin(); iter != _files.end();) {
+		if (iter->second.expired()) {
+			iter = _files.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+
+	bool  compress = compressible && is_compression_enabled();
+	key_t key{path.u8string(), mtime, variant, compress};
+	if (auto found = _files.find(key); found != _files.end()) {
+		return found->second.lock();
+	}
+
+	auto reference = std::shared_ptr<streamfx::gfx::texture_file>(
+		new streamfx::gfx::texture_file(path, variant, converter, compress));
+	_files.emplace(key, reference);
+
+	// The task must not keep the file alive, or it would never be released.
+	std::weak_ptr<streamfx::gfx::texture_file> weak = reference;
+	reference->_task                                 = streamfx::threadpool()->push(
+		[weak](streamfx::util::threadpool_data_t) {
+			if (auto self = weak.lock(); self) {
+				self->read();
+			}
+		},
+		nullptr);
+
+	return reference;
+}
+
+streamfx::gfx::texture_file::texture_file(std::filesystem::path path, std::string variant, converter_t converter,
+										  bool compress)
+	: _path(path), _variant(variant), _converter(converter), _compress(compress), _lock(), _ready(false), _image(),
+	  _texture(), _task()
+{}
+
+streamfx::gfx::texture_file::~texture_file()
+{
+	if (_task) {
+		streamfx::threadpool()->pop(_task);
+	}
+	if (_texture) {
+		auto gctx = streamfx::obs::gs::context();
+		_texture.reset();
+	}
+}
+
+bool streamfx::gfx::texture_file::is_ready()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return _ready;
+}
+
+std::shared_ptr<streamfx::obs::gs::texture> streamfx::gfx::texture_file::get_texture()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (!_texture && !_image.mips.empty()) {
+		std::vector<const uint8_t*> mip_data;
+		for (auto& level : _image.mips) {
+			mip_data.push_back(level.data());
+		}
+
+		auto gctx = streamfx::obs::gs::context();
+		_texture  = std::make_shared<streamfx::obs::gs::texture>(
+			_image.width, _image.height, _image.format, static_cast<uint32_t>(mip_data.size()), mip_data.data(),
+			streamfx::obs::gs::texture::flags::None);
+
+		// The texture now holds the only copy that is still needed.
+		decltype(_image.mips)().swap(_image.mips);
+	}
+
+	return _texture;
+}
+
+void streamfx::gfx::texture_file::read()
+{
+	// A compressed copy from an earlier run skips decoding, converting and compressing entirely.
+	std::filesystem::path cache_path;
+	if (_compress) {
+		try {
+			char name[32];
+			snprintf(name, sizeof(name), "%016" PRIx64 ".bin", hash());
+			cache_path = streamfx::config_file_path(std::string("cache/textures/") + name);
+
+			image cached{GS_UNKNOWN, 0, 0, {}};
+			if (read_cache(cache_path, cached)) {
+				// Mark it as recently used, so that trimming the cache keeps it.
+				std::error_code ec;
+				std::filesystem::last_write_time(cache_path, std::filesystem::file_time_type::clock::now(), ec);
+
+				std::lock_guard<std::mutex> lock(_lock);
+				_image = std::move(cached);
+				_ready = true;
+				return;
+			}
+		} catch (const std::exception& ex) {
+			DLOG_WARNING(ST_PREFIX "Failed to look up '%s' in the cache: %s", _path.u8string().c_str(), ex.what());
+			cache_path.clear();
+		}
+	}
+
+	image    result{GS_UNKNOWN, 0, 0, {}};
+	uint8_t* pixels =
+		gs_create_texture_file_data(_path.u8string().c_str(), &result.format, &result.width, &result.height);
+	try {
+		if (!pixels || !result.width || !result.height || (result.format == GS_UNKNOWN)) {
+			throw std::runtime_error("Failed to decode image.");
+		}
+
+		std::size_t size =
+			static_cast<std::size_t>(gs_get_format_bpp(result.format)) * result.width * result.height / 8;
+		result.mips.emplace_back(pixels, pixels + size);
+
+		if (_converter) {
+			_converter(result);
+		}
+
+		if (_compress && compress_image(result) && !cache_path.empty()) {
+			write_cache(cache_path, result);
+		}
+	} catch (const std::exception& ex) {
+		DLOG_ERROR(ST_PREFIX "Failed to load image '%s': %s", _path.u8string().c_str(), ex.what());
+		result.mips.clear();
+	}
+	bfree(pixels);
+
+	std::lock_guard<std::mutex> lock(_lock);
+	_image = std::move(result);
+	_ready = true;
+}
+
+uint64_t streamfx::gfx::texture_file::hash()
+{
+	uint64_t hash = 14695981039346656037ull; // FNV-1a
+	auto     feed = [&hash](const void* ptr, std::size_t size) {
+		for (auto byte = reinterpret_cast<const uint8_t*>(ptr); size > 0; size--, byte++) {
+			hash = (hash ^ *byte) * 1099511628211ull;
+		}
+	};
+
+	uint32_t header[2] = {ST_CACHE_MAGIC, ST_CACHE_VERSION};
+	feed(header, sizeof(header));
+	feed(_variant.data(), _variant.size());
+
+	std::ifstream file(_path, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open file.");
+	}
+	std::vector<char> chunk(65536);
+	while (file) {
+		file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+		feed(chunk.data(), static_cast<std::size_t>(file.gcount()));
+	}
+	return hash;
+}
+
+bool streamfx::gfx::texture_file::read_cache(std::filesystem::path path, image& result)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	uint32_t header[6] = {};
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (!file || (header[0] != ST_CACHE_MAGIC) || (header[1] != ST_CACHE_VERSION) || !header[3] || !header[4]
+		|| !header[5]) {
+		return false;
+	}
+	result.format = static_cast<gs_color_format>(header[2]);
+	result.width  = header[3];
+	result.height = header[4];
+	result.mips.resize(header[5]);
+
+	for (auto& level : result.mips) {
+		uint64_t size = 0;
+		file.read(reinterpret_cast<char*>(&size), sizeof(size));
+		if (!file || (size > (uint64_t(1) << 32))) {
+			return false;
+		}
+		level.resize(static_cast<std::size_t>(size));
+		file.read(reinterpret_cast<char*>(level.data()), static_cast<std::streamsize>(size));
+		if (!file) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void streamfx::gfx::texture_file::write_cache(std::filesystem::path path, const image& result)
+{
+	// Written under a temporary name first, so that nobody ever reads a half written file.
+	try {
+		std::filesystem::create_directories(path.parent_path());
+		std::filesystem::path temporary = path;
+		temporary += ".tmp";
+
+		{
+			uint32_t header[6] = {ST_CACHE_MAGIC, ST_CACHE_VERSION, static_cast<uint32_t>(result.format), result.width,
+								  result.height,  static_cast<uint32_t>(result.mips.size())};
+
+			std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(header), sizeof(header));
+			for (auto& level : result.mips) {
+				uint64_t size = level.size();
+				file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+				file.write(reinterpret_cast<const char*>(level.data()), static_cast<std::streamsize>(size));
+			}
+			if (!file) {
+				throw std::runtime_error("Failed to write file.");
+			}
+		}
+		std::filesystem::rename(temporary, path);
+	} catch (const std::exception& ex) {
+		DLOG_WARNING(ST_PREFIX "Failed to cache '%s': %s", _path.u8string().c_str(), ex.what());
+	}
+}
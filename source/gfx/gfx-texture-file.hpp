@@ -0,0 +1,103 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "obs/gs/gs-texture.hpp"
+#include "util/util-threadpool.hpp"
+
+namespace streamfx::gfx {
+	/** An image file, decoded on the thread pool and uploaded on first use.
+	 *
+	 * Files are shared by path, modification time and variant, so every image is only decoded and uploaded once no
+	 * matter how many sources, filters or shaders use it. The texture lives for as long as anyone still holds the file.
+	 *
+	 * If enabled in the configuration, 8-bit color images are block compressed after conversion, which takes 4 to 8
+	 * times less memory and bandwidth. Compressed images are cached on disk by the hash of the file and variant, so
+	 * that they are only compressed once. The least recently used ones are removed once the cache grows too large.
+	 */
+	class texture_file {
+		public:
+		/** Pixels of an image, with the first mip level being the full size one. */
+		struct image {
+			gs_color_format                   format;
+			uint32_t                          width;
+			uint32_t                          height;
+			std::vector<std::vector<uint8_t>> mips;
+		};
+
+		/** Turns a freshly decoded image into the layout a user needs, on the thread pool. Throws if it can't. */
+		typedef std::function<void(image&)> converter_t;
+
+		private:
+		std::filesystem::path _path;
+		std::string           _variant;
+		converter_t           _converter;
+		bool                  _compress;
+
+		std::mutex                                  _lock;
+		bool                                        _ready;
+		image                                       _image;
+		std::shared_ptr<streamfx::obs::gs::texture> _texture;
+
+		std::shared_ptr<streamfx::util::threadpool::task> _task;
+
+		public:
+		/** Load an image file, or share one that is already loaded.
+		 *
+		 * @param variant Identifies the converter, as users with different converters must not share an image.
+		 * @param compressible Whether the image may be block compressed, which loses some precision.
+		 */
+		static std::shared_ptr<texture_file> load(std::filesystem::path path, std::string variant = {},
+												  converter_t converter = nullptr, bool compressible = true);
+
+		/** Set the configuration defaults, and trim the cache of compressed images on the thread pool.
+		 *
+		 * Must be called once at startup, after the configuration and the thread pool are available.
+		 */
+		static void initialize();
+
+		private:
+		texture_file(std::filesystem::path path, std::string variant, converter_t converter, bool compress);
+
+		public:
+		~texture_file();
+
+		/** Whether decoding has finished, successfully or not. */
+		bool is_ready();
+
+		/** The image, or nullptr if the file is still being decoded or could not be decoded at all. */
+		std::shared_ptr<streamfx::obs::gs::texture> get_texture();
+
+		private:
+		void read();
+
+		uint64_t hash();
+
+		bool read_cache(std::filesystem::path path, image& result);
+
+		void write_cache(std::filesystem::path path, const image& result);
+	};
+} // namespace streamfx::gfx
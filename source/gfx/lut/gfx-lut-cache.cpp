@@ -0,0 +1,74 @@
+// Copyright (c) 2021 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "gfx-lut-cache.hpp"
+
+std::shared_ptr<streamfx::gfx::lut::cache> streamfx::gfx::lut::cache::instance()
+{
+	static std::weak_ptr<streamfx::gfx::lut::cache> _instance;
+	static std::mutex                               _mutex;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	auto reference = _instance.lock();
+	if (!reference) {
+		reference = std::shared_ptr<streamfx::gfx::lut::cache>(new streamfx::gfx::lut::cache());
+		_instance = reference;
+	}
+	return reference;
+}
+
+streamfx::gfx::lut::cache::cache() : _lock(), _entries() {}
+
+streamfx::gfx::lut::cache::~cache() {}
+
+std::shared_ptr<streamfx::obs::gs::rendertarget>
+	streamfx::gfx::lut::cache::find(uint64_t hash, streamfx::gfx::lut::color_depth depth)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	auto found = _entries.find(key_t{hash, depth});
+	if (found == _entries.end()) {
+		return nullptr;
+	}
+
+	auto lut = found->second.lock();
+	if (!lut) {
+		_entries.erase(found);
+	}
+	return lut;
+}
+
+void streamfx::gfx::lut::cache::insert(uint64_t hash, streamfx::gfx::lut::color_depth depth,
+									   std::shared_ptr<streamfx::obs::gs::rendertarget> lut)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	// Forget about everything nobody uses anymore, so that the map does not grow with every edit.
+	for (auto iter = _entries.begin(); iter != _entries.end();) {
+		if (iter->second.expired()) {
+			iter = _entries.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+
+	_entries[key_t{hash, depth}] = lut;
+}
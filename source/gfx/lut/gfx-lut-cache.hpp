@@ -0,0 +1,58 @@
+// Copyright (c) 2021 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "gfx-lut.hpp"
+#include "obs/gs/gs-rendertarget.hpp"
+
+namespace streamfx::gfx::lut {
+	/** Process-wide cache of finished LUTs, addressed by a hash of whatever produced their content.
+	 *
+	 * Entries are only weakly referenced, so a LUT stays alive for exactly as long as one of its users holds on to
+	 * it. Targets handed out by the cache are shared and must not be rendered to again.
+	 */
+	class cache {
+		typedef std::pair<uint64_t, streamfx::gfx::lut::color_depth> key_t;
+
+		std::mutex                                                      _lock;
+		std::map<key_t, std::weak_ptr<streamfx::obs::gs::rendertarget>> _entries;
+
+		public:
+		static std::shared_ptr<cache> instance();
+
+		private:
+		cache();
+
+		public:
+		~cache();
+
+		/** Find a LUT that is still in use somewhere, or nullptr if there is none. */
+		std::shared_ptr<streamfx::obs::gs::rendertarget> find(uint64_t hash, streamfx::gfx::lut::color_depth depth);
+
+		/** Share a freshly rendered LUT with everyone that asks for the same hash and depth. */
+		void insert(uint64_t hash, streamfx::gfx::lut::color_depth depth,
+					std::shared_ptr<streamfx::obs::gs::rendertarget> lut);
+	};
+} // namespace streamfx::gfx::lut
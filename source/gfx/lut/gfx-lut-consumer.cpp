@@ -65,7 +65,8 @@ std::shared_ptr<streamfx::obs::gs::effect>
 
 void streamfx::gfx::lut::consumer::consume(streamfx::gfx::lut::color_depth             depth,
 										   std::shared_ptr<streamfx::obs::gs::texture> lut,
-										   std::shared_ptr<streamfx::obs::gs::texture> texture)
+										   std::shared_ptr<streamfx::obs::gs::texture> texture,
+										   streamfx::gfx::lut::interpolation           interpolation)
 {
 	auto gctx = streamfx::obs::gs::context();
 
@@ -76,7 +77,17 @@ void streamfx::gfx::lut::consumer::consume(streamfx::gfx::lut::color_depth
 	}
 
 	// Draw a simple quad.
-	while (gs_effect_loop(effect->get_object(), "Draw")) {
+	while (gs_effect_loop(effect->get_object(), technique(interpolation))) {
 		gs_draw_sprite(nullptr, 0, 1, 1);
 	}
 }
+
+const char* streamfx::gfx::lut::consumer::technique(streamfx::gfx::lut::interpolation interpolation)
+{
+	switch (interpolation) {
+	case streamfx::gfx::lut::interpolation::Tetrahedral:
+		return "DrawTetrahedral";
+	default:
+		return "Draw";
+	}
+}
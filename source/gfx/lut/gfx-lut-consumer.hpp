@@ -37,6 +37,10 @@ namespace streamfx::gfx::lut {
 														   std::shared_ptr<streamfx::obs::gs::texture> lut);
 
 		void consume(streamfx::gfx::lut::color_depth depth, std::shared_ptr<streamfx::obs::gs::texture> lut,
-					 std::shared_ptr<streamfx::obs::gs::texture> texture);
+					 std::shared_ptr<streamfx::obs::gs::texture> texture,
+					 streamfx::gfx::lut::interpolation interpolation = streamfx::gfx::lut::interpolation::Trilinear);
+
+		/** Name of the technique in the prepared effect that applies the LUT with the given interpolation. */
+		static const char* technique(streamfx::gfx::lut::interpolation interpolation);
 	};
 } // namespace streamfx::gfx::lut
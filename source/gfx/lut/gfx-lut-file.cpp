@@ -0,0 +1,367 @@
+// Copyright (c) 2021 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "gfx-lut-file.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+#include "obs/gs/gs-helper.hpp"
+#include "plugin.hpp"
+
+#define ST_PREFIX "<gfx::lut::file> "
+
+// Anything larger than this is almost certainly not a LUT, and would take forever to resample.
+#define ST_MAX_SIZE 256
+
+namespace {
+	struct cube_t {
+		uint32_t             size          = 0;
+		float_t              domain_min[3] = {0., 0., 0.};
+		float_t              domain_max[3] = {1., 1., 1.};
+		std::vector<float_t> values; // RGB triplets, red changes fastest and blue slowest.
+	};
+
+	void read_cube(std::istream& stream, cube_t& cube)
+	{
+		std::string line;
+		while (std::getline(stream, line)) {
+			std::istringstream words(line);
+			std::string        word;
+			if (!(words >> word) || (word[0] == '#')) {
+				continue;
+			}
+
+			if (std::isalpha(static_cast<uint8_t>(word[0]))) {
+				if (word == "LUT_3D_SIZE") {
+					words >> cube.size;
+				} else if (word == "LUT_1D_SIZE") {
+					throw std::runtime_error("1D LUTs are not supported.");
+				} else if (word == "DOMAIN_MIN") {
+					words >> cube.domain_min[0] >> cube.domain_min[1] >> cube.domain_min[2];
+				} else if (word == "DOMAIN_MAX") {
+					words >> cube.domain_max[0] >> cube.domain_max[1] >> cube.domain_max[2];
+				} else if (word == "LUT_3D_INPUT_RANGE") {
+					words >> cube.domain_min[0] >> cube.domain_max[0];
+					cube.domain_min[1] = cube.domain_min[2] = cube.domain_min[0];
+					cube.domain_max[1] = cube.domain_max[2] = cube.domain_max[0];
+				} // Everything else, like TITLE, does not affect the content.
+				continue;
+			}
+
+			std::istringstream values(line);
+			float_t            rgb[3];
+			if (!(values >> rgb[0] >> rgb[1] >> rgb[2])) {
+				throw std::runtime_error("Malformed data line.");
+			}
+			cube.values.insert(cube.values.end(), rgb, rgb + 3);
+		}
+	}
+
+	void read_3dl(std::istream& stream, cube_t& cube)
+	{
+		std::vector<int64_t> mesh;
+		std::vector<int64_t> raw;
+		int64_t              output_max = 0;
+
+		std::string line;
+		while (std::getline(stream, line)) {
+			std::istringstream words(line);
+			std::string        word;
+			if (!(words >> word) || (word[0] == '#')) {
+				continue;
+			}
+
+			if (std::isalpha(static_cast<uint8_t>(word[0]))) {
+				if (word == "Mesh") { // Lustre: "Mesh <input bits> <output bits>"
+					int64_t input_bits = 0, output_bits = 0;
+					if (words >> input_bits >> output_bits) {
+						output_max = (int64_t(1) << output_bits) - 1;
+					}
+				}
+				continue;
+			}
+
+			std::istringstream   values(line);
+			std::vector<int64_t> numbers;
+			for (int64_t number; values >> number;) {
+				numbers.push_back(number);
+			}
+
+			// The first line lists where the input is sampled, everything after it is output.
+			if ((numbers.size() > 3) && mesh.empty() && raw.empty()) {
+				mesh = std::move(numbers);
+			} else if (numbers.size() == 3) {
+				raw.insert(raw.end(), numbers.begin(), numbers.end());
+			} else {
+				throw std::runtime_error("Malformed data line.");
+			}
+		}
+
+		if (mesh.size() > 1) {
+			cube.size = static_cast<uint32_t>(mesh.size());
+
+			// The input range is the next power of two above the last sample, minus one.
+			int64_t input_max = 1;
+			while (input_max < mesh.back()) {
+				input_max = (input_max << 1) | 1;
+			}
+			for (std::size_t idx = 0; idx < 3; idx++) {
+				cube.domain_min[idx] = static_cast<float_t>(mesh.front()) / static_cast<float_t>(input_max);
+				cube.domain_max[idx] = static_cast<float_t>(mesh.back()) / static_cast<float_t>(input_max);
+			}
+		} else {
+			cube.size = static_cast<uint32_t>(std::round(std::cbrt(static_cast<double_t>(raw.size() / 3))));
+		}
+
+		// Without an explicit output depth, it is the smallest one that fits every value.
+		if (output_max == 0) {
+			output_max = 1;
+			while (output_max < *std::max_element(raw.begin(), raw.end())) {
+				output_max = (output_max << 1) | 1;
+			}
+		}
+
+		// Blue changes fastest in .3dl files, while the rest of the code expects red to change fastest.
+		std::size_t size = cube.size;
+		if (raw.size() != (size * size * size * 3)) {
+			throw std::runtime_error("Number of entries does not match the size of the LUT.");
+		}
+		cube.values.resize(raw.size());
+		for (std::size_t r = 0; r < size; r++) {
+			for (std::size_t g = 0; g < size; g++) {
+				for (std::size_t b = 0; b < size; b++) {
+					std::size_t from = ((r * size + g) * size + b) * 3;
+					std::size_t to   = ((b * size + g) * size + r) * 3;
+					for (std::size_t c = 0; c < 3; c++) {
+						cube.values[to + c] = static_cast<float_t>(raw[from + c]) / static_cast<float_t>(output_max);
+					}
+				}
+			}
+		}
+	}
+
+	inline float_t lerp(float_t a, float_t b, float_t t)
+	{
+		return a + (b - a) * t;
+	}
+
+	void sample_cube(const cube_t& cube, const float_t color[3], float_t result[3])
+	{
+		std::size_t size = cube.size;
+		std::size_t lo[3], hi[3];
+		float_t     fr[3];
+		for (std::size_t c = 0; c < 3; c++) {
+			float_t v = (color[c] - cube.domain_min[c]) / (cube.domain_max[c] - cube.domain_min[c]);
+			v         = std::clamp<float_t>(v, 0., 1.) * static_cast<float_t>(size - 1);
+			lo[c]     = static_cast<std::size_t>(std::floor(v));
+			hi[c]     = std::min(lo[c] + 1, size - 1);
+			fr[c]     = v - static_cast<float_t>(lo[c]);
+		}
+
+		auto at = [&cube, size](std::size_t r, std::size_t g, std::size_t b) {
+			return cube.values.data() + ((b * size + g) * size + r) * 3;
+		};
+		for (std::size_t c = 0; c < 3; c++) {
+			float_t c00 = lerp(at(lo[0], lo[1], lo[2])[c], at(hi[0], lo[1], lo[2])[c], fr[0]);
+			float_t c10 = lerp(at(lo[0], hi[1], lo[2])[c], at(hi[0], hi[1], lo[2])[c], fr[0]);
+			float_t c01 = lerp(at(lo[0], lo[1], hi[2])[c], at(hi[0], lo[1], hi[2])[c], fr[0]);
+			float_t c11 = lerp(at(lo[0], hi[1], hi[2])[c], at(hi[0], hi[1], hi[2])[c], fr[0]);
+			result[c]   = lerp(lerp(c00, c10, fr[1]), lerp(c01, c11, fr[1]), fr[2]);
+		}
+	}
+} // namespace
+
+std::shared_ptr<streamfx::gfx::lut::file> streamfx::gfx::lut::file::load(std::filesystem::path           path,
+																		   streamfx::gfx::lut::color_depth depth)
+{
+	typedef std::tuple<std::string, int64_t, streamfx::gfx::lut::color_depth> key_t;
+	static std::map<key_t, std::weak_ptr<streamfx::gfx::lut::file>>            _files;
+	static std::mutex                                                          _mutex;
+
+	// The resampled LUT is (2^depth)^1.5 texels wide, which at 10 bits is 32768 and needs 8 GiB before the texture
+	// creation would fail anyway.
+	if (static_cast<int32_t>(depth) > static_cast<int32_t>(streamfx::gfx::lut::color_depth::_8)) {
+		throw std::invalid_argument("LUTs from files are limited to a depth of 8 bits.");
+	}
+
+	int64_t mtime = static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	for (auto iter = _files.begin(); iter != _files.end();) {
+		if (iter->second.expired()) {
+			iter = _files.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+
+	key_t key{path.u8string(), mtime, depth};
+	if (auto found = _files.find(key); found != _files.end()) {
+		return found->second.lock();
+	}
+
+	auto reference = std::shared_ptr<streamfx::gfx::lut::file>(new streamfx::gfx::lut::file(path, mtime, depth));
+	_files.emplace(key, reference);
+
+	// The task must not keep the file alive, or it would never be released.
+	std::weak_ptr<streamfx::gfx::lut::file> weak = reference;
+	reference->_task                             = streamfx::threadpool()->push(
+		[weak](streamfx::util::threadpool_data_t) {
+			if (auto self = weak.lock(); self) {
+				self->read();
+			}
+		},
+		nullptr);
+
+	return reference;
+}
+
+streamfx::gfx::lut::file::file(std::filesystem::path path, int64_t mtime, streamfx::gfx::lut::color_depth depth)
+	: _path(path), _mtime(mtime), _depth(depth), _lock(), _ready(false), _format(GS_RGBA), _size(0), _data(),
+	  _texture(), _task()
+{}
+
+streamfx::gfx::lut::file::~file()
+{
+	if (_task) {
+		streamfx::threadpool()->pop(_task);
+	}
+	if (_texture) {
+		auto gctx = streamfx::obs::gs::context();
+		_texture.reset();
+	}
+}
+
+uint64_t streamfx::gfx::lut::file::hash()
+{
+	uint64_t hash = 14695981039346656037ull; // FNV-1a
+	auto     feed = [&hash](const void* ptr, std::size_t size) {
+		for (auto byte = reinterpret_cast<const uint8_t*>(ptr); size > 0; size--, byte++) {
+			hash = (hash ^ *byte) * 1099511628211ull;
+		}
+	};
+
+	std::string path  = _path.u8string();
+	int32_t     depth = static_cast<int32_t>(_depth);
+	feed(path.data(), path.size());
+	feed(&_mtime, sizeof(_mtime));
+	feed(&depth, sizeof(depth));
+	return hash;
+}
+
+bool streamfx::gfx::lut::file::is_ready()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return _ready;
+}
+
+std::shared_ptr<streamfx::obs::gs::texture> streamfx::gfx::lut::file::get_texture()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (!_texture && !_data.empty()) {
+		auto           gctx = streamfx::obs::gs::context();
+		const uint8_t* mip  = _data.data();
+		_texture = std::make_shared<streamfx::obs::gs::texture>(_size, _size, _format, 1, &mip,
+															   streamfx::obs::gs::texture::flags::None);
+
+		// The texture now holds the only copy that is still needed.
+		std::vector<uint8_t>().swap(_data);
+	}
+
+	return _texture;
+}
+
+void streamfx::gfx::lut::file::read()
+{
+	try {
+		std::ifstream stream(_path);
+		if (!stream.is_open() || stream.bad()) {
+			throw std::runtime_error("Unable to open file.");
+		}
+
+		cube_t      cube;
+		std::string extension = _path.extension().u8string();
+		std::transform(extension.begin(), extension.end(), extension.begin(),
+					   [](char v) { return static_cast<char>(std::tolower(static_cast<uint8_t>(v))); });
+		if (extension == ".3dl") {
+			read_3dl(stream, cube);
+		} else {
+			read_cube(stream, cube);
+		}
+
+		if ((cube.size < 2) || (cube.size > ST_MAX_SIZE)) {
+			throw std::runtime_error("Size of the LUT is invalid or unsupported.");
+		}
+		if (cube.values.size() != (std::size_t(cube.size) * cube.size * cube.size * 3)) {
+			throw std::runtime_error("Number of entries does not match the size of the LUT.");
+		}
+
+		// Resample into the layout that gfx::lut::producer generates, see lut.effect.
+		uint32_t idepth     = static_cast<uint32_t>(_depth);
+		uint32_t size       = 1u << idepth;
+		uint32_t grid_size  = 1u << (idepth / 2);
+		uint32_t tex_size   = size * grid_size;
+		bool     high_depth = idepth > 8;
+
+		std::size_t          bpp = high_depth ? 8 : 4;
+		std::vector<uint8_t> data(std::size_t(tex_size) * tex_size * bpp);
+		for (uint32_t y = 0; y < tex_size; y++) {
+			for (uint32_t x = 0; x < tex_size; x++) {
+				float_t color[3] = {
+					static_cast<float_t>(x % size) / static_cast<float_t>(size - 1),
+					static_cast<float_t>(y % size) / static_cast<float_t>(size - 1),
+					static_cast<float_t>((y / size) * grid_size + (x / size)) / static_cast<float_t>(size - 1),
+				};
+				float_t result[3];
+				sample_cube(cube, color, result);
+
+				uint8_t* ptr = data.data() + (std::size_t(y) * tex_size + x) * bpp;
+				for (std::size_t c = 0; c < 4; c++) {
+					float_t v = (c < 3) ? std::clamp<float_t>(result[c], 0., 1.) : 1.f;
+					if (high_depth) {
+						reinterpret_cast<uint16_t*>(ptr)[c] = static_cast<uint16_t>(std::round(v * 65535.f));
+					} else {
+						ptr[c] = static_cast<uint8_t>(std::round(v * 255.f));
+					}
+				}
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(_lock);
+		_format = high_depth ? GS_RGBA16 : GS_RGBA;
+		_size   = tex_size;
+		_data   = std::move(data);
+		_ready  = true;
+	} catch (const std::exception& ex) {
+		DLOG_ERROR(ST_PREFIX "Failed to read LUT '%s': %s", _path.u8string().c_str(), ex.what());
+
+		std::lock_guard<std::mutex> lock(_lock);
+		_ready = true;
+	}
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2021 Michael Fabian Dirks <info@xaymar.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "gfx-lut.hpp"
+#include "obs/gs/gs-texture.hpp"
+#include "util/util-threadpool.hpp"
+
+namespace streamfx::gfx::lut {
+	/** A LUT read from a .cube or .3dl file, resampled into the layout of lut-consumer.effect.
+	 *
+	 * Files are read on the thread pool and uploaded on first use. They are shared by path, modification time and
+	 * color depth, so every file is only read and uploaded once no matter how many filters use it.
+	 */
+	class file {
+		std::filesystem::path           _path;
+		int64_t                         _mtime;
+		streamfx::gfx::lut::color_depth _depth;
+
+		std::mutex                                  _lock;
+		bool                                        _ready;
+		gs_color_format                             _format;
+		uint32_t                                    _size;
+		std::vector<uint8_t>                        _data;
+		std::shared_ptr<streamfx::obs::gs::texture> _texture;
+
+		std::shared_ptr<streamfx::util::threadpool::task> _task;
+
+		public:
+		static std::shared_ptr<file> load(std::filesystem::path path, streamfx::gfx::lut::color_depth depth);
+
+		private:
+		file(std::filesystem::path path, int64_t mtime, streamfx::gfx::lut::color_depth depth);
+
+		public:
+		~file();
+
+		/** Identifies the content, for anything that caches results derived from it. */
+		uint64_t hash();
+
+		/** Whether reading has finished, successfully or not. */
+		bool is_ready();
+
+		/** The LUT, or nullptr if the file is still being read or could not be read at all. */
+		std::shared_ptr<streamfx::obs::gs::texture> get_texture();
+
+		private:
+		void read();
+	};
+} // namespace streamfx::gfx::lut
@@ -59,4 +59,9 @@ namespace streamfx::gfx::lut {
 		_14     = 14,
 		_16     = 16,
 	};
+
+	enum class interpolation {
+		Trilinear   = 0, // Two filtered fetches, needs a larger LUT for the same accuracy.
+		Tetrahedral = 1, // Four exact fetches, accurate even at low depths.
+	};
 } // namespace streamfx::gfx::lut
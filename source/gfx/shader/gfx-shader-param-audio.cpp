@@ -0,0 +1,313 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2021 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#include "gfx-shader-param-audio.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include "obs/obs-source-tracker.hpp"
+#include "plugin.hpp"
+
+// Window of 1024 samples, analyzed every 512 samples, which at 48kHz is about every 10ms.
+#define ST_FFT_SIZE 1024
+#define ST_FFT_HOP 512
+
+// Band energies are mapped from -60dB..0dB to 0..1.
+#define ST_DB_RANGE 60.0f
+
+#define ST_ANNO_BANDS "bands"
+
+static std::mutex                                                                  spectrums_lock;
+static std::map<std::string, std::weak_ptr<streamfx::gfx::shader::audio_spectrum>> spectrums;
+
+streamfx::gfx::shader::audio_spectrum::audio_spectrum(std::string name)
+	: _name(name), _source(), _handler(), _attach_time(), _input_lock(), _input(ST_FFT_SIZE, 0.f), _input_pos(0),
+	  _input_fresh(0), _busy(false), _pending(ST_FFT_SIZE, 0.f), _window(ST_FFT_SIZE), _reverse(ST_FFT_SIZE),
+	  _twiddle_re(), _twiddle_im(), _re(ST_FFT_SIZE), _im(ST_FFT_SIZE), _output_lock(), _magnitudes(size(), 0.f),
+	  _generation(0)
+{
+	constexpr double_t pi = 3.14159265358979323846;
+
+	// Hann window, to reduce the leakage from the window edges.
+	for (std::size_t idx = 0; idx < ST_FFT_SIZE; idx++) {
+		_window[idx] = static_cast<float_t>(0.5 - 0.5 * cos((2.0 * pi * idx) / (ST_FFT_SIZE - 1)));
+	}
+
+	// Bit-reversed order of the input.
+	std::size_t bits = 0;
+	while ((std::size_t{1} << bits) < ST_FFT_SIZE) {
+		bits++;
+	}
+	for (std::size_t idx = 0; idx < ST_FFT_SIZE; idx++) {
+		uint32_t rev = 0;
+		for (std::size_t bit = 0; bit < bits; bit++) {
+			rev |= ((idx >> bit) & 1) << (bits - 1 - bit);
+		}
+		_reverse[idx] = rev;
+	}
+
+	// Twiddle factors of all stages one after another, so that each stage reads them linearly.
+	_twiddle_re.reserve(ST_FFT_SIZE);
+	_twiddle_im.reserve(ST_FFT_SIZE);
+	for (std::size_t half = 1; half < ST_FFT_SIZE; half <<= 1) {
+		for (std::size_t idx = 0; idx < half; idx++) {
+			double_t angle = -pi * static_cast<double_t>(idx) / static_cast<double_t>(half);
+			_twiddle_re.push_back(static_cast<float_t>(cos(angle)));
+			_twiddle_im.push_back(static_cast<float_t>(sin(angle)));
+		}
+	}
+
+	attach();
+}
+
+streamfx::gfx::shader::audio_spectrum::~audio_spectrum()
+{
+	// Stop receiving audio before anything it needs goes away.
+	_handler.reset();
+	_source.reset();
+}
+
+uint64_t streamfx::gfx::shader::audio_spectrum::get(std::vector<float_t>& magnitudes, uint64_t generation)
+{
+	// Sources may not exist yet while a scene collection is still loading, so keep looking for it.
+	if (!_source && ((std::chrono::steady_clock::now() - _attach_time) > std::chrono::seconds(1))) {
+		attach();
+	}
+
+	std::unique_lock<std::mutex> lock(_output_lock);
+	if (_generation != generation) {
+		magnitudes.assign(_magnitudes.begin(), _magnitudes.end());
+	}
+	return _generation;
+}
+
+std::size_t streamfx::gfx::shader::audio_spectrum::size()
+{
+	return ST_FFT_SIZE / 2;
+}
+
+std::shared_ptr<streamfx::gfx::shader::audio_spectrum>
+	streamfx::gfx::shader::audio_spectrum::instance(const std::string& name)
+{
+	std::unique_lock<std::mutex> lock(spectrums_lock);
+	if (auto found = spectrums.find(name); found != spectrums.end()) {
+		if (auto spectrum = found->second.lock(); spectrum) {
+			return spectrum;
+		}
+	}
+
+	auto spectrum = std::make_shared<streamfx::gfx::shader::audio_spectrum>(name);
+	spectrums.insert_or_assign(name, spectrum);
+	return spectrum;
+}
+
+void streamfx::gfx::shader::audio_spectrum::attach()
+{
+	_attach_time = std::chrono::steady_clock::now();
+
+	obs_source_t* source = obs_get_source_by_name(_name.c_str());
+	if (!source) {
+		return;
+	}
+
+	_source  = std::shared_ptr<obs_source_t>(source, [](obs_source_t* v) { obs_source_release(v); });
+	_handler = std::make_shared<streamfx::obs::audio_signal_handler>(_source);
+	_handler->event.add(std::bind(&audio_spectrum::on_audio, this, std::placeholders::_1, std::placeholders::_2,
+								  std::placeholders::_3));
+}
+
+void streamfx::gfx::shader::audio_spectrum::on_audio(std::shared_ptr<obs_source_t>, const struct audio_data* audio,
+													 bool muted)
+{
+	std::size_t channels = std::clamp<std::size_t>(audio_output_get_channels(obs_get_audio()), 1, MAX_AV_PLANES);
+	float_t     scale    = 1.0f / static_cast<float_t>(channels);
+
+	std::unique_lock<std::mutex> lock(_input_lock);
+
+	// Mix down to mono.
+	for (uint32_t idx = 0; idx < audio->frames; idx++) {
+		float_t value = 0.f;
+		if (!muted) {
+			for (std::size_t channel = 0; channel < channels; channel++) {
+				if (audio->data[channel]) {
+					value += reinterpret_cast<const float_t*>(audio->data[channel])[idx];
+				}
+			}
+		}
+		_input[_input_pos] = value * scale;
+		_input_pos         = (_input_pos + 1) & (ST_FFT_SIZE - 1);
+	}
+	_input_fresh += audio->frames;
+
+	// Only one analysis is in flight at a time, the next one picks up whatever arrived in the meantime.
+	if (_busy || (_input_fresh < ST_FFT_HOP)) {
+		return;
+	}
+	_busy        = true;
+	_input_fresh = 0;
+	for (std::size_t idx = 0; idx < ST_FFT_SIZE; idx++) {
+		_pending[idx] = _input[(_input_pos + idx) & (ST_FFT_SIZE - 1)];
+	}
+
+	std::weak_ptr<audio_spectrum> weak = weak_from_this();
+	streamfx::threadpool()->push(
+		[weak](streamfx::util::threadpool_data_t) {
+			if (auto self = weak.lock(); self) {
+				self->analyze();
+			}
+		},
+		nullptr, streamfx::util::threadpool::priority::High);
+}
+
+void streamfx::gfx::shader::audio_spectrum::analyze()
+{
+	// Apply the window while moving the samples into bit-reversed order.
+	for (std::size_t idx = 0; idx < ST_FFT_SIZE; idx++) {
+		_re[_reverse[idx]] = _pending[idx] * _window[idx];
+		_im[idx]           = 0.f;
+	}
+
+	// Iterative radix-2 FFT on separate real and imaginary arrays. The innermost loop has no dependencies between
+	// iterations and only reads and writes linearly, so that the compiler can turn it into vector instructions.
+	const float_t* twiddle_re = _twiddle_re.data();
+	const float_t* twiddle_im = _twiddle_im.data();
+	for (std::size_t half = 1; half < ST_FFT_SIZE; half <<= 1) {
+		for (std::size_t base = 0; base < ST_FFT_SIZE; base += (half << 1)) {
+			float_t* a_re = _re.data() + base;
+			float_t* a_im = _im.data() + base;
+			float_t* b_re = a_re + half;
+			float_t* b_im = a_im + half;
+			for (std::size_t idx = 0; idx < half; idx++) {
+				float_t t_re = b_re[idx] * twiddle_re[idx] - b_im[idx] * twiddle_im[idx];
+				float_t t_im = b_re[idx] * twiddle_im[idx] + b_im[idx] * twiddle_re[idx];
+				b_re[idx]    = a_re[idx] - t_re;
+				b_im[idx]    = a_im[idx] - t_im;
+				a_re[idx] += t_re;
+				a_im[idx] += t_im;
+			}
+		}
+		twiddle_re += half;
+		twiddle_im += half;
+	}
+
+	{
+		// Scale so that a full scale sine ends up at 1.0, which needs an extra 2 for the Hann window.
+		constexpr float_t            scale = 4.0f / static_cast<float_t>(ST_FFT_SIZE);
+		std::unique_lock<std::mutex> lock(_output_lock);
+		for (std::size_t idx = 0; idx < size(); idx++) {
+			_magnitudes[idx] = std::sqrt(_re[idx] * _re[idx] + _im[idx] * _im[idx]) * scale;
+		}
+		_generation++;
+	}
+
+	std::unique_lock<std::mutex> lock(_input_lock);
+	_busy = false;
+}
+
+streamfx::gfx::shader::audio_parameter::audio_parameter(streamfx::obs::gs::effect_parameter param, std::string prefix)
+	: parameter(param, prefix), _bands(32), _band_edges(), _source_name(), _spectrum(), _generation(0), _magnitudes(),
+	  _data(), _texture()
+{
+	if (auto anno = get_parameter().get_annotation(ST_ANNO_BANDS); anno) {
+		_bands = static_cast<std::size_t>(std::max(anno.get_default_int(), 1));
+	}
+	_bands = std::clamp<std::size_t>(_bands, 1, audio_spectrum::size() / 2);
+	_data.resize(_bands, 0.f);
+
+	// Bands are spread logarithmically from the first bin above 0 Hz, similar to how they are heard.
+	_band_edges.resize(_bands + 1);
+	for (std::size_t idx = 0; idx <= _bands; idx++) {
+		double_t edge    = std::pow(static_cast<double_t>(audio_spectrum::size()), static_cast<double_t>(idx) / _bands);
+		_band_edges[idx] = std::clamp<std::size_t>(static_cast<std::size_t>(edge), 1, audio_spectrum::size() - 1);
+	}
+}
+
+streamfx::gfx::shader::audio_parameter::~audio_parameter() {}
+
+void streamfx::gfx::shader::audio_parameter::defaults(obs_data_t* settings)
+{
+	obs_data_set_default_string(settings, get_key().data(), "");
+}
+
+void streamfx::gfx::shader::audio_parameter::properties(obs_properties_t* props, obs_data_t* settings)
+{
+	if (!is_visible())
+		return;
+
+	auto p = obs_properties_add_list(props, get_key().data(), get_name().data(), OBS_COMBO_TYPE_LIST,
+									 OBS_COMBO_FORMAT_STRING);
+	if (has_description())
+		obs_property_set_long_description(p, get_description().data());
+	obs_property_list_add_string(p, "", "");
+	obs::source_tracker::get()->enumerate(
+		[&p](std::string name, obs_source_t*) {
+			obs_property_list_add_string(p, name.c_str(), name.c_str());
+			return false;
+		},
+		obs::source_tracker::filter_audio_sources);
+}
+
+void streamfx::gfx::shader::audio_parameter::update(obs_data_t* settings)
+{
+	if (std::string name = obs_data_get_string(settings, get_key().data()); name != _source_name) {
+		_source_name = name;
+		_spectrum    = name.empty() ? nullptr : audio_spectrum::instance(name);
+		_generation  = 0;
+		_data.assign(_bands, 0.f);
+		invalidate();
+	}
+}
+
+void streamfx::gfx::shader::audio_parameter::assign()
+{
+	if (!_texture) {
+		_texture = std::make_shared<streamfx::obs::gs::texture>(static_cast<uint32_t>(_bands), 1, GS_R32F, 1, nullptr,
+																streamfx::obs::gs::texture::flags::Dynamic);
+		invalidate();
+	}
+
+	bool changed = is_dirty();
+	if (_spectrum) {
+		if (uint64_t generation = _spectrum->get(_magnitudes, _generation); generation != _generation) {
+			_generation = generation;
+			for (std::size_t idx = 0; idx < _bands; idx++) {
+				std::size_t lo = _band_edges[idx];
+				std::size_t hi = std::max(_band_edges[idx + 1], lo + 1);
+
+				// The loudest bin decides, so that narrow peaks don't vanish in wide bands.
+				float_t energy = 0.f;
+				for (std::size_t bin = lo; bin < hi; bin++) {
+					energy = std::max(energy, _magnitudes[bin]);
+				}
+
+				float_t db = 20.0f * std::log10(std::max(energy, 1e-9f));
+				_data[idx] = std::clamp((db + ST_DB_RANGE) / ST_DB_RANGE, 0.f, 1.f);
+			}
+			changed = true;
+		}
+	}
+
+	if (changed) {
+		gs_texture_set_image(_texture->get_object(), reinterpret_cast<const uint8_t*>(_data.data()),
+							 static_cast<uint32_t>(_bands * sizeof(float_t)), false);
+	}
+
+	if (is_dirty()) {
+		get_parameter().set_texture(_texture->get_object());
+		clear_dirty();
+	}
+}
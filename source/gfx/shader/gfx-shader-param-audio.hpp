@@ -0,0 +1,120 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2021 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#pragma once
+#include "common.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "gfx-shader-param.hpp"
+#include "obs/gs/gs-effect-parameter.hpp"
+#include "obs/gs/gs-texture.hpp"
+#include "obs/obs-signal-handler.hpp"
+
+namespace streamfx::gfx {
+	namespace shader {
+		/** Frequency spectrum of the audio of a source, shared by everyone that listens to the same source.
+		 *
+		 * Audio is mixed down to mono as it arrives, and every half window a windowed FFT is run on the thread pool.
+		 * The magnitudes of the latest analysis can then be copied out of it from any thread.
+		 */
+		class audio_spectrum : public std::enable_shared_from_this<audio_spectrum> {
+			std::string                                          _name;
+			std::shared_ptr<obs_source_t>                        _source;
+			std::shared_ptr<streamfx::obs::audio_signal_handler> _handler;
+			std::chrono::steady_clock::time_point                _attach_time;
+
+			// Input, written by the audio thread.
+			std::mutex           _input_lock;
+			std::vector<float_t> _input; // Ring of the last window worth of samples.
+			std::size_t          _input_pos;
+			std::size_t          _input_fresh; // Samples since the last analysis started.
+			bool                 _busy;        // An analysis is queued or running.
+			std::vector<float_t> _pending;     // Samples of the analysis, in order.
+
+			// FFT, only used by the one analysis in flight.
+			std::vector<float_t>  _window;
+			std::vector<uint32_t> _reverse;
+			std::vector<float_t>  _twiddle_re;
+			std::vector<float_t>  _twiddle_im;
+			std::vector<float_t>  _re;
+			std::vector<float_t>  _im;
+
+			// Output
+			std::mutex           _output_lock;
+			std::vector<float_t> _magnitudes;
+			uint64_t             _generation;
+
+			public:
+			audio_spectrum(std::string name);
+			~audio_spectrum();
+
+			/** Copy the latest magnitudes, if there are any newer than the given generation.
+			 * @return The generation of the magnitudes, which is 0 until the first analysis finished.
+			 */
+			uint64_t get(std::vector<float_t>& magnitudes, uint64_t generation);
+
+			/** Number of magnitudes per analysis, covering 0 Hz up to half of the sample rate. */
+			static std::size_t size();
+
+			/** Get the spectrum of the named source, which is created on first use. */
+			static std::shared_ptr<audio_spectrum> instance(const std::string& name);
+
+			private:
+			void attach();
+
+			void on_audio(std::shared_ptr<obs_source_t>, const struct audio_data* audio, bool muted);
+
+			void analyze();
+		};
+
+		/** Levels of a sources audio in logarithmically spaced frequency bands, as a single row float texture with one
+		 * texel per band from low to high frequencies. The number of bands is set with the 'bands' annotation.
+		 */
+		struct audio_parameter : public parameter {
+			std::size_t                     _bands;
+			std::vector<std::size_t>        _band_edges;
+			std::string                     _source_name;
+			std::shared_ptr<audio_spectrum> _spectrum;
+
+			// Cache
+			uint64_t                                    _generation;
+			std::vector<float_t>                        _magnitudes;
+			std::vector<float_t>                        _data;
+			std::shared_ptr<streamfx::obs::gs::texture> _texture;
+
+			public:
+			audio_parameter(streamfx::obs::gs::effect_parameter param, std::string prefix);
+			virtual ~audio_parameter();
+
+			void defaults(obs_data_t* settings) override;
+
+			void properties(obs_properties_t* props, obs_data_t* settings) override;
+
+			void update(obs_data_t* settings) override;
+
+			void assign() override;
+
+			bool is_static() override
+			{
+				return false;
+			}
+		};
+	} // namespace shader
+} // namespace streamfx::gfx
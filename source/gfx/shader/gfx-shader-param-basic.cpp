@@ -18,6 +18,8 @@
 #include "gfx-shader-param-basic.hpp"
 #include "strings.hpp"
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <map>
 #include <sstream>
 #include <stdexcept>
@@ -31,6 +33,26 @@ static const std::string_view _annotation_scale           = "scale";
 static const std::string_view _annotation_enum_entry      = "enum_%zu";
 static const std::string_view _annotation_enum_entry_name = "enum_%zu_name";
 
+// Scalar or vector constructor with one value per component, if the parameter is exactly that in the effect.
+template<typename T>
+static std::string build_constant(streamfx::obs::gs::effect_parameter param, std::size_t size, const char* type,
+								  const char* format, T value_at)
+{
+	if ((size < 1) || (size > 4) || (streamfx::gfx::shader::get_length_from_effect_type(param.get_type()) != size))
+		return {};
+
+	std::string code = type;
+	if (size > 1)
+		code.append(std::to_string(size));
+	code.append("(");
+	for (std::size_t idx = 0; idx < size; idx++) {
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), format, value_at(idx));
+		code.append(idx > 0 ? ", " : "").append(buffer);
+	}
+	return code.append(")");
+}
+
 inline bool get_annotation_string(streamfx::obs::gs::effect_parameter param, std::string anno_name, std::string& out)
 {
 	if (!param)
@@ -205,13 +227,28 @@ void streamfx::gfx::shader::bool_parameter::update(obs_data_t* settings)
 
 	// TODO: Support for bool[]
 	if (get_size() == 1) {
-		_data[0] = static_cast<int32_t>(obs_data_get_int(settings, get_key().data()));
+		if (int32_t v = static_cast<int32_t>(obs_data_get_int(settings, get_key().data())); _data[0] != v) {
+			_data[0] = v;
+			invalidate();
+		}
 	}
 }
 
 void streamfx::gfx::shader::bool_parameter::assign()
 {
+	if (!is_dirty())
+		return;
+
 	get_parameter().set_value(_data.data(), _data.size());
+	clear_dirty();
+}
+
+std::string streamfx::gfx::shader::bool_parameter::constant()
+{
+	if (is_automatic() || (get_size() != 1))
+		return {};
+
+	return _data[0] ? "true" : "false";
 }
 
 streamfx::gfx::shader::float_parameter::float_parameter(streamfx::obs::gs::effect_parameter param, std::string prefix)
@@ -310,17 +347,38 @@ void streamfx::gfx::shader::float_parameter::properties(obs_properties_t* props,
 void streamfx::gfx::shader::float_parameter::update(obs_data_t* settings)
 {
 	for (std::size_t idx = 0; idx < get_size(); idx++) {
-		_data[idx].f32 = static_cast<float_t>(obs_data_get_double(settings, key_at(idx).data())) * _scale[idx].f32;
+		float_t v = static_cast<float_t>(obs_data_get_double(settings, key_at(idx).data())) * _scale[idx].f32;
+		if (_data[idx].f32 != v) {
+			_data[idx].f32 = v;
+			invalidate();
+		}
 	}
 }
 
 void streamfx::gfx::shader::float_parameter::assign()
 {
-	if (is_automatic())
+	if (is_automatic() || !is_dirty())
 		return;
 
 	get_parameter().set_value(_data.data(), get_size());
+	clear_dirty();
 }
+
+std::string streamfx::gfx::shader::float_parameter::constant()
+{
+	if (is_automatic())
+		return {};
+
+	// Infinity and NaN have no literal.
+	for (auto& v : _data) {
+		if (!std::isfinite(v.f32))
+			return {};
+	}
+
+	return build_constant(get_parameter(), get_size(), "float", "%.9g",
+						  [this](std::size_t idx) { return static_cast<double_t>(_data[idx].f32); });
+}
+
 static inline obs_property_t* build_int_property(streamfx::gfx::shader::basic_field_type ft, obs_properties_t* props,
 												 const char* key, const char* name, int32_t min, int32_t max,
 												 int32_t step, std::list<streamfx::gfx::shader::basic_enum_data> edata)
@@ -415,14 +473,28 @@ void streamfx::gfx::shader::int_parameter::properties(obs_properties_t* props, o
 void streamfx::gfx::shader::int_parameter::update(obs_data_t* settings)
 {
 	for (std::size_t idx = 0; idx < get_size(); idx++) {
-		_data[idx].i32 = static_cast<int32_t>(obs_data_get_int(settings, key_at(idx).data()) * _scale[idx].i32);
+		int32_t v = static_cast<int32_t>(obs_data_get_int(settings, key_at(idx).data()) * _scale[idx].i32);
+		if (_data[idx].i32 != v) {
+			_data[idx].i32 = v;
+			invalidate();
+		}
 	}
 }
 
 void streamfx::gfx::shader::int_parameter::assign()
 {
-	if (is_automatic())
+	if (is_automatic() || !is_dirty())
 		return;
 
 	get_parameter().set_value(_data.data(), get_size());
+	clear_dirty();
+}
+
+std::string streamfx::gfx::shader::int_parameter::constant()
+{
+	if (is_automatic())
+		return {};
+
+	return build_constant(get_parameter(), get_size(), "int", "%d",
+						  [this](std::size_t idx) { return static_cast<int>(_data[idx].i32); });
 }
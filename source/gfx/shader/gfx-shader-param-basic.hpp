@@ -108,6 +108,8 @@ namespace streamfx::gfx {
 			void update(obs_data_t* settings) override;
 
 			void assign() override;
+
+			std::string constant() override;
 		};
 
 		struct float_parameter : public basic_parameter {
@@ -124,6 +126,8 @@ namespace streamfx::gfx {
 			void update(obs_data_t* settings) override;
 
 			void assign() override;
+
+			std::string constant() override;
 		};
 
 		struct int_parameter : public basic_parameter {
@@ -140,6 +144,8 @@ namespace streamfx::gfx {
 			void update(obs_data_t* settings) override;
 
 			void assign() override;
+
+			std::string constant() override;
 		};
 
 	} // namespace shader
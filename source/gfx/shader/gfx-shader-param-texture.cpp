@@ -0,0 +1,158 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2021 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#include "gfx-shader-param-texture.hpp"
+#include "strings.hpp"
+#include <filesystem>
+#include <stdexcept>
+#include "obs/obs-source-tracker.hpp"
+
+#define ST_PREFIX "<gfx::shader::texture_parameter> "
+
+#define ST_I18N_TYPE "Shader.Parameter.Texture.Type"
+#define ST_I18N_FILE "Shader.Parameter.Texture.File"
+#define ST_I18N_SOURCE "Shader.Parameter.Texture.Source"
+
+streamfx::gfx::shader::texture_parameter::texture_parameter(streamfx::obs::gs::effect_parameter param,
+															 std::string prefix, obs_source_t* parent)
+	: parameter(param, prefix), _parent(parent), _key_type(get_key()), _key_file(), _key_source(),
+	  _field_type(texture_field_type::File), _file_path(), _source_name(), _file(), _source(), _assigned(nullptr)
+{
+	_key_file   = _key_type + ".File";
+	_key_source = _key_type + ".Source";
+}
+
+streamfx::gfx::shader::texture_parameter::~texture_parameter() {}
+
+void streamfx::gfx::shader::texture_parameter::defaults(obs_data_t* settings)
+{
+	obs_data_set_default_int(settings, _key_type.c_str(), static_cast<int64_t>(texture_field_type::File));
+	obs_data_set_default_string(settings, _key_file.c_str(), "");
+	obs_data_set_default_string(settings, _key_source.c_str(), "");
+}
+
+void streamfx::gfx::shader::texture_parameter::properties(obs_properties_t* props, obs_data_t* settings)
+{
+	if (!is_visible())
+		return;
+
+	auto pr = obs_properties_create();
+	{
+		auto p = obs_properties_add_group(props, get_key().data(), get_name().data(), OBS_GROUP_NORMAL, pr);
+		if (has_description())
+			obs_property_set_long_description(p, get_description().data());
+	}
+
+	{
+		auto p = obs_properties_add_list(pr, _key_type.c_str(), D_TRANSLATE(ST_I18N_TYPE), OBS_COMBO_TYPE_LIST,
+										 OBS_COMBO_FORMAT_INT);
+		obs_property_list_add_int(p, D_TRANSLATE(S_FILETYPE_IMAGE), static_cast<int64_t>(texture_field_type::File));
+		obs_property_list_add_int(p, D_TRANSLATE(S_SOURCETYPE_SOURCE),
+								  static_cast<int64_t>(texture_field_type::Source));
+	}
+
+	{
+		std::string filter = std::string(D_TRANSLATE(S_FILETYPE_IMAGES)) + " (" S_FILEFILTERS_TEXTURE ");;* (*.*)";
+		obs_properties_add_path(pr, _key_file.c_str(), D_TRANSLATE(ST_I18N_FILE), OBS_PATH_FILE, filter.c_str(),
+								nullptr);
+	}
+
+	{
+		auto p = obs_properties_add_list(pr, _key_source.c_str(), D_TRANSLATE(ST_I18N_SOURCE), OBS_COMBO_TYPE_LIST,
+										 OBS_COMBO_FORMAT_STRING);
+		obs_property_list_add_string(p, "", "");
+		obs::source_tracker::get()->enumerate(
+			[&p](std::string name, obs_source_t*) {
+				obs_property_list_add_string(p, std::string(name + " (Source)").c_str(), name.c_str());
+				return false;
+			},
+			obs::source_tracker::filter_video_sources);
+		obs::source_tracker::get()->enumerate(
+			[&p](std::string name, obs_source_t*) {
+				obs_property_list_add_string(p, std::string(name + " (Scene)").c_str(), name.c_str());
+				return false;
+			},
+			obs::source_tracker::filter_scenes);
+	}
+}
+
+void streamfx::gfx::shader::texture_parameter::update(obs_data_t* settings)
+{
+	if (is_automatic())
+		return;
+
+	_field_type = static_cast<texture_field_type>(obs_data_get_int(settings, _key_type.c_str()));
+
+	if (std::string path = obs_data_get_string(settings, _key_file.c_str()); path != _file_path) {
+		_file_path = path;
+		_file.reset();
+		if (!_file_path.empty()) {
+			try {
+				_file = streamfx::gfx::texture_file::load(std::filesystem::u8path(_file_path));
+			} catch (const std::exception& ex) {
+				DLOG_ERROR(ST_PREFIX "Failed to load image '%s': %s", _file_path.c_str(), ex.what());
+			}
+		}
+	}
+
+	if (std::string name = obs_data_get_string(settings, _key_source.c_str()); name != _source_name) {
+		_source_name = name;
+		_source.reset();
+		if (!_source_name.empty() && _parent) {
+			try {
+				_source = std::make_shared<streamfx::gfx::source_texture>(_source_name, _parent);
+			} catch (const std::exception& ex) {
+				DLOG_ERROR(ST_PREFIX "Failed to use source '%s': %s", _source_name.c_str(), ex.what());
+			}
+		}
+	}
+}
+
+void streamfx::gfx::shader::texture_parameter::assign()
+{
+	if (is_automatic())
+		return;
+
+	std::shared_ptr<streamfx::obs::gs::texture> texture;
+	if ((_field_type == texture_field_type::Source) && _source) {
+		obs_source_t* source = _source->get_object();
+		uint32_t      width  = obs_source_get_width(source);
+		uint32_t      height = obs_source_get_height(source);
+		if (width && height) {
+			texture = _source->render(width, height);
+		}
+	} else if ((_field_type == texture_field_type::File) && _file) {
+		// Until decoding finishes, the shader sees no texture at all.
+		texture = _file->get_texture();
+	}
+
+	gs_texture_t* object = texture ? texture->get_object() : nullptr;
+	if ((object != _assigned) || is_dirty()) {
+		get_parameter().set_texture(object);
+		_assigned = object;
+		clear_dirty();
+	}
+}
+
+bool streamfx::gfx::shader::texture_parameter::is_static()
+{
+	// Sources change from frame to frame, and a file changes once when it finished decoding.
+	if (_field_type == texture_field_type::Source) {
+		return false;
+	}
+	return !_file || _file->is_ready();
+}
@@ -0,0 +1,64 @@
+// Modern effects for a modern Streamer
+// Copyright (C) 2021 Michael Fabian Dirks
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#pragma once
+#include "common.hpp"
+#include <memory>
+#include <string>
+#include "gfx-shader-param.hpp"
+#include "gfx/gfx-source-texture.hpp"
+#include "gfx/gfx-texture-file.hpp"
+#include "obs/gs/gs-effect-parameter.hpp"
+
+namespace streamfx::gfx {
+	namespace shader {
+		enum class texture_field_type : int64_t {
+			File,
+			Source,
+		};
+
+		/** A texture chosen by the user, either from an image file or from the current frame of a source. */
+		struct texture_parameter : public parameter {
+			obs_source_t* _parent;
+			std::string   _key_type;
+			std::string   _key_file;
+			std::string   _key_source;
+
+			texture_field_type _field_type;
+			std::string        _file_path;
+			std::string        _source_name;
+
+			std::shared_ptr<streamfx::gfx::texture_file>   _file;
+			std::shared_ptr<streamfx::gfx::source_texture> _source;
+			gs_texture_t*                                  _assigned;
+
+			public:
+			texture_parameter(streamfx::obs::gs::effect_parameter param, std::string prefix, obs_source_t* parent);
+			virtual ~texture_parameter();
+
+			void defaults(obs_data_t* settings) override;
+
+			void properties(obs_properties_t* props, obs_data_t* settings) override;
+
+			void update(obs_data_t* settings) override;
+
+			void assign() override;
+
+			bool is_static() override;
+		};
+	} // namespace shader
+} // namespace streamfx::gfx
@@ -18,7 +18,9 @@
 #include "gfx-shader-param.hpp"
 #include <algorithm>
 #include <sstream>
+#include "gfx-shader-param-audio.hpp"
 #include "gfx-shader-param-basic.hpp"
+#include "gfx-shader-param-texture.hpp"
 
 #define ST_ANNO_ORDER "order"
 #define ST_ANNO_VISIBILITY "visible"
@@ -103,6 +105,9 @@ streamfx::gfx::shader::parameter_type streamfx::gfx::shader::get_type_from_strin
 	if ((v == "sampler")) {
 		return parameter_type::Sampler;
 	}
+	if ((v == "audio") || (v == "spectrum")) {
+		return parameter_type::Audio;
+	}
 	/* To decide on in the future:
 	 * - Double support?
 	 * - Half Support?
@@ -112,7 +117,8 @@ streamfx::gfx::shader::parameter_type streamfx::gfx::shader::get_type_from_strin
 }
 
 streamfx::gfx::shader::parameter::parameter(streamfx::obs::gs::effect_parameter param, std::string key_prefix)
-	: _param(param), _order(0), _key(_param.get_name()), _visible(true), _automatic(false), _name(_key), _description()
+	: _param(param), _order(0), _key(_param.get_name()), _visible(true), _automatic(false), _name(_key), _description(),
+	  _dirty(true)
 {
 	{
 		std::stringstream ss;
@@ -177,7 +183,8 @@ void streamfx::gfx::shader::parameter::update(obs_data_t* settings) {}
 void streamfx::gfx::shader::parameter::assign() {}
 
 std::shared_ptr<streamfx::gfx::shader::parameter>
-	streamfx::gfx::shader::parameter::make_parameter(streamfx::obs::gs::effect_parameter param, std::string prefix)
+	streamfx::gfx::shader::parameter::make_parameter(streamfx::obs::gs::effect_parameter param, std::string prefix,
+													 obs_source_t* parent)
 {
 	if (!param) {
 		throw std::runtime_error("Bad call to make_parameter. This is a bug in the plugin.");
@@ -186,7 +193,7 @@ std::shared_ptr<streamfx::gfx::shader::parameter>
 	parameter_type real_type = get_type_from_effect_type(param.get_type());
 	if (auto anno = param.get_annotation(ST_ANNO_TYPE); anno) {
 		// We have a type override.
-		real_type = get_type_from_string(param.get_default_string());
+		real_type = get_type_from_string(anno.get_default_string());
 	}
 
 	switch (real_type) {
@@ -196,6 +203,10 @@ std::shared_ptr<streamfx::gfx::shader::parameter>
 		return std::make_shared<streamfx::gfx::shader::int_parameter>(param, prefix);
 	case parameter_type::Float:
 		return std::make_shared<streamfx::gfx::shader::float_parameter>(param, prefix);
+	case parameter_type::Texture:
+		return std::make_shared<streamfx::gfx::shader::texture_parameter>(param, prefix, parent);
+	case parameter_type::Audio:
+		return std::make_shared<streamfx::gfx::shader::audio_parameter>(param, prefix);
 	default:
 		return nullptr;
 	}
@@ -36,7 +36,9 @@ namespace streamfx::gfx {
 			// Texture with dimensions stored in size (1 = Texture1D, 2 = Texture2D, 3 = Texture3D, 6 = TextureCube).
 			Texture,
 			// Sampler for Textures.
-			Sampler
+			Sampler,
+			// Frequency spectrum of the audio of a source, as a Texture.
+			Audio,
 		};
 
 		parameter_type get_type_from_effect_type(streamfx::obs::gs::effect_parameter::type type);
@@ -67,10 +69,23 @@ namespace streamfx::gfx {
 			std::string _name;
 			std::string _description;
 
+			// Whether the value changed since it was last assigned to the effect.
+			bool _dirty;
+
 			protected:
 			parameter(streamfx::obs::gs::effect_parameter param, std::string key_prefix);
 			virtual ~parameter(){};
 
+			inline bool is_dirty()
+			{
+				return _dirty;
+			}
+
+			inline void clear_dirty()
+			{
+				_dirty = false;
+			}
+
 			public:
 			virtual void defaults(obs_data_t* settings);
 
@@ -80,6 +95,33 @@ namespace streamfx::gfx {
 
 			virtual void assign();
 
+			/** Whether the value only changes through update(), and not on its own from frame to frame. */
+			virtual bool is_static()
+			{
+				return true;
+			}
+
+			/** The current value as a constant expression for effect code, or empty if it can't be one. */
+			virtual std::string constant()
+			{
+				return {};
+			}
+
+			/** Assign the value on the next call to assign() even if it did not change, for example because someone
+			 * else wrote to the same effect in the meantime.
+			 */
+			inline void invalidate()
+			{
+				_dirty = true;
+			}
+
+			/** Assign to the same parameter in another compile of the same effect from now on. */
+			inline void rebind(streamfx::obs::gs::effect_parameter param)
+			{
+				_param = param;
+				_dirty = true;
+			}
+
 			public:
 			inline streamfx::obs::gs::effect_parameter get_parameter()
 			{
@@ -138,7 +180,8 @@ namespace streamfx::gfx {
 
 			public:
 			static std::shared_ptr<parameter> make_parameter(streamfx::obs::gs::effect_parameter param,
-															 std::string                         prefix);
+															 std::string                         prefix,
+															 obs_source_t*                       parent = nullptr);
 		};
 	} // namespace shader
 } // namespace streamfx::gfx
@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <cstdio>
 #include <cstring>
+#include <mutex>
 #include "obs/obs-tools.hpp"
 #include "plugin.hpp"
 
@@ -29,29 +30,76 @@
 #define ST_KEY_SHADER "Shader.Shader"
 #define ST_I18N_SHADER_FILE ST_I18N_SHADER ".File"
 #define ST_KEY_SHADER_FILE ST_KEY_SHADER ".File"
+#define ST_I18N_SHADER_FILE_POLL ST_I18N_SHADER_FILE ".Poll"
+#define ST_KEY_SHADER_FILE_POLL ST_KEY_SHADER_FILE ".Poll"
+#define ST_I18N_SHADER_SPECIALIZE ST_I18N_SHADER ".Specialize"
+#define ST_KEY_SHADER_SPECIALIZE ST_KEY_SHADER ".Specialize"
 #define ST_I18N_SHADER_TECHNIQUE ST_I18N_SHADER ".Technique"
 #define ST_KEY_SHADER_TECHNIQUE ST_KEY_SHADER ".Technique"
+#define ST_I18N_SHADER_ERROR ST_I18N_SHADER ".Error"
+#define ST_KEY_SHADER_ERROR ST_KEY_SHADER ".Error"
 #define ST_I18N_SHADER_SIZE ST_I18N_SHADER ".Size"
 #define ST_KEY_SHADER_SIZE ST_KEY_SHADER ".Size"
 #define ST_I18N_SHADER_SIZE_WIDTH ST_I18N_SHADER_SIZE ".Width"
 #define ST_KEY_SHADER_SIZE_WIDTH ST_KEY_SHADER_SIZE ".Width"
 #define ST_I18N_SHADER_SIZE_HEIGHT ST_I18N_SHADER_SIZE ".Height"
 #define ST_KEY_SHADER_SIZE_HEIGHT ST_KEY_SHADER_SIZE ".Height"
+#define ST_I18N_SHADER_SCALE ST_I18N_SHADER ".Scale"
+#define ST_KEY_SHADER_SCALE ST_KEY_SHADER ".Scale"
+#define ST_I18N_SHADER_CHECKERBOARD ST_I18N_SHADER ".Checkerboard"
+#define ST_KEY_SHADER_CHECKERBOARD ST_KEY_SHADER ".Checkerboard"
 #define ST_I18N_SHADER_SEED ST_I18N_SHADER ".Seed"
 #define ST_KEY_SHADER_SEED ST_KEY_SHADER ".Seed"
 #define ST_I18N_PARAMETERS ST_I18N ".Parameters"
 #define ST_KEY_PARAMETERS "Shader.Parameters"
 
+// Seconds that parameters have to stay unchanged before the shader is specialized for them.
+#define SPECIALIZE_DELAY 5.0f
+
+#define ST_ANNO_SCALE "scale"
+
+static std::mutex                          effect_owners_lock;
+static std::map<gs_effect_t*, const void*> effect_owners;
+
+/** Remember who assigned their parameters to a shared effect last, and return true if that was someone else. */
+static bool claim_effect(gs_effect_t* effect, const void* owner)
+{
+	std::unique_lock<std::mutex> lock(effect_owners_lock);
+	auto&                        current = effect_owners[effect];
+	if (current == owner) {
+		return false;
+	}
+	current = owner;
+	return true;
+}
+
+static void release_effect(gs_effect_t* effect, const void* owner)
+{
+	std::unique_lock<std::mutex> lock(effect_owners_lock);
+	if (auto found = effect_owners.find(effect); (found != effect_owners.end()) && (found->second == owner)) {
+		effect_owners.erase(found);
+	}
+}
+
 streamfx::gfx::shader::shader::shader(obs_source_t* self, shader_mode mode)
-	: _self(self), _mode(mode), _base_width(1), _base_height(1), _active(true),
+	: _self(self), _mode(mode), _base_width(1), _base_height(1), _active(true), _visible(true),
 
 	  _shader(), _shader_file(), _shader_tech("Draw"), _shader_file_mt(), _shader_file_sz(), _shader_file_tick(0),
+	  _shader_load(), _shader_error_file(), _shader_error_file_mt(), _shader_error_file_sz(), _shader_error(),
+	  _specialize(false), _specialize_time(0), _specialize_constants(), _specialize_failed(), _shader_constants(),
+	  _shader_generic(), _shader_static(false),
+
+	  _shader_file_poll(false), _shader_file_watched(), _shader_file_watch(),
 
 	  _width_type(size_type::Percent), _width_value(1.0), _height_type(size_type::Percent), _height_value(1.0),
+	  _render_scale(1.0), _checkerboard(false),
+
+	  _have_current_params(false), _time(0), _time_loop(0), _loops(0), _random(), _random_seed(0), _tracking(),
 
-	  _have_current_params(false), _time(0), _time_loop(0), _loops(0), _random(), _random_seed(0),
+	  _rt_up_to_date(false), _rt_static(false),
+	  _rt(std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE)), _rt_feedback(), _rt_size(0, 0),
 
-	  _rt_up_to_date(false), _rt(std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE))
+	  _cb_effect(), _cb_sparse(), _cb_history(), _cb_frame(0)
 {
 	// Intialize random values.
 	_random.seed(static_cast<unsigned long long>(_random_seed));
@@ -61,7 +109,12 @@ streamfx::gfx::shader::shader::shader(obs_source_t* self, shader_mode mode)
 	}
 }
 
-streamfx::gfx::shader::shader::~shader() {}
+streamfx::gfx::shader::shader::~shader()
+{
+	if (_shader) {
+		release_effect(_shader.get_object(), this);
+	}
+}
 
 bool streamfx::gfx::shader::shader::is_shader_different(const std::filesystem::path& file)
 try {
@@ -102,99 +155,332 @@ try {
 	if (!std::filesystem::exists(file))
 		return false;
 
-	shader_dirty = is_shader_different(file);
-	param_dirty  = is_technique_different(tech) || shader_dirty;
+	shader_dirty = false;
+	param_dirty  = false;
 
-	// Update Shader
-	if (shader_dirty) {
-		_shader           = streamfx::obs::gs::effect(file);
-		_shader_file_mt   = std::filesystem::last_write_time(file);
-		_shader_file_sz   = std::filesystem::file_size(file);
-		_shader_file      = file;
-		_shader_file_tick = 0;
+	// Compiling can take a while for large shaders, so it happens off of the graphics thread.
+	if (is_shader_different(file)) {
+		load_shader_async(file, tech);
+		return true;
+	} else if (_shader_load && _shader_load->constants.empty()) {
+		// Changed back to the current file while another one was still loading.
+		_shader_load.reset();
 	}
 
 	// Update Params
-	if (param_dirty) {
-		auto settings =
-			std::shared_ptr<obs_data_t>(obs_source_get_settings(_self), [](obs_data_t* p) { obs_data_release(p); });
+	if (_shader && is_technique_different(tech)) {
+		param_dirty    = true;
+		_rt_up_to_date = false;
+		update_parameters(tech);
+	}
 
-		bool have_valid_tech = false;
-		for (std::size_t idx = 0; idx < _shader.count_techniques(); idx++) {
-			if (_shader.get_technique(idx).name() == tech) {
-				have_valid_tech = true;
-				break;
+	return true;
+} catch (const std::exception& ex) {
+	DLOG_ERROR("Loading shader '%s' failed with error: %s", file.c_str(), ex.what());
+	return false;
+} catch (...) {
+	return false;
+}
+
+bool streamfx::gfx::shader::shader::is_loaded()
+{
+	return static_cast<bool>(_shader);
+}
+
+void streamfx::gfx::shader::shader::load_shader_async(const std::filesystem::path& file, const std::string& tech)
+{
+	auto file_mt = std::filesystem::last_write_time(file);
+	auto file_sz = std::filesystem::file_size(file);
+
+	// Failed before and unchanged since, so it would only fail again.
+	if ((_shader_error_file == file) && (_shader_error_file_mt == file_mt) && (_shader_error_file_sz == file_sz)) {
+		_shader_load.reset();
+		return;
+	}
+
+	// Already loading this exact file, so only the technique may have to be updated.
+	if (_shader_load && _shader_load->constants.empty() && (_shader_load->file == file)
+		&& (_shader_load->file_mt == file_mt) && (_shader_load->file_sz == file_sz)) {
+		_shader_load->tech = tech;
+		return;
+	}
+
+	// Replaces any older load, whose result is then dropped once it finishes.
+	auto load     = std::make_shared<shader_load>();
+	load->file    = file;
+	load->tech    = tech;
+	load->file_mt = file_mt;
+	load->file_sz = file_sz;
+	start_load(load);
+}
+
+void streamfx::gfx::shader::shader::start_load(std::shared_ptr<shader_load> load)
+{
+	load->done   = false;
+	_shader_load = load;
+
+	streamfx::threadpool()->push(
+		[](streamfx::util::threadpool_data_t data) {
+			auto load = std::static_pointer_cast<shader_load>(data);
+			try {
+				if (load->constants.empty()) {
+					load->effect = streamfx::obs::gs::effect::create_shared(load->file);
+				} else {
+					load->effect = streamfx::obs::gs::effect::create_specialized(load->file, load->constants);
+				}
+			} catch (const std::exception& ex) {
+				load->error = ex.what();
+			} catch (...) {
+				load->error = "Unknown error.";
 			}
+			load->done = true;
+		},
+		load);
+}
+
+void streamfx::gfx::shader::shader::apply_shader(shader_load& load)
+{
+	if (!load.constants.empty()) {
+		// Outdated if anything changed while it was compiling.
+		if (!_specialize || !_shader || (load.file != _shader_file) || (load.file_mt != _shader_file_mt)
+			|| (load.file_sz != _shader_file_sz) || (load.constants != _specialize_constants)) {
+			return;
 		}
-		if (have_valid_tech) {
-			_shader_tech = tech;
-		} else {
-			_shader_tech = _shader.get_technique(0).name();
 
-			// Update source data.
-			obs_data_set_string(settings.get(), ST_KEY_SHADER_TECHNIQUE, _shader_tech.c_str());
+		// Some shaders use their parameter names for other things as well, which the constants then break.
+		if (!load.effect) {
+			DLOG_WARNING("Specializing shader '%s' failed, continuing without: %s", load.file.c_str(),
+						 load.error.c_str());
+			_specialize_failed = load.constants;
+			return;
 		}
 
-		// Clear the shader parameters map and rebuild.
-		_shader_params.clear();
-		auto etech = _shader.get_technique(_shader_tech);
-		for (std::size_t idx = 0; idx < etech.count_passes(); idx++) {
-			auto pass = etech.get_pass(idx);
+		if (!_shader_generic) {
+			_shader_generic = _shader;
+		}
+		_shader_constants = load.constants;
+		use_shader(load.effect, _shader_tech);
+		return;
+	}
+
+	if (!load.effect) {
+		DLOG_ERROR("Loading shader '%s' failed with error: %s", load.file.c_str(), load.error.c_str());
+		_shader_error_file    = load.file;
+		_shader_error_file_mt = load.file_mt;
+		_shader_error_file_sz = load.file_sz;
+		_shader_error         = load.error;
+
+		// Show the error.
+		obs_source_update_properties(_self);
+		return;
+	}
+	_shader_error_file.clear();
+	_shader_error.clear();
+
+	_shader_generic.reset();
+	_shader_constants.clear();
+	_specialize_failed.clear();
+
+	_shader_file_mt   = load.file_mt;
+	_shader_file_sz   = load.file_sz;
+	_shader_file      = load.file;
+	_shader_file_tick = 0;
+	use_shader(load.effect, load.tech);
+	update_specialization();
+
+	// Show the techniques and parameters of the new shader.
+	obs_source_update_properties(_self);
+}
 
-			for (std::size_t vidx = 0; vidx < pass.count_vertex_parameters(); vidx++) {
-				auto el = pass.get_vertex_parameter(vidx);
+void streamfx::gfx::shader::shader::use_shader(streamfx::obs::gs::effect effect, const std::string& tech)
+{
+	if (_shader) {
+		release_effect(_shader.get_object(), this);
+	}
+	_shader_builtins.reset();
 
-				if (!el)
-					continue;
+	_shader          = effect;
+	_shader_builtins = {_shader, {"Time", "ViewSize", "Random", "RandomSeed", "TrackedFace", "Feedback"}};
 
-				auto fnd = _shader_params.find(el.get_name());
-				if (fnd != _shader_params.end())
-					continue;
+	// Only shaders that read their previous output need a second target to swap with.
+	if (auto& el = _shader_builtins[FEEDBACK];
+		el && (el.get_type() == streamfx::obs::gs::effect_parameter::type::Texture)) {
+		if (!_rt_feedback) {
+			_rt_feedback = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+		}
+	} else {
+		_rt_feedback.reset();
+	}
 
-				auto param = streamfx::gfx::shader::parameter::make_parameter(el, ST_KEY_PARAMETERS);
+	// ViewSize and RandomSeed only change along with the size and the settings.
+	_shader_static = !_shader_builtins[TIME] && !_shader_builtins[RANDOM] && !_shader_builtins[TRACKED_FACE]
+					 && !_shader_builtins[FEEDBACK];
 
-				if (param) {
-					_shader_params.insert_or_assign(el.get_name(), param);
-					param->defaults(settings.get());
-					param->update(settings.get());
-				}
+	_rt_up_to_date       = false;
+	_have_current_params = false;
+	update_parameters(tech);
+}
+
+void streamfx::gfx::shader::shader::specialize()
+{
+	auto load       = std::make_shared<shader_load>();
+	load->file      = _shader_file;
+	load->tech      = _shader_tech;
+	load->file_mt   = _shader_file_mt;
+	load->file_sz   = _shader_file_sz;
+	load->constants = _specialize_constants;
+	start_load(load);
+}
+
+void streamfx::gfx::shader::shader::update_specialization()
+{
+	std::map<std::string, std::string> constants;
+	if (_specialize) {
+		// Anything the user can change stays a uniform, so only values hidden from the UI are compiled in.
+		for (auto& kv : _shader_params) {
+			if (kv.second->is_visible()) {
+				continue;
 			}
+			if (auto value = kv.second->constant(); !value.empty()) {
+				constants.emplace(kv.first, value);
+			}
+		}
+	}
 
-			for (std::size_t vidx = 0; vidx < pass.count_pixel_parameters(); vidx++) {
-				auto el = pass.get_pixel_parameter(vidx);
+	if (constants != _specialize_constants) {
+		_specialize_constants = std::move(constants);
+		_specialize_time      = 0;
+	}
 
-				if (!el)
-					continue;
+	// Back to uniforms as soon as the compiled constants are outdated.
+	if (_shader_generic && (_shader_constants != _specialize_constants)) {
+		auto effect = std::move(_shader_generic);
+		_shader_generic.reset();
+		_shader_constants.clear();
+		use_shader(effect, _shader_tech);
+	}
+}
+
+void streamfx::gfx::shader::shader::update_parameters(const std::string& tech)
+{
+	auto settings =
+		std::shared_ptr<obs_data_t>(obs_source_get_settings(_self), [](obs_data_t* p) { obs_data_release(p); });
 
-				auto fnd = _shader_params.find(el.get_name());
-				if (fnd != _shader_params.end())
-					continue;
+	// Compiled in constants are missing from a specialized shader, so parameters always come from the generic one.
+	auto& generic = _shader_generic ? _shader_generic : _shader;
 
-				auto param = streamfx::gfx::shader::parameter::make_parameter(el, ST_KEY_PARAMETERS);
+	bool have_valid_tech = false;
+	for (std::size_t idx = 0; idx < _shader.count_techniques(); idx++) {
+		if (_shader.get_technique(idx).name() == tech) {
+			have_valid_tech = true;
+			break;
+		}
+	}
+	if (have_valid_tech) {
+		_shader_tech = tech;
+	} else {
+		_shader_tech = _shader.get_technique(0).name();
 
-				if (param) {
-					_shader_params.insert_or_assign(el.get_name(), param);
-					param->defaults(settings.get());
-					param->update(settings.get());
+		// Update source data.
+		obs_data_set_string(settings.get(), ST_KEY_SHADER_TECHNIQUE, _shader_tech.c_str());
+	}
+
+	// Clear the shader parameters map and rebuild.
+	_shader_params.clear();
+	auto etech = _shader.get_technique(_shader_tech);
+
+	// Rebuild the passes, with intermediate targets for all named passes that aren't last.
+	_shader_passes.clear();
+	for (std::size_t idx = 0; idx < etech.count_passes(); idx++) {
+		shader_pass info{streamfx::obs::gs::effect_parameter(), 1.0f, nullptr};
+
+		if (std::string name = etech.get_pass(idx).name(); !name.empty() && ((idx + 1) < etech.count_passes())) {
+			info.target = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+			if (auto el = _shader.get_parameter(name);
+				el && (el.get_type() == streamfx::obs::gs::effect_parameter::type::Texture)) {
+				info.input = el;
+				if (auto anno = el.get_annotation(ST_ANNO_SCALE); anno) {
+					info.scale = std::clamp(anno.get_default_float(), 1.0f / 64.0f, 1.0f);
 				}
 			}
 		}
+
+		_shader_passes.push_back(info);
 	}
+	auto gtech = generic.get_technique(_shader_tech);
+	for (std::size_t idx = 0; idx < gtech.count_passes(); idx++) {
+		auto pass = gtech.get_pass(idx);
 
-	return true;
-} catch (const std::exception& ex) {
-	DLOG_ERROR("Loading shader '%s' failed with error: %s", file.c_str(), ex.what());
-	return false;
-} catch (...) {
-	return false;
+		for (std::size_t vidx = 0; vidx < pass.count_vertex_parameters(); vidx++) {
+			auto el = pass.get_vertex_parameter(vidx);
+
+			if (!el)
+				continue;
+
+			auto fnd = _shader_params.find(el.get_name());
+			if (fnd != _shader_params.end())
+				continue;
+
+			auto param = streamfx::gfx::shader::parameter::make_parameter(el, ST_KEY_PARAMETERS, _self);
+
+			if (param) {
+				_shader_params.insert_or_assign(el.get_name(), param);
+				param->defaults(settings.get());
+				param->update(settings.get());
+			}
+		}
+
+		for (std::size_t vidx = 0; vidx < pass.count_pixel_parameters(); vidx++) {
+			auto el = pass.get_pixel_parameter(vidx);
+
+			if (!el)
+				continue;
+
+			auto fnd = _shader_params.find(el.get_name());
+			if (fnd != _shader_params.end())
+				continue;
+
+			auto param = streamfx::gfx::shader::parameter::make_parameter(el, ST_KEY_PARAMETERS, _self);
+
+			if (param) {
+				_shader_params.insert_or_assign(el.get_name(), param);
+				param->defaults(settings.get());
+				param->update(settings.get());
+			}
+		}
+	}
+
+	// Values are then assigned to the shader actually in use, wherever it still has them.
+	if (_shader_generic) {
+		for (auto& kv : _shader_params) {
+			if (auto el = _shader.get_parameter(kv.first); el) {
+				kv.second->rebind(el);
+			}
+		}
+	}
+}
+
+void streamfx::gfx::shader::shader::watch_shader_file(const std::filesystem::path& file)
+{
+	// Polling and empty paths need no watch, and an unchanged path keeps the one it has.
+	if (_shader_file_poll || file.empty()) {
+		_shader_file_watch.reset();
+	} else if (!_shader_file_watch || (file != _shader_file_watched)) {
+		_shader_file_watch = ::streamfx::util::file_watcher::instance()->add(file);
+	}
+	_shader_file_watched = file;
 }
 
 void streamfx::gfx::shader::shader::defaults(obs_data_t* data)
 {
 	obs_data_set_default_string(data, ST_KEY_SHADER_FILE, "");
+	obs_data_set_default_bool(data, ST_KEY_SHADER_FILE_POLL, false);
+	obs_data_set_default_bool(data, ST_KEY_SHADER_SPECIALIZE, false);
 	obs_data_set_default_string(data, ST_KEY_SHADER_TECHNIQUE, "");
 	obs_data_set_default_string(data, ST_KEY_SHADER_SIZE_WIDTH, "100.0 %");
 	obs_data_set_default_string(data, ST_KEY_SHADER_SIZE_HEIGHT, "100.0 %");
+	obs_data_set_default_double(data, ST_KEY_SHADER_SCALE, 100.0);
+	obs_data_set_default_bool(data, ST_KEY_SHADER_CHECKERBOARD, false);
 	obs_data_set_default_int(data, ST_KEY_SHADER_SEED, static_cast<long long>(time(NULL)));
 }
 
@@ -216,10 +502,21 @@ void streamfx::gfx::shader::shader::properties(obs_properties_t* pr)
 			auto p = obs_properties_add_path(grp, ST_KEY_SHADER_FILE, D_TRANSLATE(ST_I18N_SHADER_FILE), OBS_PATH_FILE,
 											 "*.*", path.c_str());
 		}
+		{
+			auto p = obs_properties_add_bool(grp, ST_KEY_SHADER_FILE_POLL, D_TRANSLATE(ST_I18N_SHADER_FILE_POLL));
+		}
+		{
+			auto p = obs_properties_add_bool(grp, ST_KEY_SHADER_SPECIALIZE, D_TRANSLATE(ST_I18N_SHADER_SPECIALIZE));
+		}
 		{
 			auto p = obs_properties_add_list(grp, ST_KEY_SHADER_TECHNIQUE, D_TRANSLATE(ST_I18N_SHADER_TECHNIQUE),
 											 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
 		}
+		if (!_shader_error.empty()) {
+			std::string text = std::string(D_TRANSLATE(ST_I18N_SHADER_ERROR)) + "\n" + _shader_error;
+			auto        p    = obs_properties_add_text(grp, ST_KEY_SHADER_ERROR, text.c_str(), OBS_TEXT_INFO);
+			obs_property_text_set_info_type(p, OBS_TEXT_INFO_ERROR);
+		}
 
 		{
 			obs_properties_add_button2(
@@ -244,6 +541,17 @@ void streamfx::gfx::shader::shader::properties(obs_properties_t* pr)
 			}
 		}
 
+		{
+			auto p = obs_properties_add_float_slider(grp, ST_KEY_SHADER_SCALE, D_TRANSLATE(ST_I18N_SHADER_SCALE), 25.0,
+													 100.0, 1.0);
+			obs_property_float_set_suffix(p, " %");
+		}
+
+		{
+			auto p =
+				obs_properties_add_bool(grp, ST_KEY_SHADER_CHECKERBOARD, D_TRANSLATE(ST_I18N_SHADER_CHECKERBOARD));
+		}
+
 		{
 			auto p = obs_properties_add_int_slider(grp, ST_KEY_SHADER_SEED, D_TRANSLATE(ST_I18N_SHADER_SEED),
 												   std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), 1);
@@ -330,6 +638,9 @@ bool streamfx::gfx::shader::shader::update_shader(obs_data_t* data, bool& shader
 	const char* tech_c = obs_data_get_string(data, ST_KEY_SHADER_TECHNIQUE);
 	std::string tech   = tech_c ? tech_c : "Draw";
 
+	// Watched even if it fails to load, so that fixing the file reloads it.
+	watch_shader_file(file);
+
 	return load_shader(file, tech, shader_dirty, param_dirty);
 }
 
@@ -350,6 +661,8 @@ inline std::pair<streamfx::gfx::shader::size_type, double_t> parse_text_as_size(
 
 void streamfx::gfx::shader::shader::update(obs_data_t* data)
 {
+	_shader_file_poll = obs_data_get_bool(data, ST_KEY_SHADER_FILE_POLL);
+
 	bool v1, v2;
 	update_shader(data, v1, v2);
 
@@ -363,6 +676,9 @@ void streamfx::gfx::shader::shader::update(obs_data_t* data)
 		_height_value = std::clamp(sz_y.second, 0.01, 8192.0);
 	}
 
+	_render_scale = std::clamp(obs_data_get_double(data, ST_KEY_SHADER_SCALE) / 100.0, 0.25, 1.0);
+	_checkerboard = obs_data_get_bool(data, ST_KEY_SHADER_CHECKERBOARD);
+
 	if (int32_t seed = static_cast<int32_t>(obs_data_get_int(data, ST_KEY_SHADER_SEED)); _random_seed != seed) {
 		_random_seed = seed;
 		_random.seed(static_cast<unsigned long long>(_random_seed));
@@ -375,6 +691,11 @@ void streamfx::gfx::shader::shader::update(obs_data_t* data)
 	for (auto kv : _shader_params) {
 		kv.second->update(data);
 	}
+
+	_specialize = obs_data_get_bool(data, ST_KEY_SHADER_SPECIALIZE);
+	update_specialization();
+
+	_rt_up_to_date = false;
 }
 
 uint32_t streamfx::gfx::shader::shader::width()
@@ -425,6 +746,16 @@ uint32_t streamfx::gfx::shader::shader::height()
 	}
 }
 
+uint32_t streamfx::gfx::shader::shader::render_width()
+{
+	return std::max<uint32_t>(static_cast<uint32_t>(width() * _render_scale), 1);
+}
+
+uint32_t streamfx::gfx::shader::shader::render_height()
+{
+	return std::max<uint32_t>(static_cast<uint32_t>(height() * _render_scale), 1);
+}
+
 uint32_t streamfx::gfx::shader::shader::base_width()
 {
 	return _base_width;
@@ -437,11 +768,37 @@ uint32_t streamfx::gfx::shader::shader::base_height()
 
 bool streamfx::gfx::shader::shader::tick(float_t time)
 {
-	_shader_file_tick = static_cast<float_t>(static_cast<double_t>(_shader_file_tick) + static_cast<double_t>(time));
-	if (_shader_file_tick >= 1.0f / 3.0f) {
-		_shader_file_tick -= 1.0f / 3.0f;
+	// Swap in a shader that finished loading in the background.
+	if (_shader_load && _shader_load->done) {
+		auto load = std::move(_shader_load);
+		apply_shader(*load);
+	}
+
+	// Nobody can see the result, so time stands still until it is shown again.
+	if (!_visible)
+		return false;
+
+	if (_shader_file_poll) {
+		// Fallback for file systems which don't notify about changes, such as some network shares.
+		_shader_file_tick =
+			static_cast<float_t>(static_cast<double_t>(_shader_file_tick) + static_cast<double_t>(time));
+		if (_shader_file_tick >= 1.0f / 3.0f) {
+			_shader_file_tick -= 1.0f / 3.0f;
+			bool v1, v2;
+			load_shader(_shader_file, _shader_tech, v1, v2);
+		}
+	} else if (_shader_file_watch && _shader_file_watch->changed()) {
 		bool v1, v2;
-		load_shader(_shader_file, _shader_tech, v1, v2);
+		load_shader(_shader_file_watched, _shader_tech, v1, v2);
+	}
+
+	// Compile the parameters into the shader once they stopped changing for a while.
+	if (_shader && !_shader_load && !_specialize_constants.empty() && (_shader_constants != _specialize_constants)
+		&& (_specialize_failed != _specialize_constants)) {
+		_specialize_time += time;
+		if (_specialize_time >= SPECIALIZE_DELAY) {
+			specialize();
+		}
 	}
 
 	// Update State
@@ -456,30 +813,69 @@ bool streamfx::gfx::shader::shader::tick(float_t time)
 			_loops = -_loops;
 	}
 
-	// Recreate Per-Activation-Random values.
-	for (size_t idx = 0; idx < 8; idx++) {
-		_random_values[8 + idx] =
-			static_cast<float_t>(static_cast<double_t>(_random()) / static_cast<double_t>(_random.max()));
+	// Recreate Per-Frame-Random values, but only if anyone is going to see them.
+	if (_shader_builtins[RANDOM]) {
+		for (size_t idx = 0; idx < 8; idx++) {
+			_random_values[8 + idx] =
+				static_cast<float_t>(static_cast<double_t>(_random()) / static_cast<double_t>(_random.max()));
+		}
 	}
 
-	// Flag Render Target as outdated.
-	_rt_up_to_date = false;
+	// Flag Render Target as outdated, unless nothing it depends on changed. Something that just stopped changing,
+	// like a texture that finished decoding, still has to be rendered once more.
+	bool is_now_static = is_static();
+	if (!is_now_static || !_rt_static) {
+		_rt_up_to_date = false;
+	}
+	_rt_static = is_now_static;
 
 	return false;
 }
 
+bool streamfx::gfx::shader::shader::is_static()
+{
+	if (!_shader || !_shader_static) {
+		return false;
+	}
+
+	// Parameters may read sources or audio, which change on their own as well.
+	for (auto& kv : _shader_params) {
+		if (!kv.second->is_static()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void streamfx::gfx::shader::shader::invalidate()
+{
+	_rt_up_to_date = false;
+}
+
 void streamfx::gfx::shader::shader::prepare_render()
 {
 	if (!_shader)
 		return;
 
-	// Assign user parameters
-	for (auto kv : _shader_params) {
+	// Already rendered this frame for a different view, so render() will only draw the cached result.
+	if (_rt_up_to_date)
+		return;
+
+	// Assign user parameters, skipping those that did not change. The effect may be shared with other instances of
+	// the same file, in which case their values have to be replaced with ours again first.
+	bool reassign = claim_effect(_shader.get_object(), this);
+	for (auto& kv : _shader_params) {
+		if (_shader_constants.count(kv.first) != 0) {
+			continue;
+		}
+		if (reassign) {
+			kv.second->invalidate();
+		}
 		kv.second->assign();
 	}
 
 	// float4 Time: (Time in Seconds), (Time in Current Second), (Time in Seconds only), (Random Value)
-	if (streamfx::obs::gs::effect_parameter el = _shader.get_parameter("Time"); el != nullptr) {
+	if (auto& el = _shader_builtins[TIME]; el) {
 		if (el.get_type() == streamfx::obs::gs::effect_parameter::type::Float4) {
 			el.set_float4(
 				_time, _time_loop, static_cast<float_t>(_loops),
@@ -488,27 +884,43 @@ void streamfx::gfx::shader::shader::prepare_render()
 	}
 
 	// float4 ViewSize: (Width), (Height), (1.0 / Width), (1.0 / Height)
-	if (auto el = _shader.get_parameter("ViewSize"); el != nullptr) {
+	if (auto& el = _shader_builtins[VIEW_SIZE]; el) {
 		if (el.get_type() == streamfx::obs::gs::effect_parameter::type::Float4) {
-			el.set_float4(static_cast<float_t>(width()), static_cast<float_t>(height()),
-						  1.0f / static_cast<float_t>(width()), 1.0f / static_cast<float_t>(height()));
+			el.set_float4(static_cast<float_t>(render_width()), static_cast<float_t>(render_height()),
+						  1.0f / static_cast<float_t>(render_width()), 1.0f / static_cast<float_t>(render_height()));
 		}
 	}
 
 	// float4x4 Random: float4[Per-Instance Random], float4[Per-Activation Random], float4x2[Per-Frame Random]
-	if (auto el = _shader.get_parameter("Random"); el != nullptr) {
+	if (auto& el = _shader_builtins[RANDOM]; el) {
 		if (el.get_type() == streamfx::obs::gs::effect_parameter::type::Matrix) {
 			el.set_value(_random_values, 16);
 		}
 	}
 
 	// int32 RandomSeed: Seed used for random generation
-	if (auto el = _shader.get_parameter("RandomSeed"); el != nullptr) {
+	if (auto& el = _shader_builtins[RANDOM_SEED]; el) {
 		if (el.get_type() == streamfx::obs::gs::effect_parameter::type::Integer) {
 			el.set_int(_random_seed);
 		}
 	}
 
+	// float4 TrackedFace: (Left), (Top), (Width), (Height) of the first face found on the filtered source, in UV.
+	if (auto& el = _shader_builtins[TRACKED_FACE]; el) {
+		if (el.get_type() == streamfx::obs::gs::effect_parameter::type::Float4) {
+			std::shared_ptr<const ::streamfx::util::tracking::frame> frame;
+			if (_mode == shader_mode::Filter) {
+				frame = _tracking.get(obs_filter_get_parent(_self));
+			}
+			if (frame && !frame->faces.empty()) {
+				auto& face = frame->faces.front();
+				el.set_float4(face.x, face.y, face.width, face.height);
+			} else {
+				el.set_float4(0.f, 0.f, 0.f, 0.f);
+			}
+		}
+	}
+
 	return;
 }
 
@@ -520,35 +932,217 @@ void streamfx::gfx::shader::shader::render(gs_effect* effect)
 	if (!effect)
 		effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
 
+	if (!_checkerboard && _cb_effect) {
+		checkerboard_unload();
+	}
+
 	if (!_rt_up_to_date) {
-		auto op   = _rt->render(width(), height());
+		uint32_t width  = render_width();
+		uint32_t height = render_height();
+
+		// A result that stopped changing is rendered in full once, as there is nothing left to reconstruct it from.
+		if (_checkerboard && !_rt_static && checkerboard_load()) {
+			render_checkerboard(width, height);
+		} else {
+			// The previous output becomes the feedback texture, and the old feedback target is overwritten.
+			if (_rt_feedback) {
+				std::swap(_rt, _rt_feedback);
+				_shader_builtins[FEEDBACK].set_texture(_rt_feedback->get_object());
+			}
+
+			auto op   = _rt->render(width, height);
+			vec4 zero = {0, 0, 0, 0};
+			gs_ortho(0, 1, 0, 1, 0, 1);
+			gs_clear(GS_CLEAR_COLOR, &zero, 0, 0);
+
+			gs_blend_state_push();
+			gs_reset_blend_state();
+
+			gs_enable_blending(true);
+			gs_blend_function_separate(GS_BLEND_ONE, GS_BLEND_ZERO, GS_BLEND_ONE, GS_BLEND_ZERO);
+			gs_enable_color(true, true, true, true);
+			render_shader();
+
+			gs_blend_state_pop();
+		}
+
+		_rt_size       = {width, height};
+		_rt_up_to_date = true;
+	}
+
+	// A reduced render scale is stretched back up to the output size by the linear sampler of the draw effect.
+	gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), _rt->get_texture()->get_object());
+	while (gs_effect_loop(effect, "Draw")) {
+		gs_draw_sprite(nullptr, 0, width(), height());
+	}
+}
+
+void streamfx::gfx::shader::shader::render_shader()
+{
+	if (_shader_passes.size() > 1) {
+		render_passes();
+	} else {
+		while (gs_effect_loop(_shader.get_object(), _shader_tech.c_str())) {
+			streamfx::gs_draw_fullscreen_tri();
+		}
+	}
+}
+
+bool streamfx::gfx::shader::shader::checkerboard_load()
+{
+	if (_cb_effect) {
+		return true;
+	}
+
+	auto path = streamfx::data_file_path("effects/checkerboard.effect");
+	try {
+		_cb_effect  = streamfx::obs::gs::effect::create_shared(path);
+		_cb_sparse  = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_Z24_S8);
+		_cb_history = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	} catch (const std::exception& ex) {
+		DLOG_ERROR("Failed to load '%s', rendering all pixels instead: %s", path.u8string().c_str(), ex.what());
+		checkerboard_unload();
+		_checkerboard = false;
+		return false;
+	}
+
+	// Nothing has been rendered into the history yet.
+	_rt_size = {0, 0};
+	return true;
+}
+
+void streamfx::gfx::shader::shader::checkerboard_unload()
+{
+	_cb_history.reset();
+	_cb_sparse.reset();
+	_cb_effect.reset();
+}
+
+void streamfx::gfx::shader::shader::render_checkerboard(uint32_t width, uint32_t height)
+{
+	// The previous output is what the missing half is reconstructed from, and what Feedback reads.
+	bool history = (_rt_size.first == width) && (_rt_size.second == height);
+	std::swap(_rt, _cb_history);
+	if (_rt_feedback) {
+		_shader_builtins[FEEDBACK].set_texture(_cb_history->get_object());
+	}
+
+	float_t parity = static_cast<float_t>(_cb_frame++ & 1);
+	_cb_effect.get_parameter("imageSize").set_float2(static_cast<float_t>(width), static_cast<float_t>(height));
+	_cb_effect.get_parameter("imageTexel")
+		.set_float2(1.0f / static_cast<float_t>(width), 1.0f / static_cast<float_t>(height));
+	_cb_effect.get_parameter("parity").set_float(parity);
+
+	{ // Shade only the pixels marked in the stencil buffer, which the hardware rejects before running the shader.
+		auto op   = _cb_sparse->render(width, height);
 		vec4 zero = {0, 0, 0, 0};
 		gs_ortho(0, 1, 0, 1, 0, 1);
-		gs_clear(GS_CLEAR_COLOR, &zero, 0, 0);
+		gs_clear(GS_CLEAR_COLOR | GS_CLEAR_STENCIL, &zero, 0, 0);
 
 		gs_blend_state_push();
 		gs_reset_blend_state();
 
+		gs_enable_blending(false);
+		gs_enable_color(false, false, false, false);
+		gs_enable_depth_test(false);
+		gs_enable_stencil_test(true);
+		gs_enable_stencil_write(true);
+		gs_stencil_function(GS_STENCIL_BOTH, GS_ALWAYS);
+		gs_stencil_op(GS_STENCIL_BOTH, GS_KEEP, GS_KEEP, GS_INCR);
+		while (gs_effect_loop(_cb_effect.get_object(), "Mask")) {
+			streamfx::gs_draw_fullscreen_tri();
+		}
+
+		gs_enable_stencil_write(false);
+		gs_stencil_function(GS_STENCIL_BOTH, GS_NOTEQUAL);
+		gs_enable_color(true, true, true, true);
 		gs_enable_blending(true);
 		gs_blend_function_separate(GS_BLEND_ONE, GS_BLEND_ZERO, GS_BLEND_ONE, GS_BLEND_ZERO);
+		render_shader();
+
+		gs_enable_stencil_test(false);
+		gs_blend_state_pop();
+	}
+
+	{ // Resolve
+		auto op = _rt->render(width, height);
+		gs_ortho(0, 1, 0, 1, 0, 1);
+
+		gs_blend_state_push();
+		gs_reset_blend_state();
+		gs_enable_blending(false);
 		gs_enable_color(true, true, true, true);
-		while (gs_effect_loop(_shader.get_object(), _shader_tech.c_str())) {
+
+		_cb_effect.get_parameter("current").set_texture(_cb_sparse->get_object());
+		_cb_effect.get_parameter("previous").set_texture(_cb_history->get_object());
+		_cb_effect.get_parameter("history").set_float(history ? 1.0f : 0.0f);
+		while (gs_effect_loop(_cb_effect.get_object(), "Resolve")) {
 			streamfx::gs_draw_fullscreen_tri();
 		}
 
 		gs_blend_state_pop();
+	}
+}
 
-		_rt_up_to_date = true;
+void streamfx::gfx::shader::shader::render_passes()
+{
+	gs_technique_t* tech = gs_effect_get_technique(_shader.get_object(), _shader_tech.c_str());
+	if (!tech) {
+		return;
 	}
 
-	gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), _rt->get_texture()->get_object());
-	while (gs_effect_loop(effect, "Draw")) {
-		gs_draw_sprite(nullptr, 0, width(), height());
+	std::size_t passes = std::min<std::size_t>(gs_technique_begin(tech), _shader_passes.size());
+	for (std::size_t idx = 0; idx < passes; idx++) {
+		auto& pass = _shader_passes[idx];
+		if (!pass.target) {
+			// Everything else renders into the output, which is already bound.
+			if (gs_technique_begin_pass(tech, idx)) {
+				streamfx::gs_draw_fullscreen_tri();
+				gs_technique_end_pass(tech);
+			}
+			continue;
+		}
+
+		uint32_t w = std::max<uint32_t>(static_cast<uint32_t>(render_width() * pass.scale), 1);
+		uint32_t h = std::max<uint32_t>(static_cast<uint32_t>(render_height() * pass.scale), 1);
+		{
+			auto op   = pass.target->render(w, h);
+			vec4 zero = {0, 0, 0, 0};
+			gs_ortho(0, 1, 0, 1, 0, 1);
+			gs_clear(GS_CLEAR_COLOR, &zero, 0, 0);
+
+			// ViewSize describes the target of the current pass.
+			if (auto& el = _shader_builtins[VIEW_SIZE];
+				el && (el.get_type() == streamfx::obs::gs::effect_parameter::type::Float4)) {
+				el.set_float4(static_cast<float_t>(w), static_cast<float_t>(h), 1.0f / static_cast<float_t>(w),
+							  1.0f / static_cast<float_t>(h));
+			}
+
+			if (gs_technique_begin_pass(tech, idx)) {
+				streamfx::gs_draw_fullscreen_tri();
+				gs_technique_end_pass(tech);
+			}
+		}
+
+		if (pass.input) {
+			pass.input.set_texture(pass.target->get_object());
+		}
+	}
+	gs_technique_end(tech);
+
+	// Restore ViewSize for the passes that render into the output, and for the next frame.
+	if (auto& el = _shader_builtins[VIEW_SIZE];
+		el && (el.get_type() == streamfx::obs::gs::effect_parameter::type::Float4)) {
+		el.set_float4(static_cast<float_t>(render_width()), static_cast<float_t>(render_height()),
+					  1.0f / static_cast<float_t>(render_width()), 1.0f / static_cast<float_t>(render_height()));
 	}
 }
 
 void streamfx::gfx::shader::shader::set_size(uint32_t w, uint32_t h)
 {
+	if ((_base_width != w) || (_base_height != h)) {
+		_rt_up_to_date = false;
+	}
 	_base_width  = w;
 	_base_height = h;
 }
@@ -616,6 +1210,14 @@ void streamfx::gfx::shader::shader::set_transition_size(uint32_t w, uint32_t h)
 	}
 }
 
+void streamfx::gfx::shader::shader::set_visible(bool visible)
+{
+	_visible = visible;
+
+	// Whatever was rendered before hiding is stale by now.
+	_rt_up_to_date = false;
+}
+
 void streamfx::gfx::shader::shader::set_active(bool active)
 {
 	_active = active;
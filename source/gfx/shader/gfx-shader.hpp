@@ -17,13 +17,19 @@
 
 #pragma once
 #include "common.hpp"
+#include <atomic>
 #include <filesystem>
 #include <list>
 #include <map>
+#include <memory>
 #include <random>
+#include <string>
+#include <vector>
 #include "gfx/shader/gfx-shader-param.hpp"
 #include "obs/gs/gs-effect.hpp"
 #include "obs/gs/gs-rendertarget.hpp"
+#include "util/util-file-watcher.hpp"
+#include "util/util-tracking.hpp"
 
 namespace streamfx::gfx {
 	namespace shader {
@@ -48,6 +54,7 @@ namespace streamfx::gfx {
 			uint32_t    _base_width;
 			uint32_t    _base_height;
 			bool        _active;
+			bool        _visible;
 
 			// Shader
 			streamfx::obs::gs::effect       _shader;
@@ -58,11 +65,70 @@ namespace streamfx::gfx {
 			float_t                         _shader_file_tick;
 			shader_param_map_t              _shader_params;
 
+			// Loading, compiled on the thread pool and swapped in by tick() once done. Until then the previous shader
+			// keeps rendering.
+			struct shader_load {
+				std::filesystem::path              file;
+				std::string                        tech;
+				std::filesystem::file_time_type    file_mt;
+				uintmax_t                          file_sz;
+				std::map<std::string, std::string> constants; // Only set to specialize the current shader.
+				streamfx::obs::gs::effect          effect;
+				std::string                        error;
+				std::atomic_bool                   done;
+			};
+			std::shared_ptr<shader_load> _shader_load;
+
+			// Last failed load, which is only retried once the file changes.
+			std::filesystem::path           _shader_error_file;
+			std::filesystem::file_time_type _shader_error_file_mt;
+			uintmax_t                       _shader_error_file_sz;
+			std::string                     _shader_error;
+
+			// Specialization, which compiles hidden parameters that stopped changing into the shader as constants. The
+			// uniform-only shader is kept around to switch back to as soon as any of them changes again, and remains
+			// the source of the parameter list.
+			bool                               _specialize;
+			float_t                            _specialize_time;      // Since the constants last changed.
+			std::map<std::string, std::string> _specialize_constants; // Of the current parameter values.
+			std::map<std::string, std::string> _specialize_failed;
+			std::map<std::string, std::string> _shader_constants; // Compiled into _shader, if specialized.
+			streamfx::obs::gs::effect          _shader_generic;
+
+			// Automatic parameters, resolved once per load.
+			enum builtin_parameter {
+				TIME,
+				VIEW_SIZE,
+				RANDOM,
+				RANDOM_SEED,
+				TRACKED_FACE,
+				FEEDBACK,
+				_BUILTIN_COUNT,
+			};
+			streamfx::obs::gs::effect_parameters<_BUILTIN_COUNT> _shader_builtins;
+			bool                                                 _shader_static; // No builtins that change alone.
+
+			// Passes of the technique. Named passes other than the last one render into an intermediate target, which
+			// later passes read through the texture uniform of the same name.
+			struct shader_pass {
+				streamfx::obs::gs::effect_parameter              input;
+				float_t                                          scale;
+				std::shared_ptr<streamfx::obs::gs::rendertarget> target;
+			};
+			std::vector<shader_pass> _shader_passes;
+
+			// File Watching
+			bool                                                   _shader_file_poll; // Check on every tick instead.
+			std::filesystem::path                                  _shader_file_watched;
+			std::shared_ptr<::streamfx::util::file_watcher::watch> _shader_file_watch;
+
 			// Options
 			size_type _width_type;
 			double_t  _width_value;
 			size_type _height_type;
 			double_t  _height_value;
+			double_t  _render_scale; // Fraction of the output size that the shader actually renders at.
+			bool      _checkerboard; // Shade half of the pixels per frame, and reconstruct the rest.
 
 			// Cache
 			bool            _have_current_params;
@@ -73,9 +139,21 @@ namespace streamfx::gfx {
 			int32_t         _random_seed;
 			float_t _random_values[16]; // 0..4 Per-Instance-Random, 4..8 Per-Activation-Random 9..15 Per-Frame-Random
 
+			// Tracking
+			::streamfx::util::tracking::subscription _tracking;
+
 			// Rendering
 			bool                                             _rt_up_to_date;
+			bool                                             _rt_static; // Result of is_static() on the last tick.
 			std::shared_ptr<streamfx::obs::gs::rendertarget> _rt;
+			std::shared_ptr<streamfx::obs::gs::rendertarget> _rt_feedback; // Previous output, if the shader wants it.
+			std::pair<uint32_t, uint32_t>                    _rt_size;     // Size of the result currently in _rt.
+
+			// Checkerboard Rendering
+			streamfx::obs::gs::effect                        _cb_effect;
+			std::shared_ptr<streamfx::obs::gs::rendertarget> _cb_sparse;  // Half of the pixels, with stencil.
+			std::shared_ptr<streamfx::obs::gs::rendertarget> _cb_history; // Previous output to reconstruct from.
+			uint32_t                                         _cb_frame;
 
 			public:
 			shader(obs_source_t* self, shader_mode mode);
@@ -85,9 +163,19 @@ namespace streamfx::gfx {
 
 			bool is_technique_different(const std::string& tech);
 
+			/** Load a shader, or switch to a different technique of the current one.
+			 *
+			 * A different file is compiled in the background, and only swapped in by a later tick(), so shader_dirty
+			 * is never set by this. The properties are refreshed once the swap happened.
+			 */
 			bool load_shader(const std::filesystem::path& file, const std::string& tech, bool& shader_dirty,
 							 bool& param_dirty);
 
+			/** Whether any shader finished loading yet. Filters pass their input through until then. */
+			bool is_loaded();
+
+			void watch_shader_file(const std::filesystem::path& file);
+
 			static void defaults(obs_data_t* data);
 
 			void properties(obs_properties_t* props);
@@ -110,10 +198,49 @@ namespace streamfx::gfx {
 
 			bool tick(float_t time);
 
+			/** Whether the output only changes when the settings, the size or the inputs do. Such shaders are only
+			 * rendered again when one of those changes, instead of on every frame.
+			 */
+			bool is_static();
+
+			/** The inputs changed, so render again on the next frame even if the shader is static. */
+			void invalidate();
+
 			void prepare_render();
 
 			void render(gs_effect* effect);
 
+			private:
+			void load_shader_async(const std::filesystem::path& file, const std::string& tech);
+
+			void start_load(std::shared_ptr<shader_load> load);
+
+			void apply_shader(shader_load& load);
+
+			void use_shader(streamfx::obs::gs::effect effect, const std::string& tech);
+
+			void specialize();
+
+			void update_specialization();
+
+			void update_parameters(const std::string& tech);
+
+			uint32_t render_width();
+
+			uint32_t render_height();
+
+			void render_passes();
+
+			/** Draw the selected technique into the currently bound target. */
+			void render_shader();
+
+			bool checkerboard_load();
+
+			void checkerboard_unload();
+
+			/** Shade half of the pixels into the sparse target, then resolve them together with the previous output. */
+			void render_checkerboard(uint32_t width, uint32_t height);
+
 			public:
 			void set_size(uint32_t w, uint32_t h);
 
@@ -125,6 +252,8 @@ namespace streamfx::gfx {
 
 			void set_transition_size(uint32_t w, uint32_t h);
 
+			void set_visible(bool visible);
+
 			void set_active(bool active);
 		};
 	} // namespace shader
@@ -18,6 +18,7 @@
  */
 
 #include "nvidia-ar-feature.hpp"
+#include "obs/obs-statistics.hpp"
 
 streamfx::nvidia::ar::feature::feature(std::shared_ptr<::streamfx::nvidia::ar::ar> ar, NvAR_FeatureID feature) : _ar(ar)
 {
@@ -26,10 +27,38 @@ streamfx::nvidia::ar::feature::feature(std::shared_ptr<::streamfx::nvidia::ar::a
 		throw std::runtime_error("Failed to create feature.");
 	}
 
-	_feature = std::shared_ptr<nvAR_Feature>{feat, [this](NvAR_FeatureHandle v) { _ar->destroy(v); }};
+	_feature = std::shared_ptr<nvAR_Feature>{feat, [ar](NvAR_FeatureHandle v) { ar->destroy(v); }};
 }
 
 streamfx::nvidia::ar::feature::~feature()
 {
 	_feature.reset();
 }
+
+NvAR_FeatureHandle streamfx::nvidia::ar::feature::get()
+{
+	return _feature.get();
+}
+
+NvCV_Status streamfx::nvidia::ar::feature::load()
+{
+	// Loads the models, which is what most of the initialization of the SDK is.
+	::streamfx::obs::statistics::load_cost cost{::streamfx::obs::statistics::load_step::SDK};
+	return _ar->load(_feature.get());
+}
+
+NvCV_Status streamfx::nvidia::ar::feature::run()
+{
+	return _ar->run(_feature.get());
+}
+
+NvCV_Status streamfx::nvidia::ar::feature::set_object(std::string name, void* value, std::size_t size)
+{
+	return _ar->set_object(_feature.get(), name.c_str(), value, static_cast<unsigned long>(size));
+}
+
+NvCV_Status streamfx::nvidia::ar::feature::set_float32_array(std::string name, std::float_t* values,
+															 std::size_t count)
+{
+	return _ar->set_float32_array(_feature.get(), name.c_str(), values, static_cast<int32_t>(count));
+}
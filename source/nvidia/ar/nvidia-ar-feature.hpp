@@ -18,6 +18,7 @@
  */
 
 #pragma once
+#include <cstddef>
 #include <string>
 #include "nvidia-ar.hpp"
 #include "nvidia/cuda/nvidia-cuda-stream.hpp"
@@ -31,6 +32,19 @@ namespace streamfx::nvidia::ar {
 		feature(std::shared_ptr<::streamfx::nvidia::ar::ar> ar, NvAR_FeatureID feature);
 		~feature();
 
+		NvAR_FeatureHandle get();
+
+		NvCV_Status load();
+
+		/** Run the feature on its CUDA stream, returning once its outputs have been written. */
+		NvCV_Status run();
+
+		/** Bind an input or output object, such as an NvCVImage or NvAR_BBoxes, which must outlive its use. */
+		NvCV_Status set_object(std::string name, void* value, std::size_t size);
+
+		/** Bind an output array, which is written to by every call to run(). */
+		NvCV_Status set_float32_array(std::string name, std::float_t* values, std::size_t count);
+
 		public:
 		template<typename T>
 		inline NvCV_Status set(std::string name, T value);
@@ -151,6 +165,8 @@ namespace streamfx::nvidia::ar {
 
 		template<>
 		inline NvCV_Status get(std::string name, std::shared_ptr<::streamfx::nvidia::cuda::stream>& value)
-		{}
+		{
+			return NVCV_ERR_UNIMPLEMENTED;
+		}
 	};
 } // namespace streamfx::nvidia::ar
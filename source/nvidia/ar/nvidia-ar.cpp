@@ -21,6 +21,7 @@
 #include <stdexcept>
 #include <util/bmem.h>
 #include <util/platform.h>
+#include "obs/obs-statistics.hpp"
 
 #ifdef WIN32
 #include <Shlobj.h>
@@ -36,6 +37,7 @@
 
 streamfx::nvidia::ar::ar::ar()
 {
+	::streamfx::obs::statistics::load_cost cost{::streamfx::obs::statistics::load_step::SDK};
 	if (!getNvARLib())
 		throw std::runtime_error("Failed to load NVIDIA AR SDK runtime.");
 }
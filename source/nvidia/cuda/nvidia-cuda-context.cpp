@@ -86,6 +86,20 @@ streamfx::nvidia::cuda::context::context(ID3D11Device* device) : context()
 		throw std::runtime_error("Failed to get device index for device.");
 	}
 
+	acquire_primary();
+}
+#endif
+
+streamfx::nvidia::cuda::context::context(::streamfx::nvidia::cuda::device_t device) : context()
+{
+	_device = device;
+	acquire_primary();
+}
+
+void streamfx::nvidia::cuda::context::acquire_primary()
+{
+	using namespace streamfx::nvidia::cuda;
+
 	_cuda->cuDevicePrimaryCtxSetFlags(_device, context_flags::SCHEDULER_BLOCKING_SYNC);
 
 	// Acquire Context
@@ -118,13 +132,17 @@ streamfx::nvidia::cuda::context::context(ID3D11Device* device) : context()
 
 	_has_device = true;
 }
-#endif
 
 ::streamfx::nvidia::cuda::context_t streamfx::nvidia::cuda::context::get()
 {
 	return _ctx;
 }
 
+::streamfx::nvidia::cuda::device_t streamfx::nvidia::cuda::context::device()
+{
+	return _device;
+}
+
 std::shared_ptr<::streamfx::nvidia::cuda::context_stack> streamfx::nvidia::cuda::context::enter()
 {
 	return std::make_shared<::streamfx::nvidia::cuda::context_stack>(shared_from_this());
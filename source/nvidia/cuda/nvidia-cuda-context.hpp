@@ -41,8 +41,14 @@ namespace streamfx::nvidia::cuda {
 		context(ID3D11Device* device);
 #endif
 
+		/** Acquire the primary context of a device, such as one that is not used for rendering.
+		 */
+		context(::streamfx::nvidia::cuda::device_t device);
+
 		::streamfx::nvidia::cuda::context_t get();
 
+		::streamfx::nvidia::cuda::device_t device();
+
 		void push();
 		void pop();
 
@@ -50,6 +56,9 @@ namespace streamfx::nvidia::cuda {
 
 		public:
 		std::shared_ptr<::streamfx::nvidia::cuda::context_stack> enter();
+
+		private:
+		void acquire_primary();
 	};
 
 	class context_stack {
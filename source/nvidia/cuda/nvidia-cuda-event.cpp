@@ -0,0 +1,92 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "nvidia-cuda-event.hpp"
+#include <stdexcept>
+#include "util/util-logging.hpp"
+
+#ifdef _DEBUG
+#define ST_PREFIX "<%s> "
+#define D_LOG_ERROR(x, ...) P_LOG_ERROR(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_WARNING(x, ...) P_LOG_WARN(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_INFO(x, ...) P_LOG_INFO(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_DEBUG(x, ...) P_LOG_DEBUG(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#else
+#define ST_PREFIX "<nvidia::cuda::event> "
+#define D_LOG_ERROR(...) P_LOG_ERROR(ST_PREFIX __VA_ARGS__)
+#define D_LOG_WARNING(...) P_LOG_WARN(ST_PREFIX __VA_ARGS__)
+#define D_LOG_INFO(...) P_LOG_INFO(ST_PREFIX __VA_ARGS__)
+#define D_LOG_DEBUG(...) P_LOG_DEBUG(ST_PREFIX __VA_ARGS__)
+#endif
+
+streamfx::nvidia::cuda::event::~event()
+{
+	D_LOG_DEBUG("Finalizing... (Addr: 0x%" PRIuPTR ")", this);
+
+	_cuda->cuEventDestroy(_event);
+}
+
+streamfx::nvidia::cuda::event::event(::streamfx::nvidia::cuda::event_flags flags)
+	: _cuda(::streamfx::nvidia::cuda::cuda::get()), _event()
+{
+	D_LOG_DEBUG("Initializating... (Addr: 0x%" PRIuPTR ")", this);
+
+	if (auto res = _cuda->cuEventCreate(&_event, flags); res != ::streamfx::nvidia::cuda::result::SUCCESS) {
+		throw std::runtime_error("Failed to create CUevent object.");
+	}
+}
+
+::streamfx::nvidia::cuda::event_t streamfx::nvidia::cuda::event::get()
+{
+	return _event;
+}
+
+void streamfx::nvidia::cuda::event::record(std::shared_ptr<::streamfx::nvidia::cuda::stream> stream)
+{
+	if (auto res = _cuda->cuEventRecord(_event, stream->get()); res != ::streamfx::nvidia::cuda::result::SUCCESS) {
+		throw ::streamfx::nvidia::cuda::cuda_error(res);
+	}
+}
+
+void streamfx::nvidia::cuda::event::wait(std::shared_ptr<::streamfx::nvidia::cuda::stream> stream)
+{
+	if (auto res = _cuda->cuStreamWaitEvent(stream->get(), _event, 0);
+		res != ::streamfx::nvidia::cuda::result::SUCCESS) {
+		throw ::streamfx::nvidia::cuda::cuda_error(res);
+	}
+}
+
+bool streamfx::nvidia::cuda::event::query()
+{
+	switch (auto res = _cuda->cuEventQuery(_event); res) {
+	case ::streamfx::nvidia::cuda::result::SUCCESS:
+		return true;
+	case ::streamfx::nvidia::cuda::result::NOT_READY:
+		return false;
+	default:
+		throw ::streamfx::nvidia::cuda::cuda_error(res);
+	}
+}
+
+void streamfx::nvidia::cuda::event::synchronize()
+{
+	if (auto res = _cuda->cuEventSynchronize(_event); res != ::streamfx::nvidia::cuda::result::SUCCESS) {
+		throw ::streamfx::nvidia::cuda::cuda_error(res);
+	}
+}
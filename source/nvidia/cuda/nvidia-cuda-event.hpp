@@ -0,0 +1,46 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include <memory>
+#include "nvidia-cuda-stream.hpp"
+#include "nvidia-cuda.hpp"
+
+namespace streamfx::nvidia::cuda {
+	class event {
+		std::shared_ptr<::streamfx::nvidia::cuda::cuda> _cuda;
+		::streamfx::nvidia::cuda::event_t               _event;
+
+		public:
+		~event();
+		event(::streamfx::nvidia::cuda::event_flags flags = ::streamfx::nvidia::cuda::event_flags::DISABLE_TIMING);
+
+		::streamfx::nvidia::cuda::event_t get();
+
+		void record(std::shared_ptr<::streamfx::nvidia::cuda::stream> stream);
+
+		/** Make all further work on a stream wait for the last record(), which may be on another device.
+		 */
+		void wait(std::shared_ptr<::streamfx::nvidia::cuda::stream> stream);
+
+		bool query();
+
+		void synchronize();
+	};
+} // namespace streamfx::nvidia::cuda
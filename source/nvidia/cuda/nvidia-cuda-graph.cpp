@@ -0,0 +1,96 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "nvidia-cuda-graph.hpp"
+#include <stdexcept>
+#include "util/util-logging.hpp"
+
+#ifdef _DEBUG
+#define ST_PREFIX "<%s> "
+#define D_LOG_ERROR(x, ...) P_LOG_ERROR(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_WARNING(x, ...) P_LOG_WARN(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_INFO(x, ...) P_LOG_INFO(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_DEBUG(x, ...) P_LOG_DEBUG(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#else
+#define ST_PREFIX "<nvidia::cuda::graph> "
+#define D_LOG_ERROR(...) P_LOG_ERROR(ST_PREFIX __VA_ARGS__)
+#define D_LOG_WARNING(...) P_LOG_WARN(ST_PREFIX __VA_ARGS__)
+#define D_LOG_INFO(...) P_LOG_INFO(ST_PREFIX __VA_ARGS__)
+#define D_LOG_DEBUG(...) P_LOG_DEBUG(ST_PREFIX __VA_ARGS__)
+#endif
+
+streamfx::nvidia::cuda::graph::~graph()
+{
+	D_LOG_DEBUG("Finalizing... (Addr: 0x%" PRIuPTR ")", this);
+
+	_cuda->cuGraphExecDestroy(_graph);
+}
+
+streamfx::nvidia::cuda::graph::graph(std::shared_ptr<::streamfx::nvidia::cuda::stream> stream,
+									 std::function<void()>                             work)
+	: _cuda(::streamfx::nvidia::cuda::cuda::get()), _graph()
+{
+	D_LOG_DEBUG("Initializating... (Addr: 0x%" PRIuPTR ")", this);
+
+	if (!is_available()) {
+		throw std::runtime_error("CUDA Graphs are not supported by the installed driver.");
+	}
+
+	// Other threads may keep using CUDA freely, only this thread is restricted while recording.
+	if (auto res =
+			_cuda->cuStreamBeginCapture(stream->get(), ::streamfx::nvidia::cuda::stream_capture_mode::THREAD_LOCAL);
+		res != ::streamfx::nvidia::cuda::result::SUCCESS) {
+		throw ::streamfx::nvidia::cuda::cuda_error(res);
+	}
+
+	::streamfx::nvidia::cuda::graph_t graph = nullptr;
+	try {
+		work();
+	} catch (...) {
+		// Always end the recording, as the stream is unusable otherwise.
+		if (_cuda->cuStreamEndCapture(stream->get(), &graph) == ::streamfx::nvidia::cuda::result::SUCCESS) {
+			_cuda->cuGraphDestroy(graph);
+		}
+		throw;
+	}
+
+	if (auto res = _cuda->cuStreamEndCapture(stream->get(), &graph); res != ::streamfx::nvidia::cuda::result::SUCCESS) {
+		throw ::streamfx::nvidia::cuda::cuda_error(res);
+	}
+
+	auto res = _cuda->cuGraphInstantiateWithFlags(&_graph, graph, 0);
+	_cuda->cuGraphDestroy(graph);
+	if (res != ::streamfx::nvidia::cuda::result::SUCCESS) {
+		throw ::streamfx::nvidia::cuda::cuda_error(res);
+	}
+}
+
+void streamfx::nvidia::cuda::graph::launch(std::shared_ptr<::streamfx::nvidia::cuda::stream> stream)
+{
+	if (auto res = _cuda->cuGraphLaunch(_graph, stream->get()); res != ::streamfx::nvidia::cuda::result::SUCCESS) {
+		throw ::streamfx::nvidia::cuda::cuda_error(res);
+	}
+}
+
+bool streamfx::nvidia::cuda::graph::is_available()
+{
+	auto cuda = ::streamfx::nvidia::cuda::cuda::get();
+	return cuda->cuStreamBeginCapture && cuda->cuStreamEndCapture && cuda->cuGraphDestroy && cuda->cuGraphExecDestroy
+		   && cuda->cuGraphInstantiateWithFlags && cuda->cuGraphLaunch;
+}
@@ -0,0 +1,45 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include <functional>
+#include <memory>
+#include "nvidia-cuda-stream.hpp"
+#include "nvidia-cuda.hpp"
+
+namespace streamfx::nvidia::cuda {
+	/** Work recorded from a stream once, which can then be replayed with a single launch.
+	 *
+	 * Only work queued by the calling thread is recorded, and nothing of it is executed while recording. Work that
+	 * can't be recorded, like synchronizing or allocating memory, makes the recording fail.
+	 */
+	class graph {
+		std::shared_ptr<::streamfx::nvidia::cuda::cuda> _cuda;
+		::streamfx::nvidia::cuda::graph_exec_t          _graph;
+
+		public:
+		~graph();
+		graph(std::shared_ptr<::streamfx::nvidia::cuda::stream> stream, std::function<void()> work);
+
+		void launch(std::shared_ptr<::streamfx::nvidia::cuda::stream> stream);
+
+		public:
+		static bool is_available();
+	};
+} // namespace streamfx::nvidia::cuda
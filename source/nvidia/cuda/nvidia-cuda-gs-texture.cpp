@@ -142,3 +142,49 @@ std::shared_ptr<streamfx::obs::gs::texture> streamfx::nvidia::cuda::gstexture::g
 {
 	return _resource;
 }
+
+streamfx::nvidia::cuda::gstexture_cache::~gstexture_cache() {}
+
+streamfx::nvidia::cuda::gstexture_cache::gstexture_cache() : _lock(), _textures() {}
+
+std::shared_ptr<::streamfx::nvidia::cuda::gstexture>
+	streamfx::nvidia::cuda::gstexture_cache::get(std::shared_ptr<streamfx::obs::gs::texture> texture)
+{
+	if (!texture)
+		throw std::invalid_argument("texture");
+
+	std::unique_lock<std::mutex> lock(_lock);
+
+	// Forget registrations nobody uses anymore, as their texture may be gone and its address reused.
+	for (auto it = _textures.begin(); it != _textures.end();) {
+		if (it->second.expired()) {
+			it = _textures.erase(it);
+		} else {
+			it++;
+		}
+	}
+
+	if (auto kv = _textures.find(texture->get_object()); kv != _textures.end()) {
+		if (auto registered = kv->second.lock(); registered) {
+			return registered;
+		}
+	}
+
+	auto registered = std::make_shared<::streamfx::nvidia::cuda::gstexture>(texture);
+	_textures.insert_or_assign(texture->get_object(), registered);
+	return registered;
+}
+
+std::shared_ptr<::streamfx::nvidia::cuda::gstexture_cache> streamfx::nvidia::cuda::gstexture_cache::instance()
+{
+	static std::weak_ptr<::streamfx::nvidia::cuda::gstexture_cache> instance;
+	static std::mutex                                                lock;
+
+	std::unique_lock<std::mutex> ul(lock);
+	if (instance.expired()) {
+		auto hard_instance = std::make_shared<::streamfx::nvidia::cuda::gstexture_cache>();
+		instance           = hard_instance;
+		return hard_instance;
+	}
+	return instance.lock();
+}
@@ -19,7 +19,9 @@
 
 #pragma once
 #include <cstddef>
+#include <map>
 #include <memory>
+#include <mutex>
 #include "nvidia-cuda-stream.hpp"
 #include "nvidia-cuda.hpp"
 #include "obs/gs/gs-texture.hpp"
@@ -44,4 +46,23 @@ namespace streamfx::nvidia::cuda {
 		std::shared_ptr<streamfx::obs::gs::texture>   get_texture();
 		::streamfx::nvidia::cuda::graphics_resource_t get();
 	};
+
+	/** Keeps textures registered with CUDA for as long as anyone uses them, keyed by the underlying gs_texture_t.
+	 *
+	 * Registering a resource is expensive, and a resource may only be registered once, so everyone working on the
+	 * same texture shares a single registration instead.
+	 */
+	class gstexture_cache {
+		std::mutex                                                                  _lock;
+		std::map<gs_texture_t*, std::weak_ptr<::streamfx::nvidia::cuda::gstexture>> _textures;
+
+		public:
+		~gstexture_cache();
+		gstexture_cache();
+
+		std::shared_ptr<::streamfx::nvidia::cuda::gstexture> get(std::shared_ptr<streamfx::obs::gs::texture> texture);
+
+		public:
+		static std::shared_ptr<::streamfx::nvidia::cuda::gstexture_cache> instance();
+	};
 } // namespace streamfx::nvidia::cuda
@@ -0,0 +1,82 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "nvidia-cuda-host-memory.hpp"
+#include <stdexcept>
+#include "util/util-logging.hpp"
+
+#ifdef _DEBUG
+#define ST_PREFIX "<%s> "
+#define D_LOG_ERROR(x, ...) P_LOG_ERROR(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_WARNING(x, ...) P_LOG_WARN(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_INFO(x, ...) P_LOG_INFO(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_DEBUG(x, ...) P_LOG_DEBUG(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#else
+#define ST_PREFIX "<nvidia::cuda::host_memory> "
+#define D_LOG_ERROR(...) P_LOG_ERROR(ST_PREFIX __VA_ARGS__)
+#define D_LOG_WARNING(...) P_LOG_WARN(ST_PREFIX __VA_ARGS__)
+#define D_LOG_INFO(...) P_LOG_INFO(ST_PREFIX __VA_ARGS__)
+#define D_LOG_DEBUG(...) P_LOG_DEBUG(ST_PREFIX __VA_ARGS__)
+#endif
+
+// Usable from every context, not just the one that allocated it.
+#define ST_CU_MEMHOSTALLOC_PORTABLE 0x01
+
+streamfx::nvidia::cuda::host_memory::~host_memory()
+{
+	D_LOG_DEBUG("Finalizing... (Addr: 0x%" PRIuPTR ")", this);
+
+	auto stack = _context->enter();
+	_cuda->cuMemFreeHost(_pointer);
+}
+
+streamfx::nvidia::cuda::host_memory::host_memory(std::shared_ptr<::streamfx::nvidia::cuda::context> context,
+												 std::size_t                                        size)
+	: _cuda(::streamfx::nvidia::cuda::cuda::get()), _context(context), _pointer(), _size(size)
+{
+	D_LOG_DEBUG("Initializating... (Addr: 0x%" PRIuPTR ")", this);
+
+	if (!is_available()) {
+		throw std::runtime_error("nvidia::cuda::host_memory: Page-locked memory is not supported.");
+	}
+
+	auto stack = _context->enter();
+	switch (_cuda->cuMemHostAlloc(&_pointer, _size, ST_CU_MEMHOSTALLOC_PORTABLE)) {
+	case ::streamfx::nvidia::cuda::result::SUCCESS:
+		break;
+	default:
+		throw std::runtime_error("nvidia::cuda::host_memory: cuMemHostAlloc failed.");
+	}
+}
+
+void* streamfx::nvidia::cuda::host_memory::get()
+{
+	return _pointer;
+}
+
+std::size_t streamfx::nvidia::cuda::host_memory::size()
+{
+	return _size;
+}
+
+bool streamfx::nvidia::cuda::host_memory::is_available()
+{
+	auto cuda = ::streamfx::nvidia::cuda::cuda::get();
+	return cuda->cuMemHostAlloc && cuda->cuMemFreeHost;
+}
@@ -0,0 +1,48 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include <cstddef>
+#include <memory>
+#include "nvidia-cuda-context.hpp"
+#include "nvidia-cuda.hpp"
+
+namespace streamfx::nvidia::cuda {
+	/** Page-locked system memory, which the GPU can copy from and to directly instead of through a staging copy.
+	 *
+	 * Copies from and to it are truly asynchronous, so it must not be touched until they are complete.
+	 */
+	class host_memory {
+		std::shared_ptr<::streamfx::nvidia::cuda::cuda>    _cuda;
+		std::shared_ptr<::streamfx::nvidia::cuda::context> _context;
+		void*                                              _pointer;
+		std::size_t                                        _size;
+
+		public:
+		~host_memory();
+		host_memory(std::shared_ptr<::streamfx::nvidia::cuda::context> context, std::size_t size);
+
+		void* get();
+
+		std::size_t size();
+
+		public:
+		static bool is_available();
+	};
+} // namespace streamfx::nvidia::cuda
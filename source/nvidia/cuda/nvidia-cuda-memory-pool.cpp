@@ -0,0 +1,201 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "nvidia-cuda-memory-pool.hpp"
+#include <stdexcept>
+#include "util/util-logging.hpp"
+
+#ifdef _DEBUG
+#define ST_PREFIX "<%s> "
+#define D_LOG_ERROR(x, ...) P_LOG_ERROR(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_WARNING(x, ...) P_LOG_WARN(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_INFO(x, ...) P_LOG_INFO(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_DEBUG(x, ...) P_LOG_DEBUG(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#else
+#define ST_PREFIX "<nvidia::cuda::memory_pool> "
+#define D_LOG_ERROR(...) P_LOG_ERROR(ST_PREFIX __VA_ARGS__)
+#define D_LOG_WARNING(...) P_LOG_WARN(ST_PREFIX __VA_ARGS__)
+#define D_LOG_INFO(...) P_LOG_INFO(ST_PREFIX __VA_ARGS__)
+#define D_LOG_DEBUG(...) P_LOG_DEBUG(ST_PREFIX __VA_ARGS__)
+#endif
+
+// Smallest bucket, anything below is rounded up to it.
+static constexpr std::size_t minimum_bucket = 64ull << 10;
+
+/** Round a size up to its bucket.
+ *
+ * Buckets are spaced at a quarter of the next lower power of two, which keeps the waste below 25%.
+ */
+static std::size_t bucket_size(std::size_t size)
+{
+	if (size <= minimum_bucket) {
+		return minimum_bucket;
+	}
+
+	std::size_t power = minimum_bucket;
+	while ((power << 1) <= size) {
+		power <<= 1;
+	}
+	std::size_t step = power >> 2;
+	return ((size + step - 1) / step) * step;
+}
+
+streamfx::nvidia::cuda::memory_pool::~memory_pool()
+{
+	D_LOG_DEBUG("Finalizing... (Addr: 0x%" PRIuPTR ")", this);
+
+	trim();
+}
+
+streamfx::nvidia::cuda::memory_pool::memory_pool(std::shared_ptr<::streamfx::nvidia::cuda::context> context,
+												  std::size_t                                        limit)
+	: _cuda(::streamfx::nvidia::cuda::cuda::get()), _context(context), _lock(), _free(), _free_size(0),
+	  _free_limit(limit)
+{
+	D_LOG_DEBUG("Initializating... (Addr: 0x%" PRIuPTR ")", this);
+
+	if (!_cuda->cuMemAllocAsync || !_cuda->cuMemFreeAsync) {
+		D_LOG_INFO("Stream ordered allocation is not supported by the driver, using synchronous allocation.", 0);
+	}
+}
+
+std::shared_ptr<::streamfx::nvidia::cuda::memory>
+	streamfx::nvidia::cuda::memory_pool::allocate(std::size_t                                       size,
+												  std::shared_ptr<::streamfx::nvidia::cuda::stream> stream)
+{
+	auto         cctx    = _context->enter();
+	std::size_t  bucket  = bucket_size(size);
+	device_ptr_t pointer = 0;
+
+	auto wrap = [this, bucket, stream](device_ptr_t pointer) {
+		std::weak_ptr<::streamfx::nvidia::cuda::memory_pool> weak = weak_from_this();
+		return std::make_shared<::streamfx::nvidia::cuda::memory>(
+			pointer, bucket, [weak, stream](device_ptr_t pointer, std::size_t size) {
+				if (auto self = weak.lock(); self) {
+					self->release(pointer, size, stream);
+				} else {
+					::streamfx::nvidia::cuda::cuda::get()->cuMemFree(pointer);
+				}
+			});
+	};
+
+	{ // Try to reuse an earlier allocation.
+		std::unique_lock<std::mutex> lock(_lock);
+		if (auto kv = _free.find(bucket); (kv != _free.end()) && !kv->second.empty()) {
+			block entry = kv->second.back();
+			kv->second.pop_back();
+			_free_size -= entry.size;
+			lock.unlock();
+
+			// Order this use after the previous one, unless the stream already guarantees it.
+			if (entry.stream != stream) {
+				if (auto res = _cuda->cuStreamWaitEvent(stream->get(), entry.released->get(), 0);
+					res != ::streamfx::nvidia::cuda::result::SUCCESS) {
+					entry.released->synchronize();
+				}
+			}
+
+			return wrap(entry.pointer);
+		}
+	}
+
+	auto allocate = [this, bucket, &stream](device_ptr_t* pointer) {
+		if (_cuda->cuMemAllocAsync) {
+			return _cuda->cuMemAllocAsync(pointer, bucket, stream->get());
+		} else {
+			return _cuda->cuMemAlloc(pointer, bucket);
+		}
+	};
+
+	auto res = allocate(&pointer);
+	if (res == ::streamfx::nvidia::cuda::result::OUT_OF_MEMORY) {
+		// Give back everything we hold on to, and try again.
+		D_LOG_WARNING("Out of memory allocating %zu bytes, releasing %zu cached bytes.", bucket, cached());
+		trim();
+		res = allocate(&pointer);
+	}
+	if (res != ::streamfx::nvidia::cuda::result::SUCCESS) {
+		throw ::streamfx::nvidia::cuda::cuda_error(res);
+	}
+
+	return wrap(pointer);
+}
+
+void streamfx::nvidia::cuda::memory_pool::trim()
+{
+	std::map<std::size_t, std::vector<block>> blocks;
+	{
+		std::unique_lock<std::mutex> lock(_lock);
+		std::swap(blocks, _free);
+		_free_size = 0;
+	}
+
+	auto cctx = _context->enter();
+	for (auto& kv : blocks) {
+		for (auto& entry : kv.second) {
+			free(entry);
+		}
+	}
+}
+
+std::size_t streamfx::nvidia::cuda::memory_pool::cached()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	return _free_size;
+}
+
+void streamfx::nvidia::cuda::memory_pool::release(device_ptr_t pointer, std::size_t size,
+												  std::shared_ptr<::streamfx::nvidia::cuda::stream> stream)
+{
+	auto cctx = _context->enter();
+
+	block entry{pointer, size, stream, nullptr};
+	try {
+		entry.released = std::make_shared<::streamfx::nvidia::cuda::event>();
+		entry.released->record(stream);
+	} catch (...) {
+		// Without an event there is no way to order later users, so wait for the stream instead.
+		stream->synchronize();
+		_cuda->cuMemFree(pointer);
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(_lock);
+		if ((_free_size + size) <= _free_limit) {
+			_free[size].push_back(entry);
+			_free_size += size;
+			return;
+		}
+	}
+
+	// The cache is full, so this one has to go.
+	free(entry);
+}
+
+void streamfx::nvidia::cuda::memory_pool::free(block& entry)
+{
+	auto cctx = _context->enter();
+	if (_cuda->cuMemFreeAsync) {
+		_cuda->cuMemFreeAsync(entry.pointer, entry.stream->get());
+	} else {
+		entry.released->synchronize();
+		_cuda->cuMemFree(entry.pointer);
+	}
+}
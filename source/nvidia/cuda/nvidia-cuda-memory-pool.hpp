@@ -0,0 +1,78 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "nvidia-cuda-context.hpp"
+#include "nvidia-cuda-event.hpp"
+#include "nvidia-cuda-memory.hpp"
+#include "nvidia-cuda-stream.hpp"
+#include "nvidia-cuda.hpp"
+
+namespace streamfx::nvidia::cuda {
+	/** Size-bucketed cache of device memory, shared by everything that runs on the same context.
+	 *
+	 * Released memory is kept around and handed out again for requests of the same bucket, so resizing sources no
+	 * longer stalls on allocations or fragments device memory. Memory is stream-ordered: it may only be used on the
+	 * stream it was allocated for, and later users on other streams are ordered after the last use automatically.
+	 */
+	class memory_pool : public std::enable_shared_from_this<::streamfx::nvidia::cuda::memory_pool> {
+		struct block {
+			device_ptr_t                                      pointer;
+			std::size_t                                       size;
+			std::shared_ptr<::streamfx::nvidia::cuda::stream> stream;
+			std::shared_ptr<::streamfx::nvidia::cuda::event>  released;
+		};
+
+		std::shared_ptr<::streamfx::nvidia::cuda::cuda>    _cuda;
+		std::shared_ptr<::streamfx::nvidia::cuda::context> _context;
+
+		std::mutex                                _lock;
+		std::map<std::size_t, std::vector<block>> _free;
+		std::size_t                               _free_size;
+		std::size_t                               _free_limit;
+
+		public:
+		~memory_pool();
+		memory_pool(std::shared_ptr<::streamfx::nvidia::cuda::context> context, std::size_t limit = 512ull << 20);
+
+		/** Allocate at least size bytes for use on stream.
+		 */
+		std::shared_ptr<::streamfx::nvidia::cuda::memory>
+			allocate(std::size_t size, std::shared_ptr<::streamfx::nvidia::cuda::stream> stream);
+
+		/** Free all memory that is currently not in use.
+		 */
+		void trim();
+
+		/** Amount of memory currently cached for reuse, in bytes.
+		 */
+		std::size_t cached();
+
+		private:
+		void release(device_ptr_t pointer, std::size_t size,
+					 std::shared_ptr<::streamfx::nvidia::cuda::stream> stream);
+
+		void free(block& block);
+	};
+} // namespace streamfx::nvidia::cuda
@@ -39,11 +39,15 @@ streamfx::nvidia::cuda::memory::~memory()
 {
 	D_LOG_DEBUG("Finalizing... (Addr: 0x%" PRIuPTR ")", this);
 
-	_cuda->cuMemFree(_pointer);
+	if (_release) {
+		_release(_pointer, _size);
+	} else {
+		_cuda->cuMemFree(_pointer);
+	}
 }
 
 streamfx::nvidia::cuda::memory::memory(size_t size)
-	: _cuda(::streamfx::nvidia::cuda::cuda::get()), _pointer(), _size(size)
+	: _cuda(::streamfx::nvidia::cuda::cuda::get()), _pointer(), _size(size), _release()
 {
 	D_LOG_DEBUG("Initializating... (Addr: 0x%" PRIuPTR ")", this);
 
@@ -56,6 +60,13 @@ streamfx::nvidia::cuda::memory::memory(size_t size)
 	}
 }
 
+streamfx::nvidia::cuda::memory::memory(device_ptr_t pointer, std::size_t size,
+									   std::function<void(device_ptr_t, std::size_t)> release)
+	: _cuda(::streamfx::nvidia::cuda::cuda::get()), _pointer(pointer), _size(size), _release(release)
+{
+	D_LOG_DEBUG("Initializating... (Addr: 0x%" PRIuPTR ")", this);
+}
+
 streamfx::nvidia::cuda::device_ptr_t streamfx::nvidia::cuda::memory::get()
 {
 	return _pointer;
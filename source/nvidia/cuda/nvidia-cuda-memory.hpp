@@ -19,6 +19,7 @@
 
 #pragma once
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include "nvidia-cuda.hpp"
 
@@ -28,10 +29,18 @@ namespace streamfx::nvidia::cuda {
 		device_ptr_t                                    _pointer;
 		size_t                                          _size;
 
+		std::function<void(device_ptr_t, std::size_t)> _release;
+
 		public:
 		~memory();
 		memory(size_t size);
 
+		/** Wrap memory owned by someone else, such as a memory_pool.
+		 *
+		 * @param release Called with the pointer and size instead of freeing the memory on destruction.
+		 */
+		memory(device_ptr_t pointer, std::size_t size, std::function<void(device_ptr_t, std::size_t)> release);
+
 		device_ptr_t get();
 
 		std::size_t size();
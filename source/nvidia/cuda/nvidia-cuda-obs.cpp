@@ -19,6 +19,7 @@
 
 #include "nvidia-cuda-obs.hpp"
 #include "obs/gs/gs-helper.hpp"
+#include "obs/obs-statistics.hpp"
 #include "util/util-logging.hpp"
 
 #ifdef _DEBUG
@@ -35,6 +36,9 @@
 #define D_LOG_DEBUG(...) P_LOG_DEBUG(ST_PREFIX __VA_ARGS__)
 #endif
 
+// Number of streams handed out by get_worker_stream().
+static constexpr std::size_t worker_streams = 4;
+
 streamfx::nvidia::cuda::obs::~obs()
 {
 	D_LOG_DEBUG("Finalizing... (Addr: 0x%" PRIuPTR ")", this);
@@ -43,14 +47,22 @@ streamfx::nvidia::cuda::obs::~obs()
 	{
 		auto stack = _context->enter();
 		_stream->synchronize();
+		for (auto& stream : _streams) {
+			stream->synchronize();
+		}
 		_context->synchronize();
+		_memory_pool.reset();
+		_streams.clear();
 		_stream.reset();
 	}
+	_inference.clear();
 	_context.reset();
 	_cuda.reset();
 }
 
-streamfx::nvidia::cuda::obs::obs() : _cuda(::streamfx::nvidia::cuda::cuda::get()), _context()
+streamfx::nvidia::cuda::obs::obs()
+	: _cuda(::streamfx::nvidia::cuda::cuda::get()), _context(), _stream(), _memory_pool(), _streams(), _streams_next(0),
+	  _inference_lock(), _inference()
 {
 	D_LOG_DEBUG("Initializating... (Addr: 0x%" PRIuPTR ")", this);
 
@@ -70,6 +82,14 @@ streamfx::nvidia::cuda::obs::obs() : _cuda(::streamfx::nvidia::cuda::cuda::get()
 	// Create Stream
 	auto stack = _context->enter();
 	_stream    = std::make_shared<::streamfx::nvidia::cuda::stream>();
+
+	// Create the shared memory and stream pools.
+	_memory_pool = std::make_shared<::streamfx::nvidia::cuda::memory_pool>(_context);
+	_streams.reserve(worker_streams);
+	for (std::size_t idx = 0; idx < worker_streams; idx++) {
+		_streams.push_back(std::make_shared<::streamfx::nvidia::cuda::stream>(
+			::streamfx::nvidia::cuda::stream_flags::NON_BLOCKING, 0));
+	}
 }
 
 std::shared_ptr<streamfx::nvidia::cuda::obs> streamfx::nvidia::cuda::obs::get()
@@ -79,6 +99,7 @@ std::shared_ptr<streamfx::nvidia::cuda::obs> streamfx::nvidia::cuda::obs::get()
 
 	std::unique_lock<std::mutex> ul(lock);
 	if (instance.expired()) {
+		::streamfx::obs::statistics::load_cost       cost{::streamfx::obs::statistics::load_step::SDK};
 		std::shared_ptr<streamfx::nvidia::cuda::obs> hard_instance;
 		hard_instance = std::make_shared<streamfx::nvidia::cuda::obs>();
 		instance      = hard_instance;
@@ -101,3 +122,80 @@ std::shared_ptr<streamfx::nvidia::cuda::stream> streamfx::nvidia::cuda::obs::get
 {
 	return _stream;
 }
+
+std::shared_ptr<streamfx::nvidia::cuda::memory_pool> streamfx::nvidia::cuda::obs::get_memory_pool()
+{
+	return _memory_pool;
+}
+
+std::shared_ptr<streamfx::nvidia::cuda::stream> streamfx::nvidia::cuda::obs::get_worker_stream()
+{
+	return _streams[_streams_next.fetch_add(1) % _streams.size()];
+}
+
+std::vector<std::string> streamfx::nvidia::cuda::obs::get_devices()
+{
+	std::vector<std::string> devices;
+
+	int32_t count = 0;
+	if (_cuda->cuDeviceGetCount(&count) != ::streamfx::nvidia::cuda::result::SUCCESS) {
+		return devices;
+	}
+
+	devices.reserve(static_cast<std::size_t>(count));
+	for (int32_t idx = 0; idx < count; idx++) {
+		::streamfx::nvidia::cuda::device_t device;
+		std::vector<char>                  name(256, 0);
+		if (_cuda->cuDeviceGet(&device, idx) == ::streamfx::nvidia::cuda::result::SUCCESS) {
+			_cuda->cuDeviceGetName(name.data(), static_cast<int32_t>(name.size() - 1), device);
+		}
+		devices.emplace_back(name.data());
+	}
+
+	return devices;
+}
+
+std::shared_ptr<streamfx::nvidia::cuda::context> streamfx::nvidia::cuda::obs::get_inference_context(int32_t device)
+{
+	if ((device < 0) || (device == _context->device())) {
+		return _context;
+	}
+
+	std::unique_lock<std::mutex> ul(_inference_lock);
+	if (auto kv = _inference.find(device); kv != _inference.end()) {
+		if (auto ctx = kv->second.lock(); ctx) {
+			return ctx;
+		}
+	}
+
+	::streamfx::nvidia::cuda::device_t cu_device;
+	if (_cuda->cuDeviceGet(&cu_device, device) != ::streamfx::nvidia::cuda::result::SUCCESS) {
+		throw std::invalid_argument("device");
+	}
+	auto ctx = std::make_shared<::streamfx::nvidia::cuda::context>(cu_device);
+
+	// Without peer access, the driver stages every copy between the two devices through host memory.
+	int32_t can_access = 0;
+	if (_cuda->cuDeviceCanAccessPeer && _cuda->cuCtxEnablePeerAccess
+		&& (_cuda->cuDeviceCanAccessPeer(&can_access, _context->device(), cu_device)
+			== ::streamfx::nvidia::cuda::result::SUCCESS)
+		&& (can_access != 0)) {
+		{
+			auto stack = _context->enter();
+			_cuda->cuCtxEnablePeerAccess(ctx->get(), 0);
+		}
+		{
+			auto stack = ctx->enter();
+			_cuda->cuCtxEnablePeerAccess(_context->get(), 0);
+		}
+		D_LOG_INFO("Enabled peer access between device %" PRId32 " and device %" PRId32 ".", _context->device(),
+				   device);
+	} else {
+		D_LOG_WARNING("Device %" PRId32 " can't access device %" PRId32 " directly, copies will be staged through "
+					  "host memory.",
+					  _context->device(), device);
+	}
+
+	_inference[device] = ctx;
+	return ctx;
+}
@@ -18,8 +18,14 @@
  */
 
 #pragma once
+#include <atomic>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "nvidia-cuda-context.hpp"
+#include "nvidia-cuda-memory-pool.hpp"
 #include "nvidia-cuda-stream.hpp"
 #include "nvidia-cuda.hpp"
 
@@ -29,6 +35,13 @@ namespace streamfx::nvidia::cuda {
 		std::shared_ptr<::streamfx::nvidia::cuda::context> _context;
 		std::shared_ptr<::streamfx::nvidia::cuda::stream>  _stream;
 
+		std::shared_ptr<::streamfx::nvidia::cuda::memory_pool>         _memory_pool;
+		std::vector<std::shared_ptr<::streamfx::nvidia::cuda::stream>> _streams;
+		std::atomic<std::size_t>                                       _streams_next;
+
+		std::mutex                                                          _inference_lock;
+		std::map<int32_t, std::weak_ptr<::streamfx::nvidia::cuda::context>> _inference;
+
 		public:
 		~obs();
 		obs();
@@ -37,6 +50,26 @@ namespace streamfx::nvidia::cuda {
 		std::shared_ptr<::streamfx::nvidia::cuda::context> get_context();
 		std::shared_ptr<::streamfx::nvidia::cuda::stream>  get_stream();
 
+		std::shared_ptr<::streamfx::nvidia::cuda::memory_pool> get_memory_pool();
+
+		/** Get one of a small set of non-blocking streams for work that should not wait on get_stream().
+		 *
+		 * Streams are handed out round-robin, so they may be shared with other users.
+		 */
+		std::shared_ptr<::streamfx::nvidia::cuda::stream> get_worker_stream();
+
+		/** Names of all CUDA devices, indexed by their ordinal.
+		 */
+		std::vector<std::string> get_devices();
+
+		/** Get a context for running inference on a device other than the one OBS renders with.
+		 *
+		 * Returns get_context() for a negative ordinal or the rendering device itself. Otherwise peer access is
+		 * enabled in both directions if supported, so that buffers can be copied between the two devices directly
+		 * instead of through host memory.
+		 */
+		std::shared_ptr<::streamfx::nvidia::cuda::context> get_inference_context(int32_t device);
+
 		public:
 		static std::shared_ptr<::streamfx::nvidia::cuda::obs> get();
 	};
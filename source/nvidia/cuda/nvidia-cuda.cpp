@@ -19,6 +19,7 @@
 
 #include "nvidia-cuda.hpp"
 #include <mutex>
+#include "obs/obs-statistics.hpp"
 #include "util/util-logging.hpp"
 
 #ifdef _DEBUG
@@ -114,6 +115,8 @@ streamfx::nvidia::cuda::cuda::cuda() : _library()
 
 	{ // 3. Load remaining functions.
 		// Device Management
+		P_CUDA_LOAD_SYMBOL(cuDeviceGet);
+		P_CUDA_LOAD_SYMBOL(cuDeviceGetCount);
 		P_CUDA_LOAD_SYMBOL(cuDeviceGetName);
 		P_CUDA_LOAD_SYMBOL(cuDeviceGetLuid);
 		P_CUDA_LOAD_SYMBOL(cuDeviceGetUuid);
@@ -133,6 +136,10 @@ streamfx::nvidia::cuda::cuda::cuda() : _library()
 		P_CUDA_LOAD_SYMBOL(cuCtxGetStreamPriorityRange);
 		P_CUDA_LOAD_SYMBOL(cuCtxSynchronize);
 
+		// Peer Context Memory Access
+		P_CUDA_LOAD_SYMBOL_OPT(cuDeviceCanAccessPeer);
+		P_CUDA_LOAD_SYMBOL_OPT(cuCtxEnablePeerAccess);
+
 		// Module Management
 		// - Not yet needed.
 
@@ -157,12 +164,16 @@ streamfx::nvidia::cuda::cuda::cuda() : _library()
 		P_CUDA_LOAD_SYMBOL_OPT_V2(cuMemcpyHtoD);
 		P_CUDA_LOAD_SYMBOL_OPT_V2(cuMemcpyHtoDAsync);
 		P_CUDA_LOAD_SYMBOL_OPT_V2(cuMemHostGetDevicePointer);
+		P_CUDA_LOAD_SYMBOL_OPT(cuMemHostAlloc);
+		P_CUDA_LOAD_SYMBOL_OPT(cuMemFreeHost);
+		P_CUDA_LOAD_SYMBOL_OPT_V2(cuMemGetInfo);
 
 		// Virtual Memory Management
 		// - Not yet needed.
 
-		// Stream Ordered Memory Allocator
-		// - Not yet needed.
+		// Stream Ordered Memory Allocator (CUDA 11.2+)
+		P_CUDA_LOAD_SYMBOL_OPT(cuMemAllocAsync);
+		P_CUDA_LOAD_SYMBOL_OPT(cuMemFreeAsync);
 
 		// Unified Addressing
 		// - Not yet needed.
@@ -173,9 +184,16 @@ streamfx::nvidia::cuda::cuda::cuda() : _library()
 		P_CUDA_LOAD_SYMBOL(cuStreamSynchronize);
 		P_CUDA_LOAD_SYMBOL_OPT(cuStreamCreateWithPriority);
 		P_CUDA_LOAD_SYMBOL_OPT(cuStreamGetPriority);
+		P_CUDA_LOAD_SYMBOL_OPT_V2(cuStreamBeginCapture);
+		P_CUDA_LOAD_SYMBOL_OPT(cuStreamEndCapture);
 
 		// Event Management
-		// - Not yet needed.
+		P_CUDA_LOAD_SYMBOL(cuEventCreate);
+		P_CUDA_LOAD_SYMBOL_V2(cuEventDestroy);
+		P_CUDA_LOAD_SYMBOL(cuEventQuery);
+		P_CUDA_LOAD_SYMBOL(cuEventRecord);
+		P_CUDA_LOAD_SYMBOL(cuEventSynchronize);
+		P_CUDA_LOAD_SYMBOL(cuStreamWaitEvent);
 
 		// External Resource Interoperability (CUDA 11.1+)
 		// - Not yet needed.
@@ -186,8 +204,11 @@ streamfx::nvidia::cuda::cuda::cuda() : _library()
 		// Execution Control
 		// - Not yet needed.
 
-		// Graph Management
-		// - Not yet needed.
+		// Graph Management (CUDA 11.4+)
+		P_CUDA_LOAD_SYMBOL_OPT(cuGraphDestroy);
+		P_CUDA_LOAD_SYMBOL_OPT(cuGraphExecDestroy);
+		P_CUDA_LOAD_SYMBOL_OPT(cuGraphInstantiateWithFlags);
+		P_CUDA_LOAD_SYMBOL_OPT(cuGraphLaunch);
 
 		// Occupancy
 		// - Not yet needed.
@@ -254,6 +275,8 @@ std::shared_ptr<streamfx::nvidia::cuda::cuda> streamfx::nvidia::cuda::cuda::get(
 
 	std::unique_lock<std::mutex> ul(lock);
 	if (instance.expired()) {
+		::streamfx::obs::statistics::load_cost cost{::streamfx::obs::statistics::load_step::SDK};
+
 		auto hard_instance = std::make_shared<streamfx::nvidia::cuda::cuda>();
 		instance           = hard_instance;
 		return hard_instance;
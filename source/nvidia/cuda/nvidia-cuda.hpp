@@ -41,20 +41,22 @@
 
 namespace streamfx::nvidia::cuda {
 	enum class result : std::size_t {
-		SUCCESS                  = 0,
-		INVALID_VALUE            = 1,
-		OUT_OF_MEMORY            = 2,
-		NOT_INITIALIZED          = 3,
-		DEINITIALIZED            = 4,
-		NO_DEVICE                = 100,
-		INVALID_DEVICE           = 101,
-		INVALID_CONTEXT          = 201,
-		MAP_FAILED               = 205,
-		UNMAP_FAILED             = 206,
-		ARRAY_IS_MAPPED          = 207,
-		ALREADY_MAPPED           = 208,
-		NOT_MAPPED               = 211,
-		INVALID_GRAPHICS_CONTEXT = 219,
+		SUCCESS                     = 0,
+		INVALID_VALUE               = 1,
+		OUT_OF_MEMORY               = 2,
+		NOT_INITIALIZED             = 3,
+		DEINITIALIZED               = 4,
+		NO_DEVICE                   = 100,
+		INVALID_DEVICE              = 101,
+		INVALID_CONTEXT             = 201,
+		MAP_FAILED                  = 205,
+		UNMAP_FAILED                = 206,
+		ARRAY_IS_MAPPED             = 207,
+		ALREADY_MAPPED              = 208,
+		NOT_MAPPED                  = 211,
+		INVALID_GRAPHICS_CONTEXT    = 219,
+		NOT_READY                   = 600,
+		PEER_ACCESS_ALREADY_ENABLED = 704,
 		// Still missing some.
 	};
 
@@ -102,10 +104,26 @@ namespace streamfx::nvidia::cuda {
 		NON_BLOCKING = 0x1,
 	};
 
+	enum class event_flags : uint32_t {
+		DEFAULT        = 0x0,
+		BLOCKING_SYNC  = 0x1,
+		DISABLE_TIMING = 0x2,
+		INTERPROCESS   = 0x4,
+	};
+
+	enum class stream_capture_mode : uint32_t {
+		GLOBAL       = 0x0,
+		THREAD_LOCAL = 0x1,
+		RELAXED      = 0x2,
+	};
+
 	typedef void*    array_t;
 	typedef void*    context_t;
 	typedef uint64_t device_ptr_t;
+	typedef void*    event_t;
 	typedef void*    external_memory_t;
+	typedef void*    graph_t;
+	typedef void*    graph_exec_t;
 	typedef void*    graphics_resource_t;
 	typedef void*    stream_t;
 	typedef int32_t  device_t;
@@ -217,6 +235,8 @@ namespace streamfx::nvidia::cuda {
 		P_CUDA_DEFINE_FUNCTION(cuDriverGetVersion, int32_t* driverVersion);
 
 		// Device Management
+		P_CUDA_DEFINE_FUNCTION(cuDeviceGet, device_t* device, int32_t ordinal);
+		P_CUDA_DEFINE_FUNCTION(cuDeviceGetCount, int32_t* count);
 		P_CUDA_DEFINE_FUNCTION(cuDeviceGetName, char* name, int32_t length, device_t device);
 		P_CUDA_DEFINE_FUNCTION(cuDeviceGetLuid, luid_t* luid, uint32_t* device_node_mask, device_t device);
 		P_CUDA_DEFINE_FUNCTION(cuDeviceGetUuid, uuid_t* uuid, device_t device);
@@ -237,6 +257,10 @@ namespace streamfx::nvidia::cuda {
 		P_CUDA_DEFINE_FUNCTION(cuCtxSetCurrent, context_t ctx);
 		P_CUDA_DEFINE_FUNCTION(cuCtxSynchronize);
 
+		// Peer Context Memory Access
+		P_CUDA_DEFINE_FUNCTION(cuDeviceCanAccessPeer, int32_t* canAccessPeer, device_t device, device_t peerDevice);
+		P_CUDA_DEFINE_FUNCTION(cuCtxEnablePeerAccess, context_t peerContext, uint32_t flags);
+
 		// Module Management
 		// - Not yet needed.
 
@@ -246,6 +270,9 @@ namespace streamfx::nvidia::cuda {
 		P_CUDA_DEFINE_FUNCTION(cuMemAllocPitch, device_ptr_t* ptr, std::size_t* pitch, std::size_t width_in_bytes,
 							   std::size_t height, uint32_t element_size_bytes);
 		P_CUDA_DEFINE_FUNCTION(cuMemFree, device_ptr_t ptr);
+		P_CUDA_DEFINE_FUNCTION(cuMemFreeHost, void* ptr);
+		P_CUDA_DEFINE_FUNCTION(cuMemGetInfo, std::size_t* free, std::size_t* total);
+		P_CUDA_DEFINE_FUNCTION(cuMemHostAlloc, void** ptr, std::size_t bytes, uint32_t flags);
 		P_CUDA_DEFINE_FUNCTION(cuMemHostGetDevicePointer, device_ptr_t* devptr, void* ptr, uint32_t flags);
 		P_CUDA_DEFINE_FUNCTION(cuMemcpy, device_ptr_t dst, device_ptr_t src, std::size_t bytes);
 		P_CUDA_DEFINE_FUNCTION(cuMemcpy2D, const memcpy2d_v2_t* copy);
@@ -269,8 +296,9 @@ namespace streamfx::nvidia::cuda {
 		// Virtual Memory Management
 		// - Not yet needed.
 
-		// Stream Ordered Memory Allocator
-		// - Not yet needed.
+		// Stream Ordered Memory Allocator (CUDA 11.2+)
+		P_CUDA_DEFINE_FUNCTION(cuMemAllocAsync, device_ptr_t* ptr, std::size_t bytes, stream_t stream);
+		P_CUDA_DEFINE_FUNCTION(cuMemFreeAsync, device_ptr_t ptr, stream_t stream);
 
 		// Unified Addressing
 		// - Not yet needed.
@@ -281,9 +309,16 @@ namespace streamfx::nvidia::cuda {
 		P_CUDA_DEFINE_FUNCTION(cuStreamDestroy, stream_t stream);
 		P_CUDA_DEFINE_FUNCTION(cuStreamSynchronize, stream_t stream);
 		P_CUDA_DEFINE_FUNCTION(cuStreamGetPriority, stream_t stream, int32_t* priority);
+		P_CUDA_DEFINE_FUNCTION(cuStreamBeginCapture, stream_t stream, stream_capture_mode mode);
+		P_CUDA_DEFINE_FUNCTION(cuStreamEndCapture, stream_t stream, graph_t* graph);
 
 		// Event Management
-		// - Not yet needed.
+		P_CUDA_DEFINE_FUNCTION(cuEventCreate, event_t* event, event_flags flags);
+		P_CUDA_DEFINE_FUNCTION(cuEventDestroy, event_t event);
+		P_CUDA_DEFINE_FUNCTION(cuEventQuery, event_t event);
+		P_CUDA_DEFINE_FUNCTION(cuEventRecord, event_t event, stream_t stream);
+		P_CUDA_DEFINE_FUNCTION(cuEventSynchronize, event_t event);
+		P_CUDA_DEFINE_FUNCTION(cuStreamWaitEvent, stream_t stream, event_t event, uint32_t flags);
 
 		// External Resource Interoperability (CUDA 11.1+)
 		// - Not yet needed.
@@ -294,8 +329,11 @@ namespace streamfx::nvidia::cuda {
 		// Execution Control
 		// - Not yet needed.
 
-		// Graph Management
-		// - Not yet needed.
+		// Graph Management (CUDA 11.4+)
+		P_CUDA_DEFINE_FUNCTION(cuGraphDestroy, graph_t graph);
+		P_CUDA_DEFINE_FUNCTION(cuGraphExecDestroy, graph_exec_t graph_exec);
+		P_CUDA_DEFINE_FUNCTION(cuGraphInstantiateWithFlags, graph_exec_t* graph_exec, graph_t graph, uint64_t flags);
+		P_CUDA_DEFINE_FUNCTION(cuGraphLaunch, graph_exec_t graph_exec, stream_t stream);
 
 		// Occupancy
 		// - Not yet needed.
@@ -23,6 +23,7 @@
 // - NVIDIA Augmented Reality SDK
 
 #include "nvidia-cv-image.hpp"
+#include <cstring>
 #include "nvidia/cuda/nvidia-cuda-obs.hpp"
 #include "obs/gs/gs-helper.hpp"
 
@@ -43,28 +44,132 @@
 using ::streamfx::nvidia::cv::image;
 using ::streamfx::nvidia::cv::result;
 
+/** Number of components and bytes per component for formats that can be laid out without CVImage's help.
+ */
+static bool pooled_layout(::streamfx::nvidia::cv::pixel_format   pix_fmt,
+						  ::streamfx::nvidia::cv::component_type cmp_type, uint32_t& components, uint32_t& bytes)
+{
+	switch (pix_fmt) {
+	case ::streamfx::nvidia::cv::pixel_format::Y:
+	case ::streamfx::nvidia::cv::pixel_format::A:
+		components = 1;
+		break;
+	case ::streamfx::nvidia::cv::pixel_format::YA:
+		components = 2;
+		break;
+	case ::streamfx::nvidia::cv::pixel_format::RGB:
+	case ::streamfx::nvidia::cv::pixel_format::BGR:
+		components = 3;
+		break;
+	case ::streamfx::nvidia::cv::pixel_format::RGBA:
+	case ::streamfx::nvidia::cv::pixel_format::BGRA:
+	case ::streamfx::nvidia::cv::pixel_format::ARGB:
+	case ::streamfx::nvidia::cv::pixel_format::ABGR:
+		components = 4;
+		break;
+	default:
+		return false;
+	}
+
+	switch (cmp_type) {
+	case ::streamfx::nvidia::cv::component_type::UINT8:
+		bytes = 1;
+		break;
+	case ::streamfx::nvidia::cv::component_type::UINT16:
+	case ::streamfx::nvidia::cv::component_type::SINT16:
+	case ::streamfx::nvidia::cv::component_type::FP16:
+		bytes = 2;
+		break;
+	case ::streamfx::nvidia::cv::component_type::UINT32:
+	case ::streamfx::nvidia::cv::component_type::SINT:
+	case ::streamfx::nvidia::cv::component_type::FP32:
+		bytes = 4;
+		break;
+	case ::streamfx::nvidia::cv::component_type::UINT64:
+	case ::streamfx::nvidia::cv::component_type::SINT64:
+	case ::streamfx::nvidia::cv::component_type::FP64:
+		bytes = 8;
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+/** Host images are always placed into pinned memory, so transfers from and to the GPU need no staging copy.
+ */
+static ::streamfx::nvidia::cv::memory_location host_location(::streamfx::nvidia::cv::memory_location location)
+{
+	if (location == ::streamfx::nvidia::cv::memory_location::CPU) {
+		return ::streamfx::nvidia::cv::memory_location::CPU_PINNED;
+	}
+	return location;
+}
+
 image::~image()
 {
 	auto gctx = ::streamfx::obs::gs::context();
-	auto cctx = ::streamfx::nvidia::cuda::obs::get()->get_context()->enter();
+	auto cctx = get_context()->enter();
 
-	_cv->NvCVImage_Dealloc(&_image);
+	if (_memory) {
+		_memory.reset();
+	} else {
+		_cv->NvCVImage_Dealloc(&_image);
+	}
 }
 
-image::image() : _cv(::streamfx::nvidia::cv::cv::get()), _image(), _alignment(1)
+image::image()
+	: _cv(::streamfx::nvidia::cv::cv::get()), _image(), _alignment(1), _memory(), _context(), _stream()
 {
 	// Forcefully clear the image storage.
 	memset(&_image, sizeof(_image), 0);
 }
 
 image::image(uint32_t width, uint32_t height, pixel_format pix_fmt, component_type cmp_type,
-			 component_layout cmp_layout, memory_location location, uint32_t alignment)
+			 component_layout cmp_layout, memory_location location, uint32_t alignment,
+			 std::shared_ptr<::streamfx::nvidia::cuda::stream> stream)
 	: image()
 {
 	auto gctx = ::streamfx::obs::gs::context();
 	auto cctx = ::streamfx::nvidia::cuda::obs::get()->get_context()->enter();
 
+	_stream    = stream;
 	_alignment = alignment;
+	location   = host_location(location);
+	if (allocate_pooled(width, height, pix_fmt, cmp_type, cmp_layout, location, alignment)) {
+		return;
+	}
+
+	if (auto res = _cv->NvCVImage_Alloc(&_image, width, height, pix_fmt, cmp_type, static_cast<uint32_t>(cmp_layout),
+										static_cast<uint32_t>(location), _alignment);
+		res != result::SUCCESS) {
+		throw std::runtime_error(_cv->NvCV_GetErrorStringFromCode(res));
+	}
+}
+
+image::image(uint32_t width, uint32_t height, pixel_format pix_fmt, component_type cmp_type,
+			 component_layout cmp_layout, memory_location location, uint32_t alignment,
+			 std::shared_ptr<::streamfx::nvidia::cuda::context> context,
+			 std::shared_ptr<::streamfx::nvidia::cuda::stream>  stream)
+	: image()
+{
+	if (!context) {
+		context = ::streamfx::nvidia::cuda::obs::get()->get_context();
+	} else if (context != ::streamfx::nvidia::cuda::obs::get()->get_context()) {
+		_context = context;
+	}
+
+	auto gctx = ::streamfx::obs::gs::context();
+	auto cctx = get_context()->enter();
+
+	_stream    = stream;
+	_alignment = alignment;
+	location   = host_location(location);
+	if (allocate_pooled(width, height, pix_fmt, cmp_type, cmp_layout, location, alignment)) {
+		return;
+	}
+
 	if (auto res = _cv->NvCVImage_Alloc(&_image, width, height, pix_fmt, cmp_type, static_cast<uint32_t>(cmp_layout),
 										static_cast<uint32_t>(location), _alignment);
 		res != result::SUCCESS) {
@@ -77,7 +182,19 @@ void streamfx::nvidia::cv::image::reallocate(uint32_t width, uint32_t height, pi
 											 memory_location location, uint32_t alignment)
 {
 	auto gctx = ::streamfx::obs::gs::context();
-	auto cctx = ::streamfx::nvidia::cuda::obs::get()->get_context()->enter();
+	auto cctx = get_context()->enter();
+
+	location = host_location(location);
+	if (allocate_pooled(width, height, pix_fmt, cmp_type, cmp_layout, location, alignment)) {
+		_alignment = alignment;
+		return;
+	}
+
+	if (_memory) {
+		// Hand the old buffer back to the pool, CVImage doesn't know about it.
+		_memory.reset();
+		memset(&_image, 0, sizeof(_image));
+	}
 
 	if (auto res = _cv->NvCVImage_Realloc(&_image, width, height, pix_fmt, cmp_type, static_cast<uint32_t>(cmp_layout),
 										  static_cast<uint32_t>(location), alignment);
@@ -97,3 +214,54 @@ streamfx::nvidia::cv::image_t* streamfx::nvidia::cv::image::get_image()
 {
 	return &_image;
 }
+
+std::shared_ptr<::streamfx::nvidia::cuda::context> streamfx::nvidia::cv::image::get_context()
+{
+	if (_context) {
+		return _context;
+	}
+	return ::streamfx::nvidia::cuda::obs::get()->get_context();
+}
+
+bool streamfx::nvidia::cv::image::allocate_pooled(uint32_t width, uint32_t height, pixel_format pix_fmt,
+												  component_type cmp_type, component_layout cmp_layout,
+												  memory_location location, uint32_t alignment)
+{
+	uint32_t components = 0;
+	uint32_t bytes      = 0;
+
+	// Only simple GPU images on the rendering device can be placed into pooled memory, the rest is left to CVImage.
+	if (_context || (location != memory_location::GPU)
+		|| ((cmp_layout != component_layout::INTERLEAVED) && (cmp_layout != component_layout::PLANAR))
+		|| !pooled_layout(pix_fmt, cmp_type, components, bytes)) {
+		return false;
+	}
+
+	// Planar images store each component as its own plane, one after the other.
+	bool     planar = (cmp_layout == component_layout::PLANAR);
+	uint32_t pitch  = width * bytes * (planar ? 1 : components);
+	if (alignment > 1) {
+		pitch = ((pitch + alignment - 1) / alignment) * alignment;
+	}
+	std::size_t size = static_cast<std::size_t>(pitch) * height * (planar ? components : 1);
+
+	// Release whatever is currently backing the image.
+	if (_memory) {
+		_memory.reset();
+	} else {
+		_cv->NvCVImage_Dealloc(&_image);
+	}
+	memset(&_image, 0, sizeof(_image));
+
+	// Allocated on the stream that uses the image, so that neither the allocation nor its reuse races with that use.
+	auto nvobs = ::streamfx::nvidia::cuda::obs::get();
+	_memory    = nvobs->get_memory_pool()->allocate(size, _stream ? _stream : nvobs->get_stream());
+	if (auto res = _cv->NvCVImage_Init(&_image, width, height, pitch, reinterpret_cast<void*>(_memory->get()), pix_fmt,
+									   cmp_type, cmp_layout, location);
+		res != result::SUCCESS) {
+		_memory.reset();
+		throw std::runtime_error(_cv->NvCV_GetErrorStringFromCode(res));
+	}
+
+	return true;
+}
@@ -20,6 +20,9 @@
 
 #pragma once
 #include <cinttypes>
+#include "nvidia/cuda/nvidia-cuda-context.hpp"
+#include "nvidia/cuda/nvidia-cuda-memory.hpp"
+#include "nvidia/cuda/nvidia-cuda-stream.hpp"
 #include "nvidia/cv/nvidia-cv.hpp"
 
 namespace streamfx::nvidia::cv {
@@ -34,6 +37,15 @@ namespace streamfx::nvidia::cv {
 		image_t                                     _image;
 		size_t                                      _alignment;
 
+		// Set if the pixels are backed by the shared CUDA memory pool instead of CVImage.
+		std::shared_ptr<::streamfx::nvidia::cuda::memory> _memory;
+
+		// Set if the image lives on a different device than the one OBS renders with.
+		std::shared_ptr<::streamfx::nvidia::cuda::context> _context;
+
+		// Set if the image is used on a different stream than the one OBS renders with.
+		std::shared_ptr<::streamfx::nvidia::cuda::stream> _stream;
+
 		public:
 		virtual ~image();
 
@@ -41,8 +53,22 @@ namespace streamfx::nvidia::cv {
 		image();
 
 		public:
+		/** Allocate the image for use on stream, or the stream OBS renders with if none is given.
+		 *
+		 * Pooled memory is allocated and handed back on the stream that uses it, so that CUDA orders its reuse.
+		 */
 		image(uint32_t width, uint32_t height, pixel_format pix_fmt, component_type cmp_type,
-			  component_layout cmp_layout, memory_location location, uint32_t alignment);
+			  component_layout cmp_layout, memory_location location, uint32_t alignment,
+			  std::shared_ptr<::streamfx::nvidia::cuda::stream> stream = nullptr);
+
+		/** Allocate the image within a specific CUDA context, instead of the one OBS renders with.
+		 *
+		 * Such images are never placed into the shared memory pool, as it belongs to the rendering device.
+		 */
+		image(uint32_t width, uint32_t height, pixel_format pix_fmt, component_type cmp_type,
+			  component_layout cmp_layout, memory_location location, uint32_t alignment,
+			  std::shared_ptr<::streamfx::nvidia::cuda::context> context,
+			  std::shared_ptr<::streamfx::nvidia::cuda::stream>  stream = nullptr);
 
 		virtual void reallocate(uint32_t width, uint32_t height, pixel_format pix_fmt, component_type cmp_type,
 								component_layout cmp_layout, memory_location location, uint32_t alignment);
@@ -50,6 +76,12 @@ namespace streamfx::nvidia::cv {
 		virtual void resize(uint32_t width, uint32_t height);
 
 		virtual ::streamfx::nvidia::cv::image_t* get_image();
+
+		private:
+		std::shared_ptr<::streamfx::nvidia::cuda::context> get_context();
+
+		bool allocate_pooled(uint32_t width, uint32_t height, pixel_format pix_fmt, component_type cmp_type,
+							 component_layout cmp_layout, memory_location location, uint32_t alignment);
 	};
 
 } // namespace streamfx::nvidia::cv
@@ -19,8 +19,15 @@
 // SOFTWARE.
 
 #include "nvidia-vfx-superresolution.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
 #include <utility>
 #include "obs/gs/gs-helper.hpp"
+#include "obs/obs-statistics.hpp"
+#include "plugin.hpp"
 #include "util/util-logging.hpp"
 #include "util/utility.hpp"
 
@@ -38,21 +45,127 @@
 #define D_LOG_DEBUG(...) P_LOG_DEBUG(ST_PREFIX __VA_ARGS__)
 #endif
 
+using ::streamfx::nvidia::vfx::superresolution_format;
+
+static constexpr uint32_t min_width  = 160;
+static constexpr uint32_t min_height = 90;
+
+// Loaded effects kept around, so that switching back to a previous configuration doesn't load the model again.
+static constexpr std::size_t fx_cache_size = 4;
+
+struct streamfx::nvidia::vfx::superresolution::fx_load {
+	fx_key_t                                           key;
+	std::shared_ptr<void>                              fx;
+	std::shared_ptr<::streamfx::nvidia::cuda::cuda>    cuda;
+	std::shared_ptr<::streamfx::nvidia::cuda::context> context;
+	::streamfx::nvidia::cv::result                     result = ::streamfx::nvidia::cv::result::ERROR_GENERAL;
+	uint64_t                                           memory = 0;
+	std::atomic<bool>                                  done{false};
+};
+
+// Input pixels shared between neighbouring tiles, so that the seams are hidden.
+static constexpr uint32_t tile_overlap = 16;
+
+/** Length of a tile when splitting a length into the given number of tiles.
+ */
+static uint32_t tile_split(uint32_t length, uint32_t count)
+{
+	return std::min(length, (length + count - 1) / count + 2 * tile_overlap);
+}
+
+/** Number of tiles needed to cover a length with tiles of the given length.
+ */
+static uint32_t tile_count(uint32_t length, uint32_t tile)
+{
+	if (tile >= length) {
+		return 1;
+	}
+	uint32_t step = tile - 2 * tile_overlap;
+	return (length - 2 * tile_overlap + step - 1) / step;
+}
+
+/** Origin of a tile, and the range [start, end) of the length it is responsible for.
+ *
+ * Tiles at the edges are pushed inwards instead of shrunk, as the effect is loaded for a fixed size.
+ */
+static uint32_t tile_origin(uint32_t length, uint32_t tile, uint32_t index, uint32_t count, uint32_t& start,
+							uint32_t& end)
+{
+	if (count <= 1) {
+		start = 0;
+		end   = length;
+		return 0;
+	}
+
+	uint32_t step = tile - 2 * tile_overlap;
+	start         = (index == 0) ? 0 : (tile_overlap + index * step);
+	end           = (index == count - 1) ? length : std::min(tile_overlap + (index + 1) * step, length - tile_overlap);
+	return std::min((index == 0) ? 0 : (start - tile_overlap), length - tile);
+}
+
+const char* streamfx::nvidia::vfx::cstring(superresolution_format format)
+{
+	switch (format) {
+	case superresolution_format::UINT8_CHUNKY:
+		return "UINT8 Chunky";
+	case superresolution_format::FP16_PLANAR:
+		return "FP16 Planar";
+	case superresolution_format::FP32_PLANAR:
+		return "FP32 Planar";
+	default:
+		return "Unknown";
+	}
+}
+
 streamfx::nvidia::vfx::superresolution::~superresolution()
 {
 	auto gctx = ::streamfx::obs::gs::context();
 	auto cctx = ::streamfx::nvidia::cuda::obs::get()->get_context()->enter();
 
-	_fx.reset();
+	// Wait for any work still in flight, as it uses the resources below.
+	if (_fx_load_task) {
+		streamfx::threadpool()->pop(_fx_load_task);
+		while (!_fx_load_task->is_done()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+	if (_pending) {
+		_event->synchronize();
+	}
+	if (_inference) {
+		auto ictx = _inference->enter();
+		_inference_stream->synchronize();
+	}
+
+	_graphs.clear();
+	{
+		auto fctx = fx_context()->enter();
+		_fx.reset();
+		_fx_cache.clear();
+		_ar_fx.reset();
+	}
 
 	// Clean up any CUDA resources in use.
 	_input.reset();
-	_convert_to_fp32.reset();
+	_convert_to_float.reset();
 	_source.reset();
+	_ar_destination.reset();
 	_destination.reset();
 	_convert_to_u8.reset();
 	_output.reset();
+	_output_previous.reset();
 	_tmp.reset();
+	_peer_source.reset();
+	_peer_destination.reset();
+	_event.reset();
+	_stream.reset();
+	_transfer_event.reset();
+	if (_inference) {
+		auto ictx = _inference->enter();
+		_inference_event.reset();
+		_inference_stream.reset();
+	}
+	_inference.reset();
 
 	// Release CUDA, CVImage, and Video Effects SDK.
 	_nvvfx.reset();
@@ -60,43 +173,39 @@ streamfx::nvidia::vfx::superresolution::~superresolution()
 	_nvcuda.reset();
 }
 
-streamfx::nvidia::vfx::superresolution::superresolution()
+streamfx::nvidia::vfx::superresolution::superresolution(int32_t device)
 	: _nvcuda(::streamfx::nvidia::cuda::obs::get()), _nvcvi(::streamfx::nvidia::cv::cv::get()),
-	  _nvvfx(::streamfx::nvidia::vfx::vfx::get()), _strength(1.), _scale(1.5), _input(), _source(), _destination(),
-	  _convert_to_u8(), _output(), _tmp(), _dirty(true)
+	  _nvvfx(::streamfx::nvidia::vfx::vfx::get()), _strength(1.), _ar_strength(0.), _scale(1.5),
+	  _asynchronous(false), _use_graphs(false), _format(superresolution_format::UINT8_CHUNKY), _memory_budget(0),
+	  _tile(1, 1), _input(), _convert_to_float(), _source(), _ar_destination(), _destination(), _convert_to_u8(),
+	  _output(), _output_previous(), _tmp(), _stream(), _buffer_stream(), _event(), _device(device), _inference(),
+	  _inference_stream(), _inference_event(), _transfer_event(), _peer_source(), _peer_destination(), _graphs(),
+	  _dirty(true),
+	  _fx_loaded(false), _ar_bound(false), _pending(false), _previous_valid(false), _graphs_settled(false),
+	  _graphs_failed(false)
 {
 	// Enter Graphics and CUDA context.
 	auto gctx = ::streamfx::obs::gs::context();
 	auto cctx = ::streamfx::nvidia::cuda::obs::get()->get_context()->enter();
 
-	{ // Try & Create the Super-Resolution effect.
-		::streamfx::nvidia::vfx::handle_t handle;
-		if (auto res = _nvvfx->NvVFX_CreateEffect(::streamfx::nvidia::vfx::EFFECT_SUPERRESOLUTION, &handle);
-			res != ::streamfx::nvidia::cv::result::SUCCESS) {
-			D_LOG_ERROR("Failed to create effect due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
-			throw std::runtime_error("CreateEffect failed.");
-		}
+	// Run on the shared stream until asynchronous mode is requested.
+	_stream = _nvcuda->get_stream();
+	_event  = std::make_shared<::streamfx::nvidia::cuda::event>();
 
-		_fx = std::shared_ptr<void>(handle, [](::streamfx::nvidia::vfx::handle_t handle) {
-			::streamfx::nvidia::vfx::vfx::get()->NvVFX_DestroyEffect(handle);
-		});
-	}
+	// Inference on another device runs on its own stream, which waits for the transfers on _stream and vice versa.
+	if (auto ctx = _nvcuda->get_inference_context(device); ctx != _nvcuda->get_context()) {
+		_inference      = ctx;
+		_transfer_event = std::make_shared<::streamfx::nvidia::cuda::event>();
 
-	// Assign the appropriate CUDA stream.
-	if (auto res = _nvvfx->NvVFX_SetCudaStream(_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_CUDA_STREAM,
-											   _nvcuda->get_stream()->get());
-		res != ::streamfx::nvidia::cv::result::SUCCESS) {
-		D_LOG_ERROR("Failed to set CUDA stream due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
-		throw std::runtime_error("SetCudaStream failed.");
+		auto ictx         = _inference->enter();
+		_inference_stream = std::make_shared<::streamfx::nvidia::cuda::stream>(
+			::streamfx::nvidia::cuda::stream_flags::NON_BLOCKING);
+		_inference_event = std::make_shared<::streamfx::nvidia::cuda::event>();
+		D_LOG_INFO("Running inference on device %" PRId32 ".", _inference->device());
 	}
 
-	// Set the proper model directory.
-	if (auto res = _nvvfx->NvVFX_SetString(_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_MODEL_DIRECTORY,
-										   _nvvfx->model_path().generic_u8string().c_str());
-		res != ::streamfx::nvidia::cv::result::SUCCESS) {
-		D_LOG_ERROR("Failed to set model directory due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
-		throw std::runtime_error("SetString failed.");
-	}
+	// Try & Create the Super-Resolution effect.
+	_fx = create();
 
 	// Set the strength, scale and buffers.
 	set_strength(_strength);
@@ -107,23 +216,20 @@ streamfx::nvidia::vfx::superresolution::superresolution()
 	load();
 }
 
+int32_t streamfx::nvidia::vfx::superresolution::device()
+{
+	return _device;
+}
+
 void streamfx::nvidia::vfx::superresolution::set_strength(float strength)
 {
 	strength = (strength >= .5f) ? 1.f : 0.f;
 	std::swap(_strength, strength);
 
-	// If anything was changed, flag the effect as dirty.
+	// If anything was changed, flag the effect as dirty. Loaded effects are left as they are, so the strength is
+	// applied by load() to whichever effect is loaded next.
 	if (!::streamfx::util::math::is_close<float>(_strength, strength, 0.01))
 		_dirty = true;
-
-	// Update Effect
-	uint32_t value = (_strength >= .5f) ? 1 : 0;
-	auto     gctx  = ::streamfx::obs::gs::context();
-	auto     cctx  = ::streamfx::nvidia::cuda::obs::get()->get_context()->enter();
-	if (auto res = _nvvfx->NvVFX_SetU32(_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_STRENGTH, value);
-		res != ::streamfx::nvidia::cv::result::SUCCESS) {
-		D_LOG_ERROR("Failed to set '%s' to %lu.", ::streamfx::nvidia::vfx::PARAMETER_STRENGTH, value);
-	};
 }
 
 float streamfx::nvidia::vfx::superresolution::strength()
@@ -161,14 +267,229 @@ float streamfx::nvidia::vfx::superresolution::scale()
 	return _scale;
 }
 
+void streamfx::nvidia::vfx::superresolution::set_artifact_reduction(bool enabled)
+{
+	if (enabled == static_cast<bool>(_ar_fx))
+		return;
+
+	auto gctx = ::streamfx::obs::gs::context();
+	auto cctx = ::streamfx::nvidia::cuda::obs::get()->get_context()->enter();
+
+	// Finish any work still in flight, as it uses the buffers that are about to be rebound.
+	if (_pending) {
+		_event->synchronize();
+		_pending = false;
+	}
+
+	if (enabled) {
+		auto                              fctx = fx_context()->enter();
+		::streamfx::nvidia::vfx::handle_t handle;
+		if (auto res = _nvvfx->NvVFX_CreateEffect(::streamfx::nvidia::vfx::EFFECT_ARTIFACT_REDUCTION, &handle);
+			res != ::streamfx::nvidia::cv::result::SUCCESS) {
+			D_LOG_ERROR("Failed to create artifact reduction due to error: %s",
+						_nvcvi->NvCV_GetErrorStringFromCode(res));
+			throw std::runtime_error("CreateEffect failed.");
+		}
+		_ar_fx = std::shared_ptr<void>(handle, [](::streamfx::nvidia::vfx::handle_t handle) {
+			::streamfx::nvidia::vfx::vfx::get()->NvVFX_DestroyEffect(handle);
+		});
+
+		if (_inference) {
+			if (auto res = _nvvfx->NvVFX_SetU32(_ar_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_GPU,
+												static_cast<uint32_t>(_inference->device()));
+				res != ::streamfx::nvidia::cv::result::SUCCESS) {
+				D_LOG_ERROR("Failed to set GPU due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+				_ar_fx.reset();
+				throw std::runtime_error("SetU32 failed.");
+			}
+		}
+
+		if (auto res = _nvvfx->NvVFX_SetString(_ar_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_MODEL_DIRECTORY,
+											   _nvvfx->model_path().generic_u8string().c_str());
+			res != ::streamfx::nvidia::cv::result::SUCCESS) {
+			D_LOG_ERROR("Failed to set model directory due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+			_ar_fx.reset();
+			throw std::runtime_error("SetString failed.");
+		}
+		set_artifact_reduction_strength(_ar_strength);
+
+		// Artifact Reduction only accepts planar FP32, which super-resolution then has to take as well.
+		_format = superresolution_format::FP32_PLANAR;
+	} else {
+		auto fctx = fx_context()->enter();
+		_ar_fx.reset();
+		_ar_destination.reset();
+
+		// Start over with the cheapest format, load() falls back from there if necessary.
+		_format = superresolution_format::UINT8_CHUNKY;
+	}
+
+	_ar_bound       = false;
+	_previous_valid = false;
+	_dirty          = true;
+}
+
+bool streamfx::nvidia::vfx::superresolution::artifact_reduction()
+{
+	return static_cast<bool>(_ar_fx);
+}
+
+void streamfx::nvidia::vfx::superresolution::set_artifact_reduction_strength(float strength)
+{
+	strength = (strength >= .5f) ? 1.f : 0.f;
+	std::swap(_ar_strength, strength);
+
+	if (!_ar_fx)
+		return;
+
+	// The mode is only picked up by loading the effect again.
+	if (!::streamfx::util::math::is_close<float>(_ar_strength, strength, 0.01))
+		_dirty = true;
+
+	uint32_t value = (_ar_strength >= .5f) ? 1 : 0;
+	auto     gctx  = ::streamfx::obs::gs::context();
+	auto     cctx  = ::streamfx::nvidia::cuda::obs::get()->get_context()->enter();
+	if (auto res = _nvvfx->NvVFX_SetU32(_ar_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_MODE, value);
+		res != ::streamfx::nvidia::cv::result::SUCCESS) {
+		D_LOG_ERROR("Failed to set '%s' to %lu.", ::streamfx::nvidia::vfx::PARAMETER_MODE, value);
+	};
+}
+
+float streamfx::nvidia::vfx::superresolution::artifact_reduction_strength()
+{
+	return _ar_strength;
+}
+
+void streamfx::nvidia::vfx::superresolution::set_asynchronous(bool asynchronous)
+{
+	if (_asynchronous == asynchronous)
+		return;
+
+	auto gctx = ::streamfx::obs::gs::context();
+	auto cctx = ::streamfx::nvidia::cuda::obs::get()->get_context()->enter();
+
+	// Finish any work still in flight on the old stream.
+	if (_pending) {
+		_event->synchronize();
+		_pending = false;
+	}
+
+	_asynchronous   = asynchronous;
+	_previous_valid = false;
+	if (!_asynchronous) {
+		_output_previous.reset();
+	}
+	select_stream();
+}
+
+bool streamfx::nvidia::vfx::superresolution::asynchronous()
+{
+	return _asynchronous;
+}
+
+void streamfx::nvidia::vfx::superresolution::set_graphs(bool enabled)
+{
+	if (enabled && !::streamfx::nvidia::cuda::graph::is_available()) {
+		D_LOG_WARNING("CUDA Graphs are not supported by the installed driver, launches will be issued directly.", 0);
+		enabled = false;
+	}
+	if (enabled && _inference) {
+		// A recording can't follow the work from one device to the other.
+		D_LOG_WARNING("CUDA Graphs are not supported for inference on another device, launches will be issued "
+					  "directly.",
+					  0);
+		enabled = false;
+	}
+	if (_use_graphs == enabled)
+		return;
+
+	auto gctx = ::streamfx::obs::gs::context();
+	auto cctx = ::streamfx::nvidia::cuda::obs::get()->get_context()->enter();
+
+	// Finish any work still in flight on the old stream.
+	if (_pending) {
+		_event->synchronize();
+		_pending = false;
+	}
+
+	_use_graphs     = enabled;
+	_previous_valid = false;
+	select_stream();
+}
+
+bool streamfx::nvidia::vfx::superresolution::graphs()
+{
+	return _use_graphs;
+}
+
+void streamfx::nvidia::vfx::superresolution::set_memory_budget(uint64_t budget)
+{
+	// Buffers are reallocated by the next call to process(), if the tile size changes.
+	_memory_budget = budget;
+}
+
+uint64_t streamfx::nvidia::vfx::superresolution::memory_budget()
+{
+	return _memory_budget;
+}
+
+uint64_t streamfx::nvidia::vfx::superresolution::memory_usage()
+{
+	return memory_usage(_tile.first, _tile.second);
+}
+
+uint32_t streamfx::nvidia::vfx::superresolution::tiles()
+{
+	if (!_input) {
+		return 1;
+	}
+
+	return tile_count(_input->get_texture()->get_width(), _tile.first)
+		   * tile_count(_input->get_texture()->get_height(), _tile.second);
+}
+
+uint64_t streamfx::nvidia::vfx::superresolution::model_memory()
+{
+	uint64_t memory = 0;
+	for (auto& entry : _fx_cache) {
+		memory += entry.memory;
+	}
+	return memory;
+}
+
+void streamfx::nvidia::vfx::superresolution::idle()
+{
+	// A load in flight still refers to the current effect, so it has to finish first.
+	if (_fx_load && !_fx_load->done) {
+		return;
+	}
+
+	auto gctx = ::streamfx::obs::gs::context();
+	auto fctx = fx_context()->enter();
+	if (_pending) {
+		_event->synchronize();
+		_pending = false;
+	}
+	_previous_valid = false;
+
+	// Starts over with an unloaded effect bound to the current buffers, which load() then loads again.
+	_fx_load.reset();
+	_fx_load_task.reset();
+	reset_graphs();
+	_fx_cache.clear();
+	_fx        = create();
+	_fx_loaded = false;
+	_ar_bound  = false;
+	bind();
+	_dirty = true;
+}
+
 void streamfx::nvidia::vfx::superresolution::size(std::pair<uint32_t, uint32_t> const& size,
 												  std::pair<uint32_t, uint32_t>&       input_size,
 												  std::pair<uint32_t, uint32_t>&       output_size)
 {
-	constexpr uint32_t min_width  = 160;
-	constexpr uint32_t min_height = 90;
-	uint32_t           max_width  = 0;
-	uint32_t           max_height = 0;
+	uint32_t max_width  = 0;
+	uint32_t max_height = 0;
 
 	if (_scale > 3.0) {
 		max_width  = 960;
@@ -212,12 +533,38 @@ std::shared_ptr<::streamfx::obs::gs::texture>
 	::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_magenta, "NvVFX Super-Resolution"};
 #endif
 
+	if (_pending) {
+		// Wait for the previous frame, which also frees up the buffers for this one.
+#ifdef ENABLE_PROFILING
+		::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_gray, "Wait for previous frame"};
+#endif
+		_event->synchronize();
+		_pending = false;
+
+		// Keep the finished result around for presenting, and write this frame into the other output.
+		if (!_output_previous) {
+			auto tex         = _output->get_texture();
+			_output_previous = std::make_shared<::streamfx::nvidia::cv::texture>(tex->get_width(), tex->get_height(),
+																				 tex->get_color_format());
+		}
+		std::swap(_output, _output_previous);
+		_previous_valid = true;
+	}
+
+	// Nothing may touch the effect or its buffers while its models load, so frames pass through until then.
+	if (_fx_load && !_fx_load->done) {
+		return in;
+	}
+
 	// Resize if the size or scale was changed.
 	resize(in->get_width(), in->get_height());
 
 	// Reload effect if dirty.
 	if (_dirty) {
 		load();
+		if (!_fx_loaded) {
+			return in;
+		}
 	}
 
 	{ // Copy parameter to input.
@@ -227,26 +574,126 @@ std::shared_ptr<::streamfx::obs::gs::texture>
 		gs_copy_texture(_input->get_texture()->get_object(), in->get_object());
 	}
 
-	{ // Convert Input to Source format
+	{ // Run the effect, replaying the recorded launches once the buffers stopped changing.
+		std::shared_ptr<::streamfx::nvidia::cuda::graph> graph;
+		if (_use_graphs && _graphs_settled && !_graphs_failed) {
+			if (auto kv = _graphs.find(_output.get()); kv != _graphs.end()) {
+				graph = kv->second;
+			} else {
+				try {
+					graph = std::make_shared<::streamfx::nvidia::cuda::graph>(_stream, [this]() { process_tiles(); });
+					_graphs.emplace(_output.get(), graph);
+				} catch (const std::exception& ex) {
+					D_LOG_WARNING("Failed to record launches, issuing them directly instead: %s", ex.what());
+					_graphs_failed = true;
+				}
+			}
+		}
+
+		if (graph) {
+			graph->launch(_stream);
+		} else {
+			process_tiles();
+			_graphs_settled = true;
+		}
+	}
+
+	if (!_asynchronous && (_use_graphs || _inference)) {
+		// Nothing blocks on the effect in these modes, so wait for it here.
+		_stream->synchronize();
+	}
+
+	if (_asynchronous) {
+		_event->record(_stream);
+		_pending = true;
+
+		// Without an earlier result there is nothing to present yet, so this frame has to be waited for.
+		if (!_previous_valid) {
+			_event->synchronize();
+			return _output->get_texture();
+		}
+
+		return _output_previous->get_texture();
+	}
+
+	// Return output.
+	return _output->get_texture();
+}
+
+void streamfx::nvidia::vfx::superresolution::process_tiles()
+{
+	uint32_t width   = _input->get_texture()->get_width();
+	uint32_t height  = _input->get_texture()->get_height();
+	uint32_t columns = tile_count(width, _tile.first);
+	uint32_t rows    = tile_count(height, _tile.second);
+
+	for (uint32_t row = 0; row < rows; row++) {
+		uint32_t y0, y1;
+		uint32_t y = tile_origin(height, _tile.second, row, rows, y0, y1);
+		for (uint32_t column = 0; column < columns; column++) {
+			uint32_t x0, x1;
+			uint32_t x = tile_origin(width, _tile.first, column, columns, x0, x1);
+
+			// Area of the output this tile is responsible for, relative to the tile itself.
+			::streamfx::nvidia::cv::point<int32_t> out_point{static_cast<int32_t>(x0 * _scale),
+															 static_cast<int32_t>(y0 * _scale)};
+			::streamfx::nvidia::cv::rect<int32_t>  out_rect{
+				out_point.x - static_cast<int32_t>(x * _scale), out_point.y - static_cast<int32_t>(y * _scale),
+				static_cast<int32_t>(x1 * _scale) - out_point.x, static_cast<int32_t>(y1 * _scale) - out_point.y};
+			out_rect.w = std::min(out_rect.w, static_cast<int32_t>(_destination->get_image()->width) - out_rect.x);
+			out_rect.h = std::min(out_rect.h, static_cast<int32_t>(_destination->get_image()->height) - out_rect.y);
+
+			process_tile({static_cast<int32_t>(x), static_cast<int32_t>(y), static_cast<int32_t>(_tile.first),
+						  static_cast<int32_t>(_tile.second)},
+						 out_rect, out_point);
+		}
+	}
+}
+
+void streamfx::nvidia::vfx::superresolution::process_tile(::streamfx::nvidia::cv::rect<int32_t> const&  in_rect,
+														  ::streamfx::nvidia::cv::rect<int32_t> const&  out_rect,
+														  ::streamfx::nvidia::cv::point<int32_t> const& out_point)
+{
+	::streamfx::nvidia::cv::point<int32_t> origin{0, 0};
+
+	// With inference on another device, the transfers go through the copies on the rendering device instead.
+	auto source      = _inference ? _peer_source : _source;
+	auto destination = _inference ? _peer_destination : _destination;
+
+	if (_convert_to_float) {
+		{ // Convert Input to Source format
 #ifdef ENABLE_PROFILING
-		::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_convert,
-													"Convert Input -> Source"};
+			::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_convert,
+														"Convert Input -> Source"};
 #endif
-		if (auto res = _nvcvi->NvCVImage_Transfer(_input->get_image(), _convert_to_fp32->get_image(), 1.f,
-												  _nvcuda->get_stream()->get(), _tmp->get_image());
-			res != ::streamfx::nvidia::cv::result::SUCCESS) {
-			D_LOG_ERROR("Failed to transfer processing result to output due to error: %s",
-						_nvcvi->NvCV_GetErrorStringFromCode(res));
-			throw std::runtime_error("Transfer failed.");
+			if (auto res = _nvcvi->NvCVImage_TransferRect(_input->get_image(), &in_rect, _convert_to_float->get_image(),
+														  &origin, 1.f, _stream->get(), _tmp->get_image());
+				res != ::streamfx::nvidia::cv::result::SUCCESS) {
+				D_LOG_ERROR("Failed to transfer processing result to output due to error: %s",
+							_nvcvi->NvCV_GetErrorStringFromCode(res));
+				throw std::runtime_error("Transfer failed.");
+			}
 		}
-	}
 
-	{ // Copy input to source.
+		{ // Copy input to source.
+#ifdef ENABLE_PROFILING
+			::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_copy,
+														"Copy Input -> Source"};
+#endif
+			if (auto res = _nvcvi->NvCVImage_Transfer(_convert_to_float->get_image(), source->get_image(), 1.f,
+													  _stream->get(), _tmp->get_image());
+				res != ::streamfx::nvidia::cv::result::SUCCESS) {
+				D_LOG_ERROR("Failed to transfer input to processing source due to error: %s",
+							_nvcvi->NvCV_GetErrorStringFromCode(res));
+				throw std::runtime_error("Transfer failed.");
+			}
+		}
+	} else { // Copy input to source, the effect accepts it as is.
 #ifdef ENABLE_PROFILING
 		::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_copy, "Copy Input -> Source"};
 #endif
-		if (auto res = _nvcvi->NvCVImage_Transfer(_convert_to_fp32->get_image(), _source->get_image(), 1.f,
-												  _nvcuda->get_stream()->get(), _tmp->get_image());
+		if (auto res = _nvcvi->NvCVImage_TransferRect(_input->get_image(), &in_rect, source->get_image(), &origin,
+													  1.f, _stream->get(), _tmp->get_image());
 			res != ::streamfx::nvidia::cv::result::SUCCESS) {
 			D_LOG_ERROR("Failed to transfer input to processing source due to error: %s",
 						_nvcvi->NvCV_GetErrorStringFromCode(res));
@@ -254,46 +701,145 @@ std::shared_ptr<::streamfx::obs::gs::texture>
 		}
 	}
 
-	{ // Process source to destination.
+	if (_inference) { // Hand the source over to the inference device.
 #ifdef ENABLE_PROFILING
-		::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_cache, "Process"};
+		::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_copy, "Copy Source -> Device"};
 #endif
-		if (auto res = _nvvfx->NvVFX_Run(_fx.get(), 0); res != ::streamfx::nvidia::cv::result::SUCCESS) {
-			D_LOG_ERROR("Failed to process due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
-			throw std::runtime_error("Run failed.");
-		}
+		copy_peer(_peer_source, _source);
+		_transfer_event->record(_stream);
+		_transfer_event->wait(_inference_stream);
 	}
 
-	{ // Convert Destination to Output format
+	{
+		auto fctx = fx_context()->enter();
+
+		// Recorded launches must not block, so the effect is left to run asynchronously on the stream for them. The
+		// same goes for another device, where the copy back waits for the stream instead.
+		int32_t async = (_use_graphs || _inference) ? 1 : 0;
+
+		if (_ar_fx) { // Reduce artifacts in the source, which super-resolution then reads from.
 #ifdef ENABLE_PROFILING
-		::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_convert,
-													"Convert Destination -> Output"};
+			::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_cache,
+														"Artifact Reduction"};
 #endif
-		if (auto res = _nvcvi->NvCVImage_Transfer(_destination->get_image(), _convert_to_u8->get_image(), 1.f,
-												  _nvcuda->get_stream()->get(), _tmp->get_image());
-			res != ::streamfx::nvidia::cv::result::SUCCESS) {
-			D_LOG_ERROR("Failed to transfer processing result to output due to error: %s",
-						_nvcvi->NvCV_GetErrorStringFromCode(res));
-			throw std::runtime_error("Transfer failed.");
+			if (auto res = _nvvfx->NvVFX_Run(_ar_fx.get(), async); res != ::streamfx::nvidia::cv::result::SUCCESS) {
+				D_LOG_ERROR("Failed to reduce artifacts due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+				throw std::runtime_error("Run failed.");
+			}
+		}
+
+		{ // Process source to destination.
+#ifdef ENABLE_PROFILING
+			::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_cache, "Process"};
+#endif
+			if (auto res = _nvvfx->NvVFX_Run(_fx.get(), async); res != ::streamfx::nvidia::cv::result::SUCCESS) {
+				D_LOG_ERROR("Failed to process due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+				throw std::runtime_error("Run failed.");
+			}
 		}
 	}
 
-	{ // Copy destination to output.
+	if (_inference) { // Hand the destination back to the rendering device.
+#ifdef ENABLE_PROFILING
+		::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_copy,
+													"Copy Device -> Destination"};
+#endif
+		_inference_event->record(_inference_stream);
+		_inference_event->wait(_stream);
+		copy_peer(_destination, _peer_destination);
+	}
+
+	if (_convert_to_u8) {
+		{ // Convert Destination to Output format
+#ifdef ENABLE_PROFILING
+			::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_convert,
+														"Convert Destination -> Output"};
+#endif
+			if (auto res = _nvcvi->NvCVImage_Transfer(destination->get_image(), _convert_to_u8->get_image(), 1.f,
+													  _stream->get(), _tmp->get_image());
+				res != ::streamfx::nvidia::cv::result::SUCCESS) {
+				D_LOG_ERROR("Failed to transfer processing result to output due to error: %s",
+							_nvcvi->NvCV_GetErrorStringFromCode(res));
+				throw std::runtime_error("Transfer failed.");
+			}
+		}
+
+		{ // Copy destination to output.
+#ifdef ENABLE_PROFILING
+			::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_copy,
+														"Copy Destination -> Output"};
+#endif
+			if (auto res = _nvcvi->NvCVImage_TransferRect(_convert_to_u8->get_image(), &out_rect,
+														  _output->get_image(), &out_point, 1., _stream->get(),
+														  _tmp->get_image());
+				res != ::streamfx::nvidia::cv::result::SUCCESS) {
+				D_LOG_ERROR("Failed to transfer processing result to output due to error: %s",
+							_nvcvi->NvCV_GetErrorStringFromCode(res));
+				throw std::runtime_error("Transfer failed.");
+			}
+		}
+	} else { // Copy destination to output, the effect already produced the right format.
 #ifdef ENABLE_PROFILING
 		::streamfx::obs::gs::debug_marker profiler1{::streamfx::obs::gs::debug_color_copy,
 													"Copy Destination -> Output"};
 #endif
-		if (auto res = _nvcvi->NvCVImage_Transfer(_convert_to_u8->get_image(), _output->get_image(), 1.,
-												  _nvcuda->get_stream()->get(), _tmp->get_image());
+		if (auto res = _nvcvi->NvCVImage_TransferRect(destination->get_image(), &out_rect, _output->get_image(),
+													  &out_point, 1., _stream->get(), _tmp->get_image());
 			res != ::streamfx::nvidia::cv::result::SUCCESS) {
 			D_LOG_ERROR("Failed to transfer processing result to output due to error: %s",
 						_nvcvi->NvCV_GetErrorStringFromCode(res));
 			throw std::runtime_error("Transfer failed.");
 		}
 	}
+}
 
-	// Return output.
-	return _output->get_texture();
+uint64_t streamfx::nvidia::vfx::superresolution::memory_usage(uint32_t width, uint32_t height)
+{
+	uint64_t in_size  = static_cast<uint64_t>(width) * height;
+	uint64_t out_size = static_cast<uint64_t>(width * _scale) * static_cast<uint64_t>(height * _scale);
+
+	// Artifact Reduction adds its own BGR FP32 destination.
+	uint64_t ar_size = _ar_fx ? (in_size * 12) : 0;
+
+	switch (_format) {
+	case superresolution_format::UINT8_CHUNKY:
+		// Source, Destination and Temporary, all RGBA UINT8.
+		return ar_size + (in_size * 4) + (out_size * 4) + (out_size * 4);
+	case superresolution_format::FP16_PLANAR:
+		// Source and Destination as BGR FP16, Conversions as RGBA FP16 and RGBA UINT8, Temporary as RGBA UINT8.
+		return ar_size + (in_size * (6 + 8)) + (out_size * (6 + 4)) + (out_size * 4);
+	case superresolution_format::FP32_PLANAR:
+	default:
+		// Source and Destination as BGR FP32, Conversions as RGBA FP32 and RGBA UINT8, Temporary as RGBA UINT8.
+		return ar_size + (in_size * (12 + 16)) + (out_size * (12 + 4)) + (out_size * 4);
+	}
+}
+
+std::pair<uint32_t, uint32_t> streamfx::nvidia::vfx::superresolution::tile_size(uint32_t width, uint32_t height)
+{
+	std::pair<uint32_t, uint32_t> tile{width, height};
+	uint32_t                      columns = 1;
+	uint32_t                      rows    = 1;
+
+	// Split the longer side of the tile until the buffers fit into the budget, or the tiles can't get any smaller.
+	while ((_memory_budget != 0) && (memory_usage(tile.first, tile.second) > _memory_budget)) {
+		uint32_t w           = tile_split(width, columns + 1);
+		uint32_t h           = tile_split(height, rows + 1);
+		bool     can_split_w = (w >= min_width) && (w < tile.first);
+		bool     can_split_h = (h >= min_height) && (h < tile.second);
+
+		if (can_split_w && (!can_split_h || (tile.first >= tile.second))) {
+			columns++;
+			tile.first = w;
+		} else if (can_split_h) {
+			rows++;
+			tile.second = h;
+		} else {
+			break;
+		}
+	}
+
+	return tile;
 }
 
 void streamfx::nvidia::vfx::superresolution::resize(uint32_t width, uint32_t height)
@@ -301,40 +847,102 @@ void streamfx::nvidia::vfx::superresolution::resize(uint32_t width, uint32_t hei
 	uint32_t out_width  = static_cast<uint32_t>(width * _scale);
 	uint32_t out_height = static_cast<uint32_t>(height * _scale);
 
+	// Buffers are only as large as a single tile.
+	_tile                    = tile_size(width, height);
+	uint32_t tile_width      = _tile.first;
+	uint32_t tile_height     = _tile.second;
+	uint32_t tile_out_width  = static_cast<uint32_t>(tile_width * _scale);
+	uint32_t tile_out_height = static_cast<uint32_t>(tile_height * _scale);
+
+	// Buffer layout the effect is fed with in the current format.
+	auto pix_fmt    = ::streamfx::nvidia::cv::pixel_format::BGR;
+	auto cmp_type   = ::streamfx::nvidia::cv::component_type::FP32;
+	auto cmp_layout = ::streamfx::nvidia::cv::component_layout::PLANAR;
+	switch (_format) {
+	case superresolution_format::UINT8_CHUNKY:
+		pix_fmt    = ::streamfx::nvidia::cv::pixel_format::RGBA;
+		cmp_type   = ::streamfx::nvidia::cv::component_type::UINT8;
+		cmp_layout = ::streamfx::nvidia::cv::component_layout::CHUNKY;
+		break;
+	case superresolution_format::FP16_PLANAR:
+		cmp_type = ::streamfx::nvidia::cv::component_type::FP16;
+		break;
+	case superresolution_format::FP32_PLANAR:
+		break;
+	}
+	bool convert = (_format != superresolution_format::UINT8_CHUNKY);
+
 	auto gctx = ::streamfx::obs::gs::context();
 	auto cctx = ::streamfx::nvidia::cuda::obs::get()->get_context()->enter();
 
-	if (!_tmp) {
-		_tmp = std::make_shared<::streamfx::nvidia::cv::image>(
-			out_width, out_height, ::streamfx::nvidia::cv::pixel_format::RGBA,
-			::streamfx::nvidia::cv::component_type::UINT8, ::streamfx::nvidia::cv::component_layout::PLANAR,
-			::streamfx::nvidia::cv::memory_location::GPU, 1);
+	// Pooled buffers belong to the stream they were allocated on, so a different stream needs new ones.
+	if (_buffer_stream != _stream) {
+		_tmp.reset();
+		_source.reset();
+		_peer_source.reset();
+		_convert_to_float.reset();
+		_ar_destination.reset();
+		_destination.reset();
+		_peer_destination.reset();
+		_convert_to_u8.reset();
+		_buffer_stream = _stream;
 	}
 
-	// Input Size was changed.
-	if (!_input || !_source || (width != _input->get_texture()->get_width())
-		|| (height != _input->get_texture()->get_height())) {
-		if (_input) {
-			_input->resize(width, height);
+	if (!_tmp || (_tmp->get_image()->width != tile_out_width) || (_tmp->get_image()->height != tile_out_height)) {
+		if (_tmp) {
+			_tmp->resize(tile_out_width, tile_out_height);
 		} else {
-			_input = std::make_shared<::streamfx::nvidia::cv::texture>(width, height, GS_RGBA_UNORM);
+			_tmp = std::make_shared<::streamfx::nvidia::cv::image>(
+				tile_out_width, tile_out_height, ::streamfx::nvidia::cv::pixel_format::RGBA,
+				::streamfx::nvidia::cv::component_type::UINT8, ::streamfx::nvidia::cv::component_layout::PLANAR,
+				::streamfx::nvidia::cv::memory_location::GPU, 1, _stream);
 		}
+		reset_graphs();
+	}
+
+	// Input Size was changed.
+	if (!_input) {
+		_input = std::make_shared<::streamfx::nvidia::cv::texture>(width, height, GS_RGBA_UNORM);
+		reset_graphs();
+	} else if ((width != _input->get_texture()->get_width()) || (height != _input->get_texture()->get_height())) {
+		_input->resize(width, height);
+		reset_graphs();
+	}
 
+	// Input Size, Tile Size or Format was changed.
+	if (!_source || (tile_width != _source->get_image()->width) || (tile_height != _source->get_image()->height)
+		|| (_source->get_image()->comp_type != cmp_type)) {
 		if (_source) {
-			_source->resize(width, height);
+			_source->reallocate(tile_width, tile_height, pix_fmt, cmp_type, cmp_layout,
+								::streamfx::nvidia::cv::memory_location::GPU, 1);
 		} else {
 			_source = std::make_shared<::streamfx::nvidia::cv::image>(
-				width, height, ::streamfx::nvidia::cv::pixel_format::BGR, ::streamfx::nvidia::cv::component_type::FP32,
-				::streamfx::nvidia::cv::component_layout::PLANAR, ::streamfx::nvidia::cv::memory_location::GPU, 1);
+				tile_width, tile_height, pix_fmt, cmp_type, cmp_layout, ::streamfx::nvidia::cv::memory_location::GPU,
+				1, _inference, fx_stream());
 		}
 
-		if (_convert_to_fp32) {
-			_convert_to_fp32->resize(out_width, out_height);
+		if (!_inference) {
+			_peer_source.reset();
+		} else if (_peer_source) {
+			_peer_source->reallocate(tile_width, tile_height, pix_fmt, cmp_type, cmp_layout,
+									 ::streamfx::nvidia::cv::memory_location::GPU, 1);
 		} else {
-			_convert_to_fp32 = std::make_shared<::streamfx::nvidia::cv::image>(
-				out_width, out_height, ::streamfx::nvidia::cv::pixel_format::RGBA,
-				::streamfx::nvidia::cv::component_type::FP32, ::streamfx::nvidia::cv::component_layout::PLANAR,
-				::streamfx::nvidia::cv::memory_location::GPU, 1);
+			_peer_source = std::make_shared<::streamfx::nvidia::cv::image>(
+				tile_width, tile_height, pix_fmt, cmp_type, cmp_layout, ::streamfx::nvidia::cv::memory_location::GPU,
+				1, _stream);
+		}
+
+		if (!convert) {
+			_convert_to_float.reset();
+		} else if (_convert_to_float) {
+			_convert_to_float->reallocate(tile_width, tile_height, ::streamfx::nvidia::cv::pixel_format::RGBA,
+										  cmp_type, ::streamfx::nvidia::cv::component_layout::PLANAR,
+										  ::streamfx::nvidia::cv::memory_location::GPU, 1);
+		} else {
+			_convert_to_float = std::make_shared<::streamfx::nvidia::cv::image>(
+				tile_width, tile_height, ::streamfx::nvidia::cv::pixel_format::RGBA, cmp_type,
+				::streamfx::nvidia::cv::component_layout::PLANAR, ::streamfx::nvidia::cv::memory_location::GPU, 1,
+				_stream);
 		}
 
 		if (auto res = _nvvfx->NvVFX_SetImage(_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_INPUT_IMAGE_0,
@@ -344,34 +952,108 @@ void streamfx::nvidia::vfx::superresolution::resize(uint32_t width, uint32_t hei
 			throw std::runtime_error("SetImage failed.");
 		}
 
-		_dirty = true;
+		_ar_bound = false;
+		_dirty    = true;
+	}
+
+	// Artifact Reduction was toggled, or the Tile Size or Format was changed.
+	if (_ar_fx && !_ar_bound) {
+		if (_ar_destination) {
+			_ar_destination->reallocate(tile_width, tile_height, pix_fmt, cmp_type, cmp_layout,
+										::streamfx::nvidia::cv::memory_location::GPU, 1);
+		} else {
+			_ar_destination = std::make_shared<::streamfx::nvidia::cv::image>(
+				tile_width, tile_height, pix_fmt, cmp_type, cmp_layout, ::streamfx::nvidia::cv::memory_location::GPU,
+				1, _inference, fx_stream());
+		}
+
+		// Source -> Artifact Reduction -> Super-Resolution, without leaving the planar FP32 buffers.
+		if (auto res = _nvvfx->NvVFX_SetImage(_ar_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_INPUT_IMAGE_0,
+											  _source->get_image());
+			res != ::streamfx::nvidia::cv::result::SUCCESS) {
+			D_LOG_ERROR("Failed to set input image due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+			throw std::runtime_error("SetImage failed.");
+		}
+		if (auto res = _nvvfx->NvVFX_SetImage(_ar_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_OUTPUT_IMAGE_0,
+											  _ar_destination->get_image());
+			res != ::streamfx::nvidia::cv::result::SUCCESS) {
+			D_LOG_ERROR("Failed to set output image due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+			throw std::runtime_error("SetImage failed.");
+		}
+		if (auto res = _nvvfx->NvVFX_SetImage(_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_INPUT_IMAGE_0,
+											  _ar_destination->get_image());
+			res != ::streamfx::nvidia::cv::result::SUCCESS) {
+			D_LOG_ERROR("Failed to set input image due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+			throw std::runtime_error("SetImage failed.");
+		}
+
+		_ar_bound = true;
+		_dirty    = true;
+		reset_graphs();
+	} else if (!_ar_fx && !_ar_bound) {
+		// Artifact Reduction was turned off, so super-resolution reads straight from the source again.
+		if (auto res = _nvvfx->NvVFX_SetImage(_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_INPUT_IMAGE_0,
+											  _source->get_image());
+			res != ::streamfx::nvidia::cv::result::SUCCESS) {
+			D_LOG_ERROR("Failed to set input image due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+			throw std::runtime_error("SetImage failed.");
+		}
+
+		_ar_bound = true;
+		_dirty    = true;
+		reset_graphs();
 	}
 
 	// Input Size or Scale was changed.
-	if (!_destination || !_output || (out_width != _output->get_texture()->get_width())
+	if (!_output || (out_width != _output->get_texture()->get_width())
 		|| (out_height != _output->get_texture()->get_height())) {
+		if (_output) {
+			_output->resize(out_width, out_height);
+		} else {
+			_output = std::make_shared<::streamfx::nvidia::cv::texture>(out_width, out_height, GS_RGBA_UNORM);
+		}
+
+		// The previous result no longer matches the new size.
+		if (_output_previous) {
+			_output_previous->resize(out_width, out_height);
+		}
+		_previous_valid = false;
+		reset_graphs();
+	}
+
+	// Tile Size, Scale or Format was changed.
+	if (!_destination || (tile_out_width != _destination->get_image()->width)
+		|| (tile_out_height != _destination->get_image()->height)
+		|| (_destination->get_image()->comp_type != cmp_type)) {
 		if (_destination) {
-			_destination->resize(out_width, out_height);
+			_destination->reallocate(tile_out_width, tile_out_height, pix_fmt, cmp_type, cmp_layout,
+									 ::streamfx::nvidia::cv::memory_location::GPU, 1);
 		} else {
 			_destination = std::make_shared<::streamfx::nvidia::cv::image>(
-				out_width, out_height, ::streamfx::nvidia::cv::pixel_format::BGR,
-				::streamfx::nvidia::cv::component_type::FP32, ::streamfx::nvidia::cv::component_layout::PLANAR,
-				::streamfx::nvidia::cv::memory_location::GPU, 1);
+				tile_out_width, tile_out_height, pix_fmt, cmp_type, cmp_layout,
+				::streamfx::nvidia::cv::memory_location::GPU, 1, _inference, fx_stream());
 		}
 
-		if (_output) {
-			_output->resize(out_width, out_height);
+		if (!_inference) {
+			_peer_destination.reset();
+		} else if (_peer_destination) {
+			_peer_destination->reallocate(tile_out_width, tile_out_height, pix_fmt, cmp_type, cmp_layout,
+										  ::streamfx::nvidia::cv::memory_location::GPU, 1);
 		} else {
-			_output = std::make_shared<::streamfx::nvidia::cv::texture>(out_width, out_height, GS_RGBA_UNORM);
+			_peer_destination = std::make_shared<::streamfx::nvidia::cv::image>(
+				tile_out_width, tile_out_height, pix_fmt, cmp_type, cmp_layout,
+				::streamfx::nvidia::cv::memory_location::GPU, 1, _stream);
 		}
 
-		if (_convert_to_u8) {
-			_convert_to_u8->resize(out_width, out_height);
+		if (!convert) {
+			_convert_to_u8.reset();
+		} else if (_convert_to_u8) {
+			_convert_to_u8->resize(tile_out_width, tile_out_height);
 		} else {
 			_convert_to_u8 = std::make_shared<::streamfx::nvidia::cv::image>(
-				out_width, out_height, ::streamfx::nvidia::cv::pixel_format::RGBA,
+				tile_out_width, tile_out_height, ::streamfx::nvidia::cv::pixel_format::RGBA,
 				::streamfx::nvidia::cv::component_type::UINT8, ::streamfx::nvidia::cv::component_layout::INTERLEAVED,
-				::streamfx::nvidia::cv::memory_location::GPU, 1);
+				::streamfx::nvidia::cv::memory_location::GPU, 1, _stream);
 		}
 
 		if (auto res = _nvvfx->NvVFX_SetImage(_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_OUTPUT_IMAGE_0,
@@ -385,26 +1067,257 @@ void streamfx::nvidia::vfx::superresolution::resize(uint32_t width, uint32_t hei
 	}
 }
 
+std::shared_ptr<void> streamfx::nvidia::vfx::superresolution::create()
+{
+	auto fctx = fx_context()->enter();
+
+	::streamfx::nvidia::vfx::handle_t handle;
+	if (auto res = _nvvfx->NvVFX_CreateEffect(::streamfx::nvidia::vfx::EFFECT_SUPERRESOLUTION, &handle);
+		res != ::streamfx::nvidia::cv::result::SUCCESS) {
+		D_LOG_ERROR("Failed to create effect due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+		throw std::runtime_error("CreateEffect failed.");
+	}
+	auto fx = std::shared_ptr<void>(handle, [](::streamfx::nvidia::vfx::handle_t handle) {
+		::streamfx::nvidia::vfx::vfx::get()->NvVFX_DestroyEffect(handle);
+	});
+
+	// Assign the appropriate GPU, the CUDA stream is assigned by load().
+	if (_inference) {
+		if (auto res = _nvvfx->NvVFX_SetU32(fx.get(), ::streamfx::nvidia::vfx::PARAMETER_GPU,
+											static_cast<uint32_t>(_inference->device()));
+			res != ::streamfx::nvidia::cv::result::SUCCESS) {
+			D_LOG_ERROR("Failed to set GPU due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+			throw std::runtime_error("SetU32 failed.");
+		}
+	}
+
+	// Set the proper model directory.
+	if (auto res = _nvvfx->NvVFX_SetString(fx.get(), ::streamfx::nvidia::vfx::PARAMETER_MODEL_DIRECTORY,
+										   _nvvfx->model_path().generic_u8string().c_str());
+		res != ::streamfx::nvidia::cv::result::SUCCESS) {
+		D_LOG_ERROR("Failed to set model directory due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+		throw std::runtime_error("SetString failed.");
+	}
+
+	return fx;
+}
+
+void streamfx::nvidia::vfx::superresolution::bind()
+{
+	auto input = _ar_fx ? _ar_destination : _source;
+	if (auto res = _nvvfx->NvVFX_SetImage(_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_INPUT_IMAGE_0,
+										  input->get_image());
+		res != ::streamfx::nvidia::cv::result::SUCCESS) {
+		D_LOG_ERROR("Failed to set input image due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+		throw std::runtime_error("SetImage failed.");
+	}
+	if (auto res = _nvvfx->NvVFX_SetImage(_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_OUTPUT_IMAGE_0,
+										  _destination->get_image());
+		res != ::streamfx::nvidia::cv::result::SUCCESS) {
+		D_LOG_ERROR("Failed to set output image due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+		throw std::runtime_error("SetImage failed.");
+	}
+}
+
 void streamfx::nvidia::vfx::superresolution::load()
 {
+	::streamfx::obs::statistics::load_cost cost{::streamfx::obs::statistics::load_step::SDK};
+
 	auto gctx = ::streamfx::obs::gs::context();
+	auto fctx = fx_context()->enter();
+
+	// Pick up a finished load, or a fallback to another format that has to be loaded first.
+	if (_fx_load && !finish_load()) {
+		return;
+	}
+
+	// An effect loaded with the same configuration only needs the buffers and stream bound to it again.
+	fx_key_t key{_scale, (_strength >= .5f) ? 1u : 0u, _tile.first, _tile.second, _format};
+	auto     cached = std::find_if(_fx_cache.begin(), _fx_cache.end(), [&key](auto& kv) { return kv.key == key; });
+	if (cached != _fx_cache.end()) {
+		_fx_cache.splice(_fx_cache.begin(), _fx_cache, cached);
+		if (_fx != cached->fx) {
+			_fx = cached->fx;
+			bind();
+		}
+		_fx_loaded = true;
+	} else if (_fx_loaded) {
+		// The current effect stays loaded for its own configuration, so a new one is needed for this one.
+		_fx = create();
+		bind();
+		_fx_loaded = false;
+	}
+
 	{
-		auto cctx = ::streamfx::nvidia::cuda::obs::get()->get_context()->enter();
 		if (auto res = _nvvfx->NvVFX_SetCudaStream(_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_CUDA_STREAM,
-												   _nvcuda->get_stream()->get());
+												   fx_stream()->get());
 			res != ::streamfx::nvidia::cv::result::SUCCESS) {
 			D_LOG_ERROR("Failed to set CUDA stream due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
 			throw std::runtime_error("SetCudaStream failed.");
 		}
+
+		// Both effects share the stream, so the artifact reduction result is ready when super-resolution runs.
+		if (_ar_fx) {
+			if (auto res = _nvvfx->NvVFX_SetCudaStream(_ar_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_CUDA_STREAM,
+													   fx_stream()->get());
+				res != ::streamfx::nvidia::cv::result::SUCCESS) {
+				D_LOG_ERROR("Failed to set CUDA stream due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+				throw std::runtime_error("SetCudaStream failed.");
+			}
+			if (auto res = _nvvfx->NvVFX_Load(_ar_fx.get()); res != ::streamfx::nvidia::cv::result::SUCCESS) {
+				D_LOG_ERROR("Failed to initialize artifact reduction due to error: %s",
+							_nvcvi->NvCV_GetErrorStringFromCode(res));
+				throw std::runtime_error("Load failed.");
+			}
+		}
 	}
 
-	{
-		auto cctx = ::streamfx::nvidia::cuda::obs::get()->get_context()->enter();
-		if (auto res = _nvvfx->NvVFX_Load(_fx.get()); res != ::streamfx::nvidia::cv::result::SUCCESS) {
-			D_LOG_ERROR("Failed to initialize effect due to error: %s", _nvcvi->NvCV_GetErrorStringFromCode(res));
+	if (!_fx_loaded) {
+		uint32_t value = std::get<1>(key);
+		if (auto res = _nvvfx->NvVFX_SetU32(_fx.get(), ::streamfx::nvidia::vfx::PARAMETER_STRENGTH, value);
+			res != ::streamfx::nvidia::cv::result::SUCCESS) {
+			D_LOG_ERROR("Failed to set '%s' to %lu.", ::streamfx::nvidia::vfx::PARAMETER_STRENGTH, value);
+		};
+
+		// Stays dirty until the load finished, which the next call to load() picks up.
+		start_load(key);
+		return;
+	}
+
+	// Anything recorded so far used the previous state of the effect.
+	reset_graphs();
+	_dirty = false;
+}
+
+void streamfx::nvidia::vfx::superresolution::start_load(fx_key_t const& key)
+{
+	auto load     = std::make_shared<fx_load>();
+	load->key     = key;
+	load->fx      = _fx;
+	load->cuda    = _nvcuda->get_cuda();
+	load->context = fx_context();
+	_fx_load      = load;
+
+	_fx_load_task = streamfx::threadpool()->push(
+		[](::streamfx::util::threadpool_data_t data) {
+			auto load = std::static_pointer_cast<fx_load>(data);
+			try {
+				auto cctx = load->context->enter();
+
+				// The models are allocated by the SDK, so the difference in free memory is the closest estimate.
+				std::size_t free_before = 0, free_after = 0, total = 0;
+				if (load->cuda->cuMemGetInfo) {
+					load->cuda->cuMemGetInfo(&free_before, &total);
+				}
+				load->result = ::streamfx::nvidia::vfx::vfx::get()->NvVFX_Load(load->fx.get());
+				if (load->cuda->cuMemGetInfo) {
+					load->cuda->cuMemGetInfo(&free_after, &total);
+				}
+				load->memory = (free_before > free_after) ? (free_before - free_after) : 0;
+			} catch (...) {
+				load->result = ::streamfx::nvidia::cv::result::ERROR_GENERAL;
+			}
+			load->done = true;
+		},
+		load);
+}
+
+bool streamfx::nvidia::vfx::superresolution::finish_load()
+{
+	if (!_fx_load->done) {
+		return false;
+	}
+	auto load = std::move(_fx_load);
+	_fx_load_task.reset();
+
+	if (load->result != ::streamfx::nvidia::cv::result::SUCCESS) {
+		// Not every model accepts every format, so fall back to the next cheapest one until one loads.
+		if (_format == superresolution_format::FP32_PLANAR) {
+			D_LOG_ERROR("Failed to initialize effect due to error: %s",
+						_nvcvi->NvCV_GetErrorStringFromCode(load->result));
 			throw std::runtime_error("Load failed.");
 		}
+
+		D_LOG_INFO("Effect rejected %s buffers with error '%s', falling back to %s buffers.", cstring(_format),
+				   _nvcvi->NvCV_GetErrorStringFromCode(load->result),
+				   cstring(static_cast<superresolution_format>(static_cast<int>(_format) + 1)));
+		_format = static_cast<superresolution_format>(static_cast<int>(_format) + 1);
+		resize(_input->get_texture()->get_width(), _input->get_texture()->get_height());
+
+		std::get<4>(load->key) = _format;
+		start_load(load->key);
+		return false;
 	}
 
-	_dirty = false;
+	// Remember the effect under the configuration it loaded with, which may not be the current one anymore, and
+	// drop the least recently used one.
+	_fx_cache.push_front({load->key, load->fx, load->memory});
+	if (_fx_cache.size() > fx_cache_size) {
+		_fx_cache.pop_back();
+	}
+	_fx_loaded = true;
+	return true;
+}
+
+void streamfx::nvidia::vfx::superresolution::select_stream()
+{
+	if (_use_graphs) {
+		// Recording picks up all work on a stream, so work queued by anyone else must stay off of it.
+		_stream = std::make_shared<::streamfx::nvidia::cuda::stream>(
+			::streamfx::nvidia::cuda::stream_flags::NON_BLOCKING);
+	} else if (_asynchronous) {
+		_stream = _nvcuda->get_worker_stream();
+	} else {
+		_stream = _nvcuda->get_stream();
+	}
+
+	// The effect has to be reloaded to pick up the new stream.
+	_dirty = true;
+}
+
+std::shared_ptr<::streamfx::nvidia::cuda::context> streamfx::nvidia::vfx::superresolution::fx_context()
+{
+	return _inference ? _inference : _nvcuda->get_context();
+}
+
+std::shared_ptr<::streamfx::nvidia::cuda::stream> streamfx::nvidia::vfx::superresolution::fx_stream()
+{
+	return _inference ? _inference_stream : _stream;
+}
+
+void streamfx::nvidia::vfx::superresolution::copy_peer(std::shared_ptr<::streamfx::nvidia::cv::image> source,
+														std::shared_ptr<::streamfx::nvidia::cv::image> destination)
+{
+	auto src = source->get_image();
+	auto dst = destination->get_image();
+
+	// Planes are stored one after the other, so a planar image can be copied as if it was a single taller plane.
+	auto     layout = static_cast<::streamfx::nvidia::cv::component_layout>(src->comp_layout);
+	bool     planar = (layout == ::streamfx::nvidia::cv::component_layout::PLANAR);
+	uint32_t planes = planar ? src->num_components : 1;
+
+	::streamfx::nvidia::cuda::memcpy2d_v2_t mc;
+	memset(&mc, 0, sizeof(mc));
+	mc.src_memory_type = ::streamfx::nvidia::cuda::memory_type::UNIFIED;
+	mc.src_device      = reinterpret_cast<::streamfx::nvidia::cuda::device_ptr_t>(src->pixels);
+	mc.src_pitch       = static_cast<std::size_t>(src->pitch);
+	mc.dst_memory_type = ::streamfx::nvidia::cuda::memory_type::UNIFIED;
+	mc.dst_device      = reinterpret_cast<::streamfx::nvidia::cuda::device_ptr_t>(dst->pixels);
+	mc.dst_pitch       = static_cast<std::size_t>(dst->pitch);
+	mc.width_in_bytes  = static_cast<std::size_t>(src->width) * (planar ? src->component_bytes : src->pixel_bytes);
+	mc.height          = static_cast<std::size_t>(src->height) * planes;
+
+	// Unified addressing lets the driver copy directly between the devices, if peer access is enabled.
+	if (auto res = _nvcuda->get_cuda()->cuMemcpy2DAsync(&mc, _stream->get());
+		res != ::streamfx::nvidia::cuda::result::SUCCESS) {
+		D_LOG_ERROR("Failed to copy between devices.", 0);
+		throw ::streamfx::nvidia::cuda::cuda_error(res);
+	}
+}
+
+void streamfx::nvidia::vfx::superresolution::reset_graphs()
+{
+	_graphs.clear();
+	_graphs_settled = false;
+	_graphs_failed  = false;
 }
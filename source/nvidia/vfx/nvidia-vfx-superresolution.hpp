@@ -19,37 +19,110 @@
 // SOFTWARE.
 
 #pragma once
+#include <list>
+#include <map>
+#include <tuple>
 #include "nvidia-vfx.hpp"
+#include "nvidia/cuda/nvidia-cuda-event.hpp"
+#include "nvidia/cuda/nvidia-cuda-graph.hpp"
 #include "nvidia/cuda/nvidia-cuda-gs-texture.hpp"
 #include "nvidia/cuda/nvidia-cuda-obs.hpp"
 #include "nvidia/cuda/nvidia-cuda.hpp"
 #include "nvidia/cv/nvidia-cv-image.hpp"
 #include "nvidia/cv/nvidia-cv-texture.hpp"
 #include "obs/gs/gs-texture.hpp"
+#include "util/util-threadpool.hpp"
 
 namespace streamfx::nvidia::vfx {
+	/** Buffer format the effect is fed with, ordered from cheapest to most expensive to convert to.
+	 */
+	enum class superresolution_format {
+		UINT8_CHUNKY = 0, // RGBA, same as the textures, so only copies are needed.
+		FP16_PLANAR  = 1,
+		FP32_PLANAR  = 2,
+	};
+
+	const char* cstring(superresolution_format format);
+
 	class superresolution {
+		// Scale, Strength, Tile Width, Tile Height and Format an effect was loaded with.
+		typedef std::tuple<float, uint32_t, uint32_t, uint32_t, superresolution_format> fx_key_t;
+
 		std::shared_ptr<::streamfx::nvidia::cuda::obs> _nvcuda;
 		std::shared_ptr<::streamfx::nvidia::cv::cv>    _nvcvi;
 		std::shared_ptr<::streamfx::nvidia::vfx::vfx>  _nvvfx;
 		std::shared_ptr<void>                          _fx;
+		std::shared_ptr<void>                          _ar_fx; // Artifact Reduction, run in front of _fx.
+
+		// Loaded effects, most recently used first, along with the video memory their models took up while loading.
+		// _fx is one of them once it has been loaded.
+		struct fx_cache_entry {
+			fx_key_t              key;
+			std::shared_ptr<void> fx;
+			uint64_t              memory;
+		};
+		std::list<fx_cache_entry> _fx_cache;
+
+		// Loading the models for a new configuration takes seconds, so it happens on the threadpool.
+		struct fx_load;
+		std::shared_ptr<fx_load>                            _fx_load;
+		std::shared_ptr<::streamfx::util::threadpool::task> _fx_load_task;
 
 		std::shared_ptr<::streamfx::nvidia::cv::texture> _input;
-		std::shared_ptr<::streamfx::nvidia::cv::image>   _convert_to_fp32;
+		std::shared_ptr<::streamfx::nvidia::cv::image>   _convert_to_float;
 		std::shared_ptr<::streamfx::nvidia::cv::image>   _source;
+		std::shared_ptr<::streamfx::nvidia::cv::image>   _ar_destination; // Source of _fx while _ar_fx is in use.
 		std::shared_ptr<::streamfx::nvidia::cv::image>   _destination;
 		std::shared_ptr<::streamfx::nvidia::cv::image>   _convert_to_u8;
 		std::shared_ptr<::streamfx::nvidia::cv::texture> _output;
+		std::shared_ptr<::streamfx::nvidia::cv::texture> _output_previous;
 		std::shared_ptr<::streamfx::nvidia::cv::image>   _tmp;
 
-		float _strength;
-		float _scale;
+		std::shared_ptr<::streamfx::nvidia::cuda::stream> _stream;
+		std::shared_ptr<::streamfx::nvidia::cuda::stream> _buffer_stream; // Stream the buffers were allocated for.
+		std::shared_ptr<::streamfx::nvidia::cuda::event>  _event;
+
+		// Requested device, the rest is only set if inference runs on a different device than OBS renders with.
+		int32_t                                            _device;
+		std::shared_ptr<::streamfx::nvidia::cuda::context> _inference;
+		std::shared_ptr<::streamfx::nvidia::cuda::stream>  _inference_stream;
+		std::shared_ptr<::streamfx::nvidia::cuda::event>   _inference_event;  // Recorded on _inference_stream.
+		std::shared_ptr<::streamfx::nvidia::cuda::event>   _transfer_event;   // Recorded on _stream.
+		std::shared_ptr<::streamfx::nvidia::cv::image>     _peer_source;      // _source, on the rendering device.
+		std::shared_ptr<::streamfx::nvidia::cv::image>     _peer_destination; // _destination, on the rendering device.
+
+		// Recorded launches, one for each output they write to.
+		std::map<::streamfx::nvidia::cv::texture*, std::shared_ptr<::streamfx::nvidia::cuda::graph>> _graphs;
+
+		float                  _strength;
+		float                  _ar_strength;
+		float                  _scale;
+		bool                   _asynchronous;
+		bool                   _use_graphs;
+		superresolution_format _format;
+
+		uint64_t                      _memory_budget;
+		std::pair<uint32_t, uint32_t> _tile;
 
 		bool _dirty;
+		bool _fx_loaded;
+		bool _ar_bound;
+		bool _pending;
+		bool _previous_valid;
+		bool _graphs_settled;
+		bool _graphs_failed;
 
 		public:
 		~superresolution();
-		superresolution();
+
+		/** Create the effect on a CUDA device, or on the one OBS renders with if the device is negative.
+		 *
+		 * On any other device the source and destination are copied between the two devices around the effect,
+		 * which is cheaper than competing with rendering and encoding for the rendering device.
+		 */
+		superresolution(int32_t device = -1);
+
+		int32_t device();
 
 		void  set_strength(float strength);
 		float strength();
@@ -57,14 +130,94 @@ namespace streamfx::nvidia::vfx {
 		void  set_scale(float scale);
 		float scale();
 
+		/** Reduce compression artifacts in the input before it is upscaled.
+		 *
+		 * Both effects share the same CUDA stream and planar FP32 buffers, so the input is only converted and
+		 * transferred once for both of them.
+		 */
+		void set_artifact_reduction(bool enabled);
+		bool artifact_reduction();
+
+		void  set_artifact_reduction_strength(float strength);
+		float artifact_reduction_strength();
+
+		/** Run the effect on its own CUDA stream and present the result of the previous frame.
+		 *
+		 * process() then only waits for the previous frame to finish instead of the entire effect, at the cost of
+		 * one frame of latency.
+		 */
+		void set_asynchronous(bool asynchronous);
+		bool asynchronous();
+
+		/** Record the launches of a frame once and replay them for every following frame.
+		 *
+		 * Launches are recorded again after the buffers or the effect changed, and are issued directly if the
+		 * driver or the effect doesn't support recording them.
+		 */
+		void set_graphs(bool enabled);
+		bool graphs();
+
+		/** Limit the memory used by the processing buffers, in bytes.
+		 *
+		 * If the buffers for the full frame would exceed the budget, the effect is run over overlapping tiles that
+		 * share a single set of tile-sized buffers. A budget of 0 disables tiling.
+		 */
+		void     set_memory_budget(uint64_t budget);
+		uint64_t memory_budget();
+
+		/** Estimated memory used by the processing buffers, in bytes.
+		 */
+		uint64_t memory_usage();
+
+		/** Number of tiles the current frame is split into.
+		 */
+		uint32_t tiles();
+
+		/** Estimated video memory held by the loaded models, in bytes.
+		 */
+		uint64_t model_memory();
+
+		/** Release all loaded models, which are loaded again once the effect is used next.
+		 */
+		void idle();
+
 		void size(std::pair<uint32_t, uint32_t> const& size, std::pair<uint32_t, uint32_t>& input_size,
 				  std::pair<uint32_t, uint32_t>& output_size);
 
 		std::shared_ptr<::streamfx::obs::gs::texture> process(std::shared_ptr<::streamfx::obs::gs::texture> in);
 
 		private:
+		void process_tiles();
+
+		void process_tile(::streamfx::nvidia::cv::rect<int32_t> const&  in_rect,
+						  ::streamfx::nvidia::cv::rect<int32_t> const&  out_rect,
+						  ::streamfx::nvidia::cv::point<int32_t> const& out_point);
+
+		uint64_t memory_usage(uint32_t width, uint32_t height);
+
+		std::pair<uint32_t, uint32_t> tile_size(uint32_t width, uint32_t height);
+
 		void resize(uint32_t width, uint32_t height);
 
+		void select_stream();
+
+		std::shared_ptr<::streamfx::nvidia::cuda::context> fx_context();
+
+		std::shared_ptr<::streamfx::nvidia::cuda::stream> fx_stream();
+
+		void copy_peer(std::shared_ptr<::streamfx::nvidia::cv::image> source,
+					   std::shared_ptr<::streamfx::nvidia::cv::image> destination);
+
+		void reset_graphs();
+
+		std::shared_ptr<void> create();
+
+		void bind();
+
 		void load();
+
+		void start_load(fx_key_t const& key);
+
+		bool finish_load();
 	};
 } // namespace streamfx::nvidia::vfx
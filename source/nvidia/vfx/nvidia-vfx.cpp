@@ -23,6 +23,7 @@
 #include <mutex>
 #include "nvidia/cuda/nvidia-cuda-obs.hpp"
 #include "obs/gs/gs-helper.hpp"
+#include "obs/obs-statistics.hpp"
 #include "util/util-logging.hpp"
 #include "util/util-platform.hpp"
 
@@ -180,6 +181,8 @@ std::shared_ptr<::streamfx::nvidia::vfx::vfx> streamfx::nvidia::vfx::vfx::get()
 
 	std::unique_lock<std::mutex> ul(lock);
 	if (instance.expired()) {
+		::streamfx::obs::statistics::load_cost cost{::streamfx::obs::statistics::load_step::SDK};
+
 		auto hard_instance = std::make_shared<streamfx::nvidia::vfx::vfx>();
 		instance           = hard_instance;
 		return hard_instance;
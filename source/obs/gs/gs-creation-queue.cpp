@@ -0,0 +1,126 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "gs-creation-queue.hpp"
+#include "obs/gs/gs-helper.hpp"
+#include "plugin.hpp"
+
+#define ST_PREFIX "<gs::creation_queue> "
+
+// At most this much time of every tick is spent on queued work, but always at least one task.
+constexpr std::chrono::nanoseconds slice = std::chrono::milliseconds(2);
+
+static std::shared_ptr<streamfx::obs::gs::creation_queue> _creation_queue_instance;
+
+streamfx::obs::gs::creation_queue::creation_queue()
+	: _lock(), _tasks(), _slice(slice), _done(), _running(nullptr), _running_thread()
+{
+	obs_add_tick_callback(tick, this);
+}
+
+streamfx::obs::gs::creation_queue::~creation_queue()
+{
+	obs_remove_tick_callback(tick, this);
+}
+
+void streamfx::obs::gs::creation_queue::push(const void* owner, std::function<void()> task)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	_tasks.emplace_back(owner, std::move(task));
+}
+
+void streamfx::obs::gs::creation_queue::cancel(const void* owner)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	_tasks.remove_if([owner](const auto& kv) { return kv.first == owner; });
+
+	// A task that cancels its own owner is done once it returns, waiting for it would never end.
+	if (_running_thread != std::this_thread::get_id()) {
+		_done.wait(lock, [this, owner]() { return _running != owner; });
+	}
+}
+
+std::size_t streamfx::obs::gs::creation_queue::size()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	return _tasks.size();
+}
+
+void streamfx::obs::gs::creation_queue::drain()
+{
+	if (size() == 0) {
+		return;
+	}
+
+	// The graphics context is entered before the lock, like everyone calling cancel() with it held does.
+	auto gctx  = streamfx::obs::gs::context();
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::unique_lock<std::mutex> lock(_lock);
+	while (!_tasks.empty()) {
+		// Tasks may render a whole chain of sources, so the lock is not held while they run. Only cancel() for the
+		// same owner waits for the task, everyone else can push and cancel in the meantime.
+		auto [owner, task] = std::move(_tasks.front());
+		_tasks.pop_front();
+		_running        = owner;
+		_running_thread = std::this_thread::get_id();
+		lock.unlock();
+
+		try {
+			task();
+		} catch (const std::exception& ex) {
+			DLOG_ERROR(ST_PREFIX "Queued task failed: %s", ex.what());
+		} catch (...) {
+			DLOG_ERROR(ST_PREFIX "Queued task failed.");
+		}
+
+		lock.lock();
+		_running        = nullptr;
+		_running_thread = std::thread::id();
+		_done.notify_all();
+
+		if ((std::chrono::high_resolution_clock::now() - start) >= _slice) {
+			break;
+		}
+	}
+}
+
+void streamfx::obs::gs::creation_queue::tick(void* ptr, float_t) noexcept
+try {
+	reinterpret_cast<streamfx::obs::gs::creation_queue*>(ptr)->drain();
+} catch (const std::exception& ex) {
+	DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
+} catch (...) {
+	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+}
+
+void streamfx::obs::gs::creation_queue::initialize()
+{
+	_creation_queue_instance = std::make_shared<streamfx::obs::gs::creation_queue>();
+}
+
+void streamfx::obs::gs::creation_queue::finalize()
+{
+	_creation_queue_instance.reset();
+}
+
+std::shared_ptr<streamfx::obs::gs::creation_queue> streamfx::obs::gs::creation_queue::get()
+{
+	return _creation_queue_instance;
+}
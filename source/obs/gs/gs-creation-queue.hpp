@@ -0,0 +1,67 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace streamfx::obs::gs {
+	/** Queue of graphics work that does not have to happen right away, like creating the resources of a new instance.
+	 *
+	 * Creating many instances at once, for example while a scene collection loads, would otherwise hold the graphics
+	 * context for a long time and stall rendering. Instead, queued work is done at tick time in short slices, and has
+	 * the graphics context entered for it. Owners must cancel their work before they go away.
+	 */
+	class creation_queue {
+		std::mutex                                               _lock;
+		std::list<std::pair<const void*, std::function<void()>>> _tasks;
+		std::chrono::nanoseconds                                 _slice;
+		std::condition_variable                                  _done;
+		const void*                                              _running; // Owner of the task being done.
+		std::thread::id                                          _running_thread;
+
+		public:
+		creation_queue();
+		~creation_queue();
+
+		/** Queue work for owner, which is done in order with all other queued work. */
+		void push(const void* owner, std::function<void()> task);
+
+		/** Drop all work queued by owner, waiting for it if it is being done right now. */
+		void cancel(const void* owner);
+
+		std::size_t size();
+
+		private:
+		void drain();
+
+		static void tick(void* ptr, float_t seconds) noexcept;
+
+		public /* Singleton */:
+		static void                                               initialize();
+		static void                                               finalize();
+		static std::shared_ptr<streamfx::obs::gs::creation_queue> get();
+	};
+} // namespace streamfx::obs::gs
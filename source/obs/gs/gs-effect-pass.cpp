@@ -40,9 +40,12 @@ streamfx::obs::gs::effect_pass::~effect_pass() {}
 
 std::string streamfx::obs::gs::effect_pass::name()
 {
-	const char* name_c   = get()->name;
-	std::size_t name_len = strnlen(name_c, 256);
-	return name_c ? std::string(name_c, name_c + name_len) : std::string();
+	const char* name_c = get()->name;
+	if (!name_c) {
+		// Passes don't need to be named.
+		return std::string();
+	}
+	return std::string(name_c, name_c + strnlen(name_c, 256));
 }
 
 std::size_t streamfx::obs::gs::effect_pass::count_vertex_parameters()
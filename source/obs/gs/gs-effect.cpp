@@ -18,10 +18,14 @@
  */
 
 #include "gs-effect.hpp"
+#include <cctype>
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <stdexcept>
 #include <vector>
 #include "obs/gs/gs-helper.hpp"
+#include "obs/obs-statistics.hpp"
 
 #define MAX_EFFECT_SIZE 32 * 1024 * 1024
 
@@ -43,12 +47,76 @@ static std::string load_file_as_code(std::filesystem::path file)
 	return std::string(buf.data(), buf.data() + size);
 }
 
+static std::string load_file_as_code(std::filesystem::path file, const std::vector<std::string>& defines)
+{
+	std::string code;
+	for (auto& define : defines) {
+		code.append("#define ").append(define).append("\n");
+	}
+	return code.append(load_file_as_code(file));
+}
+
+static inline bool is_identifier(char chr)
+{
+	return std::isalnum(static_cast<unsigned char>(chr)) || (chr == '_');
+}
+
+static std::string load_file_as_code(std::filesystem::path file, const std::map<std::string, std::string>& constants)
+{
+	std::string code = load_file_as_code(file);
+
+	// Find every "uniform <type> <name>" declaration, and define the name as its constant right after it. Everything
+	// that follows then reads the constant instead, while the declaration itself is left alone.
+	for (std::size_t pos = code.find("uniform"); pos != std::string::npos; pos = code.find("uniform", pos + 1)) {
+		std::size_t end = pos + 7;
+		if (((pos > 0) && is_identifier(code[pos - 1])) || ((end < code.size()) && is_identifier(code[end])))
+			continue;
+
+		auto skip = [&code](std::size_t at, bool identifier) {
+			for (; at < code.size(); at++) {
+				bool is_space = std::isspace(static_cast<unsigned char>(code[at])) != 0;
+				if (identifier ? !is_identifier(code[at]) : !is_space)
+					break;
+			}
+			return at;
+		};
+		std::size_t type_end   = skip(skip(end, false), true);
+		std::size_t name_begin = skip(type_end, false);
+		std::size_t name_end   = skip(name_begin, true);
+		if ((name_end == name_begin) || (name_begin == type_end))
+			continue;
+
+		auto constant = constants.find(code.substr(name_begin, name_end - name_begin));
+		if (constant == constants.end())
+			continue;
+
+		// Annotations may contain semicolons of their own.
+		std::size_t term = skip(name_end, false);
+		if ((term < code.size()) && (code[term] == '<'))
+			term = code.find('>', term);
+		if (term != std::string::npos)
+			term = code.find(';', term);
+		if (term == std::string::npos)
+			break;
+
+		std::string define = "\n#define " + constant->first + " (" + constant->second + ")\n";
+		code.insert(term + 1, define);
+		pos = term + define.size();
+	}
+
+	return code;
+}
+
 streamfx::obs::gs::effect::effect(const std::string& code, const std::string& name)
 {
 	auto gctx = streamfx::obs::gs::context();
 
 	char*        error_buffer = nullptr;
-	gs_effect_t* effect       = gs_effect_create(code.c_str(), name.c_str(), &error_buffer);
+	gs_effect_t* effect       = nullptr;
+	{
+		streamfx::obs::statistics::load_cost cost{streamfx::obs::statistics::load_step::Effects};
+		effect = gs_effect_create(code.c_str(), name.c_str(), &error_buffer);
+	}
 
 	if (!effect) {
 		throw error_buffer ? std::runtime_error(error_buffer)
@@ -60,6 +128,49 @@ streamfx::obs::gs::effect::effect(const std::string& code, const std::string& na
 
 streamfx::obs::gs::effect::effect(std::filesystem::path file) : effect(load_file_as_code(file), file.u8string()) {}
 
+streamfx::obs::gs::effect::effect(std::filesystem::path file, const std::vector<std::string>& defines)
+	: effect(load_file_as_code(file, defines), file.u8string())
+{}
+
+streamfx::obs::gs::effect streamfx::obs::gs::effect::create_shared(std::filesystem::path file)
+{
+	return create_shared(file, {});
+}
+
+streamfx::obs::gs::effect streamfx::obs::gs::effect::create_shared(std::filesystem::path           file,
+																   const std::vector<std::string>& defines)
+{
+	static std::mutex                                                              lock;
+	static std::map<std::pair<std::string, uint64_t>, std::weak_ptr<gs_effect_t>> cache;
+
+	// Keyed by content as well as path, as includes are resolved relative to the path. The defines are part of the
+	// content, so every variant of an effect is compiled once and then shared as well.
+	std::string code = load_file_as_code(file, defines);
+	uint64_t    hash = 14695981039346656037ull; // FNV-1a
+	for (char chr : code) {
+		hash = (hash ^ static_cast<uint8_t>(chr)) * 1099511628211ull;
+	}
+	auto key = std::make_pair(file.u8string(), hash);
+
+	std::unique_lock<std::mutex> ul(lock);
+	for (auto iter = cache.begin(); iter != cache.end();) {
+		if (iter->second.expired()) {
+			iter = cache.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+
+	streamfx::obs::gs::effect value;
+	if (auto iter = cache.find(key); iter != cache.end()) {
+		static_cast<std::shared_ptr<gs_effect_t>&>(value) = iter->second.lock();
+	} else {
+		value      = streamfx::obs::gs::effect(code, key.first);
+		cache[key] = value;
+	}
+	return value;
+}
+
 streamfx::obs::gs::effect::~effect()
 {
 	auto gctx = streamfx::obs::gs::context();
@@ -139,3 +250,41 @@ bool streamfx::obs::gs::effect::has_parameter(const std::string& name, effect_pa
 		return eprm.get_type() == type;
 	return false;
 }
+
+streamfx::obs::gs::effect_permutations::effect_permutations() : _file(), _features(), _variants() {}
+
+streamfx::obs::gs::effect_permutations::effect_permutations(std::filesystem::path    file,
+															 std::vector<std::string> features)
+	: _file(file), _features(std::move(features)), _variants()
+{}
+
+streamfx::obs::gs::effect streamfx::obs::gs::effect_permutations::get(uint64_t mask)
+{
+	if (auto found = _variants.find(mask); found != _variants.end()) {
+		return found->second;
+	}
+
+	std::vector<std::string> defines;
+	for (std::size_t idx = 0; idx < _features.size(); idx++) {
+		if (mask & (1ull << idx)) {
+			defines.push_back(_features[idx]);
+		}
+	}
+
+	auto& variant = _variants[mask];
+	variant       = create_shared(_file, defines);
+	return variant;
+}
+
+streamfx::obs::gs::effect
+	streamfx::obs::gs::effect::create_specialized(std::filesystem::path                     file,
+												  const std::map<std::string, std::string>& constants)
+{
+	// Every set of values is its own effect, so there is nothing to share.
+	return streamfx::obs::gs::effect(load_file_as_code(file, constants), file.u8string());
+}
+
+void streamfx::obs::gs::effect_permutations::clear()
+{
+	_variants.clear();
+}
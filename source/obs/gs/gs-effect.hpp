@@ -19,8 +19,11 @@
 
 #pragma once
 #include "common.hpp"
+#include <array>
 #include <filesystem>
 #include <list>
+#include <map>
+#include <vector>
 #include "gs-effect-parameter.hpp"
 #include "gs-effect-technique.hpp"
 
@@ -30,6 +33,8 @@ namespace streamfx::obs::gs {
 		effect(){};
 		effect(const std::string& code, const std::string& name);
 		effect(std::filesystem::path file);
+		/** Load an effect file with each of the given names defined, to compile only the code paths that are needed. */
+		effect(std::filesystem::path file, const std::vector<std::string>& defines);
 		~effect();
 
 		std::size_t                         count_techniques();
@@ -58,5 +63,79 @@ namespace streamfx::obs::gs {
 		{
 			return streamfx::obs::gs::effect(code, name);
 		};
+
+		public:
+		/** Load an effect file, sharing the compiled effect with everyone else who loaded the same code from the same
+		 * path. Parameter values are shared as well, so this is only meant for users which set all parameters before
+		 * every draw.
+		 */
+		static streamfx::obs::gs::effect create_shared(std::filesystem::path file);
+		static streamfx::obs::gs::effect create_shared(std::filesystem::path file,
+													   const std::vector<std::string>& defines);
+
+		/** Load an effect file with some of its uniforms replaced by constant expressions, so that the compiler can
+		 * fold them. The uniforms stay declared and can still be set, but the code no longer reads them.
+		 */
+		static streamfx::obs::gs::effect create_specialized(std::filesystem::path                     file,
+															const std::map<std::string, std::string>& constants);
+	};
+
+	/** Variants of one effect file, each compiled with only the features that it needs.
+	 *
+	 * Features are the bits of a mask, and every set bit defines the name at the same index before compiling. Users
+	 * pick the variant that matches their current settings instead of branching on uniforms at runtime, so that no
+	 * variant contains code or texture fetches it never uses. Variants are compiled on first use and are shared with
+	 * everyone else who uses the same file, see create_shared().
+	 */
+	class effect_permutations {
+		std::filesystem::path      _file;
+		std::vector<std::string>   _features;
+		std::map<uint64_t, effect> _variants;
+
+		public:
+		effect_permutations();
+		effect_permutations(std::filesystem::path file, std::vector<std::string> features);
+
+		/** Get the variant for exactly the features in mask.
+		 *
+		 * Throws if the variant fails to compile. Failed variants are remembered, so later calls return an empty effect
+		 * instead of compiling them again every frame.
+		 */
+		effect get(uint64_t mask);
+
+		void clear();
+	};
+
+	/** Parameters of an effect, looked up by name once instead of on every use.
+	 *
+	 * Users list the names in the same order as an enumeration of their own, and then refer to the parameters by
+	 * that enumeration. Parameters that the effect does not have are left empty. Holds on to the effect, so it must
+	 * be reset whenever the effect is replaced or released.
+	 */
+	template<std::size_t N>
+	class effect_parameters {
+		std::array<effect_parameter, N> _parameters;
+
+		public:
+		effect_parameters() : _parameters() {}
+		effect_parameters(effect fx, const std::array<const char*, N>& names) : _parameters()
+		{
+			if (!fx) {
+				return;
+			}
+			for (std::size_t idx = 0; idx < N; idx++) {
+				_parameters[idx] = fx.get_parameter(names[idx]);
+			}
+		}
+
+		inline effect_parameter& operator[](std::size_t idx)
+		{
+			return _parameters[idx];
+		}
+
+		inline void reset()
+		{
+			_parameters.fill(effect_parameter());
+		}
 	};
 } // namespace streamfx::obs::gs
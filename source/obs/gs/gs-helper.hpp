@@ -21,6 +21,7 @@
 #include "common.hpp"
 #include <vector>
 #include "plugin.hpp"
+#include "util/util-memory.hpp"
 
 namespace streamfx::obs::gs {
 	class context {
@@ -64,21 +65,25 @@ namespace streamfx::obs::gs {
 	static const float_t* debug_color_render       = debug_color_teal;
 
 	class debug_marker {
-		std::string _name;
-
 		public:
 		inline debug_marker(const float_t color[4], const char* format, ...)
 		{
-			std::size_t       size;
-			std::vector<char> buffer(64);
+			// The graphics backend copies the name right away, so it only has to live for the call.
+			streamfx::util::frame_vector<char> buffer(64);
 
 			va_list vargs;
 			va_start(vargs, format);
-			size = static_cast<size_t>(vsnprintf(buffer.data(), buffer.size(), format, vargs));
+			va_list vargs2;
+			va_copy(vargs2, vargs);
+			int size = vsnprintf(buffer.data(), buffer.size(), format, vargs);
+			if ((size >= 0) && (static_cast<std::size_t>(size) >= buffer.size())) {
+				buffer.resize(static_cast<std::size_t>(size) + 1);
+				vsnprintf(buffer.data(), buffer.size(), format, vargs2);
+			}
+			va_end(vargs2);
 			va_end(vargs);
 
-			_name = std::string(buffer.data(), buffer.data() + size);
-			gs_debug_marker_begin(color, _name.c_str());
+			gs_debug_marker_begin(color, buffer.data());
 		}
 
 		inline ~debug_marker()
@@ -21,6 +21,8 @@
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
 #include "plugin.hpp"
+#include "util/util-library.hpp"
+#include "util/utility.hpp"
 
 #ifdef _WIN32
 #ifdef _MSC_VER
@@ -36,52 +38,142 @@
 #endif
 #endif
 
+// OpenGL is not linked against, so only the handful of functions and enumerations needed here are declared.
+#if defined(_WIN32)
+#define ST_GLAPI __stdcall
+#define ST_GL_LIBRARY "opengl32.dll"
+#elif defined(__APPLE__)
+#define ST_GLAPI
+#define ST_GL_LIBRARY "/System/Library/Frameworks/OpenGL.framework/OpenGL"
+#else
+#define ST_GLAPI
+#define ST_GL_LIBRARY "libGL.so.1"
+#define ST_EGL_LIBRARY "libEGL.so.1"
+#endif
+
+#define ST_GL_TEXTURE_2D 0x0DE1
+#define ST_GL_TEXTURE_BINDING_2D 0x8069
+#define ST_GL_TEXTURE_MAX_LEVEL 0x813D
+#define ST_GL_READ_FRAMEBUFFER 0x8CA8
+#define ST_GL_READ_FRAMEBUFFER_BINDING 0x8CAA
+#define ST_GL_COLOR_ATTACHMENT0 0x8CE0
+
+namespace {
+	struct opengl {
+		typedef void*(ST_GLAPI* get_proc_address_t)(const char* name);
+
+		void(ST_GLAPI* glGetIntegerv)(uint32_t pname, int32_t* data)                                       = nullptr;
+		void(ST_GLAPI* glBindTexture)(uint32_t target, uint32_t texture)                                   = nullptr;
+		void(ST_GLAPI* glGetTexParameteriv)(uint32_t target, uint32_t pname, int32_t* params)              = nullptr;
+		void(ST_GLAPI* glTexParameteri)(uint32_t target, uint32_t pname, int32_t param)                    = nullptr;
+		void(ST_GLAPI* glGenerateMipmap)(uint32_t target)                                                  = nullptr;
+		void(ST_GLAPI* glGenFramebuffers)(int32_t n, uint32_t* framebuffers)                               = nullptr;
+		void(ST_GLAPI* glDeleteFramebuffers)(int32_t n, const uint32_t* framebuffers)                      = nullptr;
+		void(ST_GLAPI* glBindFramebuffer)(uint32_t target, uint32_t framebuffer)                           = nullptr;
+		void(ST_GLAPI* glFramebufferTexture2D)(uint32_t target, uint32_t attachment, uint32_t textarget,
+											   uint32_t texture, int32_t level)                            = nullptr;
+		void(ST_GLAPI* glCopyTexSubImage2D)(uint32_t target, int32_t level, int32_t xoffset, int32_t yoffset, int32_t x,
+											int32_t y, int32_t width, int32_t height)                      = nullptr;
+		void(ST_GLAPI* glCopyImageSubData)(uint32_t src, uint32_t src_target, int32_t src_level, int32_t src_x,
+										   int32_t src_y, int32_t src_z, uint32_t dst, uint32_t dst_target,
+										   int32_t dst_level, int32_t dst_x, int32_t dst_y, int32_t dst_z,
+										   int32_t width, int32_t height, int32_t depth) = nullptr; // 4.3 or newer.
+
+		std::shared_ptr<streamfx::util::library> _library;
+		get_proc_address_t                       _get_proc_address = nullptr;
+		bool                                     _available        = false;
+
+		opengl()
+		{
+			try {
+				// Functions past OpenGL 1.1 have to be asked for through the loader of whatever created the context.
+#if defined(_WIN32)
+				_library          = streamfx::util::library::load(std::string_view(ST_GL_LIBRARY));
+				_get_proc_address = reinterpret_cast<get_proc_address_t>(_library->load_symbol("wglGetProcAddress"));
+#elif defined(__APPLE__)
+				_library = streamfx::util::library::load(std::string_view(ST_GL_LIBRARY));
+#else
+				try {
+					auto egl = streamfx::util::library::load(std::string_view(ST_EGL_LIBRARY));
+					auto egl_get_current_context =
+						reinterpret_cast<void*(ST_GLAPI*)()>(egl->load_symbol("eglGetCurrentContext"));
+					if (egl_get_current_context && egl_get_current_context()) {
+						_library = egl;
+						_get_proc_address =
+							reinterpret_cast<get_proc_address_t>(_library->load_symbol("eglGetProcAddress"));
+					}
+				} catch (...) {
+				}
+				if (!_get_proc_address) {
+					_library          = streamfx::util::library::load(std::string_view(ST_GL_LIBRARY));
+					_get_proc_address =
+						reinterpret_cast<get_proc_address_t>(_library->load_symbol("glXGetProcAddressARB"));
+				}
+#endif
+
+				load(glGetIntegerv, "glGetIntegerv");
+				load(glBindTexture, "glBindTexture");
+				load(glGetTexParameteriv, "glGetTexParameteriv");
+				load(glTexParameteri, "glTexParameteri");
+				load(glGenerateMipmap, "glGenerateMipmap");
+				load(glGenFramebuffers, "glGenFramebuffers");
+				load(glDeleteFramebuffers, "glDeleteFramebuffers");
+				load(glBindFramebuffer, "glBindFramebuffer");
+				load(glFramebufferTexture2D, "glFramebufferTexture2D");
+				load(glCopyTexSubImage2D, "glCopyTexSubImage2D");
+				load(glCopyImageSubData, "glCopyImageSubData");
+
+				_available = glGetIntegerv && glBindTexture && glGetTexParameteriv && glTexParameteri
+							 && glGenerateMipmap
+							 && (glCopyImageSubData
+								 || (glGenFramebuffers && glDeleteFramebuffers && glBindFramebuffer
+									 && glFramebufferTexture2D && glCopyTexSubImage2D));
+			} catch (...) {
+				_available = false;
+			}
+		}
+
+		template<typename T>
+		void load(T& function, const char* name)
+		{
+			void* ptr = nullptr;
+			if (_get_proc_address) {
+				ptr = _get_proc_address(name);
+			}
+			if (!ptr) {
+				ptr = _library->load_symbol(name);
+			}
+			function = reinterpret_cast<T>(ptr);
+		}
+
+		// Only valid while the OpenGL context of libobs is current.
+		static opengl& get()
+		{
+			static opengl instance;
+			return instance;
+		}
+	};
+} // namespace
+
 streamfx::obs::gs::mipmapper::~mipmapper()
 {
-	_vb.reset();
 	_rt.reset();
 	_effect.reset();
 }
 
 streamfx::obs::gs::mipmapper::mipmapper()
 {
-	_vb = std::make_unique<streamfx::obs::gs::vertex_buffer>(uint32_t(3u), uint8_t(1u));
-
-	{
-		auto vtx        = _vb->at(0);
-		vtx.position->x = 0;
-		vtx.position->y = 0;
-		vtx.uv[0]->x    = 0;
-		vtx.uv[0]->y    = 0;
-	}
-	{
-		auto vtx        = _vb->at(1);
-		vtx.position->x = 0.;
-		vtx.position->y = 2.;
-		vtx.uv[0]->x    = 0.;
-		vtx.uv[0]->y    = 2.;
-	}
-	{
-		auto vtx        = _vb->at(2);
-		vtx.position->x = 2.;
-		vtx.position->y = 0.;
-		vtx.uv[0]->x    = 2.;
-		vtx.uv[0]->y    = 0.;
-	}
-
-	_vb->update();
-
-	_effect = streamfx::obs::gs::effect::create(streamfx::data_file_path("effects/mipgen.effect").u8string());
+	_effect = streamfx::obs::gs::effect::create_shared(streamfx::data_file_path("effects/mipgen.effect"));
 }
 
 void streamfx::obs::gs::mipmapper::rebuild(std::shared_ptr<streamfx::obs::gs::texture> source,
-										   std::shared_ptr<streamfx::obs::gs::texture> target)
+										   std::shared_ptr<streamfx::obs::gs::texture> target, std::size_t levels)
 {
 	{ // Validate arguments and structure.
 		if (!source || !target)
 			return; // Do nothing if source or target are missing.
 
-		if (!_vb || !_effect)
+		if (!_effect)
 			return; // Do nothing if the necessary data failed to load.
 
 		// Ensure texture sizes match
@@ -121,8 +213,16 @@ void streamfx::obs::gs::mipmapper::rebuild(std::shared_ptr<streamfx::obs::gs::te
 		d3d_device->GetImmediateContext(&d3d_context);
 	}
 #endif
+	opengl*  gl        = nullptr;
+	uint32_t gl_source = 0;
+	uint32_t gl_target = 0;
 	if (gs_get_device_type() == GS_DEVICE_OPENGL) {
-		// FixMe! Implement OpenGL
+		if (opengl::get()._available) {
+			gl = &opengl::get();
+			// libobs hands out a pointer to the texture name instead of the name itself.
+			gl_source = *reinterpret_cast<uint32_t*>(gs_texture_get_obj(source->get_object()));
+			gl_target = *reinterpret_cast<uint32_t*>(gs_texture_get_obj(target->get_object()));
+		}
 	}
 
 	// Use different methods for different types of textures.
@@ -131,6 +231,9 @@ void streamfx::obs::gs::mipmapper::rebuild(std::shared_ptr<streamfx::obs::gs::te
 			uint32_t width         = source->get_width();
 			uint32_t height        = source->get_height();
 			size_t   max_mip_level = 1;
+#ifdef _WIN32
+			D3D11_TEXTURE2D_DESC td = {};
+#endif
 
 			{
 #ifdef ENABLE_PROFILING
@@ -141,7 +244,6 @@ void streamfx::obs::gs::mipmapper::rebuild(std::shared_ptr<streamfx::obs::gs::te
 #ifdef _WIN32
 				if (gs_get_device_type() == GS_DEVICE_DIRECT3D_11) {
 					{ // Retrieve maximum mip map level.
-						D3D11_TEXTURE2D_DESC td;
 						static_cast<ID3D11Texture2D*>(d3d_target)->GetDesc(&td);
 						max_mip_level = td.MipLevels;
 					}
@@ -150,77 +252,188 @@ void streamfx::obs::gs::mipmapper::rebuild(std::shared_ptr<streamfx::obs::gs::te
 					d3d_context->CopySubresourceRegion(d3d_target, 0, 0, 0, 0, d3d_source, 0, nullptr);
 				}
 #endif
-				if (gs_get_device_type() == GS_DEVICE_OPENGL) {
-					// FixMe! Implement OpenGL
+				if (gl) {
+					// libobs tracks its own bindings, so whatever is changed here has to be put back.
+					int32_t old_texture = 0;
+					gl->glGetIntegerv(ST_GL_TEXTURE_BINDING_2D, &old_texture);
+					gl->glBindTexture(ST_GL_TEXTURE_2D, gl_target);
+
+					{ // Retrieve maximum mip map level, which libobs sets to the number of levels it allocated.
+						int32_t max_level = 0;
+						gl->glGetTexParameteriv(ST_GL_TEXTURE_2D, ST_GL_TEXTURE_MAX_LEVEL, &max_level);
+						size_t chain_levels = 1
+											  + std::max(streamfx::util::math::get_power_of_two_exponent_ceil(width),
+														 streamfx::util::math::get_power_of_two_exponent_ceil(height));
+						max_mip_level = std::min<size_t>(static_cast<size_t>(max_level) + 1, chain_levels);
+					}
+
+					// Copy mip level 0 across textures.
+					if (gl->glCopyImageSubData) {
+						gl->glCopyImageSubData(gl_source, ST_GL_TEXTURE_2D, 0, 0, 0, 0, gl_target, ST_GL_TEXTURE_2D, 0,
+											   0, 0, 0, static_cast<int32_t>(width), static_cast<int32_t>(height), 1);
+					} else { // Older than 4.3, which includes every version macOS has.
+						int32_t  old_fbo = 0;
+						uint32_t fbo     = 0;
+						gl->glGetIntegerv(ST_GL_READ_FRAMEBUFFER_BINDING, &old_fbo);
+						gl->glGenFramebuffers(1, &fbo);
+						gl->glBindFramebuffer(ST_GL_READ_FRAMEBUFFER, fbo);
+						gl->glFramebufferTexture2D(ST_GL_READ_FRAMEBUFFER, ST_GL_COLOR_ATTACHMENT0, ST_GL_TEXTURE_2D,
+												   gl_source, 0);
+						gl->glCopyTexSubImage2D(ST_GL_TEXTURE_2D, 0, 0, 0, 0, 0, static_cast<int32_t>(width),
+												static_cast<int32_t>(height));
+						gl->glBindFramebuffer(ST_GL_READ_FRAMEBUFFER, static_cast<uint32_t>(old_fbo));
+						gl->glDeleteFramebuffers(1, &fbo);
+					}
+
+					gl->glBindTexture(ST_GL_TEXTURE_2D, static_cast<uint32_t>(old_texture));
 				}
 			}
 
 			// Do we even need to do anything here?
-			if (max_mip_level == 1)
+			size_t last_mip_level = std::min(max_mip_level, levels);
+			if (last_mip_level <= 1)
 				break;
 
-			// Render each mip map level.
-			for (size_t mip = 1; mip < max_mip_level; mip++) {
+#ifdef _WIN32
+			// Let the driver build the chain if the texture supports it, which avoids all of the copies below.
+			if ((gs_get_device_type() == GS_DEVICE_DIRECT3D_11) && (td.MiscFlags & D3D11_RESOURCE_MISC_GENERATE_MIPS)
+				&& (td.BindFlags & D3D11_BIND_RENDER_TARGET) && (td.BindFlags & D3D11_BIND_SHADER_RESOURCE)) {
 #ifdef ENABLE_PROFILING
 				auto cctr = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance,
-															"Mip Level %" PRIuMAX, mip);
+															"Mip Level 1-%" PRIuMAX, last_mip_level - 1);
 #endif
 
-				uint32_t cwidth  = std::max<uint32_t>(width >> mip, 1);
-				uint32_t cheight = std::max<uint32_t>(height >> mip, 1);
-				float_t  iwidth  = 1.f / static_cast<float_t>(cwidth);
-				float_t  iheight = 1.f / static_cast<float_t>(cheight);
-
-				// Set up rendering state.
-				gs_load_vertexbuffer(_vb->update(false));
-				gs_load_indexbuffer(nullptr);
-				gs_blend_state_push();
-				gs_reset_blend_state();
-				gs_enable_blending(false);
-				gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
-				gs_enable_color(true, true, true, true);
-				gs_enable_depth_test(false);
-				gs_enable_stencil_test(false);
-				gs_enable_stencil_write(false);
-				gs_set_cull_mode(GS_NEITHER);
-				try {
-					auto op = _rt->render(width, height);
-					gs_set_viewport(0, 0, static_cast<int>(cwidth), static_cast<int>(cheight));
-					gs_ortho(0, 1, 0, 1, 0, 1);
+				// Typeless resources need a typed view, so pick the one libobs would use.
+				D3D11_SHADER_RESOURCE_VIEW_DESC srvd = {};
+				srvd.Format                          = td.Format;
+				switch (td.Format) {
+				case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+					srvd.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+					break;
+				case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+					srvd.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+					break;
+				case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+					srvd.Format = DXGI_FORMAT_B8G8R8X8_UNORM;
+					break;
+				default:
+					break;
+				}
+				srvd.ViewDimension             = D3D11_SRV_DIMENSION_TEXTURE2D;
+				srvd.Texture2D.MostDetailedMip = 0;
+				srvd.Texture2D.MipLevels       = UINT(last_mip_level);
+
+				ID3D11ShaderResourceView* srv = nullptr;
+				if (SUCCEEDED(d3d_device->CreateShaderResourceView(d3d_target, &srvd, &srv))) {
+					d3d_context->GenerateMips(srv);
+					srv->Release();
+					break;
+				}
+			}
+#endif
 
-					vec4 black = {1., 1., 1., 1};
-					gs_clear(GS_CLEAR_COLOR | GS_CLEAR_DEPTH, &black, 0, 0);
+			// OpenGL can always build the chain itself, and the render loop below has no way to copy into it.
+			if (gl) {
+#ifdef ENABLE_PROFILING
+				auto cctr = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance,
+															"Mip Level 1-%" PRIuMAX, last_mip_level - 1);
+#endif
+
+				int32_t old_texture = 0;
+				gl->glGetIntegerv(ST_GL_TEXTURE_BINDING_2D, &old_texture);
+				gl->glBindTexture(ST_GL_TEXTURE_2D, gl_target);
+
+				// Limit generation to the requested levels, then restore the range libobs set up.
+				int32_t max_level = 0;
+				gl->glGetTexParameteriv(ST_GL_TEXTURE_2D, ST_GL_TEXTURE_MAX_LEVEL, &max_level);
+				gl->glTexParameteri(ST_GL_TEXTURE_2D, ST_GL_TEXTURE_MAX_LEVEL,
+									static_cast<int32_t>(last_mip_level - 1));
+				gl->glGenerateMipmap(ST_GL_TEXTURE_2D);
+				gl->glTexParameteri(ST_GL_TEXTURE_2D, ST_GL_TEXTURE_MAX_LEVEL, max_level);
+
+				gl->glBindTexture(ST_GL_TEXTURE_2D, static_cast<uint32_t>(old_texture));
+				break;
+			}
+
+			// Only Direct3D 11 can copy rendered levels into the target, OpenGL without its entry points is left as is.
+			if (gs_get_device_type() != GS_DEVICE_DIRECT3D_11) {
+				break;
+			}
+
+			// Set up rendering state once for all levels.
+			gs_load_indexbuffer(nullptr);
+			gs_blend_state_push();
+			gs_reset_blend_state();
+			gs_enable_blending(false);
+			gs_blend_function(GS_BLEND_ONE, GS_BLEND_ZERO);
+			gs_enable_color(true, true, true, true);
+			gs_enable_depth_test(false);
+			gs_enable_stencil_test(false);
+			gs_enable_stencil_write(false);
+			gs_set_cull_mode(GS_NEITHER);
+			try {
+				// Two levels are rendered side by side per pass, so the render target only has to fit level 1 and 2.
+				auto op = _rt->render(std::max<uint32_t>(width >> 1, 1) + std::max<uint32_t>(width >> 2, 1),
+									  std::max<uint32_t>(height >> 1, 1));
+#ifdef _WIN32
+				ID3D11Resource* rtt = nullptr;
+				if (gs_get_device_type() == GS_DEVICE_DIRECT3D_11) {
+					rtt = reinterpret_cast<ID3D11Resource*>(gs_texture_get_obj(_rt->get_object()));
+				}
+#endif
+
+				for (size_t mip = 1; mip < last_mip_level; mip += 2) {
+#ifdef ENABLE_PROFILING
+					auto cctr = streamfx::obs::gs::debug_marker(streamfx::obs::gs::debug_color_azure_radiance,
+																"Mip Level %" PRIuMAX, mip);
+#endif
+
+					bool     pair    = (mip + 1) < last_mip_level;
+					uint32_t cwidth  = std::max<uint32_t>(width >> mip, 1);
+					uint32_t cheight = std::max<uint32_t>(height >> mip, 1);
+					uint32_t nwidth  = std::max<uint32_t>(width >> (mip + 1), 1);
+					uint32_t nheight = std::max<uint32_t>(height >> (mip + 1), 1);
+					uint32_t vwidth  = pair ? (cwidth + nwidth) : cwidth;
+
+					gs_set_viewport(0, 0, static_cast<int>(vwidth), static_cast<int>(cheight));
+					gs_ortho(0, 1, 0, 1, 0, 1);
 
 					_effect.get_parameter("image").set_texture(target);
-					_effect.get_parameter("imageTexel").set_float2(iwidth, iheight);
+					_effect.get_parameter("imageTexel")
+						.set_float2(1.f / static_cast<float_t>(cwidth), 1.f / static_cast<float_t>(cheight));
 					_effect.get_parameter("level").set_int(int32_t(mip - 1));
-					while (gs_effect_loop(_effect.get_object(), "Draw")) {
-						gs_draw(gs_draw_mode::GS_TRIS, 0, _vb->size());
+					_effect.get_parameter("pairSplit")
+						.set_float(static_cast<float_t>(cwidth) / static_cast<float_t>(vwidth));
+					_effect.get_parameter("pairScale")
+						.set_float2(static_cast<float_t>(vwidth) / static_cast<float_t>(nwidth),
+									static_cast<float_t>(cheight) / static_cast<float_t>(nheight));
+					while (gs_effect_loop(_effect.get_object(), pair ? "DrawPair" : "Draw")) {
+						streamfx::gs_draw_fullscreen_tri();
 					}
-				} catch (...) {
-				}
-
-				// Clean up rendering state.
-				gs_load_indexbuffer(nullptr);
-				gs_load_vertexbuffer(nullptr);
-				gs_blend_state_pop();
 
-				// Copy from the render target to the target mip level.
+					// Copy from the render target to the target mip levels.
 #ifdef _WIN32
-				if (gs_get_device_type() == GS_DEVICE_DIRECT3D_11) {
-					ID3D11Texture2D* rtt =
-						reinterpret_cast<ID3D11Texture2D*>(gs_texture_get_obj(_rt->get_texture()->get_object()));
-					uint32_t level = uint32_t(D3D11CalcSubresource(UINT(mip), 0, UINT(max_mip_level)));
+					if (gs_get_device_type() == GS_DEVICE_DIRECT3D_11) {
+						uint32_t  level = uint32_t(D3D11CalcSubresource(UINT(mip), 0, UINT(max_mip_level)));
+						D3D11_BOX box   = {0, 0, 0, cwidth, cheight, 1};
+						d3d_context->CopySubresourceRegion(d3d_target, level, 0, 0, 0, rtt, 0, &box);
 
-					D3D11_BOX box = {0, 0, 0, cwidth, cheight, 1};
-					d3d_context->CopySubresourceRegion(d3d_target, level, 0, 0, 0, rtt, 0, &box);
-				}
+						if (pair) {
+							level = uint32_t(D3D11CalcSubresource(UINT(mip + 1), 0, UINT(max_mip_level)));
+							box   = {cwidth, 0, 0, cwidth + nwidth, nheight, 1};
+							d3d_context->CopySubresourceRegion(d3d_target, level, 0, 0, 0, rtt, 0, &box);
+						}
+					}
 #endif
-				if (gs_get_device_type() == GS_DEVICE_OPENGL) {
-					// FixMe! Implement OpenGL
 				}
+			} catch (...) {
 			}
 
+			// Clean up rendering state.
+			gs_load_indexbuffer(nullptr);
+			gs_load_vertexbuffer(nullptr);
+			gs_blend_state_pop();
+
 			break;
 		}
 	} else {
@@ -38,15 +38,20 @@
 
 namespace streamfx::obs::gs {
 	class mipmapper {
-		std::unique_ptr<streamfx::obs::gs::vertex_buffer> _vb;
-		std::unique_ptr<streamfx::obs::gs::rendertarget>  _rt;
-		streamfx::obs::gs::effect                         _effect;
+		std::unique_ptr<streamfx::obs::gs::rendertarget> _rt;
+		streamfx::obs::gs::effect                        _effect;
 
 		public:
 		~mipmapper();
 		mipmapper();
 
+		/** Copy source into level 0 of target and regenerate the levels below it.
+		 *
+		 * @param levels Number of levels to write, including level 0. Levels past this count are left untouched, so
+		 *               callers must make sure they are never sampled. Defaults to the full chain of target.
+		 */
 		void rebuild(std::shared_ptr<streamfx::obs::gs::texture> source,
-					 std::shared_ptr<streamfx::obs::gs::texture> target);
+					 std::shared_ptr<streamfx::obs::gs::texture> target,
+					 std::size_t levels = std::numeric_limits<std::size_t>::max());
 	};
 } // namespace streamfx::obs::gs
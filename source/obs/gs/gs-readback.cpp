@@ -0,0 +1,105 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "gs-readback.hpp"
+#include <stdexcept>
+#include "gs-helper.hpp"
+
+streamfx::obs::gs::readback::readback(std::size_t latency) : _slots(), _current(0)
+{
+	if (latency == 0) {
+		throw std::invalid_argument("latency must be at least 1");
+	}
+	_slots.resize(latency + 1);
+}
+
+streamfx::obs::gs::readback::~readback()
+{
+	auto gctx = streamfx::obs::gs::context();
+	for (auto& s : _slots) {
+		if (s.surface) {
+			gs_stagesurface_destroy(s.surface);
+		}
+	}
+}
+
+void streamfx::obs::gs::readback::deliver(slot& s)
+{
+	if (!s.pending) {
+		return;
+	}
+	s.pending     = false;
+	auto callback = std::move(s.callback);
+
+	uint8_t* data   = nullptr;
+	uint32_t stride = 0;
+	if (gs_stagesurface_map(s.surface, &data, &stride)) {
+		callback(data, stride, s.width, s.height);
+		gs_stagesurface_unmap(s.surface);
+	} else {
+		callback(nullptr, 0, s.width, s.height);
+	}
+}
+
+void streamfx::obs::gs::readback::stage(gs_texture_t* texture, callback_t callback)
+{
+	// The copy queued `latency` calls ago sits right after the current slot. The current slot itself was delivered by
+	// the previous call, so it is free to be reused.
+	deliver(_slots[(_current + 1) % _slots.size()]);
+
+	auto& s  = _slots[_current];
+	_current = (_current + 1) % _slots.size();
+
+	if (!texture) {
+		return;
+	}
+
+	uint32_t        width  = gs_texture_get_width(texture);
+	uint32_t        height = gs_texture_get_height(texture);
+	gs_color_format format = gs_texture_get_color_format(texture);
+	if (!s.surface || (s.width != width) || (s.height != height) || (s.format != format)) {
+		if (s.surface) {
+			gs_stagesurface_destroy(s.surface);
+		}
+		s.surface = gs_stagesurface_create(width, height, format);
+		s.width   = width;
+		s.height  = height;
+		s.format  = format;
+		if (!s.surface) {
+			return;
+		}
+	}
+
+	gs_stage_texture(s.surface, texture);
+	s.callback = std::move(callback);
+	s.pending  = true;
+}
+
+void streamfx::obs::gs::readback::reset()
+{
+	for (auto& s : _slots) {
+		s.pending  = false;
+		s.callback = nullptr;
+	}
+}
+
+std::size_t streamfx::obs::gs::readback::latency()
+{
+	return _slots.size() - 1;
+}
@@ -0,0 +1,77 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <functional>
+#include <vector>
+
+namespace streamfx::obs::gs {
+	/** Reads textures back from the GPU without stalling the graphics thread.
+	 *
+	 * Mapping a staging surface right after copying into it waits for the GPU to finish everything queued before the
+	 * copy. Instead, every copy goes into the next surface of a small ring and is only mapped after the given number
+	 * of further copies, by which time the GPU has long finished it. The mapped data is handed to the callback that
+	 * was queued along with the copy.
+	 *
+	 * Surfaces follow the size and format of whatever is staged, and are recreated when either changes. All methods
+	 * must be called from within the graphics context.
+	 */
+	class readback {
+		public:
+		/** Receives the mapped texture, or nullptr as data if mapping failed. Only valid for the duration of the call.
+		 */
+		typedef std::function<void(const uint8_t* data, uint32_t stride, uint32_t width, uint32_t height)> callback_t;
+
+		private:
+		struct slot {
+			gs_stagesurf_t* surface = nullptr;
+			uint32_t        width   = 0;
+			uint32_t        height  = 0;
+			gs_color_format format  = GS_UNKNOWN;
+			callback_t      callback;
+			bool            pending = false;
+		};
+
+		std::vector<slot> _slots;
+		std::size_t       _current;
+
+		void deliver(slot& s);
+
+		public:
+		/**
+		 * @param latency How many later calls to stage() pass before the data of a copy is delivered, at least 1.
+		 */
+		readback(std::size_t latency = 1);
+		~readback();
+
+		readback(const readback&) = delete;
+		readback& operator=(const readback&) = delete;
+
+		/** Queue a copy of the texture, and deliver the copy that was queued `latency` calls ago.
+		 */
+		void stage(gs_texture_t* texture, callback_t callback);
+
+		/** Drop all copies that have not been delivered yet, without calling their callbacks.
+		 */
+		void reset();
+
+		std::size_t latency();
+	};
+} // namespace streamfx::obs::gs
@@ -0,0 +1,127 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "gs-rendergraph.hpp"
+#include <stdexcept>
+#include "obs/gs/gs-helper.hpp"
+#include "util/util-memory.hpp"
+
+streamfx::obs::gs::rendergraph::rendergraph()
+	: _pool(streamfx::obs::gs::rendertarget_pool::instance()), _resources(), _passes()
+{}
+
+streamfx::obs::gs::rendergraph::~rendergraph()
+{
+	reset();
+}
+
+streamfx::obs::gs::rendergraph::resource_t streamfx::obs::gs::rendergraph::create(uint32_t width, uint32_t height,
+																				   gs_color_format format)
+{
+	_resources.push_back({width, height, format, false, false, 0, nullptr, nullptr});
+	return _resources.size() - 1;
+}
+
+streamfx::obs::gs::rendergraph::resource_t
+	streamfx::obs::gs::rendergraph::import(std::shared_ptr<streamfx::obs::gs::texture> texture)
+{
+	_resources.push_back({0, 0, GS_RGBA, true, false, 0, nullptr, texture});
+	return _resources.size() - 1;
+}
+
+void streamfx::obs::gs::rendergraph::keep(resource_t resource)
+{
+	_resources.at(resource).keep = true;
+}
+
+void streamfx::obs::gs::rendergraph::add_pass(std::string_view name, std::vector<resource_t> reads, resource_t write,
+											  pass_function_t function)
+{
+	if (_resources.at(write).imported) {
+		throw std::invalid_argument("imported resources can not be written");
+	}
+	for (auto read : reads) {
+		_resources.at(read);
+	}
+	_passes.push_back({std::string{name}, std::move(reads), write, std::move(function)});
+}
+
+void streamfx::obs::gs::rendergraph::execute()
+{
+	// Walk backwards to find the passes that contribute to a kept resource, and the last pass reading each resource.
+	streamfx::util::frame_vector<bool> needed(_resources.size(), false);
+	streamfx::util::frame_vector<bool> active(_passes.size(), false);
+	for (std::size_t idx = 0; idx < _resources.size(); idx++) {
+		needed[idx]               = _resources[idx].keep;
+		_resources[idx].last_read = 0;
+	}
+	for (std::size_t idx = _passes.size(); idx > 0; idx--) {
+		auto& pass = _passes[idx - 1];
+		if (!needed[pass.write]) {
+			continue;
+		}
+
+		active[idx - 1] = true;
+		for (auto read : pass.reads) {
+			needed[read] = true;
+			if (_resources[read].last_read < idx) {
+				_resources[read].last_read = idx;
+			}
+		}
+	}
+
+	for (std::size_t idx = 0; idx < _passes.size(); idx++) {
+		if (!active[idx]) {
+			continue;
+		}
+
+		auto& pass   = _passes[idx];
+		auto& output = _resources[pass.write];
+		{
+#ifdef ENABLE_PROFILING
+			streamfx::obs::gs::debug_marker gdm{streamfx::obs::gs::debug_color_render, "%s", pass.name.c_str()};
+#endif
+			if (!output.target) {
+				output.target = _pool->acquire(output.width, output.height, output.format);
+			}
+			pass.function(*output.target, output.width, output.height);
+			output.texture = output.target->get_texture();
+		}
+
+		// Give back everything that no later pass reads, so the next target of the same size and format is this one.
+		for (auto read : pass.reads) {
+			auto& input = _resources[read];
+			if (!input.imported && !input.keep && (input.last_read == (idx + 1))) {
+				input.texture.reset();
+				input.target.reset();
+			}
+		}
+	}
+}
+
+std::shared_ptr<streamfx::obs::gs::texture> streamfx::obs::gs::rendergraph::get_texture(resource_t resource)
+{
+	return _resources.at(resource).texture;
+}
+
+void streamfx::obs::gs::rendergraph::reset()
+{
+	_passes.clear();
+	_resources.clear();
+}
@@ -0,0 +1,93 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "gs-rendertarget-pool.hpp"
+#include "gs-rendertarget.hpp"
+#include "gs-texture.hpp"
+
+namespace streamfx::obs::gs {
+	/** Schedules the passes of a frame along with the intermediate targets they render into.
+	 *
+	 * Passes declare the resources they read and the one they write. A transient resource only leases a target from
+	 * the render target pool right before the first pass writing it, and gives it back right after the last pass
+	 * reading it, so passes of this graph and any graph executed after it share textures whenever their lifetimes do
+	 * not overlap. Passes whose result is neither read by a later pass nor kept are skipped entirely.
+	 */
+	class rendergraph {
+		public:
+		typedef std::size_t resource_t;
+
+		/** Renders one pass. The target is not bound yet, so that the pass can render its own inputs first. */
+		typedef std::function<void(streamfx::obs::gs::rendertarget& target, uint32_t width, uint32_t height)>
+			pass_function_t;
+
+		private:
+		struct resource {
+			uint32_t                                         width;
+			uint32_t                                         height;
+			gs_color_format                                  format;
+			bool                                             imported;
+			bool                                             keep;
+			std::size_t                                      last_read; // One past the index of the last reader.
+			std::shared_ptr<streamfx::obs::gs::rendertarget> target;
+			std::shared_ptr<streamfx::obs::gs::texture>      texture;
+		};
+
+		struct pass {
+			std::string             name;
+			std::vector<resource_t> reads;
+			resource_t              write;
+			pass_function_t         function;
+		};
+
+		std::shared_ptr<streamfx::obs::gs::rendertarget_pool> _pool;
+		std::vector<resource>                                 _resources;
+		std::vector<pass>                                     _passes;
+
+		public:
+		rendergraph();
+		~rendergraph();
+
+		/** Declare a target that only lives for as long as passes use it. */
+		resource_t create(uint32_t width, uint32_t height, gs_color_format format = GS_RGBA);
+
+		/** Make a texture from outside the graph available to passes. */
+		resource_t import(std::shared_ptr<streamfx::obs::gs::texture> texture);
+
+		/** Keep the result of a resource after execute(), until the next reset(). */
+		void keep(resource_t resource);
+
+		void add_pass(std::string_view name, std::vector<resource_t> reads, resource_t write, pass_function_t function);
+
+		/** Run all passes that contribute to a kept resource, in the order they were added. */
+		void execute();
+
+		/** The texture of a resource, valid from after its first write until its last read. */
+		std::shared_ptr<streamfx::obs::gs::texture> get_texture(resource_t resource);
+
+		/** Forget all passes and resources, and give back the targets of kept resources. */
+		void reset();
+	};
+} // namespace streamfx::obs::gs
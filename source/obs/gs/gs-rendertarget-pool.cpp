@@ -0,0 +1,137 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2017 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "gs-rendertarget-pool.hpp"
+#include "obs/gs/gs-helper.hpp"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4201)
+#endif
+#include <util/platform.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+// Idle targets older than this are destroyed on the next lease.
+#define ST_IDLE_TIMEOUT 2000000000ull // ns
+
+// Idle targets older than this may be resized for a lease of another size. Targets in steady use are back in use
+// within a frame or two, so they are never taken away from their regular user.
+#define ST_REUSE_TIMEOUT 100000000ull // ns
+
+streamfx::obs::gs::rendertarget_pool::state::~state()
+{
+	auto gctx = streamfx::obs::gs::context();
+	for (auto& kv : idle) {
+		for (auto& entry : kv.second) {
+			delete entry.first;
+		}
+	}
+}
+
+streamfx::obs::gs::rendertarget_pool::rendertarget_pool() : _state(std::make_shared<state>()) {}
+
+streamfx::obs::gs::rendertarget_pool::~rendertarget_pool() {}
+
+std::shared_ptr<streamfx::obs::gs::rendertarget> streamfx::obs::gs::rendertarget_pool::acquire(
+	uint32_t width, uint32_t height, gs_color_format color_format, gs_zstencil_format zs_format)
+{
+	key_t         key{width, height, color_format, zs_format};
+	rendertarget* rt  = nullptr;
+	uint64_t      now = os_gettime_ns();
+
+	{
+		std::unique_lock<std::mutex> lock(_state->lock);
+
+		// Drop anything that has not been used in a while.
+		for (auto kv = _state->idle.begin(); kv != _state->idle.end();) {
+			auto& entries = kv->second;
+			for (auto entry = entries.begin(); entry != entries.end();) {
+				if ((now - entry->second) > ST_IDLE_TIMEOUT) {
+					delete entry->first;
+					entry = entries.erase(entry);
+				} else {
+					entry++;
+				}
+			}
+			kv = entries.empty() ? _state->idle.erase(kv) : std::next(kv);
+		}
+
+		auto kv = _state->idle.find(key);
+		if (kv == _state->idle.end()) {
+			// Sources that animate their size ask for a new size every frame. Taking over a target of the same format
+			// that nobody asked for in a while replaces only its texture, instead of adding yet another target that
+			// then sits idle until the timeout.
+			for (auto iter = _state->idle.begin(); iter != _state->idle.end(); iter++) {
+				if ((std::get<2>(iter->first) != color_format) || (std::get<3>(iter->first) != zs_format)
+					|| ((now - iter->second.back().second) < ST_REUSE_TIMEOUT)) {
+					continue;
+				}
+				if ((kv == _state->idle.end()) || (iter->second.back().second > kv->second.back().second)) {
+					kv = iter;
+				}
+			}
+		}
+		if (kv != _state->idle.end()) {
+			rt = kv->second.back().first;
+			kv->second.pop_back();
+			if (kv->second.empty()) {
+				_state->idle.erase(kv);
+			}
+		}
+	}
+
+	if (!rt) {
+		rt = new rendertarget(color_format, zs_format);
+	}
+
+	std::weak_ptr<state> weak = _state;
+	return std::shared_ptr<rendertarget>(rt, [weak, key](rendertarget* rt) {
+		if (auto state = weak.lock(); state) {
+			std::unique_lock<std::mutex> lock(state->lock);
+			state->idle[key].emplace_back(rt, os_gettime_ns());
+		} else {
+			delete rt;
+		}
+	});
+}
+
+std::size_t streamfx::obs::gs::rendertarget_pool::size()
+{
+	std::unique_lock<std::mutex> lock(_state->lock);
+	std::size_t                  count = 0;
+	for (auto& kv : _state->idle) {
+		count += kv.second.size();
+	}
+	return count;
+}
+
+std::shared_ptr<streamfx::obs::gs::rendertarget_pool> streamfx::obs::gs::rendertarget_pool::instance()
+{
+	static std::mutex                       lock;
+	static std::weak_ptr<rendertarget_pool> weak;
+	std::unique_lock<std::mutex>            ul(lock);
+	std::shared_ptr<rendertarget_pool>      ptr = weak.lock();
+	if (!ptr) {
+		ptr  = std::make_shared<rendertarget_pool>();
+		weak = ptr;
+	}
+	return ptr;
+}
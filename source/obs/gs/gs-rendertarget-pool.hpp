@@ -0,0 +1,61 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2017 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include "gs-rendertarget.hpp"
+
+namespace streamfx::obs::gs {
+	/** Pool of render targets, shared by everything that only needs an intermediate target for part of a frame.
+	 *
+	 * Leased targets return to the pool once the last reference is gone, and are handed out again for the same size
+	 * and format. If no target of that size is idle, one of another size that has not been asked for in a while is
+	 * reused instead, so that a size that changes every frame does not pile up targets. Targets that stay unused for a
+	 * while are released, so that the pool follows the current scene.
+	 */
+	class rendertarget_pool {
+		typedef std::tuple<uint32_t, uint32_t, gs_color_format, gs_zstencil_format> key_t;
+
+		struct state {
+			std::mutex                                                       lock;
+			std::map<key_t, std::vector<std::pair<rendertarget*, uint64_t>>> idle;
+
+			~state();
+		};
+		std::shared_ptr<state> _state;
+
+		public:
+		rendertarget_pool();
+		~rendertarget_pool();
+
+		/** Lease a render target for rendering at exactly this size. */
+		std::shared_ptr<streamfx::obs::gs::rendertarget> acquire(uint32_t width, uint32_t height,
+																 gs_color_format    color_format = GS_RGBA,
+																 gs_zstencil_format zs_format    = GS_ZS_NONE);
+
+		std::size_t size();
+
+		public:
+		static std::shared_ptr<streamfx::obs::gs::rendertarget_pool> instance();
+	};
+} // namespace streamfx::obs::gs
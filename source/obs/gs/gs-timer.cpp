@@ -0,0 +1,184 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "gs-timer.hpp"
+#include <algorithm>
+#include <vector>
+#include "gs-helper.hpp"
+
+std::shared_ptr<gs_timer_range_t> streamfx::obs::gs::gpu_timer::_active_range;
+std::size_t                       streamfx::obs::gs::gpu_timer::_active_depth = 0;
+
+std::mutex                                                         streamfx::obs::gs::gpu_timer::_registry_lock;
+std::map<std::string, std::weak_ptr<streamfx::obs::gs::gpu_timer>> streamfx::obs::gs::gpu_timer::_registry;
+
+streamfx::obs::gs::gpu_timer::gpu_timer(std::string name)
+	: _name(name), _trace_name(nullptr), _profiler(util::profiler::create()), _queries(), _current(0), _depth(0)
+{}
+
+streamfx::obs::gs::gpu_timer::~gpu_timer()
+{
+	// Timers that never ran have nothing to release, so there is no need to wait for the graphics context.
+	if (std::none_of(_queries.begin(), _queries.end(), [](const query& q) { return q.timer || q.range; }))
+		return;
+
+	auto gctx = streamfx::obs::gs::context();
+	for (auto& q : _queries) {
+		if (q.timer)
+			gs_timer_destroy(q.timer);
+		q.range.reset();
+	}
+}
+
+void streamfx::obs::gs::gpu_timer::resolve(query& q)
+{
+	if (!q.pending)
+		return;
+	q.pending = false;
+	auto range = std::move(q.range);
+
+	// Neither call blocks, they report false if the GPU has not reached the query yet.
+	bool     disjoint  = true;
+	uint64_t frequency = 0;
+	uint64_t ticks     = 0;
+	if (!gs_timer_range_get_data(range.get(), &disjoint, &frequency) || disjoint || (frequency == 0))
+		return;
+	if (!gs_timer_get_data(q.timer, &ticks))
+		return;
+
+	auto duration = std::chrono::nanoseconds(
+		static_cast<int64_t>((static_cast<double_t>(ticks) * 1'000'000'000.) / static_cast<double_t>(frequency)));
+	_profiler->track(duration);
+
+	if (q.traced) {
+		q.traced = false;
+		if (auto trace = util::trace::get(); trace) {
+			if (!_trace_name)
+				_trace_name = trace->intern(_name);
+			util::trace::record(_trace_name, 0, q.start, duration, util::trace::gpu_track);
+		}
+	}
+}
+
+void streamfx::obs::gs::gpu_timer::begin()
+{
+	if (_depth++ > 0)
+		return;
+
+	auto& q = _queries[_current];
+	resolve(q);
+
+	if (!q.timer)
+		q.timer = gs_timer_create();
+	if (!q.timer) // Not supported by the current backend.
+		return;
+
+	if (_active_depth++ == 0) {
+		if (gs_timer_range_t* range = gs_timer_range_create(); range) {
+			_active_range = std::shared_ptr<gs_timer_range_t>(range, [](gs_timer_range_t* v) {
+				// The last query holding on to a range is always released within the graphics context.
+				gs_timer_range_destroy(v);
+			});
+			gs_timer_range_begin(range);
+		}
+	}
+	q.range = _active_range;
+
+	q.traced = util::trace::is_capturing();
+	if (q.traced)
+		q.start = std::chrono::high_resolution_clock::now();
+
+	gs_timer_begin(q.timer);
+}
+
+void streamfx::obs::gs::gpu_timer::end()
+{
+	if ((_depth == 0) || (--_depth > 0))
+		return;
+
+	auto& q = _queries[_current];
+	_current = (_current + 1) % query_count;
+	if (!q.timer)
+		return;
+
+	gs_timer_end(q.timer);
+	q.pending = (q.range != nullptr);
+
+	if (--_active_depth == 0) {
+		if (_active_range)
+			gs_timer_range_end(_active_range.get());
+		_active_range.reset();
+	}
+}
+
+const std::string& streamfx::obs::gs::gpu_timer::name()
+{
+	return _name;
+}
+
+std::shared_ptr<streamfx::util::profiler> streamfx::obs::gs::gpu_timer::profiler()
+{
+	return _profiler;
+}
+
+streamfx::obs::gs::gpu_timer::scope::scope(std::shared_ptr<gpu_timer> parent) : _parent(parent)
+{
+	if (_parent)
+		_parent->begin();
+}
+
+streamfx::obs::gs::gpu_timer::scope::~scope()
+{
+	if (_parent)
+		_parent->end();
+}
+
+std::shared_ptr<streamfx::obs::gs::gpu_timer> streamfx::obs::gs::gpu_timer::get(std::string name)
+{
+	std::unique_lock<std::mutex> lock(_registry_lock);
+	if (auto iter = _registry.find(name); iter != _registry.end()) {
+		if (auto timer = iter->second.lock(); timer)
+			return timer;
+	}
+
+	auto timer      = std::make_shared<gpu_timer>(name);
+	_registry[name] = timer;
+	return timer;
+}
+
+void streamfx::obs::gs::gpu_timer::enumerate(std::function<void(std::shared_ptr<gpu_timer>)> fn)
+{
+	std::vector<std::shared_ptr<gpu_timer>> timers;
+	{
+		std::unique_lock<std::mutex> lock(_registry_lock);
+		for (auto iter = _registry.begin(); iter != _registry.end();) {
+			if (auto timer = iter->second.lock(); timer) {
+				timers.push_back(timer);
+				++iter;
+			} else {
+				iter = _registry.erase(iter);
+			}
+		}
+	}
+
+	// Call outside of the lock, so that fn may look up timers itself.
+	for (auto& timer : timers) {
+		fn(timer);
+	}
+}
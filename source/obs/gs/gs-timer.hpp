@@ -0,0 +1,104 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <array>
+#include <functional>
+#include <map>
+#include <mutex>
+#include "util/util-profiler.hpp"
+#include "util/util-trace.hpp"
+
+namespace streamfx::obs::gs {
+	/** Measures how long the GPU spends on a region, using timestamp and disjoint queries.
+	 *
+	 * Queries are kept in a small ring and only read back once the ring wraps around to them again, which is several
+	 * frames later. A query that the GPU has not finished by then is dropped instead of waited for, so measuring never
+	 * stalls the graphics thread. Resolved durations are recorded into a util::profiler.
+	 *
+	 * Disjoint queries can not be nested, so all timers that are running at the same time share the range that the
+	 * outermost one opened.
+	 *
+	 * Timers are shared by name, so that every instance of a filter contributes to the same histogram. All methods
+	 * except get() and enumerate() must be called from within the graphics context.
+	 *
+	 * While a trace is captured, resolved durations also become zones on the GPU track. The GPU does not share a clock
+	 * with the CPU, so these start when begin() was called and not when the GPU actually got to them.
+	 */
+	class gpu_timer {
+		static constexpr std::size_t query_count = 8;
+
+		struct query {
+			std::shared_ptr<gs_timer_range_t>              range;
+			gs_timer_t*                                    timer   = nullptr;
+			bool                                           pending = false;
+			bool                                           traced  = false;
+			std::chrono::high_resolution_clock::time_point start;
+		};
+
+		std::string                     _name;
+		const char*                     _trace_name;
+		std::shared_ptr<util::profiler> _profiler;
+		std::array<query, query_count>  _queries;
+		std::size_t                     _current;
+		std::size_t                     _depth;
+
+		void resolve(query& q);
+
+		public:
+		gpu_timer(std::string name);
+		~gpu_timer();
+
+		/** Start measuring. Nested calls on the same timer are folded into the outermost region.
+		 */
+		void begin();
+
+		void end();
+
+		const std::string& name();
+
+		std::shared_ptr<util::profiler> profiler();
+
+		public:
+		class scope {
+			std::shared_ptr<gpu_timer> _parent;
+
+			public:
+			scope(std::shared_ptr<gpu_timer> parent);
+			~scope();
+		};
+
+		private:
+		static std::shared_ptr<gs_timer_range_t> _active_range; // Only touched by the graphics thread.
+		static std::size_t                       _active_depth;
+
+		static std::mutex                                      _registry_lock;
+		static std::map<std::string, std::weak_ptr<gpu_timer>> _registry;
+
+		public:
+		/** Retrieve the timer with the given name, creating it if nobody holds it yet.
+		 */
+		static std::shared_ptr<gpu_timer> get(std::string name);
+
+		/** Call fn for every timer that is currently alive.
+		 */
+		static void enumerate(std::function<void(std::shared_ptr<gpu_timer>)> fn);
+	};
+} // namespace streamfx::obs::gs
@@ -97,6 +97,7 @@ void streamfx::obs::gs::vertex_buffer::finalize()
 
 	_buffer.reset();
 	_data.reset();
+	_uploaded.clear();
 }
 
 streamfx::obs::gs::vertex_buffer::~vertex_buffer()
@@ -111,7 +112,7 @@ streamfx::obs::gs::vertex_buffer::vertex_buffer(uint32_t size, uint8_t layers)
 
 	  _positions(nullptr), _normals(nullptr), _tangents(nullptr), _colors(nullptr), _uv_layers(nullptr), _uvs(),
 
-	  _obs_data(nullptr)
+	  _obs_data(nullptr), _uploaded()
 {
 	initialize(_size, _layers);
 }
@@ -123,7 +124,7 @@ streamfx::obs::gs::vertex_buffer::vertex_buffer(gs_vertbuffer_t* vb)
 
 	  _positions(nullptr), _normals(nullptr), _tangents(nullptr), _colors(nullptr), _uv_layers(nullptr), _uvs(),
 
-	  _obs_data(nullptr)
+	  _obs_data(nullptr), _uploaded()
 {
 	auto        gctx = streamfx::obs::gs::context();
 	gs_vb_data* vbd  = gs_vertexbuffer_get_data(vb);
@@ -302,9 +303,46 @@ vec4* streamfx::obs::gs::vertex_buffer::get_uv_layer(uint8_t idx)
 	return _uvs[idx];
 }
 
+bool streamfx::obs::gs::vertex_buffer::has_changed()
+{
+	std::pair<const void*, std::size_t> arrays[4 + MAXIMUM_UVW_LAYERS] = {
+		{_positions, sizeof(vec3) * _capacity},
+		{_normals, sizeof(vec3) * _capacity},
+		{_tangents, sizeof(vec3) * _capacity},
+		{_colors, sizeof(uint32_t) * _capacity},
+	};
+	std::size_t count = 4;
+	for (std::size_t n = 0; n < _layers; n++) {
+		arrays[count++] = {_uvs[n], sizeof(vec4) * _capacity};
+	}
+
+	std::size_t total = 0;
+	for (std::size_t idx = 0; idx < count; idx++) {
+		total += arrays[idx].second;
+	}
+
+	bool changed = (_uploaded.size() != total);
+	if (!changed) {
+		for (std::size_t idx = 0, offset = 0; idx < count; offset += arrays[idx].second, idx++) {
+			if (memcmp(_uploaded.data() + offset, arrays[idx].first, arrays[idx].second) != 0) {
+				changed = true;
+				break;
+			}
+		}
+	}
+
+	if (changed) {
+		_uploaded.resize(total);
+		for (std::size_t idx = 0, offset = 0; idx < count; offset += arrays[idx].second, idx++) {
+			memcpy(_uploaded.data() + offset, arrays[idx].first, arrays[idx].second);
+		}
+	}
+	return changed;
+}
+
 gs_vertbuffer_t* streamfx::obs::gs::vertex_buffer::update(bool refreshGPU)
 {
-	if (refreshGPU) {
+	if (refreshGPU && has_changed()) {
 		auto gctx = streamfx::obs::gs::context();
 		gs_vertexbuffer_flush_direct(_buffer.get(), _data.get());
 		_obs_data = gs_vertexbuffer_get_data(_buffer.get());
@@ -43,9 +43,17 @@ namespace streamfx::obs::gs {
 		// OBS compatability
 		gs_vb_data* _obs_data;
 
+		// Copy of what was last uploaded, so that unchanged meshes are not uploaded again.
+		std::vector<uint8_t> _uploaded;
+
 		void initialize(uint32_t capacity, uint8_t layers);
 		void finalize();
 
+		/*!
+		* \brief Check if the mesh differs from what was last uploaded, and remember it as uploaded if so.
+		*/
+		bool has_changed();
+
 		public:
 		virtual ~vertex_buffer();
 
@@ -171,6 +179,13 @@ namespace streamfx::obs::gs {
 
 		gs_vertbuffer_t* update();
 
+		/*!
+		* \brief Retrieve the GPU buffer, uploading the mesh first if requested.
+		* libobs can only replace the whole buffer, so the upload is skipped entirely when no vertex has changed since
+		*  the last one.
+		*
+		* \param refreshGPU Upload the mesh if it changed.
+		*/
 		gs_vertbuffer_t* update(bool refreshGPU);
 	};
 } // namespace streamfx::obs::gs
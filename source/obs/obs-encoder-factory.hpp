@@ -19,9 +19,16 @@
 
 #pragma once
 #include "common.hpp"
+#include "obs/obs-statistics.hpp"
 #include "plugin.hpp"
 
 namespace streamfx::obs {
+	/** Thrown while creating a texture encoder if falling back to the "_sw" encoder would not help either. */
+	class encoder_no_fallback_error : public std::runtime_error {
+		public:
+		encoder_no_fallback_error(const char* what) : std::runtime_error(what) {}
+	};
+
 	template<class _factory, typename _instance>
 	class encoder_factory {
 		public:
@@ -124,6 +131,9 @@ namespace streamfx::obs {
 			auto* fac = reinterpret_cast<factory_t*>(obs_encoder_get_type_data(encoder));
 			try {
 				return fac->create(settings, encoder, true);
+			} catch (const encoder_no_fallback_error& ex) {
+				DLOG_ERROR("Failed to create encoder: %s", ex.what());
+				return nullptr;
 			} catch (...) {
 				return obs_encoder_create_rerouted(encoder, fac->_info_fallback.id);
 			}
@@ -173,6 +183,7 @@ namespace streamfx::obs {
 		try {
 			auto priv = reinterpret_cast<instance_t*>(data);
 			if (priv) {
+				obs::statistics::scope prof{priv->get_statistics(), obs::statistics::callback::Update};
 				uint64_t version = static_cast<uint64_t>(obs_data_get_int(settings, S_VERSION));
 				priv->migrate(settings, version);
 				obs_data_set_int(settings, S_VERSION, static_cast<int64_t>(STREAMFX_VERSION));
@@ -191,8 +202,11 @@ namespace streamfx::obs {
 		static bool _encode(void* data, struct encoder_frame* frame, struct encoder_packet* packet,
 							bool* received_packet) noexcept
 		try {
-			if (data)
-				return reinterpret_cast<instance_t*>(data)->encode(frame, packet, received_packet);
+			if (data) {
+				auto* instance = reinterpret_cast<instance_t*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Encode};
+				return instance->encode(frame, packet, received_packet);
+			}
 			return false;
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
@@ -205,9 +219,11 @@ namespace streamfx::obs {
 		static bool _encode_texture(void* data, uint32_t handle, int64_t pts, uint64_t lock_key, uint64_t* next_key,
 									struct encoder_packet* packet, bool* received_packet) noexcept
 		try {
-			if (data)
-				return reinterpret_cast<instance_t*>(data)->encode_video(handle, pts, lock_key, next_key, packet,
-																		 received_packet);
+			if (data) {
+				auto* instance = reinterpret_cast<instance_t*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Encode};
+				return instance->encode_video(handle, pts, lock_key, next_key, packet, received_packet);
+			}
 			return false;
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
@@ -297,12 +313,20 @@ namespace streamfx::obs {
 
 	class encoder_instance {
 		protected:
-		obs_encoder_t* _self;
+		obs_encoder_t*                   _self;
+		std::shared_ptr<obs::statistics> _statistics;
 
 		public:
-		encoder_instance(obs_data_t* settings, obs_encoder_t* self, bool is_hw) : _self(self) {}
+		encoder_instance(obs_data_t* settings, obs_encoder_t* self, bool is_hw)
+			: _self(self), _statistics(obs::statistics::create(self))
+		{}
 		virtual ~encoder_instance(){};
 
+		const std::shared_ptr<obs::statistics>& get_statistics()
+		{
+			return _statistics;
+		}
+
 		virtual void migrate(obs_data_t* settings, uint64_t version) {}
 
 		virtual bool update(obs_data_t* settings)
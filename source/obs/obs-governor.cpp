@@ -0,0 +1,237 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "obs-governor.hpp"
+#include <algorithm>
+#include "configuration.hpp"
+#include "plugin.hpp"
+
+#define ST_PREFIX "<obs::governor> "
+
+#define ST_CFG_ENABLED "Governor.Enabled"
+#define ST_CFG_PREVIEW "Governor.Preview"
+
+// Decisions are made over this many seconds, so that a single slow frame does not cause anything.
+constexpr float_t window = 0.5f;
+
+// Degrade above this share of the frame interval, and restore below the other one.
+constexpr double_t threshold_degrade = 0.9;
+constexpr double_t threshold_restore = 0.6;
+
+// Windows in a row that must have headroom before anything is restored.
+constexpr uint32_t headroom_windows = 6;
+
+static std::shared_ptr<streamfx::obs::governor> _governor_instance;
+
+streamfx::obs::degradable::degradable(int32_t priority, uint32_t levels)
+	: _degrade_priority(priority), _degrade_levels(levels), _degrade_level(0)
+{
+	if (auto governor = streamfx::obs::governor::get(); governor) {
+		governor->add(this);
+	}
+}
+
+streamfx::obs::degradable::~degradable()
+{
+	if (auto governor = streamfx::obs::governor::get(); governor) {
+		governor->remove(this);
+	}
+}
+
+uint32_t streamfx::obs::degradable::degrade_level()
+{
+	return _degrade_level.load(std::memory_order_relaxed);
+}
+
+uint32_t streamfx::obs::degradable::degrade_level(bool preview)
+{
+	uint32_t level = degrade_level();
+	return preview ? std::min(std::max<uint32_t>(level, 1), _degrade_levels) : level;
+}
+
+streamfx::obs::governor::governor()
+	: _lock(), _instances(), _enabled(false), _preview(false), _elapsed(0), _lagged(0), _headroom(0)
+{
+	auto data = streamfx::configuration::instance()->get();
+	obs_data_set_default_bool(data.get(), ST_CFG_ENABLED, false);
+	obs_data_set_default_bool(data.get(), ST_CFG_PREVIEW, false);
+	_enabled = obs_data_get_bool(data.get(), ST_CFG_ENABLED);
+	_preview = obs_data_get_bool(data.get(), ST_CFG_PREVIEW);
+	_lagged  = obs_get_lagged_frames();
+
+	obs_add_tick_callback(tick, this);
+}
+
+streamfx::obs::governor::~governor()
+{
+	obs_remove_tick_callback(tick, this);
+}
+
+bool streamfx::obs::governor::is_enabled()
+{
+	return _enabled;
+}
+
+void streamfx::obs::governor::set_enabled(bool enabled)
+{
+	_enabled = enabled;
+
+	auto data = streamfx::configuration::instance()->get();
+	obs_data_set_bool(data.get(), ST_CFG_ENABLED, enabled);
+
+	if (!enabled) {
+		std::unique_lock<std::mutex> lock(_lock);
+		reset();
+	}
+}
+
+bool streamfx::obs::governor::is_preview_enabled()
+{
+	return _preview;
+}
+
+void streamfx::obs::governor::set_preview_enabled(bool enabled)
+{
+	_preview = enabled;
+
+	auto data = streamfx::configuration::instance()->get();
+	obs_data_set_bool(data.get(), ST_CFG_PREVIEW, enabled);
+}
+
+void streamfx::obs::governor::add(degradable* instance)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	_instances.push_back(instance);
+}
+
+void streamfx::obs::governor::remove(degradable* instance)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	_instances.remove(instance);
+}
+
+void streamfx::obs::governor::evaluate()
+{
+	double_t budget  = static_cast<double_t>(obs_get_frame_interval_ns());
+	double_t used    = static_cast<double_t>(obs_get_average_frame_time_ns());
+	uint32_t lagged  = obs_get_lagged_frames();
+	bool     dropped = (lagged != _lagged);
+	_lagged          = lagged;
+
+	if ((budget <= 0.) || !_enabled) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(_lock);
+	if (dropped || (used > (budget * threshold_degrade))) {
+		_headroom = 0;
+		if (degrade()) {
+			DLOG_INFO(ST_PREFIX "Rendering takes %.2fms of %.2fms, reducing quality.", used / 1000000.,
+					  budget / 1000000.);
+		}
+	} else if (used < (budget * threshold_restore)) {
+		if (++_headroom >= headroom_windows) {
+			_headroom = 0;
+			if (restore()) {
+				DLOG_INFO(ST_PREFIX "Rendering takes %.2fms of %.2fms, restoring quality.", used / 1000000.,
+						  budget / 1000000.);
+			}
+		}
+	} else {
+		_headroom = 0;
+	}
+}
+
+bool streamfx::obs::governor::degrade()
+{
+	// Pick the lowest priority, and spread the levels evenly among instances of the same priority.
+	degradable* pick = nullptr;
+	for (auto instance : _instances) {
+		uint32_t level = instance->degrade_level();
+		if (level >= instance->_degrade_levels) {
+			continue;
+		}
+		if (!pick || (instance->_degrade_priority < pick->_degrade_priority)
+			|| ((instance->_degrade_priority == pick->_degrade_priority) && (level < pick->degrade_level()))) {
+			pick = instance;
+		}
+	}
+
+	if (pick) {
+		pick->_degrade_level.fetch_add(1, std::memory_order_relaxed);
+	}
+	return pick != nullptr;
+}
+
+bool streamfx::obs::governor::restore()
+{
+	// The exact opposite of degrade(), so that the most important instances recover first.
+	degradable* pick = nullptr;
+	for (auto instance : _instances) {
+		uint32_t level = instance->degrade_level();
+		if (level == 0) {
+			continue;
+		}
+		if (!pick || (instance->_degrade_priority > pick->_degrade_priority)
+			|| ((instance->_degrade_priority == pick->_degrade_priority) && (level > pick->degrade_level()))) {
+			pick = instance;
+		}
+	}
+
+	if (pick) {
+		pick->_degrade_level.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return pick != nullptr;
+}
+
+void streamfx::obs::governor::reset()
+{
+	for (auto instance : _instances) {
+		instance->_degrade_level.store(0, std::memory_order_relaxed);
+	}
+	_headroom = 0;
+}
+
+void streamfx::obs::governor::tick(void* ptr, float_t seconds) noexcept
+try {
+	auto self = reinterpret_cast<streamfx::obs::governor*>(ptr);
+	if ((self->_elapsed += seconds) >= window) {
+		self->_elapsed = 0;
+		self->evaluate();
+	}
+} catch (const std::exception& ex) {
+	DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
+} catch (...) {
+	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+}
+
+void streamfx::obs::governor::initialize()
+{
+	_governor_instance = std::make_shared<streamfx::obs::governor>();
+}
+
+void streamfx::obs::governor::finalize()
+{
+	_governor_instance.reset();
+}
+
+std::shared_ptr<streamfx::obs::governor> streamfx::obs::governor::get()
+{
+	return _governor_instance;
+}
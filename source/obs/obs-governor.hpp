@@ -0,0 +1,105 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace streamfx::obs {
+	/** Mix-in for instances that can trade quality for render time.
+	 *
+	 * Level 0 is full quality, every further level should roughly halve the cost of the instance. The governor only
+	 * ever changes the level, instances read it back with degrade_level() whenever they render.
+	 */
+	class degradable {
+		int32_t               _degrade_priority;
+		uint32_t              _degrade_levels;
+		std::atomic<uint32_t> _degrade_level;
+
+		friend class governor;
+
+		public:
+		/**
+		 * @param priority Lower priorities are degraded first and restored last.
+		 * @param levels Highest level that is supported.
+		 */
+		degradable(int32_t priority, uint32_t levels);
+		virtual ~degradable();
+
+		uint32_t degrade_level();
+
+		/** Level to render at, which is at least 1 if the render is outside of program, see is_preview_render().
+		 */
+		uint32_t degrade_level(bool preview);
+	};
+
+	/** Opt-in frame budget governor.
+	 *
+	 * Watches how long OBS Studio takes to render a frame and, while it is over budget or frames are being lagged,
+	 * degrades registered instances one level at a time in priority order. Once there is enough headroom for a while,
+	 * levels are restored again in the opposite order.
+	 *
+	 * Separately, instances that opted in render cheaper outside of program while the preview profile is enabled.
+	 */
+	class governor {
+		std::mutex             _lock;
+		std::list<degradable*> _instances;
+		std::atomic<bool>      _enabled;
+		std::atomic<bool>      _preview;
+
+		float_t  _elapsed;
+		uint32_t _lagged;
+		uint32_t _headroom;
+
+		public:
+		governor();
+		~governor();
+
+		bool is_enabled();
+
+		void set_enabled(bool enabled);
+
+		bool is_preview_enabled();
+
+		void set_preview_enabled(bool enabled);
+
+		void add(degradable* instance);
+
+		void remove(degradable* instance);
+
+		private:
+		void evaluate();
+
+		bool degrade();
+
+		bool restore();
+
+		void reset();
+
+		static void tick(void* ptr, float_t seconds) noexcept;
+
+		public /* Singleton */:
+		static void                                     initialize();
+		static void                                     finalize();
+		static std::shared_ptr<streamfx::obs::governor> get();
+	};
+} // namespace streamfx::obs
@@ -0,0 +1,149 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "obs-memory-budget.hpp"
+#include <algorithm>
+#include <vector>
+#include "configuration.hpp"
+#include "obs/obs-source-factory.hpp"
+#include "plugin.hpp"
+
+#define ST_PREFIX "<obs::memory_budget> "
+
+#define ST_CFG_BUDGET "Memory.Budget"
+#define ST_CFG_IDLE_TIMEOUT "Memory.IdleTimeout"
+
+// The budget is only checked this often, as adding up all instances is not free.
+constexpr float_t interval = 1.f;
+
+static std::shared_ptr<streamfx::obs::memory_budget> _memory_budget_instance;
+
+streamfx::obs::memory_budget::memory_budget() : _lock(), _instances(), _budget(0), _idle_timeout(10.f), _elapsed(0)
+{
+	auto data = streamfx::configuration::instance()->get();
+	obs_data_set_default_int(data.get(), ST_CFG_BUDGET, 0);
+	obs_data_set_default_double(data.get(), ST_CFG_IDLE_TIMEOUT, 10.);
+	_budget       = static_cast<uint64_t>(std::max<int64_t>(obs_data_get_int(data.get(), ST_CFG_BUDGET), 0)) << 20;
+	_idle_timeout = static_cast<float_t>(std::max(obs_data_get_double(data.get(), ST_CFG_IDLE_TIMEOUT), 0.));
+
+	obs_add_tick_callback(tick, this);
+}
+
+streamfx::obs::memory_budget::~memory_budget()
+{
+	obs_remove_tick_callback(tick, this);
+}
+
+uint64_t streamfx::obs::memory_budget::get_budget()
+{
+	return _budget;
+}
+
+float_t streamfx::obs::memory_budget::get_idle_timeout()
+{
+	return _idle_timeout;
+}
+
+uint64_t streamfx::obs::memory_budget::usage()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	uint64_t                     used = 0;
+	for (auto instance : _instances) {
+		used += instance->get_statistics()->video_memory();
+	}
+	return used;
+}
+
+void streamfx::obs::memory_budget::add(source_instance* instance)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	_instances.push_back(instance);
+}
+
+void streamfx::obs::memory_budget::remove(source_instance* instance)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	_instances.remove(instance);
+}
+
+void streamfx::obs::memory_budget::evaluate()
+{
+	if (_budget == 0) {
+		return;
+	}
+
+	std::unique_lock<std::mutex>                      lock(_lock);
+	uint64_t                                          used = 0;
+	std::vector<std::pair<float_t, source_instance*>> candidates;
+	for (auto instance : _instances) {
+		used += instance->get_statistics()->video_memory();
+		if (!instance->is_idle() && (instance->get_hidden_time() > 0)) {
+			candidates.emplace_back(instance->get_hidden_time(), instance);
+		}
+	}
+	if (used <= _budget) {
+		return;
+	}
+
+	// Whatever was hidden the longest is the least likely to be shown again soon.
+	std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+	std::size_t evicted = 0;
+	for (auto& kv : candidates) {
+		uint64_t memory = kv.second->get_statistics()->video_memory();
+		kv.second->evict();
+		used -= std::min(used, memory);
+		evicted++;
+		if (used <= _budget) {
+			break;
+		}
+	}
+
+	if (evicted > 0) {
+		DLOG_INFO(ST_PREFIX "Released the caches of %zu hidden instance(s), now using %" PRIu64 " of %" PRIu64 " MiB.",
+				  evicted, used >> 20, _budget >> 20);
+	}
+}
+
+void streamfx::obs::memory_budget::tick(void* ptr, float_t seconds) noexcept
+try {
+	auto self = reinterpret_cast<streamfx::obs::memory_budget*>(ptr);
+	if ((self->_elapsed += seconds) >= interval) {
+		self->_elapsed = 0;
+		self->evaluate();
+	}
+} catch (const std::exception& ex) {
+	DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
+} catch (...) {
+	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+}
+
+void streamfx::obs::memory_budget::initialize()
+{
+	_memory_budget_instance = std::make_shared<streamfx::obs::memory_budget>();
+}
+
+void streamfx::obs::memory_budget::finalize()
+{
+	_memory_budget_instance.reset();
+}
+
+std::shared_ptr<streamfx::obs::memory_budget> streamfx::obs::memory_budget::get()
+{
+	return _memory_budget_instance;
+}
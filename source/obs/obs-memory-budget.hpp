@@ -0,0 +1,70 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace streamfx::obs {
+	class source_instance;
+
+	/** Keeps the video memory held by hidden instances under a budget.
+	 *
+	 * Instances that opted into idle tracking register here. Once a second, the video memory that they report
+	 * through their statistics is added up, and while it exceeds the budget, the instances hidden the longest release
+	 * their caches early instead of waiting for the idle timeout. Instances that are showing are never touched, as
+	 * they would re-create everything right away. Both limits come from the global configuration, and a budget of 0
+	 * leaves only the idle timeout.
+	 */
+	class memory_budget {
+		std::mutex                  _lock;
+		std::list<source_instance*> _instances;
+
+		uint64_t _budget; // Bytes.
+		float_t  _idle_timeout;
+		float_t  _elapsed;
+
+		public:
+		memory_budget();
+		~memory_budget();
+
+		uint64_t get_budget();
+
+		float_t get_idle_timeout();
+
+		/** Video memory held by all registered instances right now. */
+		uint64_t usage();
+
+		void add(source_instance* instance);
+
+		void remove(source_instance* instance);
+
+		private:
+		void evaluate();
+
+		static void tick(void* ptr, float_t seconds) noexcept;
+
+		public /* Singleton */:
+		static void                                          initialize();
+		static void                                          finalize();
+		static std::shared_ptr<streamfx::obs::memory_budget> get();
+	};
+} // namespace streamfx::obs
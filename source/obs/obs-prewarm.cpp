@@ -0,0 +1,114 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "obs-prewarm.hpp"
+#include <set>
+#include "configuration.hpp"
+#include "obs/obs-source-factory.hpp"
+#include "plugin.hpp"
+
+#define ST_PREFIX "<obs::prewarm> "
+
+#define ST_CFG_ENABLED "Prewarm.Enabled"
+
+static std::shared_ptr<streamfx::obs::prewarm> _prewarm_instance;
+
+streamfx::obs::prewarm::prewarm() : _lock(), _instances(), _enabled(false)
+{
+	auto data = streamfx::configuration::instance()->get();
+	obs_data_set_default_bool(data.get(), ST_CFG_ENABLED, false);
+	_enabled = obs_data_get_bool(data.get(), ST_CFG_ENABLED);
+}
+
+streamfx::obs::prewarm::~prewarm() {}
+
+bool streamfx::obs::prewarm::is_enabled()
+{
+	return _enabled;
+}
+
+void streamfx::obs::prewarm::set_enabled(bool enabled)
+{
+	_enabled = enabled;
+
+	auto data = streamfx::configuration::instance()->get();
+	obs_data_set_bool(data.get(), ST_CFG_ENABLED, enabled);
+}
+
+void streamfx::obs::prewarm::add(source_instance* instance)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	_instances.push_back(instance);
+}
+
+void streamfx::obs::prewarm::remove(source_instance* instance)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	_instances.remove(instance);
+}
+
+void streamfx::obs::prewarm::warm(obs_source_t* scene)
+{
+	if (!_enabled || !scene) {
+		return;
+	}
+
+	std::set<obs_source_t*> sources{scene};
+	obs_source_enum_full_tree(
+		scene,
+		[](obs_source_t*, obs_source_t* child, void* param) {
+			reinterpret_cast<std::set<obs_source_t*>*>(param)->insert(child);
+		},
+		&sources);
+
+	std::unique_lock<std::mutex> lock(_lock);
+	std::size_t                  queued = 0;
+	for (auto instance : _instances) {
+		obs_source_t* source = obs_filter_get_parent(instance->get());
+		if (!source) {
+			source = instance->get();
+		}
+
+		// Whatever is in program already renders every frame at full quality.
+		if ((sources.count(source) == 0) || obs_source_active(source)) {
+			continue;
+		}
+		instance->queue_prewarm();
+		queued++;
+	}
+
+	if (queued > 0) {
+		DLOG_INFO(ST_PREFIX "Warming up %zu instance(s) in scene '%s'.", queued, obs_source_get_name(scene));
+	}
+}
+
+void streamfx::obs::prewarm::initialize()
+{
+	_prewarm_instance = std::make_shared<streamfx::obs::prewarm>();
+}
+
+void streamfx::obs::prewarm::finalize()
+{
+	_prewarm_instance.reset();
+}
+
+std::shared_ptr<streamfx::obs::prewarm> streamfx::obs::prewarm::get()
+{
+	return _prewarm_instance;
+}
@@ -0,0 +1,64 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace streamfx::obs {
+	class source_instance;
+
+	/** Renders the instances of a scene once ahead of time, before the scene goes live.
+	 *
+	 * Instances create most of their resources lazily on their first render, which otherwise is the first frame the
+	 * scene is in program, right at the cut. Instances that opted in register here, and whenever a scene is likely to
+	 * go live next, every one of them in that scene that is not in program yet renders once into a throwaway target.
+	 * Those renders go through the creation queue, so they are spread over the next few ticks. Disabled by default,
+	 * as scenes that never go live are then warmed up for nothing. Only the Studio Mode preview triggers it, and only
+	 * while the preview profile reduces its quality, as it otherwise renders at full quality anyway.
+	 */
+	class prewarm {
+		std::mutex                  _lock;
+		std::list<source_instance*> _instances;
+		std::atomic<bool>           _enabled;
+
+		public:
+		prewarm();
+		~prewarm();
+
+		bool is_enabled();
+
+		void set_enabled(bool enabled);
+
+		void add(source_instance* instance);
+
+		void remove(source_instance* instance);
+
+		/** Warm up every registered instance in the scene, including nested scenes, groups and filters. */
+		void warm(obs_source_t* scene);
+
+		public /* Singleton */:
+		static void                                    initialize();
+		static void                                    finalize();
+		static std::shared_ptr<streamfx::obs::prewarm> get();
+	};
+} // namespace streamfx::obs
@@ -0,0 +1,106 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+
+#include "obs-render-sharing.hpp"
+#include <cinttypes>
+#include "obs/gs/gs-helper.hpp"
+#include "plugin.hpp"
+
+#define ST_PREFIX "<obs::render_sharing> "
+
+static std::shared_ptr<streamfx::obs::render_sharing> _render_sharing_instance;
+
+streamfx::obs::render_sharing::render_sharing() : _lock(), _frame(0), _groups() {}
+
+streamfx::obs::render_sharing::~render_sharing()
+{
+	auto gctx = streamfx::obs::gs::context();
+	_groups.clear();
+}
+
+std::shared_ptr<streamfx::obs::gs::rendertarget>
+	streamfx::obs::render_sharing::acquire(const key_t& key, bool& render)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	if (uint64_t now = obs_get_video_frame_time(); now != _frame) {
+		_frame = now;
+		next_frame();
+	}
+
+	auto& entry = _groups[key];
+	entry.renders++;
+
+	// Nothing to share with, or at least nothing to share with as far as the last frame can tell.
+	if (!entry.shared) {
+		render = true;
+		return nullptr;
+	}
+
+	if (!entry.captured) {
+		if (!entry.target) {
+			entry.target = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+		}
+		entry.captured = true;
+		render         = true;
+		return entry.target;
+	}
+
+	render = false;
+	return entry.target;
+}
+
+void streamfx::obs::render_sharing::next_frame()
+{
+	for (auto iter = _groups.begin(); iter != _groups.end();) {
+		auto& entry = iter->second;
+		if (entry.renders == 0) {
+			// Not rendered at all, which also happens to every group of a settings hash that is gone.
+			iter = _groups.erase(iter);
+			continue;
+		}
+
+		if (!entry.shared && (entry.renders > 1)) {
+			DLOG_DEBUG(ST_PREFIX "Rendering '%s' on '%s' once for %" PRIu32 " views.", std::get<0>(iter->first),
+					   obs_source_get_name(std::get<2>(iter->first)), entry.renders);
+		}
+		entry.shared   = (entry.renders > 1);
+		entry.renders  = 0;
+		entry.captured = false;
+		if (!entry.shared) {
+			entry.target.reset();
+		}
+		++iter;
+	}
+}
+
+void streamfx::obs::render_sharing::initialize()
+{
+	_render_sharing_instance = std::make_shared<streamfx::obs::render_sharing>();
+}
+
+void streamfx::obs::render_sharing::finalize()
+{
+	_render_sharing_instance.reset();
+}
+
+std::shared_ptr<streamfx::obs::render_sharing> streamfx::obs::render_sharing::get()
+{
+	return _render_sharing_instance;
+}
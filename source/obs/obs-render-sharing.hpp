@@ -0,0 +1,77 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+
+#pragma once
+#include "common.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include "obs/gs/gs-rendertarget.hpp"
+
+namespace streamfx::obs {
+	/** Shares the output of filters between every render of the same frame.
+	 *
+	 * A filter on a source that is shown in several scenes, or in both preview and program, is rendered again for
+	 * every view. Instances that opted in are grouped by source type, settings hash, input and size, and a group that
+	 * was rendered more than once in the previous frame captures its first render of the next frame, which all other
+	 * renders then only draw. Groups that are only rendered once per frame are left alone and cost nothing.
+	 *
+	 * The input is the filter's target, which is unique to every filter chain. So in practice a group only ever holds
+	 * one instance, and distinct instances with the same settings are never merged. The input is still part of the
+	 * key, as reordering filters changes it and must not present a capture of what the filter saw before.
+	 */
+	class render_sharing {
+		public:
+		/** Source type, settings hash, input, width and height. */
+		typedef std::tuple<const char*, uint64_t, obs_source_t*, uint32_t, uint32_t> key_t;
+
+		private:
+		struct group {
+			uint32_t                                         renders  = 0;     // In this frame.
+			bool                                             shared   = false; // Rendered more than once last frame.
+			bool                                             captured = false; // In this frame.
+			std::shared_ptr<streamfx::obs::gs::rendertarget> target;
+		};
+
+		std::mutex             _lock;
+		uint64_t               _frame;
+		std::map<key_t, group> _groups;
+
+		public:
+		render_sharing();
+		~render_sharing();
+
+		/** Decide how a render of an instance happens.
+		 *
+		 * @param render Set if the caller has to render, into the returned target if there is one.
+		 * @return The target to draw once rendered, or nullptr if the caller renders directly as if nothing was shared.
+		 */
+		std::shared_ptr<streamfx::obs::gs::rendertarget> acquire(const key_t& key, bool& render);
+
+		private:
+		void next_frame();
+
+		public /* Singleton */:
+		static void                                           initialize();
+		static void                                           finalize();
+		static std::shared_ptr<streamfx::obs::render_sharing> get();
+	};
+} // namespace streamfx::obs
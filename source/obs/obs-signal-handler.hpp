@@ -58,9 +58,10 @@ namespace streamfx::obs {
 		}
 		virtual ~signal_handler()
 		{
-			event.clear();
+			// Disconnecting waits for a signal that is still being handled, clearing the event alone would not.
 			signal_handler_t* sh = obs_source_get_signal_handler(_keepalive.get());
 			signal_handler_disconnect(sh, _signal.c_str(), handle_signal, this);
+			event.clear();
 		}
 	};
 
@@ -84,8 +85,9 @@ namespace streamfx::obs {
 		}
 		virtual ~audio_signal_handler()
 		{
-			event.clear();
+			// Removing the callback waits for audio that is still being handled, clearing the event alone would not.
 			obs_source_remove_audio_capture_callback(_keepalive.get(), handle_audio, this);
+			event.clear();
 		}
 
 		streamfx::util::event<std::shared_ptr<obs_source_t>, const struct audio_data*, bool> event;
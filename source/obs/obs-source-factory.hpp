@@ -19,6 +19,16 @@
 
 #pragma once
 #include "common.hpp"
+#include <mutex>
+#include "obs/gs/gs-creation-queue.hpp"
+#include "obs/gs/gs-helper.hpp"
+#include "obs/gs/gs-rendertarget-pool.hpp"
+#include "obs/gs/gs-rendertarget.hpp"
+#include "obs/obs-governor.hpp"
+#include "obs/obs-memory-budget.hpp"
+#include "obs/obs-prewarm.hpp"
+#include "obs/obs-render-sharing.hpp"
+#include "obs/obs-statistics.hpp"
 #include "plugin.hpp"
 
 namespace streamfx::obs {
@@ -28,6 +38,7 @@ namespace streamfx::obs {
 		obs_source_info                                         _info = {};
 		std::map<std::string, std::shared_ptr<obs_source_info>> _proxies;
 		std::set<std::string>                                   _proxy_names;
+		bool                                                    _render_rate;
 
 		public:
 		source_factory()
@@ -49,6 +60,7 @@ namespace streamfx::obs {
 			set_visibility_tracking_enabled(false);
 			set_input_enabled(false);
 			set_have_child_sources(false);
+			set_render_rate_enabled(true);
 		}
 		virtual ~source_factory() {}
 
@@ -121,6 +133,14 @@ namespace streamfx::obs {
 			}
 		}
 
+		/** Offer the "Update Rate" options, which re-present the previous output instead of rendering every frame.
+		 * Only video filters and sources that render on the graphics thread support it, anything else ignores it.
+		 */
+		void set_render_rate_enabled(bool v)
+		{
+			_render_rate = v;
+		}
+
 		void finish_setup()
 		{
 			if (_info.output_flags & OBS_SOURCE_INTERACTION) {
@@ -129,6 +149,11 @@ namespace streamfx::obs {
 				set_input_enabled(false);
 			}
 
+			if ((_info.type == OBS_SOURCE_TYPE_TRANSITION)
+				|| ((_info.output_flags & OBS_SOURCE_ASYNC_VIDEO) != OBS_SOURCE_VIDEO)) {
+				set_render_rate_enabled(false);
+			}
+
 			if (_info.type == OBS_SOURCE_TYPE_TRANSITION) {
 				set_resolution_enabled(false);
 				_info.transition_start = _transition_start;
@@ -198,7 +223,14 @@ namespace streamfx::obs {
 
 		static void* _create(obs_data_t* settings, obs_source_t* source) noexcept
 		try {
-			return reinterpret_cast<_factory*>(obs_source_get_type_data(source))->create(settings, source);
+			obs::statistics::load_timer timer{nullptr, obs::statistics::load_step::Create};
+			auto*                       factory  = reinterpret_cast<_factory*>(obs_source_get_type_data(source));
+			auto*                       instance = reinterpret_cast<_instance*>(factory->create(settings, source));
+			if (instance) {
+				instance->update_render_rate(settings);
+				timer.set_target(instance->get_statistics());
+			}
+			return instance;
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 			return nullptr;
@@ -209,8 +241,15 @@ namespace streamfx::obs {
 
 		static void _get_defaults2(void* type_data, obs_data_t* settings) noexcept
 		try {
-			if (type_data)
-				reinterpret_cast<_factory*>(type_data)->get_defaults2(settings);
+			if (type_data) {
+				auto* factory = reinterpret_cast<_factory*>(type_data);
+				factory->get_defaults2(settings);
+				if (static_cast<source_factory*>(factory)->_render_rate) {
+					obs_data_set_default_int(settings, S_RENDERRATE_MODE, 0);
+					obs_data_set_default_int(settings, S_RENDERRATE_FRAMES, 2);
+					obs_data_set_default_double(settings, S_RENDERRATE_RATE, 10.);
+				}
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -219,8 +258,14 @@ namespace streamfx::obs {
 
 		static obs_properties_t* _get_properties2(void* data, void* type_data) noexcept
 		try {
-			if (type_data)
-				return reinterpret_cast<_factory*>(type_data)->get_properties2(reinterpret_cast<_instance*>(data));
+			if (type_data) {
+				auto* factory = reinterpret_cast<_factory*>(type_data);
+				auto* props   = factory->get_properties2(reinterpret_cast<_instance*>(data));
+				if (props && static_cast<source_factory*>(factory)->_render_rate) {
+					add_render_rate_properties(props);
+				}
+				return props;
+			}
 			return nullptr;
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
@@ -230,11 +275,47 @@ namespace streamfx::obs {
 			return nullptr;
 		}
 
+		static void add_render_rate_properties(obs_properties_t* props)
+		{
+			obs_properties_t* grp = obs_properties_create();
+			obs_properties_add_group(props, S_RENDERRATE, D_TRANSLATE(S_RENDERRATE), OBS_GROUP_NORMAL, grp);
+
+			auto p = obs_properties_add_list(grp, S_RENDERRATE_MODE, D_TRANSLATE(S_RENDERRATE_MODE),
+											 OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+			obs_property_list_add_int(p, D_TRANSLATE(S_RENDERRATE_MODE_EVERYFRAME), 0);
+			obs_property_list_add_int(p, D_TRANSLATE(S_RENDERRATE_MODE_FRAMES), 1);
+			obs_property_list_add_int(p, D_TRANSLATE(S_RENDERRATE_MODE_RATE), 2);
+			obs_property_set_modified_callback(p, _render_rate_modified);
+
+			obs_properties_add_int_slider(grp, S_RENDERRATE_FRAMES, D_TRANSLATE(S_RENDERRATE_FRAMES), 2, 120, 1);
+
+			p = obs_properties_add_float_slider(grp, S_RENDERRATE_RATE, D_TRANSLATE(S_RENDERRATE_RATE), 0.1, 60., 0.1);
+			obs_property_float_set_suffix(p, " Hz");
+		}
+
+		static bool _render_rate_modified(obs_properties_t* props, obs_property_t*, obs_data_t* settings) noexcept
+		try {
+			int64_t mode = obs_data_get_int(settings, S_RENDERRATE_MODE);
+			obs_property_set_visible(obs_properties_get(props, S_RENDERRATE_FRAMES), mode == 1);
+			obs_property_set_visible(obs_properties_get(props, S_RENDERRATE_RATE), mode == 2);
+			return true;
+		} catch (const std::exception& ex) {
+			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
+			return false;
+		} catch (...) {
+			DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+			return false;
+		}
+
 		private /* Instance */:
 		static void _destroy(void* data) noexcept
 		try {
-			if (data)
+			if (data) {
+				// Nothing may render or evict the instance while it is being torn down.
+				reinterpret_cast<_instance*>(data)->disable_prewarm();
+				reinterpret_cast<_instance*>(data)->disable_memory_budget();
 				delete reinterpret_cast<_instance*>(data);
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -269,8 +350,11 @@ namespace streamfx::obs {
 
 		static void _activate(void* data) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->activate();
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Visibility};
+				instance->activate();
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -279,8 +363,11 @@ namespace streamfx::obs {
 
 		static void _deactivate(void* data) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->deactivate();
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Visibility};
+				instance->deactivate();
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -289,8 +376,11 @@ namespace streamfx::obs {
 
 		static void _show(void* data) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->show();
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Visibility};
+				instance->show();
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -299,8 +389,11 @@ namespace streamfx::obs {
 
 		static void _hide(void* data) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->hide();
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Visibility};
+				instance->hide();
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -309,8 +402,15 @@ namespace streamfx::obs {
 
 		static void _video_tick(void* data, float seconds) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->video_tick(seconds);
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				if (instance->idle_tick(seconds))
+					return;
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::VideoTick};
+				instance->update_tick(seconds);
+				instance->render_rate_tick(seconds);
+				instance->video_tick(seconds);
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -319,8 +419,11 @@ namespace streamfx::obs {
 
 		static void _video_render(void* data, gs_effect_t* effect) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->video_render(effect);
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::VideoRender};
+				instance->render_limited(effect);
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -329,8 +432,11 @@ namespace streamfx::obs {
 
 		static void _video_render_filter(void* data, gs_effect_t* effect) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->video_render(effect);
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::VideoRender};
+				instance->render_limited(effect);
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 			obs_source_skip_video_filter(reinterpret_cast<_instance*>(data)->get());
@@ -341,8 +447,11 @@ namespace streamfx::obs {
 
 		static struct obs_source_frame* _filter_video(void* data, struct obs_source_frame* frame) noexcept
 		try {
-			if (data)
-				return reinterpret_cast<_instance*>(data)->filter_video(frame);
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::FilterVideo};
+				return instance->filter_video(frame);
+			}
 			return frame;
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
@@ -354,8 +463,11 @@ namespace streamfx::obs {
 
 		static struct obs_audio_data* _filter_audio(void* data, struct obs_audio_data* frame) noexcept
 		try {
-			if (data)
-				return reinterpret_cast<_instance*>(data)->filter_audio(frame);
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::FilterAudio};
+				return instance->filter_audio(frame);
+			}
 			return frame;
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
@@ -379,11 +491,19 @@ namespace streamfx::obs {
 		try {
 			auto priv = reinterpret_cast<_instance*>(data);
 			if (priv) {
+				obs::statistics::scope prof{priv->get_statistics(), obs::statistics::callback::Load};
 				uint64_t version = static_cast<uint64_t>(obs_data_get_int(settings, S_VERSION));
-				priv->migrate(settings, version);
+				{
+					obs::statistics::load_timer timer{priv->get_statistics(), obs::statistics::load_step::Migrate};
+					priv->migrate(settings, version);
+				}
 				obs_data_set_int(settings, S_VERSION, static_cast<int64_t>(STREAMFX_VERSION));
 				obs_data_set_string(settings, S_COMMIT, STREAMFX_COMMIT);
-				priv->load(settings);
+				priv->update_settings_hash(settings);
+				{
+					obs::statistics::load_timer timer{priv->get_statistics(), obs::statistics::load_step::Load};
+					priv->load(settings);
+				}
 			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
@@ -393,8 +513,13 @@ namespace streamfx::obs {
 
 		static void _update(void* data, obs_data_t* settings) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->update(settings);
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope      prof{instance->get_statistics(), obs::statistics::callback::Update};
+				obs::statistics::load_timer timer{instance->get_statistics(), obs::statistics::load_step::Update};
+				instance->update_render_rate(settings);
+				instance->queue_update(settings);
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -404,7 +529,9 @@ namespace streamfx::obs {
 		static void _save(void* data, obs_data_t* settings) noexcept
 		try {
 			if (data) {
-				reinterpret_cast<_instance*>(data)->save(settings);
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Save};
+				instance->save(settings);
 				obs_data_set_int(settings, S_VERSION, static_cast<int64_t>(STREAMFX_VERSION));
 				obs_data_set_string(settings, S_COMMIT, STREAMFX_COMMIT);
 			}
@@ -417,8 +544,11 @@ namespace streamfx::obs {
 		static void _mouse_click(void* data, const struct obs_mouse_event* event, int32_t type, bool mouse_up,
 								 uint32_t click_count) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->mouse_click(event, type, mouse_up, click_count);
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Interaction};
+				instance->mouse_click(event, type, mouse_up, click_count);
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -427,8 +557,11 @@ namespace streamfx::obs {
 
 		static void _mouse_move(void* data, const struct obs_mouse_event* event, bool mouse_leave) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->mouse_move(event, mouse_leave);
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Interaction};
+				instance->mouse_move(event, mouse_leave);
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -437,8 +570,11 @@ namespace streamfx::obs {
 
 		static void _mouse_wheel(void* data, const struct obs_mouse_event* event, int x_delta, int y_delta) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->mouse_wheel(event, x_delta, y_delta);
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Interaction};
+				instance->mouse_wheel(event, x_delta, y_delta);
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -447,8 +583,11 @@ namespace streamfx::obs {
 
 		static void _focus(void* data, bool focus) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->focus(focus);
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Interaction};
+				instance->focus(focus);
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -457,8 +596,11 @@ namespace streamfx::obs {
 
 		static void _key_click(void* data, const struct obs_key_event* event, bool key_up) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->key_click(event, key_up);
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Interaction};
+				instance->key_click(event, key_up);
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -478,9 +620,11 @@ namespace streamfx::obs {
 		static bool _audio_render(void* data, uint64_t* ts_out, struct obs_source_audio_mix* audio_output,
 								  uint32_t mixers, std::size_t channels, std::size_t sample_rate) noexcept
 		try {
-			if (data)
-				return reinterpret_cast<_instance*>(data)->audio_render(ts_out, audio_output, mixers, channels,
-																		sample_rate);
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::AudioRender};
+				return instance->audio_render(ts_out, audio_output, mixers, channels, sample_rate);
+			}
 			return false;
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
@@ -502,8 +646,11 @@ namespace streamfx::obs {
 
 		static void _transition_start(void* data) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->transition_start();
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Visibility};
+				instance->transition_start();
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -512,8 +659,11 @@ namespace streamfx::obs {
 
 		static void _transition_stop(void* data) noexcept
 		try {
-			if (data)
-				reinterpret_cast<_instance*>(data)->transition_stop();
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::Visibility};
+				instance->transition_stop();
+			}
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
 		} catch (...) {
@@ -523,8 +673,11 @@ namespace streamfx::obs {
 		static bool _audio_mix(void* data, uint64_t* ts_out, struct audio_output_data* audio_output,
 							   std::size_t channels, std::size_t sample_rate) noexcept
 		try {
-			if (data)
-				return reinterpret_cast<_instance*>(data)->audio_mix(ts_out, audio_output, channels, sample_rate);
+			if (data) {
+				auto* instance = reinterpret_cast<_instance*>(data);
+				obs::statistics::scope prof{instance->get_statistics(), obs::statistics::callback::AudioMix};
+				return instance->audio_mix(ts_out, audio_output, channels, sample_rate);
+			}
 			return false;
 		} catch (const std::exception& ex) {
 			DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
@@ -555,17 +708,430 @@ namespace streamfx::obs {
 
 	class source_instance {
 		protected:
-		obs_source_t* _self;
+		obs_source_t*                    _self;
+		std::shared_ptr<obs::statistics> _statistics;
+
+		float_t _idle_timeout; // Negative if not tracked.
+		float_t _hidden_time;
+		bool    _idle;
+
+		std::mutex  _update_lock;
+		obs_data_t* _update_pending;
+		float_t     _update_interval; // Zero or negative if not coalesced.
+		float_t     _update_elapsed;
+
+		uint32_t                                         _render_frames;   // Frames between renders, 0 if unlimited.
+		float_t                                          _render_interval; // Seconds between renders, 0 if unlimited.
+		uint32_t                                         _render_frame;
+		float_t                                          _render_elapsed;
+		bool                                             _render_due;
+		std::shared_ptr<streamfx::obs::gs::rendertarget> _render_cache;
+
+		bool     _render_sharing;
+		uint64_t _settings_hash; // Of the settings last passed to update() or load().
+		bool     _preview_profile;
+		bool     _prewarm;
+		bool     _prewarming; // During prewarm(), which renders at full quality even outside of program.
+		bool     _budgeted;
+
+		public:
+		source_instance(obs_data_t* settings, obs_source_t* source)
+			: _self(source), _statistics(obs::statistics::create(source)), _idle_timeout(-1.f), _hidden_time(0.f),
+			  _idle(false), _update_lock(), _update_pending(nullptr), _update_interval(-1.f), _update_elapsed(0.f),
+			  _render_frames(0), _render_interval(0.f), _render_frame(0), _render_elapsed(0.f), _render_due(true),
+			  _render_cache(), _render_sharing(false), _settings_hash(0), _preview_profile(false), _prewarm(false),
+			  _prewarming(false), _budgeted(false)
+		{}
+		virtual ~source_instance()
+		{
+			disable_memory_budget();
+			disable_prewarm();
+			if (_update_pending) {
+				obs_data_release(_update_pending);
+			}
+		};
+
+		protected:
+		/** Skip video_tick() while nothing shows this source (or the source of this filter), and call idle() once it
+		 * has not been shown for the configured idle timeout, or earlier if hidden instances exceed the video memory
+		 * budget. Hidden sources then cost neither GPU time nor memory.
+		 */
+		void enable_idle_tracking()
+		{
+			_idle_timeout = 10.f;
+			if (auto budget = streamfx::obs::memory_budget::get(); budget) {
+				_idle_timeout = budget->get_idle_timeout();
+				_budgeted     = true;
+				budget->add(this);
+			}
+		}
+
+		/** Apply settings changes in video_tick() instead of every time they change, at most once every interval
+		 * seconds. Dragging a slider then rebuilds at that rate rather than at the rate the UI sends changes. The last
+		 * change is always applied, it is only delayed. An interval of zero applies every change immediately.
+		 */
+		void enable_update_coalescing(float_t interval)
+		{
+			_update_interval = std::max(interval, 0.f);
+			_update_elapsed  = _update_interval;
+		}
+
+		/** Render at most once per frame and input, no matter in how many views the filter is shown, see
+		 * render_sharing. Only for filters whose output depends on nothing but their input and settings.
+		 */
+		void enable_render_sharing()
+		{
+			_render_sharing = true;
+		}
+
+		/** Allow is_preview_render() to report renders outside of program, for instances that have a cheaper way to
+		 * render which is good enough for preview, projectors and the multiview.
+		 */
+		void enable_preview_profile()
+		{
+			_preview_profile = true;
+		}
+
+		/** Whether this render cannot reach program, in which case a cheaper way to render may be used.
+		 *
+		 * libobs does not tell which view a render is for, but only active sources (or sources of active filters) are
+		 * part of an output. Inactive ones are only shown in preview, projectors or the multiview, and all of their
+		 * renders in a frame agree. Renders of active sources for other views keep full quality, and are cheap
+		 * already if the instance renders once per frame or uses render sharing.
+		 */
+		bool is_preview_render()
+		{
+			if (!_preview_profile || _prewarming) {
+				return false;
+			}
+			if (auto governor = streamfx::obs::governor::get(); !governor || !governor->is_preview_enabled()) {
+				return false;
+			}
+
+			obs_source_t* source = _self;
+			if (obs_source_get_type(_self) == OBS_SOURCE_TYPE_FILTER) {
+				source = obs_filter_get_parent(_self);
+			}
+			return source && !obs_source_active(source);
+		}
+
+		/** Render once ahead of time whenever the scene this instance is in is likely to go live next, see
+		 * obs::prewarm. For instances that create resources lazily on their first render.
+		 */
+		void enable_prewarm()
+		{
+			if (auto prewarm = streamfx::obs::prewarm::get(); prewarm) {
+				_prewarm = true;
+				prewarm->add(this);
+			}
+		}
 
 		public:
-		source_instance(obs_data_t* settings, obs_source_t* source) : _self(source) {}
-		virtual ~source_instance(){};
+		/** Remember which settings are applied, other instances with the same ones render the same. */
+		void update_settings_hash(obs_data_t* settings)
+		{
+			if (!_render_sharing) {
+				return;
+			}
+
+			uint64_t hash = 14695981039346656037ull; // FNV-1a
+			if (const char* json = obs_data_get_json(settings); json) {
+				for (; *json; json++) {
+					hash = (hash ^ static_cast<uint8_t>(*json)) * 1099511628211ull;
+				}
+			}
+			_settings_hash = hash;
+		}
+
+		/** Called instead of update() on settings changes, applies them immediately unless coalescing is enabled. */
+		void queue_update(obs_data_t* settings)
+		{
+			if (_update_interval <= 0) {
+				update_settings_hash(settings);
+				update(settings);
+				return;
+			}
+
+			std::unique_lock<std::mutex> lock(_update_lock);
+			obs_data_addref(settings);
+			if (_update_pending) {
+				obs_data_release(_update_pending);
+			}
+			_update_pending = settings;
+		}
+
+		/** Called before video_tick(), applies the latest queued settings once the interval has passed. */
+		void update_tick(float_t seconds)
+		{
+			if (_update_interval <= 0) {
+				return;
+			}
+
+			if (_update_elapsed < _update_interval) {
+				_update_elapsed += seconds;
+			}
+			if (_update_elapsed < _update_interval) {
+				return;
+			}
+
+			obs_data_t* settings = nullptr;
+			{
+				std::unique_lock<std::mutex> lock(_update_lock);
+				std::swap(settings, _update_pending);
+			}
+			if (settings) {
+				std::shared_ptr<obs_data_t> guard{settings, obs_data_release};
+				_update_elapsed = 0;
+				update_settings_hash(settings);
+				update(settings);
+			}
+		}
+
+		/** Read the "Update Rate" options offered by source_factory, which are absent (every frame) if not offered. */
+		void update_render_rate(obs_data_t* settings)
+		{
+			_render_frames   = 0;
+			_render_interval = 0.f;
+			switch (obs_data_get_int(settings, S_RENDERRATE_MODE)) {
+			case 1:
+				_render_frames =
+					static_cast<uint32_t>(std::max<int64_t>(obs_data_get_int(settings, S_RENDERRATE_FRAMES), 1));
+				break;
+			case 2:
+				if (double_t rate = obs_data_get_double(settings, S_RENDERRATE_RATE); rate > 0) {
+					_render_interval = static_cast<float_t>(1. / rate);
+				}
+				break;
+			}
+			_render_due = true;
+		}
+
+		/** Called before video_tick(), decides if the next frame renders or presents the previous output again. */
+		void render_rate_tick(float_t seconds)
+		{
+			if (_render_frames > 0) {
+				if (++_render_frame >= _render_frames) {
+					_render_frame = 0;
+					_render_due   = true;
+				}
+			} else if (_render_interval > 0) {
+				_render_elapsed += seconds;
+				if (_render_elapsed >= _render_interval) {
+					// Catch up by at most one render after a stall, instead of rendering every frame for a while.
+					_render_elapsed = std::min(_render_elapsed - _render_interval, _render_interval);
+					_render_due     = true;
+				}
+			}
+		}
+
+		/** Called instead of video_render(), only renders when due and presents a copy of that output otherwise.
+		 *
+		 * The output is captured with blending disabled and then drawn with the blend state set up by OBS, which is
+		 * what drawing it directly would have done. Every further view of the same frame also only presents the copy.
+		 */
+		void render_limited(gs_effect_t* effect)
+		{
+			uint32_t width  = obs_source_get_width(_self);
+			uint32_t height = obs_source_get_height(_self);
+			if (((_render_frames == 0) && (_render_interval <= 0)) || (width == 0) || (height == 0)) {
+				_render_cache.reset();
+				if (!render_shared(effect, width, height)) {
+					video_render(effect);
+				}
+				return;
+			}
+
+			if (!_render_cache) {
+				_render_cache = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+				_render_due   = true;
+			}
+			gs_texture_t* texture = _render_cache->get_object();
+			if (_render_due || !texture || (gs_texture_get_width(texture) != width)
+				|| (gs_texture_get_height(texture) != height)) {
+				_render_due = false;
+				capture(_render_cache, effect, width, height);
+				texture = _render_cache->get_object();
+			}
+			present(texture, width, height);
+		}
+
+		/** Called by render_limited() while not limited, returns false if the filter has to render directly. */
+		bool render_shared(gs_effect_t* effect, uint32_t width, uint32_t height)
+		{
+			obs_source_t* input   = obs_filter_get_target(_self);
+			auto          sharing = streamfx::obs::render_sharing::get();
+			if (!_render_sharing || !sharing || !input) {
+				return false;
+			}
+
+			streamfx::obs::render_sharing::key_t key{obs_source_get_id(_self), _settings_hash, input, width, height};
+			bool                                 render = false;
+			auto                                 target = sharing->acquire(key, render);
+			if (!target) {
+				return false;
+			}
+			if (render) {
+				capture(target, effect, width, height);
+			}
+			present(target->get_object(), width, height);
+			return true;
+		}
+
+		/** Render into a target with blending disabled, so that it can be presented with any blend state later. */
+		void capture(std::shared_ptr<streamfx::obs::gs::rendertarget> target, gs_effect_t* effect, uint32_t width,
+					 uint32_t height)
+		{
+			gs_blend_state_push();
+			gs_reset_blend_state();
+			gs_enable_blending(false);
+			try {
+				auto op    = target->render(width, height);
+				vec4 clear = {0};
+				gs_clear(GS_CLEAR_COLOR, &clear, 0, 0);
+				gs_ortho(0, static_cast<float_t>(width), 0, static_cast<float_t>(height), -1., 1.);
+				video_render(effect);
+			} catch (...) {
+				gs_blend_state_pop();
+				throw;
+			}
+			gs_blend_state_pop();
+		}
+
+		/** Draw a captured output with the blend state set up by OBS, like drawing it directly would have. */
+		void present(gs_texture_t* texture, uint32_t width, uint32_t height)
+		{
+			gs_effect_t* default_effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+			gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"), texture);
+			while (gs_effect_loop(default_effect, "Draw")) {
+				gs_draw_sprite(texture, 0, width, height);
+			}
+		}
+
+		/** Release anything that can be re-created lazily, called with the graphics context held.
+		 * The reported video memory is reset before, so only what is kept has to be reported again.
+		 */
+		virtual void idle() {}
+
+		bool is_idle()
+		{
+			return _idle;
+		}
+
+		/** Seconds since the source was last shown, 0 while it is showing. */
+		float_t get_hidden_time()
+		{
+			return _hidden_time;
+		}
+
+		/** Release everything idle() can release right now, unless it already did. */
+		void evict()
+		{
+			if (_idle) {
+				return;
+			}
+
+			auto gctx = streamfx::obs::gs::context();
+			_idle     = true;
+			_statistics->set_video_memory(0);
+			_render_cache.reset();
+			idle();
+		}
+
+		/** Called instead of video_tick(), returns true if the tick should be skipped. */
+		bool idle_tick(float_t seconds)
+		{
+			if (_idle_timeout < 0) {
+				return false;
+			}
+
+			obs_source_t* source = obs_filter_get_parent(_self);
+			if (obs_source_showing(source ? source : _self)) {
+				_hidden_time = 0;
+				_idle        = false;
+				return false;
+			}
+
+			_hidden_time += seconds;
+			if (_hidden_time >= _idle_timeout) {
+				evict();
+			}
+			return true;
+		}
+
+		/** Leave the memory budget, which otherwise may still evict the instance while its members are destroyed. */
+		void disable_memory_budget()
+		{
+			if (!_budgeted) {
+				return;
+			}
+
+			_budgeted = false;
+			if (auto budget = streamfx::obs::memory_budget::get(); budget) {
+				budget->remove(this);
+			}
+		}
+
+		/** Stop being warmed up, and drop a warm-up that has not happened yet. */
+		void disable_prewarm()
+		{
+			if (!_prewarm) {
+				return;
+			}
+
+			_prewarm = false;
+			if (auto prewarm = streamfx::obs::prewarm::get(); prewarm) {
+				prewarm->remove(this);
+			}
+			if (auto queue = streamfx::obs::gs::creation_queue::get(); queue) {
+				queue->cancel(&_prewarming);
+			}
+		}
+
+		/** Queue prewarm() on the creation queue, replacing an earlier one that has not happened yet. */
+		void queue_prewarm()
+		{
+			if (auto queue = streamfx::obs::gs::creation_queue::get(); queue) {
+				queue->cancel(&_prewarming);
+				queue->push(&_prewarming, [this]() { prewarm(); });
+			}
+		}
+
+		/** Render once into a throwaway target, so that whatever the first render creates exists already. Called
+		 * with the graphics context held.
+		 */
+		void prewarm()
+		{
+			uint32_t width  = obs_source_get_width(_self);
+			uint32_t height = obs_source_get_height(_self);
+			auto     pool   = streamfx::obs::gs::rendertarget_pool::instance();
+			if ((width == 0) || (height == 0) || !pool) {
+				return;
+			}
+
+			// Stay warm for a whole idle timeout, instead of being released again on the next tick.
+			_idle        = false;
+			_hidden_time = 0;
+
+			_prewarming = true;
+			try {
+				capture(pool->acquire(width, height), obs_get_base_effect(OBS_EFFECT_DEFAULT), width, height);
+			} catch (...) {
+				_prewarming = false;
+				throw;
+			}
+			_prewarming = false;
+		}
 
 		virtual obs_source_t* get()
 		{
 			return _self;
 		}
 
+		const std::shared_ptr<obs::statistics>& get_statistics()
+		{
+			return _statistics;
+		}
+
 		virtual uint32_t get_width()
 		{
 			return 0;
@@ -24,6 +24,30 @@
 
 static std::shared_ptr<streamfx::obs::source_tracker> source_tracker_instance;
 
+// Scene signals that change what a scene shows, or where.
+static const char* scene_signals[] = {"item_add",   "item_remove",  "reorder",
+                                      "refresh",    "item_visible", "item_transform"};
+
+void streamfx::obs::source_tracker::scene_change_handler(void* ptr, calldata_t*) noexcept
+{
+	reinterpret_cast<streamfx::obs::source_tracker*>(ptr)->_scene_generation++;
+}
+
+void streamfx::obs::source_tracker::connect_scene(obs_source_t* scene, bool connect)
+{
+	signal_handler_t* sh = obs_source_get_signal_handler(scene);
+	if (!sh) {
+		return;
+	}
+	for (auto signal : scene_signals) {
+		if (connect) {
+			signal_handler_connect(sh, signal, &scene_change_handler, this);
+		} else {
+			signal_handler_disconnect(sh, signal, &scene_change_handler, this);
+		}
+	}
+}
+
 void streamfx::obs::source_tracker::source_create_handler(void* ptr, calldata_t* data) noexcept
 try {
 	streamfx::obs::source_tracker* self = reinterpret_cast<streamfx::obs::source_tracker*>(ptr);
@@ -45,9 +69,15 @@ try {
 		return;
 	}
 
-	{
-		std::unique_lock<std::mutex> ul(self->_lock);
-		self->_sources.insert({std::string(name), {weak, streamfx::obs::obs_weak_source_deleter}});
+	tracked_source entry{{weak, streamfx::obs::obs_weak_source_deleter},
+						 obs_source_get_type(target),
+						 obs_source_get_output_flags(target)};
+	self->modify([&name, &entry](source_map_t& sources) { sources.insert({std::string(name), entry}); });
+
+	// Only tracked scenes are watched, as those are the ones that can be disconnected from again.
+	if (entry.type == OBS_SOURCE_TYPE_SCENE) {
+		self->connect_scene(target, true);
+		self->_scene_generation++;
 	}
 } catch (...) {
 	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
@@ -69,13 +99,9 @@ try {
 		return;
 	}
 
-	{
-		std::unique_lock<std::mutex> ul(self->_lock);
-		auto                         found = self->_sources.find(std::string(name));
-		if (found == self->_sources.end()) {
-			return;
-		}
-		self->_sources.erase(found);
+	self->modify([&name](source_map_t& sources) { sources.erase(std::string(name)); });
+	if (obs_source_get_type(target) == OBS_SOURCE_TYPE_SCENE) {
+		self->_scene_generation++;
 	}
 } catch (...) {
 	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
@@ -97,22 +123,38 @@ try {
 		return;
 	}
 
-	{
-		std::unique_lock<std::mutex> ul(self->_lock);
-		auto                         found = self->_sources.find(std::string(prev_name));
-		if (found == self->_sources.end()) {
+	self->modify([&](source_map_t& sources) {
+		auto found = sources.find(std::string(prev_name));
+		if (found == sources.end()) {
 			// Untracked source, insert.
 			obs_weak_source_t* weak = obs_source_get_weak_source(target);
 			if (!weak) {
 				return;
 			}
-			self->_sources.insert({new_name, {weak, streamfx::obs::obs_weak_source_deleter}});
+			sources.insert({new_name,
+							{{weak, streamfx::obs::obs_weak_source_deleter},
+							 obs_source_get_type(target),
+							 obs_source_get_output_flags(target)}});
 			return;
 		}
 
 		// Insert at new key, remove old pair.
-		self->_sources.insert({new_name, found->second});
-		self->_sources.erase(found);
+		sources.insert({new_name, found->second});
+		sources.erase(found);
+	});
+} catch (...) {
+	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+}
+
+void streamfx::obs::source_tracker::source_visibility_handler(void* ptr, calldata_t* data) noexcept
+try {
+	streamfx::obs::source_tracker* self = reinterpret_cast<streamfx::obs::source_tracker*>(ptr);
+
+	// Switching scenes changes which items are shown, without changing any scene.
+	obs_source_t* target = nullptr;
+	calldata_get_ptr(data, "source", &target);
+	if (target && (obs_source_get_type(target) == OBS_SOURCE_TYPE_SCENE)) {
+		self->_scene_generation++;
 	}
 } catch (...) {
 	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
@@ -134,11 +176,14 @@ std::shared_ptr<streamfx::obs::source_tracker> streamfx::obs::source_tracker::ge
 }
 
 streamfx::obs::source_tracker::source_tracker()
+	: _sources(std::make_shared<const source_map_t>()), _lock(), _scene_generation(1)
 {
 	auto osi = obs_get_signal_handler();
 	signal_handler_connect(osi, "source_create", &source_create_handler, this);
 	signal_handler_connect(osi, "source_destroy", &source_destroy_handler, this);
 	signal_handler_connect(osi, "source_rename", &source_rename_handler, this);
+	signal_handler_connect(osi, "source_show", &source_visibility_handler, this);
+	signal_handler_connect(osi, "source_hide", &source_visibility_handler, this);
 }
 
 streamfx::obs::source_tracker::~source_tracker()
@@ -148,28 +193,82 @@ streamfx::obs::source_tracker::~source_tracker()
 		signal_handler_disconnect(osi, "source_create", &source_create_handler, this);
 		signal_handler_disconnect(osi, "source_destroy", &source_destroy_handler, this);
 		signal_handler_disconnect(osi, "source_rename", &source_rename_handler, this);
+		signal_handler_disconnect(osi, "source_show", &source_visibility_handler, this);
+		signal_handler_disconnect(osi, "source_hide", &source_visibility_handler, this);
 	}
 
-	this->_sources.clear();
+	// Scenes that outlive the plugin must not call back into it.
+	for (auto& kv : *std::atomic_load(&_sources)) {
+		if (kv.second.type != OBS_SOURCE_TYPE_SCENE) {
+			continue;
+		}
+		if (obs_source_t* scene = obs_weak_source_get_source(kv.second.weak.get()); scene) {
+			connect_scene(scene, false);
+			obs_source_release(scene);
+		}
+	}
+
+	std::atomic_store(&_sources, std::make_shared<const source_map_t>());
 }
 
-void streamfx::obs::source_tracker::enumerate(enumerate_cb_t ecb, filter_cb_t fcb)
+void streamfx::obs::source_tracker::modify(std::function<void(source_map_t&)> fn)
+{
+	std::unique_lock<std::mutex> ul(_lock);
+	auto                         sources = std::make_shared<source_map_t>(*std::atomic_load(&_sources));
+	fn(*sources);
+	std::atomic_store(&_sources, std::shared_ptr<const source_map_t>(std::move(sources)));
+}
+
+// Decide the built-in filters from the type and flags remembered at creation, without touching the source at all.
+static bool is_cached_filter(const streamfx::obs::source_tracker::filter_cb_t& fcb)
+{
+	typedef bool (*filter_fn_t)(std::string, obs_source_t*);
+
+	auto fn = fcb ? fcb.target<filter_fn_t>() : nullptr;
+	return fn
+		   && ((*fn == &streamfx::obs::source_tracker::filter_sources)
+			   || (*fn == &streamfx::obs::source_tracker::filter_audio_sources)
+			   || (*fn == &streamfx::obs::source_tracker::filter_video_sources)
+			   || (*fn == &streamfx::obs::source_tracker::filter_transitions)
+			   || (*fn == &streamfx::obs::source_tracker::filter_scenes));
+}
+
+static bool cached_filter(const streamfx::obs::source_tracker::filter_cb_t& fcb, obs_source_type type, uint32_t flags)
 {
-	// Need func-local copy, otherwise we risk corruption if a new source is created or destroyed.
-	decltype(_sources) _clone;
-	{
-		std::unique_lock<std::mutex> ul(_lock);
-		_clone = _sources;
+	typedef bool (*filter_fn_t)(std::string, obs_source_t*);
+
+	auto fn = *fcb.target<filter_fn_t>();
+	if (fn == &streamfx::obs::source_tracker::filter_audio_sources) {
+		return !(flags & OBS_SOURCE_AUDIO) || (type != OBS_SOURCE_TYPE_INPUT);
+	} else if (fn == &streamfx::obs::source_tracker::filter_video_sources) {
+		return !(flags & OBS_SOURCE_VIDEO) || (type != OBS_SOURCE_TYPE_INPUT);
+	} else if (fn == &streamfx::obs::source_tracker::filter_transitions) {
+		return (type != OBS_SOURCE_TYPE_TRANSITION);
+	} else if (fn == &streamfx::obs::source_tracker::filter_scenes) {
+		return (type != OBS_SOURCE_TYPE_SCENE);
+	} else {
+		return (type != OBS_SOURCE_TYPE_INPUT);
 	}
+}
+
+void streamfx::obs::source_tracker::enumerate(enumerate_cb_t ecb, filter_cb_t fcb)
+{
+	// The snapshot can't change underneath us, and sources created or destroyed meanwhile simply aren't seen.
+	std::shared_ptr<const source_map_t> sources = std::atomic_load(&_sources);
+	bool                                cached  = is_cached_filter(fcb);
 
-	for (auto kv : _clone) {
-		auto source = std::shared_ptr<obs_source_t>(obs_weak_source_get_source(kv.second.get()),
+	for (auto& kv : *sources) {
+		if (cached && cached_filter(fcb, kv.second.type, kv.second.flags)) {
+			continue;
+		}
+
+		auto source = std::shared_ptr<obs_source_t>(obs_weak_source_get_source(kv.second.weak.get()),
 													streamfx::obs::obs_source_deleter);
 		if (!source) {
 			continue;
 		}
 
-		if (fcb) {
+		if (fcb && !cached) {
 			if (fcb(kv.first, source.get())) {
 				continue;
 			}
@@ -183,6 +282,11 @@ void streamfx::obs::source_tracker::enumerate(enumerate_cb_t ecb, filter_cb_t fc
 	}
 }
 
+uint64_t streamfx::obs::source_tracker::scene_generation()
+{
+	return _scene_generation.load();
+}
+
 bool streamfx::obs::source_tracker::filter_sources(std::string, obs_source_t* source)
 {
 	return (obs_source_get_type(source) != OBS_SOURCE_TYPE_INPUT);
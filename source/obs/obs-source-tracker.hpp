@@ -19,18 +19,35 @@
 
 #pragma once
 #include "common.hpp"
+#include <atomic>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
 
 namespace streamfx::obs {
 	class source_tracker {
-		std::map<std::string, std::shared_ptr<obs_weak_source_t>> _sources;
-		std::mutex                                                _lock;
+		struct tracked_source {
+			std::shared_ptr<obs_weak_source_t> weak;
+			obs_source_type                    type;
+			uint32_t                           flags;
+		};
+		typedef std::map<std::string, tracked_source> source_map_t;
+
+		// Readers only ever see an immutable snapshot, writers replace it as a whole while holding the lock.
+		std::shared_ptr<const source_map_t> _sources;
+		std::mutex                          _lock;
+		std::atomic<uint64_t>               _scene_generation;
+
+		void modify(std::function<void(source_map_t&)> fn);
 
 		static void source_create_handler(void* ptr, calldata_t* data) noexcept;
 		static void source_destroy_handler(void* ptr, calldata_t* data) noexcept;
 		static void source_rename_handler(void* ptr, calldata_t* data) noexcept;
+		static void source_visibility_handler(void* ptr, calldata_t* data) noexcept;
+		static void scene_change_handler(void* ptr, calldata_t* data) noexcept;
+
+		void connect_scene(obs_source_t* scene, bool connect);
 
 		public: // Singleton
 		static void                                           initialize();
@@ -62,6 +79,11 @@ namespace streamfx::obs {
 		// @param filter_cb Filter function to narrow down results.
 		void enumerate(enumerate_cb_t enumerate_cb, filter_cb_t filter_cb = nullptr);
 
+		// Changes whenever a scene is created, destroyed, shown or hidden, or an item in one is added, removed,
+		// reordered, shown, hidden, moved or cropped. Anything derived from the layout of scenes stays valid for as
+		// long as it doesn't.
+		uint64_t scene_generation();
+
 		public:
 		static bool filter_sources(std::string name, obs_source_t* source);
 		static bool filter_audio_sources(std::string name, obs_source_t* source);
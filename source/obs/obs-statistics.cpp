@@ -0,0 +1,431 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "obs-statistics.hpp"
+#include <algorithm>
+#include <sstream>
+#include "plugin.hpp"
+
+#define ST_PREFIX "<obs::statistics> "
+
+// Innermost load_timer and the load_cost nesting of the current thread.
+static thread_local streamfx::obs::statistics::load_timer*                           current_load_timer = nullptr;
+static thread_local std::array<uint32_t, streamfx::obs::statistics::load_step_count> load_cost_depth    = {};
+
+std::mutex                                            streamfx::obs::statistics::_registry_lock;
+std::vector<std::weak_ptr<streamfx::obs::statistics>> streamfx::obs::statistics::_registry;
+std::atomic<bool>                                     streamfx::obs::statistics::_loading{true};
+
+streamfx::obs::statistics::statistics(obs_source_t* source)
+	: _source(obs_source_get_weak_source(source)), _encoder(nullptr), _kind(kind::Source),
+	  _cpu(util::profiler::create()), _gpu(), _video_memory(0), _cache_hits(0), _cache_lookups(0), _callbacks(),
+	  _load()
+{
+#ifdef ENABLE_PROFILING
+	for (auto& entry : _callbacks) {
+		entry = util::profiler::create();
+	}
+#endif
+
+	switch (obs_source_get_type(source)) {
+	case OBS_SOURCE_TYPE_FILTER:
+		_kind = kind::Filter;
+		break;
+	case OBS_SOURCE_TYPE_TRANSITION:
+		_kind = kind::Transition;
+		break;
+	default:
+		_kind = kind::Source;
+		break;
+	}
+
+	if (obs_source_get_output_flags(source) & OBS_SOURCE_VIDEO) {
+		_gpu = std::make_shared<gs::gpu_timer>(obs_source_get_id(source));
+	}
+}
+
+streamfx::obs::statistics::statistics(obs_encoder_t* encoder)
+	: _source(nullptr), _encoder(obs_encoder_get_weak_encoder(encoder)), _kind(kind::Encoder),
+	  _cpu(util::profiler::create()), _gpu(), _video_memory(0), _cache_hits(0), _cache_lookups(0), _callbacks(),
+	  _load()
+{
+#ifdef ENABLE_PROFILING
+	// Encoders never see most source callbacks, so only keep the histograms they can use.
+	for (auto type : {callback::Update, callback::Encode}) {
+		_callbacks[static_cast<std::size_t>(type)] = util::profiler::create();
+	}
+#endif
+}
+
+streamfx::obs::statistics::~statistics()
+{
+	if (_source)
+		obs_weak_source_release(_source);
+	if (_encoder)
+		obs_weak_encoder_release(_encoder);
+}
+
+streamfx::obs::statistics::kind streamfx::obs::statistics::get_kind()
+{
+	return _kind;
+}
+
+std::string streamfx::obs::statistics::name()
+{
+	std::string result;
+	if (_source) {
+		if (obs_source_t* source = obs_weak_source_get_source(_source); source) {
+			result = obs_source_get_name(source);
+			if (obs_source_t* parent = obs_filter_get_parent(source); parent) {
+				result = std::string(obs_source_get_name(parent)) + " / " + result;
+			}
+			obs_source_release(source);
+		}
+	} else if (_encoder) {
+		if (obs_encoder_t* encoder = obs_weak_encoder_get_encoder(_encoder); encoder) {
+			result = obs_encoder_get_name(encoder);
+			obs_encoder_release(encoder);
+		}
+	}
+	return result;
+}
+
+obs_source_t* streamfx::obs::statistics::source()
+{
+	return _source ? obs_weak_source_get_source(_source) : nullptr;
+}
+
+std::shared_ptr<streamfx::util::profiler> streamfx::obs::statistics::cpu()
+{
+	return _cpu;
+}
+
+std::shared_ptr<streamfx::util::profiler> streamfx::obs::statistics::cpu(callback type)
+{
+	return _callbacks[static_cast<std::size_t>(type)];
+}
+
+std::shared_ptr<streamfx::obs::gs::gpu_timer> streamfx::obs::statistics::gpu()
+{
+	return _gpu;
+}
+
+void streamfx::obs::statistics::set_video_memory(uint64_t bytes)
+{
+	_video_memory.store(bytes, std::memory_order_relaxed);
+}
+
+uint64_t streamfx::obs::statistics::video_memory()
+{
+	return _video_memory.load(std::memory_order_relaxed);
+}
+
+void streamfx::obs::statistics::track_cache(bool hit)
+{
+	if (hit)
+		_cache_hits.fetch_add(1, std::memory_order_relaxed);
+	_cache_lookups.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t streamfx::obs::statistics::cache_lookups()
+{
+	return _cache_lookups.load(std::memory_order_relaxed);
+}
+
+double_t streamfx::obs::statistics::cache_hit_rate()
+{
+	uint64_t lookups = _cache_lookups.load(std::memory_order_relaxed);
+	uint64_t hits    = _cache_hits.load(std::memory_order_relaxed);
+	return lookups ? (static_cast<double_t>(hits) / static_cast<double_t>(lookups)) : 0.;
+}
+
+std::chrono::nanoseconds streamfx::obs::statistics::load_time(load_step step)
+{
+	return std::chrono::nanoseconds(_load[static_cast<std::size_t>(step)].load(std::memory_order_relaxed));
+}
+
+std::chrono::nanoseconds streamfx::obs::statistics::load_time()
+{
+	std::chrono::nanoseconds total{0};
+	for (auto step : {load_step::Create, load_step::Migrate, load_step::Load, load_step::Update}) {
+		total += load_time(step);
+	}
+	return total;
+}
+
+streamfx::obs::statistics::scope::scope(const std::shared_ptr<statistics>& parent, callback type)
+	: _parent(parent.get()), _type(type), _callback(nullptr), _total(false), _gpu(false), _trace(false), _start()
+{
+	if (!_parent)
+		return;
+
+	_callback = _parent->_callbacks[static_cast<std::size_t>(type)].get();
+	_total    = (type == callback::VideoTick) || (type == callback::VideoRender) || (type == callback::Encode);
+	_gpu      = (type == callback::VideoRender) && _parent->_gpu;
+	_trace    = util::trace::is_capturing();
+	if (!_total && !_callback && !_trace) {
+		// Untracked, so do not even pay for reading the clock.
+		_parent = nullptr;
+		return;
+	}
+
+	_start = std::chrono::high_resolution_clock::now();
+	if (_gpu)
+		_parent->_gpu->begin();
+}
+
+streamfx::obs::statistics::scope::~scope()
+{
+	if (!_parent)
+		return;
+
+	if (_gpu)
+		_parent->_gpu->end();
+
+	auto duration = std::chrono::high_resolution_clock::now() - _start;
+	if (_total)
+		_parent->_cpu->track(duration);
+	if (_callback)
+		_callback->track(duration);
+	if (_trace)
+		util::trace::record(callback_name(_type), reinterpret_cast<uintptr_t>(_parent), _start, duration);
+}
+
+streamfx::obs::statistics::load_timer::load_timer(const std::shared_ptr<statistics>& target, load_step step)
+	: _outer(current_load_timer), _target(target), _step(step), _nested(), _start()
+{
+	if (!is_loading() || (_target && (_target->load_time(step).count() != 0))) {
+		// Outside of loading, or already done once while loading.
+		_target.reset();
+		_outer = nullptr;
+		return;
+	}
+
+	current_load_timer = this;
+	_start             = std::chrono::high_resolution_clock::now();
+}
+
+streamfx::obs::statistics::load_timer::~load_timer()
+{
+	if (current_load_timer != this) {
+		return;
+	}
+	current_load_timer = _outer;
+
+	if (!_target) {
+		return;
+	}
+
+	// Zero marks a step as not done, so even the fastest step takes a nanosecond.
+	auto     now      = std::chrono::high_resolution_clock::now();
+	auto     duration = std::chrono::duration_cast<std::chrono::nanoseconds>(now - _start);
+	uint64_t expected = 0;
+	_target->_load[static_cast<std::size_t>(_step)].compare_exchange_strong(
+		expected, std::max<uint64_t>(static_cast<uint64_t>(duration.count()), 1), std::memory_order_relaxed);
+	for (auto step : {load_step::Effects, load_step::SDK}) {
+		if (uint64_t value = _nested[static_cast<std::size_t>(step)]; value) {
+			_target->_load[static_cast<std::size_t>(step)].fetch_add(value, std::memory_order_relaxed);
+		}
+	}
+}
+
+void streamfx::obs::statistics::load_timer::set_target(const std::shared_ptr<statistics>& target)
+{
+	if (current_load_timer == this) {
+		_target = target;
+	}
+}
+
+void streamfx::obs::statistics::load_timer::add(load_step step, std::chrono::nanoseconds duration)
+{
+	if (current_load_timer) {
+		current_load_timer->_nested[static_cast<std::size_t>(step)] += static_cast<uint64_t>(duration.count());
+	}
+}
+
+streamfx::obs::statistics::load_cost::load_cost(load_step step)
+	: _step(step), _outermost(load_cost_depth[static_cast<std::size_t>(step)]++ == 0), _start()
+{
+	// Nothing to charge the cost to outside of loading, so do not even read the clock.
+	if (_outermost && current_load_timer) {
+		_start = std::chrono::high_resolution_clock::now();
+	} else {
+		_outermost = false;
+	}
+}
+
+streamfx::obs::statistics::load_cost::~load_cost()
+{
+	load_cost_depth[static_cast<std::size_t>(_step)]--;
+	if (_outermost) {
+		load_timer::add(_step, std::chrono::duration_cast<std::chrono::nanoseconds>(
+								   std::chrono::high_resolution_clock::now() - _start));
+	}
+}
+
+std::shared_ptr<streamfx::obs::statistics> streamfx::obs::statistics::add(statistics* value)
+{
+	auto result = std::shared_ptr<statistics>(value);
+
+	std::unique_lock<std::mutex> lock(_registry_lock);
+	// Drop whatever expired since the last time, so that the registry does not grow forever.
+	_registry.erase(std::remove_if(_registry.begin(), _registry.end(),
+								   [](const std::weak_ptr<statistics>& v) { return v.expired(); }),
+					_registry.end());
+	_registry.push_back(result);
+	return result;
+}
+
+std::shared_ptr<streamfx::obs::statistics> streamfx::obs::statistics::create(obs_source_t* source)
+{
+	return add(new statistics(source));
+}
+
+std::shared_ptr<streamfx::obs::statistics> streamfx::obs::statistics::create(obs_encoder_t* encoder)
+{
+	return add(new statistics(encoder));
+}
+
+const char* streamfx::obs::statistics::callback_name(callback type)
+{
+	switch (type) {
+	case callback::VideoTick:
+		return "video_tick";
+	case callback::VideoRender:
+		return "video_render";
+	case callback::FilterVideo:
+		return "filter_video";
+	case callback::FilterAudio:
+		return "filter_audio";
+	case callback::AudioRender:
+		return "audio_render";
+	case callback::AudioMix:
+		return "audio_mix";
+	case callback::Load:
+		return "load";
+	case callback::Update:
+		return "update";
+	case callback::Save:
+		return "save";
+	case callback::Visibility:
+		return "visibility";
+	case callback::Interaction:
+		return "interaction";
+	case callback::Encode:
+		return "encode";
+	}
+	return "";
+}
+
+const char* streamfx::obs::statistics::load_step_name(load_step step)
+{
+	switch (step) {
+	case load_step::Create:
+		return "create";
+	case load_step::Migrate:
+		return "migrate";
+	case load_step::Load:
+		return "load";
+	case load_step::Update:
+		return "update";
+	case load_step::Effects:
+		return "effects";
+	case load_step::SDK:
+		return "sdk";
+	}
+	return "";
+}
+
+void streamfx::obs::statistics::set_loading(bool loading)
+{
+	_loading.store(loading, std::memory_order_relaxed);
+}
+
+bool streamfx::obs::statistics::is_loading()
+{
+	return _loading.load(std::memory_order_relaxed);
+}
+
+void streamfx::obs::statistics::log_load_summary(std::size_t limit)
+{
+	// Only instances that were loaded from the collection, anything created later loads on demand.
+	std::vector<std::shared_ptr<statistics>> values;
+	enumerate([&values](std::shared_ptr<statistics> value) {
+		if (value->load_time(load_step::Load).count() != 0)
+			values.push_back(value);
+	});
+	if (values.empty()) {
+		return;
+	}
+
+	std::sort(values.begin(), values.end(),
+			  [](const std::shared_ptr<statistics>& a, const std::shared_ptr<statistics>& b) {
+				  return a->load_time() > b->load_time();
+			  });
+
+	std::chrono::nanoseconds total{0};
+	for (auto& value : values) {
+		total += value->load_time();
+	}
+	DLOG_INFO(ST_PREFIX "Loaded %zu instance(s) in %.3f ms, the most expensive being:", values.size(),
+			  static_cast<double_t>(total.count()) / 1000000.);
+
+	for (std::size_t idx = 0; idx < std::min(limit, values.size()); idx++) {
+		auto&             value = values[idx];
+		std::stringstream sstr;
+		for (std::size_t step = 0; step < load_step_count; step++) {
+			if (auto time = value->load_time(static_cast<load_step>(step)); time.count() != 0) {
+				sstr << " " << load_step_name(static_cast<load_step>(step)) << " "
+					 << (static_cast<double_t>(time.count()) / 1000000.) << " ms,";
+			}
+		}
+		std::string steps = sstr.str();
+		if (!steps.empty()) {
+			steps.pop_back();
+		}
+		DLOG_INFO(ST_PREFIX "%2zu. '%s' %.3f ms:%s", idx + 1, value->name().c_str(),
+				  static_cast<double_t>(value->load_time().count()) / 1000000., steps.c_str());
+	}
+}
+
+void streamfx::obs::statistics::enumerate(std::function<void(std::shared_ptr<statistics>)> fn)
+{
+	std::vector<std::shared_ptr<statistics>> values;
+	{
+		std::unique_lock<std::mutex> lock(_registry_lock);
+		values.reserve(_registry.size());
+		for (auto& entry : _registry) {
+			if (auto value = entry.lock(); value)
+				values.push_back(value);
+		}
+	}
+
+	for (auto& value : values) {
+		fn(value);
+	}
+}
+
+uint64_t streamfx::obs::statistics::texture_memory(const std::shared_ptr<gs::texture>& texture)
+{
+	if (!texture)
+		return 0;
+
+	uint64_t size = static_cast<uint64_t>(texture->get_width()) * texture->get_height() * texture->get_depth();
+	return (size * gs_get_format_bpp(texture->get_color_format())) / 8;
+}
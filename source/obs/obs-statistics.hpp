@@ -0,0 +1,219 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "obs/gs/gs-texture.hpp"
+#include "obs/gs/gs-timer.hpp"
+#include "util/util-profiler.hpp"
+#include "util/util-trace.hpp"
+
+namespace streamfx::obs {
+	/** Runtime cost of a single source, filter, transition or encoder instance.
+	 *
+	 * The factories time every render, tick and encode call, while instances themselves report the video memory
+	 * they hold and how often their caches were hit. Times are inclusive, so a filter also pays for whatever it
+	 * renders below itself. Every live object can be listed through enumerate(), which the performance dock uses.
+	 *
+	 * With ENABLE_PROFILING, every callback from libobs is additionally timed into its own histogram.
+	 *
+	 * Loading a scene collection is timed separately, see load_timer, as it happens once and would vanish in the
+	 * averages otherwise.
+	 */
+	class statistics {
+		public:
+		enum class kind {
+			Source,
+			Filter,
+			Transition,
+			Encoder,
+		};
+
+		enum class callback : std::size_t {
+			VideoTick,
+			VideoRender,
+			FilterVideo,
+			FilterAudio,
+			AudioRender,
+			AudioMix,
+			Load,
+			Update,
+			Save,
+			Visibility,  // activate, deactivate, show, hide, transition start and stop
+			Interaction, // mouse, keyboard and focus
+			Encode,
+		};
+		static constexpr std::size_t callback_count = static_cast<std::size_t>(callback::Encode) + 1;
+
+		enum class load_step : std::size_t {
+			Create,
+			Migrate,
+			Load,
+			Update, // Only the first one.
+			// Spent within the steps above, so not part of the total.
+			Effects,
+			SDK,
+		};
+		static constexpr std::size_t load_step_count = static_cast<std::size_t>(load_step::SDK) + 1;
+
+		private:
+		obs_weak_source_t*              _source;
+		obs_weak_encoder_t*             _encoder;
+		kind                            _kind;
+		std::shared_ptr<util::profiler> _cpu;
+		std::shared_ptr<gs::gpu_timer>  _gpu;
+		std::atomic<uint64_t>           _video_memory;
+		std::atomic<uint64_t>           _cache_hits;
+		std::atomic<uint64_t>           _cache_lookups;
+
+		std::array<std::shared_ptr<util::profiler>, callback_count> _callbacks;
+		std::array<std::atomic<uint64_t>, load_step_count>          _load; // in nanoseconds, 0 if not yet done
+
+		statistics(obs_source_t* source);
+		statistics(obs_encoder_t* encoder);
+
+		public:
+		~statistics();
+
+		kind get_kind();
+
+		std::string name();
+
+		/** Strong reference to the source, or nullptr if it is gone or this tracks an encoder.
+		 * The caller must release it with obs_source_release.
+		 */
+		obs_source_t* source();
+
+		std::shared_ptr<util::profiler> cpu();
+
+		/** CPU time spent in a single callback, nullptr if it is not tracked.
+		 */
+		std::shared_ptr<util::profiler> cpu(callback type);
+
+		/** GPU time spent in video_render, nullptr for encoders.
+		 */
+		std::shared_ptr<gs::gpu_timer> gpu();
+
+		void     set_video_memory(uint64_t bytes);
+		uint64_t video_memory();
+
+		void     track_cache(bool hit);
+		uint64_t cache_lookups();
+		double_t cache_hit_rate();
+
+		/** Time spent in a step of loading this instance, or in total over the steps that are not nested in others.
+		 */
+		std::chrono::nanoseconds load_time(load_step step);
+		std::chrono::nanoseconds load_time();
+
+		public:
+		/** Times a callback for as long as it is alive.
+		 *
+		 * Ticks, renders and encodes also count towards the totals in cpu() and gpu(), everything else is only
+		 * tracked if its callback has a histogram. While a trace is captured, every callback also becomes a zone.
+		 */
+		class scope {
+			statistics*                                    _parent;
+			callback                                       _type;
+			util::profiler*                                _callback;
+			bool                                           _total;
+			bool                                           _gpu;
+			bool                                           _trace;
+			std::chrono::high_resolution_clock::time_point _start;
+
+			public:
+			scope(const std::shared_ptr<statistics>& parent, callback type);
+			~scope();
+		};
+
+		/** Times a step of loading an instance, along with any effects and SDKs that are initialized meanwhile.
+		 *
+		 * Nothing is timed unless a scene collection is being loaded, and of every step only the first time is kept.
+		 * The instance does not exist yet while it is being created, so the target can also be given afterwards.
+		 */
+		class load_timer {
+			load_timer*                                    _outer;
+			std::shared_ptr<statistics>                    _target;
+			load_step                                      _step;
+			std::array<uint64_t, load_step_count>          _nested;
+			std::chrono::high_resolution_clock::time_point _start;
+
+			public:
+			load_timer(const std::shared_ptr<statistics>& target, load_step step);
+			~load_timer();
+
+			void set_target(const std::shared_ptr<statistics>& target);
+
+			/** Call within an effect compile or SDK initialization, which is charged to the innermost timer. */
+			static void add(load_step step, std::chrono::nanoseconds duration);
+		};
+
+		/** Times an effect compile or SDK initialization for whichever instance is being loaded at the moment.
+		 * Nested costs of the same kind, such as an SDK initializing CUDA, are counted once.
+		 */
+		class load_cost {
+			load_step                                      _step;
+			bool                                           _outermost;
+			std::chrono::high_resolution_clock::time_point _start;
+
+			public:
+			load_cost(load_step step);
+			~load_cost();
+		};
+
+		private:
+		static std::mutex                             _registry_lock;
+		static std::vector<std::weak_ptr<statistics>> _registry;
+		static std::atomic<bool>                      _loading;
+
+		static std::shared_ptr<statistics> add(statistics* value);
+
+		public:
+		static std::shared_ptr<statistics> create(obs_source_t* source);
+
+		static std::shared_ptr<statistics> create(obs_encoder_t* encoder);
+
+		static const char* callback_name(callback type);
+
+		static const char* load_step_name(load_step step);
+
+		/** Whether a scene collection is being loaded, which is assumed until the frontend reports otherwise.
+		 */
+		static void set_loading(bool loading);
+		static bool is_loading();
+
+		/** Log the instances that took the longest to load, most expensive first.
+		 */
+		static void log_load_summary(std::size_t limit);
+
+		/** Call fn for every instance that is currently alive.
+		 */
+		static void enumerate(std::function<void(std::shared_ptr<statistics>)> fn);
+
+		/** Memory used by a texture, or 0 if there is none.
+		 */
+		static uint64_t texture_memory(const std::shared_ptr<gs::texture>& texture);
+	};
+} // namespace streamfx::obs
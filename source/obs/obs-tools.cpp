@@ -18,8 +18,12 @@
  */
 
 #include "obs-tools.hpp"
+#include <algorithm>
+#include <cmath>
 #include <map>
+#include <mutex>
 #include <stdexcept>
+#include "obs-source-tracker.hpp"
 #include "plugin.hpp"
 
 struct scs_searchdata {
@@ -170,6 +174,179 @@ bool streamfx::obs::tools::obs_properties_remove_by_name(obs_properties_t* props
 	return false;
 }
 
+bool streamfx::obs::tools::filter_direct_render(obs_source_t* self, gs_effect_t* effect, const char* technique,
+												 uint32_t width, uint32_t height)
+{
+	if (!obs_source_process_filter_begin(self, GS_RGBA, OBS_ALLOW_DIRECT_RENDERING)) {
+		obs_source_skip_video_filter(self);
+		return false;
+	}
+
+	obs_source_process_filter_tech_end(self, effect, width, height, technique);
+	return true;
+}
+
+struct vr_searchdata {
+	obs_source_t* source;
+	obs_source_t* last_filter = nullptr;
+	uint32_t      width;
+	uint32_t      height;
+	float_t       region[4] = {0, 0, 0, 0};
+	bool          found     = false;
+	bool          unknown   = false;
+	bool          showing   = false;
+};
+
+// Scanning every scene is only repeated once the layout of scenes changed, see source_tracker::scene_generation.
+struct vr_cache_entry {
+	uint32_t width;
+	uint32_t height;
+	float_t  region[4];
+	bool     found;
+	bool     unknown;
+	bool     showing;
+};
+static std::mutex                              vr_cache_lock;
+static uint64_t                                vr_cache_generation = 0;
+static std::map<obs_source_t*, vr_cache_entry> vr_cache;
+
+static void vr_enum_filters_cb(obs_source_t*, obs_source_t* filter, void* param) noexcept
+{
+	auto& sd = *reinterpret_cast<vr_searchdata*>(param);
+	if (obs_source_enabled(filter) && ((obs_source_get_output_flags(filter) & OBS_SOURCE_VIDEO) != 0)) {
+		sd.last_filter = filter;
+	}
+}
+
+static bool vr_enum_items_cb(obs_scene_t* scene, obs_sceneitem_t* item, void* param) noexcept
+{
+	auto&         sd     = *reinterpret_cast<vr_searchdata*>(param);
+	obs_source_t* source = obs_sceneitem_get_source(item);
+
+	// Items in groups are transformed by the group as well, which is not worth following.
+	if (obs_sceneitem_is_group(item)) {
+		if (obs_scene_find_source(obs_sceneitem_group_get_scene(item), obs_source_get_name(sd.source))) {
+			sd.unknown = true;
+		}
+		return !sd.unknown;
+	}
+	if ((source != sd.source) || !obs_sceneitem_visible(item)) {
+		return true;
+	}
+
+	// Map the corners of the scene back onto the cropped source, which the draw transform starts from.
+	matrix4 draw, inverse;
+	obs_sceneitem_get_draw_transform(item, &draw);
+	if (!matrix4_inv(&inverse, &draw)) {
+		return true;
+	}
+	obs_sceneitem_crop crop;
+	obs_sceneitem_get_crop(item, &crop);
+
+	obs_source_t* scene_source = obs_scene_get_source(scene);
+	float_t       scene_w      = static_cast<float_t>(obs_source_get_width(scene_source));
+	float_t       scene_h      = static_cast<float_t>(obs_source_get_height(scene_source));
+	float_t       bounds[4]    = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+	for (auto corner : {std::make_pair(0.f, 0.f), std::make_pair(scene_w, 0.f), std::make_pair(0.f, scene_h),
+						std::make_pair(scene_w, scene_h)}) {
+		vec3 pos, out;
+		vec3_set(&pos, corner.first, corner.second, 0.f);
+		vec3_transform(&out, &pos, &inverse);
+		bounds[0] = std::min(bounds[0], out.x);
+		bounds[1] = std::min(bounds[1], out.y);
+		bounds[2] = std::max(bounds[2], out.x);
+		bounds[3] = std::max(bounds[3], out.y);
+	}
+
+	float_t crop_w = static_cast<float_t>(sd.width) - static_cast<float_t>(crop.left + crop.right);
+	float_t crop_h = static_cast<float_t>(sd.height) - static_cast<float_t>(crop.top + crop.bottom);
+	float_t area[4]{
+		std::clamp(bounds[0], 0.f, crop_w) + crop.left,
+		std::clamp(bounds[1], 0.f, crop_h) + crop.top,
+		std::clamp(bounds[2], 0.f, crop_w) + crop.left,
+		std::clamp(bounds[3], 0.f, crop_h) + crop.top,
+	};
+	if ((area[0] >= area[2]) || (area[1] >= area[3])) {
+		return true;
+	}
+
+	// Remember if any scene that is actually being shown shows us, anything else shows us by other means.
+	sd.showing = sd.showing || obs_source_showing(scene_source);
+
+	if (!sd.found) {
+		std::copy(area, area + 4, sd.region);
+	} else {
+		sd.region[0] = std::min(sd.region[0], area[0]);
+		sd.region[1] = std::min(sd.region[1], area[1]);
+		sd.region[2] = std::max(sd.region[2], area[2]);
+		sd.region[3] = std::max(sd.region[3], area[3]);
+	}
+	sd.found = true;
+	return true;
+}
+
+static bool vr_enum_scenes_cb(void* param, obs_source_t* source) noexcept
+{
+	auto& sd = *reinterpret_cast<vr_searchdata*>(param);
+	if (obs_scene_t* scene = obs_scene_from_source(source); scene) {
+		obs_scene_enum_items(scene, vr_enum_items_cb, param);
+	}
+	return !sd.unknown;
+}
+
+bool streamfx::obs::tools::visible_region(obs_source_t* self, uint32_t width, uint32_t height, uint32_t region[4])
+{
+	vr_searchdata sd;
+	sd.source = obs_filter_get_parent(self);
+	sd.width  = width;
+	sd.height = height;
+	if (!sd.source || (obs_source_get_width(sd.source) != width) || (obs_source_get_height(sd.source) != height)) {
+		return false;
+	}
+
+	obs_source_enum_filters(sd.source, vr_enum_filters_cb, &sd);
+	if (sd.last_filter != self) {
+		return false;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(vr_cache_lock);
+		auto                         tracker = streamfx::obs::source_tracker::get();
+		uint64_t                     gen     = tracker ? tracker->scene_generation() : 0;
+		if (!tracker || (gen != vr_cache_generation)) {
+			vr_cache.clear();
+			vr_cache_generation = gen;
+		}
+
+		auto entry = vr_cache.find(sd.source);
+		if ((entry == vr_cache.end()) || (entry->second.width != width) || (entry->second.height != height)) {
+			obs_enum_scenes(vr_enum_scenes_cb, &sd);
+			vr_cache_entry value{width, height, {}, sd.found, sd.unknown, sd.showing};
+			std::copy(sd.region, sd.region + 4, value.region);
+			entry = vr_cache.insert_or_assign(sd.source, value).first;
+		}
+		std::copy(entry->second.region, entry->second.region + 4, sd.region);
+		sd.found   = entry->second.found;
+		sd.unknown = entry->second.unknown;
+		sd.showing = entry->second.showing;
+	}
+	if (!sd.found || sd.unknown) {
+		return false;
+	}
+
+	// Something other than a scene shows us, like a projector or another source, and may show all of us.
+	if (obs_source_showing(sd.source) && !sd.showing) {
+		return false;
+	}
+
+	for (std::size_t idx = 0; idx < 4; idx++) {
+		float_t limit = static_cast<float_t>((idx % 2) ? height : width);
+		float_t value = (idx < 2) ? std::floor(sd.region[idx]) : std::ceil(sd.region[idx]);
+		region[idx]   = static_cast<uint32_t>(std::clamp<float_t>(value, 0.f, limit));
+	}
+	return (region[0] > 0) || (region[1] > 0) || (region[2] < width) || (region[3] < height);
+}
+
 streamfx::obs::tools::child_source::child_source(obs_source_t* parent, std::shared_ptr<obs_source_t> child)
 	: _parent(parent), _child(child)
 {
@@ -26,6 +26,28 @@ namespace streamfx::obs {
 
 		bool obs_properties_remove_by_name(obs_properties_t* props, const char* name);
 
+		/** Apply an effect to the input of a filter while it is rendered, instead of capturing the input first.
+		 *
+		 * The input is bound to the "image" parameter of the effect. This saves one full resolution copy of the
+		 * input, but the result is not cached, so it is only worth it if the filter is rendered once per frame.
+		 * If the input can not be rendered right now, the filter is skipped and false is returned.
+		 *
+		 * Consecutive filters using this fuse into the capture of whichever filter after them needs a full input,
+		 * so that a chain of per-pixel filters writes one intermediate frame in total instead of two per filter.
+		 */
+		bool filter_direct_render(obs_source_t* self, gs_effect_t* effect, const char* technique, uint32_t width,
+								  uint32_t height);
+
+		/** Find the part of a filter's output that any scene actually shows, as left, top, right and bottom.
+		 *
+		 * Only the last filter on a source can know this, as filters after it may move pixels around. The region
+		 * takes the crop and transform of every visible scene item showing the source into account, and returns
+		 * false if all of the output may be visible or if it can not be determined, like for sources in groups or
+		 * sources that are shown without any shown scene showing them. Scenes are only scanned again once their
+		 * layout changed, so this is cheap enough to call every tick.
+		 */
+		bool visible_region(obs_source_t* self, uint32_t width, uint32_t height, uint32_t region[4]);
+
 		class child_source {
 			obs_source_t*                 _parent;
 			std::shared_ptr<obs_source_t> _child;
@@ -18,11 +18,20 @@
 */
 
 #include "plugin.hpp"
+#include <chrono>
 #include <fstream>
 #include <stdexcept>
 #include "configuration.hpp"
-#include "obs/gs/gs-vertexbuffer.hpp"
+#include "gfx/gfx-texture-file.hpp"
+#include "obs/gs/gs-creation-queue.hpp"
+#include "obs/gs/gs-helper.hpp"
+#include "obs/obs-governor.hpp"
+#include "obs/obs-memory-budget.hpp"
+#include "obs/obs-prewarm.hpp"
+#include "obs/obs-render-sharing.hpp"
 #include "obs/obs-source-tracker.hpp"
+#include "util/util-file-watcher.hpp"
+#include "util/util-trace.hpp"
 
 #ifdef ENABLE_NVIDIA_CUDA
 #include "nvidia/cuda/nvidia-cuda-obs.hpp"
@@ -60,6 +69,9 @@
 #include "filters/filter-video-superresolution.hpp"
 #endif
 
+#ifdef ENABLE_SOURCE_FACE_CROP
+#include "sources/source-face-crop.hpp"
+#endif
 #ifdef ENABLE_SOURCE_MIRROR
 #include "sources/source-mirror.hpp"
 #endif
@@ -80,55 +92,130 @@
 //static std::shared_ptr<streamfx::updater> _updater;
 #endif
 
+// Global configuration keys.
+#define ST_CFG_THREADPOOL_POLICY "threadpool.policy"
+
 static std::shared_ptr<streamfx::util::threadpool>       _threadpool;
-static std::shared_ptr<streamfx::obs::gs::vertex_buffer> _gs_fstri_vb;
+static std::shared_ptr<gs_vertbuffer_t>                  _gs_fstri_vb;
+#ifdef ENABLE_NVIDIA_CUDA
+static std::shared_ptr<streamfx::nvidia::cuda::obs>      _cuda;
+static std::shared_ptr<streamfx::util::threadpool::task> _cuda_task;
+#endif
+
+namespace {
+	/** Logs how long the enclosing scope took, so slow subsystems stand out in the startup log.
+	 */
+	class startup_timer {
+		const char*                                    _name;
+		std::chrono::high_resolution_clock::time_point _start;
+
+		public:
+		startup_timer(const char* name) : _name(name), _start(std::chrono::high_resolution_clock::now()) {}
+		~startup_timer()
+		{
+			auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::high_resolution_clock::now() - _start);
+			DLOG_INFO("Initialized %s in %.3f ms.", _name, elapsed.count() / 1000.0);
+		}
+	};
+} // namespace
 
 MODULE_EXPORT bool obs_module_load(void)
 try {
+	// Everything after this is logged from a background thread.
+	streamfx::util::logging::initialize();
+
 	DLOG_INFO("Loading Version %s", STREAMFX_VERSION_STRING);
+	DLOG_INFO("CPU supports up to %s.", streamfx::util::platform::get_isa_name(streamfx::util::platform::get_isa()));
+	startup_timer total("everything");
 
 	// Initialize global configuration.
 	streamfx::configuration::initialize();
 
 	// Initialize global Thread Pool.
-	_threadpool = std::make_shared<streamfx::util::threadpool>();
+	{ // Workers follow the policy from the global configuration, which leaves them alone by default.
+		int64_t policy = 0;
+		if (auto config = streamfx::configuration::instance(); config) {
+			policy = obs_data_get_int(config->get().get(), ST_CFG_THREADPOOL_POLICY);
+		}
+		_threadpool =
+			std::make_shared<streamfx::util::threadpool>(static_cast<streamfx::util::platform::thread_policy>(policy));
+	}
+
+	// Initialize Image Files
+	streamfx::gfx::texture_file::initialize();
 
 	// Initialize Source Tracker
 	streamfx::obs::source_tracker::initialize();
 
+	// Initialize Frame Budget Governor
+	streamfx::obs::governor::initialize();
+
+	// Initialize Video Memory Budget
+	streamfx::obs::memory_budget::initialize();
+
+	// Initialize Render Sharing
+	streamfx::obs::render_sharing::initialize();
+
+	// Initialize Deferred Resource Creation
+	streamfx::obs::gs::creation_queue::initialize();
+
+	// Initialize Scene Pre-Warming
+	streamfx::obs::prewarm::initialize();
+
+	// Initialize Trace Capture
+	streamfx::util::trace::initialize();
+
+	// Initialize File Watcher
+	streamfx::util::file_watcher::initialize();
+
 #ifdef ENABLE_NVIDIA_CUDA
-	// Initialize CUDA if features requested it.
-	std::shared_ptr<::streamfx::nvidia::cuda::obs> cuda;
-	try {
-		cuda = ::streamfx::nvidia::cuda::obs::get();
-	} catch (...) {
-		// If CUDA failed to load, it is considered safe to ignore.
-	}
+	// Initialize CUDA if features requested it. Loading the driver and creating the context takes a while and nothing
+	// during registration needs it, so it warms up on the thread pool while the rest of the plugin loads.
+	_cuda_task = _threadpool->push(
+		[](streamfx::util::threadpool_data_t) {
+			try {
+				startup_timer timer("CUDA");
+				_cuda = ::streamfx::nvidia::cuda::obs::get();
+			} catch (...) {
+				// If CUDA failed to load, it is considered safe to ignore.
+			}
+		},
+		nullptr);
 #endif
 
 	// GS Stuff
 	{
-		_gs_fstri_vb = std::make_shared<streamfx::obs::gs::vertex_buffer>(uint32_t(3), uint8_t(1));
-		{
-			auto vtx = _gs_fstri_vb->at(0);
-			vec3_set(vtx.position, 0, 0, 0);
-			vec4_set(vtx.uv[0], 0, 0, 0, 0);
-		}
-		{
-			auto vtx = _gs_fstri_vb->at(1);
-			vec3_set(vtx.position, 2, 0, 0);
-			vec4_set(vtx.uv[0], 2, 0, 0, 0);
-		}
-		{
-			auto vtx = _gs_fstri_vb->at(2);
-			vec3_set(vtx.position, 0, 2, 0);
-			vec4_set(vtx.uv[0], 0, 2, 0, 0);
+		// The full screen triangle never changes, so it lives in an immutable buffer shared by every full screen pass.
+		gs_vb_data* vbd       = gs_vbdata_create();
+		vbd->num              = 3;
+		vbd->points           = static_cast<vec3*>(bzalloc(sizeof(vec3) * 3));
+		vbd->num_tex          = 1;
+		vbd->tvarray          = static_cast<gs_tvertarray*>(bzalloc(sizeof(gs_tvertarray)));
+		vbd->tvarray[0].width = 4;
+		vbd->tvarray[0].array = bzalloc(sizeof(vec4) * 3);
+
+		auto uvs = static_cast<vec4*>(vbd->tvarray[0].array);
+		vec3_set(&vbd->points[0], 0, 0, 0);
+		vec4_set(&uvs[0], 0, 0, 0, 0);
+		vec3_set(&vbd->points[1], 2, 0, 0);
+		vec4_set(&uvs[1], 2, 0, 0, 0);
+		vec3_set(&vbd->points[2], 0, 2, 0);
+		vec4_set(&uvs[2], 0, 2, 0, 0);
+
+		auto gctx    = streamfx::obs::gs::context();
+		_gs_fstri_vb = std::shared_ptr<gs_vertbuffer_t>(gs_vertexbuffer_create(vbd, 0), [](gs_vertbuffer_t* v) {
+			auto gctx = streamfx::obs::gs::context();
+			gs_vertexbuffer_destroy(v);
+		});
+		if (!_gs_fstri_vb) {
+			throw std::runtime_error("Failed to create full screen triangle.");
 		}
-		_gs_fstri_vb->update();
 	}
 
 	// Encoders
 	{
+		startup_timer timer("encoders");
 #ifdef ENABLE_ENCODER_FFMPEG
 		using namespace streamfx::encoder::ffmpeg;
 		ffmpeg_manager::initialize();
@@ -137,6 +224,7 @@ try {
 
 	// Filters
 	{
+		startup_timer timer("filters");
 #ifdef ENABLE_FILTER_BLUR
 		streamfx::filter::blur::blur_factory::initialize();
 #endif
@@ -168,6 +256,10 @@ try {
 
 	// Sources
 	{
+		startup_timer timer("sources");
+#ifdef ENABLE_SOURCE_FACE_CROP
+		streamfx::source::face_crop::face_crop_factory::initialize();
+#endif
 #ifdef ENABLE_SOURCE_MIRROR
 		streamfx::source::mirror::mirror_factory::initialize();
 #endif
@@ -178,6 +270,7 @@ try {
 
 	// Transitions
 	{
+		startup_timer timer("transitions");
 #ifdef ENABLE_TRANSITION_SHADER
 		streamfx::transition::shader::shader_factory::initialize();
 #endif
@@ -185,7 +278,10 @@ try {
 
 // Frontend
 #ifdef ENABLE_FRONTEND
-	streamfx::ui::handler::initialize();
+	{
+		startup_timer timer("frontend");
+		streamfx::ui::handler::initialize();
+	}
 #endif
 
 	DLOG_INFO("Loaded Version %s", STREAMFX_VERSION_STRING);
@@ -216,6 +312,9 @@ try {
 
 	// Sources
 	{
+#ifdef ENABLE_SOURCE_FACE_CROP
+		streamfx::source::face_crop::face_crop_factory::finalize();
+#endif
 #ifdef ENABLE_SOURCE_MIRROR
 		streamfx::source::mirror::mirror_factory::finalize();
 #endif
@@ -267,6 +366,27 @@ try {
 		_gs_fstri_vb.reset();
 	}
 
+	// Finalize File Watcher
+	streamfx::util::file_watcher::finalize();
+
+	// Finalize Trace Capture
+	streamfx::util::trace::finalize();
+
+	// Finalize Scene Pre-Warming
+	streamfx::obs::prewarm::finalize();
+
+	// Finalize Deferred Resource Creation
+	streamfx::obs::gs::creation_queue::finalize();
+
+	// Finalize Render Sharing
+	streamfx::obs::render_sharing::finalize();
+
+	// Finalize Video Memory Budget
+	streamfx::obs::memory_budget::finalize();
+
+	// Finalize Frame Budget Governor
+	streamfx::obs::governor::finalize();
+
 	// Finalize Source Tracker
 	streamfx::obs::source_tracker::finalize();
 
@@ -278,14 +398,23 @@ try {
 	// Finalize Thread Pool
 	_threadpool.reset();
 
+#ifdef ENABLE_NVIDIA_CUDA
+	// Finalize CUDA, which can only be done once the warm-up task is guaranteed to be gone.
+	_cuda_task.reset();
+	_cuda.reset();
+#endif
+
 	// Finalize Configuration
 	streamfx::configuration::finalize();
 
 	DLOG_INFO("Unloaded Version %s", STREAMFX_VERSION_STRING);
+	streamfx::util::logging::finalize();
 } catch (std::exception const& ex) {
 	DLOG_ERROR("Unexpected exception in function '%s': %s", __FUNCTION_NAME__, ex.what());
+	streamfx::util::logging::finalize();
 } catch (...) {
 	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+	streamfx::util::logging::finalize();
 }
 
 std::shared_ptr<streamfx::util::threadpool> streamfx::threadpool()
@@ -295,8 +424,8 @@ std::shared_ptr<streamfx::util::threadpool> streamfx::threadpool()
 
 void streamfx::gs_draw_fullscreen_tri()
 {
-	gs_load_vertexbuffer(_gs_fstri_vb->update(false));
-	gs_draw(GS_TRIS, 0, 3); //_gs_fstri_vb->size());
+	gs_load_vertexbuffer(_gs_fstri_vb.get());
+	gs_draw(GS_TRIS, 0, 3);
 }
 
 std::filesystem::path streamfx::data_file_path(std::string_view file)
@@ -0,0 +1,362 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "source-face-crop.hpp"
+#include "strings.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <utility>
+#include "obs/gs/gs-helper.hpp"
+#include "obs/obs-source-tracker.hpp"
+
+#define ST_I18N "Source.FaceCrop"
+#define ST_I18N_SOURCE ST_I18N ".Source"
+#define ST_KEY_SOURCE "Source.FaceCrop.Source"
+#define ST_I18N_FACE ST_I18N ".Face"
+#define ST_KEY_FACE "Source.FaceCrop.Face"
+#define ST_I18N_ZOOM ST_I18N ".Zoom"
+#define ST_KEY_ZOOM "Source.FaceCrop.Zoom"
+#define ST_I18N_OFFSET ST_I18N ".Offset"
+#define ST_I18N_OFFSET_X ST_I18N_OFFSET ".X"
+#define ST_KEY_OFFSET_X "Source.FaceCrop.Offset.X"
+#define ST_I18N_OFFSET_Y ST_I18N_OFFSET ".Y"
+#define ST_KEY_OFFSET_Y "Source.FaceCrop.Offset.Y"
+#define ST_I18N_STABILITY ST_I18N ".Stability"
+#define ST_KEY_STABILITY "Source.FaceCrop.Stability"
+
+// Faces a tracker follows at most, see the NVIDIA Face Tracking filter.
+#define ST_MAX_FACES 8
+
+#define ST_PREFIX "<source::face_crop> "
+
+using namespace streamfx::source::face_crop;
+
+face_crop_instance::face_crop_instance(obs_data_t* settings, obs_source_t* self)
+	: obs::source_instance(settings, self), _source(), _source_child(), _signal_rename(), _source_texture(),
+	  _source_size(), _cfg_index(0), _cfg_zoom(.5), _cfg_offset({0., 0.}), _cfg_stability(.5), _tracking(),
+	  _filters(), _center{.5, .5}, _size{1., 1.}, _geometry(),
+	  _framed_warning(false)
+{
+	{
+		auto gctx = streamfx::obs::gs::context{};
+		_geometry = std::make_shared<streamfx::obs::gs::vertex_buffer>(uint32_t(4), uint8_t(1));
+	}
+
+	update(settings);
+}
+
+face_crop_instance::~face_crop_instance()
+{
+	release();
+}
+
+uint32_t face_crop_instance::get_width()
+{
+	return _source_size.first ? _source_size.first : 1;
+}
+
+uint32_t face_crop_instance::get_height()
+{
+	return _source_size.second ? _source_size.second : 1;
+}
+
+void face_crop_instance::load(obs_data_t* data)
+{
+	update(data);
+}
+
+void face_crop_instance::migrate(obs_data_t* data, uint64_t version) {}
+
+void face_crop_instance::update(obs_data_t* data)
+{
+	int64_t face       = std::clamp<int64_t>(obs_data_get_int(data, ST_KEY_FACE), 1, ST_MAX_FACES);
+	_cfg_index         = static_cast<std::size_t>(face - 1);
+	_cfg_zoom          = obs_data_get_double(data, ST_KEY_ZOOM) / 100.0;
+	_cfg_offset.first  = obs_data_get_double(data, ST_KEY_OFFSET_X) / 100.0;
+	_cfg_offset.second = obs_data_get_double(data, ST_KEY_OFFSET_Y) / 100.0;
+	_cfg_stability     = obs_data_get_double(data, ST_KEY_STABILITY) / 100.0;
+	refresh_region_of_interest();
+
+	if (const char* name = obs_data_get_string(data, ST_KEY_SOURCE);
+		!_source || (strcmp(name, obs_source_get_name(_source.get())) != 0)) {
+		acquire(name);
+	}
+}
+
+void face_crop_instance::save(obs_data_t* data)
+{
+	if (_source) {
+		obs_data_set_string(data, ST_KEY_SOURCE, obs_source_get_name(_source.get()));
+	} else {
+		obs_data_unset_user_value(data, ST_KEY_SOURCE);
+	}
+}
+
+void face_crop_instance::video_tick(float_t time)
+{
+	if (!_source) {
+		return;
+	}
+	_source_size.first  = obs_source_get_width(_source.get());
+	_source_size.second = obs_source_get_height(_source.get());
+
+	// Frame the face with the aspect ratio of the source, like the tracking filter does, or show all of the source.
+	_center[0] = _center[1] = .5;
+	_size[0] = _size[1] = 1.;
+	auto frame = _tracking.get(_source.get());
+	if (frame && frame->framed) {
+		// The tracked faces are in the frame before the tracker crops it, so they don't match what is shown here.
+		if (!std::exchange(_framed_warning, true)) {
+			DLOG_WARNING(ST_PREFIX "<%s> Source '%s' is already framed by its tracker, disable 'Frame the First Face' "
+								   "on it to crop faces.",
+						 obs_source_get_name(_self), obs_source_get_name(_source.get()));
+		}
+	} else if (frame && (_cfg_index < frame->tracks.size())) {
+		const ::streamfx::util::tracking::rect& face = frame->tracks[_cfg_index];
+		if ((face.width > 0.) && (face.height > 0.) && (_source_size.second > 0)) {
+			// Keeping the aspect ratio of the source means the same size in both normalized directions.
+			double_t size = streamfx::util::math::lerp<double_t>(1., face.height, _cfg_zoom);
+			size          = std::clamp(size, 10. / static_cast<double_t>(_source_size.second), 1.);
+
+			double_t cx = face.x + face.width / 2. + face.width * _cfg_offset.first;
+			double_t cy = face.y + face.height / 2. + face.height * _cfg_offset.second;
+
+			_center[0] = std::clamp(cx, size / 2., 1. - size / 2.);
+			_center[1] = std::clamp(cy, size / 2., 1. - size / 2.);
+			_size[0] = _size[1] = size;
+		}
+	}
+
+	_filters.center[0].filter(_center[0]);
+	_filters.center[1].filter(_center[1]);
+	_filters.size[0].filter(_size[0]);
+	_filters.size[1].filter(_size[1]);
+	refresh_geometry();
+}
+
+void face_crop_instance::video_render(gs_effect_t* effect)
+{
+	if (!_source || !_source_texture || !_source_size.first || !_source_size.second) {
+		return;
+	}
+	if ((obs_source_get_output_flags(_source.get()) & OBS_SOURCE_VIDEO) == 0) {
+		return;
+	}
+
+#ifdef ENABLE_PROFILING
+	streamfx::obs::gs::debug_marker gdmp{streamfx::obs::gs::debug_color_source, "Face Crop '%s' of '%s'",
+										 obs_source_get_name(_self), obs_source_get_name(_source.get())};
+#endif
+
+	// Other crops of the same source reuse this texture, so it is only rendered and tracked once per frame.
+	auto tex = _source_texture->render(_source_size.first, _source_size.second);
+	if (!tex) {
+		return;
+	}
+
+	gs_effect_t* default_effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+	gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"), tex->get_object());
+	gs_load_vertexbuffer(_geometry->update(false));
+	while (gs_effect_loop(default_effect, "Draw")) {
+		gs_draw(gs_draw_mode::GS_TRISTRIP, 0, 0);
+	}
+	gs_load_vertexbuffer(nullptr);
+}
+
+void face_crop_instance::enum_active_sources(obs_source_enum_proc_t cb, void* ptr)
+{
+	if (!_source)
+		return;
+	cb(_self, _source.get(), ptr);
+}
+
+void face_crop_instance::enum_all_sources(obs_source_enum_proc_t cb, void* ptr)
+{
+	if (!_source)
+		return;
+	cb(_self, _source.get(), ptr);
+}
+
+void face_crop_instance::acquire(std::string source_name)
+try {
+	release();
+
+	std::shared_ptr<obs_source_t> source =
+		std::shared_ptr<obs_source_t>{obs_get_source_by_name(source_name.c_str()), obs::obs_source_deleter};
+	if ((!source) || (source.get() == _self)) {
+		return;
+	}
+
+	_source_child       = std::make_shared<obs::tools::child_source>(_self, source);
+	_source             = source;
+	_source_size.first  = obs_source_get_width(_source.get());
+	_source_size.second = obs_source_get_height(_source.get());
+	_source_texture     = std::make_shared<gfx::source_texture>(_source.get(), _self);
+
+	// Listen to the rename event to update our own settings.
+	_signal_rename = std::make_shared<obs::source_signal_handler>("rename", _source);
+	_signal_rename->event.add(
+		std::bind(&face_crop_instance::on_rename, this, std::placeholders::_1, std::placeholders::_2));
+} catch (...) {
+	release();
+}
+
+void face_crop_instance::release()
+{
+	_signal_rename.reset();
+	_source_texture.reset();
+	_source_child.reset();
+	_source.reset();
+}
+
+void face_crop_instance::refresh_region_of_interest()
+{
+	double_t kalman_q = streamfx::util::math::lerp<double_t>(1.0, 1e-6, _cfg_stability);
+	double_t kalman_r =
+		streamfx::util::math::lerp<double_t>(std::numeric_limits<double_t>::epsilon(), 1e+2, _cfg_stability);
+
+	_filters.center[0] = streamfx::util::math::kalman1D<double_t>{kalman_q, kalman_r, 1., _center[0]};
+	_filters.center[1] = streamfx::util::math::kalman1D<double_t>{kalman_q, kalman_r, 1., _center[1]};
+	_filters.size[0]   = streamfx::util::math::kalman1D<double_t>{kalman_q, kalman_r, 1., _size[0]};
+	_filters.size[1]   = streamfx::util::math::kalman1D<double_t>{kalman_q, kalman_r, 1., _size[1]};
+}
+
+void face_crop_instance::refresh_geometry()
+{
+	auto v0 = _geometry->at(0);
+	auto v1 = _geometry->at(1);
+	auto v2 = _geometry->at(2);
+	auto v3 = _geometry->at(3);
+
+	vec3_set(v3.position, static_cast<float_t>(_source_size.first), static_cast<float_t>(_source_size.second), 0.);
+	vec3_set(v2.position, v3.position->x, 0., 0.);
+	vec3_set(v1.position, 0., v3.position->y, 0.);
+	vec3_set(v0.position, 0., 0., 0.);
+
+	float_t cx  = static_cast<float_t>(_filters.center[0].get());
+	float_t cy  = static_cast<float_t>(_filters.center[1].get());
+	float_t hsx = static_cast<float_t>(_filters.size[0].get() / 2.);
+	float_t hsy = static_cast<float_t>(_filters.size[1].get() / 2.);
+	vec4_set(v0.uv[0], cx - hsx, cy - hsy, 0., 0.);
+	vec4_set(v1.uv[0], cx - hsx, cy + hsy, 0., 0.);
+	vec4_set(v2.uv[0], cx + hsx, cy - hsy, 0., 0.);
+	vec4_set(v3.uv[0], cx + hsx, cy + hsy, 0., 0.);
+
+	_geometry->update(true);
+}
+
+void face_crop_instance::on_rename(std::shared_ptr<obs_source_t>, calldata*)
+{
+	obs_source_save(_self);
+}
+
+face_crop_factory::face_crop_factory()
+{
+	_info.id           = S_PREFIX "source-face-crop";
+	_info.type         = OBS_SOURCE_TYPE_INPUT;
+	_info.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_CUSTOM_DRAW;
+
+	set_have_active_child_sources(true);
+	set_have_child_sources(true);
+	finish_setup();
+}
+
+face_crop_factory::~face_crop_factory() {}
+
+const char* face_crop_factory::get_name()
+{
+	return D_TRANSLATE(ST_I18N);
+}
+
+void face_crop_factory::get_defaults2(obs_data_t* data)
+{
+	obs_data_set_default_string(data, ST_KEY_SOURCE, "");
+	obs_data_set_default_int(data, ST_KEY_FACE, 1);
+	obs_data_set_default_double(data, ST_KEY_ZOOM, 50.0);
+	obs_data_set_default_double(data, ST_KEY_OFFSET_X, 0.0);
+	obs_data_set_default_double(data, ST_KEY_OFFSET_Y, -15.0);
+	obs_data_set_default_double(data, ST_KEY_STABILITY, 50.0);
+}
+
+obs_properties_t* face_crop_factory::get_properties2(face_crop_instance* data)
+{
+	obs_properties_t* pr = obs_properties_create();
+	obs_property_t*   p  = nullptr;
+
+	{
+		p = obs_properties_add_list(pr, ST_KEY_SOURCE, D_TRANSLATE(ST_I18N_SOURCE), OBS_COMBO_TYPE_LIST,
+									OBS_COMBO_FORMAT_STRING);
+		obs_property_set_long_description(p, D_TRANSLATE(ST_I18N_SOURCE ".Description"));
+		obs_property_list_add_string(p, "", "");
+		obs::source_tracker::get()->enumerate(
+			[&p](std::string name, obs_source_t*) {
+				std::stringstream sstr;
+				sstr << name << " (" << D_TRANSLATE(S_SOURCETYPE_SOURCE) << ")";
+				obs_property_list_add_string(p, sstr.str().c_str(), name.c_str());
+				return false;
+			},
+			obs::source_tracker::filter_sources);
+	}
+
+	{
+		p = obs_properties_add_int_slider(pr, ST_KEY_FACE, D_TRANSLATE(ST_I18N_FACE), 1, ST_MAX_FACES, 1);
+	}
+
+	{
+		p = obs_properties_add_float_slider(pr, ST_KEY_STABILITY, D_TRANSLATE(ST_I18N_STABILITY), 0, 100.0, 0.01);
+		obs_property_float_set_suffix(p, " %");
+	}
+
+	{
+		p = obs_properties_add_float_slider(pr, ST_KEY_ZOOM, D_TRANSLATE(ST_I18N_ZOOM), 0, 200.0, 0.01);
+		obs_property_float_set_suffix(p, " %");
+	}
+
+	{
+		auto grp = obs_properties_create();
+		obs_properties_add_group(pr, ST_I18N_OFFSET, D_TRANSLATE(ST_I18N_OFFSET), OBS_GROUP_NORMAL, grp);
+
+		p = obs_properties_add_float_slider(grp, ST_KEY_OFFSET_X, D_TRANSLATE(ST_I18N_OFFSET_X), -50.0, 50.0, 0.01);
+		obs_property_float_set_suffix(p, " %");
+		p = obs_properties_add_float_slider(grp, ST_KEY_OFFSET_Y, D_TRANSLATE(ST_I18N_OFFSET_Y), -50.0, 50.0, 0.01);
+		obs_property_float_set_suffix(p, " %");
+	}
+
+	return pr;
+}
+
+std::shared_ptr<face_crop_factory> _source_face_crop_factory_instance;
+
+void streamfx::source::face_crop::face_crop_factory::initialize()
+{
+	if (!_source_face_crop_factory_instance)
+		_source_face_crop_factory_instance = std::make_shared<face_crop_factory>();
+}
+
+void streamfx::source::face_crop::face_crop_factory::finalize()
+{
+	_source_face_crop_factory_instance.reset();
+}
+
+std::shared_ptr<face_crop_factory> streamfx::source::face_crop::face_crop_factory::get()
+{
+	return _source_face_crop_factory_instance;
+}
@@ -0,0 +1,108 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include "gfx/gfx-source-texture.hpp"
+#include "obs/gs/gs-vertexbuffer.hpp"
+#include "obs/obs-signal-handler.hpp"
+#include "obs/obs-source-factory.hpp"
+#include "obs/obs-tools.hpp"
+#include "util/util-tracking.hpp"
+#include "util/utility.hpp"
+
+namespace streamfx::source::face_crop {
+	/** Frames one of the faces that a tracker follows on another source.
+	 *
+	 * The source is rendered through a shared source texture, and the faces come from the tracking channel, so any
+	 * number of crops of the same source only cost one render and one detection per frame.
+	 */
+	class face_crop_instance : public obs::source_instance {
+		// Source
+		std::shared_ptr<obs_source_t>               _source;
+		std::shared_ptr<obs::tools::child_source>   _source_child;
+		std::shared_ptr<obs::source_signal_handler> _signal_rename;
+		std::shared_ptr<gfx::source_texture>        _source_texture;
+		std::pair<uint32_t, uint32_t>               _source_size;
+
+		// Settings
+		std::size_t                   _cfg_index;
+		double_t                      _cfg_zoom;
+		std::pair<double_t, double_t> _cfg_offset;
+		double_t                      _cfg_stability;
+
+		// Tracking
+		::streamfx::util::tracking::subscription _tracking;
+		struct {
+			streamfx::util::math::kalman1D<double_t> center[2];
+			streamfx::util::math::kalman1D<double_t> size[2];
+		} _filters;
+		double_t                                          _center[2]; // Region the filters move towards.
+		double_t                                          _size[2];
+		std::shared_ptr<streamfx::obs::gs::vertex_buffer> _geometry;
+		bool                                              _framed_warning;
+
+		public:
+		face_crop_instance(obs_data_t* settings, obs_source_t* self);
+		virtual ~face_crop_instance();
+
+		virtual uint32_t get_width() override;
+		virtual uint32_t get_height() override;
+
+		virtual void load(obs_data_t*) override;
+		virtual void migrate(obs_data_t*, uint64_t) override;
+		virtual void update(obs_data_t*) override;
+		virtual void save(obs_data_t*) override;
+
+		virtual void video_tick(float_t) override;
+		virtual void video_render(gs_effect_t*) override;
+
+		virtual void enum_active_sources(obs_source_enum_proc_t, void*) override;
+		virtual void enum_all_sources(obs_source_enum_proc_t, void*) override;
+
+		private:
+		void acquire(std::string source_name);
+		void release();
+
+		void refresh_region_of_interest();
+		void refresh_geometry();
+
+		void on_rename(std::shared_ptr<obs_source_t>, calldata*);
+	};
+
+	class face_crop_factory
+		: public obs::source_factory<source::face_crop::face_crop_factory, source::face_crop::face_crop_instance> {
+		public:
+		face_crop_factory();
+		virtual ~face_crop_factory() override;
+
+		virtual const char* get_name() override;
+
+		virtual void get_defaults2(obs_data_t* data) override;
+
+		virtual obs_properties_t* get_properties2(source::face_crop::face_crop_instance* data) override;
+
+		public: // Singleton
+		static void initialize();
+
+		static void finalize();
+
+		static std::shared_ptr<face_crop_factory> get();
+	};
+} // namespace streamfx::source::face_crop
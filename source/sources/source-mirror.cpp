@@ -48,14 +48,23 @@
 #define ST_I18N_SOURCE_AUDIO_LAYOUT ST_I18N_SOURCE_AUDIO ".Layout"
 #define ST_KEY_SOURCE_AUDIO_LAYOUT "Source.Mirror.Audio.Layout"
 #define ST_I18N_SOURCE_AUDIO_LAYOUT_(x) ST_I18N_SOURCE_AUDIO_LAYOUT "." D_VSTR(x)
+#define ST_I18N_SOURCE_CACHE ST_I18N_SOURCE ".Cache"
+#define ST_KEY_SOURCE_CACHE "Source.Mirror.Cache"
+#define ST_I18N_SOURCE_PROXY ST_I18N_SOURCE ".Proxy"
+#define ST_KEY_SOURCE_PROXY "Source.Mirror.Proxy"
+#define ST_I18N_SOURCE_PROXY_(x) ST_I18N_SOURCE_PROXY "." D_VSTR(x)
 
 using namespace streamfx::source::mirror;
 
+// Packets in flight between the audio thread and the worker, about 680ms at 48kHz with 1024 frames per packet.
+#define ST_AUDIO_SLOTS 32
+
 static constexpr std::string_view HELP_URL = "https://github.com/Xaymar/obs-StreamFX/wiki/Source-Mirror";
 
-mirror_audio_data::mirror_audio_data(const audio_data* audio, speaker_layout layout)
+mirror_audio_data::mirror_audio_data() : osa(), data(MAX_AV_PLANES) {}
+
+void mirror_audio_data::assign(const audio_data* audio, speaker_layout layout)
 {
-	// Build a clone of a packet.
 	audio_t*                 oad = obs_get_audio();
 	const audio_output_info* aoi = audio_output_get_info(oad);
 	osa.frames                   = audio->frames;
@@ -63,29 +72,47 @@ mirror_audio_data::mirror_audio_data(const audio_data* audio, speaker_layout lay
 	osa.speakers                 = layout;
 	osa.format                   = aoi->format;
 	osa.samples_per_sec          = aoi->samples_per_sec;
-	data.resize(MAX_AV_PLANES);
 	for (std::size_t idx = 0; idx < MAX_AV_PLANES; idx++) {
 		if (!audio->data[idx]) {
 			osa.data[idx] = nullptr;
 			continue;
 		}
 
-		data[idx].resize(audio->frames * get_audio_bytes_per_channel(osa.format));
-		memcpy(data[idx].data(), audio->data[idx], data[idx].size());
+		std::size_t size = audio->frames * get_audio_bytes_per_channel(osa.format);
+		if (data[idx].size() < size) {
+			data[idx].resize(size);
+		}
+		memcpy(data[idx].data(), audio->data[idx], size);
 		osa.data[idx] = data[idx].data();
 	}
 }
 
 mirror_instance::mirror_instance(obs_data_t* settings, obs_source_t* self)
-	: obs::source_instance(settings, self), _source(), _source_child(), _signal_rename(), _audio_enabled(false),
-	  _audio_layout(SPEAKERS_UNKNOWN)
+	: obs::source_instance(settings, self), _source(), _source_child(), _signal_rename(), _cache_enabled(false),
+	  _cache_divisor(1), _cache_texture(), _audio_enabled(false), _audio_layout(SPEAKERS_UNKNOWN),
+	  _audio_slots(ST_AUDIO_SLOTS), _audio_free(ST_AUDIO_SLOTS), _audio_queued(ST_AUDIO_SLOTS), _audio_worker(),
+	  _audio_stop(false), _audio_lock(), _audio_cv()
 {
+	for (uint32_t idx = 0; idx < ST_AUDIO_SLOTS; idx++) {
+		_audio_free.push(idx);
+	}
+	_audio_worker = std::thread(std::bind(&mirror_instance::audio_output, this));
+
 	update(settings);
 }
 
 mirror_instance::~mirror_instance()
 {
 	release();
+
+	{
+		std::unique_lock<std::mutex> ul(_audio_lock);
+		_audio_stop = true;
+		_audio_cv.notify_all();
+	}
+	if (_audio_worker.joinable()) {
+		_audio_worker.join();
+	}
 }
 
 uint32_t mirror_instance::get_width()
@@ -120,6 +147,10 @@ void mirror_instance::update(obs_data_t* data)
 	_audio_enabled = obs_data_get_bool(data, ST_KEY_SOURCE_AUDIO);
 	_audio_layout  = static_cast<speaker_layout>(obs_data_get_int(data, ST_KEY_SOURCE_AUDIO_LAYOUT));
 
+	// Video
+	_cache_enabled = obs_data_get_bool(data, ST_KEY_SOURCE_CACHE);
+	_cache_divisor = static_cast<uint32_t>(std::clamp<int64_t>(obs_data_get_int(data, ST_KEY_SOURCE_PROXY), 1, 8));
+
 	// Acquire new source.
 	acquire(obs_data_get_string(data, ST_KEY_SOURCE));
 }
@@ -150,7 +181,27 @@ void mirror_instance::video_render(gs_effect_t* effect)
 	_source_size.first  = obs_source_get_width(_source.get());
 	_source_size.second = obs_source_get_height(_source.get());
 
-	obs_source_video_render(_source.get());
+	if (!_cache_texture) {
+		obs_source_video_render(_source.get());
+		return;
+	}
+
+	if (!_source_size.first || !_source_size.second) {
+		return;
+	}
+
+	// Other mirrors of the same source at the same size reuse this texture, so it is only rendered once per frame.
+	auto tex = _cache_texture->render(std::max<uint32_t>(_source_size.first / _cache_divisor, 1),
+									  std::max<uint32_t>(_source_size.second / _cache_divisor, 1));
+	if (!tex) {
+		return;
+	}
+
+	gs_effect_t* default_effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+	gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"), tex->get_object());
+	while (gs_effect_loop(default_effect, "Draw")) {
+		gs_draw_sprite(tex->get_object(), 0, _source_size.first, _source_size.second);
+	}
 }
 
 void mirror_instance::enum_active_sources(obs_source_enum_proc_t cb, void* ptr)
@@ -184,6 +235,9 @@ try {
 	_source             = source;
 	_source_size.first  = obs_source_get_width(_source.get());
 	_source_size.second = obs_source_get_height(_source.get());
+	if (_cache_enabled || (_cache_divisor > 1)) {
+		_cache_texture = std::make_shared<gfx::source_texture>(_source.get(), _self);
+	}
 
 	// Listen to the rename event to update our own settings.
 	_signal_rename = std::make_shared<obs::source_signal_handler>("rename", _source);
@@ -204,6 +258,7 @@ void mirror_instance::release()
 {
 	_signal_audio.reset();
 	_signal_rename.reset();
+	_cache_texture.reset();
 	_source_child.reset();
 	_source.reset();
 }
@@ -257,21 +312,32 @@ void mirror_instance::on_audio(std::shared_ptr<obs_source_t>, const audio_data*
 		}
 	}
 
-	{
-		std::unique_lock<std::mutex> ul(_audio_queue_lock);
-		_audio_queue.emplace(audio, detected_layout);
+	// Copy the packet into a free slot. If the worker fell so far behind that none is left, the packet is dropped
+	// instead of stalling the audio thread of the mirrored source.
+	uint32_t slot;
+	if (!_audio_free.pop(slot)) {
+		return;
 	}
+	_audio_slots[slot].assign(audio, detected_layout);
+	_audio_queued.push(slot);
 
-	// Create a clone of the audio data and push it to the thread pool.
-	streamfx::threadpool()->push(std::bind(&mirror_instance::audio_output, this, std::placeholders::_1), nullptr);
+	// The lock only orders the wake-up against the worker going to sleep.
+	std::unique_lock<std::mutex> ul(_audio_lock);
+	_audio_cv.notify_one();
 }
 
-void mirror_instance::audio_output(std::shared_ptr<void> data)
+void mirror_instance::audio_output()
 {
-	std::unique_lock<std::mutex> ul(_audio_queue_lock);
-	while (_audio_queue.size() > 0) {
-		obs_source_output_audio(_self, &((_audio_queue.front()).osa));
-		_audio_queue.pop();
+	// Output happens here instead of inside the audio callback of the mirrored source, which must return quickly.
+	while (!_audio_stop) {
+		uint32_t slot;
+		while (_audio_queued.pop(slot)) {
+			obs_source_output_audio(_self, &_audio_slots[slot].osa);
+			_audio_free.push(slot);
+		}
+
+		std::unique_lock<std::mutex> ul(_audio_lock);
+		_audio_cv.wait(ul, [this]() { return _audio_stop || !_audio_queued.empty(); });
 	}
 }
 
@@ -299,6 +365,8 @@ void mirror_factory::get_defaults2(obs_data_t* data)
 	obs_data_set_default_string(data, ST_KEY_SOURCE, "");
 	obs_data_set_default_bool(data, ST_KEY_SOURCE_AUDIO, false);
 	obs_data_set_default_int(data, ST_KEY_SOURCE_AUDIO_LAYOUT, static_cast<int64_t>(SPEAKERS_UNKNOWN));
+	obs_data_set_default_bool(data, ST_KEY_SOURCE_CACHE, false);
+	obs_data_set_default_int(data, ST_KEY_SOURCE_PROXY, 1);
 }
 
 static bool modified_properties(obs_properties_t* pr, obs_property_t* p, obs_data_t* data) noexcept
@@ -349,6 +417,19 @@ obs_properties_t* mirror_factory::get_properties2(mirror_instance* data)
 			obs::source_tracker::filter_scenes);
 	}
 
+	{
+		p = obs_properties_add_bool(pr, ST_KEY_SOURCE_CACHE, D_TRANSLATE(ST_I18N_SOURCE_CACHE));
+	}
+
+	{
+		p = obs_properties_add_list(pr, ST_KEY_SOURCE_PROXY, D_TRANSLATE(ST_I18N_SOURCE_PROXY), OBS_COMBO_TYPE_LIST,
+									OBS_COMBO_FORMAT_INT);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_SOURCE_PROXY_(Full)), 1);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_SOURCE_PROXY_(Half)), 2);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_SOURCE_PROXY_(Quarter)), 4);
+		obs_property_list_add_int(p, D_TRANSLATE(ST_I18N_SOURCE_PROXY_(Eighth)), 8);
+	}
+
 	{
 		p = obs_properties_add_bool(pr, ST_KEY_SOURCE_AUDIO, D_TRANSLATE(ST_I18N_SOURCE_AUDIO));
 		obs_property_set_modified_callback(p, modified_properties);
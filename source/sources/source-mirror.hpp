@@ -19,9 +19,9 @@
 
 #pragma once
 #include "common.hpp"
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <vector>
 #include "gfx/gfx-source-texture.hpp"
@@ -31,10 +31,14 @@
 #include "obs/obs-source-factory.hpp"
 #include "obs/obs-source.hpp"
 #include "obs/obs-tools.hpp"
+#include "util/util-ringbuffer.hpp"
 
 namespace streamfx::source::mirror {
 	struct mirror_audio_data {
-		mirror_audio_data(const audio_data*, speaker_layout);
+		mirror_audio_data();
+
+		// Copy a packet into this slot, only allocating if it is larger than anything seen before.
+		void assign(const audio_data*, speaker_layout);
 
 		obs_source_audio                  osa;
 		std::vector<std::vector<uint8_t>> data;
@@ -48,11 +52,21 @@ namespace streamfx::source::mirror {
 		std::shared_ptr<obs::audio_signal_handler>  _signal_audio;
 		std::pair<uint32_t, uint32_t>               _source_size;
 
+		// Shared Rendering
+		bool                                 _cache_enabled;
+		uint32_t                             _cache_divisor; // Renders at 1/N of the source size, then stretches.
+		std::shared_ptr<gfx::source_texture> _cache_texture; // Shares one render per frame with all other users.
+
 		// Audio
-		bool                          _audio_enabled;
-		speaker_layout                _audio_layout;
-		std::mutex                    _audio_queue_lock;
-		std::queue<mirror_audio_data> _audio_queue;
+		bool                                 _audio_enabled;
+		speaker_layout                       _audio_layout;
+		std::vector<mirror_audio_data>       _audio_slots;
+		streamfx::util::ringbuffer<uint32_t> _audio_free;   // Slots that on_audio may fill.
+		streamfx::util::ringbuffer<uint32_t> _audio_queued; // Slots that the worker has yet to output.
+		std::thread                          _audio_worker;
+		std::atomic_bool                     _audio_stop;
+		std::mutex                           _audio_lock;
+		std::condition_variable              _audio_cv;
 
 		public:
 		mirror_instance(obs_data_t* settings, obs_source_t* self);
@@ -79,7 +93,7 @@ namespace streamfx::source::mirror {
 		void on_rename(std::shared_ptr<obs_source_t>, calldata*);
 		void on_audio(std::shared_ptr<obs_source_t>, const struct audio_data*, bool);
 
-		void audio_output(std::shared_ptr<void> data);
+		void audio_output();
 	};
 
 	class mirror_factory : public obs::source_factory<source::mirror::mirror_factory, source::mirror::mirror_instance> {
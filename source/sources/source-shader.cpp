@@ -32,8 +32,10 @@ static constexpr std::string_view HELP_URL =
 shader_instance::shader_instance(obs_data_t* data, obs_source_t* self) : obs::source_instance(data, self), _fx()
 {
 	_fx = std::make_shared<::streamfx::gfx::shader::shader>(self, ::streamfx::gfx::shader::shader_mode::Source);
+	_fx->set_visible(obs_source_showing(self));
 
 	update(data);
+	enable_update_coalescing(0.1f);
 }
 
 shader_instance::~shader_instance() {}
@@ -101,6 +103,16 @@ void streamfx::source::shader::shader_instance::deactivate()
 	_fx->set_active(false);
 }
 
+void streamfx::source::shader::shader_instance::show()
+{
+	_fx->set_visible(true);
+}
+
+void streamfx::source::shader::shader_instance::hide()
+{
+	_fx->set_visible(false);
+}
+
 shader_factory::shader_factory()
 {
 	_info.id           = S_PREFIX "source-shader";
@@ -108,6 +120,7 @@ shader_factory::shader_factory()
 	_info.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_CUSTOM_DRAW;
 
 	set_activity_tracking_enabled(true);
+	set_visibility_tracking_enabled(true);
 	finish_setup();
 	register_proxy("obs-stream-effects-source-shader");
 }
@@ -45,6 +45,9 @@ namespace streamfx::source::shader {
 
 		void activate() override;
 		void deactivate() override;
+
+		void show() override;
+		void hide() override;
 	};
 
 	class shader_factory : public obs::source_factory<source::shader::shader_factory, source::shader::shader_instance> {
@@ -32,6 +32,7 @@
 #define S_FILEFILTERS_VIDEO "*.mkv *.webm *.mp4 *.mov *.flv"
 #define S_FILEFILTERS_SOUND "*.ogg *.flac *.mp3 *.wav"
 #define S_FILEFILTERS_EFFECT "*.effect *.txt"
+#define S_FILEFILTERS_LUT "*.cube *.3dl"
 #define S_FILEFILTERS_ANY "*.*"
 
 #define S_VERSION "Version"
@@ -39,6 +40,14 @@
 
 #define S_ADVANCED "Advanced"
 
+#define S_RENDERRATE "RenderRate"
+#define S_RENDERRATE_MODE "RenderRate.Mode"
+#define S_RENDERRATE_MODE_EVERYFRAME "RenderRate.Mode.EveryFrame"
+#define S_RENDERRATE_MODE_FRAMES "RenderRate.Mode.Frames"
+#define S_RENDERRATE_MODE_RATE "RenderRate.Mode.Rate"
+#define S_RENDERRATE_FRAMES "RenderRate.Frames"
+#define S_RENDERRATE_RATE "RenderRate.Rate"
+
 #define S_STATE_DEFAULT "State.Default"
 #define S_STATE_DISABLED "State.Disabled"
 #define S_STATE_ENABLED "State.Enabled"
@@ -53,6 +62,7 @@
 #define S_FILETYPE_SOUNDS "FileType.Sounds"
 #define S_FILETYPE_EFFECT "FileType.Effect"
 #define S_FILETYPE_EFFECTS "FileType.Effects"
+#define S_FILETYPE_LUTS "FileType.LUTs"
 
 #define S_SOURCETYPE_SOURCE "SourceType.Source"
 #define S_SOURCETYPE_SCENE "SourceType.Scene"
@@ -68,6 +78,9 @@
 #define S_BLUR_TYPE_GAUSSIAN "Blur.Type.Gaussian"
 #define S_BLUR_TYPE_GAUSSIAN_LINEAR "Blur.Type.GaussianLinear"
 #define S_BLUR_TYPE_DUALFILTERING "Blur.Type.DualFiltering"
+#define S_BLUR_TYPE_MIPMAP "Blur.Type.Mipmap"
+#define S_BLUR_TYPE_SUMMEDAREA "Blur.Type.SummedArea"
+#define S_BLUR_TYPE_AUTOMATIC "Blur.Type.Automatic"
 
 #define S_BLUR_SUBTYPE_AREA "Blur.Subtype.Area"
 #define S_BLUR_SUBTYPE_DIRECTIONAL "Blur.Subtype.Directional"
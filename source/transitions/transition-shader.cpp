@@ -21,19 +21,24 @@
 #include "strings.hpp"
 #include <stdexcept>
 #include "obs/gs/gs-helper.hpp"
+#include "obs/gs/gs-texture.hpp"
 
 #define ST_I18N "Transition.Shader"
+#define ST_I18N_INPUTSCALE ST_I18N ".InputScale"
+#define ST_KEY_INPUTSCALE "Transition.Shader.InputScale"
 
 using namespace streamfx::transition::shader;
 
 static constexpr std::string_view HELP_URL =
 	"https://github.com/Xaymar/obs-StreamFX/wiki/Source-Filter-Transition-Shader";
 
-shader_instance::shader_instance(obs_data_t* data, obs_source_t* self) : obs::source_instance(data, self)
+shader_instance::shader_instance(obs_data_t* data, obs_source_t* self)
+	: obs::source_instance(data, self), _fx(), _input_scale(1.0f), _input_a(), _input_b(), _warmed_up(false)
 {
 	_fx = std::make_shared<streamfx::gfx::shader::shader>(self, streamfx::gfx::shader::shader_mode::Transition);
 
 	update(data);
+	enable_update_coalescing(0.1f);
 }
 
 shader_instance::~shader_instance() {}
@@ -56,10 +61,15 @@ void shader_instance::properties(obs_properties_t* props)
 void shader_instance::load(obs_data_t* data)
 {
 	update(data);
+
+	// Loaded along with a scene collection, so warm up again once the shader is ready.
+	_warmed_up = false;
 }
 
 void shader_instance::update(obs_data_t* data)
 {
+	_input_scale = static_cast<float_t>(std::clamp(obs_data_get_double(data, ST_KEY_INPUTSCALE) / 100.0, 0.25, 1.0));
+
 	_fx->update(data);
 }
 
@@ -75,6 +85,11 @@ void shader_instance::video_tick(float_t sec_since_last)
 	obs_video_info ovi;
 	obs_get_video_info(&ovi);
 	_fx->set_size(ovi.base_width, ovi.base_height);
+
+	// The first transition otherwise pays for compiling and allocating everything, which hitches visibly.
+	if (!_warmed_up && _fx->is_loaded()) {
+		warm_up(ovi.base_width, ovi.base_height);
+	}
 }
 
 void shader_instance::video_render(gs_effect_t* effect)
@@ -96,14 +111,81 @@ void shader_instance::video_render(gs_effect_t* effect)
 
 void shader_instance::transition_render(gs_texture_t* a, gs_texture_t* b, float_t t, uint32_t cx, uint32_t cy)
 {
-	_fx->set_input_a(std::make_shared<::streamfx::obs::gs::texture>(a, false));
-	_fx->set_input_b(std::make_shared<::streamfx::obs::gs::texture>(b, false));
+	if (_input_scale < 1.0f) {
+		_fx->set_input_a(downscale_input(_input_a, a, cx, cy));
+		_fx->set_input_b(downscale_input(_input_b, b, cx, cy));
+	} else {
+		_fx->set_input_a(std::make_shared<::streamfx::obs::gs::texture>(a, false));
+		_fx->set_input_b(std::make_shared<::streamfx::obs::gs::texture>(b, false));
+	}
 	_fx->set_transition_time(t);
 	_fx->set_transition_size(cx, cy);
+
+	// Both scenes keep changing while the transition runs, so even a static shader has to render every frame.
+	_fx->invalidate();
 	_fx->prepare_render();
 	_fx->render(nullptr);
 }
 
+std::shared_ptr<streamfx::obs::gs::texture>
+	shader_instance::downscale_input(std::shared_ptr<streamfx::obs::gs::rendertarget>& target, gs_texture_t* input,
+									 uint32_t cx, uint32_t cy)
+{
+	if (!target) {
+		target = std::make_shared<streamfx::obs::gs::rendertarget>(GS_RGBA, GS_ZS_NONE);
+	}
+
+	// Shaders that sample their inputs many times per pixel mostly pay for memory bandwidth, which a smaller input
+	// reduces a lot. The shader itself still renders at full size.
+	uint32_t width  = std::max<uint32_t>(static_cast<uint32_t>(cx * _input_scale), 1);
+	uint32_t height = std::max<uint32_t>(static_cast<uint32_t>(cy * _input_scale), 1);
+	{
+		auto op = target->render(width, height);
+		gs_ortho(0, 1, 0, 1, 0, 1);
+
+		gs_blend_state_push();
+		gs_reset_blend_state();
+		gs_enable_blending(false);
+
+		gs_effect_t* effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+		gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), input);
+		while (gs_effect_loop(effect, "Draw")) {
+			gs_draw_sprite(input, 0, 1, 1);
+		}
+
+		gs_blend_state_pop();
+	}
+
+	return target->get_texture();
+}
+
+void shader_instance::warm_up(uint32_t cx, uint32_t cy)
+try {
+	_warmed_up = true;
+
+	auto gctx = streamfx::obs::gs::context();
+
+#ifdef ENABLE_PROFILING
+	streamfx::obs::gs::debug_marker gdmp{streamfx::obs::gs::debug_color_source, "Shader Transition '%s' Warm-Up",
+										 obs_source_get_name(_self)};
+#endif
+
+	// A single transparent texel stands in for both scenes, and the result goes into a target nobody sees.
+	uint8_t        texel[4] = {0, 0, 0, 0};
+	const uint8_t* mip_data = texel;
+
+	auto input = std::make_shared<streamfx::obs::gs::texture>(1, 1, GS_RGBA, 1, &mip_data,
+															   streamfx::obs::gs::texture::flags::None);
+	streamfx::obs::gs::rendertarget output(GS_RGBA, GS_ZS_NONE);
+	{
+		auto op = output.render(1, 1);
+		gs_ortho(0, 1, 0, 1, 0, 1);
+		transition_render(input->get_object(), input->get_object(), 0.0f, cx, cy);
+	}
+} catch (const std::exception& ex) {
+	DLOG_WARNING("Warming up shader transition '%s' failed: %s", obs_source_get_name(_self), ex.what());
+}
+
 bool shader_instance::audio_render(uint64_t* ts_out, obs_source_audio_mix* audio_output, uint32_t mixers,
 								   std::size_t channels, std::size_t sample_rate)
 {
@@ -143,6 +225,7 @@ const char* shader_factory::get_name()
 void shader_factory::get_defaults2(obs_data_t* data)
 {
 	streamfx::gfx::shader::shader::defaults(data);
+	obs_data_set_default_double(data, ST_KEY_INPUTSCALE, 100.0);
 }
 
 obs_properties_t* shader_factory::get_properties2(shader::shader_instance* data)
@@ -161,6 +244,12 @@ obs_properties_t* shader_factory::get_properties2(shader::shader_instance* data)
 		reinterpret_cast<shader_instance*>(data)->properties(pr);
 	}
 
+	{
+		auto p = obs_properties_add_float_slider(pr, ST_KEY_INPUTSCALE, D_TRANSLATE(ST_I18N_INPUTSCALE), 25.0, 100.0,
+												 1.0);
+		obs_property_float_set_suffix(p, " %");
+	}
+
 	return pr;
 }
 
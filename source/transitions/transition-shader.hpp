@@ -28,6 +28,14 @@ namespace streamfx::transition::shader {
 	class shader_instance : public obs::source_instance {
 		std::shared_ptr<streamfx::gfx::shader::shader> _fx;
 
+		// Inputs, optionally downscaled before the shader samples them.
+		float_t                                          _input_scale;
+		std::shared_ptr<streamfx::obs::gs::rendertarget> _input_a;
+		std::shared_ptr<streamfx::obs::gs::rendertarget> _input_b;
+
+		// Whether the current shader already rendered once ahead of the first transition.
+		bool _warmed_up;
+
 		public:
 		shader_instance(obs_data_t* data, obs_source_t* self);
 		virtual ~shader_instance();
@@ -45,6 +53,15 @@ namespace streamfx::transition::shader {
 
 		void transition_render(gs_texture_t* a, gs_texture_t* b, float_t t, uint32_t cx, uint32_t cy);
 
+		private:
+		std::shared_ptr<streamfx::obs::gs::texture>
+			downscale_input(std::shared_ptr<streamfx::obs::gs::rendertarget>& target, gs_texture_t* input, uint32_t cx,
+							uint32_t cy);
+
+		void warm_up(uint32_t cx, uint32_t cy);
+
+		public:
+
 		virtual bool audio_render(uint64_t* ts_out, struct obs_source_audio_mix* audio_output, uint32_t mixers,
 								  std::size_t channels, std::size_t sample_rate) override;
 
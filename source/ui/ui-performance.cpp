@@ -0,0 +1,299 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "ui-performance.hpp"
+#include <cmath>
+#include "plugin.hpp"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4251 4365 4371 4619 4946)
+#endif
+#include <QHeaderView>
+#include <QStringList>
+#include <QVBoxLayout>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#define D_I18N_TITLE "UI.Performance"
+#define D_I18N_COLUMN_NAME "UI.Performance.Name"
+#define D_I18N_COLUMN_TYPE "UI.Performance.Type"
+#define D_I18N_COLUMN_CPU_AVERAGE "UI.Performance.CPU.Average"
+#define D_I18N_COLUMN_CPU_P99 "UI.Performance.CPU.P99"
+#define D_I18N_COLUMN_GPU_AVERAGE "UI.Performance.GPU.Average"
+#define D_I18N_COLUMN_GPU_P99 "UI.Performance.GPU.P99"
+#define D_I18N_COLUMN_VIDEO_MEMORY "UI.Performance.VideoMemory"
+#define D_I18N_COLUMN_CACHE "UI.Performance.Cache"
+#define D_I18N_COLUMN_LOAD "UI.Performance.Load"
+#define D_I18N_TYPE_SOURCE "UI.Performance.Type.Source"
+#define D_I18N_TYPE_FILTER "UI.Performance.Type.Filter"
+#define D_I18N_TYPE_TRANSITION "UI.Performance.Type.Transition"
+#define D_I18N_TYPE_ENCODER "UI.Performance.Type.Encoder"
+#define D_I18N_DISABLE "UI.Performance.Disable"
+#define D_I18N_ENABLE "UI.Performance.Enable"
+
+constexpr int refresh_interval = 1000; // ms
+
+enum column : int {
+	COLUMN_NAME,
+	COLUMN_TYPE,
+	COLUMN_CPU_AVERAGE,
+	COLUMN_CPU_P99,
+	COLUMN_GPU_AVERAGE,
+	COLUMN_GPU_P99,
+	COLUMN_VIDEO_MEMORY,
+	COLUMN_CACHE,
+	COLUMN_LOAD,
+	_COLUMN_COUNT,
+};
+
+// Stores the index into _rows, which survives sorting.
+constexpr int row_role = Qt::UserRole;
+
+static const char* type_name(streamfx::obs::statistics::kind kind)
+{
+	switch (kind) {
+	case streamfx::obs::statistics::kind::Source:
+		return D_TRANSLATE(D_I18N_TYPE_SOURCE);
+	case streamfx::obs::statistics::kind::Filter:
+		return D_TRANSLATE(D_I18N_TYPE_FILTER);
+	case streamfx::obs::statistics::kind::Transition:
+		return D_TRANSLATE(D_I18N_TYPE_TRANSITION);
+	case streamfx::obs::statistics::kind::Encoder:
+		return D_TRANSLATE(D_I18N_TYPE_ENCODER);
+	}
+	return "";
+}
+
+static QTableWidgetItem* make_number(double_t value, bool valid = true)
+{
+	auto item = new QTableWidgetItem();
+	if (valid) {
+		// Storing the number instead of text keeps sorting numeric.
+		item->setData(Qt::DisplayRole, std::round(value * 100.) / 100.);
+	}
+	item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+	return item;
+}
+
+static QTableWidgetItem* make_duration(std::shared_ptr<streamfx::util::profiler> profiler, bool p99)
+{
+	if (!profiler || (profiler->count() == 0))
+		return make_number(0., false);
+
+	double_t ns = p99 ? static_cast<double_t>(profiler->percentile(0.99).count()) : profiler->average_duration();
+	return make_number(ns / 1000000.);
+}
+
+static QString make_callback_summary(const std::shared_ptr<streamfx::obs::statistics>& value)
+{
+	QStringList lines;
+	for (std::size_t idx = 0; idx < streamfx::obs::statistics::callback_count; idx++) {
+		auto type     = static_cast<streamfx::obs::statistics::callback>(idx);
+		auto profiler = value->cpu(type);
+		if (!profiler || (profiler->count() == 0))
+			continue;
+
+		lines.append(QString("%1: %2 ms, p99 %3 ms, %4 calls")
+						 .arg(QString::fromUtf8(streamfx::obs::statistics::callback_name(type)))
+						 .arg(profiler->average_duration() / 1000000., 0, 'f', 3)
+						 .arg(static_cast<double_t>(profiler->percentile(0.99).count()) / 1000000., 0, 'f', 3)
+						 .arg(static_cast<qulonglong>(profiler->count())));
+	}
+	return lines.join('\n');
+}
+
+static QString make_load_summary(const std::shared_ptr<streamfx::obs::statistics>& value)
+{
+	QStringList lines;
+	for (std::size_t idx = 0; idx < streamfx::obs::statistics::load_step_count; idx++) {
+		auto type = static_cast<streamfx::obs::statistics::load_step>(idx);
+		auto time = value->load_time(type);
+		if (time.count() == 0)
+			continue;
+
+		lines.append(QString("%1: %2 ms")
+						 .arg(QString::fromUtf8(streamfx::obs::statistics::load_step_name(type)))
+						 .arg(static_cast<double_t>(time.count()) / 1000000., 0, 'f', 3));
+	}
+	return lines.join('\n');
+}
+
+streamfx::ui::performance::performance(QWidget* parent)
+	: QDockWidget(parent), _table(), _toggle(), _timer(), _rows()
+{
+	setObjectName("StreamFXPerformance");
+	setWindowTitle(QString::fromUtf8(D_TRANSLATE(D_I18N_TITLE)));
+	setFeatures(QDockWidget::DockWidgetClosable | QDockWidget::DockWidgetMovable | QDockWidget::DockWidgetFloatable);
+	setFloating(true);
+	hide();
+
+	auto widget = new QWidget(this);
+	auto layout = new QVBoxLayout(widget);
+	layout->setContentsMargins(0, 0, 0, 0);
+
+	_table = new QTableWidget(0, _COLUMN_COUNT, widget);
+	_table->setHorizontalHeaderLabels({
+		QString::fromUtf8(D_TRANSLATE(D_I18N_COLUMN_NAME)),
+		QString::fromUtf8(D_TRANSLATE(D_I18N_COLUMN_TYPE)),
+		QString::fromUtf8(D_TRANSLATE(D_I18N_COLUMN_CPU_AVERAGE)),
+		QString::fromUtf8(D_TRANSLATE(D_I18N_COLUMN_CPU_P99)),
+		QString::fromUtf8(D_TRANSLATE(D_I18N_COLUMN_GPU_AVERAGE)),
+		QString::fromUtf8(D_TRANSLATE(D_I18N_COLUMN_GPU_P99)),
+		QString::fromUtf8(D_TRANSLATE(D_I18N_COLUMN_VIDEO_MEMORY)),
+		QString::fromUtf8(D_TRANSLATE(D_I18N_COLUMN_CACHE)),
+		QString::fromUtf8(D_TRANSLATE(D_I18N_COLUMN_LOAD)),
+	});
+	_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+	_table->setSelectionMode(QAbstractItemView::SingleSelection);
+	_table->verticalHeader()->setVisible(false);
+	_table->horizontalHeader()->setSectionResizeMode(COLUMN_NAME, QHeaderView::Stretch);
+	_table->setSortingEnabled(true);
+	_table->sortByColumn(COLUMN_CPU_AVERAGE, Qt::DescendingOrder);
+	layout->addWidget(_table);
+
+	_toggle = new QPushButton(QString::fromUtf8(D_TRANSLATE(D_I18N_DISABLE)), widget);
+	_toggle->setEnabled(false);
+	layout->addWidget(_toggle);
+
+	setWidget(widget);
+
+	_timer = new QTimer(this);
+	_timer->setInterval(refresh_interval);
+
+	connect(_timer, &QTimer::timeout, this, &streamfx::ui::performance::on_refresh);
+	connect(_table, &QTableWidget::itemSelectionChanged, this, &streamfx::ui::performance::on_selection_changed);
+	connect(_toggle, &QPushButton::clicked, this, &streamfx::ui::performance::on_toggle);
+	connect(this, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+		if (visible) {
+			on_refresh();
+			_timer->start();
+		} else {
+			_timer->stop();
+		}
+	});
+}
+
+streamfx::ui::performance::~performance() {}
+
+void streamfx::ui::performance::clear()
+{
+	_timer->stop();
+	_table->setRowCount(0);
+	_rows.clear();
+}
+
+std::shared_ptr<streamfx::obs::statistics> streamfx::ui::performance::selected()
+{
+	auto items = _table->selectedItems();
+	if (items.empty())
+		return nullptr;
+
+	std::size_t row = items.front()->data(row_role).toULongLong();
+	return (row < _rows.size()) ? _rows[row].lock() : nullptr;
+}
+
+void streamfx::ui::performance::on_refresh()
+{
+	auto previous = selected();
+
+	std::vector<std::shared_ptr<streamfx::obs::statistics>> values;
+	streamfx::obs::statistics::enumerate(
+		[&values](std::shared_ptr<streamfx::obs::statistics> value) { values.push_back(value); });
+
+	// Sorting while filling would move rows around underneath us.
+	_table->setSortingEnabled(false);
+	_table->setRowCount(static_cast<int>(values.size()));
+	_rows.assign(values.begin(), values.end());
+
+	int select = -1;
+	for (std::size_t idx = 0; idx < values.size(); idx++) {
+		auto& value = values[idx];
+		int   row   = static_cast<int>(idx);
+
+		auto name = new QTableWidgetItem(QString::fromUtf8(value->name().c_str()));
+		name->setData(row_role, static_cast<qulonglong>(idx));
+		_table->setItem(row, COLUMN_NAME, name);
+		_table->setItem(row, COLUMN_TYPE, new QTableWidgetItem(QString::fromUtf8(type_name(value->get_kind()))));
+
+		auto cpu_average = make_duration(value->cpu(), false);
+		cpu_average->setToolTip(make_callback_summary(value));
+		_table->setItem(row, COLUMN_CPU_AVERAGE, cpu_average);
+		_table->setItem(row, COLUMN_CPU_P99, make_duration(value->cpu(), true));
+		auto gpu = value->gpu();
+		_table->setItem(row, COLUMN_GPU_AVERAGE, make_duration(gpu ? gpu->profiler() : nullptr, false));
+		_table->setItem(row, COLUMN_GPU_P99, make_duration(gpu ? gpu->profiler() : nullptr, true));
+
+		uint64_t memory = value->video_memory();
+		_table->setItem(row, COLUMN_VIDEO_MEMORY, make_number(static_cast<double_t>(memory) / 1048576., memory > 0));
+		_table->setItem(row, COLUMN_CACHE, make_number(value->cache_hit_rate() * 100., value->cache_lookups() > 0));
+
+		auto load_time = value->load_time();
+		auto load      = make_number(static_cast<double_t>(load_time.count()) / 1000000., load_time.count() > 0);
+		load->setToolTip(make_load_summary(value));
+		_table->setItem(row, COLUMN_LOAD, load);
+
+		if (value == previous)
+			select = row;
+	}
+
+	_table->setSortingEnabled(true);
+
+	if (select >= 0) {
+		// The row moved while sorting, so look it up by the stored index.
+		for (int row = 0; row < _table->rowCount(); row++) {
+			if (_table->item(row, COLUMN_NAME)->data(row_role).toInt() == select) {
+				_table->selectRow(row);
+				break;
+			}
+		}
+	}
+	on_selection_changed();
+}
+
+void streamfx::ui::performance::on_selection_changed()
+{
+	auto value = selected();
+	if (!value || (value->get_kind() != streamfx::obs::statistics::kind::Filter)) {
+		_toggle->setEnabled(false);
+		return;
+	}
+
+	if (obs_source_t* source = value->source(); source) {
+		_toggle->setEnabled(true);
+		const char* text = obs_source_enabled(source) ? D_I18N_DISABLE : D_I18N_ENABLE;
+		_toggle->setText(QString::fromUtf8(D_TRANSLATE(text)));
+		obs_source_release(source);
+	} else {
+		_toggle->setEnabled(false);
+	}
+}
+
+void streamfx::ui::performance::on_toggle(bool)
+{
+	if (auto value = selected(); value) {
+		if (obs_source_t* source = value->source(); source) {
+			obs_source_set_enabled(source, !obs_source_enabled(source));
+			obs_source_release(source);
+		}
+	}
+	on_selection_changed();
+}
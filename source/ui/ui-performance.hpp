@@ -0,0 +1,74 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <memory>
+#include <vector>
+#include "obs/obs-statistics.hpp"
+#include "ui-common.hpp"
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4251 4365 4371 4619 4946)
+#endif
+#include <QDockWidget>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+namespace streamfx::ui {
+	/** Dock listing the cost of every live StreamFX source, filter, transition and encoder.
+	 *
+	 * The table is rebuilt from obs::statistics once a second while the dock is visible, and can be sorted by any
+	 * column, so that the most expensive instance can be found and switched off while live. The time it took to load
+	 * an instance with the scene collection is listed as well.
+	 */
+	class performance : public QDockWidget {
+		Q_OBJECT
+
+		private:
+		QTableWidget* _table;
+		QPushButton*  _toggle;
+		QTimer*       _timer;
+
+		std::vector<std::weak_ptr<streamfx::obs::statistics>> _rows;
+
+		public:
+		performance(QWidget* parent = nullptr);
+		~performance();
+
+		/** Forget about all instances, called before OBS Studio shuts down.
+		 */
+		void clear();
+
+		private:
+		std::shared_ptr<streamfx::obs::statistics> selected();
+
+		private slots:
+		; // Needed by some linters.
+
+		void on_refresh();
+		void on_selection_changed();
+		void on_toggle(bool);
+	};
+} // namespace streamfx::ui
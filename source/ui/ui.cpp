@@ -20,10 +20,15 @@
 #include "ui.hpp"
 #include "common.hpp"
 #include "strings.hpp"
+#include <ctime>
 #include <string_view>
 #include "configuration.hpp"
+#include "obs/obs-governor.hpp"
+#include "obs/obs-prewarm.hpp"
+#include "obs/obs-statistics.hpp"
 #include "obs/obs-tools.hpp"
 #include "plugin.hpp"
+#include "util/util-trace.hpp"
 
 #include <obs-frontend-api.h>
 
@@ -36,9 +41,18 @@ constexpr std::string_view _i18n_menu_website      = "UI.Menu.Website";
 constexpr std::string_view _i18n_menu_discord      = "UI.Menu.Discord";
 constexpr std::string_view _i18n_menu_github       = "UI.Menu.Github";
 constexpr std::string_view _i18n_menu_about        = "UI.Menu.About";
+constexpr std::string_view _i18n_menu_governor     = "UI.Menu.Governor";
+constexpr std::string_view _i18n_menu_preview      = "UI.Menu.Preview";
+constexpr std::string_view _i18n_menu_prewarm      = "UI.Menu.Prewarm";
+constexpr std::string_view _i18n_menu_trace        = "UI.Menu.Trace";
+constexpr std::string_view _i18n_hotkey_trace      = "UI.Hotkey.Trace";
 
 // Configuration
 constexpr std::string_view _cfg_have_shown_about = "UI.HaveShownAboutStreamFX";
+constexpr std::string_view _cfg_trace_hotkey     = "StreamFX.Trace.Hotkey";
+
+// Trace Capture
+constexpr std::chrono::seconds _trace_length{10};
 
 // URLs
 constexpr std::string_view _url_report_issue = "https://github.com/Xaymar/obs-StreamFX/issues/new?template=issue.md";
@@ -80,6 +94,10 @@ streamfx::ui::handler::handler()
 
 	  _about_action(), _about_dialog(),
 
+	  _performance(), _governor(), _preview(), _prewarm(),
+
+	  _trace(), _trace_hotkey(OBS_INVALID_HOTKEY_ID),
+
 	  _translator()
 #ifdef ENABLE_UPDATER
 	  ,
@@ -87,10 +105,18 @@ streamfx::ui::handler::handler()
 #endif
 {
 	obs_frontend_add_event_callback(frontend_event_handler, this);
+
+	_trace_hotkey = obs_hotkey_register_frontend("streamfx.trace", D_TRANSLATE(_i18n_hotkey_trace.data()),
+												 hotkey_trace, this);
+	obs_frontend_add_save_callback(frontend_save_handler, this);
 }
 
 streamfx::ui::handler::~handler()
 {
+	obs_frontend_remove_save_callback(frontend_save_handler, this);
+	if (_trace_hotkey != OBS_INVALID_HOTKEY_ID)
+		obs_hotkey_unregister(_trace_hotkey);
+
 	obs_frontend_remove_event_callback(frontend_event_handler, this);
 }
 
@@ -100,6 +126,16 @@ void streamfx::ui::handler::frontend_event_handler(obs_frontend_event event, voi
 	switch (event) {
 	case OBS_FRONTEND_EVENT_FINISHED_LOADING:
 		ptr->on_obs_loaded();
+		ptr->on_collection_loaded();
+		break;
+	case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CLEANUP:
+		streamfx::obs::statistics::set_loading(true);
+		break;
+	case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED:
+		ptr->on_collection_loaded();
+		break;
+	case OBS_FRONTEND_EVENT_PREVIEW_SCENE_CHANGED:
+		ptr->on_preview_scene_changed();
 		break;
 	case OBS_FRONTEND_EVENT_EXIT:
 		ptr->on_obs_exit();
@@ -109,6 +145,54 @@ void streamfx::ui::handler::frontend_event_handler(obs_frontend_event event, voi
 	}
 }
 
+void streamfx::ui::handler::frontend_save_handler(obs_data_t* save_data, bool saving, void* private_data)
+{
+	// Frontend hotkeys are not part of any source, so they are kept with the scene collection instead.
+	streamfx::ui::handler* ptr = reinterpret_cast<streamfx::ui::handler*>(private_data);
+	if (saving) {
+		obs_data_array_t* bindings = obs_hotkey_save(ptr->_trace_hotkey);
+		obs_data_set_array(save_data, _cfg_trace_hotkey.data(), bindings);
+		obs_data_array_release(bindings);
+	} else {
+		obs_data_array_t* bindings = obs_data_get_array(save_data, _cfg_trace_hotkey.data());
+		obs_hotkey_load(ptr->_trace_hotkey, bindings);
+		obs_data_array_release(bindings);
+	}
+}
+
+void streamfx::ui::handler::hotkey_trace(void* data, obs_hotkey_id, obs_hotkey_t*, bool pressed)
+{
+	if (pressed)
+		reinterpret_cast<streamfx::ui::handler*>(data)->capture_trace();
+}
+
+void streamfx::ui::handler::capture_trace()
+{
+	auto trace = streamfx::util::trace::get();
+	if (!trace)
+		return;
+
+	try {
+		std::time_t now = std::time(nullptr);
+		char        name[64];
+		std::strftime(name, sizeof(name), "traces/streamfx-%Y%m%d-%H%M%S.json", std::localtime(&now));
+		auto file = streamfx::config_file_path(name);
+		std::filesystem::create_directories(file.parent_path());
+
+		// Events only carry the address of the statistics they belong to, which is turned back into a name here.
+		trace->start(file, _trace_length, [](uint64_t object) {
+			std::string result;
+			streamfx::obs::statistics::enumerate([&result, object](std::shared_ptr<streamfx::obs::statistics> value) {
+				if (reinterpret_cast<uintptr_t>(value.get()) == object)
+					result = value->name();
+			});
+			return result;
+		});
+	} catch (const std::exception& ex) {
+		DLOG_ERROR("Failed to start capturing a trace: %s", ex.what());
+	}
+}
+
 void streamfx::ui::handler::on_obs_loaded()
 {
 	// Initialize the required Qt resources.
@@ -121,6 +205,10 @@ void streamfx::ui::handler::on_obs_loaded()
 	// Create the 'About StreamFX' dialog.
 	_about_dialog = new streamfx::ui::about();
 
+	// Create the performance dock, which OBS Studio lists in its 'Docks' menu.
+	_performance = new streamfx::ui::performance(reinterpret_cast<QWidget*>(obs_frontend_get_main_window()));
+	obs_frontend_add_dock(_performance);
+
 	{ // Create and build the StreamFX menu
 		_menu = new QMenu(reinterpret_cast<QWidget*>(obs_frontend_get_main_window()));
 
@@ -151,6 +239,39 @@ void streamfx::ui::handler::on_obs_loaded()
 		_link_github->setMenuRole(QAction::NoRole);
 		connect(_link_github, &QAction::triggered, this, &streamfx::ui::handler::on_action_github);
 
+		_menu->addSeparator();
+
+		// Frame Budget Governor
+		_governor = _menu->addAction(QString::fromUtf8(D_TRANSLATE(_i18n_menu_governor.data())));
+		_governor->setMenuRole(QAction::NoRole);
+		_governor->setCheckable(true);
+		if (auto governor = streamfx::obs::governor::get(); governor) {
+			_governor->setChecked(governor->is_enabled());
+		}
+		connect(_governor, &QAction::triggered, this, &streamfx::ui::handler::on_action_governor);
+
+		_preview = _menu->addAction(QString::fromUtf8(D_TRANSLATE(_i18n_menu_preview.data())));
+		_preview->setMenuRole(QAction::NoRole);
+		_preview->setCheckable(true);
+		if (auto governor = streamfx::obs::governor::get(); governor) {
+			_preview->setChecked(governor->is_preview_enabled());
+		}
+		connect(_preview, &QAction::triggered, this, &streamfx::ui::handler::on_action_preview);
+
+		// Scene Pre-Warming
+		_prewarm = _menu->addAction(QString::fromUtf8(D_TRANSLATE(_i18n_menu_prewarm.data())));
+		_prewarm->setMenuRole(QAction::NoRole);
+		_prewarm->setCheckable(true);
+		if (auto prewarm = streamfx::obs::prewarm::get(); prewarm) {
+			_prewarm->setChecked(prewarm->is_enabled());
+		}
+		connect(_prewarm, &QAction::triggered, this, &streamfx::ui::handler::on_action_prewarm);
+
+		// Trace Capture
+		_trace = _menu->addAction(QString::fromUtf8(D_TRANSLATE(_i18n_menu_trace.data())));
+		_trace->setMenuRole(QAction::NoRole);
+		connect(_trace, &QAction::triggered, this, &streamfx::ui::handler::on_action_trace);
+
 		// Create the updater.
 #ifdef ENABLE_UPDATER
 		_updater = streamfx::ui::updater::instance(_menu);
@@ -196,6 +317,10 @@ void streamfx::ui::handler::on_obs_loaded()
 
 void streamfx::ui::handler::on_obs_exit()
 {
+	// Stop looking at instances that are about to be destroyed.
+	if (_performance)
+		_performance->clear();
+
 	// Remove translator.
 	QCoreApplication::removeTranslator(_translator);
 
@@ -203,6 +328,32 @@ void streamfx::ui::handler::on_obs_exit()
 	qt_cleanup_resource();
 }
 
+void streamfx::ui::handler::on_collection_loaded()
+{
+	// Both events can arrive for the same collection, only the first one ends its loading.
+	if (!streamfx::obs::statistics::is_loading())
+		return;
+
+	streamfx::obs::statistics::set_loading(false);
+	streamfx::obs::statistics::log_load_summary(10);
+}
+
+void streamfx::ui::handler::on_preview_scene_changed()
+{
+	// In Studio Mode, whatever is in the preview is the scene most likely to go live next. Unless the preview is
+	// rendered at reduced quality, it already renders just like it will in program, and there is nothing to warm up.
+	auto prewarm = streamfx::obs::prewarm::get();
+	if (!prewarm || !prewarm->is_enabled() || !obs_frontend_preview_program_mode_active())
+		return;
+	if (auto governor = streamfx::obs::governor::get(); !governor || !governor->is_preview_enabled())
+		return;
+
+	if (obs_source_t* scene = obs_frontend_get_current_preview_scene(); scene) {
+		prewarm->warm(scene);
+		obs_source_release(scene);
+	}
+}
+
 void streamfx::ui::handler::on_action_report_issue(bool)
 {
 	QDesktopServices::openUrl(QUrl(QString::fromUtf8(_url_report_issue.data())));
@@ -233,6 +384,35 @@ void streamfx::ui::handler::on_action_about(bool checked)
 	_about_dialog->show();
 }
 
+void streamfx::ui::handler::on_action_governor(bool checked)
+{
+	if (auto governor = streamfx::obs::governor::get(); governor) {
+		governor->set_enabled(checked);
+	}
+}
+
+void streamfx::ui::handler::on_action_preview(bool checked)
+{
+	if (auto governor = streamfx::obs::governor::get(); governor) {
+		governor->set_preview_enabled(checked);
+	}
+}
+
+void streamfx::ui::handler::on_action_prewarm(bool checked)
+{
+	if (auto prewarm = streamfx::obs::prewarm::get(); prewarm) {
+		prewarm->set_enabled(checked);
+		if (checked) {
+			on_preview_scene_changed();
+		}
+	}
+}
+
+void streamfx::ui::handler::on_action_trace(bool)
+{
+	capture_trace();
+}
+
 static std::shared_ptr<streamfx::ui::handler> _handler_singleton;
 
 void streamfx::ui::handler::initialize()
@@ -20,6 +20,7 @@
 #pragma once
 #include "ui-about.hpp"
 #include "ui-common.hpp"
+#include "ui-performance.hpp"
 
 #ifdef ENABLE_UPDATER
 #include "ui-updater.hpp"
@@ -46,6 +47,20 @@ namespace streamfx::ui {
 		QAction*   _about_action;
 		ui::about* _about_dialog;
 
+		// Performance Dock
+		ui::performance* _performance;
+
+		// Frame Budget Governor
+		QAction* _governor;
+		QAction* _preview;
+
+		// Scene Pre-Warming
+		QAction* _prewarm;
+
+		// Trace Capture
+		QAction*      _trace;
+		obs_hotkey_id _trace_hotkey;
+
 		QTranslator* _translator;
 
 #ifdef ENABLE_UPDATER
@@ -61,8 +76,16 @@ namespace streamfx::ui {
 		private:
 		static void frontend_event_handler(obs_frontend_event event, void* private_data);
 
+		static void frontend_save_handler(obs_data_t* save_data, bool saving, void* private_data);
+
+		static void hotkey_trace(void* data, obs_hotkey_id id, obs_hotkey_t* hotkey, bool pressed);
+
+		void capture_trace();
+
 		void on_obs_loaded();
 		void on_obs_exit();
+		void on_collection_loaded();
+		void on_preview_scene_changed();
 
 		public slots:
 		; // Not having this breaks some linters.
@@ -79,6 +102,16 @@ namespace streamfx::ui {
 		// About
 		void on_action_about(bool);
 
+		// Frame Budget Governor
+		void on_action_governor(bool);
+		void on_action_preview(bool);
+
+		// Scene Pre-Warming
+		void on_action_prewarm(bool);
+
+		// Trace Capture
+		void on_action_trace(bool);
+
 		public /* Singleton */:
 		static void initialize();
 
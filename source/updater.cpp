@@ -20,13 +20,14 @@
 
 #include "updater.hpp"
 #include "version.hpp"
+#include <algorithm>
+#include <cctype>
 #include <mutex>
 #include <string_view>
 #include "configuration.hpp"
 #include "plugin.hpp"
 
 // TODO:
-// - Cache result in the configuration directory (not as a configuration value).
 // - Move 'autoupdater.last_checked_at' to out of the configuration.
 // - Figure out if nightly updates are viable at all.
 
@@ -44,6 +45,9 @@
 #define ST_CFG_AUTOMATION "updater.automation"
 #define ST_CFG_CHANNEL "updater.channel"
 #define ST_CFG_LASTCHECKEDAT "updater.lastcheckedat"
+#define ST_CFG_ETAG "updater.etag"
+#define ST_CFG_CACHE_RELEASE "updater.cache.release"
+#define ST_CFG_CACHE_TESTING "updater.cache.testing"
 
 void streamfx::to_json(nlohmann::json& json, const update_info& info)
 {
@@ -112,7 +116,7 @@ void streamfx::from_json(const nlohmann::json& json, update_info& info)
 		info.version_major = version.at("major").get<uint16_t>();
 		info.version_minor = version.at("minor").get<uint16_t>();
 		info.version_patch = version.at("patch").get<uint16_t>();
-		if (version.find("type") != version.end())
+		if (version.find("alpha") != version.end())
 			info.version_type = version.at("alpha").get<bool>() ? 'a' : 'b';
 		info.version_index = version.at("index").get<uint16_t>();
 		info.channel       = json.at("preview").get<bool>() ? update_channel::TESTING : update_channel::RELEASE;
@@ -182,8 +186,18 @@ void streamfx::updater::task(streamfx::util::threadpool_data_t)
 try {
 	{
 		std::vector<char> buffer;
-		task_query(buffer);
-		task_parse(buffer);
+		std::string       etag;
+		if (task_query(buffer, etag)) {
+			task_parse(buffer);
+
+			// Remember the result, so that the next launch has it without asking, and the next check can be answered
+			// with a 304 instead of the full list of releases.
+			std::lock_guard<std::mutex> lock(_lock);
+			_etag = etag;
+			save();
+		} else {
+			D_LOG_DEBUG("Releases are unchanged since the last check.");
+		}
 	}
 
 #ifdef _DEBUG
@@ -223,16 +237,28 @@ try {
 	events.error.call(*this, message);
 }
 
-void streamfx::updater::task_query(std::vector<char>& buffer)
+bool streamfx::updater::task_query(std::vector<char>& buffer, std::string& etag)
 {
 	static constexpr std::string_view ST_API_URL = "https://api.github.com/repos/Xaymar/obs-StreamFX/releases";
 
-	streamfx::util::curl curl;
-	size_t               buffer_offset = 0;
+	// Reusing the handle keeps the connection to the API alive between checks.
+	if (!_curl) {
+		_curl = std::make_shared<streamfx::util::curl>();
+	}
+	auto&  curl          = *_curl;
+	size_t buffer_offset = 0;
 
 	// Set headers (User-Agent is needed so Github can contact us!).
 	curl.set_header("User-Agent", "StreamFX Updater v" STREAMFX_VERSION_STRING);
 	curl.set_header("Accept", "application/vnd.github.v3+json");
+	{ // Ask for the releases only if they changed since the response the current information was built from.
+		std::lock_guard<std::mutex> lock(_lock);
+		if (!_etag.empty()) {
+			curl.set_header("If-None-Match", _etag);
+		} else {
+			curl.clear_header("If-None-Match");
+		}
+	}
 
 	// Set up request.
 	curl.set_option(CURLOPT_HTTPGET, true); // GET
@@ -252,6 +278,22 @@ void streamfx::updater::task_query(std::vector<char>& buffer)
 		return s1 * s2;
 	});
 	//std::bind(&streamfx::updater::task_write_cb, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)
+	curl.set_header_callback([&etag](void* data, size_t s1, size_t s2) {
+		std::string_view line(static_cast<const char*>(data), s1 * s2);
+		if (line.substr(0, 5) == "HTTP/") {
+			etag.clear(); // Headers of a previous response, such as a redirect.
+		} else if ((line.size() > 5) && std::equal(line.begin(), line.begin() + 5, "etag:", [](char a, char b) {
+					   return std::tolower(static_cast<unsigned char>(a)) == b;
+				   })) {
+			line.remove_prefix(5);
+			while (!line.empty() && std::isspace(static_cast<unsigned char>(line.front())))
+				line.remove_prefix(1);
+			while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back())))
+				line.remove_suffix(1);
+			etag = line;
+		}
+		return s1 * s2;
+	});
 
 	// Clear any unknown data and reserve 64KiB of memory.
 	buffer.clear();
@@ -271,10 +313,14 @@ void streamfx::updater::task_query(std::vector<char>& buffer)
 	}
 	D_LOG_DEBUG("API returned status code %d.", status_code);
 
-	if (status_code != 200) {
+	if (status_code == 304) {
+		return false;
+	} else if (status_code != 200) {
 		D_LOG_ERROR("API returned unexpected status code %d.", status_code);
 		throw std::runtime_error("Request failed due to one or more reasons.");
 	}
+
+	return true;
 }
 
 void streamfx::updater::task_parse(std::vector<char>& buffer)
@@ -333,6 +379,23 @@ void streamfx::updater::load()
 			_channel = static_cast<update_channel>(obs_data_get_int(dataptr.get(), ST_CFG_CHANNEL));
 		if (obs_data_has_user_value(dataptr.get(), ST_CFG_LASTCHECKEDAT))
 			_lastcheckedat = std::chrono::seconds(obs_data_get_int(dataptr.get(), ST_CFG_LASTCHECKEDAT));
+
+		// Restore the result of the last check, without which the ETag is meaningless.
+		try {
+			if (obs_data_has_user_value(dataptr.get(), ST_CFG_CACHE_RELEASE)
+				&& obs_data_has_user_value(dataptr.get(), ST_CFG_CACHE_TESTING)) {
+				_release_info = nlohmann::json::parse(obs_data_get_string(dataptr.get(), ST_CFG_CACHE_RELEASE))
+									.get<update_info>();
+				_testing_info = nlohmann::json::parse(obs_data_get_string(dataptr.get(), ST_CFG_CACHE_TESTING))
+									.get<update_info>();
+				_etag         = obs_data_get_string(dataptr.get(), ST_CFG_ETAG);
+			}
+		} catch (const std::exception& ex) {
+			D_LOG_WARNING("Failed to restore the result of the last check: %s", ex.what());
+			_release_info = {};
+			_testing_info = {};
+			_etag.clear();
+		}
 	}
 }
 
@@ -345,6 +408,9 @@ void streamfx::updater::save()
 		obs_data_set_bool(dataptr.get(), ST_CFG_AUTOMATION, _automation);
 		obs_data_set_int(dataptr.get(), ST_CFG_CHANNEL, static_cast<long long>(_channel));
 		obs_data_set_int(dataptr.get(), ST_CFG_LASTCHECKEDAT, static_cast<long long>(_lastcheckedat.count()));
+		obs_data_set_string(dataptr.get(), ST_CFG_ETAG, _etag.c_str());
+		obs_data_set_string(dataptr.get(), ST_CFG_CACHE_RELEASE, nlohmann::json(_release_info).dump().c_str());
+		obs_data_set_string(dataptr.get(), ST_CFG_CACHE_TESTING, nlohmann::json(_testing_info).dump().c_str());
 	}
 }
 
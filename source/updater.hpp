@@ -52,6 +52,7 @@ namespace streamfx {
 		// Internal
 		std::mutex                                        _lock;
 		std::weak_ptr<::streamfx::util::threadpool::task> _task;
+		std::shared_ptr<::streamfx::util::curl>           _curl; // Kept between checks to reuse the connection.
 
 		// Options
 		std::atomic_bool     _gdpr;
@@ -63,11 +64,12 @@ namespace streamfx {
 		update_info _current_info;
 		update_info _release_info;
 		update_info _testing_info;
+		std::string _etag; // Identifies the response that the information above was built from.
 		bool        _dirty;
 
 		private:
 		void task(streamfx::util::threadpool_data_t);
-		void task_query(std::vector<char>& buffer);
+		bool task_query(std::vector<char>& buffer, std::string& etag);
 		void task_parse(std::vector<char>& buffer);
 
 		bool can_check();
@@ -42,6 +42,7 @@ namespace streamfx::util {
 		CURL*                              _curl;
 		curl_io_callback_t                 _read_callback;
 		curl_io_callback_t                 _write_callback;
+		curl_io_callback_t                 _header_callback;
 		curl_xferinfo_callback_t           _xferinfo_callback;
 		curl_debug_callback_t              _debug_callback;
 		std::map<std::string, std::string> _headers;
@@ -50,6 +51,7 @@ namespace streamfx::util {
 									streamfx::util::curl* userptr);
 		static size_t  read_helper(void*, size_t, size_t, streamfx::util::curl*);
 		static size_t  write_helper(void*, size_t, size_t, streamfx::util::curl*);
+		static size_t  header_helper(void*, size_t, size_t, streamfx::util::curl*);
 		static int32_t xferinfo_callback(streamfx::util::curl*, curl_off_t, curl_off_t, curl_off_t, curl_off_t);
 
 		public:
@@ -123,6 +125,9 @@ namespace streamfx::util {
 
 		CURLcode set_write_callback(curl_io_callback_t cb);
 
+		/** Called once for every response header line, including the status line and the final empty line. */
+		CURLcode set_header_callback(curl_io_callback_t cb);
+
 		CURLcode set_xferinfo_callback(curl_xferinfo_callback_t cb);
 
 		CURLcode set_debug_callback(curl_debug_callback_t cb);
@@ -19,21 +19,45 @@
 
 #pragma once
 #include "common.hpp"
+#include <algorithm>
 #include <functional>
-#include <list>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 namespace streamfx::util {
+	/** Listeners are kept in an immutable snapshot that is replaced as a whole whenever they change.
+	 *
+	 * Calling the event only takes a reference to the current snapshot. It never waits on _lock and never allocates,
+	 * and may run concurrently with itself and with changes to the listeners. A listener that is removed while a call
+	 * is in progress elsewhere may still receive that one call.
+	 *
+	 * The snapshot is swapped with std::atomic_load/atomic_store. These are not lock-free: standard libraries guard
+	 * them with a small pool of internal locks, held only while the reference count is updated. C++20 deprecates them
+	 * in favor of std::atomic<std::shared_ptr>, which this should move to once the plugin builds as C++20.
+	 */
 	template<typename... _args>
 	class event {
-		std::list<std::function<void(_args...)>> _listeners;
-		std::recursive_mutex                     _lock;
+		typedef std::vector<std::function<void(_args...)>> listeners_t;
+
+		std::shared_ptr<const listeners_t> _listeners;
+		std::recursive_mutex               _lock; // Only serializes changes, never taken while calling.
 
 		std::function<void()> _cb_fill;
 		std::function<void()> _cb_clear;
 
+		void publish(std::shared_ptr<const listeners_t> listeners)
+		{
+			std::atomic_store(&_listeners, std::move(listeners));
+		}
+
+		std::shared_ptr<const listeners_t> snapshot()
+		{
+			return std::atomic_load(&_listeners);
+		}
+
 		public /* constructor */:
-		event() : _listeners(), _lock(), _cb_fill(), _cb_clear() {}
+		event() : _listeners(std::make_shared<const listeners_t>()), _lock(), _cb_fill(), _cb_clear() {}
 		virtual ~event()
 		{
 			std::lock_guard<std::recursive_mutex> lg(_lock);
@@ -49,7 +73,9 @@ namespace streamfx::util {
 			std::lock_guard<std::recursive_mutex> lg(_lock);
 			std::lock_guard<std::recursive_mutex> lgo(other._lock);
 
-			_listeners.swap(other._listeners);
+			auto listeners = snapshot();
+			publish(other.snapshot());
+			other.publish(listeners);
 			_cb_fill.swap(other._cb_fill);
 			_cb_clear.swap(other._cb_clear);
 		}
@@ -65,7 +91,9 @@ namespace streamfx::util {
 			std::lock_guard<std::recursive_mutex> lg(_lock);
 			std::lock_guard<std::recursive_mutex> lgo(other._lock);
 
-			_listeners.swap(other._listeners);
+			auto listeners = snapshot();
+			publish(other.snapshot());
+			other.publish(listeners);
 			_cb_fill.swap(other._cb_fill);
 			_cb_clear.swap(other._cb_clear);
 
@@ -82,8 +110,8 @@ namespace streamfx::util {
 		template<typename... _largs>
 		inline void call(_args... args)
 		{
-			std::lock_guard<std::recursive_mutex> lg(_lock);
-			for (auto& l : _listeners) {
+			std::shared_ptr<const listeners_t> listeners = snapshot();
+			for (auto& l : *listeners) {
 				l(args...);
 			}
 		}
@@ -96,12 +124,14 @@ namespace streamfx::util {
 		inline void add(std::function<void(_args...)> listener)
 		{
 			std::lock_guard<std::recursive_mutex> lg(_lock);
-			if (_listeners.size() == 0) {
+			auto                                  listeners = std::make_shared<listeners_t>(*snapshot());
+			if (listeners->size() == 0) {
 				if (_cb_fill) {
 					_cb_fill();
 				}
 			}
-			_listeners.push_back(listener);
+			listeners->push_back(listener);
+			publish(std::move(listeners));
 		}
 		inline event<_args...>& operator+=(std::function<void(_args...)> listener)
 		{
@@ -115,8 +145,11 @@ namespace streamfx::util {
 		inline void remove(std::function<void(_args...)> listener)
 		{
 			std::lock_guard<std::recursive_mutex> lg(_lock);
-			_listeners.remove(listener);
-			if (_listeners.size() == 0) {
+			auto                                  listeners = std::make_shared<listeners_t>(*snapshot());
+			listeners->erase(std::remove(listeners->begin(), listeners->end(), listener), listeners->end());
+			bool empty = listeners->empty();
+			publish(std::move(listeners));
+			if (empty) {
 				if (_cb_clear) {
 					_cb_clear();
 				}
@@ -133,8 +166,7 @@ namespace streamfx::util {
 		 */
 		inline bool empty()
 		{
-			std::lock_guard<std::recursive_mutex> lg(_lock);
-			return _listeners.empty();
+			return snapshot()->empty();
 		}
 		inline operator bool()
 		{
@@ -146,7 +178,7 @@ namespace streamfx::util {
 		inline void clear()
 		{
 			std::lock_guard<std::recursive_mutex> lg(_lock);
-			_listeners.clear();
+			publish(std::make_shared<const listeners_t>());
 			if (_cb_clear) {
 				_cb_clear();
 			}
@@ -0,0 +1,307 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+*/
+
+#include "util-file-watcher.hpp"
+#include <cerrno>
+#include <set>
+#include <thread>
+#include <vector>
+#include "util-logging.hpp"
+
+#if defined(WIN32)
+#include <Windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifdef _DEBUG
+#define ST_PREFIX "<%s> "
+#define D_LOG_ERROR(x, ...) P_LOG_ERROR(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_WARNING(x, ...) P_LOG_WARN(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_INFO(x, ...) P_LOG_INFO(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#define D_LOG_DEBUG(x, ...) P_LOG_DEBUG(ST_PREFIX##x, __FUNCTION_SIG__, __VA_ARGS__)
+#else
+#define ST_PREFIX "<util::file_watcher> "
+#define D_LOG_ERROR(...) P_LOG_ERROR(ST_PREFIX __VA_ARGS__)
+#define D_LOG_WARNING(...) P_LOG_WARN(ST_PREFIX __VA_ARGS__)
+#define D_LOG_INFO(...) P_LOG_INFO(ST_PREFIX __VA_ARGS__)
+#define D_LOG_DEBUG(...) P_LOG_DEBUG(ST_PREFIX __VA_ARGS__)
+#endif
+
+// Same rate at which shaders used to check their files on their own.
+#define ST_POLL_INTERVAL std::chrono::milliseconds(333)
+
+static std::shared_ptr<streamfx::util::file_watcher> _file_watcher_instance;
+
+streamfx::util::file_watcher::watch::watch(std::filesystem::path file)
+	: _file(file), _changed(false), _polled(true), _time(), _size(0)
+{
+	std::error_code ec;
+	_time = std::filesystem::last_write_time(_file, ec);
+	_size = std::filesystem::file_size(_file, ec);
+}
+
+streamfx::util::file_watcher::watch::~watch() {}
+
+const std::filesystem::path& streamfx::util::file_watcher::watch::file()
+{
+	return _file;
+}
+
+bool streamfx::util::file_watcher::watch::changed()
+{
+	return _changed.exchange(false);
+}
+
+streamfx::util::file_watcher::file_watcher()
+	: _lock(), _watches(), _directories(), _native(-1), _running(false), _stop(false), _worker(), _last_poll()
+{
+#if defined(__linux__)
+	_native = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (_native < 0) {
+		D_LOG_WARNING("Native file notifications are unavailable (error %d), falling back to polling.", errno);
+	}
+#endif
+}
+
+streamfx::util::file_watcher::~file_watcher()
+{
+	// The worker notices within one poll interval, and must be gone before the handles it waits on are closed.
+	_stop = true;
+	if (_worker.joinable()) {
+		_worker.join();
+	}
+
+#if defined(WIN32)
+	for (auto& kv : _directories) {
+		FindCloseChangeNotification(reinterpret_cast<HANDLE>(kv.second));
+	}
+#elif defined(__linux__)
+	if (_native >= 0) {
+		close(static_cast<int>(_native)); // Also removes all watches.
+	}
+#endif
+}
+
+std::shared_ptr<streamfx::util::file_watcher::watch> streamfx::util::file_watcher::add(std::filesystem::path file)
+{
+	std::error_code ec;
+	if (auto path = std::filesystem::absolute(file, ec); !ec) {
+		file = path.lexically_normal();
+	}
+	auto value = std::make_shared<watch>(file);
+
+	std::unique_lock<std::mutex> lock{_lock};
+	value->_polled = !watch_directory(file.parent_path());
+	_watches.push_back(value);
+
+	// The worker ends on its own once nothing is watched anymore, and no longer touches anything at that point.
+	if (!_running) {
+		if (_worker.joinable()) {
+			_worker.join();
+		}
+		_running = true;
+		_worker  = std::thread(&file_watcher::work, this);
+	}
+
+	return value;
+}
+
+bool streamfx::util::file_watcher::watch_directory(const std::filesystem::path& directory)
+{
+	if (_directories.find(directory) != _directories.end()) {
+		return true;
+	}
+
+#if defined(WIN32)
+	// The worker waits for all directories at once, which Windows limits.
+	if (_directories.size() >= MAXIMUM_WAIT_OBJECTS) {
+		return false;
+	}
+
+	HANDLE handle = FindFirstChangeNotificationW(directory.wstring().c_str(), FALSE,
+												 FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE
+													 | FILE_NOTIFY_CHANGE_LAST_WRITE);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	_directories.emplace(directory, reinterpret_cast<intptr_t>(handle));
+	return true;
+#elif defined(__linux__)
+	if (_native < 0) {
+		return false;
+	}
+
+	// Editors often save by replacing the file, so the directory is watched instead of the file itself.
+	int wd = inotify_add_watch(static_cast<int>(_native), directory.c_str(),
+							   IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+	if (wd < 0) {
+		return false;
+	}
+	_directories.emplace(directory, wd);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void streamfx::util::file_watcher::notify(const std::filesystem::path& directory, const std::filesystem::path& name)
+{
+	std::unique_lock<std::mutex> lock{_lock};
+	for (auto& weak : _watches) {
+		if (auto value = weak.lock(); value) {
+			if ((value->_file.parent_path() == directory) && (name.empty() || (value->_file.filename() == name))) {
+				value->_changed = true;
+			}
+		}
+	}
+}
+
+bool streamfx::util::file_watcher::poll()
+{
+	std::unique_lock<std::mutex> lock{_lock};
+
+	std::set<std::filesystem::path> used;
+	for (auto iter = _watches.begin(); iter != _watches.end();) {
+		auto value = iter->lock();
+		if (!value) {
+			iter = _watches.erase(iter);
+			continue;
+		}
+		used.insert(value->_file.parent_path());
+
+		if (value->_polled) {
+			std::error_code ec;
+			auto            time = std::filesystem::last_write_time(value->_file, ec);
+			auto            size = std::filesystem::file_size(value->_file, ec);
+			if ((time != value->_time) || (size != value->_size)) {
+				value->_time    = time;
+				value->_size    = size;
+				value->_changed = true;
+			}
+		}
+		++iter;
+	}
+
+	// Stop watching directories that no one is interested in anymore.
+	for (auto iter = _directories.begin(); iter != _directories.end();) {
+		if (used.find(iter->first) != used.end()) {
+			++iter;
+			continue;
+		}
+#if defined(WIN32)
+		FindCloseChangeNotification(reinterpret_cast<HANDLE>(iter->second));
+#elif defined(__linux__)
+		inotify_rm_watch(static_cast<int>(_native), static_cast<int>(iter->second));
+#endif
+		iter = _directories.erase(iter);
+	}
+
+	if (_watches.empty()) {
+		_running = false;
+	}
+	return _running;
+}
+
+void streamfx::util::file_watcher::work()
+{
+	for (bool running = true; running && !_stop;) {
+#if defined(WIN32)
+		std::vector<HANDLE>                handles;
+		std::vector<std::filesystem::path> directories;
+		{
+			std::unique_lock<std::mutex> lock{_lock};
+			for (auto& kv : _directories) {
+				handles.push_back(reinterpret_cast<HANDLE>(kv.second));
+				directories.push_back(kv.first);
+			}
+		}
+
+		if (handles.empty()) {
+			std::this_thread::sleep_for(ST_POLL_INTERVAL);
+		} else {
+			DWORD res = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE,
+											   static_cast<DWORD>(ST_POLL_INTERVAL.count()));
+			if (res < (WAIT_OBJECT_0 + handles.size())) {
+				// Windows only tells that something in the directory changed, so all files in it are flagged.
+				std::size_t idx = res - WAIT_OBJECT_0;
+				notify(directories[idx], {});
+				FindNextChangeNotification(handles[idx]);
+			}
+		}
+#elif defined(__linux__)
+		if (_native < 0) {
+			std::this_thread::sleep_for(ST_POLL_INTERVAL);
+		} else {
+			pollfd fd{static_cast<int>(_native), POLLIN, 0};
+			if ((::poll(&fd, 1, static_cast<int>(ST_POLL_INTERVAL.count())) > 0) && (fd.revents & POLLIN)) {
+				alignas(inotify_event) char buffer[4096];
+				ssize_t                     length = read(static_cast<int>(_native), buffer, sizeof(buffer));
+				for (ssize_t offset = 0; offset < length;) {
+					auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+					offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+					std::filesystem::path directory;
+					{
+						std::unique_lock<std::mutex> lock{_lock};
+						for (auto& kv : _directories) {
+							if (kv.second == event->wd) {
+								directory = kv.first;
+								break;
+							}
+						}
+					}
+					if (!directory.empty()) {
+						std::filesystem::path name;
+						if (event->len > 0) {
+							name = event->name;
+						}
+						notify(directory, name);
+					}
+				}
+			}
+		}
+#else
+		// No native notifications here, every file is polled.
+		std::this_thread::sleep_for(ST_POLL_INTERVAL);
+#endif
+
+		if (auto now = std::chrono::steady_clock::now(); (now - _last_poll) >= ST_POLL_INTERVAL) {
+			_last_poll = now;
+			running    = poll();
+		}
+	}
+}
+
+void streamfx::util::file_watcher::initialize()
+{
+	_file_watcher_instance = std::shared_ptr<file_watcher>(new file_watcher());
+}
+
+void streamfx::util::file_watcher::finalize()
+{
+	_file_watcher_instance.reset();
+}
+
+std::shared_ptr<streamfx::util::file_watcher> streamfx::util::file_watcher::instance()
+{
+	return _file_watcher_instance;
+}
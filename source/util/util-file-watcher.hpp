@@ -0,0 +1,97 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace streamfx::util {
+	/** Process-wide watcher for file changes.
+	 *
+	 * A single worker thread waits for change notifications from the operating system and flags the affected
+	 * watches, so that their owners only have to check an atomic flag. Files which can't be watched natively are
+	 * polled by the same thread instead. The thread only runs while anything is watched, and is joined when the
+	 * watcher is finalized.
+	 */
+	class file_watcher {
+		public:
+		class watch {
+			std::filesystem::path _file;
+			std::atomic_bool      _changed;
+			bool                  _polled;
+
+			// Last known state, only used while polling.
+			std::filesystem::file_time_type _time;
+			std::uintmax_t                  _size;
+
+			public:
+			watch(std::filesystem::path file);
+			~watch();
+
+			const std::filesystem::path& file();
+
+			/** Whether the file changed since the last call.
+			 */
+			bool changed();
+
+			friend class file_watcher;
+		};
+
+		private:
+		std::mutex                                _lock;
+		std::list<std::weak_ptr<watch>>           _watches;
+		std::map<std::filesystem::path, intptr_t> _directories; // Native handles of the watched directories.
+		intptr_t                                  _native;
+		bool                                      _running;
+		std::atomic_bool                          _stop;
+		std::thread                               _worker;
+		std::chrono::steady_clock::time_point     _last_poll;
+
+		public:
+		file_watcher();
+		~file_watcher();
+
+		/** Start watching a file, which stops once the returned watch is released.
+		 */
+		std::shared_ptr<watch> add(std::filesystem::path file);
+
+		private:
+		bool watch_directory(const std::filesystem::path& directory);
+
+		void notify(const std::filesystem::path& directory, const std::filesystem::path& name);
+
+		/** Poll files without native notifications and forget about released watches.
+		 * @return false once nothing is watched anymore, which ends the worker.
+		 */
+		bool poll();
+
+		void work();
+
+		public /* Singleton */:
+		static void                          initialize();
+		static void                          finalize();
+		static std::shared_ptr<file_watcher> instance();
+	};
+} // namespace streamfx::util
@@ -20,6 +20,120 @@
 #include "util-logging.hpp"
 #include "common.hpp"
 #include <stdarg.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Messages that fit into a record, longer ones are written out right away.
+#define ST_RECORD_SIZE 512
+// Records that can be queued at once, must be a power of two.
+#define ST_RECORD_COUNT 1024
+// How long the flusher sleeps when there is nothing to do.
+#define ST_FLUSH_INTERVAL std::chrono::milliseconds(10)
+
+namespace {
+	struct record {
+		std::atomic<std::size_t> sequence;
+		int32_t                  level;
+		char                     text[ST_RECORD_SIZE];
+	};
+
+	/** Bounded multi-producer single-consumer ring, using a sequence number per record.
+	 *
+	 * A record may be written once its sequence equals the position a producer claimed, and read once it is one past
+	 * that. Producers only contend on claiming a position, and never wait for each other or the consumer.
+	 */
+	class log_queue {
+		std::array<record, ST_RECORD_COUNT> _records;
+		std::atomic<std::size_t>            _head; // Next position to claim.
+		std::mutex                          _tail_lock; // Held by whoever is flushing.
+		std::size_t                         _tail;
+		std::atomic<uint64_t>               _dropped;
+
+		public:
+		log_queue() : _records(), _head(0), _tail_lock(), _tail(0), _dropped(0)
+		{
+			for (std::size_t idx = 0; idx < _records.size(); idx++) {
+				_records[idx].sequence.store(idx, std::memory_order_relaxed);
+			}
+		}
+
+		bool push(int32_t level, const char* text, std::size_t length)
+		{
+			std::size_t pos = _head.load(std::memory_order_relaxed);
+			record*     rec = nullptr;
+			while (true) {
+				rec                = &_records[pos & (ST_RECORD_COUNT - 1)];
+				std::size_t seq    = rec->sequence.load(std::memory_order_acquire);
+				intptr_t    offset = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+				if (offset == 0) {
+					if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				} else if (offset < 0) {
+					_dropped.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				} else {
+					pos = _head.load(std::memory_order_relaxed);
+				}
+			}
+
+			rec->level = level;
+			memcpy(rec->text, text, length);
+			rec->text[length] = '\0';
+			rec->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		/** Write out everything that is queued right now, and then the given message if any.
+		 * @return true if anything was written.
+		 */
+		bool flush(int32_t level = 0, const char* text = nullptr)
+		{
+			std::unique_lock<std::mutex> lock(_tail_lock);
+
+			bool    written = false;
+			record* rec     = &_records[_tail & (ST_RECORD_COUNT - 1)];
+			while (rec->sequence.load(std::memory_order_acquire) == (_tail + 1)) {
+				blog(rec->level, "[StreamFX] %s", rec->text);
+				rec->sequence.store(_tail + ST_RECORD_COUNT, std::memory_order_release);
+				rec     = &_records[(++_tail) & (ST_RECORD_COUNT - 1)];
+				written = true;
+			}
+
+			if (uint64_t dropped = _dropped.exchange(0, std::memory_order_relaxed); dropped > 0) {
+				blog(LOG_WARNING, "[StreamFX] Dropped %" PRIu64 " log message(s), the log queue was full.", dropped);
+			}
+
+			if (text) {
+				blog(level, "[StreamFX] %s", text);
+				written = true;
+			}
+			return written;
+		}
+	};
+
+	std::mutex                 _flusher_lock;
+	std::condition_variable    _flusher_cv;
+	std::thread                _flusher;
+	bool                       _flusher_stop = false;
+	std::atomic_bool           _flusher_running{false};
+	std::unique_ptr<log_queue> _queue; // Kept until unload, a late producer may still be pushing into it.
+
+	void flusher_main()
+	{
+		std::unique_lock<std::mutex> lock(_flusher_lock);
+		while (!_flusher_stop) {
+			lock.unlock();
+			_queue->flush();
+			lock.lock();
+
+			// Producers never wake the flusher, so that logging does not need to make a system call.
+			_flusher_cv.wait_for(lock, ST_FLUSH_INTERVAL, [] { return _flusher_stop; });
+		}
+	}
+} // namespace
 
 void streamfx::util::logging::log(level lvl, const char* format, ...)
 {
@@ -29,16 +143,59 @@ void streamfx::util::logging::log(level lvl, const char* format, ...)
 		{level::LEVEL_WARN, LOG_WARNING},
 		{level::LEVEL_ERROR, LOG_ERROR},
 	};
-	thread_local static std::vector<char> buffer;
+	int32_t obs_level = level_map.at(lvl);
 
 	va_list vargs;
 	va_start(vargs, format);
+	va_list vargs2;
+	va_copy(vargs2, vargs);
 
-	int32_t ret = vsnprintf(buffer.data(), buffer.size(), format, vargs);
-	buffer.resize(ret + 1);
-	ret = vsnprintf(buffer.data(), buffer.size(), format, vargs);
+	char    local[ST_RECORD_SIZE];
+	int32_t ret = vsnprintf(local, sizeof(local), format, vargs);
+	if ((ret >= 0) && (static_cast<std::size_t>(ret) < sizeof(local)) && _flusher_running.load()) {
+		if (lvl == level::LEVEL_ERROR) {
+			_queue->flush(obs_level, local);
+		} else {
+			_queue->push(obs_level, local, static_cast<std::size_t>(ret));
+		}
+	} else if (ret >= 0) {
+		if (static_cast<std::size_t>(ret) < sizeof(local)) {
+			blog(obs_level, "[StreamFX] %s", local);
+		} else {
+			std::vector<char> buffer(static_cast<std::size_t>(ret) + 1);
+			vsnprintf(buffer.data(), buffer.size(), format, vargs2);
+			blog(obs_level, "[StreamFX] %s", buffer.data());
+		}
+	}
 
+	va_end(vargs2);
 	va_end(vargs);
+}
+
+void streamfx::util::logging::initialize()
+{
+	if (_flusher_running.load())
+		return;
+
+	if (!_queue)
+		_queue = std::make_unique<log_queue>();
+	_flusher_stop = false;
+	_flusher      = std::thread(flusher_main);
+	_flusher_running.store(true);
+}
+
+void streamfx::util::logging::finalize()
+{
+	if (!_flusher_running.exchange(false))
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(_flusher_lock);
+		_flusher_stop = true;
+	}
+	_flusher_cv.notify_all();
+	_flusher.join();
 
-	blog(level_map.at(lvl), "[StreamFX] %s", buffer.data());
+	// Anything that was pushed while the flusher was stopping is still written out.
+	_queue->flush();
 }
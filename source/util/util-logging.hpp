@@ -46,6 +46,13 @@
 #define __FUNCTION_NAME__ __func__
 #endif
 
+// Let the compiler check format strings against their arguments.
+#if defined(__GNUC__) || defined(__clang__)
+#define ST_PRINTF_FORMAT(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define ST_PRINTF_FORMAT(fmt, args)
+#endif
+
 namespace streamfx::util::logging {
 	enum class level {
 		LEVEL_DEBUG, // Debug information, which is not necessary to know at runtime.
@@ -54,5 +61,21 @@ namespace streamfx::util::logging {
 		LEVEL_ERROR, // Errors that must be fixed.
 	};
 
-	void log(level lvl, const char* format, ...);
+	/** Format a message and hand it to the background flusher.
+	 *
+	 * Messages are formatted on the calling thread and queued in a lock-free ring, so that logging from the render,
+	 * audio or encoder threads never waits for libobs to write them out. Should the ring be full, the message is
+	 * dropped and later reported as such. Messages too long for the ring, or logged while the flusher is not running,
+	 * are written out right away instead. Errors are always written out right away, after everything queued before
+	 * them, so that they are in the log even if the process crashes right after.
+	 */
+	void log(level lvl, const char* format, ...) ST_PRINTF_FORMAT(2, 3);
+
+	/** Start the background flusher.
+	 */
+	void initialize();
+
+	/** Stop the background flusher, after it wrote out everything that is still queued.
+	 */
+	void finalize();
 } // namespace streamfx::util::logging
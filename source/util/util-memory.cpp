@@ -18,14 +18,79 @@
 */
 
 #include "util-memory.hpp"
-#include <cstdlib>
-#include <stdexcept>
-#include <stdlib.h>
+#include <algorithm>
+#include <new>
 
-#if defined(_MSC_VER) && (_MSC_VER <= 2100)
-//#define USE_MSC_ALLOC
-#elif defined(_cplusplus) && (__cplusplus >= 201103L)
-#define USE_STD_ALLOC
-#endif
+// Size of the first block of every arena.
+#define ST_BLOCK_SIZE 65536
+// Largest single request that the arena serves, anything larger is not a small temporary.
+#define ST_MAX_ALLOCATION 262144
 
-using namespace std;
+streamfx::util::frame_arena::frame_arena() : _blocks(), _live(0) {}
+
+streamfx::util::frame_arena::~frame_arena() {}
+
+void streamfx::util::frame_arena::reset()
+{
+	if (_blocks.size() > 1) {
+		// This frame needed more than one block, so the next one gets a block that fits all of it at once.
+		std::size_t total = 0;
+		for (auto& blk : _blocks) {
+			total += blk.size;
+		}
+		_blocks.clear();
+		_blocks.push_back({std::make_unique<uint8_t[]>(total), total, 0});
+	} else if (!_blocks.empty()) {
+		_blocks.front().used = 0;
+	}
+}
+
+void* streamfx::util::frame_arena::allocate(std::size_t size, std::size_t alignment)
+{
+	if (size > ST_MAX_ALLOCATION) {
+		return ::operator new(size);
+	}
+
+	if (!_blocks.empty()) {
+		auto&       blk    = _blocks.back();
+		std::size_t offset = (blk.used + alignment - 1) & ~(alignment - 1);
+		if ((offset + size) <= blk.size) {
+			blk.used = offset + size;
+			_live++;
+			return blk.data.get() + offset;
+		}
+	}
+
+	// Blocks are allocated aligned for any type, so a fresh block never needs padding.
+	std::size_t block_size = std::max<std::size_t>(_blocks.empty() ? ST_BLOCK_SIZE : _blocks.back().size * 2, size);
+	_blocks.push_back({std::make_unique<uint8_t[]>(block_size), block_size, size});
+	_live++;
+	return _blocks.back().data.get();
+}
+
+void streamfx::util::frame_arena::deallocate(void* ptr, std::size_t size)
+{
+	if (size > ST_MAX_ALLOCATION) {
+		::operator delete(ptr);
+		return;
+	}
+
+	if ((_live > 0) && (--_live == 0)) {
+		reset();
+	}
+}
+
+std::size_t streamfx::util::frame_arena::capacity()
+{
+	std::size_t total = 0;
+	for (auto& blk : _blocks) {
+		total += blk.size;
+	}
+	return total;
+}
+
+streamfx::util::frame_arena& streamfx::util::frame_arena::get()
+{
+	thread_local frame_arena arena;
+	return arena;
+}
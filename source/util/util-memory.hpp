@@ -0,0 +1,109 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace streamfx::util {
+	/** Per-thread bump allocator for temporaries that die within the frame they were made in.
+	 *
+	 * Allocating is a pointer increment, and freeing only counts down the live allocations. As soon as none are left,
+	 * which happens at the latest by the end of every frame, all of it is reused from the start. If a frame needed
+	 * more than one block, those are merged into a single larger block on reset, so after the first few frames the
+	 * render path stops touching the heap entirely. Requests above the size limit go to the heap instead.
+	 *
+	 * An arena belongs to the thread that called get(), memory from it must be released on that same thread.
+	 */
+	class frame_arena {
+		struct block {
+			std::unique_ptr<uint8_t[]> data;
+			std::size_t                size;
+			std::size_t                used;
+		};
+
+		std::vector<block> _blocks;
+		std::size_t        _live;
+
+		void reset();
+
+		public:
+		frame_arena();
+		~frame_arena();
+
+		void* allocate(std::size_t size, std::size_t alignment);
+
+		void deallocate(void* ptr, std::size_t size);
+
+		/** Bytes reserved for this arena, used or not. */
+		std::size_t capacity();
+
+		/** The arena of the calling thread. */
+		static frame_arena& get();
+	};
+
+	/** STL allocator on top of the frame_arena of the thread that created it.
+	 */
+	template<typename T>
+	class frame_allocator {
+		frame_arena* _arena;
+
+		template<typename U>
+		friend class frame_allocator;
+
+		public:
+		typedef T value_type;
+
+		frame_allocator() noexcept : _arena(&frame_arena::get()) {}
+
+		template<typename U>
+		frame_allocator(const frame_allocator<U>& other) noexcept : _arena(other._arena)
+		{}
+
+		T* allocate(std::size_t count)
+		{
+			return reinterpret_cast<T*>(_arena->allocate(count * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T* ptr, std::size_t count) noexcept
+		{
+			_arena->deallocate(ptr, count * sizeof(T));
+		}
+
+		template<typename U>
+		bool operator==(const frame_allocator<U>& other) const noexcept
+		{
+			return _arena == other._arena;
+		}
+
+		template<typename U>
+		bool operator!=(const frame_allocator<U>& other) const noexcept
+		{
+			return _arena != other._arena;
+		}
+	};
+
+	template<typename T>
+	using frame_vector = std::vector<T, frame_allocator<T>>;
+
+	using frame_string = std::basic_string<char, std::char_traits<char>, frame_allocator<char>>;
+} // namespace streamfx::util
@@ -0,0 +1,57 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+// Only compiled with AVX2 enabled, and only called through the dispatch table in util-plane-copy.cpp.
+
+namespace streamfx::util::detail {
+	void stream_rows_avx2(uint8_t* to, std::size_t to_stride, const uint8_t* from, std::size_t from_stride,
+						  std::size_t width, std::size_t height)
+	{
+		for (std::size_t y = 0; y < height; y++, to += to_stride, from += from_stride) {
+			// Copy until the destination is aligned, as streaming stores require it.
+			std::size_t head = std::min<std::size_t>((32 - (reinterpret_cast<uintptr_t>(to) & 31)) & 31, width);
+			std::memcpy(to, from, head);
+
+			std::size_t x = head;
+			for (; (x + 128) <= width; x += 128) {
+				__m256i r0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + x));
+				__m256i r1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + x + 32));
+				__m256i r2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + x + 64));
+				__m256i r3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + x + 96));
+				_mm256_stream_si256(reinterpret_cast<__m256i*>(to + x), r0);
+				_mm256_stream_si256(reinterpret_cast<__m256i*>(to + x + 32), r1);
+				_mm256_stream_si256(reinterpret_cast<__m256i*>(to + x + 64), r2);
+				_mm256_stream_si256(reinterpret_cast<__m256i*>(to + x + 96), r3);
+			}
+			std::memcpy(to + x, from + x, width - x);
+		}
+
+		// Streaming stores are weakly ordered, make them visible before anyone else reads the plane.
+		_mm_sfence();
+
+		// Avoid the penalty for mixing AVX and SSE code in the caller.
+		_mm256_zeroupper();
+	}
+} // namespace streamfx::util::detail
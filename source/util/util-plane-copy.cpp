@@ -0,0 +1,173 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "util-plane-copy.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include "plugin.hpp"
+#include "util-platform.hpp"
+#include "util-threadpool.hpp"
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__x86_64__) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ST_HAVE_SSE2
+#endif
+
+#if defined(ENABLE_SIMD) && defined(ST_HAVE_SSE2)
+namespace streamfx::util::detail {
+	// See util-plane-copy-avx2.cpp
+	void stream_rows_avx2(uint8_t* to, std::size_t to_stride, const uint8_t* from, std::size_t from_stride,
+						  std::size_t width, std::size_t height);
+} // namespace streamfx::util::detail
+#endif
+
+// Streaming stores only beat a regular copy once the plane no longer fits into the cache, and are up to twice as
+// slow below that (see the copy_plane micro-benchmarks). This is used if the cache size is unknown.
+#define ST_STREAMING_THRESHOLD (32 * 1024 * 1024)
+
+// Planes larger than this are split across the thread pool, in bands of at least this size.
+#define ST_THREADING_THRESHOLD (4 * 1024 * 1024)
+#define ST_THREADING_BAND (1 * 1024 * 1024)
+
+static void copy_rows_c(uint8_t* to, std::size_t to_stride, const uint8_t* from, std::size_t from_stride,
+						std::size_t width, std::size_t height)
+{
+	for (std::size_t y = 0; y < height; y++, to += to_stride, from += from_stride) {
+		std::memcpy(to, from, width);
+	}
+}
+
+#ifdef ST_HAVE_SSE2
+static void stream_rows_sse2(uint8_t* to, std::size_t to_stride, const uint8_t* from, std::size_t from_stride,
+							 std::size_t width, std::size_t height)
+{
+	for (std::size_t y = 0; y < height; y++, to += to_stride, from += from_stride) {
+		// Copy until the destination is aligned, as streaming stores require it.
+		std::size_t head = std::min<std::size_t>((16 - (reinterpret_cast<uintptr_t>(to) & 15)) & 15, width);
+		std::memcpy(to, from, head);
+
+		std::size_t x = head;
+		for (; (x + 64) <= width; x += 64) {
+			__m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + x));
+			__m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + x + 16));
+			__m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + x + 32));
+			__m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + x + 48));
+			_mm_stream_si128(reinterpret_cast<__m128i*>(to + x), r0);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(to + x + 16), r1);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(to + x + 32), r2);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(to + x + 48), r3);
+		}
+		std::memcpy(to + x, from + x, width - x);
+	}
+
+	// Streaming stores are weakly ordered, make them visible before anyone else reads the plane.
+	_mm_sfence();
+}
+#endif
+
+// Copies that bypass the cache, without streaming stores this is just a regular copy.
+static const streamfx::util::platform::dispatch<decltype(&copy_rows_c)> stream_rows({
+	{streamfx::util::platform::isa::NONE, &copy_rows_c},
+#ifdef ST_HAVE_SSE2
+	{streamfx::util::platform::isa::SSE2, &stream_rows_sse2},
+#if defined(ENABLE_SIMD)
+	{streamfx::util::platform::isa::AVX2, &streamfx::util::detail::stream_rows_avx2},
+#endif
+#endif
+});
+
+static void copy_rows(uint8_t* to, std::size_t to_stride, const uint8_t* from, std::size_t from_stride,
+					  std::size_t width, std::size_t height, bool streaming)
+{
+	if (streaming) {
+		stream_rows(to, to_stride, from, from_stride, width, height);
+	} else {
+		copy_rows_c(to, to_stride, from, from_stride, width, height);
+	}
+}
+
+std::size_t streamfx::util::get_streaming_threshold()
+{
+	static const std::size_t threshold = [] {
+		std::size_t cache = streamfx::util::platform::get_cache_size();
+		return (cache > 0) ? cache : static_cast<std::size_t>(ST_STREAMING_THRESHOLD);
+	}();
+	return threshold;
+}
+
+void streamfx::util::copy_plane(uint8_t* to, std::size_t to_stride, const uint8_t* from, std::size_t from_stride,
+								std::size_t width, std::size_t height)
+{
+	if ((width == 0) || (height == 0)) {
+		return;
+	}
+
+	// Tightly packed planes can be treated as a single long row.
+	if ((to_stride == width) && (from_stride == width)) {
+		width *= height;
+		height = 1;
+	}
+
+	std::size_t total     = width * height;
+	bool        streaming = total >= get_streaming_threshold();
+	if ((total < ST_THREADING_THRESHOLD) || (height < 2)) {
+		copy_rows(to, to_stride, from, from_stride, width, height, streaming);
+		return;
+	}
+
+	std::size_t bands = std::min<std::size_t>(std::max<std::size_t>(std::thread::hardware_concurrency(), 1),
+											  std::min<std::size_t>(total / ST_THREADING_BAND, height));
+	std::size_t rows  = (height + bands - 1) / bands;
+
+	struct join_t {
+		std::mutex              lock;
+		std::condition_variable cv;
+		std::size_t             remaining;
+	} join;
+	join.remaining = (height + rows - 1) / rows;
+
+	auto work = [&](std::size_t row) {
+		copy_rows(to + row * to_stride, to_stride, from + row * from_stride, from_stride, width,
+				  std::min(rows, height - row), streaming);
+
+		std::unique_lock<std::mutex> ul(join.lock);
+		if (--join.remaining == 0) {
+			join.cv.notify_all();
+		}
+	};
+
+	// Hand all but the last band to the thread pool, and copy the last one on this thread. A worker of the pool copies
+	// every band itself, waiting on the others could deadlock once all workers do the same.
+	auto        pool = ::streamfx::threadpool();
+	std::size_t row  = 0;
+	for (; (row + rows) < height; row += rows) {
+		if (pool->is_worker()) {
+			work(row);
+		} else {
+			pool->push([&work, row](::streamfx::util::threadpool_data_t) { work(row); }, nullptr);
+		}
+	}
+	work(row);
+
+	std::unique_lock<std::mutex> ul(join.lock);
+	join.cv.wait(ul, [&join]() { return join.remaining == 0; });
+}
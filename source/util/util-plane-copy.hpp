@@ -0,0 +1,38 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace streamfx::util {
+	/** Copy a two dimensional block of memory, such as a single plane of an image.
+	 *
+	 * Planes larger than the cache are written with streaming stores so that they don't evict it, and very large planes
+	 * are additionally split into bands that are copied on the shared thread pool. Returns once all rows are copied.
+	 *
+	 * @param width Number of bytes to copy per row.
+	 * @param height Number of rows to copy.
+	 */
+	void copy_plane(uint8_t* to, std::size_t to_stride, const uint8_t* from, std::size_t from_stride,
+					std::size_t width, std::size_t height);
+
+	/** Size in bytes from which copy_plane() uses streaming stores, which is the size of the largest CPU cache. */
+	std::size_t get_streaming_threshold();
+} // namespace streamfx::util
@@ -22,6 +22,9 @@
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "util-platform.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
 #include "util-logging.hpp"
 
 #ifdef _DEBUG
@@ -39,8 +42,36 @@
 #endif
 
 #ifdef WIN32
+#include <map>
+#include <set>
 #include <Windows.h>
+#include <TlHelp32.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define ST_ARCH_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define ST_ARCH_ARM64
+#endif
+
+// Nice value of background threads, lower priority than anything OBS itself creates.
+#define ST_BACKGROUND_NICE 5
 
+#ifdef WIN32
 std::string streamfx::util::platform::native_to_utf8(std::wstring const& v)
 {
 	std::vector<char> buffer((v.length() + 1) * 4, 0);
@@ -84,3 +115,391 @@ std::filesystem::path streamfx::util::platform::utf8_to_native(std::filesystem::
 }
 
 #endif
+
+#ifdef WIN32
+namespace {
+	/** Logical processors in the fastest or slowest efficiency class of the first processor group.
+	 *
+	 * @return 0 if all cores share the same efficiency class.
+	 */
+	KAFFINITY find_cores(bool fastest)
+	{
+		DWORD length = 0;
+		GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &length);
+		std::vector<uint8_t> buffer(length);
+		if (!GetLogicalProcessorInformationEx(
+				RelationProcessorCore, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()),
+				&length)) {
+			return 0;
+		}
+
+		std::map<BYTE, KAFFINITY> classes;
+		for (DWORD offset = 0; offset < length;) {
+			auto info = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data() + offset);
+			if ((info->Relationship == RelationProcessorCore) && (info->Processor.GroupMask[0].Group == 0)) {
+				classes[info->Processor.EfficiencyClass] |= info->Processor.GroupMask[0].Mask;
+			}
+			offset += info->Size;
+		}
+		if (classes.size() < 2) {
+			return 0;
+		}
+
+		DWORD_PTR process_mask = 0;
+		DWORD_PTR system_mask  = 0;
+		GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask);
+		return (fastest ? classes.rbegin()->second : classes.begin()->second) & process_mask;
+	}
+
+	void apply_policy(HANDLE thread, streamfx::util::platform::thread_policy policy)
+	{
+		using streamfx::util::platform::thread_policy;
+
+		// The topology doesn't change while OBS runs.
+		static const KAFFINITY fastest = find_cores(true);
+		static const KAFFINITY slowest = find_cores(false);
+
+		switch (policy) {
+		case thread_policy::PERFORMANCE:
+			if (fastest != 0)
+				SetThreadAffinityMask(thread, fastest);
+			break;
+		case thread_policy::BACKGROUND:
+			if (slowest != 0)
+				SetThreadAffinityMask(thread, slowest);
+			// One step below the thread's own priority, so that threads a library runs above or below normal keep
+			// their order among each other. Idle and time critical threads are left alone.
+			if (int priority = GetThreadPriority(thread); (priority != THREAD_PRIORITY_ERROR_RETURN)
+														  && (priority > THREAD_PRIORITY_IDLE)
+														  && (priority < THREAD_PRIORITY_TIME_CRITICAL)) {
+				SetThreadPriority(thread, std::max(priority - 1, static_cast<int>(THREAD_PRIORITY_LOWEST)));
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	std::set<DWORD> enumerate_threads()
+	{
+		std::set<DWORD> threads;
+
+		HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+		if (snapshot == INVALID_HANDLE_VALUE) {
+			return threads;
+		}
+
+		THREADENTRY32 entry = THREADENTRY32();
+		entry.dwSize        = sizeof(THREADENTRY32);
+		DWORD process       = GetCurrentProcessId();
+		for (BOOL valid = Thread32First(snapshot, &entry); valid; valid = Thread32Next(snapshot, &entry)) {
+			if (entry.th32OwnerProcessID == process) {
+				threads.insert(entry.th32ThreadID);
+			}
+		}
+
+		CloseHandle(snapshot);
+		return threads;
+	}
+} // namespace
+
+void streamfx::util::platform::set_thread_policy(thread_policy policy)
+{
+	apply_policy(GetCurrentThread(), policy);
+}
+
+void streamfx::util::platform::with_thread_policy(thread_policy policy, std::function<void()> function)
+{
+	if (policy == thread_policy::DEFAULT) {
+		function();
+		return;
+	}
+
+	// New threads start with the affinity of the process, so find them afterwards instead.
+	auto before = enumerate_threads();
+	function();
+	for (DWORD id : enumerate_threads()) {
+		if (before.count(id) != 0) {
+			continue;
+		}
+		if (HANDLE thread = OpenThread(THREAD_SET_INFORMATION | THREAD_QUERY_INFORMATION, FALSE, id); thread) {
+			apply_policy(thread, policy);
+			CloseHandle(thread);
+		}
+	}
+}
+
+#elif defined(__linux__)
+namespace {
+	/** Logical processors of the fastest or slowest kind of core on Intel hybrid CPUs.
+	 *
+	 * @return false if the CPU only has one kind of core.
+	 */
+	bool find_cores(bool fastest, cpu_set_t& set)
+	{
+		CPU_ZERO(&set);
+
+		// Lists like "0-15,20", only present when there is more than one kind of core.
+		std::ifstream file(fastest ? "/sys/devices/cpu_core/cpus" : "/sys/devices/cpu_atom/cpus");
+		std::string   list;
+		if (!std::getline(file, list)) {
+			return false;
+		}
+
+		std::stringstream ranges(list);
+		for (std::string range; std::getline(ranges, range, ',');) {
+			try {
+				std::size_t split = range.find('-');
+				int         first = std::stoi(range.substr(0, split));
+				int         last  = (split != std::string::npos) ? std::stoi(range.substr(split + 1)) : first;
+				for (int cpu = first; (cpu <= last) && (cpu < CPU_SETSIZE); cpu++) {
+					CPU_SET(cpu, &set);
+				}
+			} catch (const std::exception&) {
+				return false;
+			}
+		}
+		return CPU_COUNT(&set) > 0;
+	}
+
+	/** Whether the nice value of a thread can be lowered back to nice after raising it.
+	 *
+	 * Raising it is always allowed, lowering it again needs CAP_SYS_NICE or a high enough RLIMIT_NICE.
+	 */
+	bool can_restore_nice(int nice)
+	{
+		if (geteuid() == 0) {
+			return true;
+		}
+
+		struct rlimit limit;
+		if (getrlimit(RLIMIT_NICE, &limit) != 0) {
+			return false;
+		}
+		if (limit.rlim_cur == RLIM_INFINITY) {
+			return true;
+		}
+		return (20 - static_cast<int>(limit.rlim_cur)) <= nice;
+	}
+} // namespace
+
+void streamfx::util::platform::set_thread_policy(thread_policy policy)
+{
+	cpu_set_t set;
+	switch (policy) {
+	case thread_policy::PERFORMANCE:
+		if (find_cores(true, set))
+			pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		break;
+	case thread_policy::BACKGROUND:
+		if (find_cores(false, set))
+			pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), ST_BACKGROUND_NICE);
+		break;
+	default:
+		break;
+	}
+}
+
+void streamfx::util::platform::with_thread_policy(thread_policy policy, std::function<void()> function)
+{
+	if (policy == thread_policy::DEFAULT) {
+		function();
+		return;
+	}
+
+	// New threads inherit affinity and priority of the thread creating them, so borrow the calling one.
+	id_t      tid  = static_cast<id_t>(syscall(SYS_gettid));
+	cpu_set_t original;
+	bool      restore_affinity = (pthread_getaffinity_np(pthread_self(), sizeof(original), &original) == 0);
+
+	// getpriority() returns -1 both as a nice value and on failure. A nice value that can't be restored afterwards
+	// would stick to the calling thread, so then only the affinity is changed.
+	errno             = 0;
+	int  nice         = getpriority(PRIO_PROCESS, tid);
+	bool restore_nice = (policy == thread_policy::BACKGROUND) && (errno == 0) && (nice < ST_BACKGROUND_NICE)
+						&& can_restore_nice(nice);
+
+	cpu_set_t set;
+	if (restore_affinity && find_cores(policy == thread_policy::PERFORMANCE, set)) {
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+	if (restore_nice && (setpriority(PRIO_PROCESS, tid, ST_BACKGROUND_NICE) != 0)) {
+		restore_nice = false;
+	}
+
+	auto restore = [&]() {
+		if (restore_affinity) {
+			pthread_setaffinity_np(pthread_self(), sizeof(original), &original);
+		}
+		if (restore_nice && (setpriority(PRIO_PROCESS, tid, nice) != 0)) {
+			D_LOG_WARNING("Failed to restore nice value %d of thread %d.", nice, static_cast<int>(tid));
+		}
+	};
+	try {
+		function();
+	} catch (...) {
+		restore();
+		throw;
+	}
+	restore();
+}
+
+#else
+void streamfx::util::platform::set_thread_policy(thread_policy) {}
+
+void streamfx::util::platform::with_thread_policy(thread_policy, std::function<void()> function)
+{
+	function();
+}
+#endif
+
+namespace {
+#ifdef ST_ARCH_X86
+	void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+	{
+#ifdef _MSC_VER
+		int values[4];
+		__cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+		for (size_t idx = 0; idx < 4; idx++) {
+			regs[idx] = static_cast<uint32_t>(values[idx]);
+		}
+#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+
+	uint64_t xgetbv()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		uint32_t lo, hi;
+		__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+	}
+#endif
+
+	/** Bit mask of every supported extension, indexed by streamfx::util::platform::isa. */
+	uint32_t detect_isa()
+	{
+		using streamfx::util::platform::isa;
+
+		uint32_t mask = 1u << static_cast<uint32_t>(isa::NONE);
+#ifdef ST_ARCH_X86
+		uint32_t regs[4];
+		cpuid(0, 0, regs);
+		uint32_t max_leaf = regs[0];
+		if (max_leaf < 1) {
+			return mask;
+		}
+
+		cpuid(1, 0, regs);
+		bool sse2    = (regs[3] & (1u << 26)) != 0;
+		bool sse41   = (regs[2] & (1u << 19)) != 0;
+		bool fma     = (regs[2] & (1u << 12)) != 0;
+		bool osxsave = (regs[2] & (1u << 27)) != 0;
+		bool avx     = (regs[2] & (1u << 28)) != 0;
+
+		// The operating system also has to save the larger registers on a context switch.
+		uint64_t xcr0      = osxsave ? xgetbv() : 0;
+		bool     os_avx    = (xcr0 & 0x06) == 0x06;
+		bool     os_avx512 = (xcr0 & 0xE6) == 0xE6;
+		bool     avx2      = false;
+		bool     avx512    = false;
+		if (max_leaf >= 7) {
+			cpuid(7, 0, regs);
+			avx2   = (regs[1] & (1u << 5)) != 0;
+			avx512 = ((regs[1] & (1u << 16)) != 0) && ((regs[1] & (1u << 30)) != 0);
+		}
+
+		if (sse2) {
+			mask |= 1u << static_cast<uint32_t>(isa::SSE2);
+		}
+		if (sse2 && sse41) {
+			mask |= 1u << static_cast<uint32_t>(isa::SSE4_1);
+		}
+		if (sse41 && avx && avx2 && fma && os_avx) {
+			mask |= 1u << static_cast<uint32_t>(isa::AVX2);
+			if (avx512 && os_avx512) {
+				mask |= 1u << static_cast<uint32_t>(isa::AVX512);
+			}
+		}
+#elif defined(ST_ARCH_ARM64)
+		mask |= 1u << static_cast<uint32_t>(isa::NEON);
+#endif
+		return mask;
+	}
+
+	uint32_t get_isa_mask()
+	{
+		static const uint32_t mask = detect_isa();
+		return mask;
+	}
+} // namespace
+
+bool streamfx::util::platform::has_isa(isa value)
+{
+	return (get_isa_mask() & (1u << static_cast<uint32_t>(value))) != 0;
+}
+
+streamfx::util::platform::isa streamfx::util::platform::get_isa()
+{
+	for (auto value : {isa::NEON, isa::AVX512, isa::AVX2, isa::SSE4_1, isa::SSE2}) {
+		if (has_isa(value)) {
+			return value;
+		}
+	}
+	return isa::NONE;
+}
+
+const char* streamfx::util::platform::get_isa_name(isa value)
+{
+	switch (value) {
+	case isa::SSE2:
+		return "SSE2";
+	case isa::SSE4_1:
+		return "SSE4.1";
+	case isa::AVX2:
+		return "AVX2";
+	case isa::AVX512:
+		return "AVX-512";
+	case isa::NEON:
+		return "NEON";
+	default:
+		return "None";
+	}
+}
+
+namespace {
+	std::size_t detect_cache_size()
+	{
+		std::size_t size = 0;
+#ifdef WIN32
+		DWORD length = 0;
+		GetLogicalProcessorInformation(nullptr, &length);
+		std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> infos(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+		if (!infos.empty() && GetLogicalProcessorInformation(infos.data(), &length)) {
+			for (auto& info : infos) {
+				if (info.Relationship == RelationCache) {
+					size = std::max<std::size_t>(size, info.Cache.Size);
+				}
+			}
+		}
+#elif defined(__linux__) && defined(_SC_LEVEL3_CACHE_SIZE)
+		for (int name : {_SC_LEVEL3_CACHE_SIZE, _SC_LEVEL2_CACHE_SIZE}) {
+			if (long value = sysconf(name); value > 0) {
+				size = std::max<std::size_t>(size, static_cast<std::size_t>(value));
+			}
+		}
+#endif
+		return size;
+	}
+} // namespace
+
+std::size_t streamfx::util::platform::get_cache_size()
+{
+	static const std::size_t size = detect_cache_size();
+	return size;
+}
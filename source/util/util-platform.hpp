@@ -22,10 +22,104 @@
 // OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
 #include <string>
+#include <utility>
 
 namespace streamfx::util::platform {
+	/** Where threads may run, and how they compete with everything else.
+	 *
+	 * CPUs with only one kind of core, such as those with multiple CCDs, treat all cores as the fastest.
+	 */
+	enum class thread_policy : int32_t {
+		DEFAULT     = 0, // Leave placement and priority to the operating system.
+		PERFORMANCE = 1, // Only run on the fastest cores of hybrid CPUs.
+		BACKGROUND  = 2, // Only run on the slowest cores of hybrid CPUs, at a lower priority than OBS itself.
+	};
+
+	/** Apply a policy to the calling thread. */
+	void set_thread_policy(thread_policy policy);
+
+	/** Run a function and apply a policy to all threads it creates, such as the thread pool of a library. */
+	void with_thread_policy(thread_policy policy, std::function<void()> function);
+
+	/** Instruction set extensions that kernels can be specialized for.
+	 *
+	 * Later entries of the same architecture are preferred over earlier ones. Kernels for anything newer than SSE2
+	 * live in their own translation units named after the extension (e.g. "-avx2.cpp"), which are only compiled with
+	 * the matching compiler flags if ENABLE_SIMD is set.
+	 */
+	enum class isa : int32_t {
+		NONE   = 0, // Portable C++, always available.
+		SSE2   = 1, // Baseline of all x86-64 CPUs.
+		SSE4_1 = 2,
+		AVX2   = 3, // Includes FMA3.
+		AVX512 = 4, // AVX-512 F and BW.
+		NEON   = 5, // Baseline of all ARM64 CPUs.
+	};
+
+	/** Check if both the CPU and the operating system support an extension.
+	 *
+	 * The CPU is only inspected once, on first use.
+	 */
+	bool has_isa(isa value);
+
+	/** The most preferred extension that has_isa() reports. */
+	isa get_isa();
+
+	const char* get_isa_name(isa value);
+
+	/** Size of the largest CPU cache in bytes, or 0 if the operating system does not tell.
+	 *
+	 * The caches are only inspected once, on first use.
+	 */
+	std::size_t get_cache_size();
+
+	/** Table of implementations of a single kernel, resolved to the most preferred supported one on construction.
+	 *
+	 * Kernels declare their table as a static at namespace scope, so that it is resolved once while the plugin loads
+	 * and every call after that is a single indirect call:
+	 *
+	 *   static dispatch<decltype(&sum_c)> sum({{isa::NONE, &sum_c}, {isa::AVX2, &sum_avx2}});
+	 *
+	 * An entry that is nullptr is skipped, which allows tables to list kernels that were not compiled in.
+	 */
+	template<typename T>
+	class dispatch {
+		T   _function;
+		isa _isa;
+
+		public:
+		dispatch(std::initializer_list<std::pair<isa, T>> implementations) : _function(nullptr), _isa(isa::NONE)
+		{
+			for (auto& kv : implementations) {
+				if (kv.second && has_isa(kv.first) && (!_function || (kv.first > _isa))) {
+					_function = kv.second;
+					_isa      = kv.first;
+				}
+			}
+			if (!_function) {
+				throw std::logic_error("No implementation of this kernel supports this CPU.");
+			}
+		}
+
+		template<typename... Args>
+		inline auto operator()(Args&&... args) const
+		{
+			return _function(std::forward<Args>(args)...);
+		}
+
+		inline isa get_isa() const
+		{
+			return _isa;
+		}
+	};
+
 #ifdef WIN32
 	std::string           native_to_utf8(std::wstring const& v);
 	std::filesystem::path native_to_utf8(std::filesystem::path const& v);
@@ -18,130 +18,170 @@
  */
 
 #include "util-profiler.hpp"
-#include <iterator>
+#include <limits>
 
-streamfx::util::profiler::profiler() {}
+std::size_t streamfx::util::profiler::bucket_index(uint64_t value)
+{
+	if (value < sub_bucket_count) {
+		return static_cast<std::size_t>(value);
+	}
 
-streamfx::util::profiler::~profiler() {}
+	// Position of the highest set bit, which selects the power of two.
+	std::size_t msb = 0;
+	for (uint64_t v = value; v > 1; v >>= 1) {
+		msb++;
+	}
 
-std::shared_ptr<streamfx::util::profiler::instance> streamfx::util::profiler::track()
-{
-	return std::make_shared<streamfx::util::profiler::instance>(shared_from_this());
+	std::size_t shift = msb - sub_bucket_bits;
+	return (shift + 1) * sub_bucket_count + static_cast<std::size_t>((value >> shift) - sub_bucket_count);
 }
 
-void streamfx::util::profiler::track(std::chrono::nanoseconds duration)
+uint64_t streamfx::util::profiler::bucket_lower(std::size_t index)
 {
-	std::unique_lock<std::mutex> ul(_timings_lock);
-	auto                         itr = _timings.find(duration);
-	if (itr == _timings.end()) {
-		_timings.emplace(duration, 1u);
-	} else {
-		itr->second++;
+	if (index < sub_bucket_count) {
+		return index;
 	}
+
+	std::size_t shift = index / sub_bucket_count - 1;
+	return static_cast<uint64_t>((index % sub_bucket_count) + sub_bucket_count) << shift;
 }
 
-uint64_t streamfx::util::profiler::count()
+uint64_t streamfx::util::profiler::bucket_upper(std::size_t index)
 {
-	uint64_t count = 0;
-
-	std::map<std::chrono::nanoseconds, size_t> copy_timings;
-	{
-		std::unique_lock<std::mutex> ul(_timings_lock);
-		copy(_timings.begin(), _timings.end(), std::inserter(copy_timings, copy_timings.end()));
-	}
-
-	for (auto kv : copy_timings) {
-		count += kv.second;
+	if (index < sub_bucket_count) {
+		return index;
 	}
 
-	return count;
+	std::size_t shift = index / sub_bucket_count - 1;
+	return bucket_lower(index) + ((uint64_t(1) << shift) - 1);
 }
 
-std::chrono::nanoseconds streamfx::util::profiler::total_duration()
+streamfx::util::profiler::profiler()
+	: _buckets(), _count(0), _total(0), _min(std::numeric_limits<uint64_t>::max()), _max(0)
 {
-	std::chrono::nanoseconds duration{0};
-
-	std::map<std::chrono::nanoseconds, size_t> copy_timings;
-	{
-		std::unique_lock<std::mutex> ul(_timings_lock);
-		copy(_timings.begin(), _timings.end(), std::inserter(copy_timings, copy_timings.end()));
+	for (auto& bucket : _buckets) {
+		bucket.store(0, std::memory_order_relaxed);
 	}
+}
 
-	for (auto kv : copy_timings) {
-		duration += kv.first * kv.second;
-	}
+streamfx::util::profiler::~profiler() {}
 
-	return duration;
+std::shared_ptr<streamfx::util::profiler::instance> streamfx::util::profiler::track()
+{
+	return std::make_shared<streamfx::util::profiler::instance>(shared_from_this());
 }
 
-double_t streamfx::util::profiler::average_duration()
+void streamfx::util::profiler::track(std::chrono::nanoseconds duration)
 {
-	std::chrono::nanoseconds duration{0};
-	uint64_t                 count = 0;
+	uint64_t value = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
 
-	std::map<std::chrono::nanoseconds, size_t> copy_timings;
-	{
-		std::unique_lock<std::mutex> ul(_timings_lock);
-		copy(_timings.begin(), _timings.end(), std::inserter(copy_timings, copy_timings.end()));
-	}
+	_buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+	_count.fetch_add(1, std::memory_order_relaxed);
+	_total.fetch_add(value, std::memory_order_relaxed);
 
-	for (auto kv : copy_timings) {
-		duration += kv.first * kv.second;
-		count += kv.second;
+	for (uint64_t v = _min.load(std::memory_order_relaxed); (value < v) && !_min.compare_exchange_weak(v, value);) {
+	}
+	for (uint64_t v = _max.load(std::memory_order_relaxed); (value > v) && !_max.compare_exchange_weak(v, value);) {
 	}
+}
 
-	return double_t(duration.count()) / double_t(count);
+uint64_t streamfx::util::profiler::count()
+{
+	return _count.load(std::memory_order_relaxed);
 }
 
-template<typename T>
-inline bool is_equal(T a, T b, T c)
+std::chrono::nanoseconds streamfx::util::profiler::total_duration()
 {
-	return (a == b) || ((a >= (b - c)) && (a <= (b + c)));
+	return std::chrono::nanoseconds(static_cast<int64_t>(_total.load(std::memory_order_relaxed)));
 }
 
-std::chrono::nanoseconds streamfx::util::profiler::percentile(double_t percentile, bool by_time)
+double_t streamfx::util::profiler::average_duration()
 {
-	constexpr double_t edge  = 0.00005;
-	uint64_t           calls = count();
+	return double_t(_total.load(std::memory_order_relaxed)) / double_t(_count.load(std::memory_order_relaxed));
+}
 
-	std::map<std::chrono::nanoseconds, size_t> copy_timings;
-	{
-		std::unique_lock<std::mutex> ul(_timings_lock);
-		copy(_timings.begin(), _timings.end(), inserter(copy_timings, copy_timings.end()));
+std::chrono::nanoseconds streamfx::util::profiler::percentile(double_t percentile, bool by_time)
+{
+	// Counters may move while we look at them, so work with a copy of the buckets.
+	std::array<uint64_t, bucket_count> buckets;
+	uint64_t                           calls = 0;
+	for (std::size_t idx = 0; idx < bucket_count; idx++) {
+		buckets[idx] = _buckets[idx].load(std::memory_order_relaxed);
+		calls += buckets[idx];
 	}
+	if (calls == 0) {
+		return std::chrono::nanoseconds(-1);
+	}
+
+	uint64_t smallest = _min.load(std::memory_order_relaxed);
+	uint64_t largest  = _max.load(std::memory_order_relaxed);
+
+	// Buckets are reported by their middle, but never outside of what was actually recorded.
+	auto value_of = [smallest, largest](std::size_t idx) {
+		uint64_t middle = bucket_lower(idx) + (bucket_upper(idx) - bucket_lower(idx)) / 2;
+		return std::chrono::nanoseconds(static_cast<int64_t>(std::clamp(middle, smallest, largest)));
+	};
+
 	if (by_time) { // Return by time percentile.
-		// Find largest and smallest time.
-		std::chrono::nanoseconds smallest = copy_timings.begin()->first;
-		std::chrono::nanoseconds largest  = copy_timings.rbegin()->first;
-		std::chrono::nanoseconds variance = largest - smallest;
-
-		for (auto kv : copy_timings) {
-			double_t kv_pct = double_t((kv.first - smallest).count()) / double_t(variance.count());
-			if (is_equal<double_t>(kv_pct, percentile, edge) || (kv_pct > percentile)) {
-				return std::chrono::nanoseconds(kv.first);
+		double_t threshold = double_t(smallest) + double_t(largest - smallest) * percentile;
+		for (std::size_t idx = 0; idx < bucket_count; idx++) {
+			if ((buckets[idx] > 0) && (double_t(bucket_upper(idx)) >= threshold)) {
+				return value_of(idx);
 			}
 		}
 	} else { // Return by call percentile.
-		if (percentile == 0.0) {
-			return copy_timings.begin()->first;
+		if (percentile <= 0.0) {
+			return std::chrono::nanoseconds(static_cast<int64_t>(smallest));
 		}
 
-		uint64_t accu_calls_now = 0;
-		for (auto kv : copy_timings) {
-			uint64_t accu_calls_last = accu_calls_now;
-			accu_calls_now += kv.second;
+		uint64_t accu_calls = 0;
+		for (std::size_t idx = 0; idx < bucket_count; idx++) {
+			accu_calls += buckets[idx];
+			if ((buckets[idx] > 0) && ((double_t(accu_calls) / double_t(calls)) >= percentile)) {
+				return value_of(idx);
+			}
+		}
+	}
 
-			double_t percentile_last = double_t(accu_calls_last) / double_t(calls);
-			double_t percentile_now  = double_t(accu_calls_now) / double_t(calls);
+	return std::chrono::nanoseconds(static_cast<int64_t>(largest));
+}
 
-			if (is_equal<double_t>(percentile, percentile_now, edge)
-				|| ((percentile_last < percentile) && (percentile_now > percentile))) {
-				return std::chrono::nanoseconds(kv.first);
-			}
+void streamfx::util::profiler::write_csv(std::ostream& stream)
+{
+	stream << "lower_ns,upper_ns,count" << std::endl;
+	for (std::size_t idx = 0; idx < bucket_count; idx++) {
+		if (uint64_t count = _buckets[idx].load(std::memory_order_relaxed); count > 0) {
+			stream << bucket_lower(idx) << "," << bucket_upper(idx) << "," << count << std::endl;
 		}
 	}
+}
 
-	return std::chrono::nanoseconds(-1);
+void streamfx::util::profiler::write_json(std::ostream& stream)
+{
+	uint64_t calls = count();
+
+	stream << "{";
+	stream << "\"count\":" << calls << ",";
+	stream << "\"total_ns\":" << total_duration().count() << ",";
+	if (calls > 0) {
+		stream << "\"min_ns\":" << _min.load(std::memory_order_relaxed) << ",";
+		stream << "\"max_ns\":" << _max.load(std::memory_order_relaxed) << ",";
+		stream << "\"average_ns\":" << average_duration() << ",";
+		stream << "\"p50_ns\":" << percentile(0.5).count() << ",";
+		stream << "\"p95_ns\":" << percentile(0.95).count() << ",";
+		stream << "\"p99_ns\":" << percentile(0.99).count() << ",";
+		stream << "\"p999_ns\":" << percentile(0.999).count() << ",";
+	}
+	stream << "\"buckets\":[";
+	bool first = true;
+	for (std::size_t idx = 0; idx < bucket_count; idx++) {
+		if (uint64_t count = _buckets[idx].load(std::memory_order_relaxed); count > 0) {
+			stream << (first ? "" : ",") << "[" << bucket_lower(idx) << "," << bucket_upper(idx) << "," << count
+				   << "]";
+			first = false;
+		}
+	}
+	stream << "]}";
 }
 
 streamfx::util::profiler::instance::instance(std::shared_ptr<streamfx::util::profiler> parent)
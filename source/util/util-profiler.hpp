@@ -19,14 +19,31 @@
 
 #pragma once
 #include "common.hpp"
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <map>
-#include <mutex>
+#include <ostream>
 
 namespace streamfx::util {
+	/** Timing histogram with log-linear buckets, similar to HdrHistogram.
+	 *
+	 * Every power of two is split into 32 linear buckets, so any recorded duration is known to within about 3%.
+	 * Tracking only increments a few atomic counters, and never locks or allocates, so it is cheap enough to leave on.
+	 */
 	class profiler : public std::enable_shared_from_this<streamfx::util::profiler> {
-		std::map<std::chrono::nanoseconds, size_t> _timings;
-		std::mutex                                 _timings_lock;
+		static constexpr std::size_t sub_bucket_bits  = 5;
+		static constexpr std::size_t sub_bucket_count = std::size_t(1) << sub_bucket_bits;
+		static constexpr std::size_t bucket_count     = (64 - sub_bucket_bits + 1) * sub_bucket_count;
+
+		std::array<std::atomic<uint64_t>, bucket_count> _buckets;
+		std::atomic<uint64_t>                           _count;
+		std::atomic<uint64_t>                           _total; // in nanoseconds
+		std::atomic<uint64_t>                           _min;
+		std::atomic<uint64_t>                           _max;
+
+		static std::size_t bucket_index(uint64_t value);
+		static uint64_t    bucket_lower(std::size_t index);
+		static uint64_t    bucket_upper(std::size_t index);
 
 		public:
 		class instance {
@@ -61,6 +78,14 @@ namespace streamfx::util {
 
 		std::chrono::nanoseconds percentile(double_t percentile, bool by_time = false);
 
+		/** Write all non-empty buckets as CSV, with the columns "lower_ns,upper_ns,count".
+		 */
+		void write_csv(std::ostream& stream);
+
+		/** Write a summary and all non-empty buckets as a single JSON object.
+		 */
+		void write_json(std::ostream& stream);
+
 		public:
 		static std::shared_ptr<streamfx::util::profiler> create()
 		{
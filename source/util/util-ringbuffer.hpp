@@ -0,0 +1,222 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace streamfx::util {
+	/** Bounded single-producer single-consumer ring buffer.
+	 *
+	 * Exactly one thread may call push() and exactly one other thread may call pop(). Neither side
+	 * ever blocks or allocates, a full or empty ring is reported through the return value instead.
+	 */
+	template<typename T>
+	class ringbuffer {
+		std::vector<T>           _buffer;
+		std::size_t              _mask;
+		std::atomic<std::size_t> _head; // Written by the producer.
+		std::atomic<std::size_t> _tail; // Written by the consumer.
+
+		public:
+		ringbuffer(std::size_t capacity) : _buffer(), _mask(0), _head(0), _tail(0)
+		{
+			if (capacity == 0) {
+				throw std::invalid_argument("capacity must be larger than 0");
+			}
+
+			// Round up to the next power of two so that indices can be masked instead of divided.
+			std::size_t size = 1;
+			while (size < capacity) {
+				size <<= 1;
+			}
+			_buffer.resize(size);
+			_mask = size - 1;
+		}
+		~ringbuffer() {}
+
+		ringbuffer(const ringbuffer<T>&) = delete;
+		ringbuffer<T>& operator=(const ringbuffer<T>&) = delete;
+
+		/** Try to append an element.
+		 * @return true if the element was stored, false if the ring is full.
+		 */
+		bool push(T value)
+		{
+			std::size_t head = _head.load(std::memory_order_relaxed);
+			if ((head - _tail.load(std::memory_order_acquire)) > _mask) {
+				return false;
+			}
+
+			_buffer[head & _mask] = std::move(value);
+			_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		/** Try to remove the oldest element.
+		 * @return true if an element was stored into value, false if the ring is empty.
+		 */
+		bool pop(T& value)
+		{
+			std::size_t tail = _tail.load(std::memory_order_relaxed);
+			if (tail == _head.load(std::memory_order_acquire)) {
+				return false;
+			}
+
+			value                 = std::move(_buffer[tail & _mask]);
+			_buffer[tail & _mask] = T();
+			_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		std::size_t size()
+		{
+			return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+		}
+
+		std::size_t capacity()
+		{
+			return _mask + 1;
+		}
+
+		bool empty()
+		{
+			return size() == 0;
+		}
+	};
+
+	/** Bounded multi-producer multi-consumer ring buffer.
+	 *
+	 * Any number of threads may call push() and pop() at the same time. Every element carries a sequence number that
+	 * tells whether it is free to write or ready to read, so neither side ever takes a lock or allocates.
+	 */
+	template<typename T>
+	class mpmc_ringbuffer {
+		struct cell {
+			std::atomic<std::size_t> sequence;
+			T                        value;
+		};
+
+		std::unique_ptr<cell[]>              _buffer;
+		std::size_t                          _mask;
+		alignas(64) std::atomic<std::size_t> _head; // Claimed by producers.
+		alignas(64) std::atomic<std::size_t> _tail; // Claimed by consumers.
+
+		public:
+		mpmc_ringbuffer(std::size_t capacity) : _buffer(), _mask(0), _head(0), _tail(0)
+		{
+			if (capacity == 0) {
+				throw std::invalid_argument("capacity must be larger than 0");
+			}
+
+			// Round up to the next power of two so that indices can be masked instead of divided.
+			std::size_t size = 1;
+			while (size < capacity) {
+				size <<= 1;
+			}
+			_buffer.reset(new cell[size]);
+			_mask = size - 1;
+			for (std::size_t idx = 0; idx < size; idx++) {
+				_buffer[idx].sequence.store(idx, std::memory_order_relaxed);
+			}
+		}
+		~mpmc_ringbuffer() {}
+
+		mpmc_ringbuffer(const mpmc_ringbuffer<T>&) = delete;
+		mpmc_ringbuffer<T>& operator=(const mpmc_ringbuffer<T>&) = delete;
+
+		/** Try to append an element.
+		 * @return true if the element was stored, false if the ring is full.
+		 */
+		bool push(T value)
+		{
+			cell*       slot;
+			std::size_t head = _head.load(std::memory_order_relaxed);
+			while (true) {
+				slot          = &_buffer[head & _mask];
+				intptr_t diff = static_cast<intptr_t>(slot->sequence.load(std::memory_order_acquire))
+								- static_cast<intptr_t>(head);
+				if (diff == 0) {
+					if (_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				} else if (diff < 0) {
+					return false;
+				} else {
+					head = _head.load(std::memory_order_relaxed);
+				}
+			}
+
+			slot->value = std::move(value);
+			slot->sequence.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		/** Try to remove the oldest element.
+		 * @return true if an element was stored into value, false if the ring is empty.
+		 */
+		bool pop(T& value)
+		{
+			cell*       slot;
+			std::size_t tail = _tail.load(std::memory_order_relaxed);
+			while (true) {
+				slot          = &_buffer[tail & _mask];
+				intptr_t diff = static_cast<intptr_t>(slot->sequence.load(std::memory_order_acquire))
+								- static_cast<intptr_t>(tail + 1);
+				if (diff == 0) {
+					if (_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				} else if (diff < 0) {
+					return false;
+				} else {
+					tail = _tail.load(std::memory_order_relaxed);
+				}
+			}
+
+			value       = std::move(slot->value);
+			slot->value = T();
+			slot->sequence.store(tail + _mask + 1, std::memory_order_release);
+			return true;
+		}
+
+		/** Number of elements, which may already be outdated by the time it is returned. */
+		std::size_t size()
+		{
+			std::size_t tail = _tail.load(std::memory_order_acquire);
+			std::size_t head = _head.load(std::memory_order_acquire);
+			return (head > tail) ? (head - tail) : 0;
+		}
+
+		std::size_t capacity()
+		{
+			return _mask + 1;
+		}
+
+		bool empty()
+		{
+			return size() == 0;
+		}
+	};
+} // namespace streamfx::util
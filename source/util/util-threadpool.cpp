@@ -20,43 +20,104 @@
 #include "util-threadpool.hpp"
 #include "common.hpp"
 #include <cstddef>
+#include "util-trace.hpp"
 
 #define ST_PREFIX "<util::threadpool> "
 
 // Most Tasks likely wait for IO, so we can use that time for other tasks.
 #define ST_CONCURRENCY_MULTIPLIER 2
 
-streamfx::util::threadpool::threadpool()
-	: _workers(), _worker_stop(false), _worker_idx(0), _tasks(), _tasks_lock(), _tasks_cv()
+// Upper limit of finished tasks kept around for reuse.
+#define ST_POOL_SIZE 256
+
+namespace {
+	// Lets push() from inside a task queue onto the worker that runs it.
+	thread_local streamfx::util::threadpool* tl_pool  = nullptr;
+	thread_local std::size_t                 tl_index = 0;
+} // namespace
+
+streamfx::util::threadpool::threadpool(::streamfx::util::platform::thread_policy policy)
+	: _workers(), _worker_stop(false), _worker_idx(0), _queues(), _queue_next(0), _tasks_pending(0), _tasks_lock(),
+	  _tasks_cv(), _pool(), _pool_lock(), _policy(policy)
 {
 	std::size_t concurrency = static_cast<size_t>(std::thread::hardware_concurrency() * ST_CONCURRENCY_MULTIPLIER);
+	concurrency             = std::max<std::size_t>(concurrency, 1);
 	for (std::size_t n = 0; n < concurrency; n++) {
-		_workers.emplace_back(std::bind(&streamfx::util::threadpool::work, this));
+		_queues.emplace_back(std::make_unique<worker_queue>());
+	}
+	for (std::size_t n = 0; n < concurrency; n++) {
+		_workers.emplace_back(std::bind(&streamfx::util::threadpool::work, this, n));
 	}
 }
 
 streamfx::util::threadpool::~threadpool()
 {
-	_worker_stop = true;
-	_tasks_cv.notify_all();
-	for (auto& thread : _workers) {
+	{
+		std::unique_lock<std::mutex> lock(_tasks_lock);
+		_worker_stop = true;
 		_tasks_cv.notify_all();
+	}
+	for (auto& thread : _workers) {
 		if (thread.joinable()) {
 			thread.join();
 		}
 	}
 }
 
-std::shared_ptr<::streamfx::util::threadpool::task> streamfx::util::threadpool::push(threadpool_callback_t fn,
-																					 threadpool_data_t     data)
+std::shared_ptr<::streamfx::util::threadpool::task>
+	streamfx::util::threadpool::push(threadpool_callback_t fn, threadpool_data_t data, priority prio)
+{
+	auto task = allocate(fn, data, prio);
+	enqueue(task);
+	return task;
+}
+
+void streamfx::util::threadpool::enqueue(std::shared_ptr<::streamfx::util::threadpool::task> task)
 {
-	auto task = std::make_shared<streamfx::util::threadpool::task>(fn, data);
+	// Work queued by a task stays on the same worker, which likely still has the data it needs in cache.
+	std::size_t index = (tl_pool == this) ? tl_index : (_queue_next.fetch_add(1) % _queues.size());
+	{
+		auto&                        queue = *_queues[index];
+		std::unique_lock<std::mutex> lock(queue.lock);
+		queue.tasks[static_cast<std::size_t>(task->_priority)].emplace_back(std::move(task));
 
-	std::unique_lock<std::mutex> lock(_tasks_lock);
-	_tasks.emplace_back(task);
-	_tasks_cv.notify_one();
+		// Counted under the queue lock, so that take() can never count a task before it was counted here.
+		_tasks_pending.fetch_add(1);
+	}
 
-	return task;
+	{
+		std::unique_lock<std::mutex> lock(_tasks_lock);
+		_tasks_cv.notify_one();
+	}
+}
+
+void streamfx::util::threadpool::execute(::streamfx::util::threadpool::task& work)
+{
+	// Try to execute work, but don't crash on catchable exceptions.
+	if (!work._is_dead && work._callback) {
+		streamfx::util::trace::scope zone{"threadpool_task"};
+		try {
+			work._callback(work._data);
+		} catch (std::exception const& ex) {
+			DLOG_WARNING(ST_PREFIX "Caught exception from task (%" PRIxPTR ", %" PRIxPTR ") with message: %s",
+						 reinterpret_cast<ptrdiff_t>(work._callback.target<void>()),
+						 reinterpret_cast<ptrdiff_t>(work._data.get()), ex.what());
+		} catch (...) {
+			DLOG_WARNING(ST_PREFIX "Caught exception of unknown type from task (%" PRIxPTR ", %" PRIxPTR ").",
+						 reinterpret_cast<ptrdiff_t>(work._callback.target<void>()),
+						 reinterpret_cast<ptrdiff_t>(work._data.get()));
+		}
+	}
+
+	// Even a skipped task completes, so that its continuations learn about it.
+	work.complete();
+}
+
+void streamfx::util::threadpool::execute_graphics(void* param)
+{
+	auto work = reinterpret_cast<std::shared_ptr<::streamfx::util::threadpool::task>*>(param);
+	execute(**work);
+	delete work;
 }
 
 void streamfx::util::threadpool::pop(std::shared_ptr<::streamfx::util::threadpool::task> work)
@@ -66,64 +127,160 @@ void streamfx::util::threadpool::pop(std::shared_ptr<::streamfx::util::threadpoo
 	}
 }
 
-void streamfx::util::threadpool::work()
+bool streamfx::util::threadpool::is_worker()
 {
-	std::shared_ptr<streamfx::util::threadpool::task> local_work{};
-	uint32_t                                          local_number = _worker_idx.fetch_add(1);
-
-	while (!_worker_stop) {
-		// Wait for more work, or immediately continue if there is still work to do.
-		{
-			// Lock the tasks mutex to check for work.
-			std::unique_lock<std::mutex> lock(_tasks_lock);
+	return tl_pool == this;
+}
 
-			// If there are currently no tasks queued, wait on the condition variable.
-			// This temporarily unlocks the mutex until it is woken up.
-			if (_tasks.size() == 0) {
-				_tasks_cv.wait(lock, [this]() { return _worker_stop || _tasks.size() > 0; });
+bool streamfx::util::threadpool::take(std::size_t index, std::shared_ptr<::streamfx::util::threadpool::task>& work)
+{
+	// All high priority work anywhere goes before any normal priority work.
+	for (std::size_t prio = 0; prio < 2; prio++) {
+		for (std::size_t offset = 0; offset < _queues.size(); offset++) {
+			auto&                        queue = *_queues[(index + offset) % _queues.size()];
+			std::unique_lock<std::mutex> lock(queue.lock);
+			if (!queue.tasks[prio].empty()) {
+				work = std::move(queue.tasks[prio].front());
+				queue.tasks[prio].pop_front();
+				_tasks_pending.fetch_sub(1);
+				return true;
 			}
+		}
+	}
+	return false;
+}
 
-			// If there is either no tasks or we were asked to stop, skip everything.
-			if (_worker_stop || (_tasks.size() == 0)) {
-				continue;
-			}
+std::shared_ptr<::streamfx::util::threadpool::task>
+	streamfx::util::threadpool::allocate(threadpool_callback_t fn, threadpool_data_t data, priority prio)
+{
+	{
+		std::unique_lock<std::mutex> lock(_pool_lock);
+		if (!_pool.empty()) {
+			auto task = std::move(_pool.back());
+			_pool.pop_back();
+			lock.unlock();
 
-			// Grab the latest task and immediately remove it from the queue.
-			local_work = _tasks.front();
-			_tasks.pop_front();
+			task->_is_dead.store(false);
+			task->_callback = std::move(fn);
+			task->_data     = std::move(data);
+			task->_pool     = this;
+			task->_priority = prio;
+			task->_is_done  = false;
+			return task;
 		}
+	}
 
-		// If the task was killed, skip everything again.
-		if (local_work->_is_dead) {
-			continue;
+	auto task       = std::make_shared<streamfx::util::threadpool::task>(fn, data);
+	task->_pool     = this;
+	task->_priority = prio;
+	return task;
+}
+
+void streamfx::util::threadpool::recycle(std::shared_ptr<::streamfx::util::threadpool::task>& work)
+{
+	// Only reuse tasks that nobody else refers to, as callers may still check or pop the ones they hold.
+	if (work.use_count() == 1) {
+		work->_callback = nullptr;
+		work->_data.reset();
+
+		std::unique_lock<std::mutex> lock(_pool_lock);
+		if (_pool.size() < ST_POOL_SIZE) {
+			_pool.emplace_back(std::move(work));
 		}
+	}
+	work.reset();
+}
 
-		// Try to execute work, but don't crash on catchable exceptions.
-		if (local_work->_callback) {
-			try {
-				local_work->_callback(local_work->_data);
-			} catch (std::exception const& ex) {
-				DLOG_WARNING(ST_PREFIX "Worker %" PRIx32 " caught exception from task (%" PRIxPTR ", %" PRIxPTR
-									   ") with message: %s",
-							 local_number, reinterpret_cast<ptrdiff_t>(local_work->_callback.target<void>()),
-							 reinterpret_cast<ptrdiff_t>(local_work->_data.get()), ex.what());
-			} catch (...) {
-				DLOG_WARNING(ST_PREFIX "Worker %" PRIx32 " caught exception of unknown type from task (%" PRIxPTR
-									   ", %" PRIxPTR ").",
-							 local_number, reinterpret_cast<ptrdiff_t>(local_work->_callback.target<void>()),
-							 reinterpret_cast<ptrdiff_t>(local_work->_data.get()));
-			}
+void streamfx::util::threadpool::work(std::size_t index)
+{
+	std::shared_ptr<streamfx::util::threadpool::task> local_work{};
+	_worker_idx.fetch_add(1);
+
+	tl_pool  = this;
+	tl_index = index;
+	::streamfx::util::platform::set_thread_policy(_policy);
+
+	while (!_worker_stop) {
+		// Wait for more work, or immediately continue if there is still work to do.
+		if (!take(index, local_work)) {
+			std::unique_lock<std::mutex> lock(_tasks_lock);
+			_tasks_cv.wait(lock, [this]() { return _worker_stop || (_tasks_pending.load() > 0); });
+			continue;
 		}
 
-		// Remove our reference to the work unit.
-		local_work.reset();
+		execute(*local_work);
+
+		// Remove our reference to the work unit, keeping it for reuse if possible.
+		recycle(local_work);
 	}
 
+	tl_pool = nullptr;
 	_worker_idx.fetch_sub(1);
 }
 
-streamfx::util::threadpool::task::task() {}
+streamfx::util::threadpool::task::task()
+	: _is_dead(false), _callback(), _data(), _pool(nullptr), _priority(priority::Normal), _lock(), _is_done(false),
+	  _continuations()
+{}
 
 streamfx::util::threadpool::task::task(threadpool_callback_t fn, threadpool_data_t dt)
-	: _is_dead(false), _callback(fn), _data(dt)
+	: _is_dead(false), _callback(fn), _data(dt), _pool(nullptr), _priority(priority::Normal), _lock(),
+	  _is_done(false), _continuations()
 {}
+
+bool streamfx::util::threadpool::task::is_done()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	return _is_done;
+}
+
+std::shared_ptr<::streamfx::util::threadpool::task>
+	streamfx::util::threadpool::task::then(threadpool_callback_t fn, resume where)
+{
+	if (!_pool) {
+		throw std::logic_error("task was not created by a threadpool");
+	}
+
+	auto next = _pool->allocate(fn, _data, _priority);
+
+	{
+		std::unique_lock<std::mutex> lock(_lock);
+		if (!_is_done) {
+			_continuations.emplace_back(next, where);
+			return next;
+		}
+	}
+
+	// Already done, so continue right away.
+	if (_is_dead) {
+		next->_is_dead.store(true);
+	}
+	if (where == resume::Graphics) {
+		obs_queue_task(OBS_TASK_GRAPHICS, &threadpool::execute_graphics, new std::shared_ptr<task>(next), false);
+	} else {
+		_pool->enqueue(next);
+	}
+	return next;
+}
+
+void streamfx::util::threadpool::task::complete()
+{
+	decltype(_continuations) continuations;
+	{
+		std::unique_lock<std::mutex> lock(_lock);
+		_is_done = true;
+		continuations.swap(_continuations);
+	}
+
+	for (auto& kv : continuations) {
+		if (_is_dead) {
+			kv.first->_is_dead.store(true);
+		}
+		if (kv.second == resume::Graphics) {
+			obs_queue_task(OBS_TASK_GRAPHICS, &threadpool::execute_graphics, new std::shared_ptr<task>(kv.first),
+						   false);
+		} else {
+			_pool->enqueue(kv.first);
+		}
+	}
+}
@@ -20,12 +20,15 @@
 #pragma once
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
 #include <thread>
+#include <vector>
+#include "util-platform.hpp"
 
 namespace streamfx::util {
 	typedef std::shared_ptr<void>                  threadpool_data_t;
@@ -33,37 +36,102 @@ namespace streamfx::util {
 
 	class threadpool {
 		public:
+		enum class priority {
+			High,   // Latency critical work, such as tracking or audio analysis.
+			Normal, // Everything else, such as file loading or network requests.
+		};
+
+		enum class resume {
+			Pool,     // Continue on any worker of the pool.
+			Graphics, // Continue on the graphics thread, between two frames.
+		};
+
 		class task {
 			protected:
 			std::atomic_bool      _is_dead;
 			threadpool_callback_t _callback;
 			threadpool_data_t     _data;
 
+			// Completion
+			threadpool*                                           _pool;
+			priority                                              _priority;
+			std::mutex                                            _lock;
+			bool                                                  _is_done;
+			std::vector<std::pair<std::shared_ptr<task>, resume>> _continuations;
+
+			void complete();
+
 			public:
 			task();
 			task(threadpool_callback_t callback_function, threadpool_data_t data);
 
+			/** Check if the task has either run or was skipped because it was popped.
+			 */
+			bool is_done();
+
+			/** Run another callback once this task is done, with the same data.
+			 *
+			 * The data doubles as the result, whatever this task stores in it is visible to the continuation. Popping a
+			 * task before it runs also drops all of its continuations.
+			 *
+			 * @param where Where the continuation runs.
+			 * @return The continuation, which can be popped or continued itself.
+			 */
+			std::shared_ptr<task> then(threadpool_callback_t callback_function, resume where = resume::Pool);
+
 			friend class streamfx::util::threadpool;
 		};
 
 		private:
-		std::list<std::thread>                                         _workers;
-		std::atomic_bool                                               _worker_stop;
-		std::atomic<uint32_t>                                          _worker_idx;
-		std::list<std::shared_ptr<::streamfx::util::threadpool::task>> _tasks;
-		std::mutex                                                     _tasks_lock;
-		std::condition_variable                                        _tasks_cv;
+		// Every worker owns one queue per priority, and steals from the others when its own are empty.
+		struct worker_queue {
+			std::mutex                                                      lock;
+			std::deque<std::shared_ptr<::streamfx::util::threadpool::task>> tasks[2];
+		};
+
+		std::list<std::thread>                                           _workers;
+		std::atomic_bool                                                 _worker_stop;
+		std::atomic<uint32_t>                                            _worker_idx;
+		std::vector<std::unique_ptr<worker_queue>>                       _queues;
+		std::atomic<std::size_t>                                         _queue_next; // For pushes from other threads.
+		std::atomic<std::size_t>                                         _tasks_pending;
+		std::mutex                                                       _tasks_lock; // Only used for sleeping.
+		std::condition_variable                                          _tasks_cv;
+		std::vector<std::shared_ptr<::streamfx::util::threadpool::task>> _pool; // Finished tasks nobody refers to.
+		std::mutex                                                       _pool_lock;
+		::streamfx::util::platform::thread_policy                        _policy;
 
 		public:
-		threadpool();
+		threadpool(::streamfx::util::platform::thread_policy policy =
+					   ::streamfx::util::platform::thread_policy::DEFAULT);
 		~threadpool();
 
-		std::shared_ptr<::streamfx::util::threadpool::task> push(threadpool_callback_t callback_function,
-																 threadpool_data_t     data);
+		std::shared_ptr<::streamfx::util::threadpool::task>
+			push(threadpool_callback_t callback_function, threadpool_data_t data, priority prio = priority::Normal);
 
 		void pop(std::shared_ptr<::streamfx::util::threadpool::task> work);
 
+		/** Check if the calling thread is one of the workers of this pool.
+		 *
+		 * A worker that waits for tasks it pushed has to run them itself instead, as every other worker may be busy
+		 * doing the same.
+		 */
+		bool is_worker();
+
 		private:
-		void work();
+		void work(std::size_t index);
+
+		void enqueue(std::shared_ptr<::streamfx::util::threadpool::task> work);
+
+		static void execute(::streamfx::util::threadpool::task& work);
+
+		static void execute_graphics(void* param);
+
+		bool take(std::size_t index, std::shared_ptr<::streamfx::util::threadpool::task>& work);
+
+		std::shared_ptr<::streamfx::util::threadpool::task> allocate(threadpool_callback_t fn, threadpool_data_t data,
+																	 priority prio);
+
+		void recycle(std::shared_ptr<::streamfx::util::threadpool::task>& work);
 	};
 } // namespace streamfx::util
@@ -0,0 +1,285 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "util-trace.hpp"
+#include <fstream>
+#include <map>
+#include "plugin.hpp"
+#include "util-threadpool.hpp"
+
+#define ST_PREFIX "<util::trace> "
+
+// Events every thread can hold between two drains, which happen once per frame.
+#define ST_BUFFER_SIZE 16384
+
+static std::shared_ptr<streamfx::util::trace> _trace_instance;
+
+std::atomic_bool     streamfx::util::trace::_capturing{false};
+std::atomic<int64_t> streamfx::util::trace::_origin{0};
+
+static int64_t to_nanoseconds(std::chrono::high_resolution_clock::time_point value)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(value.time_since_epoch()).count();
+}
+
+static void write_escaped(std::ostream& stream, const std::string& value)
+{
+	stream << '"';
+	for (char chr : value) {
+		switch (chr) {
+		case '"':
+			stream << "\\\"";
+			break;
+		case '\\':
+			stream << "\\\\";
+			break;
+		default:
+			if (static_cast<unsigned char>(chr) < 0x20) {
+				stream << ' '; // Control characters have no business in a name.
+			} else {
+				stream << chr;
+			}
+			break;
+		}
+	}
+	stream << '"';
+}
+
+streamfx::util::trace::thread_buffer::thread_buffer(uint32_t index) : index(index), events(ST_BUFFER_SIZE), dropped(0)
+{}
+
+streamfx::util::trace::trace() : _lock(), _buffers(), _events(), _file(), _resolver(), _end(), _names_lock(), _names()
+{
+	obs_add_tick_callback(tick, this);
+}
+
+streamfx::util::trace::~trace()
+{
+	obs_remove_tick_callback(tick, this);
+	_capturing.store(false);
+}
+
+std::shared_ptr<streamfx::util::trace::thread_buffer> streamfx::util::trace::buffer()
+{
+	// The owner changes if the plugin is reloaded while the thread stays around.
+	thread_local trace*                          local_owner = nullptr;
+	thread_local std::shared_ptr<thread_buffer> local_buffer;
+	if ((local_owner != this) || !local_buffer) {
+		std::unique_lock<std::mutex> lock(_lock);
+		local_buffer = std::make_shared<thread_buffer>(static_cast<uint32_t>(_buffers.size() + 1));
+		local_owner  = this;
+		_buffers.push_back(local_buffer);
+	}
+	return local_buffer;
+}
+
+void streamfx::util::trace::drain()
+{
+	for (auto& buffer : _buffers) {
+		event ev;
+		while (buffer->events.pop(ev)) {
+			if (ev.track == 0)
+				ev.track = buffer->index;
+			_events.push_back(ev);
+		}
+	}
+}
+
+void streamfx::util::trace::finish()
+{
+	_capturing.store(false);
+	drain();
+
+	uint64_t dropped = 0;
+	for (auto& buffer : _buffers) {
+		dropped += buffer->dropped.exchange(0);
+	}
+
+	// Objects are named now, as some of them may be gone by the time the file is written.
+	auto                  events = std::make_shared<std::vector<event>>(std::move(_events));
+	auto                  names  = std::make_shared<std::map<uint64_t, std::string>>();
+	std::filesystem::path file   = _file;
+	std::vector<uint32_t> tracks;
+	for (auto& ev : *events) {
+		if (_resolver && ev.object && (names->count(ev.object) == 0))
+			names->emplace(ev.object, _resolver(ev.object));
+	}
+	for (auto& buffer : _buffers) {
+		tracks.push_back(buffer->index);
+	}
+	_events   = {};
+	_resolver = nullptr;
+
+	DLOG_INFO(ST_PREFIX "Captured %zu events, %" PRIu64 " were dropped.", events->size(), dropped);
+
+	auto pool = streamfx::threadpool();
+	if (!pool)
+		return;
+
+	pool->push(
+		[events, names, file, tracks](streamfx::util::threadpool_data_t) {
+			std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+			if (!stream) {
+				DLOG_ERROR(ST_PREFIX "Failed to open '%s' for writing.", file.u8string().c_str());
+				return;
+			}
+
+			stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+			stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << gpu_track
+				   << ",\"args\":{\"name\":\"GPU\"}}";
+			for (auto track : tracks) {
+				stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track
+					   << ",\"args\":{\"name\":\"StreamFX Thread " << track << "\"}}";
+			}
+
+			// Timestamps are in microseconds, with the nanoseconds kept as fraction.
+			stream.setf(std::ios::fixed);
+			stream.precision(3);
+			for (auto& ev : *events) {
+				std::string name = ev.name ? ev.name : "";
+				if (auto iter = names->find(ev.object); (iter != names->end()) && !iter->second.empty())
+					name = iter->second + ": " + name;
+
+				stream << ",\n{\"name\":";
+				write_escaped(stream, name);
+				stream << ",\"cat\":\"" << ((ev.track == gpu_track) ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"ts\":"
+					   << (static_cast<double_t>(ev.start) / 1000.)
+					   << ",\"dur\":" << (static_cast<double_t>(ev.duration) / 1000.) << ",\"pid\":1,\"tid\":"
+					   << ev.track << "}";
+			}
+			stream << "\n]}\n";
+
+			DLOG_INFO(ST_PREFIX "Wrote trace to '%s'.", file.u8string().c_str());
+		},
+		nullptr);
+}
+
+void streamfx::util::trace::tick(void* ptr, float_t) noexcept
+try {
+	auto self = reinterpret_cast<trace*>(ptr);
+	if (!is_capturing())
+		return;
+
+	std::unique_lock<std::mutex> lock(self->_lock);
+	if (!_capturing.load()) // Stopped while waiting for the lock.
+		return;
+
+	self->drain();
+	if (std::chrono::high_resolution_clock::now() >= self->_end)
+		self->finish();
+} catch (const std::exception& ex) {
+	DLOG_ERROR("Unexpected exception in function '%s': %s.", __FUNCTION_NAME__, ex.what());
+} catch (...) {
+	DLOG_ERROR("Unexpected exception in function '%s'.", __FUNCTION_NAME__);
+}
+
+bool streamfx::util::trace::start(std::filesystem::path file, std::chrono::milliseconds length, resolver_t resolver)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	if (_capturing.load())
+		return false;
+
+	// Whatever was recorded between two captures is stale by now.
+	for (auto& buffer : _buffers) {
+		event ev;
+		while (buffer->events.pop(ev)) {
+		}
+		buffer->dropped.store(0);
+	}
+
+	auto now  = std::chrono::high_resolution_clock::now();
+	_file     = file;
+	_resolver = resolver;
+	_end      = now + length;
+	_events.clear();
+	_origin.store(to_nanoseconds(now));
+	_capturing.store(true);
+
+	DLOG_INFO(ST_PREFIX "Capturing a trace for %" PRId64 "ms into '%s'.", static_cast<int64_t>(length.count()),
+			   file.u8string().c_str());
+	return true;
+}
+
+void streamfx::util::trace::stop()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	if (_capturing.load())
+		finish();
+}
+
+const char* streamfx::util::trace::intern(const std::string& name)
+{
+	std::unique_lock<std::mutex> lock(_names_lock);
+	return _names.insert(name).first->c_str();
+}
+
+void streamfx::util::trace::record(const char* name, uint64_t object,
+								   std::chrono::high_resolution_clock::time_point start,
+								   std::chrono::nanoseconds duration, uint32_t track)
+{
+	if (!is_capturing())
+		return;
+
+	auto self = _trace_instance.get();
+	if (!self)
+		return;
+
+	event ev;
+	ev.name     = name;
+	ev.object   = object;
+	ev.start    = to_nanoseconds(start) - _origin.load(std::memory_order_relaxed);
+	ev.duration = duration.count();
+	ev.track    = track;
+	if (ev.start < 0) // Began before the capture did.
+		return;
+
+	auto buffer = self->buffer();
+	if (!buffer->events.push(ev))
+		buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+streamfx::util::trace::scope::scope(const char* name, uint64_t object)
+	: _name(name), _object(object), _active(is_capturing()), _start()
+{
+	if (_active)
+		_start = std::chrono::high_resolution_clock::now();
+}
+
+streamfx::util::trace::scope::~scope()
+{
+	if (_active)
+		record(_name, _object, _start, std::chrono::high_resolution_clock::now() - _start);
+}
+
+void streamfx::util::trace::initialize()
+{
+	_trace_instance = std::make_shared<streamfx::util::trace>();
+}
+
+void streamfx::util::trace::finalize()
+{
+	if (_trace_instance)
+		_trace_instance->stop();
+	_trace_instance.reset();
+}
+
+std::shared_ptr<streamfx::util::trace> streamfx::util::trace::get()
+{
+	return _trace_instance;
+}
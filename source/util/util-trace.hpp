@@ -0,0 +1,137 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2022 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "util-ringbuffer.hpp"
+
+namespace streamfx::util {
+	/** Records timed zones into a trace-event JSON file for chrome://tracing or Perfetto.
+	 *
+	 * Every thread records into its own single-producer ring, which is created the first time that thread records
+	 * something during a capture. The rings are drained once per frame, and the file is written on the thread pool
+	 * after the capture ends, so recording itself only costs a clock read and a few stores. When a thread outpaces
+	 * the drain, its events are dropped and counted instead.
+	 *
+	 * All names must live at least until the capture is written, use intern() for anything that is not a literal.
+	 */
+	class trace {
+		public:
+		static constexpr uint32_t gpu_track = 0xFFFFFFFFu; // Zones measured on the GPU instead of a thread.
+
+		/** Turns the object of an event into a readable name, or an empty string if it is unknown. */
+		typedef std::function<std::string(uint64_t object)> resolver_t;
+
+		struct event {
+			const char* name     = nullptr;
+			uint64_t    object   = 0; // Statistics of the instance this belongs to, 0 if none.
+			int64_t     start    = 0; // In nanoseconds since the capture started.
+			int64_t     duration = 0; // In nanoseconds.
+			uint32_t    track    = 0; // Index of the recording thread, or gpu_track.
+		};
+
+		private:
+		struct thread_buffer {
+			uint32_t                index;
+			util::ringbuffer<event> events;
+			std::atomic<uint64_t>   dropped;
+
+			thread_buffer(uint32_t index);
+		};
+
+		// Producers only take the lock the first time they record something.
+		std::mutex                                     _lock;
+		std::vector<std::shared_ptr<thread_buffer>>    _buffers;
+		std::vector<event>                             _events;
+		std::filesystem::path                          _file;
+		resolver_t                                     _resolver;
+		std::chrono::high_resolution_clock::time_point _end;
+
+		std::mutex            _names_lock;
+		std::set<std::string> _names;
+
+		static std::atomic_bool     _capturing;
+		static std::atomic<int64_t> _origin; // high_resolution_clock in nanoseconds.
+
+		std::shared_ptr<thread_buffer> buffer();
+
+		void drain();
+
+		void finish();
+
+		static void tick(void* ptr, float_t seconds) noexcept;
+
+		public:
+		trace();
+		~trace();
+
+		/** Start capturing for the given length, unless a capture is already running.
+		 * @param resolver Called once the capture ends, to name the objects that events belong to.
+		 * @return true if the capture was started.
+		 */
+		bool start(std::filesystem::path file, std::chrono::milliseconds length, resolver_t resolver = nullptr);
+
+		/** End the current capture early and write what was captured so far.
+		 */
+		void stop();
+
+		/** Stable copy of a name, which lives until the plugin unloads.
+		 */
+		const char* intern(const std::string& name);
+
+		static bool is_capturing()
+		{
+			return _capturing.load(std::memory_order_relaxed);
+		}
+
+		/** Record a zone that started at start and took duration.
+		 * @param track Override for the track, 0 records on the calling thread.
+		 */
+		static void record(const char* name, uint64_t object, std::chrono::high_resolution_clock::time_point start,
+						   std::chrono::nanoseconds duration, uint32_t track = 0);
+
+		public:
+		/** Records a zone for as long as it is alive, if a capture was running when it was created.
+		 */
+		class scope {
+			const char*                                    _name;
+			uint64_t                                       _object;
+			bool                                           _active;
+			std::chrono::high_resolution_clock::time_point _start;
+
+			public:
+			scope(const char* name, uint64_t object = 0);
+			~scope();
+		};
+
+		public /* Singleton */:
+		static void                                   initialize();
+		static void                                   finalize();
+		static std::shared_ptr<streamfx::util::trace> get();
+	};
+} // namespace streamfx::util
@@ -0,0 +1,108 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+*/
+
+#include "util-tracking.hpp"
+#include <atomic>
+
+streamfx::util::tracking::slot::slot(obs_source_t* source) : _source(source), _frame() {}
+
+streamfx::util::tracking::slot::~slot() {}
+
+obs_source_t* streamfx::util::tracking::slot::source()
+{
+	return _source;
+}
+
+void streamfx::util::tracking::slot::publish(std::shared_ptr<const frame> value)
+{
+	std::atomic_store_explicit(&_frame, value, std::memory_order_release);
+}
+
+std::shared_ptr<const streamfx::util::tracking::frame> streamfx::util::tracking::slot::get()
+{
+	return std::atomic_load_explicit(&_frame, std::memory_order_acquire);
+}
+
+streamfx::util::tracking::channel::channel() : _lock(), _slots() {}
+
+streamfx::util::tracking::channel::~channel() {}
+
+std::shared_ptr<streamfx::util::tracking::slot> streamfx::util::tracking::channel::acquire(obs_source_t* source)
+{
+	std::unique_lock<std::mutex> lock{_lock};
+
+	// Forget about sources that are no longer tracked.
+	for (auto iter = _slots.begin(); iter != _slots.end();) {
+		if (iter->second.expired()) {
+			iter = _slots.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+
+	// Several trackers on the same source simply share its slot.
+	if (auto iter = _slots.find(source); iter != _slots.end()) {
+		if (auto value = iter->second.lock(); value) {
+			return value;
+		}
+	}
+
+	auto value     = std::make_shared<slot>(source);
+	_slots[source] = value;
+	return value;
+}
+
+std::shared_ptr<streamfx::util::tracking::slot> streamfx::util::tracking::channel::find(obs_source_t* source)
+{
+	std::unique_lock<std::mutex> lock{_lock};
+	if (auto iter = _slots.find(source); iter != _slots.end()) {
+		return iter->second.lock();
+	}
+	return nullptr;
+}
+
+std::shared_ptr<streamfx::util::tracking::channel> streamfx::util::tracking::channel::instance()
+{
+	static std::weak_ptr<channel> winst;
+	static std::mutex             mtx;
+
+	std::unique_lock<decltype(mtx)> lock(mtx);
+	auto                            instance = winst.lock();
+	if (!instance) {
+		instance = std::shared_ptr<channel>(new channel());
+		winst    = instance;
+	}
+	return instance;
+}
+
+streamfx::util::tracking::subscription::subscription() : _source(nullptr), _slot() {}
+
+streamfx::util::tracking::subscription::~subscription() {}
+
+std::shared_ptr<const streamfx::util::tracking::frame>
+	streamfx::util::tracking::subscription::get(obs_source_t* source)
+{
+	auto value = _slot.lock();
+	if (!value || (_source != source)) {
+		value   = channel::instance()->find(source);
+		_slot   = value;
+		_source = source;
+	}
+	return value ? value->get() : nullptr;
+}
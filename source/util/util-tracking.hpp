@@ -0,0 +1,112 @@
+/*
+ * Modern effects for a modern Streamer
+ * Copyright (C) 2020 Michael Fabian Dirks
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#pragma once
+#include "common.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace streamfx::util::tracking {
+	struct rect {
+		float_t x;
+		float_t y;
+		float_t width;
+		float_t height;
+	};
+
+	struct point {
+		float_t x;
+		float_t y;
+	};
+
+	/** Results of one tracked frame, normalized to the size of the tracked source.
+	 */
+	struct frame {
+		uint64_t             timestamp = 0; // Video time of the tracked frame.
+		std::vector<rect>    faces;
+		std::vector<float_t> faces_confidence;
+		std::vector<rect>    tracks; // Faces by a stable index, empty once its face was lost for a while.
+		std::vector<point>   landmarks; // Of the first face, empty if not tracked.
+		std::vector<float_t> landmarks_confidence;
+		std::vector<point>   body; // Body pose key points, empty if not tracked.
+		std::vector<float_t> body_confidence;
+		bool                 framed = false; // The tracker already crops its source to the first face.
+	};
+
+	/** Latest frame of one source.
+	 *
+	 * Frames are replaced as a whole and never modified after publishing, so readers neither see a partially
+	 * updated frame nor ever wait for the tracker.
+	 */
+	class slot {
+		obs_source_t*                _source;
+		std::shared_ptr<const frame> _frame;
+
+		public:
+		slot(obs_source_t* source);
+		~slot();
+
+		obs_source_t* source();
+
+		void publish(std::shared_ptr<const frame> value);
+
+		std::shared_ptr<const frame> get();
+	};
+
+	/** Tracking results of all sources, so that only one tracker has to run for each source.
+	 */
+	class channel {
+		std::mutex                                   _lock;
+		std::map<obs_source_t*, std::weak_ptr<slot>> _slots;
+
+		public:
+		channel();
+		~channel();
+
+		/** Claim the slot of a source for publishing, which lives as long as the returned pointer.
+		 *
+		 * Publishers must also hold on to the channel, as it forgets all slots once released.
+		 */
+		std::shared_ptr<slot> acquire(obs_source_t* source);
+
+		/** Find the slot of a source, if any tracker publishes to it.
+		 */
+		std::shared_ptr<slot> find(obs_source_t* source);
+
+		public:
+		static std::shared_ptr<channel> instance();
+	};
+
+	/** Per-consumer view of a source, which only searches the channel again once the tracker is gone.
+	 */
+	class subscription {
+		obs_source_t*       _source;
+		std::weak_ptr<slot> _slot;
+
+		public:
+		subscription();
+		~subscription();
+
+		/** Latest frame of the given source, or nullptr if nothing tracks it.
+		 */
+		std::shared_ptr<const frame> get(obs_source_t* source);
+	};
+} // namespace streamfx::util::tracking